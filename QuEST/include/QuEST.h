@@ -21,6 +21,8 @@
  *      Functions for preparing quantum states
  * @defgroup qasm QASM Logging
  *      Functions for recording performed gates to <a href="https://en.wikipedia.org/wiki/OpenQASM">QASM</a>
+ * @defgroup circuit Circuits
+ *      Reusable (and optionally parameterised) gate sequences, which can be applied and differentiated
  * @defgroup debug Debugging
  *      Utilities for seeding and debugging, such as state-logging
  *
@@ -55,20 +57,47 @@ extern "C" {
  */
 enum phaseGateType {SIGMA_Z=0, S_GATE=1, T_GATE=2};    
     
-/** A logger of QASM instructions 
+/** A logger of QASM instructions, which records every operation as a compact binary record
+ * (of its opcode, qubits and parameters), rendered as QASM only when printed or written
  *
  * @ingroup type
  * @author Tyson Jones
  */
 typedef struct {
     
-    char* buffer;       // generated QASM string
-    int bufferSize;     // maximum number of chars before overflow
-    int bufferFill;     // number of chars currently in buffer
-    int isLogging;      // whether gates are being added to buffer
+    char* buffer;               // binary records of the logged operations
+    long long int bufferSize;   // number of bytes allocated to buffer
+    long long int bufferFill;   // number of bytes of records currently in buffer
+    int isLogging;              // whether gates are being added to buffer
     
 } QASMLogger;
 
+/** The block-compressed amplitudes of a register created by createCompressedQureg() or 
+ * createReducedPrecisionQureg(). The components of each block of consecutive amplitudes are 
+ * stored as numBits-bit integers or floating-point numbers, relative to the block's largest 
+ * component, or are not stored at all if the block is zero
+ *
+ * @ingroup type
+ */
+typedef struct {
+    
+    int numBits;                // bits per stored component, or 0 if stored uncompressed
+    int floatStorage;           // the enum ampStorageType of floating-point components, else -1
+    int numBlockQubits;         // log2 of the number of amplitudes per block
+    long long int numBlocks;    // number of blocks, together storing every amplitude
+    void** blocks;              // the (real then imaginary) components of each block, or NULL if zero
+    qreal* blockScales;         // the magnitude of the largest component of each block
+    qreal errorNorm;            // an upper bound on the 2-norm of the accumulated compression error
+    
+} CompressedAmps;
+
+/** Codes for the floating-point formats in which createReducedPrecisionQureg() stores amplitudes;
+ * IEEE single and half precision, and bfloat16 (single precision truncated to 16 bits)
+ *
+ * @ingroup type
+ */
+enum ampStorageType {STORAGE_FLOAT=0, STORAGE_HALF=1, STORAGE_BFLOAT16=2};
+
 /** Represents an array of complex numbers grouped into an array of 
  * real components and an array of coressponding complex components.
  *
@@ -162,6 +191,18 @@ typedef struct Qureg
 {
     //! Whether this instance is a density-state representation
     int isDensityMatrix;
+    //! Whether this density matrix stores only its upper triangle (see createPackedDensityQureg())
+    int isPacked;
+    //! Whether this state-vector stores only the real components of its amplitudes (see createRealQureg())
+    int isReal;
+    //! Whether this state-vector stores only the amplitudes of basis states with hammingWeight qubits in |1> (see createSubspaceQureg())
+    int isSubspace;
+    //! The number of qubits in state |1> in every stored basis state of a subspace register, else 0
+    int hammingWeight;
+    //! Whether the amplitudes of this state-vector are memory-mapped from files (see createOutOfCoreQureg())
+    int isOutOfCore;
+    //! Whether this state-vector stores its amplitudes in compressed blocks (see createCompressedQureg())
+    int isCompressed;
     //! The number of qubits represented in either the state-vector or density matrix
     int numQubitsRepresented;
     //! Number of qubits in the state-vector - this is double the number represented for mixed states
@@ -187,6 +228,9 @@ typedef struct Qureg
     //! Storage for reduction of probabilities on GPU
     qreal *firstLevelReduction, *secondLevelReduction;
 
+    //! Storage for the amplitudes of a compressed state-vector, in place of stateVec
+    CompressedAmps* compressedAmps;
+
     //! Storage for generated QASM output
     QASMLogger* qasmLog;
     
@@ -204,6 +248,122 @@ typedef struct QuESTEnv
     int numRanks;
 } QuESTEnv;
 
+/** Codes for the gates which can be added to a Circuit, named after the API
+ * function which they effect. The number of qubits and parameters of each
+ * gate matches the signature of that function, e.g. \p CIRCUIT_CONTROLLED_ROTATE_X
+ * acts upon a control and target qubit, and accepts a single angle.
+ *
+ * @ingroup type
+ */
+enum circuitGateType {
+    CIRCUIT_HADAMARD=0, CIRCUIT_PAULI_X=1, CIRCUIT_PAULI_Y=2, CIRCUIT_PAULI_Z=3,
+    CIRCUIT_S_GATE=4, CIRCUIT_T_GATE=5, CIRCUIT_SQRT_X=6, CIRCUIT_SQRT_Y=7, CIRCUIT_SQRT_W=8,
+    CIRCUIT_ROTATE_X=9, CIRCUIT_ROTATE_Y=10, CIRCUIT_ROTATE_Z=11, CIRCUIT_PHASE_SHIFT=12,
+    CIRCUIT_U1=13, CIRCUIT_U2=14, CIRCUIT_U3=15,
+    CIRCUIT_CONTROLLED_NOT=16, CIRCUIT_CONTROLLED_PAULI_Y=17, CIRCUIT_CONTROLLED_PHASE_FLIP=18,
+    CIRCUIT_CONTROLLED_ROTATE_X=19, CIRCUIT_CONTROLLED_ROTATE_Y=20, CIRCUIT_CONTROLLED_ROTATE_Z=21,
+    CIRCUIT_CONTROLLED_PHASE_SHIFT=22, CIRCUIT_SWAP=23, CIRCUIT_FSIM=24
+};
+
+// hide these from doxygen
+/// \cond HIDDEN_SYMBOLS
+
+/** A single gate of a Circuit. Controlled gates store their control qubit
+ * before their target, as in their API signature.
+ *
+ * @ingroup type
+ */
+typedef struct {
+
+    int type;           // an enum circuitGateType code
+    int qubits[2];      // (control and) target qubits
+    qreal params[3];    // fixed parameters, e.g. rotation angles
+    int paramInd;       // index of the bound Circuit parameter, else -1
+
+} CircuitGate;
+
+/** An operation of a compiled Circuit; either a CircuitGate, or a gate
+ * (or fused sequence of gates) described by a precomputed matrix
+ *
+ * @ingroup type
+ */
+typedef struct {
+
+    CircuitGate gate;       // the gate, or the qubits and type of the matrix operation
+    ComplexMatrix2 matrix;  // the precomputed (and possibly controlled) one-qubit matrix
+
+} CircuitOp;
+
+/** The growable gate list of a Circuit, and its compiled execution plan
+ *
+ * @ingroup type
+ */
+typedef struct {
+
+    CircuitGate* gates;
+    int numGates;       // number of gates currently in the list
+    int capacity;       // number of gates which fit before the list is grown
+
+    CircuitOp* ops;     // the compiled operations, equivalent to gates
+    int numOps;         // number of compiled operations
+    int isCompiled;     // whether ops reflects the current gates
+
+} CircuitGateList;
+
+/// \endcond
+
+/** A sequence of gates upon a fixed number of qubits, which can be applied
+ * to any Qureg of that size. Single-parameter gates may be bound to one of
+ * the circuit's \p numParams parameters, so that the same circuit can be re-run
+ * and differentiated with new parameter values.
+ *
+ * @ingroup type
+ */
+typedef struct Circuit
+{
+    //! The number of qubits upon which the circuit acts
+    int numQubits;
+    //! The number of free parameters to which gates may be bound
+    int numParams;
+    //! The current values of the free parameters
+    qreal* params;
+
+    //! The gates of the circuit, in order of application
+    CircuitGateList* gateList;
+
+} Circuit;
+
+/** Convergence statistics of an observable averaged over many quantum trajectories,
+ * as returned by calcTrajectoryAverage() and calcTrajectoryExpecPauliSum()
+ *
+ * @ingroup type
+ */
+typedef struct TrajectoryStats
+{
+    //! The mean of the observable over all trajectories
+    qreal mean;
+    //! The unbiased sample variance of the observable between trajectories
+    qreal variance;
+    //! The standard error of \p mean, sqrt(variance / numTrajectories)
+    qreal standardError;
+    //! The number of trajectories averaged
+    int numTrajectories;
+} TrajectoryStats;
+
+/** The memory and accuracy of a compressed register, as returned by getCompressionStats()
+ *
+ * @ingroup type
+ */
+typedef struct CompressionStats
+{
+    //! The bytes of memory occupied by the compressed amplitudes
+    long long int numBytes;
+    //! The memory of the uncompressed state-vector, divided by numBytes
+    qreal compressionRatio;
+    //! An upper bound on the infidelity between the stored state and that of exact simulation
+    qreal infidelityBound;
+} CompressionStats;
+
 
 
 /*
@@ -213,7 +373,9 @@ typedef struct QuESTEnv
 /** Create a Qureg object representing a set of qubits which will remain in a pure state.
  * Allocate space for state vector of probability amplitudes, including space for temporary values to be copied from
  * one other chunk if running the distributed version. Define properties related to the size of the set of qubits.
- * The qubits are initialised in the zero state (i.e. initZeroState is automatically called)
+ * The qubits are initialised in the zero state (i.e. initZeroState is automatically called). Since every 
+ * amplitude is written by the same threads (and schedule) as later process it, the memory of a register 
+ * is placed near those threads upon NUMA machines.
  *
  * @ingroup type
  * @returns an object representing the set of qubits
@@ -238,11 +400,215 @@ Qureg createQureg(int numQubits, QuESTEnv env);
  */
 Qureg createDensityQureg(int numQubits, QuESTEnv env);
 
+/** Create a density matrix Qureg which stores only the upper triangle (including the diagonal)
+ * of the Hermitian matrix, roughly halving the memory and memory traffic of createDensityQureg().
+ * The lower triangle is never stored; getDensityAmp() recovers it by conjugation.
+ * The register begins in the zero state |0><0|.
+ *
+ * A packed density matrix supports the one-qubit gates and their (multi-)controlled variants, the
+ * phase gates pauliZ(), sGate(), tGate(), phaseShift(), controlledPhaseShift() and
+ * controlledPhaseFlip(), the two-qubit gates twoQubitUnitary(), controlledTwoQubitUnitary(),
+ * multiControlledTwoQubitUnitary(), swapGate(), sqrtSwapGate() and fSim(), the one-qubit channels
+ * mixDephasing(), mixDepolarising() and mixDamping(), and calcPurity(), calcFidelity(),
+ * calcProbOfOutcome() and calcTotalProb(), along with the state initialisations, cloning and
+ * getDensityAmp().
+ * Other operations reject packed registers; these include multiQubitUnitary() and its controlled
+ * variants, multiControlledPhaseShift(), multiControlledPhaseFlip(), multiRotateZ(),
+ * multiRotatePauli(), mixTwoQubitDephasing(), mixTwoQubitDepolarising(), mixPauli(), the Kraus
+ * maps, measurement and collapse, applyCircuit() and the QASM appliers.
+ *
+ * Packed density matrices are only supported by the CPU backend, and only upon a single node
+ * (including a distributed build run with a single process).
+ *
+ * @ingroup type
+ * @returns an object representing the set of qubits
+ * @param[in] numQubits number of qubits in the system
+ * @param[in] env object representing the execution environment
+ * @throws exitWithError if \p numQubits <= 0, or if \p env spans more than one node
+ */
+Qureg createPackedDensityQureg(int numQubits, QuESTEnv env);
+
+/** Create a state-vector Qureg whose amplitudes are all real, and which stores only their real 
+ * components. This halves the memory and memory traffic of createQureg() for circuits of real 
+ * gates, such as ansatzes built from Hadamards, X, Z, Y-rotations, CNOTs and swaps.
+ * The register begins in the zero state |0...0>.
+ *
+ * A real-amplitude register accepts only operations which keep its amplitudes real:
+ * - hadamard(), pauliX(), pauliZ(), rotateY(), controlledRotateY(), controlledNot(),
+ *   controlledPhaseFlip(), multiControlledPhaseFlip() and swapGate()
+ * - unitary(), controlledUnitary(), multiControlledUnitary(), multiStateControlledUnitary(),
+ *   compactUnitary(), controlledCompactUnitary(), twoQubitUnitary(), controlledTwoQubitUnitary(),
+ *   multiControlledTwoQubitUnitary(), multiQubitUnitary(), controlledMultiQubitUnitary() and
+ *   multiControlledMultiQubitUnitary(), when given a real-valued matrix
+ * - applyCircuit(), applyQASMFile() and applyQASMString(), when every gate is real-valued
+ *   (like a circuit of only Y-rotations and CNOTs)
+ * - initZeroState(), initBlankState(), initPlusState(), initClassicalState(), 
+ *   initStateOfSingleQubit(), initPureState() (from another real register), cloneQureg() and 
+ *   createCloneQureg(), and initStateFromAmps() and setAmps() when given zero imaginary components
+ * - calcProbOfOutcome(), collapseToOutcome(), collapseToOutcomes(), measure(), measureWithStats(), 
+ *   measureQubits(), measureAll(), calcTotalProb(), calcInnerProduct() and calcFidelity() (with 
+ *   another real register, or as the pure state of a density matrix), calcExpecPauliProd(), 
+ *   calcExpecPauliSum(), sampleOutcomes(), calcReducedDensityMatrix(), compareStates(), 
+ *   reportState(), reportStateToScreen() and the amplitude getters. Pauli expectations are 
+ *   evaluated directly, without modifying \p workspace.
+ *
+ * Any other operation which can introduce complex amplitudes, and any matrix or gate with a 
+ * non-zero imaginary component, is rejected with an error, rather than silently introducing 
+ * amplitudes which the register cannot store. So too are the decoherence channels, like 
+ * mixDephasing() and mixKrausMap(), whose randomly chosen errors may be complex.
+ * Real-amplitude registers are only supported by the CPU backends.
+ *
+ * @ingroup type
+ * @returns an object representing the set of qubits
+ * @param[in] numQubits number of qubits in the system
+ * @param[in] env object representing the execution environment (local, multinode etc)
+ * @throws exitWithError if \p numQubits <= 0
+ */
+Qureg createRealQureg(int numQubits, QuESTEnv env);
+
+/** Create a state-vector Qureg which stores only the amplitudes of the basis states with exactly 
+ * \p hammingWeight qubits in state |1>; that is, C(\p numQubits, \p hammingWeight) amplitudes rather 
+ * than 2^\p numQubits. Circuits of particle-number conserving gates, such as fermionic 
+ * chemistry ansatzes under the Jordan-Wigner mapping, never leave this subspace, so can simulate 
+ * many more qubits than createQureg() permits. The stored amplitudes are ordered by the value of 
+ * their basis state index (the combinatorial number system).
+ * The register begins in the classical state with qubits 0 to \p hammingWeight - 1 in |1>, 
+ * i.e. the Hartree-Fock reference state.
+ *
+ * A fixed Hamming-weight register accepts only operations which conserve the number of qubits in |1>:
+ * - pauliZ(), sGate(), tGate(), phaseShift(), controlledPhaseShift(), multiControlledPhaseShift(),
+ *   controlledPhaseFlip(), multiControlledPhaseFlip(), rotateZ() and multiRotateZ()
+ * - swapGate(), sqrtSwapGate() and fSim()
+ * - twoQubitUnitary(), controlledTwoQubitUnitary() and multiControlledTwoQubitUnitary(), when 
+ *   the matrix couples only basis states of equal Hamming weight. Givens rotations are applied 
+ *   this way, as a real rotation of the |01>, |10> block.
+ * - applyCircuit(), applyQASMFile() and applyQASMString(), when every gate (under the current 
+ *   parameters) conserves the number of qubits in |1>. QASM gates are checked as they are 
+ *   expanded, so a defined gate (like \p cswap) decomposed into non-conserving gates is rejected.
+ * - initBlankState(), initClassicalState() (of a basis state in the subspace), cloneQureg() 
+ *   and createCloneQureg()
+ * - calcProbOfOutcome(), collapseToOutcome(), measure(), measureWithStats(), calcTotalProb(),
+ *   calcInnerProduct() (with a register of the same Hamming weight), calcExpecPauliProd(), 
+ *   calcExpecPauliSum() and the amplitude getters, which accept any basis state index and 
+ *   report zero amplitude outside the subspace. Pauli expectations are evaluated directly, 
+ *   without modifying \p workspace.
+ *
+ * getNumAmps() reports the number of stored amplitudes, C(\p numQubits, \p hammingWeight).
+ *
+ * Every other operation is rejected with an error. Fixed Hamming-weight registers are only 
+ * supported by the single-node CPU backend.
+ *
+ * @ingroup type
+ * @returns an object representing the set of qubits
+ * @param[in] numQubits number of qubits in the system
+ * @param[in] hammingWeight number of qubits in state |1> in every stored basis state
+ * @param[in] env object representing the execution environment
+ * @throws exitWithError if \p numQubits <= 0 or \p numQubits > 62, if \p hammingWeight is not in 
+ *      [0, \p numQubits], or if \p env spans more than one node
+ */
+Qureg createSubspaceQureg(int numQubits, int hammingWeight, QuESTEnv env);
+
+/** Create a state-vector Qureg whose amplitudes are stored in files in the directory \p dirName 
+ * (ideally upon a local NVMe drive), rather than in RAM, so that it can exceed the available memory. 
+ * The files are memory-mapped, so that the operating system pages amplitudes in and out as 
+ * they are accessed, and every operation of an ordinary state-vector is supported. 
+ * The files are unlinked upon creation, so are removed when the register is destroyed or the 
+ * program exits; each node of a distributed register creates its own files.
+ *
+ * Since each operation sweeps the whole state, individual gates each cost a full read and 
+ * write of the files. applyCircuit() instead schedules the gates of a Circuit into passes: 
+ * consecutive gates (and later gates which commute past those between) upon only the lowest 
+ * qubits are applied together, block-by-block, in a single sweep of the files, whereas gates upon 
+ * higher qubits are applied alone. calcCircuitIOBytes() reports the resulting file traffic of 
+ * each gate, to guide circuit ordering.
+ *
+ * Clones made with createCloneQureg() are ordinary in-memory registers.
+ * Out-of-core registers are only supported by the CPU backend on Linux.
+ *
+ * @ingroup type
+ * @returns an object representing the set of qubits
+ * @param[in] numQubits number of qubits in the system
+ * @param[in] dirName the existing, writable directory in which to create the amplitude files
+ * @param[in] env object representing the execution environment (local, multinode etc)
+ * @throws exitWithError if \p numQubits <= 0, or if \p dirName is not an existing, writable directory
+ */
+Qureg createOutOfCoreQureg(int numQubits, char* dirName, QuESTEnv env);
+
+/** Create a state-vector Qureg which stores its amplitudes in compressed blocks of 
+ * 4096 consecutive amplitudes, so that more qubits fit in memory. Each component of a 
+ * block is stored as a \p numBits-bit integer, relative to the largest component in the block, 
+ * so that 16 and 8 bit storage respectively fit 2 and 3 more qubits than createQureg() 
+ * (in double precision). Blocks which are entirely zero occupy no memory, 
+ * so that sparse states compress further, and \p numBits = 0 stores the remaining blocks 
+ * losslessly. The register begins in the zero state.
+ *
+ * A compressed register accepts only applyCircuit(), initZeroState(), calcTotalProb(), 
+ * calcProbOfOutcome(), the amplitude getters, getCompressionStats() and calcInnerProduct() 
+ * with another compressed register. 
+ * applyCircuit() schedules gates into passes as for out-of-core registers 
+ * (see createOutOfCoreQureg()); in every pass, each thread decompresses the blocks upon which 
+ * the gates act into a private buffer, applies the gates, and recompresses them. 
+ * Each recompression of a lossy register rounds the amplitudes, and the resulting bound upon 
+ * the infidelity of the stored state, along with the compression ratio, is reported by 
+ * getCompressionStats(). 
+ * Compressed registers are only supported by the single-node CPU backend.
+ *
+ * @ingroup type
+ * @returns an object representing the set of qubits
+ * @param[in] numQubits number of qubits in the system
+ * @param[in] numBits the bits with which to store each real and imaginary component; 8, 16, 32, 
+ *      or 0 for lossless storage
+ * @param[in] env object representing the execution environment
+ * @throws exitWithError if \p numQubits <= 0, if \p numBits is not one of 0, 8, 16 or 32, 
+ *      or if \p env spans more than one node
+ */
+Qureg createCompressedQureg(int numQubits, int numBits, QuESTEnv env);
+
+/** Create a state-vector Qureg which stores its amplitudes in a reduced-precision floating-point 
+ * format, but computes every gate in qreal (double, by default) precision. This halves 
+ * (\p STORAGE_FLOAT) or quarters (\p STORAGE_HALF, \p STORAGE_BFLOAT16) the memory and the 
+ * memory bandwidth of double-precision amplitudes, and is independent of QuEST_PREC.
+ *
+ * The register is a compressed register (see createCompressedQureg()), so supports the same 
+ * operations: each block of amplitudes is converted to qreal in a thread-private buffer (using 
+ * the F16C conversion instructions for half precision, where compiled with them), upon which 
+ * gates act, before being converted back. Components are stored relative to the largest in their 
+ * block, so that half precision retains its relative accuracy for small amplitudes.
+ * calcTotalProb(), calcProbOfOutcome() and calcInnerProduct() always accumulate in double precision.
+ * getCompressionStats() bounds the infidelity introduced by rounding.
+ *
+ * @ingroup type
+ * @returns an object representing the set of qubits
+ * @param[in] numQubits number of qubits in the system
+ * @param[in] storage the format of the stored components; \p STORAGE_FLOAT, \p STORAGE_HALF or 
+ *      \p STORAGE_BFLOAT16
+ * @param[in] env object representing the execution environment
+ * @throws exitWithError if \p numQubits <= 0, if \p storage is not a valid ::ampStorageType, 
+ *      or if \p env spans more than one node
+ */
+Qureg createReducedPrecisionQureg(int numQubits, enum ampStorageType storage, QuESTEnv env);
+
+/** Report the memory occupied by the amplitudes of a compressed register (see 
+ * createCompressedQureg()), its compression ratio, and a bound upon the infidelity 
+ * 1 - |<psi|phi>|^2 / <phi|phi> between the stored state phi and the state psi which 
+ * uncompressed simulation would have produced. The bound is the squared sum of the norms 
+ * of the rounding errors of every recompression so far, so it is 0 for lossless registers.
+ *
+ * @ingroup calc
+ * @returns the compression statistics of \p qureg
+ * @param[in] qureg a compressed register
+ * @throws exitWithError if \p qureg was not created with createCompressedQureg()
+ */
+CompressionStats getCompressionStats(Qureg qureg);
+
 /** Create a new Qureg which is an exact clone of the passed qureg, which can be
  * either a statevector or a density matrix. That is, it will have the same 
  * dimensions as the passed qureg and begin in an identical quantum state.
  * This must be destroyed by the user later with destroyQureg()
  *
+ * The amplitudes are copied in parallel, unless copy-on-write clones were enabled with 
+ * setCopyOnWriteClones().
+ *
  * @ingroup type
  * @returns an object representing the set of qubits
  * @param[in] qureg an existing qureg to be cloned
@@ -255,13 +621,55 @@ Qureg createCloneQureg(Qureg qureg, QuESTEnv env);
  * Free memory allocated to state vector of probability amplitudes, including temporary vector for
  * values copied from another chunk if running the distributed version.
  *
+ * If the environment's register pool (see setQuregPoolCapacity()) has room, the amplitude arrays 
+ * are retained for reuse by the next register of the same size, rather than freed.
+ * A checkpoint of \p qureg still in progress (see startQuregCheckpoint()) is first finished.
+ *
  * @ingroup type
  * @param[in,out] qureg object to be deallocated
  * @param[in] env object representing the execution environment (local, multinode etc)
+ * @throws exitWithError if a checkpoint of \p qureg in progress could not be written
  * @author Ania Brown
  */
 void destroyQureg(Qureg qureg, QuESTEnv env);
 
+/** Set the maximum number of destroyed registers whose memory the environment retains for reuse.
+ * While the pool has room, destroyQureg() keeps a register's amplitude arrays rather than freeing them, 
+ * and a later createQureg(), createDensityQureg(), createPackedDensityQureg(), createRealQureg(), 
+ * createSubspaceQureg() or createCloneQureg() requiring arrays of exactly the same size takes them 
+ * from the pool. Recycled arrays are still initialised like fresh ones, 
+ * but avoid the cost of the operating system mapping and faulting in fresh pages, which dominates 
+ * repeated create/destroy cycles of large registers.
+ *
+ * The pool begins with capacity 0 (disabled). Reducing the capacity frees any excess pooled arrays, 
+ * so that a capacity of 0 releases them all, and destroyQuESTEnv() empties the pool.
+ * The pool holds memory at least as large as its registers, so should be enabled only when 
+ * same-size registers are repeatedly created. The GPU backend does not pool.
+ *
+ * @ingroup type
+ * @param[in] env object representing the execution environment
+ * @param[in] capacity the maximum number of registers' arrays to retain
+ * @throws exitWithError if \p capacity < 0
+ */
+void setQuregPoolCapacity(QuESTEnv env, int capacity);
+
+/** Set whether cloneQureg() and createCloneQureg() share amplitudes copy-on-write, rather than copy them.
+ * When enabled, on Linux CPU builds, a clone of a register with at least 1 MiB per real and imaginary 
+ * array (per node) maps the source's pages privately from an in-memory file, so each page is only 
+ * duplicated when first modified in either register. Cloning a source which was modified since it was 
+ * last cloned still costs a (serial) copy into a fresh file, and every page later modified costs a page 
+ * fault and a copy, so this is slower than the default parallel copy when the clone is subsequently 
+ * modified throughout. It pays off only when an unmodified source is cloned repeatedly and each clone 
+ * modifies few pages, or when memory rather than time is scarce. Other builds always copy.
+ *
+ * Copy-on-write clones begin disabled.
+ *
+ * @ingroup type
+ * @param[in] env object representing the execution environment
+ * @param[in] useCopyOnWrite whether (1) or not (0) clones share amplitudes copy-on-write
+ */
+void setCopyOnWriteClones(QuESTEnv env, int useCopyOnWrite);
+
 /** Create (dynamically) a square complex matrix which can be passed to the multi-qubit general unitary functions.
  * The matrix will have dimensions (2^\p numQubits) by (2^\p numQubits), and all elements
  * of .real and .imag are initialised to zero.
@@ -359,6 +767,87 @@ void reportStateToScreen(Qureg qureg, QuESTEnv env, int reportRank);
  */
 void reportQuregParams(Qureg qureg);
 
+/** Save the full state of \p qureg to a binary checkpoint file, which readQuregCheckpoint() can
+ * later restore.
+ *
+ * The file begins with a header recording the register's type, dimension, precision and a checksum
+ * of each of the real and imaginary components, followed by the real and then (unless \p qureg was
+ * created with createRealQureg()) the imaginary components of every amplitude, in the order of
+ * getAmp(). The layout is independent of the number of nodes, so a checkpoint may be restored
+ * with a different distribution. Every thread (and every node, via MPI-IO) writes its own
+ * contiguous part of the file in parallel.
+ *
+ * The checkpoint is written to \p filename with a ".tmp" suffix, which only replaces \p filename
+ * once complete and flushed to disk, so that an interrupted write never destroys a previous
+ * checkpoint.
+ *
+ * @ingroup debug
+ * @param[in] qureg the register to save
+ * @param[in] filename the path of the checkpoint file to (over)write
+ * @throws exitWithError if \p qureg is a compressed register (see createCompressedQureg()),
+ *      or if the file cannot be written
+ */
+void writeQuregCheckpoint(Qureg qureg, char* filename);
+
+/** Overwrite the state of \p qureg with that saved by writeQuregCheckpoint(). \p qureg must have
+ * the type, number of qubits and precision (QuEST_PREC) of the saved register, but may be
+ * distributed differently.
+ *
+ * If \p useMapping is non-zero, and the register's amplitude arrays are large and page-aligned
+ * within the file, the arrays are instead mapped copy-on-write from the file, so that amplitudes
+ * are only read from disk when first accessed, and only copied into memory when first modified.
+ * In that case, the file must not be modified (except by writeQuregCheckpoint(), which replaces
+ * rather than modifies it) while \p qureg is in use. Otherwise, amplitudes are read in parallel.
+ * Either way, the checksums of the loaded amplitudes are verified.
+ *
+ * @ingroup init
+ * @param[in,out] qureg the register to overwrite
+ * @param[in] filename the path of a file created by writeQuregCheckpoint() or startQuregCheckpoint()
+ * @param[in] useMapping whether to map, rather than read, the amplitudes from the file
+ * @returns the \p gateIndex given to startQuregCheckpoint(), from which to resume the simulation,
+ *      or 0 if the checkpoint was written by writeQuregCheckpoint()
+ * @throws exitWithError if \p qureg is a compressed register, if the file cannot be opened or is not
+ *      a checkpoint, if the checkpoint's register differs in type, number of qubits or precision
+ *      from \p qureg, or if the loaded amplitudes do not match the checkpoint's checksums (in which
+ *      case \p qureg is left in an invalid state)
+ */
+long long int readQuregCheckpoint(Qureg qureg, char* filename, int useMapping);
+
+/** Begin saving the current state of \p qureg to a checkpoint file (as writeQuregCheckpoint()), which
+ * is written by a background thread while \p qureg continues to be simulated. The checkpoint is only
+ * complete once finishQuregCheckpoint() is called, and is finished automatically by the next call to
+ * startQuregCheckpoint() or destroyQureg() upon \p qureg.
+ *
+ * The state is captured by a snapshot of the amplitudes, which (on Linux, for registers with at least
+ * 1 MiB of amplitudes per node) shares the register's memory copy-on-write, so that the snapshot only
+ * costs memory for the pages which \p qureg modifies before the checkpoint is finished. Otherwise,
+ * the amplitudes are copied. Either way, the extra memory never exceeds the size of \p qureg. Out-of-core
+ * registers (see createOutOfCoreQureg()) are not snapshot, and are instead written before returning.
+ *
+ * Because \p filename is only replaced by a complete checkpoint, a simulation interrupted at any time
+ * can resume from the last finished checkpoint, by restoring it with readQuregCheckpoint(), which
+ * returns the \p gateIndex passed here. In distributed mode, every node writes its own amplitudes to
+ * the file, which must be on a file system shared by all nodes.
+ *
+ * @ingroup debug
+ * @param[in] qureg the register to save
+ * @param[in] filename the path of the checkpoint file to (over)write
+ * @param[in] gateIndex a user-chosen record of the simulation's progress, such as the number of gates
+ *      so far applied, which readQuregCheckpoint() returns
+ * @throws exitWithError if \p qureg is a compressed register (see createCompressedQureg()), or if the
+ *      file (or that of a previous, unfinished checkpoint of \p qureg) cannot be written
+ */
+void startQuregCheckpoint(Qureg qureg, char* filename, long long int gateIndex);
+
+/** Wait for the checkpoint of \p qureg begun by startQuregCheckpoint() to be written, and then
+ * complete it, replacing its file. Does nothing if no checkpoint of \p qureg is in progress.
+ *
+ * @ingroup debug
+ * @param[in] qureg the register passed to startQuregCheckpoint()
+ * @throws exitWithError if \p qureg is a compressed register, or if the checkpoint could not be written
+ */
+void finishQuregCheckpoint(Qureg qureg);
+
 /** Get the number of qubits in a qureg object
  *
  * @ingroup calc
@@ -509,6 +998,9 @@ void setAmps(Qureg qureg, long long int startInd, qreal* reals, qreal* imags, lo
  * Only the quantum state is cloned, auxilary info (like recorded QASM) is unchanged.
  * copyQureg is unaffected.
  *
+ * The amplitudes are copied in parallel, unless copy-on-write clones were enabled with 
+ * setCopyOnWriteClones().
+ *
  * @ingroup init
  * @param[in, out] targetQureg the qureg to have its quantum state overwritten
  * @param[in] copyQureg the qureg to have its quantum state cloned in targetQureg.
@@ -1704,6 +2196,40 @@ void controlledPauliY(Qureg qureg, const int controlQubit, const int targetQubit
  */
 qreal calcProbOfOutcome(Qureg qureg, const int measureQubit, int outcome);
 
+/** Samples \p numShots measurement outcomes of the given \p qubits, without collapsing
+ * or otherwise changing the state of \p qureg. This emulates repeatedly preparing and 
+ * measuring the state on hardware, but costs only a single pass over the amplitudes.
+ *
+ * The probability of every outcome of \p qubits is first found in one sweep of the
+ * state (summing the diagonal for density matrices), which is accumulated into
+ * a cumulative distribution. Each shot is then drawn with a single random number and 
+ * a binary search of this distribution. When distributed, each node bins only its own 
+ * amplitudes, by the outcomes of those \p qubits which are not fixed within the node, 
+ * and only the nodes' total probabilities are communicated. Each shot is then drawn 
+ * from a node in proportion to its total, and the shots are shared, so that every 
+ * node receives the same \p outcomes.
+ *
+ * Each outcome is the integer whose binary digits are the measured values of \p qubits,
+ * with \p qubits[0] as the least significant bit. For example, outcome 2 of 
+ * \p qubits = {3, 1} means qubit 3 was measured as 0 and qubit 1 as 1.
+ * 
+ * Memory for the 2^\p numQubits outcome probabilities is temporarily allocated.
+ *
+ * @ingroup calc
+ * @param[in] qureg object representing the set of all qubits
+ * @param[in] qubits list of the qubits to measure in each shot
+ * @param[in] numQubits number of qubits in \p qubits
+ * @param[in] numShots number of outcomes to sample
+ * @param[out] outcomes array of length \p numShots, populated with the sampled outcomes
+ * @throws exitWithError
+ *      if \p numQubits is outside [1, \p qureg.numQubitsRepresented],
+ *      or if any qubit in \p qubits is outside [0, \p qureg.numQubitsRepresented),
+ *      or if any qubit in \p qubits is repeated,
+ *      or if \p numShots is not positive,
+ *      or if the 2^\p numQubits outcome probabilities cannot be allocated.
+ */
+void sampleOutcomes(Qureg qureg, int* qubits, int numQubits, int numShots, long long int* outcomes);
+
 /** Updates \p qureg to be consistent with measuring \p measureQubit in the given 
  * \p outcome (0 or 1), and returns the probability of such a measurement outcome. 
  * This is effectively performing a projection, or a measurement with a forced outcome.
@@ -1763,6 +2289,63 @@ int measure(Qureg qureg, int measureQubit);
  */
 int measureWithStats(Qureg qureg, int measureQubit, qreal *outcomeProb);
 
+/** Measures every qubit, collapsing \p qureg randomly into a single classical state.
+ * This is equivalent to calling \p measure upon each qubit in turn, but samples 
+ * the whole outcome from a single pass over the amplitudes, and then collapses 
+ * the state in a second pass, rather than performing two passes per qubit.
+ *
+ * For state-vectors, the phase of the surviving amplitude is retained. 
+ * For density matrices, \p qureg becomes the classical state with the sampled index.
+ *
+ * @ingroup normgate
+ * @param[in, out] qureg object representing the set of all qubits
+ * @param[out] outcomes array of length \p qureg.numQubitsRepresented, with 
+ *      \p outcomes[q] set to the measurement outcome (0 or 1) of qubit \p q
+ * @return the index of the classical state into which \p qureg collapsed
+ */
+long long int measureAll(Qureg qureg, int* outcomes);
+
+/** Updates \p qureg to be consistent with measuring each of \p qubits in the 
+ * corresponding \p outcomes, and returns the probability of this joint outcome.
+ * This is equivalent to calling \p collapseToOutcome upon each qubit in turn, but 
+ * performs only one pass to find the joint probability and one pass to zero the 
+ * inconsistent amplitudes and renormalise the remainder, rather than two passes per qubit.
+ *
+ * @ingroup normgate
+ * @param[in,out] qureg object representing the set of all qubits
+ * @param[in] qubits list of the qubits to collapse
+ * @param[in] outcomes list of the outcomes (0 or 1) to force each qubit in \p qubits into
+ * @param[in] numQubits number of qubits in \p qubits and outcomes in \p outcomes
+ * @return probability of the (forced) joint measurement outcome
+ * @throws exitWithError
+ *      if \p numQubits is outside [1, \p qureg.numQubitsRepresented],
+ *      or if any qubit in \p qubits is outside [0, \p qureg.numQubitsRepresented),
+ *      or if any qubit in \p qubits is repeated,
+ *      or if any of \p outcomes is not in {0, 1},
+ *      or if the probability of the joint outcome is zero (within machine epsilon)
+ */
+qreal collapseToOutcomes(Qureg qureg, int* qubits, int* outcomes, int numQubits);
+
+/** Measures each of \p qubits, collapsing them randomly to 0 or 1, and gives the 
+ * probability of the joint outcome. This is equivalent to calling \p measure upon each 
+ * qubit in turn, but finds the joint outcome distribution in a single pass and collapses 
+ * \p qureg in a second, independent of the number of measured qubits. It is intended 
+ * for measuring many ancillas at once, such as in error-correction cycles.
+ *
+ * @ingroup normgate
+ * @param[in,out] qureg object representing the set of all qubits
+ * @param[in] qubits list of the qubits to measure
+ * @param[in] numQubits number of qubits in \p qubits
+ * @param[out] outcomes array of length \p numQubits, populated with the outcome of each qubit
+ * @return the probability of the occurred joint outcome
+ * @throws exitWithError
+ *      if \p numQubits is outside [1, \p qureg.numQubitsRepresented],
+ *      or if any qubit in \p qubits is outside [0, \p qureg.numQubitsRepresented),
+ *      or if any qubit in \p qubits is repeated,
+ *      or if the 2^\p numQubits outcome probabilities cannot be allocated
+ */
+qreal measureQubits(Qureg qureg, int* qubits, int numQubits, int* outcomes);
+
 /** Computes the inner product \f$ \langle \text{bra} | \text{ket} \rangle \f$ of two 
  * equal-size state vectors, given by 
  * \f[ 
@@ -1872,6 +2455,11 @@ void seedQuEST(unsigned long int *seedArray, int numSeeds);
  * growing log of QASM instructions, progressively consuming more memory until 
  * disabled with stopRecordingQASM(). The QASM log is bound to this qureg instance.
  *
+ * Each operation is logged as a compact binary record of its opcode, qubits and 
+ * exact parameters (typically 10 to 80 bytes), and is only rendered as QASM 
+ * text by printRecordedQASM() and writeRecordedQASMToFile(), so recording adds 
+ * negligible cost to each gate. The binary log can be saved with writeRecordedTraceToFile().
+ *
  * @ingroup qasm
  * @param[in,out] qureg The qureg to begin recording subsequent operations upon
  * @author Tyson Jones
@@ -1916,6 +2504,54 @@ void printRecordedQASM(Qureg qureg);
  */
 void writeRecordedQASMToFile(Qureg qureg, char* filename);
 
+/** Writes the operations recorded upon \p qureg (see startRecordingQASM()) to a binary trace 
+ * file, which is far smaller and faster to write than QASM. The trace records each operation 
+ * exactly, including the outcome of each measurement, so can later be replayed upon another 
+ * register with applyTraceFile(), or rendered as QASM with writeTraceFileAsQASM(). 
+ * The file is only readable by QuEST of the same precision (QuEST_PREC).
+ *
+ * @ingroup qasm
+ * @param[in] qureg the qureg of which to write the recorded operations
+ * @param[in] filename the filename of the trace file to write
+ * @throws exitWithError if \p filename cannot be written to
+ */
+void writeRecordedTraceToFile(Qureg qureg, char* filename);
+
+/** Renders the binary trace file \p traceFilename (written by writeRecordedTraceToFile()) as 
+ * the same QASM that writeRecordedQASMToFile() would have written, into \p qasmFilename. 
+ * The trace is read incrementally, so need not fit in memory.
+ *
+ * @ingroup qasm
+ * @param[in] traceFilename the filename of the trace to read
+ * @param[in] qasmFilename the filename of the QASM file to write
+ * @throws exitWithError
+ *      if either file cannot be opened,
+ *      or if \p traceFilename is not a trace of the same precision, or contains an invalid record
+ */
+void writeTraceFileAsQASM(char* traceFilename, char* qasmFilename);
+
+/** Replays the operations of the binary trace file \p filename (written by 
+ * writeRecordedTraceToFile()) upon \p qureg, in order, by calling the API function which 
+ * recorded each (which are themselves recorded upon \p qureg, if it is recording). 
+ * Measurements are replayed with collapseToOutcome() upon their recorded outcome, so that the 
+ * recorded run is reproduced exactly. Operations which are recorded only as QASM comments 
+ * (like multiQubitUnitary() and decoherence channels) cannot be replayed, and are skipped.
+ * \p qureg is not initialised beforehand, and can be a state-vector or density matrix, 
+ * regardless of the register upon which the trace was recorded. The trace is read 
+ * incrementally, so need not fit in memory.
+ *
+ * @ingroup qasm
+ * @param[in,out] qureg the register upon which to replay the trace
+ * @param[in] filename the filename of the trace to replay
+ * @throws exitWithError
+ *      if the file cannot be opened, 
+ *      or if it is not a trace of the same precision,
+ *      or if it contains an invalid record (after applying the operations preceding it),
+ *      or if it was recorded upon a register of a different number of qubits,
+ *      or if a replayed operation is invalid for \p qureg (e.g. a measurement outcome of zero probability)
+ */
+void applyTraceFile(Qureg qureg, char* filename);
+
 /** Mixes a density matrix \p qureg to induce single-qubit dephasing noise.
  * With probability \p prob, applies Pauli Z to \p targetQubit.
  *
@@ -1925,14 +2561,16 @@ void writeRecordedQASMToFile(Qureg qureg, char* filename);
  * \f]
  * where q = \p targetQubit.
  * \p prob cannot exceed 1/2, which maximally mixes \p targetQubit.
+ * If \p qureg is a state-vector, a single one of the channel's Kraus operators is instead
+ * randomly applied (with its Born probability) and the state renormalised, simulating one
+ * quantum trajectory; see calcTrajectoryAverage().
  *
  * @ingroup decoherence
- * @param[in,out] qureg a density matrix
+ * @param[in,out] qureg a density matrix or state-vector
  * @param[in] targetQubit qubit upon which to induce dephasing noise
  * @param[in] prob the probability of the phase error occuring
  * @throws exitWithError
- *      if \p qureg is not a density matrix,
- *      or if \p targetQubit is outside [0, \p qureg.numQubitsRepresented),
+ *      if \p targetQubit is outside [0, \p qureg.numQubitsRepresented),
  *      or if \p prob is not in [0, 1/2]
  * @author Tyson Jones (GPU, doc)
  * @author Ania Brown (CPU, distributed)
@@ -1952,15 +2590,17 @@ void mixDephasing(Qureg qureg, const int targetQubit, qreal prob);
  * \f]
  * where a = \p qubit1, b = \p qubit2.
  * \p prob cannot exceed 3/4, at which maximal mixing occurs.
+ * If \p qureg is a state-vector, a single one of the channel's Kraus operators is instead
+ * randomly applied (with its Born probability) and the state renormalised, simulating one
+ * quantum trajectory; see calcTrajectoryAverage().
  *
  * @ingroup decoherence
- * @param[in,out] qureg a density matrix
+ * @param[in,out] qureg a density matrix or state-vector
  * @param[in] qubit1 qubit upon which to induce dephasing noise
  * @param[in] qubit2 qubit upon which to induce dephasing noise
  * @param[in] prob the probability of the phase error occuring
  * @throws exitWithError
- *      if \p qureg is not a density matrix,
- *      or if either \p qubit1 or \p qubit2 is outside [0, \p qureg.numQubitsRepresented),
+ *      if either \p qubit1 or \p qubit2 is outside [0, \p qureg.numQubitsRepresented),
  *      or if \p qubit1 = \p qubit2,
  *      or if \p prob is not in [0, 3/4]
  * @author Tyson Jones (GPU, doc)
@@ -1989,14 +2629,16 @@ void mixTwoQubitDephasing(Qureg qureg, int qubit1, int qubit2, qreal prob);
  * \f]
  * where \f$ \frac{\vec{\bf{1}}}{2} \f$ is the maximally mixed state of the target 
  * qubit.
+ * If \p qureg is a state-vector, a single one of the channel's Kraus operators is instead
+ * randomly applied (with its Born probability) and the state renormalised, simulating one
+ * quantum trajectory; see calcTrajectoryAverage().
  *
  * @ingroup decoherence
- * @param[in,out] qureg a density matrix
+ * @param[in,out] qureg a density matrix or state-vector
  * @param[in] targetQubit qubit upon which to induce depolarising noise
  * @param[in] prob the probability of the depolarising error occuring
  * @throws exitWithError
- *      if \p qureg is not a density matrix,
- *      or if \p targetQubit is outside [0, \p qureg.numQubitsRepresented),
+ *      if \p targetQubit is outside [0, \p qureg.numQubitsRepresented),
  *      or if \p prob is not in [0, 3/4]
  * @author Tyson Jones (GPU, doc)
  * @author Ania Brown (CPU, distributed)
@@ -2019,14 +2661,16 @@ void mixDepolarising(Qureg qureg, const int targetQubit, qreal prob);
  * mixDephasing() and mixDepolarising(), this function can increase the purity of a 
  * mixed state (by, as \p prob becomes 1, gaining certainty that the qubit is in
  * the 0 state).
+ * If \p qureg is a state-vector, a single one of the channel's Kraus operators is instead
+ * randomly applied (with its Born probability) and the state renormalised, simulating one
+ * quantum trajectory; see calcTrajectoryAverage().
  *
  * @ingroup decoherence
- * @param[in,out] qureg a density matrix
+ * @param[in,out] qureg a density matrix or state-vector
  * @param[in] targetQubit qubit upon which to induce amplitude damping
  * @param[in] prob the probability of the damping
  * @throws exitWithError
- *      if \p qureg is not a density matrix,
- *      or if \p targetQubit is outside [0, \p qureg.numQubitsRepresented),
+ *      if \p targetQubit is outside [0, \p qureg.numQubitsRepresented),
  *      or if \p prob is not in [0, 1]
  * @author Nicolas Vogt of HQS
  * @author Ania Brown (patched)
@@ -2034,6 +2678,59 @@ void mixDepolarising(Qureg qureg, const int targetQubit, qreal prob);
  */
 void mixDamping(Qureg qureg, const int targetQubit, qreal prob);
 
+/** Mixes a density matrix \p qureg to induce single-qubit dephasing noise upon every qubit.
+ * This is equivalent to calling mixDephasing() with \p prob upon each qubit in turn, but 
+ * visits the density matrix only once: every element is multiplied by 
+ * \f$(1 - 2 \, \text{prob})^k\f$, where k is the number of qubits in which its row and column differ.
+ *
+ * If \p qureg is a state-vector, mixDephasing() is instead applied to each qubit as a 
+ * single quantum trajectory.
+ *
+ * @ingroup decoherence
+ * @param[in,out] qureg a density matrix or state-vector
+ * @param[in] prob the probability of the phase error occuring upon each qubit
+ * @throws exitWithError
+ *      if \p prob is not in [0, 1/2]
+ */
+void mixDephasingAll(Qureg qureg, qreal prob);
+
+/** Mixes a density matrix \p qureg to induce single-qubit homogeneous depolarising noise
+ * upon every qubit. This is equivalent to calling mixDepolarising() with \p prob upon each 
+ * qubit in turn, but visits the density matrix once per group of up to four qubits, 
+ * applying the channel to the group while its elements are in cache.
+ *
+ * If \p qureg is a state-vector, mixDepolarising() is instead applied to each qubit as a 
+ * single quantum trajectory.
+ *
+ * @ingroup decoherence
+ * @param[in,out] qureg a density matrix or state-vector
+ * @param[in] prob the probability of the depolarising error occuring upon each qubit
+ * @throws exitWithError
+ *      if \p prob is not in [0, 3/4]
+ */
+void mixDepolarisingAll(Qureg qureg, qreal prob);
+
+/** Mixes a density matrix \p qureg to induce single-qubit amplitude damping upon each
+ * of \p targets. This is equivalent to calling mixDamping() with \p prob upon each target 
+ * in turn, but visits the density matrix once per group of up to four targets, 
+ * applying the channel to the group while its elements are in cache.
+ *
+ * If \p qureg is a state-vector, mixDamping() is instead applied to each target as a 
+ * single quantum trajectory.
+ *
+ * @ingroup decoherence
+ * @param[in,out] qureg a density matrix or state-vector
+ * @param[in] targets a list of the qubits to damp
+ * @param[in] numTargets the length of list \p targets
+ * @param[in] prob the probability of the damping upon each target
+ * @throws exitWithError
+ *      if \p numTargets is outside [1, \p qureg.numQubitsRepresented],
+ *      or if any qubit in \p targets is outside [0, \p qureg.numQubitsRepresented),
+ *      or if any qubit in \p targets is repeated,
+ *      or if \p prob is not in [0, 1]
+ */
+void mixDampingOnQubits(Qureg qureg, int* targets, int numTargets, qreal prob);
+
 /** Mixes a density matrix \p qureg to induce two-qubit homogeneous depolarising noise.
  * With probability \p prob, applies to \p qubit1 and \p qubit2 any operator of the set
  * \f$\{ IX, IY, IZ, XI, YI, ZI, XX, XY, XZ, YX, YY, YZ, ZX, ZY, ZZ \}\f$.
@@ -2082,15 +2779,17 @@ void mixDamping(Qureg qureg, const int targetQubit, qreal prob);
  * \f]
  * where \f$ \frac{\vec{\bf{1}}}{2} \f$ is the maximally mixed state of the two
  * target qubits.
+ * If \p qureg is a state-vector, a single one of the channel's Kraus operators is instead
+ * randomly applied (with its Born probability) and the state renormalised, simulating one
+ * quantum trajectory; see calcTrajectoryAverage().
  *
  * @ingroup decoherence
- * @param[in,out] qureg a density matrix
+ * @param[in,out] qureg a density matrix or state-vector
  * @param[in] qubit1 qubit upon which to induce depolarising noise
  * @param[in] qubit2 qubit upon which to induce depolarising noise
  * @param[in] prob the probability of the depolarising error occuring
  * @throws exitWithError
- *      if \p qureg is not a density matrix,
- *      or if either \p qubit1 or \p qubit2 is outside [0, \p qureg.numQubitsRepresented),
+ *      if either \p qubit1 or \p qubit2 is outside [0, \p qureg.numQubitsRepresented),
  *      or if \p qubit1 = \p qubit2,
  *      or if \p prob is not in [0, 15/16]
  * @author Tyson Jones (GPU, doc)
@@ -2115,16 +2814,18 @@ void mixTwoQubitDepolarising(Qureg qureg, int qubit1, int qubit2, qreal prob);
  *
  * This function operates by first converting the given Pauli probabilities into 
  * a single-qubit Kraus map (four 2x2 operators).
+ * If \p qureg is a state-vector, a single one of the channel's Kraus operators is instead
+ * randomly applied (with its Born probability) and the state renormalised, simulating one
+ * quantum trajectory; see calcTrajectoryAverage().
  *
  * @ingroup decoherence
- * @param[in,out] qureg a density matrix
+ * @param[in,out] qureg a density matrix or state-vector
  * @param[in] targetQubit qubit to decohere
  * @param[in] probX the probability of inducing an X error
  * @param[in] probX the probability of inducing an Y error
  * @param[in] probX the probability of inducing an Z error
  * @throws exitWithError
- *      if \p qureg is not a density matrix,
- *      or if \p targetQubit is outside [0, \p qureg.numQubitsRepresented),
+ *      if \p targetQubit is outside [0, \p qureg.numQubitsRepresented),
  *      or if any of \p probX, \p probY or \p probZ are not in [0, 1],
  *      or if any of p in {\p probX, \p probY or \p probZ} don't satisfy
  *      p <= (1 - \p probX - \p probY - \p probZ)
@@ -2194,7 +2895,9 @@ qreal calcPurity(Qureg qureg);
  * @return the fidelity between the input registers
  * @throws exitWithError
  *      if the second argument (\p pureState) is not a statevector, 
- *      or if the number of qubits in \p qureg and \p pureState do not match
+ *      or if the number of qubits in \p qureg and \p pureState do not match,
+ *      or if exactly one of two state-vectors has real amplitudes (see createRealQureg()),
+ *      or if \p qureg is a density matrix and \p pureState has real amplitudes
  * @author Tyson Jones
  */
 qreal calcFidelity(Qureg qureg, Qureg pureState);
@@ -2434,17 +3137,18 @@ void multiRotatePauli(Qureg qureg, int* targetQubits, enum pauliOpType* targetPa
  * will compute \f$ \langle \psi | I I I I X I Z | \psi \rangle \f$ (where in this notation, the left-most operator
  * applies to the least-significant qubit, i.e. that with index 0).
  *
- * \p workspace must be a register with the same type (statevector vs density matrix) and dimensions 
+ * If \p qureg is a statevector, \p workspace must be a statevector with the same dimensions 
  * (number of represented qubits) as \p qureg, and is used as working space. When this function returns, \p qureg 
- * will be unchanged and \p workspace will be set to \f$ \sigma | \psi \rangle \f$ (if \p qureg is a statevector)
- * or \f$ \sigma \rho \f$ (if \p qureg is a density matrix). NOTE that this last quantity is NOT the result of applying 
- * the paulis as unitaries, \f$ \sigma^\dagger \rho \sigma \f$, but is instead the result of their direct 
- * multiplication with the density matrix. It is therefore itself not a valid density matrix.
+ * will be unchanged and \p workspace will be set to \f$ \sigma | \psi \rangle \f$. 
+ * This works by cloning the \p qureg state into \p workspace, applying the specified 
+ * Pauli operators to \p workspace then computing its inner product with \p qureg. It therefore should 
+ * scale linearly in time with the number of specified non-identity Pauli operators.
  *
- * This function works by cloning the \p qureg state into \p workspace, applying the specified 
- * Pauli operators to \p workspace then computing its inner product with \p qureg (for statevectors)
- * or its trace (for density matrices). It therefore should scale linearly in time with the number of 
- * specified non-identity Pauli operators, which is bounded by the number of represented qubits.
+ * If \p qureg is a density matrix (including a packed one), \p workspace is not used nor modified, 
+ * and may be any register. The trace is instead evaluated directly as 
+ * \f$ \sum_r \langle r | \sigma | r \oplus f \rangle \, \rho_{r \oplus f, r} \f$, where \f$ f \f$ flags the 
+ * qubits targeted by \p PAULI_X or \p PAULI_Y. This visits only the \f$ 2^N \f$ elements of \f$ \rho \f$ 
+ * which \f$ \sigma \f$ connects, and needs no additional memory.
  *
  * @ingroup calc
  * @param[in] qureg the register of which to find the expected value, which is unchanged by this function
@@ -2453,13 +3157,13 @@ void multiRotatePauli(Qureg qureg, int* targetQubits, enum pauliOpType* targetPa
  *      to apply to the corresponding qubits in \p targetQubits
  * @param[in] numTargets number of target qubits, i.e. the length of \p targetQubits and \p pauliCodes
  * @param[in,out] workspace a working-space qureg with the same dimensions as \p qureg, which is modified 
- *      to be the result of multiplying the state with the pauli operators
+ *      to be the result of multiplying the state with the pauli operators. Unused if \p qureg is a density matrix
  * @throws exitWithError
  *      if \p numTargets is outside [1, \p qureg.numQubitsRepresented]),
  *      or if any qubit in \p targetQubits is outside [0, \p qureg.numQubitsRepresented))
  *      or if any qubit in \p targetQubits is repeated,
  *      or if any code in \p pauliCodes is not in {0,1,2,3},
- *      or if \p workspace is not of the same type and dimensions as \p qureg
+ *      or if \p qureg is a statevector and \p workspace is not of the same type and dimensions as \p qureg
  * @author Tyson Jones
  */
 qreal calcExpecPauliProd(Qureg qureg, int* targetQubits, enum pauliOpType* pauliCodes, int numTargets, Qureg workspace);
@@ -2486,17 +3190,20 @@ qreal calcExpecPauliProd(Qureg qureg, int* targetQubits, enum pauliOpType* pauli
  * will compute \f$ \langle \psi | (1.5 X I I - 3.6 X Y Z) | \psi \rangle \f$ (where in this notation, the left-most operator
  * applies to the least-significant qubit, i.e. that with index 0).
  * 
- * \p workspace must be a register with the same type (statevector vs density matrix) and dimensions 
+ * If \p qureg is a statevector, \p workspace must be a statevector with the same dimensions 
  * (number of represented qubits) as \p qureg, and is used as working space. When this function returns, \p qureg 
  * will be unchanged and \p workspace will be set to \p qureg pre-multiplied with the final Pauli product.
- * NOTE that if \p qureg is a density matrix, \p workspace will become \f$ \hat{\sigma} \rho \f$ 
- * which is itself not a density matrix (it is distinct from \f$ \hat{\sigma}^\dagger \rho \hat{\sigma} \f$).
- *
- * This function works by cloning the \p qureg state into \p workspace, applying each of the specified
- * Pauli products to \p workspace (one Pauli operation at a time), then computing its inner product with \p qureg (for statevectors)
- * or its trace (for density matrices) multiplied with the corresponding coefficient, and summing these contributions. 
+ * This works by cloning the \p qureg state into \p workspace, applying each of the specified
+ * Pauli products to \p workspace (one Pauli operation at a time), then computing its inner product with \p qureg 
+ * multiplied with the corresponding coefficient, and summing these contributions. 
  * It therefore should scale linearly in time with the total number of non-identity specified Pauli operators.
  *
+ * If \p qureg is a density matrix (including a packed one), \p workspace is not used nor modified, 
+ * and may be any register. Each term's trace is evaluated directly from the \f$ 2^N \f$ elements of 
+ * \f$ \rho \f$ which its Pauli product connects (see calcExpecPauliProd()), and all terms are accumulated 
+ * in a single sweep over the columns of \f$ \rho \f$, so that the cost is that of reading \f$ \rho \f$ once 
+ * plus \f$ 2^N \f$ operations per term, with no additional memory.
+ *
  * @ingroup calc
  * @param[in] qureg the register of which to find the expected value, which is unchanged by this function
  * @param[in] allPauliCodes a list of the Pauli codes (0=PAULI_I, 1=PAULI_X, 2=PAULI_Y, 3=PAULI_Z) 
@@ -2505,15 +3212,108 @@ qreal calcExpecPauliProd(Qureg qureg, int* targetQubits, enum pauliOpType* pauli
  * @param[in] termCoeffs The coefficients of each term in the sum of Pauli products
  * @param[in] numSumTerms The total number of Pauli products specified
  * @param[in,out] workspace a working-space qureg with the same dimensions as \p qureg, which is modified 
- *      to be the result of multiplying the state with the final specified Pauli product
+ *      to be the result of multiplying the state with the final specified Pauli product. 
+ *      Unused if \p qureg is a density matrix
  * @throws exitWithError
  *      if any code in \p allPauliCodes is not in {0,1,2,3},
  *      or if numSumTerms <= 0,
- *      or if \p workspace is not of the same type and dimensions as \p qureg
+ *      or if \p qureg is a statevector and \p workspace is not of the same type and dimensions as \p qureg
  * @author Tyson Jones
  */
 qreal calcExpecPauliSum(Qureg qureg, enum pauliOpType* allPauliCodes, qreal* termCoeffs, int numSumTerms, Qureg workspace);
 
+/** Computes the reduced density matrix of the qubits \p keepQubits, by tracing out every 
+ * other qubit of \p qureg, and stores it in \p out.
+ * Letting \f$ a, b \f$ index the basis states of the kept qubits and \f$ e \f$ those of the 
+ * traced-out qubits, this sets
+ * \f[
+ *     \text{out}_{a b} = \sum_e \psi_{a,e} \, \psi_{b,e}^*
+ * \f]
+ * if \p qureg = \f$ \psi \f$ is a statevector, and 
+ * \f$ \text{out}_{a b} = \sum_e \rho_{(a,e),(b,e)} \f$ if \p qureg = \f$ \rho \f$ is a density matrix.
+ * The kept qubits are ordered as in \p keepQubits, so that \p keepQubits[0] is the least significant 
+ * qubit of the row and column indices of \p out. For example, 
+ *
+ *     ComplexMatrixN rho = createComplexMatrixN(2);
+ *     calcReducedDensityMatrix(qureg, (int[]) {5, 2}, 2, rho);
+ *
+ * sets \p rho.real[1][0] to the real component of the reduced element whose row has qubit 5 in 
+ * state 1 and qubit 2 in state 0, and whose column has both qubits in state 0.
+ *
+ * No density matrix of \p qureg's full size is created; a statevector is streamed once, 
+ * accumulating the \f$ 2^{\text{numKeep}} \times 2^{\text{numKeep}} \f$ matrix in per-thread 
+ * buffers, and distributed registers communicate only this matrix. This takes time 
+ * \f$ O(2^{N + \text{numKeep}}) \f$ for \f$ N \f$ represented qubits. In distributed statevectors, kept qubits 
+ * which index the node are first swapped with local qubits, and swapped back afterward.
+ * Packed density matrices are supported.
+ *
+ * @ingroup calc
+ * @param[in] qureg a statevector or density matrix, which is unchanged by this function
+ * @param[in] keepQubits a list of the qubits not to trace out
+ * @param[in] numKeep the number of qubits in \p keepQubits
+ * @param[out] out a matrix created with createComplexMatrixN(\p numKeep), overwritten 
+ *      with the reduced density matrix
+ * @throws exitWithError
+ *      if \p numKeep is outside [1, \p qureg.numQubitsRepresented],
+ *      or if any qubit in \p keepQubits is outside [0, \p qureg.numQubitsRepresented),
+ *      or if any qubit in \p keepQubits is repeated,
+ *      or if \p out was not created, or was created for a number of qubits other than \p numKeep,
+ *      or if a \p numKeep qubit block of amplitudes cannot fit in a single distributed node
+ */
+void calcReducedDensityMatrix(Qureg qureg, int* keepQubits, int numKeep, ComplexMatrixN out);
+
+/** Estimates the expected value of an observable under a noisy circuit by averaging
+ * over \p numTrajectories quantum trajectories of the state-vector \p qureg.
+ *
+ * For each trajectory, \p qureg is set to the zero state, \p applyNoisyCircuit is called
+ * with \p qureg and \p circuitArgs, and \p calcObservable is called with the resulting
+ * \p qureg and \p observableArgs. The circuit may contain any gates, and the single-qubit
+ * decoherence functions (like mixDephasing() and mixDamping()) and two-qubit Pauli channels,
+ * which upon a state-vector apply one randomly sampled Kraus operator. The mean of the
+ * observable therefore converges to its value under the equivalent density-matrix evolution,
+ * while only ever storing a state-vector.
+ *
+ * Trajectories are simulated one after another, each parallelised by the backend like any
+ * other state-vector operation. Note any QASM recording enabled on \p qureg will log every
+ * trajectory.
+ *
+ * @ingroup calc
+ * @param[in,out] qureg a state-vector, which is left in the state of the final trajectory
+ * @param[in] applyNoisyCircuit a function which applies the noisy circuit to its Qureg argument
+ * @param[in] circuitArgs passed unchanged to every call of \p applyNoisyCircuit
+ * @param[in] calcObservable a function which returns the observable of its Qureg argument
+ * @param[in] observableArgs passed unchanged to every call of \p calcObservable
+ * @param[in] numTrajectories the number of trajectories to average
+ * @returns the mean, variance and standard error of the observable between trajectories
+ * @throws exitWithError
+ *      if \p qureg is not a state-vector,
+ *      or if \p numTrajectories <= 0
+ */
+TrajectoryStats calcTrajectoryAverage(Qureg qureg, void (*applyNoisyCircuit)(Qureg, void*), void* circuitArgs, qreal (*calcObservable)(Qureg, void*), void* observableArgs, int numTrajectories);
+
+/** Estimates the expected value of a sum of Pauli products (as accepted by calcExpecPauliSum())
+ * under a noisy circuit, by averaging over \p numTrajectories quantum trajectories of the 
+ * state-vector \p qureg. See calcTrajectoryAverage().
+ *
+ * @ingroup calc
+ * @param[in,out] qureg a state-vector, which is left in the state of the final trajectory
+ * @param[in] applyNoisyCircuit a function which applies the noisy circuit to its Qureg argument
+ * @param[in] circuitArgs passed unchanged to every call of \p applyNoisyCircuit
+ * @param[in] allPauliCodes the Pauli codes of every qubit in every term, as per calcExpecPauliSum()
+ * @param[in] termCoeffs the coefficients of each term in the sum of Pauli products
+ * @param[in] numSumTerms the number of Pauli products
+ * @param[in,out] workspace a state-vector with the same dimensions as \p qureg
+ * @param[in] numTrajectories the number of trajectories to average
+ * @returns the mean, variance and standard error of the Pauli sum between trajectories
+ * @throws exitWithError
+ *      if \p qureg is not a state-vector,
+ *      or if any code in \p allPauliCodes is not in {0,1,2,3},
+ *      or if numSumTerms <= 0,
+ *      or if \p workspace is not of the same type and dimensions as \p qureg,
+ *      or if \p numTrajectories <= 0
+ */
+TrajectoryStats calcTrajectoryExpecPauliSum(Qureg qureg, void (*applyNoisyCircuit)(Qureg, void*), void* circuitArgs, enum pauliOpType* allPauliCodes, qreal* termCoeffs, int numSumTerms, Qureg workspace, int numTrajectories);
+
 /** Apply a general two-qubit unitary (including a global phase factor).
  *
     \f[
@@ -2958,15 +3758,17 @@ void multiControlledMultiQubitUnitary(Qureg qureg, int* ctrls, const int numCtrl
  *
  * Note that in distributed mode, this routine requires that each node contains at least 4 amplitudes.
  * This means an q-qubit register can be distributed by at most 2^(q-2) numTargs nodes.
+ * If \p qureg is a state-vector, a single one of the channel's Kraus operators is instead
+ * randomly applied (with its Born probability) and the state renormalised, simulating one
+ * quantum trajectory; see calcTrajectoryAverage().
  *
  * @ingroup decoherence
- * @param[in,out] qureg the density matrix to which to apply the map
+ * @param[in,out] qureg the density matrix or state-vector to which to apply the map
  * @param[in] target the target qubit of the map
  * @param[in] ops an array of at most 4 Kraus operators
  * @param[in] numOps the number of operators in \p ops which must be >0 and <= 4.
  * @throws exitWithError
- *      if \p qureg is not a density matrix, 
- *      or if \p target is outside of [0, \p qureg.numQubitsRepresented),
+ *      if \p target is outside of [0, \p qureg.numQubitsRepresented),
  *      or if \p numOps is outside [1, 4],
  *      or if \p ops do not create a completely positive, trace preserving map,
  *      or if a node cannot fit 4 amplitudes in distributed mode.
@@ -3024,7 +3826,11 @@ void mixTwoQubitKrausMap(Qureg qureg, int target1, int target2, ComplexMatrix4 *
  * Note that in distributed mode, this routine requires that each node contains at least (2N)^2 amplitudes.
  * This means an q-qubit register can be distributed by at most 2^(q-2)/N^2 nodes.
  *
- * Note too that this routine internally creates a 'superoperator'; a complex matrix of dimensions
+ * When \p numOps < 2^numTargets (and, in distributed mode, every target's density-matrix
+ * column lies within a node), the map is instead applied directly as 
+ * \f$ \sum_i K_i \rho K_i^\dagger \f$, costing O(numOps 8^numTargets) per block of 
+ * 4^numTargets elements and requiring no superoperator.
+ * Otherwise, this routine internally creates a 'superoperator'; a complex matrix of dimensions
  * 2^(2*numTargets) by 2^(2*numTargets). Therefore, invoking this function incurs, 
  * for numTargs={1,2,3,4,5, ...}, an additional memory overhead of (at double-precision)
  * {0.25 KiB, 4 KiB, 64 KiB, 1 MiB, 16 MiB, ...} (respectively).
@@ -3161,6 +3967,298 @@ void setWeightedQureg(Complex fac1, Qureg qureg1, Complex fac2, Qureg qureg2, Co
  */
 void applyPauliSum(Qureg inQureg, enum pauliOpType* allPauliCodes, qreal* termCoeffs, int numSumTerms, Qureg outQureg);
 
+/** Create an empty Circuit upon \p numQubits qubits, with \p numParams free parameters
+ * (initially zero) to which gates can later be bound with addParamGateToCircuit().
+ * The Circuit must eventually be freed with destroyCircuit().
+ *
+ * @ingroup circuit
+ * @returns an empty circuit
+ * @param[in] numQubits the number of qubits the circuit acts upon
+ * @param[in] numParams the number of free parameters, which may be 0
+ * @throws exitWithError if \p numQubits <= 0 or \p numParams < 0
+ */
+Circuit createCircuit(int numQubits, int numParams);
+
+/** Free the memory of a Circuit created with createCircuit().
+ *
+ * @ingroup circuit
+ * @param[in] circ the circuit to destroy
+ */
+void destroyCircuit(Circuit circ);
+
+/** Append a gate with fixed parameters to the end of \p circ.
+ * \p qubits lists the qubits in the order they are passed to the corresponding
+ * API function; for example
+ *
+ *     addGateToCircuit(circ, CIRCUIT_CONTROLLED_ROTATE_X, (int[]) {ctrl, targ}, (qreal[]) {angle});
+ *
+ * will later effect controlledRotateX(qureg, ctrl, targ, angle). \p params lists
+ * the gate's parameters in the order of that function (e.g. theta, phi, lambda for
+ * \p CIRCUIT_U3) and may be NULL for parameter-free gates.
+ *
+ * @ingroup circuit
+ * @param[in,out] circ the circuit to extend
+ * @param[in] gate the type of gate to append
+ * @param[in] qubits the control and/or target qubits of the gate
+ * @param[in] params the parameters of the gate, or NULL
+ * @throws exitWithError
+ *      if \p gate is not a valid code,
+ *      or if any of \p qubits is outside [0, \p circ.numQubits),
+ *      or if \p qubits are not unique
+ */
+void addGateToCircuit(Circuit circ, enum circuitGateType gate, int* qubits, qreal* params);
+
+/** Append a single-parameter gate to the end of \p circ, whose parameter is
+ * the circuit's free parameter \p paramInd. The gate uses the value of that parameter
+ * current when the circuit is applied, as set by setCircuitParams().
+ *
+ * Only \p CIRCUIT_ROTATE_X, \p _Y, \p _Z, \p CIRCUIT_PHASE_SHIFT, \p CIRCUIT_U1
+ * and their controlled variants \p CIRCUIT_CONTROLLED_ROTATE_X, \p _Y, \p _Z and
+ * \p CIRCUIT_CONTROLLED_PHASE_SHIFT can be bound to a parameter; these
+ * are the gates differentiable by calcCircuitGradient().
+ * Many gates may be bound to the same parameter.
+ *
+ * @ingroup circuit
+ * @param[in,out] circ the circuit to extend
+ * @param[in] gate the type of gate to append
+ * @param[in] qubits the control and/or target qubits of the gate
+ * @param[in] paramInd the index (in [0, \p circ.numParams)) of the parameter to bind
+ * @throws exitWithError
+ *      if \p gate is not one of the parameterisable gates listed above,
+ *      or if \p qubits are invalid (see addGateToCircuit()),
+ *      or if \p paramInd is outside [0, \p circ.numParams)
+ */
+void addParamGateToCircuit(Circuit circ, enum circuitGateType gate, int* qubits, int paramInd);
+
+/** Overwrite all free parameters of \p circ with those in \p params, which must
+ * have length \p circ.numParams.
+ *
+ * @ingroup circuit
+ * @param[in,out] circ the circuit of which to set the parameters
+ * @param[in] params the new parameter values
+ */
+void setCircuitParams(Circuit circ, qreal* params);
+
+/** Compile \p circ into an optimised sequence of operations, which is thereafter
+ * used by applyCircuit() and calcCircuitGradient() until more gates are added.
+ * Since gates are validated when added, compiled circuits are applied without any
+ * further validation of their gates.
+ *
+ * Compilation precomputes the matrices of all gates which are not bound to a
+ * parameter, and fuses every run of such one-qubit gates upon the same qubit
+ * (gates upon other qubits in between them are commuted past) into a single
+ * one-qubit unitary, so that each run costs one pass over the state. Fixed
+ * controlled rotations become precomputed controlled unitaries. Gates bound
+ * to parameters are left intact, so that the parameters can be changed with
+ * setCircuitParams() in O(\p circ.numParams) without recompiling.
+ *
+ * Calling this function is optional; applyCircuit() and calcCircuitGradient()
+ * compile a circuit upon first use.
+ *
+ * @ingroup circuit
+ * @param[in,out] circ the circuit to compile
+ */
+void compileCircuit(Circuit circ);
+
+/** Apply every gate in \p circ, in order, to \p qureg, which can be a state-vector
+ * or density matrix. This is equivalent to calling each gate's API function in turn
+ * (including their QASM recording), where parameterised gates use the current
+ * parameter values of \p circ. The circuit is first compiled with compileCircuit()
+ * if it has not been since gates were last added.
+ *
+ * @ingroup circuit
+ * @param[in,out] qureg the register to modify
+ * @param[in] circ the circuit to apply
+ * @throws exitWithError 
+ *      if \p qureg does not represent \p circ.numQubits qubits,
+ *      or if \p qureg is a real-amplitude register (see createRealQureg()) and a gate of \p circ
+ *      has a complex matrix (under the current parameters),
+ *      or if \p qureg is a fixed Hamming-weight register (see createSubspaceQureg()) and a gate
+ *      of \p circ does not conserve the number of qubits in |1>,
+ *      or if \p qureg is a packed register
+ */
+void applyCircuit(Qureg qureg, Circuit circ);
+
+/** Compute the number of bytes of amplitudes which applyCircuit() reads and writes from the files
+ * of an out-of-core \p qureg (see createOutOfCoreQureg()) to apply \p circ, per node.
+ *
+ * Each pass over the state (of a single gate upon a high qubit, or of a group of gates 
+ * upon only low qubits, applied block-by-block) reads and writes every local amplitude once, 
+ * and its cost is shared equally between the gates of the pass. The share of each gate of 
+ * \p circ is written to \p gateIOBytes, so that gates which force a pass of their own can be 
+ * identified, and the circuit reordered or its qubits relabelled to group them. The traffic is 
+ * modelled upon the uncompiled gates, and assumes no amplitudes remain cached between passes.
+ * \p qureg need not itself be out-of-core, so that circuits can be planned in advance.
+ *
+ * @ingroup circuit
+ * @returns the total bytes read and written by applyCircuit()
+ * @param[in] qureg a state-vector of the size to which \p circ would be applied
+ * @param[in] circ the circuit to analyse
+ * @param[out] gateIOBytes the bytes attributed to each gate of \p circ, in order of addition, 
+ *      or NULL
+ * @throws exitWithError if \p qureg is a density matrix, or does not represent \p circ.numQubits qubits
+ */
+long long int calcCircuitIOBytes(Qureg qureg, Circuit circ, long long int* gateIOBytes);
+
+/** Compute the expected value of a Pauli sum Hamiltonian \f$H\f$ under the state
+ * \f$U(\vec{\theta})|\psi\rangle\f$ prepared by \p circ upon the state \f$|\psi\rangle\f$
+ * in \p qureg, and its gradient with respect to every free parameter of \p circ.
+ *
+ * This uses the adjoint method: the circuit is applied once, \f$H\f$ is applied
+ * to the output (into \p workspace1), and then both registers are uncomputed
+ * gate-by-gate with each gate's inverse; at every parameterised gate, its generator is
+ * applied to a copy (in \p workspace2) to evaluate that gate's contribution to the gradient.
+ * The cost is therefore roughly three circuit traversals, plus three passes
+ * over the state per parameterised gate, and needs only two workspaces
+ * regardless of the number of parameters. Contributions of gates bound to the
+ * same parameter are summed.
+ *
+ * \p allPauliCodes, \p termCoeffs and \p numSumTerms specify \f$H\f$ exactly
+ * as in calcExpecPauliSum(). On return, \p qureg is restored to its input state
+ * (up to numerical error), and \p gradient (of length \p circ.numParams)
+ * contains \f$\partial \langle H \rangle / \partial \theta_i\f$.
+ *
+ * @ingroup circuit
+ * @returns the expected value \f$\langle \psi|U^\dagger H U|\psi\rangle\f$
+ * @param[in,out] qureg the state-vector upon which \p circ is evaluated; it is restored on return
+ * @param[in] circ the parameterised circuit
+ * @param[in] allPauliCodes the Pauli codes of every term of \f$H\f$, as in calcExpecPauliSum()
+ * @param[in] termCoeffs the coefficients of every term of \f$H\f$
+ * @param[in] numSumTerms the number of terms in \f$H\f$
+ * @param[out] gradient the derivative of the expected value with respect to every circuit parameter
+ * @param[in] workspace1 a working register of the same size as \p qureg
+ * @param[in] workspace2 a further working register of the same size as \p qureg
+ * @throws exitWithError
+ *      if \p qureg or either workspace is a density matrix,
+ *      or if the registers do not represent \p circ.numQubits qubits,
+ *      or if the Pauli sum is invalid (see calcExpecPauliSum())
+ */
+qreal calcCircuitGradient(Qureg qureg, Circuit circ, enum pauliOpType* allPauliCodes, qreal* termCoeffs, int numSumTerms, qreal* gradient, Qureg workspace1, Qureg workspace2);
+
+/** Read an OpenQASM 2.0 circuit from the file \p filename into a new Circuit, which acts upon
+ * every qubit of its quantum registers (concatenated in order of declaration), and must later be 
+ * destroyed with destroyCircuit().
+ *
+ * The file is read and parsed incrementally, so need not fit in memory. The gates of qelib1.inc 
+ * (and the gate labels of QuEST's own QASM output, like Rz and cRx) are supported, as are gate 
+ * definitions, \p opaque declarations (which cannot be applied), register broadcasting, barriers 
+ * (which are ignored), and \p include of further files (except qelib1.inc, which is always included).
+ * Gates with a Circuit equivalent (like \p u3, \p cx and \p crz) are added directly, and others 
+ * (like \p ccx, or user-defined gates) are expanded into their definitions. Note that \p rx, \p ry 
+ * and \p rz are the rotations \f$\exp(-i \theta \sigma/2)\f$ of rotateX() etc, so \p rz differs 
+ * from \p u1 by a global phase.
+ *
+ * A Circuit cannot contain measurements, resets or classically-conditioned gates; use 
+ * applyQASMFile() to simulate circuits which do.
+ *
+ * @ingroup circuit
+ * @returns a new Circuit of the gates in the file
+ * @param[in] filename the name of the OpenQASM 2.0 file
+ * @throws exitWithError
+ *      if the file cannot be opened, or is not valid OpenQASM 2.0 (citing the offending line),
+ *      or declares no quantum register,
+ *      or declares a quantum register after its first gate,
+ *      or contains a measurement, reset, \p if or use of an opaque gate
+ */
+Circuit readQASMFile(char* filename);
+
+/** Read an OpenQASM 2.0 circuit from the string \p qasm into a new Circuit. 
+ * This is otherwise identical to readQASMFile().
+ *
+ * @ingroup circuit
+ * @returns a new Circuit of the gates in \p qasm
+ * @param[in] qasm the OpenQASM 2.0 program
+ * @throws exitWithError
+ *      if \p qasm is not valid OpenQASM 2.0, or cannot form a Circuit (see readQASMFile())
+ */
+Circuit readQASMString(char* qasm);
+
+/** Simulate the OpenQASM 2.0 program in the file \p filename upon \p qureg, which can be a 
+ * state-vector or density matrix. The program's quantum registers (concatenated in order of 
+ * declaration) are mapped to the lowest qubits of \p qureg, which is not initialised beforehand. 
+ *
+ * The file is read incrementally, and its gates (as supported by readQASMFile()) are collected 
+ * into batches which are compiled and applied as by applyCircuit(), so that runs of one-qubit 
+ * gates are fused. Unlike readQASMFile(), \p measure (whose outcome is stored in the classical 
+ * register), \p reset (to \f$|0\rangle\f$) and \p if (upon the value of a whole classical register, 
+ * whose first bit is least significant) are also supported, and are recorded as QASM. 
+ * If the program is invalid, the gates preceding the error may already have been applied.
+ *
+ * @ingroup circuit
+ * @param[in,out] qureg the register upon which to simulate the program
+ * @param[in] filename the name of the OpenQASM 2.0 file
+ * @throws exitWithError
+ *      if the file cannot be opened, or is not valid OpenQASM 2.0 (citing the offending line),
+ *      or its quantum registers contain more qubits than \p qureg,
+ *      or it uses an opaque gate,
+ *      or it measures or resets a compressed \p qureg,
+ *      or it applies a gate with a complex matrix to a real-amplitude \p qureg,
+ *      or it applies a gate which does not conserve the number of qubits in |1>, or a \p reset, 
+ *      to a fixed Hamming-weight \p qureg,
+ *      or if \p qureg is a packed register
+ */
+void applyQASMFile(Qureg qureg, char* filename);
+
+/** Simulate the OpenQASM 2.0 program \p qasm upon \p qureg.
+ * This is otherwise identical to applyQASMFile().
+ *
+ * @ingroup circuit
+ * @param[in,out] qureg the register upon which to simulate the program
+ * @param[in] qasm the OpenQASM 2.0 program
+ * @throws exitWithError
+ *      if \p qasm is not valid OpenQASM 2.0, or cannot be applied to \p qureg (see applyQASMFile())
+ */
+void applyQASMString(Qureg qureg, char* qasm);
+
+/** Read the gates in the file \p filename into a new Circuit upon \p numQubits qubits, which must
+ * later be destroyed with destroyCircuit(). This lets circuits be changed without recompiling,
+ * and the result can be compiled and applied like any other Circuit.
+ *
+ * The file is either binary, as written by writeCircuitFile(), or text. Text files list calls
+ * to QuEST's gate functions upon a single register (of any name), as the example
+ * circuit files do, e.g.
+ *
+ *     // depth = 0
+ *     SqW( QReg, 0 );
+ *     controlledRotateX(QReg, 8, 20, 0.7111750121892845);
+ *     fSim( QReg, 0, 5, -0.9274470782389919, 1.1916705004129888 );
+ *
+ * Arguments must be literal integers and real numbers, and C comments may appear between
+ * calls. The supported functions are those with an enum circuitGateType equivalent:
+ * hadamard(), pauliX(), pauliY(), pauliZ(), sGate(), tGate(), SqX(), SqY(), SqW(),
+ * rotateX(), rotateY(), rotateZ(), phaseShift(), u1Gate(), u2Gate(), u3Gate(),
+ * controlledNot(), controlledPauliY(), controlledPhaseFlip(), controlledRotateX(),
+ * controlledRotateY(), controlledRotateZ(), controlledPhaseShift(), swapGate() and fSim().
+ *
+ * The file is memory-mapped rather than read through a buffer. Binary files, which need no
+ * number conversion, are the fastest to load.
+ *
+ * @ingroup circuit
+ * @returns a new Circuit of the gates in the file, with no free parameters
+ * @param[in] filename the name of the text or binary circuit file
+ * @param[in] numQubits the number of qubits of the circuit
+ * @throws exitWithError
+ *      if \p numQubits <= 0,
+ *      or if the file cannot be opened,
+ *      or if a text file contains an unsupported function or malformed call (citing the line),
+ *      or if a binary file is truncated, or written by a different version of QuEST,
+ *      or if any gate's qubits are not unique or not in [0, \p numQubits)
+ */
+Circuit readCircuitFile(char* filename, int numQubits);
+
+/** Write the gates of \p circ to the file \p filename in the binary format read by
+ * readCircuitFile(). Each gate takes a fixed 36 bytes. Parameters are stored in double
+ * precision, whatever QuEST_PREC is, and in the native byte order. Gates bound to a circuit
+ * parameter are written with that parameter's current value, so the binding is lost.
+ * With distributed QuEST, this should be called by only one process.
+ *
+ * @ingroup circuit
+ * @param[in] circ the circuit to write
+ * @param[in] filename the name of the file to (over)write
+ * @throws exitWithError if the file cannot be written
+ */
+void writeCircuitFile(Circuit circ, char* filename);
+
 /** An internal function called when invalid arguments are passed to a QuEST API
  * call, which the user can optionally override by redefining. This function is 
  * a weak symbol, so that users can choose how input errors are handled, by 
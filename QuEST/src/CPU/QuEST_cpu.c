@@ -22,7 +22,6 @@
 # include <stdlib.h>
 # include <stdint.h>
 # include <assert.h>
-# include <immintrin.h>
 
 # ifdef _OPENMP
 # include <omp.h>
@@ -77,6 +76,10 @@ void densmatr_oneQubitDegradeOffDiagonal(Qureg qureg, const int targetQubit, qre
 }
 
 void densmatr_mixDephasing(Qureg qureg, const int targetQubit, qreal dephase) {
+    if (qureg.isPacked) {
+        packmatr_mixDephasingLocal(qureg, targetQubit, dephase);
+        return;
+    }
     qreal retain=1-dephase;
     densmatr_oneQubitDegradeOffDiagonal(qureg, targetQubit, retain);
 }
@@ -126,6 +129,57 @@ void densmatr_mixTwoQubitDephasing(Qureg qureg, const int qubit1, const int qubi
     }
 }
 
+/** Returns the number of 1 bits in bits */
+static inline int countOneBits(long long int bits) {
+    int num = 0;
+    for (; bits; num++)
+        bits &= bits - 1;
+    return num;
+}
+
+void densmatr_mixDephasingAll(Qureg qureg, qreal dephase) {
+    if (qureg.isPacked) {
+        packmatr_mixDephasingAllLocal(qureg, dephase);
+        return;
+    }
+
+    const int numQubits = qureg.numQubitsRepresented;
+    const long long int numTasks = qureg.numAmpsPerChunk;
+    const long long int globalIndStart = qureg.chunkId*qureg.numAmpsPerChunk;
+    const long long int rowMask = (1LL << numQubits) - 1;
+
+    // every qubit in which the row and column differ degrades the element once
+    qreal retainPowers[numQubits+1];
+    retainPowers[0] = 1;
+    for (int q=1; q<=numQubits; q++)
+        retainPowers[q] = retainPowers[q-1]*(1-dephase);
+
+    long long int thisTask;
+    long long int globalInd;
+    qreal retain;
+
+    // Can't use qureg.stateVec as a private OMP var
+    qreal *reVec = qureg.stateVec.real;
+    qreal *imVec = qureg.stateVec.imag;
+
+# ifdef _OPENMP
+# pragma omp parallel \
+    shared   (reVec,imVec,retainPowers) \
+    private  (thisTask,globalInd,retain)
+# endif
+    {
+# ifdef _OPENMP
+# pragma omp for schedule (static)
+# endif
+        for (thisTask=0; thisTask<numTasks; thisTask++){
+            globalInd = thisTask + globalIndStart;
+            retain = retainPowers[countOneBits((globalInd & rowMask) ^ (globalInd >> numQubits))];
+            reVec[thisTask] = retain*reVec[thisTask];
+            imVec[thisTask] = retain*imVec[thisTask];
+        }
+    }
+}
+
 void densmatr_mixDepolarisingLocal(Qureg qureg, const int targetQubit, qreal depolLevel) {
     qreal retain=1-depolLevel;
 
@@ -223,6 +277,145 @@ void densmatr_mixDampingLocal(Qureg qureg, const int targetQubit, qreal damping)
     }
 }
 
+/** Apply the same single-qubit channel to a tile of at most MAX_NUM_TILE_TARGETS targets in one 
+ * pass. Each group of 4^numTargets elements which differ only in the targets' row and column bits 
+ * is gathered into a private buffer, has the channel applied upon every target, and is scattered back.
+ * NUM_TILE_GROUPS neighbouring groups are processed together, so that the buffer is gathered from
+ * contiguous runs of the density matrix and the channel is applied by unit-stride loops.
+ * The channel scales the elements off-diagonal in a target by offDiagFac, and maps each pair
+ * {|..0..><..0..|, |..1..><..1..|} through the real 2x2 matrix diagMap.
+ * The targets' column bits must all lie within the chunk.
+ */
+static void densmatr_mixOneQubitChannelOnTileLocal(Qureg qureg, int* targets, int numTargets, qreal offDiagFac, qreal diagMap[2][2]) {
+
+    const int numQubits = qureg.numQubitsRepresented;
+    const int numTileBits = 2*numTargets;
+    const long long int numTileElems = 1LL << numTileBits;
+    const long long int numGroups = qureg.numAmpsPerChunk >> numTileBits;
+    const long long int numGroupsPerTask = (numGroups < NUM_TILE_GROUPS)? numGroups : NUM_TILE_GROUPS;
+    const long long int numTasks = numGroups / numGroupsPerTask;
+    const qreal m00 = diagMap[0][0], m01 = diagMap[0][1], m10 = diagMap[1][0], m11 = diagMap[1][1];
+
+    // sort the targets; the column bits (targets + numQubits) all exceed the row bits
+    int sortedTargs[numTargets];
+    int t, j;
+    for (t=0; t < numTargets; t++) {
+        for (j=t; j > 0 && sortedTargs[j-1] > targets[t]; j--)
+            sortedTargs[j] = sortedTargs[j-1];
+        sortedTargs[j] = targets[t];
+    }
+
+    // tile bit 2t is the row bit of targets[t] and tile bit 2t+1 is its column bit. Since the
+    // channels upon different targets commute, and each degrades only the elements which its
+    // mixing leaves alone, every element's total degradation is applied once when scattered
+    long long int tileOffsets[numTileElems];
+    qreal tileFacs[numTileElems];
+    long long int e;
+    for (e=0; e < numTileElems; e++) {
+        tileOffsets[e] = 0;
+        tileFacs[e] = 1;
+        for (t=0; t < numTargets; t++) {
+            if ((e >> (2*t)) & 1)
+                tileOffsets[e] |= 1LL << targets[t];
+            if ((e >> (2*t + 1)) & 1)
+                tileOffsets[e] |= 1LL << (targets[t] + numQubits);
+            if (((e >> (2*t)) ^ (e >> (2*t + 1))) & 1)
+                tileFacs[e] *= offDiagFac;
+        }
+    }
+
+    long long int thisTask;
+    long long int g, ind00, e00, e11;
+    long long int groupInds00[numGroupsPerTask];
+    qreal re0, im0, re1, im1;
+    qreal reTile[numTileElems][numGroupsPerTask];
+    qreal imTile[numTileElems][numGroupsPerTask];
+
+    // Can't use qureg.stateVec as a private OMP var
+    qreal *reVec = qureg.stateVec.real;
+    qreal *imVec = qureg.stateVec.imag;
+
+# ifdef _OPENMP
+# pragma omp parallel \
+    shared   (reVec,imVec, sortedTargs,tileOffsets,tileFacs) \
+    private  (thisTask,t,e,g,ind00,e00,e11, re0,im0,re1,im1, groupInds00,reTile,imTile)
+# endif
+    {
+# ifdef _OPENMP
+# pragma omp for schedule (static)
+# endif
+        for (thisTask=0; thisTask<numTasks; thisTask++) {
+
+            // find each group's start index (where all target row and column bits are 0)
+            for (g=0; g < numGroupsPerTask; g++) {
+                ind00 = thisTask*numGroupsPerTask + g;
+                for (t=0; t < numTargets; t++)
+                    ind00 = insertZeroBit(ind00, sortedTargs[t]);
+                for (t=0; t < numTargets; t++)
+                    ind00 = insertZeroBit(ind00, sortedTargs[t] + numQubits);
+                groupInds00[g] = ind00;
+            }
+
+            for (e=0; e < numTileElems; e++) {
+                for (g=0; g < numGroupsPerTask; g++) {
+                    reTile[e][g] = reVec[groupInds00[g] | tileOffsets[e]];
+                    imTile[e][g] = imVec[groupInds00[g] | tileOffsets[e]];
+                }
+            }
+
+            // mix each |..0..><..0..| with |..1..><..1..|
+            for (t=0; t < numTargets; t++) {
+                for (e=0; e < numTileElems/4; e++) {
+                    e00 = insertTwoZeroBits(e, 2*t, 2*t + 1);
+                    e11 = e00 | (3LL << (2*t));
+                    for (g=0; g < numGroupsPerTask; g++) {
+                        re0 = reTile[e00][g];  im0 = imTile[e00][g];
+                        re1 = reTile[e11][g];  im1 = imTile[e11][g];
+                        reTile[e00][g] = m00*re0 + m01*re1;
+                        imTile[e00][g] = m00*im0 + m01*im1;
+                        reTile[e11][g] = m10*re0 + m11*re1;
+                        imTile[e11][g] = m10*im0 + m11*im1;
+                    }
+                }
+            }
+
+            // degrade each |..0..><..1..| and |..1..><..0..|
+            for (e=0; e < numTileElems; e++) {
+                for (g=0; g < numGroupsPerTask; g++) {
+                    reVec[groupInds00[g] | tileOffsets[e]] = tileFacs[e]*reTile[e][g];
+                    imVec[groupInds00[g] | tileOffsets[e]] = tileFacs[e]*imTile[e][g];
+                }
+            }
+        }
+    }
+}
+
+/** Apply the same single-qubit channel (as per densmatr_mixOneQubitChannelOnTileLocal) to every 
+ * target, visiting the full density matrix once per MAX_NUM_TILE_TARGETS targets rather than once 
+ * per target. The targets' column bits must all lie within the chunk.
+ */
+static void densmatr_mixOneQubitChannelOnQubitsLocal(Qureg qureg, int* targets, int numTargets, qreal offDiagFac, qreal diagMap[2][2]) {
+    
+    for (int t=0; t < numTargets; t += MAX_NUM_TILE_TARGETS) {
+        int numTileTargets = numTargets - t;
+        if (numTileTargets > MAX_NUM_TILE_TARGETS)
+            numTileTargets = MAX_NUM_TILE_TARGETS;
+        densmatr_mixOneQubitChannelOnTileLocal(qureg, &targets[t], numTileTargets, offDiagFac, diagMap);
+    }
+}
+
+void densmatr_mixDepolarisingOnQubitsLocal(Qureg qureg, int* targets, int numTargets, qreal depolLevel) {
+    qreal retain = 1-depolLevel;
+    qreal diagMap[2][2] = {{retain + depolLevel/2, depolLevel/2}, {depolLevel/2, retain + depolLevel/2}};
+    densmatr_mixOneQubitChannelOnQubitsLocal(qureg, targets, numTargets, retain, diagMap);
+}
+
+void densmatr_mixDampingOnQubitsLocal(Qureg qureg, int* targets, int numTargets, qreal damping) {
+    qreal retain = 1-damping;
+    qreal diagMap[2][2] = {{1, damping}, {0, retain}};
+    densmatr_mixOneQubitChannelOnQubitsLocal(qureg, targets, numTargets, sqrt(retain), diagMap);
+}
+
 void densmatr_mixDepolarisingDistributed(Qureg qureg, const int targetQubit, qreal depolLevel) {
 
     // first do dephase part.
@@ -299,12 +492,11 @@ void densmatr_mixDepolarisingDistributed(Qureg qureg, const int targetQubit, qre
 
 void densmatr_mixDampingDistributed(Qureg qureg, const int targetQubit, qreal damping) {
     qreal retain=1-damping;
-    qreal dephase=sqrt(1-damping);
     // first do dephase part.
     // TODO -- this might be more efficient to do at the same time as the depolarise if we move to
     // iterating over all elements in the state vector for the purpose of vectorisation
     // TODO -- if we keep this split, move this function to densmatr_mixDepolarising()
-    densmatr_mixDampingDephase(qureg, targetQubit, dephase);
+    densmatr_mixDampingDephase(qureg, targetQubit, damping);
 
     long long int sizeInnerBlock, sizeInnerHalfBlock;
     long long int sizeOuterColumn, sizeOuterHalfColumn;
@@ -327,7 +519,7 @@ void densmatr_mixDampingDistributed(Qureg qureg, const int targetQubit, qreal da
 
 # ifdef _OPENMP
 # pragma omp parallel \
-    shared   (sizeInnerBlock,sizeInnerHalfBlock,sizeOuterColumn,sizeOuterHalfColumn,qureg,damping, retain, dephase) \
+    shared   (sizeInnerBlock,sizeInnerHalfBlock,sizeOuterColumn,sizeOuterHalfColumn,qureg,damping, retain) \
     private  (thisTask,thisInnerBlock,thisOuterColumn,thisIndex,thisIndexInOuterColumn, \
                 thisIndexInInnerBlock,outerBit, stateBit)
 # endif
@@ -726,1372 +918,4073 @@ void densmatr_mixTwoQubitDepolarisingQ1LocalQ2DistributedPart3(Qureg qureg, cons
 }
 
 
-/* Without nested parallelisation, only the outer most loops which call below are parallelised */
-void zeroSomeAmps(Qureg qureg, long long int startInd, long long int numAmps) {
-    long long int i;
-# ifdef _OPENMP
-# pragma omp parallel for schedule (static)
-# endif
-    for (i=startInd; i < startInd+numAmps; i++) {
-        qureg.stateVec.real[i] = 0;
-        qureg.stateVec.imag[i] = 0;
-    }
-}
-void normaliseSomeAmps(Qureg qureg, qreal norm, long long int startInd, long long int numAmps) {
-    long long int i;
-# ifdef _OPENMP
-# pragma omp parallel for schedule (static)
-# endif
-    for (i=startInd; i < startInd+numAmps; i++) {
-        qureg.stateVec.real[i] /= norm;
-        qureg.stateVec.imag[i] /= norm;
-    }
-}
-void alternateNormZeroingSomeAmpBlocks(
-    Qureg qureg, qreal norm, int normFirst,
-    long long int startAmpInd, long long int numAmps, long long int blockSize
-) {
-    long long int numDubBlocks = numAmps / (2*blockSize);
-    long long int blockStartInd;
+/** Apply a multi-controlled one-qubit unitary u to a density matrix in a single pass,
+ * effecting rho -> U rho U^dagger. Each iteration updates the four elements which
+ * differ only in the row (targetQubit) and column (targetQubit+numQubitsRepresented)
+ * bits of the target, applying u upon the row bit when the row index satisfies the
+ * controls, and conj(u) upon the column bit when the column index does. This replaces
+ * separate passes of u and conj(u) over the whole matrix.
+ * Both the row and column target bits must lie within this chunk.
+ *
+ *  @param[in,out] qureg density matrix
+ *  @param[in] ctrlQubitsMask mask of the control qubits
+ *  @param[in] ctrlFlipMask mask of the control qubits which must be in state 0
+ *  @param[in] targetQubit qubit to operate upon
+ *  @param[in] u unitary matrix to apply
+ */
+void densmatr_multiControlledUnitaryLocal(
+    Qureg qureg, long long int ctrlQubitsMask, long long int ctrlFlipMask,
+    const int targetQubit, ComplexMatrix2 u)
+{
+    const int shift = qureg.numQubitsRepresented;
+    const int colQubit = targetQubit + shift;
+    const long long int numTasks = qureg.numAmpsPerChunk >> 2; // each iteration updates 4 elements
+    const long long int globalIndStart = qureg.chunkId*qureg.numAmpsPerChunk;
+
+    long long int thisTask, globalInd;
+    long long int ind00, ind01, ind10, ind11; // ind{col bit}{row bit}
+    int rowCtrl, colCtrl;
+    qreal re00, re01, re10, re11;
+    qreal im00, im01, im10, im11;
+    qreal reA, imA, reB, imB;
+
+    // Can't use qureg.stateVec as a private OMP var
+    qreal *reVec = qureg.stateVec.real;
+    qreal *imVec = qureg.stateVec.imag;
 
-    if (normFirst) {
-        long long int dubBlockInd;
 # ifdef _OPENMP
-# pragma omp parallel for schedule (static) private (blockStartInd)
+# pragma omp parallel \
+    shared   (reVec,imVec, u, ctrlQubitsMask,ctrlFlipMask) \
+    private  (thisTask, globalInd, ind00,ind01,ind10,ind11, rowCtrl,colCtrl, \
+              re00,re01,re10,re11, im00,im01,im10,im11, reA,imA,reB,imB)
 # endif
-        for (dubBlockInd=0; dubBlockInd < numDubBlocks; dubBlockInd++) {
-            blockStartInd = startAmpInd + dubBlockInd*2*blockSize;
-            normaliseSomeAmps(qureg, norm, blockStartInd,             blockSize); // |0><0|
-            zeroSomeAmps(     qureg,       blockStartInd + blockSize, blockSize);
-        }
-    } else {
-        long long int dubBlockInd;
+    {
 # ifdef _OPENMP
-# pragma omp parallel for schedule (static) private (blockStartInd)
+# pragma omp for schedule (static)
 # endif
-        for (dubBlockInd=0; dubBlockInd < numDubBlocks; dubBlockInd++) {
-            blockStartInd = startAmpInd + dubBlockInd*2*blockSize;
-            zeroSomeAmps(     qureg,       blockStartInd,             blockSize);
-            normaliseSomeAmps(qureg, norm, blockStartInd + blockSize, blockSize); // |1><1|
+        for (thisTask=0; thisTask<numTasks; thisTask++) {
+
+            ind00 = insertTwoZeroBits(thisTask, targetQubit, colQubit);
+            globalInd = ind00 + globalIndStart;
+
+            // the row index is the lower half of the global index, and the column index the upper
+            rowCtrl = (ctrlQubitsMask == (ctrlQubitsMask & (globalInd ^ ctrlFlipMask)));
+            colCtrl = (ctrlQubitsMask == (ctrlQubitsMask & ((globalInd >> shift) ^ ctrlFlipMask)));
+            if (!rowCtrl && !colCtrl)
+                continue;
+
+            ind01 = flipBit(ind00, targetQubit);
+            ind10 = flipBit(ind00, colQubit);
+            ind11 = flipBit(ind01, colQubit);
+
+            re00 = reVec[ind00]; im00 = imVec[ind00];
+            re01 = reVec[ind01]; im01 = imVec[ind01];
+            re10 = reVec[ind10]; im10 = imVec[ind10];
+            re11 = reVec[ind11]; im11 = imVec[ind11];
+
+            // apply u to the row bit: {amp00, amp01} and {amp10, amp11}
+            if (rowCtrl) {
+                reA = re00; imA = im00; reB = re01; imB = im01;
+                re00 = u.real[0][0]*reA - u.imag[0][0]*imA + u.real[0][1]*reB - u.imag[0][1]*imB;
+                im00 = u.real[0][0]*imA + u.imag[0][0]*reA + u.real[0][1]*imB + u.imag[0][1]*reB;
+                re01 = u.real[1][0]*reA - u.imag[1][0]*imA + u.real[1][1]*reB - u.imag[1][1]*imB;
+                im01 = u.real[1][0]*imA + u.imag[1][0]*reA + u.real[1][1]*imB + u.imag[1][1]*reB;
+
+                reA = re10; imA = im10; reB = re11; imB = im11;
+                re10 = u.real[0][0]*reA - u.imag[0][0]*imA + u.real[0][1]*reB - u.imag[0][1]*imB;
+                im10 = u.real[0][0]*imA + u.imag[0][0]*reA + u.real[0][1]*imB + u.imag[0][1]*reB;
+                re11 = u.real[1][0]*reA - u.imag[1][0]*imA + u.real[1][1]*reB - u.imag[1][1]*imB;
+                im11 = u.real[1][0]*imA + u.imag[1][0]*reA + u.real[1][1]*imB + u.imag[1][1]*reB;
+            }
+
+            // apply conj(u) to the column bit: {amp00, amp10} and {amp01, amp11}
+            if (colCtrl) {
+                reA = re00; imA = im00; reB = re10; imB = im10;
+                re00 = u.real[0][0]*reA + u.imag[0][0]*imA + u.real[0][1]*reB + u.imag[0][1]*imB;
+                im00 = u.real[0][0]*imA - u.imag[0][0]*reA + u.real[0][1]*imB - u.imag[0][1]*reB;
+                re10 = u.real[1][0]*reA + u.imag[1][0]*imA + u.real[1][1]*reB + u.imag[1][1]*imB;
+                im10 = u.real[1][0]*imA - u.imag[1][0]*reA + u.real[1][1]*imB - u.imag[1][1]*reB;
+
+                reA = re01; imA = im01; reB = re11; imB = im11;
+                re01 = u.real[0][0]*reA + u.imag[0][0]*imA + u.real[0][1]*reB + u.imag[0][1]*imB;
+                im01 = u.real[0][0]*imA - u.imag[0][0]*reA + u.real[0][1]*imB - u.imag[0][1]*reB;
+                re11 = u.real[1][0]*reA + u.imag[1][0]*imA + u.real[1][1]*reB + u.imag[1][1]*imB;
+                im11 = u.real[1][0]*imA - u.imag[1][0]*reA + u.real[1][1]*imB - u.imag[1][1]*reB;
+            }
+
+            reVec[ind00] = re00; imVec[ind00] = im00;
+            reVec[ind01] = re01; imVec[ind01] = im01;
+            reVec[ind10] = re10; imVec[ind10] = im10;
+            reVec[ind11] = re11; imVec[ind11] = im11;
         }
     }
 }
 
-/** Renorms (/prob) every | * outcome * >< * outcome * | state, setting all others to zero */
-void densmatr_collapseToKnownProbOutcome(Qureg qureg, const int measureQubit, int outcome, qreal totalStateProb) {
+/** Apply a multi-controlled two-qubit unitary u to a density matrix in a single pass,
+ * effecting rho -> U rho U^dagger. Each iteration updates the 16 elements which differ 
+ * only in the row and column bits of q1 and q2, applying u upon the row bits and 
+ * conj(u) upon the column bits, subject to the controls as in 
+ * densmatr_multiControlledUnitaryLocal. As for statevec_multiControlledTwoQubitUnitaryLocal,
+ * q1 is the least significant qubit of u. All four target bits must lie within this chunk.
+ */
+void densmatr_multiControlledTwoQubitUnitaryLocal(Qureg qureg, long long int ctrlMask, const int q1, const int q2, ComplexMatrix4 u) {
 
-	// only (global) indices (as bit sequence): '* outcome *(n+q) outcome *q are spared
-    // where n = measureQubit, q = qureg.numQubitsRepresented.
-    // We can thus step in blocks of 2^q+n, killing every second, and inside the others,
-    //  stepping in sub-blocks of 2^q, killing every second.
-    // When outcome=1, we offset the start of these blocks by their size.
-    long long int innerBlockSize = (1LL << measureQubit);
-    long long int outerBlockSize = (1LL << (measureQubit + qureg.numQubitsRepresented));
+    const int shift = qureg.numQubitsRepresented;
+    const long long int numTasks = qureg.numAmpsPerChunk >> 4; // each iteration updates 16 elements
+    const long long int globalIndStart = qureg.chunkId*qureg.numAmpsPerChunk;
 
-    // Because there are 2^a number of nodes(/chunks), each node will contain 2^b number of blocks,
-    // or each block will span 2^c number of nodes. Similarly for the innerblocks.
-    long long int locNumAmps = qureg.numAmpsPerChunk;
-    long long int globalStartInd = qureg.chunkId * locNumAmps;
-    int innerBit = extractBit(measureQubit, globalStartInd);
-    int outerBit = extractBit(measureQubit + qureg.numQubitsRepresented, globalStartInd);
+    // the row and column target bits, in increasing order (since q1,q2 < shift)
+    const int qLo = (q1 < q2)? q1 : q2;
+    const int qHi = (q1 < q2)? q2 : q1;
 
-    // If this chunk's amps are entirely inside an outer block
-    if (locNumAmps <= outerBlockSize) {
+    long long int thisTask;
 
-        // if this is an undesired outer block, kill all elems
-        if (outerBit != outcome)
-            return zeroSomeAmps(qureg, 0, qureg.numAmpsPerChunk);
+    // Can't use qureg.stateVec as a private OMP var
+    qreal *reVec = qureg.stateVec.real;
+    qreal *imVec = qureg.stateVec.imag;
 
-        // othwerwise, if this is a desired outer block, and also entirely an inner block
-        if (locNumAmps <= innerBlockSize) {
+# ifdef _OPENMP
+# pragma omp parallel \
+    shared   (reVec,imVec, u, ctrlMask) \
+    private  (thisTask)
+# endif
+    {
+        long long int ind0000, globalInd;
+        long long int inds[16]; // inds[r + 4*c] with r, c the row and column bits of {q1, q2}
+        qreal re[16], im[16], reIn[4], imIn[4];
+        int rowCtrl, colCtrl, i, j, k;
 
-            // and that inner block is undesired, kill all elems
-            if (innerBit != outcome)
-                return zeroSomeAmps(qureg, 0, qureg.numAmpsPerChunk);
-            // otherwise normalise all elems
-            else
-                return normaliseSomeAmps(qureg, totalStateProb, 0, qureg.numAmpsPerChunk);
-        }
+# ifdef _OPENMP
+# pragma omp for schedule (static)
+# endif
+        for (thisTask=0; thisTask<numTasks; thisTask++) {
 
-        // otherwise this is a desired outer block which contains 2^a inner blocks; kill/renorm every second inner block
-        return alternateNormZeroingSomeAmpBlocks(
-            qureg, totalStateProb, innerBit==outcome, 0, qureg.numAmpsPerChunk, innerBlockSize);
-    }
+            ind0000 = insertZeroBit(insertZeroBit(insertTwoZeroBits(thisTask, qLo, qHi), qLo+shift), qHi+shift);
+            globalInd = ind0000 + globalIndStart;
 
-    // Otherwise, this chunk's amps contain multiple outer blocks (and hence multiple inner blocks)
-    long long int numOuterDoubleBlocks = locNumAmps / (2*outerBlockSize);
-    long long int firstBlockInd;
+            rowCtrl = ((ctrlMask & globalInd) == ctrlMask);
+            colCtrl = ((ctrlMask & (globalInd >> shift)) == ctrlMask);
+            if (!rowCtrl && !colCtrl)
+                continue;
 
-    // alternate norming* and zeroing the outer blocks (with order based on the desired outcome)
-    // These loops aren't parallelised, since they could have 1 or 2 iterations and will prevent
-    // inner parallelisation
-    if (outerBit == outcome) {
+            for (k=0; k<16; k++) {
+                inds[k] = ind0000
+                    | ((long long int) extractBit(0, k) << q1)
+                    | ((long long int) extractBit(1, k) << q2)
+                    | ((long long int) extractBit(2, k) << (q1+shift))
+                    | ((long long int) extractBit(3, k) << (q2+shift));
+                re[k] = reVec[inds[k]];
+                im[k] = imVec[inds[k]];
+            }
 
-        for (long long int outerDubBlockInd = 0; outerDubBlockInd < numOuterDoubleBlocks; outerDubBlockInd++) {
-            firstBlockInd = outerDubBlockInd*2*outerBlockSize;
+            // apply u to the row bits of each column
+            if (rowCtrl) {
+                for (k=0; k<16; k+=4) {
+                    for (i=0; i<4; i++) {
+                        reIn[i] = re[k+i];
+                        imIn[i] = im[k+i];
+                    }
+                    for (i=0; i<4; i++) {
+                        re[k+i] = 0;
+                        im[k+i] = 0;
+                        for (j=0; j<4; j++) {
+                            re[k+i] += u.real[i][j]*reIn[j] - u.imag[i][j]*imIn[j];
+                            im[k+i] += u.real[i][j]*imIn[j] + u.imag[i][j]*reIn[j];
+                        }
+                    }
+                }
+            }
 
-            // *norm only the desired inner blocks in the desired outer block
-            alternateNormZeroingSomeAmpBlocks(
-                qureg, totalStateProb, innerBit==outcome,
-                firstBlockInd, outerBlockSize, innerBlockSize);
+            // apply conj(u) to the column bits of each row
+            if (colCtrl) {
+                for (k=0; k<4; k++) {
+                    for (i=0; i<4; i++) {
+                        reIn[i] = re[k+4*i];
+                        imIn[i] = im[k+4*i];
+                    }
+                    for (i=0; i<4; i++) {
+                        re[k+4*i] = 0;
+                        im[k+4*i] = 0;
+                        for (j=0; j<4; j++) {
+                            re[k+4*i] += u.real[i][j]*reIn[j] + u.imag[i][j]*imIn[j];
+                            im[k+4*i] += u.real[i][j]*imIn[j] - u.imag[i][j]*reIn[j];
+                        }
+                    }
+                }
+            }
 
-            // zero the undesired outer block
-            zeroSomeAmps(qureg, firstBlockInd + outerBlockSize, outerBlockSize);
+            for (k=0; k<16; k++) {
+                reVec[inds[k]] = re[k];
+                imVec[inds[k]] = im[k];
+            }
         }
+    }
+}
 
-    } else {
+/*
+ * packed density matrix operations
+ *
+ * A packed density matrix stores only the upper triangle (row <= col) of the Hermitian
+ * matrix, column after column, so that element (row, col) lives at index col*(col+1)/2 + row.
+ * The lower triangle is recovered by conjugation. Packed registers are never distributed.
+ */
 
-        for (long long int outerDubBlockInd = 0; outerDubBlockInd < numOuterDoubleBlocks; outerDubBlockInd++) {
-            firstBlockInd = outerDubBlockInd*2*outerBlockSize;
+static inline long long int getPackedIndex(long long int row, long long int col) {
+    return ((col*(col+1)) >> 1) + row;
+}
 
-            // same thing but undesired outer blocks come first
-            zeroSomeAmps(qureg, firstBlockInd, outerBlockSize);
-            alternateNormZeroingSomeAmpBlocks(
-                qureg, totalStateProb, innerBit==outcome,
-                firstBlockInd + outerBlockSize, outerBlockSize, innerBlockSize);
-        }
+static inline void getPackedElem(qreal* reVec, qreal* imVec, long long int row, long long int col, qreal* re, qreal* im) {
+    if (row <= col) {
+        long long int ind = getPackedIndex(row, col);
+        *re = reVec[ind];
+        *im = imVec[ind];
+    } else {
+        long long int ind = getPackedIndex(col, row);
+        *re =   reVec[ind];
+        *im = - imVec[ind];
     }
+}
 
+static inline void setPackedElem(qreal* reVec, qreal* imVec, long long int row, long long int col, qreal re, qreal im) {
+    if (row <= col) {
+        long long int ind = getPackedIndex(row, col);
+        reVec[ind] =   re;
+        imVec[ind] =   im;
+    } else {
+        long long int ind = getPackedIndex(col, row);
+        reVec[ind] =   re;
+        imVec[ind] = - im;
+    }
 }
 
-qreal densmatr_calcPurityLocal(Qureg qureg) {
+/** Apply a multi-controlled unitary u to a packed density matrix, effecting rho -> U rho U^dagger.
+ * Each iteration updates the 2x2 block of elements whose rows and columns differ only in 
+ * targetQubit. Blocks are visited only when their (target-bit-cleared) row does not exceed their 
+ * column, since the remaining blocks are the conjugate transposes of those visited. The diagonal 
+ * blocks straddle the triangle, and both of their off-diagonal elements map to the same storage.
+ */
+void packmatr_multiControlledUnitaryLocal(
+    Qureg qureg, long long int ctrlQubitsMask, long long int ctrlFlipMask,
+    const int targetQubit, ComplexMatrix2 u)
+{
+    const long long int numHalfCols = 1LL << (qureg.numQubitsRepresented - 1);
+    const long long int targetMask = 1LL << targetQubit;
 
-    /* sum of qureg^2, which is sum_i |qureg[i]|^2 */
-    long long int index;
-    long long int numAmps = qureg.numAmpsPerChunk;
+    long long int halfCol;
 
-    qreal trace = 0;
-    qreal *vecRe = qureg.stateVec.real;
-    qreal *vecIm = qureg.stateVec.imag;
+    // Can't use qureg.stateVec as a private OMP var
+    qreal *reVec = qureg.stateVec.real;
+    qreal *imVec = qureg.stateVec.imag;
 
 # ifdef _OPENMP
 # pragma omp parallel \
-    shared    (vecRe, vecIm, numAmps) \
-    private   (index) \
-    reduction ( +:trace )
+    shared   (reVec,imVec, u, ctrlQubitsMask,ctrlFlipMask) \
+    private  (halfCol)
 # endif
     {
-# ifdef _OPENMP
-# pragma omp for schedule  (static)
-# endif
-        for (index=0LL; index<numAmps; index++) {
+        long long int halfRow, rows[2], cols[2];
+        qreal re[4], im[4], reIn[2], imIn[2]; // re[r + 2*c] with r, c the row and column target bits
+        int rowCtrl, colCtrl, i, j, k;
+
+        // columns grow longer, so deal them out round-robin to balance the triangle
+# ifdef _OPENMP
+# pragma omp for schedule (static, 1)
+# endif
+        for (halfCol=0; halfCol<numHalfCols; halfCol++) {
+
+            cols[0] = insertZeroBit(halfCol, targetQubit);
+            cols[1] = cols[0] | targetMask;
+            colCtrl = (ctrlQubitsMask == (ctrlQubitsMask & (cols[0] ^ ctrlFlipMask)));
+
+            for (halfRow=0; halfRow<=halfCol; halfRow++) {
+
+                rows[0] = insertZeroBit(halfRow, targetQubit);
+                rows[1] = rows[0] | targetMask;
+                rowCtrl = (ctrlQubitsMask == (ctrlQubitsMask & (rows[0] ^ ctrlFlipMask)));
+                if (!rowCtrl && !colCtrl)
+                    continue;
+
+                for (k=0; k<4; k++)
+                    getPackedElem(reVec, imVec, rows[k&1], cols[k>>1], &re[k], &im[k]);
+
+                // apply u to the row bit of each column
+                if (rowCtrl) {
+                    for (k=0; k<4; k+=2) {
+                        reIn[0] = re[k]; reIn[1] = re[k+1];
+                        imIn[0] = im[k]; imIn[1] = im[k+1];
+                        for (i=0; i<2; i++) {
+                            re[k+i] = 0;
+                            im[k+i] = 0;
+                            for (j=0; j<2; j++) {
+                                re[k+i] += u.real[i][j]*reIn[j] - u.imag[i][j]*imIn[j];
+                                im[k+i] += u.real[i][j]*imIn[j] + u.imag[i][j]*reIn[j];
+                            }
+                        }
+                    }
+                }
 
-            trace += vecRe[index]*vecRe[index] + vecIm[index]*vecIm[index];
-        }
-    }
+                // apply conj(u) to the column bit of each row
+                if (colCtrl) {
+                    for (k=0; k<2; k++) {
+                        reIn[0] = re[k]; reIn[1] = re[k+2];
+                        imIn[0] = im[k]; imIn[1] = im[k+2];
+                        for (i=0; i<2; i++) {
+                            re[k+2*i] = 0;
+                            im[k+2*i] = 0;
+                            for (j=0; j<2; j++) {
+                                re[k+2*i] += u.real[i][j]*reIn[j] + u.imag[i][j]*imIn[j];
+                                im[k+2*i] += u.real[i][j]*imIn[j] - u.imag[i][j]*reIn[j];
+                            }
+                        }
+                    }
+                }
 
-    return trace;
+                for (k=0; k<4; k++)
+                    setPackedElem(reVec, imVec, rows[k&1], cols[k>>1], re[k], im[k]);
+            }
+        }
+    }
 }
 
-void densmatr_mixDensityMatrix(Qureg combineQureg, qreal otherProb, Qureg otherQureg) {
+/** Apply a multi-controlled two-qubit unitary u to a packed density matrix, visiting the 
+ * 4x4 blocks of elements whose rows and columns differ only in q1 and q2, in the manner of 
+ * packmatr_multiControlledUnitaryLocal. q1 is the least significant qubit of u.
+ */
+void packmatr_multiControlledTwoQubitUnitaryLocal(Qureg qureg, long long int ctrlMask, const int q1, const int q2, ComplexMatrix4 u) {
 
-    /* corresponding amplitudes live on the same node (same dimensions) */
+    const long long int numQuarterCols = 1LL << (qureg.numQubitsRepresented - 2);
+    const long long int mask1 = 1LL << q1;
+    const long long int mask2 = 1LL << q2;
 
-    // unpack vars for OpenMP
-    qreal* combineVecRe = combineQureg.stateVec.real;
-    qreal* combineVecIm = combineQureg.stateVec.imag;
-    qreal* otherVecRe = otherQureg.stateVec.real;
-    qreal* otherVecIm = otherQureg.stateVec.imag;
-    long long int numAmps = combineQureg.numAmpsPerChunk;
-    long long int index;
+    long long int quarterCol;
+
+    // Can't use qureg.stateVec as a private OMP var
+    qreal *reVec = qureg.stateVec.real;
+    qreal *imVec = qureg.stateVec.imag;
 
 # ifdef _OPENMP
 # pragma omp parallel \
-    default (none) \
-    shared  (combineVecRe,combineVecIm,otherVecRe,otherVecIm, otherProb, numAmps) \
-    private (index)
+    shared   (reVec,imVec, u, ctrlMask) \
+    private  (quarterCol)
 # endif
     {
-# ifdef _OPENMP
-# pragma omp for schedule  (static)
-# endif
-        for (index=0; index < numAmps; index++) {
-            combineVecRe[index] *= 1-otherProb;
-            combineVecIm[index] *= 1-otherProb;
+        long long int quarterRow, row0, col0, rows[4], cols[4];
+        qreal re[16], im[16], reIn[4], imIn[4]; // re[r + 4*c] with r, c the row and column bits of {q1, q2}
+        int rowCtrl, colCtrl, i, j, k;
+
+# ifdef _OPENMP
+# pragma omp for schedule (static, 1)
+# endif
+        for (quarterCol=0; quarterCol<numQuarterCols; quarterCol++) {
+
+            col0 = insertTwoZeroBits(quarterCol, q1, q2);
+            colCtrl = ((ctrlMask & col0) == ctrlMask);
+            for (k=0; k<4; k++)
+                cols[k] = col0 | ((k&1)? mask1 : 0) | ((k&2)? mask2 : 0);
+
+            for (quarterRow=0; quarterRow<=quarterCol; quarterRow++) {
+
+                row0 = insertTwoZeroBits(quarterRow, q1, q2);
+                rowCtrl = ((ctrlMask & row0) == ctrlMask);
+                if (!rowCtrl && !colCtrl)
+                    continue;
+
+                for (k=0; k<4; k++)
+                    rows[k] = row0 | ((k&1)? mask1 : 0) | ((k&2)? mask2 : 0);
+                for (k=0; k<16; k++)
+                    getPackedElem(reVec, imVec, rows[k&3], cols[k>>2], &re[k], &im[k]);
+
+                // apply u to the row bits of each column
+                if (rowCtrl) {
+                    for (k=0; k<16; k+=4) {
+                        for (i=0; i<4; i++) {
+                            reIn[i] = re[k+i];
+                            imIn[i] = im[k+i];
+                        }
+                        for (i=0; i<4; i++) {
+                            re[k+i] = 0;
+                            im[k+i] = 0;
+                            for (j=0; j<4; j++) {
+                                re[k+i] += u.real[i][j]*reIn[j] - u.imag[i][j]*imIn[j];
+                                im[k+i] += u.real[i][j]*imIn[j] + u.imag[i][j]*reIn[j];
+                            }
+                        }
+                    }
+                }
 
-            combineVecRe[index] += otherProb * otherVecRe[index];
-            combineVecIm[index] += otherProb * otherVecIm[index];
+                // apply conj(u) to the column bits of each row
+                if (colCtrl) {
+                    for (k=0; k<4; k++) {
+                        for (i=0; i<4; i++) {
+                            reIn[i] = re[k+4*i];
+                            imIn[i] = im[k+4*i];
+                        }
+                        for (i=0; i<4; i++) {
+                            re[k+4*i] = 0;
+                            im[k+4*i] = 0;
+                            for (j=0; j<4; j++) {
+                                re[k+4*i] += u.real[i][j]*reIn[j] + u.imag[i][j]*imIn[j];
+                                im[k+4*i] += u.real[i][j]*imIn[j] - u.imag[i][j]*reIn[j];
+                            }
+                        }
+                    }
+                }
+
+                for (k=0; k<16; k++)
+                    setPackedElem(reVec, imVec, rows[k&3], cols[k>>2], re[k], im[k]);
+            }
         }
     }
 }
 
-/** computes Tr((a-b) conjTrans(a-b)) = sum of abs values of (a-b) */
-qreal densmatr_calcHilbertSchmidtDistanceSquaredLocal(Qureg a, Qureg b) {
+/** Apply the diagonal gate diag(1, term) upon targetQubit, controlled on every qubit in ctrlMask, 
+ * where term has unit magnitude. Element (row, col) is multiplied by f(row) conj(f(col)), where 
+ * f(i) is term if i has targetQubit and every control set, and 1 otherwise. Elements are scaled 
+ * in place, never mixed, so only those where exactly one of f(row) and f(col) is term are touched.
+ */
+void packmatr_phaseShiftByTermLocal(Qureg qureg, long long int ctrlMask, const int targetQubit, Complex term) {
 
-    long long int index;
-    long long int numAmps = a.numAmpsPerChunk;
+    const long long int dim = 1LL << qureg.numQubitsRepresented;
+    const long long int phaseMask = ctrlMask | (1LL << targetQubit);
+    const qreal termRe = term.real;
+    const qreal termIm = term.imag;
 
-    qreal *aRe = a.stateVec.real;
-    qreal *aIm = a.stateVec.imag;
-    qreal *bRe = b.stateVec.real;
-    qreal *bIm = b.stateVec.imag;
+    long long int col, row, ind;
+    int colIsPhased;
+    qreal facIm, re, im;
 
-    qreal trace = 0;
-    qreal difRe, difIm;
+    // Can't use qureg.stateVec as a private OMP var
+    qreal *reVec = qureg.stateVec.real;
+    qreal *imVec = qureg.stateVec.imag;
 
 # ifdef _OPENMP
 # pragma omp parallel \
-    shared    (aRe,aIm, bRe,bIm, numAmps) \
-    private   (index,difRe,difIm) \
-    reduction ( +:trace )
+    shared   (reVec,imVec) \
+    private  (col,row,ind, colIsPhased,facIm,re,im)
 # endif
     {
 # ifdef _OPENMP
-# pragma omp for schedule  (static)
+# pragma omp for schedule (static, 1)
 # endif
-        for (index=0LL; index<numAmps; index++) {
+        for (col=0; col<dim; col++) {
+            colIsPhased = ((col & phaseMask) == phaseMask);
 
-            difRe = aRe[index] - bRe[index];
-            difIm = aIm[index] - bIm[index];
-            trace += difRe*difRe + difIm*difIm;
+            // the factor is term for a phased row, or conj(term) for a phased column
+            facIm = (colIsPhased)? -termIm : termIm;
+            for (row=0; row<=col; row++) {
+                if (((row & phaseMask) == phaseMask) == colIsPhased)
+                    continue;
+
+                ind = getPackedIndex(row, col);
+                re = reVec[ind];
+                im = imVec[ind];
+                reVec[ind] = termRe*re - facIm*im;
+                imVec[ind] = termRe*im + facIm*re;
+            }
         }
     }
-
-    return trace;
 }
 
-/** computes Tr(conjTrans(a) b) = sum of (a_ij^* b_ij) */
-qreal densmatr_calcInnerProductLocal(Qureg a, Qureg b) {
+/** Apply a single-qubit channel which scales the elements off-diagonal in targetQubit by 
+ * offDiagFac, and maps each pair of elements {|..0..><..0..|, |..1..><..1..|} through the 
+ * real 2x2 matrix diagMap. This captures dephasing, depolarising and amplitude damping.
+ */
+static void packmatr_mixOneQubitChannelLocal(Qureg qureg, const int targetQubit, qreal offDiagFac, qreal diagMap[2][2]) {
 
-    long long int index;
-    long long int numAmps = a.numAmpsPerChunk;
+    const long long int dim = 1LL << qureg.numQubitsRepresented;
+    const long long int targetMask = 1LL << targetQubit;
+    const qreal m00 = diagMap[0][0], m01 = diagMap[0][1], m10 = diagMap[1][0], m11 = diagMap[1][1];
 
-    qreal *aRe = a.stateVec.real;
-    qreal *aIm = a.stateVec.imag;
-    qreal *bRe = b.stateVec.real;
-    qreal *bIm = b.stateVec.imag;
+    long long int col, row, ind, partner;
+    qreal re0, im0, re1, im1;
 
-    qreal trace = 0;
+    // Can't use qureg.stateVec as a private OMP var
+    qreal *reVec = qureg.stateVec.real;
+    qreal *imVec = qureg.stateVec.imag;
 
 # ifdef _OPENMP
 # pragma omp parallel \
-    shared    (aRe,aIm, bRe,bIm, numAmps) \
-    private   (index) \
-    reduction ( +:trace )
+    shared   (reVec,imVec) \
+    private  (col,row,ind,partner, re0,im0,re1,im1)
 # endif
     {
 # ifdef _OPENMP
-# pragma omp for schedule  (static)
+# pragma omp for schedule (static, 1)
 # endif
-        for (index=0LL; index<numAmps; index++) {
-            trace += aRe[index]*bRe[index] + aIm[index]*bIm[index];
+        for (col=0; col<dim; col++) {
+            for (row=0; row<=col; row++) {
+                ind = getPackedIndex(row, col);
+
+                if ((row ^ col) & targetMask) {
+                    reVec[ind] *= offDiagFac;
+                    imVec[ind] *= offDiagFac;
+                }
+                // partner |..1..><..1..| of every |..0..><..0..| also lies in the upper triangle
+                else if (!(row & targetMask)) {
+                    partner = getPackedIndex(row | targetMask, col | targetMask);
+                    re0 = reVec[ind];     im0 = imVec[ind];
+                    re1 = reVec[partner]; im1 = imVec[partner];
+
+                    reVec[ind]     = m00*re0 + m01*re1;
+                    imVec[ind]     = m00*im0 + m01*im1;
+                    reVec[partner] = m10*re0 + m11*re1;
+                    imVec[partner] = m10*im0 + m11*im1;
+                }
+            }
         }
     }
-
-    return trace;
 }
 
+void packmatr_mixDephasingLocal(Qureg qureg, const int targetQubit, qreal dephase) {
+    qreal diagMap[2][2] = {{1, 0}, {0, 1}};
+    packmatr_mixOneQubitChannelLocal(qureg, targetQubit, 1-dephase, diagMap);
+}
 
-/** computes a few dens-columns-worth of (vec^*T) dens * vec */
-qreal densmatr_calcFidelityLocal(Qureg qureg, Qureg pureState) {
+void packmatr_mixDepolarisingLocal(Qureg qureg, const int targetQubit, qreal depolLevel) {
+    qreal retain = 1-depolLevel;
+    qreal diagMap[2][2] = {{retain + depolLevel/2, depolLevel/2}, {depolLevel/2, retain + depolLevel/2}};
+    packmatr_mixOneQubitChannelLocal(qureg, targetQubit, retain, diagMap);
+}
 
-    /* Here, elements of pureState are not accessed (instead grabbed from qureg.pair).
-     * We only consult the attributes.
-     *
-     * qureg is a density matrix, and pureState is a statevector.
-     * Every node contains as many columns of qureg as amps by pureState.
-     * (each node contains an integer, exponent-of-2 number of whole columns of qureg)
-     * Ergo, this node contains columns:
-     * qureg.chunkID * pureState.numAmpsPerChunk  to
-     * (qureg.chunkID + 1) * pureState.numAmpsPerChunk
-     *
-     * The first pureState.numAmpsTotal elements of qureg.pairStateVec are the
-     * entire pureState state-vector
-     */
+void packmatr_mixDampingLocal(Qureg qureg, const int targetQubit, qreal damping) {
+    qreal retain = 1-damping;
+    qreal diagMap[2][2] = {{1, damping}, {0, retain}};
+    packmatr_mixOneQubitChannelLocal(qureg, targetQubit, sqrt(retain), diagMap);
+}
 
-    // unpack everything for OPENMP
-    qreal* vecRe  = qureg.pairStateVec.real;
-    qreal* vecIm  = qureg.pairStateVec.imag;
-    qreal* densRe = qureg.stateVec.real;
-    qreal* densIm = qureg.stateVec.imag;
+void packmatr_mixDephasingAllLocal(Qureg qureg, qreal dephase) {
 
-    int row, col;
-    int dim = (int) pureState.numAmpsTotal;
-    int colsPerNode = (int) pureState.numAmpsPerChunk;
-    // using only int, because density matrix has squared as many amps so its
-    // iteration would be impossible if the pureStates numAmpsTotal didn't fit into int
+    const int numQubits = qureg.numQubitsRepresented;
+    const long long int dim = 1LL << numQubits;
 
-    // starting GLOBAL column index of the qureg columns on this node
-    int startCol = (int) (qureg.chunkId * pureState.numAmpsPerChunk);
+    // every qubit in which the row and column differ degrades the element once
+    qreal retainPowers[numQubits+1];
+    retainPowers[0] = 1;
+    for (int q=1; q<=numQubits; q++)
+        retainPowers[q] = retainPowers[q-1]*(1-dephase);
 
-    qreal densElemRe, densElemIm;
-    qreal prefacRe, prefacIm;
-    qreal rowSumRe, rowSumIm;
-    qreal vecElemRe, vecElemIm;
+    long long int col, row, ind;
+    qreal retain;
 
-    // quantity computed by this node
-    qreal globalSumRe = 0;   // imag-component is assumed zero
+    // Can't use qureg.stateVec as a private OMP var
+    qreal *reVec = qureg.stateVec.real;
+    qreal *imVec = qureg.stateVec.imag;
 
 # ifdef _OPENMP
 # pragma omp parallel \
-    shared    (vecRe,vecIm,densRe,densIm, dim,colsPerNode,startCol) \
-    private   (row,col, prefacRe,prefacIm, rowSumRe,rowSumIm, densElemRe,densElemIm, vecElemRe,vecElemIm) \
-    reduction ( +:globalSumRe )
+    shared   (reVec,imVec,retainPowers) \
+    private  (col,row,ind,retain)
 # endif
     {
 # ifdef _OPENMP
-# pragma omp for schedule  (static)
+# pragma omp for schedule (static, 1)
 # endif
-        // indices of my GLOBAL row
-        for (row=0; row < dim; row++) {
-
-            // single element of conj(pureState)
-            prefacRe =   vecRe[row];
-            prefacIm = - vecIm[row];
-
-            rowSumRe = 0;
-            rowSumIm = 0;
-
-            // indices of my LOCAL column
-            for (col=0; col < colsPerNode; col++) {
-
-                // my local density element
-                densElemRe = densRe[row + dim*col];
-                densElemIm = densIm[row + dim*col];
-
-                // state-vector element
-                vecElemRe = vecRe[startCol + col];
-                vecElemIm = vecIm[startCol + col];
-
-                rowSumRe += densElemRe*vecElemRe - densElemIm*vecElemIm;
-                rowSumIm += densElemRe*vecElemIm + densElemIm*vecElemRe;
+        for (col=0; col<dim; col++) {
+            for (row=0; row<=col; row++) {
+                ind = getPackedIndex(row, col);
+                retain = retainPowers[countOneBits(row ^ col)];
+                reVec[ind] *= retain;
+                imVec[ind] *= retain;
             }
-
-            globalSumRe += rowSumRe*prefacRe - rowSumIm*prefacIm;
         }
     }
-
-    return globalSumRe;
 }
 
-Complex statevec_calcInnerProductLocal(Qureg bra, Qureg ket) {
-
-    qreal innerProdReal = 0;
-    qreal innerProdImag = 0;
+void packmatr_initClassicalStateLocal(Qureg qureg, long long int stateInd) {
 
+    const long long int numElems = qureg.numAmpsPerChunk;
     long long int index;
-    long long int numAmps = bra.numAmpsPerChunk;
-    qreal *braVecReal = bra.stateVec.real;
-    qreal *braVecImag = bra.stateVec.imag;
-    qreal *ketVecReal = ket.stateVec.real;
-    qreal *ketVecImag = ket.stateVec.imag;
 
-    qreal braRe, braIm, ketRe, ketIm;
+    // Can't use qureg.stateVec as a private OMP var
+    qreal *reVec = qureg.stateVec.real;
+    qreal *imVec = qureg.stateVec.imag;
 
 # ifdef _OPENMP
 # pragma omp parallel \
-    shared    (braVecReal, braVecImag, ketVecReal, ketVecImag, numAmps) \
-    private   (index, braRe, braIm, ketRe, ketIm) \
-    reduction ( +:innerProdReal, innerProdImag )
+    shared   (reVec,imVec) \
+    private  (index)
 # endif
     {
 # ifdef _OPENMP
-# pragma omp for schedule  (static)
+# pragma omp for schedule (static)
 # endif
-        for (index=0; index < numAmps; index++) {
-            braRe = braVecReal[index];
-            braIm = braVecImag[index];
-            ketRe = ketVecReal[index];
-            ketIm = ketVecImag[index];
-
-            // conj(bra_i) * ket_i
-            innerProdReal += braRe*ketRe + braIm*ketIm;
-            innerProdImag += braRe*ketIm - braIm*ketRe;
+        for (index=0; index<numElems; index++) {
+            reVec[index] = 0;
+            imVec[index] = 0;
         }
     }
 
-    Complex innerProd;
-    innerProd.real = innerProdReal;
-    innerProd.imag = innerProdImag;
-    return innerProd;
+    reVec[getPackedIndex(stateInd, stateInd)] = 1;
 }
 
+void packmatr_initPureStateLocal(Qureg qureg, Qureg pureState) {
 
+    const long long int dim = 1LL << qureg.numQubitsRepresented;
+    long long int col, row, ind;
+    qreal reCol, imCol, reRow, imRow;
 
-void densmatr_initClassicalState (Qureg qureg, long long int stateInd)
-{
-    // dimension of the state vector
-    long long int densityNumElems = qureg.numAmpsPerChunk;
-
-    // Can't use qureg->stateVec as a private OMP var
-    qreal *densityReal = qureg.stateVec.real;
-    qreal *densityImag = qureg.stateVec.imag;
+    // Can't use qureg.stateVec as a private OMP var
+    qreal *reVec = qureg.stateVec.real;
+    qreal *imVec = qureg.stateVec.imag;
+    qreal *rePure = pureState.stateVec.real;
+    qreal *imPure = pureState.stateVec.imag;
 
-    // initialise the state to all zeros
-    long long int index;
 # ifdef _OPENMP
 # pragma omp parallel \
-    shared   (densityNumElems, densityReal, densityImag) \
-    private  (index)
+    shared   (reVec,imVec, rePure,imPure) \
+    private  (col,row,ind, reCol,imCol,reRow,imRow)
 # endif
     {
 # ifdef _OPENMP
-# pragma omp for schedule (static)
+# pragma omp for schedule (static, 1)
 # endif
-        for (index=0; index<densityNumElems; index++) {
-            densityReal[index] = 0.0;
-            densityImag[index] = 0.0;
+        for (col=0; col<dim; col++) {
+            reCol = rePure[col];
+            imCol = imPure[col];
+            ind = getPackedIndex(0, col);
+
+            // rho_{row,col} = psi_row conj(psi_col)
+            for (row=0; row<=col; row++) {
+                reRow = rePure[row];
+                imRow = imPure[row];
+                reVec[ind + row] = reRow*reCol + imRow*imCol;
+                imVec[ind + row] = imRow*reCol - reRow*imCol;
+            }
         }
     }
+}
 
-    // index of the single density matrix elem to set non-zero
-    long long int densityDim = 1LL << qureg.numQubitsRepresented;
-    long long int densityInd = (densityDim + 1)*stateInd;
+qreal packmatr_calcTotalProbLocal(Qureg qureg) {
 
-    // give the specified classical state prob 1
-    if (qureg.chunkId == densityInd / densityNumElems){
-        densityReal[densityInd % densityNumElems] = 1.0;
-        densityImag[densityInd % densityNumElems] = 0.0;
+    const long long int dim = 1LL << qureg.numQubitsRepresented;
+    long long int diag;
+    qreal trace = 0;
+
+    qreal *reVec = qureg.stateVec.real;
+
+# ifdef _OPENMP
+# pragma omp parallel \
+    shared   (reVec) \
+    private  (diag) \
+    reduction ( +:trace )
+# endif
+    {
+# ifdef _OPENMP
+# pragma omp for schedule (static)
+# endif
+        for (diag=0; diag<dim; diag++)
+            trace += reVec[getPackedIndex(diag, diag)];
     }
+    return trace;
 }
 
+qreal packmatr_calcProbOfOutcomeLocal(Qureg qureg, const int measureQubit, int outcome) {
 
-void densmatr_initPlusState (Qureg qureg)
-{
-    // |+><+| = sum_i 1/sqrt(2^N) |i> 1/sqrt(2^N) <j| = sum_ij 1/2^N |i><j|
-    long long int dim = (1LL << qureg.numQubitsRepresented);
-    qreal probFactor = 1.0/((qreal) dim);
+    const long long int numHalfDiags = 1LL << (qureg.numQubitsRepresented - 1);
+    long long int halfDiag, diag;
+    qreal prob = 0;
 
-    // Can't use qureg->stateVec as a private OMP var
-    qreal *densityReal = qureg.stateVec.real;
-    qreal *densityImag = qureg.stateVec.imag;
+    qreal *reVec = qureg.stateVec.real;
 
-    long long int index;
-    long long int chunkSize = qureg.numAmpsPerChunk;
-    // initialise the state to |+++..+++> = 1/normFactor {1, 1, 1, ...}
 # ifdef _OPENMP
 # pragma omp parallel \
-    shared   (chunkSize, densityReal, densityImag, probFactor) \
-    private  (index)
+    shared   (reVec) \
+    private  (halfDiag,diag) \
+    reduction ( +:prob )
 # endif
     {
 # ifdef _OPENMP
 # pragma omp for schedule (static)
 # endif
-        for (index=0; index<chunkSize; index++) {
-            densityReal[index] = probFactor;
-            densityImag[index] = 0.0;
+        for (halfDiag=0; halfDiag<numHalfDiags; halfDiag++) {
+            diag = insertZeroBit(halfDiag, measureQubit) | ((long long int) outcome << measureQubit);
+            prob += reVec[getPackedIndex(diag, diag)];
         }
     }
+    return prob;
 }
 
-void densmatr_initPureStateLocal(Qureg targetQureg, Qureg copyQureg) {
+qreal packmatr_calcPurityLocal(Qureg qureg) {
 
-    /* copyQureg amps aren't explicitly used - they're accessed through targetQureg.pair,
-     * which contains the full pure statevector.
-     * targetQureg has as many columns on node as copyQureg has amps
-     */
+    const long long int dim = 1LL << qureg.numQubitsRepresented;
+    long long int col, row, ind;
+    qreal diagSum = 0, offDiagSum = 0;
 
-    long long int colOffset = targetQureg.chunkId * copyQureg.numAmpsPerChunk;
-    long long int colsPerNode = copyQureg.numAmpsPerChunk;
-    long long int rowsPerNode = copyQureg.numAmpsTotal;
+    qreal *reVec = qureg.stateVec.real;
+    qreal *imVec = qureg.stateVec.imag;
 
-    // unpack vars for OpenMP
-    qreal* vecRe = targetQureg.pairStateVec.real;
-    qreal* vecIm = targetQureg.pairStateVec.imag;
-    qreal* densRe = targetQureg.stateVec.real;
-    qreal* densIm = targetQureg.stateVec.imag;
+# ifdef _OPENMP
+# pragma omp parallel \
+    shared   (reVec,imVec) \
+    private  (col,row,ind) \
+    reduction ( +:diagSum,offDiagSum )
+# endif
+    {
+# ifdef _OPENMP
+# pragma omp for schedule (static, 1)
+# endif
+        for (col=0; col<dim; col++) {
+            ind = getPackedIndex(0, col);
+            for (row=0; row<col; row++)
+                offDiagSum += reVec[ind+row]*reVec[ind+row] + imVec[ind+row]*imVec[ind+row];
+            diagSum += reVec[ind+col]*reVec[ind+col];
+        }
+    }
 
-    long long int col, row, index;
+    // every stored off-diagonal element stands for itself and its conjugate
+    return diagSum + 2*offDiagSum;
+}
 
-    // a_i conj(a_j) |i><j|
-    qreal ketRe, ketIm, braRe, braIm;
+qreal packmatr_calcFidelityLocal(Qureg qureg, Qureg pureState) {
+
+    const long long int dim = 1LL << qureg.numQubitsRepresented;
+    long long int col, row, ind;
+    qreal reCol, imCol, reRow, imRow, reRho, imRho, reProd;
+    qreal diagSum = 0, offDiagSum = 0;
+
+    qreal *reVec = qureg.stateVec.real;
+    qreal *imVec = qureg.stateVec.imag;
+    qreal *rePure = pureState.stateVec.real;
+    qreal *imPure = pureState.stateVec.imag;
 
 # ifdef _OPENMP
 # pragma omp parallel \
-    shared   (colOffset, colsPerNode,rowsPerNode, vecRe,vecIm,densRe,densIm) \
-    private  (col,row, ketRe,ketIm,braRe,braIm, index)
+    shared   (reVec,imVec, rePure,imPure) \
+    private  (col,row,ind, reCol,imCol,reRow,imRow,reRho,imRho,reProd) \
+    reduction ( +:diagSum,offDiagSum )
 # endif
     {
 # ifdef _OPENMP
-# pragma omp for schedule (static)
+# pragma omp for schedule (static, 1)
 # endif
-        // local column
-        for (col=0; col < colsPerNode; col++) {
+        for (col=0; col<dim; col++) {
+            reCol = rePure[col];
+            imCol = (imPure)? imPure[col] : 0; // absent for real-amplitude pure states
+            ind = getPackedIndex(0, col);
 
-            // global row
-            for (row=0; row < rowsPerNode; row++) {
-
-                // get pure state amps
-                ketRe = vecRe[row];
-                ketIm = vecIm[row];
-                braRe =   vecRe[col + colOffset];
-                braIm = - vecIm[col + colOffset]; // minus for conjugation
+            // <psi|rho|psi> = sum_{row,col} conj(psi_row) rho_{row,col} psi_col, of which
+            // each (row < col) term adds to its (col, row) conjugate to give twice its real part
+            for (row=0; row<col; row++) {
+                reRow = rePure[row];
+                imRow = (imPure)? imPure[row] : 0;
+                reRho = reVec[ind+row];
+                imRho = imVec[ind+row];
 
-                // update density matrix
-                index = row + col*rowsPerNode; // local ind
-                densRe[index] = ketRe*braRe - ketIm*braIm;
-                densIm[index] = ketRe*braIm + ketIm*braRe;
+                // real part of conj(psi_row) * rho * psi_col
+                reProd = (reRow*reRho + imRow*imRho)*reCol - (reRow*imRho - imRow*reRho)*imCol;
+                offDiagSum += reProd;
             }
+            diagSum += reVec[ind+col]*(reCol*reCol + imCol*imCol);
         }
     }
+    return diagSum + 2*offDiagSum;
 }
 
-void statevec_setAmps(Qureg qureg, long long int startInd, qreal* reals, qreal* imags, long long int numAmps) {
-
-    /* this is actually distributed, since the user's code runs on every node */
-
-    // local start/end indices of the given amplitudes, assuming they fit in this chunk
-    // these may be negative or above qureg.numAmpsPerChunk
-    long long int localStartInd = startInd - qureg.chunkId*qureg.numAmpsPerChunk;
-    long long int localEndInd = localStartInd + numAmps; // exclusive
-
-    // add this to a local index to get corresponding elem in reals & imags
-    long long int offset = qureg.chunkId*qureg.numAmpsPerChunk - startInd;
-
-    // restrict these indices to fit into this chunk
-    if (localStartInd < 0)
-        localStartInd = 0;
-    if (localEndInd > qureg.numAmpsPerChunk)
-        localEndInd = qureg.numAmpsPerChunk;
-    // they may now be out of order = no iterations
-
-    // unpacking OpenMP vars
-    long long int index;
-    qreal* vecRe = qureg.stateVec.real;
-    qreal* vecIm = qureg.stateVec.imag;
+/* Without nested parallelisation, only the outer most loops which call below are parallelised */
+void zeroSomeAmps(Qureg qureg, long long int startInd, long long int numAmps) {
+    long long int i;
+# ifdef _OPENMP
+# pragma omp parallel for schedule (static)
+# endif
+    for (i=startInd; i < startInd+numAmps; i++) {
+        qureg.stateVec.real[i] = 0;
+        qureg.stateVec.imag[i] = 0;
+    }
+}
+void normaliseSomeAmps(Qureg qureg, qreal norm, long long int startInd, long long int numAmps) {
+    long long int i;
+# ifdef _OPENMP
+# pragma omp parallel for schedule (static)
+# endif
+    for (i=startInd; i < startInd+numAmps; i++) {
+        qureg.stateVec.real[i] /= norm;
+        qureg.stateVec.imag[i] /= norm;
+    }
+}
+void alternateNormZeroingSomeAmpBlocks(
+    Qureg qureg, qreal norm, int normFirst,
+    long long int startAmpInd, long long int numAmps, long long int blockSize
+) {
+    long long int numDubBlocks = numAmps / (2*blockSize);
+    long long int blockStartInd;
 
+    if (normFirst) {
+        long long int dubBlockInd;
 # ifdef _OPENMP
-# pragma omp parallel \
-    shared   (localStartInd,localEndInd, vecRe,vecIm, reals,imags, offset) \
-    private  (index)
+# pragma omp parallel for schedule (static) private (blockStartInd)
 # endif
-    {
+        for (dubBlockInd=0; dubBlockInd < numDubBlocks; dubBlockInd++) {
+            blockStartInd = startAmpInd + dubBlockInd*2*blockSize;
+            normaliseSomeAmps(qureg, norm, blockStartInd,             blockSize); // |0><0|
+            zeroSomeAmps(     qureg,       blockStartInd + blockSize, blockSize);
+        }
+    } else {
+        long long int dubBlockInd;
 # ifdef _OPENMP
-# pragma omp for schedule (static)
+# pragma omp parallel for schedule (static) private (blockStartInd)
 # endif
-        // iterate these local inds - this might involve no iterations
-        for (index=localStartInd; index < localEndInd; index++) {
-            vecRe[index] = reals[index + offset];
-            vecIm[index] = imags[index + offset];
+        for (dubBlockInd=0; dubBlockInd < numDubBlocks; dubBlockInd++) {
+            blockStartInd = startAmpInd + dubBlockInd*2*blockSize;
+            zeroSomeAmps(     qureg,       blockStartInd,             blockSize);
+            normaliseSomeAmps(qureg, norm, blockStartInd + blockSize, blockSize); // |1><1|
         }
     }
 }
 
-void statevec_createQureg(Qureg *qureg, int numQubits, QuESTEnv env)
-{
-    long long int numAmps = 1LL << numQubits;
-    long long int numAmpsPerRank = numAmps/env.numRanks;
+/** Renorms (/prob) every | * outcome * >< * outcome * | state, setting all others to zero */
+void densmatr_collapseToKnownProbOutcome(Qureg qureg, const int measureQubit, int outcome, qreal totalStateProb) {
 
-    if (numAmpsPerRank > SIZE_MAX) {
-        printf("Could not allocate memory (cannot fit numAmps into size_t)!");
-        exit (EXIT_FAILURE);
-    }
+	// only (global) indices (as bit sequence): '* outcome *(n+q) outcome *q are spared
+    // where n = measureQubit, q = qureg.numQubitsRepresented.
+    // We can thus step in blocks of 2^q+n, killing every second, and inside the others,
+    //  stepping in sub-blocks of 2^q, killing every second.
+    // When outcome=1, we offset the start of these blocks by their size.
+    long long int innerBlockSize = (1LL << measureQubit);
+    long long int outerBlockSize = (1LL << (measureQubit + qureg.numQubitsRepresented));
 
-    size_t arrSize = (size_t) (numAmpsPerRank * sizeof(*(qureg->stateVec.real)));
-    qureg->stateVec.real = malloc(arrSize);
-    qureg->stateVec.imag = malloc(arrSize);
-    if (env.numRanks>1){
-        qureg->pairStateVec.real = malloc(arrSize);
-        qureg->pairStateVec.imag = malloc(arrSize);
-    }
+    // Because there are 2^a number of nodes(/chunks), each node will contain 2^b number of blocks,
+    // or each block will span 2^c number of nodes. Similarly for the innerblocks.
+    long long int locNumAmps = qureg.numAmpsPerChunk;
+    long long int globalStartInd = qureg.chunkId * locNumAmps;
+    int innerBit = extractBit(measureQubit, globalStartInd);
+    int outerBit = extractBit(measureQubit + qureg.numQubitsRepresented, globalStartInd);
 
-    if ( (!(qureg->stateVec.real) || !(qureg->stateVec.imag))
-            && numAmpsPerRank ) {
-        printf("Could not allocate memory!");
-        exit (EXIT_FAILURE);
-    }
+    // If this chunk's amps are entirely inside an outer block
+    if (locNumAmps <= outerBlockSize) {
 
-    if ( env.numRanks>1 && (!(qureg->pairStateVec.real) || !(qureg->pairStateVec.imag))
-            && numAmpsPerRank ) {
-        printf("Could not allocate memory!");
-        exit (EXIT_FAILURE);
+        // if this is an undesired outer block, kill all elems
+        if (outerBit != outcome)
+            return zeroSomeAmps(qureg, 0, qureg.numAmpsPerChunk);
+
+        // othwerwise, if this is a desired outer block, and also entirely an inner block
+        if (locNumAmps <= innerBlockSize) {
+
+            // and that inner block is undesired, kill all elems
+            if (innerBit != outcome)
+                return zeroSomeAmps(qureg, 0, qureg.numAmpsPerChunk);
+            // otherwise normalise all elems
+            else
+                return normaliseSomeAmps(qureg, totalStateProb, 0, qureg.numAmpsPerChunk);
+        }
+
+        // otherwise this is a desired outer block which contains 2^a inner blocks; kill/renorm every second inner block
+        return alternateNormZeroingSomeAmpBlocks(
+            qureg, totalStateProb, innerBit==outcome, 0, qureg.numAmpsPerChunk, innerBlockSize);
     }
 
-    qureg->numQubitsInStateVec = numQubits;
-    qureg->numAmpsTotal = numAmps;
-    qureg->numAmpsPerChunk = numAmpsPerRank;
-    qureg->chunkId = env.rank;
-    qureg->numChunks = env.numRanks;
-    qureg->isDensityMatrix = 0;
-}
+    // Otherwise, this chunk's amps contain multiple outer blocks (and hence multiple inner blocks)
+    long long int numOuterDoubleBlocks = locNumAmps / (2*outerBlockSize);
+    long long int firstBlockInd;
 
-void statevec_destroyQureg(Qureg qureg, QuESTEnv env){
+    // alternate norming* and zeroing the outer blocks (with order based on the desired outcome)
+    // These loops aren't parallelised, since they could have 1 or 2 iterations and will prevent
+    // inner parallelisation
+    if (outerBit == outcome) {
 
-    qureg.numQubitsInStateVec = 0;
-    qureg.numAmpsTotal = 0;
-    qureg.numAmpsPerChunk = 0;
+        for (long long int outerDubBlockInd = 0; outerDubBlockInd < numOuterDoubleBlocks; outerDubBlockInd++) {
+            firstBlockInd = outerDubBlockInd*2*outerBlockSize;
 
-    free(qureg.stateVec.real);
-    free(qureg.stateVec.imag);
-    if (env.numRanks>1){
-        free(qureg.pairStateVec.real);
-        free(qureg.pairStateVec.imag);
-    }
-    qureg.stateVec.real = NULL;
-    qureg.stateVec.imag = NULL;
-    qureg.pairStateVec.real = NULL;
-    qureg.pairStateVec.imag = NULL;
-}
+            // *norm only the desired inner blocks in the desired outer block
+            alternateNormZeroingSomeAmpBlocks(
+                qureg, totalStateProb, innerBit==outcome,
+                firstBlockInd, outerBlockSize, innerBlockSize);
 
-void statevec_reportStateToScreen(Qureg qureg, QuESTEnv env, int reportRank){
-    long long int index;
-    int rank;
-    if (qureg.numQubitsInStateVec<=5){
-        for (rank=0; rank<qureg.numChunks; rank++){
-            if (qureg.chunkId==rank){
-                if (reportRank) {
-                    printf("Reporting state from rank %d [\n", qureg.chunkId);
-                    printf("real, imag\n");
-                } else if (rank==0) {
-                    printf("Reporting state [\n");
-                    printf("real, imag\n");
-                }
+            // zero the undesired outer block
+            zeroSomeAmps(qureg, firstBlockInd + outerBlockSize, outerBlockSize);
+        }
 
-                for(index=0; index<qureg.numAmpsPerChunk; index++){
-                    //printf(REAL_STRING_FORMAT ", " REAL_STRING_FORMAT "\n", qureg.pairStateVec.real[index], qureg.pairStateVec.imag[index]);
-                    printf(REAL_STRING_FORMAT ", " REAL_STRING_FORMAT "\n", qureg.stateVec.real[index], qureg.stateVec.imag[index]);
-                }
-                if (reportRank || rank==qureg.numChunks-1) printf("]\n");
-            }
-            syncQuESTEnv(env);
+    } else {
+
+        for (long long int outerDubBlockInd = 0; outerDubBlockInd < numOuterDoubleBlocks; outerDubBlockInd++) {
+            firstBlockInd = outerDubBlockInd*2*outerBlockSize;
+
+            // same thing but undesired outer blocks come first
+            zeroSomeAmps(qureg, firstBlockInd, outerBlockSize);
+            alternateNormZeroingSomeAmpBlocks(
+                qureg, totalStateProb, innerBit==outcome,
+                firstBlockInd + outerBlockSize, outerBlockSize, innerBlockSize);
         }
-    } else printf("Error: reportStateToScreen will not print output for systems of more than 5 qubits.\n");
-}
-void statevec_getEnvironmentString(QuESTEnv env, Qureg qureg, char str[200]){
-    int numThreads=1;
-# ifdef _OPENMP
-    numThreads=omp_get_max_threads();
-# endif
-    sprintf(str, "%dqubits_CPU_%dranksx%dthreads", qureg.numQubitsInStateVec, env.numRanks, numThreads);
+    }
+
 }
 
-void statevec_initBlankState (Qureg qureg)
-{
-    long long int stateVecSize;
-    long long int index;
+qreal densmatr_calcPurityLocal(Qureg qureg) {
 
-    // dimension of the state vector
-    stateVecSize = qureg.numAmpsPerChunk;
+    /* sum of qureg^2, which is sum_i |qureg[i]|^2 */
+    long long int index;
+    long long int numAmps = qureg.numAmpsPerChunk;
 
-    // Can't use qureg->stateVec as a private OMP var
-    qreal *stateVecReal = qureg.stateVec.real;
-    qreal *stateVecImag = qureg.stateVec.imag;
+    qreal trace = 0;
+    qreal *vecRe = qureg.stateVec.real;
+    qreal *vecIm = qureg.stateVec.imag;
+
+# ifdef _OPENMP
+# pragma omp parallel \
+    shared    (vecRe, vecIm, numAmps) \
+    private   (index) \
+    reduction ( +:trace )
+# endif
+    {
+# ifdef _OPENMP
+# pragma omp for schedule  (static)
+# endif
+        for (index=0LL; index<numAmps; index++) {
+
+            trace += vecRe[index]*vecRe[index] + vecIm[index]*vecIm[index];
+        }
+    }
+
+    return trace;
+}
+
+/** Encodes each Pauli-sum term as a mask of the qubits it flips (X or Y), a mask of the qubits 
+ * whose row bit contributes a sign (Y or Z), and its number of Y operators modulo 4, 
+ * which fixes the global phase i^numY. The caller frees the returned arrays (a single allocation).
+ */
+static long long int* getPauliTermMasks(
+    enum pauliOpType* allCodes, int numQubits, int numSumTerms, 
+    long long int** signMasks, int** phaseCodes
+) {
+    long long int* flipMasks = malloc(numSumTerms * (2*sizeof *flipMasks + sizeof **phaseCodes));
+    *signMasks = &flipMasks[numSumTerms];
+    *phaseCodes = (int*) &flipMasks[2*numSumTerms];
+    
+    for (int t=0; t < numSumTerms; t++) {
+        flipMasks[t] = 0;
+        (*signMasks)[t] = 0;
+        (*phaseCodes)[t] = 0;
+        for (int q=0; q < numQubits; q++) {
+            enum pauliOpType code = allCodes[t*numQubits + q];
+            if (code == PAULI_X || code == PAULI_Y)
+                flipMasks[t] |= 1LL << q;
+            if (code == PAULI_Y || code == PAULI_Z)
+                (*signMasks)[t] |= 1LL << q;
+            if (code == PAULI_Y)
+                (*phaseCodes)[t] = ((*phaseCodes)[t] + 1) % 4;
+        }
+    }
+    return flipMasks;
+}
+
+/** Returns Re(i^phaseCode (re + i im)) */
+static inline qreal getRealOfPhasedElem(int phaseCode, qreal re, qreal im) {
+    switch (phaseCode) {
+        case 0: return   re;
+        case 1: return - im;
+        case 2: return - re;
+        default: return  im;
+    }
+}
+
+/** Computes this node's contribution to sum_t coeff_t Tr(P_t rho) without any workspace. 
+ * P_t maps |r> to phase_t(r) |r ^ flipMask_t>, so that Tr(P_t rho) = sum_r phase_t(r) rho[r][r ^ flipMask_t], 
+ * where phase_t(r) = i^numY (-1)^popcount(r & signMask_t). Each column of rho is contiguous, so 
+ * every term is evaluated while visiting a column, and rho is swept exactly once for the whole sum.
+ * Only the column range stored by this node is visited; element (row, col) lives at row + col 2^n.
+ */
+qreal densmatr_calcExpecPauliSumLocal(Qureg qureg, enum pauliOpType* allCodes, qreal* termCoeffs, int numSumTerms) {
+    
+    const int numQubits = qureg.numQubitsRepresented;
+    long long int *signMasks;
+    int *phaseCodes;
+    long long int *flipMasks = getPauliTermMasks(allCodes, numQubits, numSumTerms, &signMasks, &phaseCodes);
+    
+    const long long int globalIndStart = qureg.chunkId*qureg.numAmpsPerChunk;
+    const long long int globalIndEnd = globalIndStart + qureg.numAmpsPerChunk;
+    const long long int colStart = globalIndStart >> numQubits;
+    const long long int colEnd = ((globalIndEnd - 1) >> numQubits) + 1;
+    
+    long long int col, row, globalInd;
+    int t;
+    qreal value = 0;
+    
+    qreal *reVec = qureg.stateVec.real;
+    qreal *imVec = qureg.stateVec.imag;
+    
+# ifdef _OPENMP
+# pragma omp parallel \
+    shared   (reVec,imVec, flipMasks,signMasks,phaseCodes, termCoeffs) \
+    private  (col,row,globalInd, t) \
+    reduction ( +:value )
+# endif
+    {
+# ifdef _OPENMP
+# pragma omp for schedule (static)
+# endif
+        for (col=colStart; col<colEnd; col++) {
+            for (t=0; t<numSumTerms; t++) {
+                row = col ^ flipMasks[t];
+                globalInd = row + (col << numQubits);
+                if (globalInd < globalIndStart || globalInd >= globalIndEnd)
+                    continue;
+                
+                qreal elem = getRealOfPhasedElem(phaseCodes[t], 
+                    reVec[globalInd - globalIndStart], imVec[globalInd - globalIndStart]);
+                if (countOneBits(row & signMasks[t]) & 1)
+                    elem = - elem;
+                value += termCoeffs[t] * elem;
+            }
+        }
+    }
+    
+    free(flipMasks);
+    return value;
+}
+
+/** As densmatr_calcExpecPauliSumLocal, but reading each rho[r][c] from packed storage */
+qreal packmatr_calcExpecPauliSumLocal(Qureg qureg, enum pauliOpType* allCodes, qreal* termCoeffs, int numSumTerms) {
+    
+    const int numQubits = qureg.numQubitsRepresented;
+    long long int *signMasks;
+    int *phaseCodes;
+    long long int *flipMasks = getPauliTermMasks(allCodes, numQubits, numSumTerms, &signMasks, &phaseCodes);
+    
+    const long long int dim = 1LL << numQubits;
+    long long int col, row;
+    int t;
+    qreal re, im, value = 0;
+    
+    qreal *reVec = qureg.stateVec.real;
+    qreal *imVec = qureg.stateVec.imag;
+    
+# ifdef _OPENMP
+# pragma omp parallel \
+    shared   (reVec,imVec, flipMasks,signMasks,phaseCodes, termCoeffs) \
+    private  (col,row, t, re,im) \
+    reduction ( +:value )
+# endif
+    {
+# ifdef _OPENMP
+# pragma omp for schedule (static)
+# endif
+        for (col=0; col<dim; col++) {
+            for (t=0; t<numSumTerms; t++) {
+                row = col ^ flipMasks[t];
+                getPackedElem(reVec, imVec, row, col, &re, &im);
+                
+                qreal elem = getRealOfPhasedElem(phaseCodes[t], re, im);
+                if (countOneBits(row & signMasks[t]) & 1)
+                    elem = - elem;
+                value += termCoeffs[t] * elem;
+            }
+        }
+    }
+    
+    free(flipMasks);
+    return value;
+}
+
+void densmatr_mixDensityMatrix(Qureg combineQureg, qreal otherProb, Qureg otherQureg) {
+
+    /* corresponding amplitudes live on the same node (same dimensions) */
+
+    // unpack vars for OpenMP
+    qreal* combineVecRe = combineQureg.stateVec.real;
+    qreal* combineVecIm = combineQureg.stateVec.imag;
+    qreal* otherVecRe = otherQureg.stateVec.real;
+    qreal* otherVecIm = otherQureg.stateVec.imag;
+    long long int numAmps = combineQureg.numAmpsPerChunk;
+    long long int index;
+
+# ifdef _OPENMP
+# pragma omp parallel \
+    default (none) \
+    shared  (combineVecRe,combineVecIm,otherVecRe,otherVecIm, otherProb, numAmps) \
+    private (index)
+# endif
+    {
+# ifdef _OPENMP
+# pragma omp for schedule  (static)
+# endif
+        for (index=0; index < numAmps; index++) {
+            combineVecRe[index] *= 1-otherProb;
+            combineVecIm[index] *= 1-otherProb;
+
+            combineVecRe[index] += otherProb * otherVecRe[index];
+            combineVecIm[index] += otherProb * otherVecIm[index];
+        }
+    }
+}
+
+/** computes Tr((a-b) conjTrans(a-b)) = sum of abs values of (a-b) */
+qreal densmatr_calcHilbertSchmidtDistanceSquaredLocal(Qureg a, Qureg b) {
+
+    long long int index;
+    long long int numAmps = a.numAmpsPerChunk;
+
+    qreal *aRe = a.stateVec.real;
+    qreal *aIm = a.stateVec.imag;
+    qreal *bRe = b.stateVec.real;
+    qreal *bIm = b.stateVec.imag;
+
+    qreal trace = 0;
+    qreal difRe, difIm;
+
+# ifdef _OPENMP
+# pragma omp parallel \
+    shared    (aRe,aIm, bRe,bIm, numAmps) \
+    private   (index,difRe,difIm) \
+    reduction ( +:trace )
+# endif
+    {
+# ifdef _OPENMP
+# pragma omp for schedule  (static)
+# endif
+        for (index=0LL; index<numAmps; index++) {
+
+            difRe = aRe[index] - bRe[index];
+            difIm = aIm[index] - bIm[index];
+            trace += difRe*difRe + difIm*difIm;
+        }
+    }
+
+    return trace;
+}
+
+/** computes Tr(conjTrans(a) b) = sum of (a_ij^* b_ij) */
+qreal densmatr_calcInnerProductLocal(Qureg a, Qureg b) {
+
+    long long int index;
+    long long int numAmps = a.numAmpsPerChunk;
+
+    qreal *aRe = a.stateVec.real;
+    qreal *aIm = a.stateVec.imag;
+    qreal *bRe = b.stateVec.real;
+    qreal *bIm = b.stateVec.imag;
+
+    qreal trace = 0;
+
+# ifdef _OPENMP
+# pragma omp parallel \
+    shared    (aRe,aIm, bRe,bIm, numAmps) \
+    private   (index) \
+    reduction ( +:trace )
+# endif
+    {
+# ifdef _OPENMP
+# pragma omp for schedule  (static)
+# endif
+        for (index=0LL; index<numAmps; index++) {
+            trace += aRe[index]*bRe[index] + aIm[index]*bIm[index];
+        }
+    }
+
+    return trace;
+}
+
+
+/** computes a few dens-columns-worth of (vec^*T) dens * vec */
+qreal densmatr_calcFidelityLocal(Qureg qureg, Qureg pureState) {
+
+    /* Here, elements of pureState are not accessed (instead grabbed from qureg.pair).
+     * We only consult the attributes.
+     *
+     * qureg is a density matrix, and pureState is a statevector.
+     * Every node contains as many columns of qureg as amps by pureState.
+     * (each node contains an integer, exponent-of-2 number of whole columns of qureg)
+     * Ergo, this node contains columns:
+     * qureg.chunkID * pureState.numAmpsPerChunk  to
+     * (qureg.chunkID + 1) * pureState.numAmpsPerChunk
+     *
+     * The first pureState.numAmpsTotal elements of qureg.pairStateVec are the
+     * entire pureState state-vector
+     */
+
+    // unpack everything for OPENMP
+    qreal* vecRe  = qureg.pairStateVec.real;
+    qreal* vecIm  = qureg.pairStateVec.imag;
+    qreal* densRe = qureg.stateVec.real;
+    qreal* densIm = qureg.stateVec.imag;
+
+    int row, col;
+    int dim = (int) pureState.numAmpsTotal;
+    int colsPerNode = (int) pureState.numAmpsPerChunk;
+    // using only int, because density matrix has squared as many amps so its
+    // iteration would be impossible if the pureStates numAmpsTotal didn't fit into int
+
+    // starting GLOBAL column index of the qureg columns on this node
+    int startCol = (int) (qureg.chunkId * pureState.numAmpsPerChunk);
+
+    qreal densElemRe, densElemIm;
+    qreal prefacRe, prefacIm;
+    qreal rowSumRe, rowSumIm;
+    qreal vecElemRe, vecElemIm;
+
+    // quantity computed by this node
+    qreal globalSumRe = 0;   // imag-component is assumed zero
+
+# ifdef _OPENMP
+# pragma omp parallel \
+    shared    (vecRe,vecIm,densRe,densIm, dim,colsPerNode,startCol) \
+    private   (row,col, prefacRe,prefacIm, rowSumRe,rowSumIm, densElemRe,densElemIm, vecElemRe,vecElemIm) \
+    reduction ( +:globalSumRe )
+# endif
+    {
+# ifdef _OPENMP
+# pragma omp for schedule  (static)
+# endif
+        // indices of my GLOBAL row
+        for (row=0; row < dim; row++) {
+
+            // single element of conj(pureState)
+            prefacRe =   vecRe[row];
+            prefacIm = (vecIm)? - vecIm[row] : 0; // absent for real-amplitude pure states
+
+            rowSumRe = 0;
+            rowSumIm = 0;
+
+            // indices of my LOCAL column
+            for (col=0; col < colsPerNode; col++) {
+
+                // my local density element
+                densElemRe = densRe[row + dim*col];
+                densElemIm = densIm[row + dim*col];
+
+                // state-vector element
+                vecElemRe = vecRe[startCol + col];
+                vecElemIm = (vecIm)? vecIm[startCol + col] : 0;
+
+                rowSumRe += densElemRe*vecElemRe - densElemIm*vecElemIm;
+                rowSumIm += densElemRe*vecElemIm + densElemIm*vecElemRe;
+            }
+
+            globalSumRe += rowSumRe*prefacRe - rowSumIm*prefacIm;
+        }
+    }
+
+    return globalSumRe;
+}
+
+Complex statevec_calcInnerProductLocal(Qureg bra, Qureg ket) {
+
+    qreal innerProdReal = 0;
+    qreal innerProdImag = 0;
+
+    long long int index;
+    long long int numAmps = bra.numAmpsPerChunk;
+    qreal *braVecReal = bra.stateVec.real;
+    qreal *braVecImag = bra.stateVec.imag;
+    qreal *ketVecReal = ket.stateVec.real;
+    qreal *ketVecImag = ket.stateVec.imag;
+
+    qreal braRe, braIm, ketRe, ketIm;
+
+# ifdef _OPENMP
+# pragma omp parallel \
+    shared    (braVecReal, braVecImag, ketVecReal, ketVecImag, numAmps) \
+    private   (index, braRe, braIm, ketRe, ketIm) \
+    reduction ( +:innerProdReal, innerProdImag )
+# endif
+    {
+# ifdef _OPENMP
+# pragma omp for schedule  (static)
+# endif
+        for (index=0; index < numAmps; index++) {
+            braRe = braVecReal[index];
+            braIm = braVecImag[index];
+            ketRe = ketVecReal[index];
+            ketIm = ketVecImag[index];
+
+            // conj(bra_i) * ket_i
+            innerProdReal += braRe*ketRe + braIm*ketIm;
+            innerProdImag += braRe*ketIm - braIm*ketRe;
+        }
+    }
+
+    Complex innerProd;
+    innerProd.real = innerProdReal;
+    innerProd.imag = innerProdImag;
+    return innerProd;
+}
+
+
+
+void densmatr_initClassicalState (Qureg qureg, long long int stateInd)
+{
+    if (qureg.isPacked) {
+        packmatr_initClassicalStateLocal(qureg, stateInd);
+        return;
+    }
+
+    // dimension of the state vector
+    long long int densityNumElems = qureg.numAmpsPerChunk;
+
+    // Can't use qureg->stateVec as a private OMP var
+    qreal *densityReal = qureg.stateVec.real;
+    qreal *densityImag = qureg.stateVec.imag;
+
+    // initialise the state to all zeros
+    long long int index;
+# ifdef _OPENMP
+# pragma omp parallel \
+    shared   (densityNumElems, densityReal, densityImag) \
+    private  (index)
+# endif
+    {
+# ifdef _OPENMP
+# pragma omp for schedule (static)
+# endif
+        for (index=0; index<densityNumElems; index++) {
+            densityReal[index] = 0.0;
+            densityImag[index] = 0.0;
+        }
+    }
+
+    // index of the single density matrix elem to set non-zero
+    long long int densityDim = 1LL << qureg.numQubitsRepresented;
+    long long int densityInd = (densityDim + 1)*stateInd;
+
+    // give the specified classical state prob 1
+    if (qureg.chunkId == densityInd / densityNumElems){
+        densityReal[densityInd % densityNumElems] = 1.0;
+        densityImag[densityInd % densityNumElems] = 0.0;
+    }
+}
+
+
+void densmatr_initPlusState (Qureg qureg)
+{
+    // |+><+| = sum_i 1/sqrt(2^N) |i> 1/sqrt(2^N) <j| = sum_ij 1/2^N |i><j|
+    long long int dim = (1LL << qureg.numQubitsRepresented);
+    qreal probFactor = 1.0/((qreal) dim);
+
+    // Can't use qureg->stateVec as a private OMP var
+    qreal *densityReal = qureg.stateVec.real;
+    qreal *densityImag = qureg.stateVec.imag;
+
+    long long int index;
+    long long int chunkSize = qureg.numAmpsPerChunk;
+    // initialise the state to |+++..+++> = 1/normFactor {1, 1, 1, ...}
+# ifdef _OPENMP
+# pragma omp parallel \
+    shared   (chunkSize, densityReal, densityImag, probFactor) \
+    private  (index)
+# endif
+    {
+# ifdef _OPENMP
+# pragma omp for schedule (static)
+# endif
+        for (index=0; index<chunkSize; index++) {
+            densityReal[index] = probFactor;
+            densityImag[index] = 0.0;
+        }
+    }
+}
+
+void densmatr_initPureStateLocal(Qureg targetQureg, Qureg copyQureg) {
+
+    /* copyQureg amps aren't explicitly used - they're accessed through targetQureg.pair,
+     * which contains the full pure statevector.
+     * targetQureg has as many columns on node as copyQureg has amps
+     */
+
+    long long int colOffset = targetQureg.chunkId * copyQureg.numAmpsPerChunk;
+    long long int colsPerNode = copyQureg.numAmpsPerChunk;
+    long long int rowsPerNode = copyQureg.numAmpsTotal;
+
+    // unpack vars for OpenMP
+    qreal* vecRe = targetQureg.pairStateVec.real;
+    qreal* vecIm = targetQureg.pairStateVec.imag;
+    qreal* densRe = targetQureg.stateVec.real;
+    qreal* densIm = targetQureg.stateVec.imag;
+
+    long long int col, row, index;
+
+    // a_i conj(a_j) |i><j|
+    qreal ketRe, ketIm, braRe, braIm;
+
+# ifdef _OPENMP
+# pragma omp parallel \
+    shared   (colOffset, colsPerNode,rowsPerNode, vecRe,vecIm,densRe,densIm) \
+    private  (col,row, ketRe,ketIm,braRe,braIm, index)
+# endif
+    {
+# ifdef _OPENMP
+# pragma omp for schedule (static)
+# endif
+        // local column
+        for (col=0; col < colsPerNode; col++) {
+
+            // global row
+            for (row=0; row < rowsPerNode; row++) {
+
+                // get pure state amps
+                ketRe = vecRe[row];
+                ketIm = vecIm[row];
+                braRe =   vecRe[col + colOffset];
+                braIm = - vecIm[col + colOffset]; // minus for conjugation
+
+                // update density matrix
+                index = row + col*rowsPerNode; // local ind
+                densRe[index] = ketRe*braRe - ketIm*braIm;
+                densIm[index] = ketRe*braIm + ketIm*braRe;
+            }
+        }
+    }
+}
+
+void statevec_setAmps(Qureg qureg, long long int startInd, qreal* reals, qreal* imags, long long int numAmps) {
+
+    /* this is actually distributed, since the user's code runs on every node */
+
+    // local start/end indices of the given amplitudes, assuming they fit in this chunk
+    // these may be negative or above qureg.numAmpsPerChunk
+    long long int localStartInd = startInd - qureg.chunkId*qureg.numAmpsPerChunk;
+    long long int localEndInd = localStartInd + numAmps; // exclusive
+
+    // add this to a local index to get corresponding elem in reals & imags
+    long long int offset = qureg.chunkId*qureg.numAmpsPerChunk - startInd;
+
+    // restrict these indices to fit into this chunk
+    if (localStartInd < 0)
+        localStartInd = 0;
+    if (localEndInd > qureg.numAmpsPerChunk)
+        localEndInd = qureg.numAmpsPerChunk;
+    // they may now be out of order = no iterations
+
+    // unpacking OpenMP vars
+    long long int index;
+    qreal* vecRe = qureg.stateVec.real;
+    qreal* vecIm = qureg.stateVec.imag;
+
+# ifdef _OPENMP
+# pragma omp parallel \
+    shared   (localStartInd,localEndInd, vecRe,vecIm, reals,imags, offset) \
+    private  (index)
+# endif
+    {
+# ifdef _OPENMP
+# pragma omp for schedule (static)
+# endif
+        // iterate these local inds - this might involve no iterations
+        for (index=localStartInd; index < localEndInd; index++) {
+            vecRe[index] = reals[index + offset];
+            vecIm[index] = imags[index + offset];
+        }
+    }
+}
+
+/* The amplitude arrays of destroyed registers, retained (while the pool has capacity) so that
+ * later registers of the same size reuse them rather than faulting in fresh pages. The pool
+ * belongs to the process's single QuESTEnv, and is emptied by destroyQuESTEnv.
+ */
+typedef struct {
+    size_t arrSize;
+    ComplexArray stateVec;
+    ComplexArray pairStateVec;
+} PooledQuregArrays;
+
+static PooledQuregArrays* quregPool = NULL;
+static int quregPoolSize = 0;
+static int quregPoolCapacity = 0;
+
+static void freeQuregArrays(size_t arrSize, ComplexArray stateVec, ComplexArray pairStateVec) {
+    freeAmpArray(stateVec.real, arrSize);
+    freeAmpArray(stateVec.imag, arrSize);
+    freeAmpArray(pairStateVec.real, arrSize);
+    freeAmpArray(pairStateVec.imag, arrSize);
+}
+
+void statevec_setQuregPoolCapacity(int capacity) {
+    while (quregPoolSize > capacity) {
+        quregPoolSize--;
+        freeQuregArrays(quregPool[quregPoolSize].arrSize, quregPool[quregPoolSize].stateVec, quregPool[quregPoolSize].pairStateVec);
+    }
+    quregPoolCapacity = capacity;
+    if (capacity == 0) {
+        free(quregPool);
+        quregPool = NULL;
+    } else
+        quregPool = realloc(quregPool, capacity * sizeof *quregPool);
+}
+
+/** Assign a register's amplitude arrays, each of arrSize bytes, recycled from the pool where possible.
+ * The arrays are not initialised here: the create functions then write every amplitude (as by 
+ * initZeroState), in parallel and with the static schedule of the kernels, so that each page is 
+ * first touched (and so placed in the memory of the NUMA node) of the thread which will process it. 
+ * Recycled arrays are merely detached from any file they were shared from. Real-amplitude 
+ * registers have no imag arrays.
+ */
+static void allocQuregArrays(Qureg *qureg, size_t arrSize, int withImag, int withPair) {
+
+    for (int i=quregPoolSize-1; i>=0; i--) {
+        if (quregPool[i].arrSize != arrSize || 
+                (quregPool[i].stateVec.imag != NULL) != withImag ||
+                (quregPool[i].pairStateVec.real != NULL) != withPair)
+            continue;
+
+        qureg->stateVec = quregPool[i].stateVec;
+        qureg->pairStateVec = quregPool[i].pairStateVec;
+        quregPool[i] = quregPool[--quregPoolSize];
+
+        unshareAmpArray(qureg->stateVec.real, arrSize);
+        if (withImag)
+            unshareAmpArray(qureg->stateVec.imag, arrSize);
+        return;
+    }
+
+    qureg->stateVec.real = allocAmpArray(arrSize);
+    qureg->stateVec.imag = (withImag)? allocAmpArray(arrSize) : NULL;
+    qureg->pairStateVec.real = (withPair)? allocAmpArray(arrSize) : NULL;
+    qureg->pairStateVec.imag = (withPair && withImag)? allocAmpArray(arrSize) : NULL;
+}
+
+void statevec_createQureg(Qureg *qureg, int numQubits, QuESTEnv env)
+{
+    long long int numAmps = 1LL << numQubits;
+    long long int numAmpsPerRank = numAmps/env.numRanks;
+
+    if (numAmpsPerRank > SIZE_MAX) {
+        printf("Could not allocate memory (cannot fit numAmps into size_t)!");
+        exit (EXIT_FAILURE);
+    }
+
+    size_t arrSize = (size_t) (numAmpsPerRank * sizeof(*(qureg->stateVec.real)));
+    allocQuregArrays(qureg, arrSize, 1, env.numRanks>1);
+
+    if ( (!(qureg->stateVec.real) || !(qureg->stateVec.imag))
+            && numAmpsPerRank ) {
+        printf("Could not allocate memory!");
+        exit (EXIT_FAILURE);
+    }
+
+    if ( env.numRanks>1 && (!(qureg->pairStateVec.real) || !(qureg->pairStateVec.imag))
+            && numAmpsPerRank ) {
+        printf("Could not allocate memory!");
+        exit (EXIT_FAILURE);
+    }
+
+    qureg->numQubitsInStateVec = numQubits;
+    qureg->numAmpsTotal = numAmps;
+    qureg->numAmpsPerChunk = numAmpsPerRank;
+    qureg->chunkId = env.rank;
+    qureg->numChunks = env.numRanks;
+    qureg->isDensityMatrix = 0;
+    qureg->isPacked = 0;
+    qureg->isReal = 0;
+    qureg->isSubspace = 0;
+    qureg->hammingWeight = 0;
+    qureg->isOutOfCore = 0;
+    qureg->isCompressed = 0;
+    qureg->compressedAmps = NULL;
+}
+
+void packmatr_createQureg(Qureg *qureg, int numQubits, QuESTEnv env)
+{
+    // only the upper triangle (including the diagonal) of the 2^N x 2^N matrix is stored
+    long long int dim = 1LL << numQubits;
+    long long int numElems = (dim*(dim+1)) >> 1;
+
+    if (numElems > SIZE_MAX) {
+        printf("Could not allocate memory (cannot fit numAmps into size_t)!");
+        exit (EXIT_FAILURE);
+    }
+
+    size_t arrSize = (size_t) (numElems * sizeof(*(qureg->stateVec.real)));
+    allocQuregArrays(qureg, arrSize, 1, 0);
+
+    if (!(qureg->stateVec.real) || !(qureg->stateVec.imag)) {
+        printf("Could not allocate memory!");
+        exit (EXIT_FAILURE);
+    }
+
+    qureg->numQubitsInStateVec = 2*numQubits;
+    qureg->numAmpsTotal = numElems;
+    qureg->numAmpsPerChunk = numElems;
+    qureg->chunkId = env.rank;
+    qureg->numChunks = env.numRanks;
+    qureg->isDensityMatrix = 1;
+    qureg->isPacked = 1;
+    qureg->isReal = 0;
+    qureg->isSubspace = 0;
+    qureg->hammingWeight = 0;
+    qureg->isOutOfCore = 0;
+    qureg->isCompressed = 0;
+    qureg->compressedAmps = NULL;
+}
+
+void realvec_createQureg(Qureg *qureg, int numQubits, QuESTEnv env)
+{
+    long long int numAmps = 1LL << numQubits;
+    long long int numAmpsPerRank = numAmps/env.numRanks;
+
+    if (numAmpsPerRank > SIZE_MAX) {
+        printf("Could not allocate memory (cannot fit numAmps into size_t)!");
+        exit (EXIT_FAILURE);
+    }
+
+    size_t arrSize = (size_t) (numAmpsPerRank * sizeof(*(qureg->stateVec.real)));
+    allocQuregArrays(qureg, arrSize, 0, env.numRanks>1);
+
+    if ( (!(qureg->stateVec.real) || (env.numRanks>1 && !(qureg->pairStateVec.real)))
+            && numAmpsPerRank ) {
+        printf("Could not allocate memory!");
+        exit (EXIT_FAILURE);
+    }
+
+    qureg->numQubitsInStateVec = numQubits;
+    qureg->numAmpsTotal = numAmps;
+    qureg->numAmpsPerChunk = numAmpsPerRank;
+    qureg->chunkId = env.rank;
+    qureg->numChunks = env.numRanks;
+    qureg->isDensityMatrix = 0;
+    qureg->isPacked = 0;
+    qureg->isReal = 1;
+    qureg->isSubspace = 0;
+    qureg->hammingWeight = 0;
+    qureg->isOutOfCore = 0;
+    qureg->isCompressed = 0;
+    qureg->compressedAmps = NULL;
+}
+
+static long long int getSubspaceDim(int numQubits, int hammingWeight);
+
+void subspace_createQureg(Qureg *qureg, int numQubits, int hammingWeight, QuESTEnv env)
+{
+    long long int numAmps = getSubspaceDim(numQubits, hammingWeight);
+
+    if (numAmps > SIZE_MAX/sizeof(qreal)) {
+        printf("Could not allocate memory (cannot fit numAmps into size_t)!");
+        exit (EXIT_FAILURE);
+    }
+
+    size_t arrSize = (size_t) (numAmps * sizeof(*(qureg->stateVec.real)));
+    allocQuregArrays(qureg, arrSize, 1, 0);
+
+    if (!(qureg->stateVec.real) || !(qureg->stateVec.imag)) {
+        printf("Could not allocate memory!");
+        exit (EXIT_FAILURE);
+    }
+
+    qureg->numQubitsInStateVec = numQubits;
+    qureg->numAmpsTotal = numAmps;
+    qureg->numAmpsPerChunk = numAmps;
+    qureg->chunkId = env.rank;
+    qureg->numChunks = env.numRanks;
+    qureg->isDensityMatrix = 0;
+    qureg->isPacked = 0;
+    qureg->isReal = 0;
+    qureg->isSubspace = 1;
+    qureg->hammingWeight = hammingWeight;
+    qureg->isOutOfCore = 0;
+    qureg->isCompressed = 0;
+    qureg->compressedAmps = NULL;
+}
+
+void statevec_createOutOfCoreQureg(Qureg *qureg, int numQubits, char* dirName, QuESTEnv env)
+{
+    long long int numAmps = 1LL << numQubits;
+    long long int numAmpsPerRank = numAmps/env.numRanks;
+
+    if (numAmpsPerRank > SIZE_MAX/sizeof(qreal)) {
+        printf("Could not allocate memory (cannot fit numAmps into size_t)!");
+        exit (EXIT_FAILURE);
+    }
+
+    // every array (including the pair arrays) is file-backed, and never pooled
+    size_t arrSize = (size_t) (numAmpsPerRank * sizeof(*(qureg->stateVec.real)));
+    qureg->stateVec.real = allocFileAmpArray(arrSize, dirName);
+    qureg->stateVec.imag = allocFileAmpArray(arrSize, dirName);
+    qureg->pairStateVec.real = (env.numRanks>1)? allocFileAmpArray(arrSize, dirName) : NULL;
+    qureg->pairStateVec.imag = (env.numRanks>1)? allocFileAmpArray(arrSize, dirName) : NULL;
+
+    if (!(qureg->stateVec.real) || !(qureg->stateVec.imag) || 
+            (env.numRanks>1 && (!(qureg->pairStateVec.real) || !(qureg->pairStateVec.imag)))) {
+        printf("Could not allocate memory (cannot map the amplitude files)!");
+        exit (EXIT_FAILURE);
+    }
+
+    qureg->numQubitsInStateVec = numQubits;
+    qureg->numAmpsTotal = numAmps;
+    qureg->numAmpsPerChunk = numAmpsPerRank;
+    qureg->chunkId = env.rank;
+    qureg->numChunks = env.numRanks;
+    qureg->isDensityMatrix = 0;
+    qureg->isPacked = 0;
+    qureg->isReal = 0;
+    qureg->isSubspace = 0;
+    qureg->hammingWeight = 0;
+    qureg->isOutOfCore = 1;
+    qureg->isCompressed = 0;
+    qureg->compressedAmps = NULL;
+}
+
+void statevec_destroyQureg(Qureg qureg, QuESTEnv env){
+
+    size_t arrSize = (size_t) (qureg.numAmpsPerChunk * sizeof(*(qureg.stateVec.real)));
+    qureg.numQubitsInStateVec = 0;
+    qureg.numAmpsTotal = 0;
+    qureg.numAmpsPerChunk = 0;
+
+    if (qureg.isOutOfCore) {
+        freeFileAmpArray(qureg.stateVec.real, arrSize);
+        freeFileAmpArray(qureg.stateVec.imag, arrSize);
+        freeFileAmpArray(qureg.pairStateVec.real, arrSize);
+        freeFileAmpArray(qureg.pairStateVec.imag, arrSize);
+    }
+    else if (quregPoolSize < quregPoolCapacity) {
+        PooledQuregArrays arrs = {.arrSize=arrSize, .stateVec=qureg.stateVec, .pairStateVec=qureg.pairStateVec};
+        quregPool[quregPoolSize++] = arrs;
+    } else
+        freeQuregArrays(arrSize, qureg.stateVec, qureg.pairStateVec);
+    qureg.stateVec.real = NULL;
+    qureg.stateVec.imag = NULL;
+    qureg.pairStateVec.real = NULL;
+    qureg.pairStateVec.imag = NULL;
+}
+
+void statevec_reportStateToScreen(Qureg qureg, QuESTEnv env, int reportRank){
+    long long int index;
+    int rank;
+    if (qureg.numQubitsInStateVec<=5){
+        for (rank=0; rank<qureg.numChunks; rank++){
+            if (qureg.chunkId==rank){
+                if (reportRank) {
+                    printf("Reporting state from rank %d [\n", qureg.chunkId);
+                    printf("real, imag\n");
+                } else if (rank==0) {
+                    printf("Reporting state [\n");
+                    printf("real, imag\n");
+                }
+
+                for(index=0; index<qureg.numAmpsPerChunk; index++){
+                    //printf(REAL_STRING_FORMAT ", " REAL_STRING_FORMAT "\n", qureg.pairStateVec.real[index], qureg.pairStateVec.imag[index]);
+                    printf(REAL_STRING_FORMAT ", " REAL_STRING_FORMAT "\n", qureg.stateVec.real[index], 
+                        (qureg.isReal)? 0 : qureg.stateVec.imag[index]);
+                }
+                if (reportRank || rank==qureg.numChunks-1) printf("]\n");
+            }
+            syncQuESTEnv(env);
+        }
+    } else printf("Error: reportStateToScreen will not print output for systems of more than 5 qubits.\n");
+}
+void statevec_getEnvironmentString(QuESTEnv env, Qureg qureg, char str[200]){
+    int numThreads=1;
+# ifdef _OPENMP
+    numThreads=omp_get_max_threads();
+# endif
+    sprintf(str, "%dqubits_CPU_%dranksx%dthreads", qureg.numQubitsInStateVec, env.numRanks, numThreads);
+}
+
+void statevec_initBlankState (Qureg qureg)
+{
+    long long int stateVecSize;
+    long long int index;
+
+    // dimension of the state vector
+    stateVecSize = qureg.numAmpsPerChunk;
+
+    // Can't use qureg->stateVec as a private OMP var
+    qreal *stateVecReal = qureg.stateVec.real;
+    qreal *stateVecImag = qureg.stateVec.imag;
 
     // initialise the state-vector to all-zeroes
 # ifdef _OPENMP
 # pragma omp parallel \
-    shared   (stateVecSize, stateVecReal, stateVecImag) \
-    private  (index)
+    shared   (stateVecSize, stateVecReal, stateVecImag) \
+    private  (index)
+# endif
+    {
+# ifdef _OPENMP
+# pragma omp for schedule (static)
+# endif
+        for (index=0; index<stateVecSize; index++) {
+            stateVecReal[index] = 0.0;
+            stateVecImag[index] = 0.0;
+        }
+    }
+}
+
+void statevec_initZeroState (Qureg qureg)
+{
+    statevec_initBlankState(qureg);
+    if (qureg.chunkId==0){
+        // zero state |0000..0000> has probability 1
+        qureg.stateVec.real[0] = 1.0;
+        qureg.stateVec.imag[0] = 0.0;
+    }
+}
+
+void statevec_initPlusState (Qureg qureg)
+{
+    long long int chunkSize, stateVecSize;
+    long long int index;
+
+    // dimension of the state vector
+    chunkSize = qureg.numAmpsPerChunk;
+    stateVecSize = chunkSize*qureg.numChunks;
+    qreal normFactor = 1.0/sqrt((qreal)stateVecSize);
+
+    // Can't use qureg->stateVec as a private OMP var
+    qreal *stateVecReal = qureg.stateVec.real;
+    qreal *stateVecImag = qureg.stateVec.imag;
+
+    // initialise the state to |+++..+++> = 1/normFactor {1, 1, 1, ...}
+# ifdef _OPENMP
+# pragma omp parallel \
+    shared   (chunkSize, stateVecReal, stateVecImag, normFactor) \
+    private  (index)
+# endif
+    {
+# ifdef _OPENMP
+# pragma omp for schedule (static)
+# endif
+        for (index=0; index<chunkSize; index++) {
+            stateVecReal[index] = normFactor;
+            stateVecImag[index] = 0.0;
+        }
+    }
+}
+
+void statevec_initClassicalState (Qureg qureg, long long int stateInd)
+{
+    long long int stateVecSize;
+    long long int index;
+
+    // dimension of the state vector
+    stateVecSize = qureg.numAmpsPerChunk;
+
+    // Can't use qureg->stateVec as a private OMP var
+    qreal *stateVecReal = qureg.stateVec.real;
+    qreal *stateVecImag = qureg.stateVec.imag;
+
+    // initialise the state to vector to all zeros
+# ifdef _OPENMP
+# pragma omp parallel \
+    shared   (stateVecSize, stateVecReal, stateVecImag) \
+    private  (index)
+# endif
+    {
+# ifdef _OPENMP
+# pragma omp for schedule (static)
+# endif
+        for (index=0; index<stateVecSize; index++) {
+            stateVecReal[index] = 0.0;
+            stateVecImag[index] = 0.0;
+        }
+    }
+
+    // give the specified classical state prob 1
+    if (qureg.chunkId == stateInd/stateVecSize){
+        stateVecReal[stateInd % stateVecSize] = 1.0;
+        stateVecImag[stateInd % stateVecSize] = 0.0;
+    }
+}
+
+void statevec_cloneQureg(Qureg targetQureg, Qureg copyQureg) {
+
+    // registers are equal sized, so nodes hold the same state-vector partitions
+    long long int stateVecSize;
+    long long int index;
+
+    // dimension of the state vector
+    stateVecSize = targetQureg.numAmpsPerChunk;
+
+    // if enabled, large in-memory arrays instead share the copy's pages, which are only duplicated when next written
+    size_t arrSize = (size_t) (stateVecSize * sizeof(*(targetQureg.stateVec.real)));
+    if (!targetQureg.isOutOfCore && !copyQureg.isOutOfCore &&
+        shareAmpArray(targetQureg.stateVec.real, copyQureg.stateVec.real, arrSize) &&
+        shareAmpArray(targetQureg.stateVec.imag, copyQureg.stateVec.imag, arrSize))
+        return;
+
+    // Can't use qureg->stateVec as a private OMP var
+    qreal *targetStateVecReal = targetQureg.stateVec.real;
+    qreal *targetStateVecImag = targetQureg.stateVec.imag;
+    qreal *copyStateVecReal = copyQureg.stateVec.real;
+    qreal *copyStateVecImag = copyQureg.stateVec.imag;
+
+    // initialise the state to |0000..0000>
+# ifdef _OPENMP
+# pragma omp parallel \
+    shared   (stateVecSize, targetStateVecReal, targetStateVecImag, copyStateVecReal, copyStateVecImag) \
+    private  (index)
+# endif
+    {
+# ifdef _OPENMP
+# pragma omp for schedule (static)
+# endif
+        for (index=0; index<stateVecSize; index++) {
+            targetStateVecReal[index] = copyStateVecReal[index];
+            targetStateVecImag[index] = copyStateVecImag[index];
+        }
+    }
+}
+
+/**
+ * Initialise the state vector of probability amplitudes such that one qubit is set to 'outcome' and all other qubits are in an equal superposition of zero and one.
+ * @param[in,out] qureg object representing the set of qubits to be initialised
+ * @param[in] qubitId id of qubit to set to state 'outcome'
+ * @param[in] value of qubit 'qubitId'
+ */
+void statevec_initStateOfSingleQubit(Qureg *qureg, int qubitId, int outcome)
+{
+    long long int chunkSize, stateVecSize;
+    long long int index;
+    int bit;
+    const long long int chunkId=qureg->chunkId;
+
+    // dimension of the state vector
+    chunkSize = qureg->numAmpsPerChunk;
+    stateVecSize = chunkSize*qureg->numChunks;
+    qreal normFactor = 1.0/sqrt((qreal)stateVecSize/2.0);
+
+    // Can't use qureg->stateVec as a private OMP var
+    qreal *stateVecReal = qureg->stateVec.real;
+    qreal *stateVecImag = qureg->stateVec.imag;
+
+    // initialise the state to |0000..0000>
+# ifdef _OPENMP
+# pragma omp parallel \
+    shared   (chunkSize, stateVecReal, stateVecImag, normFactor, qubitId, outcome) \
+    private  (index, bit)
+# endif
+    {
+# ifdef _OPENMP
+# pragma omp for schedule (static)
+# endif
+        for (index=0; index<chunkSize; index++) {
+            bit = extractBit(qubitId, index+chunkId*chunkSize);
+            stateVecReal[index] = (bit==outcome)? normFactor : 0.0;
+            if (stateVecImag) // absent for real-amplitude registers
+                stateVecImag[index] = 0.0;
+        }
+    }
+}
+
+
+/**
+ * Initialise the state vector of probability amplitudes to an (unphysical) state with
+ * each component of each probability amplitude a unique floating point value. For debugging processes
+ * @param[in,out] qureg object representing the set of qubits to be initialised
+ */
+void statevec_initDebugState (Qureg qureg)
+{
+    long long int chunkSize;
+    long long int index;
+    long long int indexOffset;
+
+    // dimension of the state vector
+    chunkSize = qureg.numAmpsPerChunk;
+
+    // Can't use qureg->stateVec as a private OMP var
+    qreal *stateVecReal = qureg.stateVec.real;
+    qreal *stateVecImag = qureg.stateVec.imag;
+
+    indexOffset = chunkSize * qureg.chunkId;
+
+    // initialise the state to |0000..0000>
+# ifdef _OPENMP
+# pragma omp parallel \
+    shared   (chunkSize, stateVecReal, stateVecImag, indexOffset) \
+    private  (index)
+# endif
+    {
+# ifdef _OPENMP
+# pragma omp for schedule (static)
+# endif
+        for (index=0; index<chunkSize; index++) {
+            stateVecReal[index] = ((indexOffset + index)*2.0)/10.0;
+            stateVecImag[index] = ((indexOffset + index)*2.0+1.0)/10.0;
+        }
+    }
+}
+
+// returns 1 if successful, else 0
+int statevec_initStateFromSingleFile(Qureg *qureg, char filename[200], QuESTEnv env){
+    long long int chunkSize, stateVecSize;
+    long long int indexInChunk, totalIndex;
+
+    chunkSize = qureg->numAmpsPerChunk;
+    stateVecSize = chunkSize*qureg->numChunks;
+
+    qreal *stateVecReal = qureg->stateVec.real;
+    qreal *stateVecImag = qureg->stateVec.imag;
+
+    FILE *fp;
+    char line[200];
+
+    for (int rank=0; rank<(qureg->numChunks); rank++){
+        if (rank==qureg->chunkId){
+            fp = fopen(filename, "r");
+
+            // indicate file open failure
+            if (fp == NULL)
+                return 0;
+
+            indexInChunk = 0; totalIndex = 0;
+            while (fgets(line, sizeof(char)*200, fp) != NULL && totalIndex<stateVecSize){
+                if (line[0]!='#'){
+                    int chunkId = (int) (totalIndex/chunkSize);
+                    if (chunkId==qureg->chunkId){
+                        # if QuEST_PREC==1
+                        sscanf(line, "%f, %f", &(stateVecReal[indexInChunk]),
+                                &(stateVecImag[indexInChunk]));
+                        # elif QuEST_PREC==2
+                        sscanf(line, "%lf, %lf", &(stateVecReal[indexInChunk]),
+                                &(stateVecImag[indexInChunk]));
+                        # elif QuEST_PREC==4
+                        sscanf(line, "%Lf, %Lf", &(stateVecReal[indexInChunk]),
+                                &(stateVecImag[indexInChunk]));
+                        # endif
+                        indexInChunk += 1;
+                    }
+                    totalIndex += 1;
+                }
+            }
+            fclose(fp);
+        }
+        syncQuESTEnv(env);
+    }
+
+    // indicate success
+    return 1;
+}
+
+int statevec_compareStates(Qureg mq1, Qureg mq2, qreal precision){
+    qreal diff, imag1, imag2;
+    long long int chunkSize = mq1.numAmpsPerChunk;
+
+    // real-amplitude registers have zero imaginary components
+    for (long long int i=0; i<chunkSize; i++){
+        diff = absReal(mq1.stateVec.real[i] - mq2.stateVec.real[i]);
+        if (diff>precision) return 0;
+        imag1 = (mq1.isReal)? 0 : mq1.stateVec.imag[i];
+        imag2 = (mq2.isReal)? 0 : mq2.stateVec.imag[i];
+        diff = absReal(imag1 - imag2);
+        if (diff>precision) return 0;
+    }
+    return 1;
+}
+
+void statevec_compactUnitaryLocalSmall (Qureg qureg, const int targetQubit, Complex alpha, Complex beta)
+{
+    long long int indexUp,indexLo;    // current index and corresponding index in lower half block
+
+    qreal stateRealUp,stateRealLo,stateImagUp,stateImagLo;
+
+    const long long int sizeTask = (1LL << targetQubit);
+    if(sizeTask >= SIMD_WIDTH){
+        statevec_compactUnitaryLocalSIMD(qureg,targetQubit,alpha,beta);
+        //printf("simd");
+        return;
+    }
+
+    const long long int numTasks = (qureg.numAmpsPerChunk>>(1 + targetQubit)) ;
+    long long thisTask;
+
+    // Can't use qureg.stateVec as a private OMP var
+    qreal *stateVecReal = qureg.stateVec.real;
+    qreal *stateVecImag = qureg.stateVec.imag;
+    qreal alphaImag=alpha.imag, alphaReal=alpha.real;
+    qreal betaImag=beta.imag, betaReal=beta.real;
+
+# ifdef _OPENMP
+# pragma omp parallel \
+    shared   (stateVecReal,stateVecImag, alphaReal,alphaImag, betaReal,betaImag) \
+    private  (thisTask,indexUp,indexLo, stateRealUp,stateImagUp,stateRealLo,stateImagLo)
+# endif
+    {
+# ifdef _OPENMP
+# pragma omp for schedule (static)
+# endif
+        for (thisTask = 0; thisTask < numTasks; ++thisTask)
+        for (indexUp = thisTask * sizeTask * 2; indexUp < thisTask * sizeTask * 2 + sizeTask; ++ indexUp) {
+
+            indexLo     = indexUp + sizeTask;
+
+            // store current state vector values in temp variables
+            stateRealUp = stateVecReal[indexUp];
+            stateImagUp = stateVecImag[indexUp];
+
+            stateRealLo = stateVecReal[indexLo];
+            stateImagLo = stateVecImag[indexLo];
+
+            // state[indexUp] = alpha * state[indexUp] - conj(beta)  * state[indexLo]
+            stateVecReal[indexUp] = alphaReal*stateRealUp - alphaImag*stateImagUp
+                - betaReal*stateRealLo - betaImag*stateImagLo;
+            stateVecImag[indexUp] = alphaReal*stateImagUp + alphaImag*stateRealUp
+                - betaReal*stateImagLo + betaImag*stateRealLo;
+
+            // state[indexLo] = beta  * state[indexUp] + conj(alpha) * state[indexLo]
+            stateVecReal[indexLo] = betaReal*stateRealUp - betaImag*stateImagUp
+                + alphaReal*stateRealLo + alphaImag*stateImagLo;
+            stateVecImag[indexLo] = betaReal*stateImagUp + betaImag*stateRealUp
+                + alphaReal*stateImagLo - alphaImag*stateRealLo;
+        }
+    }
+
+}
+
+void statevec_compactUnitaryLocalSIMD (Qureg qureg, const int targetQubit, Complex alpha, Complex beta)
+{
+    long long int indexUp,indexLo;    // current index and corresponding index in lower half block
+
+
+    const long long int numTasks = (qureg.numAmpsPerChunk>>(1 + targetQubit)) ;
+    const long long int sizeTask = (1LL << targetQubit);
+    long long thisTask;
+
+
+    // Can't use qureg.stateVec as a private OMP var
+    qreal *stateVecReal = qureg.stateVec.real;
+    qreal *stateVecImag = qureg.stateVec.imag;
+    qreal alphaImag=alpha.imag, alphaReal=alpha.real;
+    qreal betaImag=beta.imag, betaReal=beta.real;
+
+
+    qrealSIMD stateRealUpSIMD,stateImagUpSIMD,stateRealLoSIMD,stateImagLoSIMD;
+    register const qrealSIMD alphaRealSIMD = SIMD_SET1(alphaReal);
+    register const qrealSIMD alphaImagSIMD = SIMD_SET1(alphaImag);
+    register const qrealSIMD betaRealSIMD = SIMD_SET1(betaReal);
+    register const qrealSIMD betaImagSIMD = SIMD_SET1(betaImag);
+
+
+# ifdef _OPENMP
+    if(numTasks >= omp_get_num_threads()){
+# pragma omp parallel \
+    shared   (stateVecReal,stateVecImag, alphaRealSIMD,alphaImagSIMD, betaRealSIMD,betaImagSIMD) \
+    private  (thisTask,indexUp,indexLo, stateRealUpSIMD,stateImagUpSIMD,stateRealLoSIMD,stateImagLoSIMD)
+# endif
+    {
+# ifdef _OPENMP
+# pragma omp for schedule (static)
+# endif
+        for (thisTask = 0; thisTask < numTasks; ++thisTask)
+        for (indexUp = thisTask * sizeTask * 2; indexUp < thisTask * sizeTask * 2 + sizeTask; indexUp+=SIMD_WIDTH) {
+
+            indexLo     = indexUp + sizeTask;
+
+            // store current state vector values in temp variables
+            stateRealUpSIMD = SIMD_LOAD(stateVecReal+indexUp);
+            stateImagUpSIMD = SIMD_LOAD(stateVecImag+indexUp);
+            stateRealLoSIMD = SIMD_LOAD(stateVecReal+indexLo);
+            stateImagLoSIMD = SIMD_LOAD(stateVecImag+indexLo);
+
+
+            // state[indexUp] = alpha * state[indexUp] - conj(beta)  * state[indexLo]
+            //stateVecReal[indexUp] = alphaReal*stateRealUp - alphaImag*stateImagUp
+            //    - betaReal*stateRealLo - betaImag*stateImagLo;
+            qrealSIMD res1 =  SIMD_MUL(alphaRealSIMD,stateRealUpSIMD);
+            res1 = SIMD_SUB(res1,SIMD_MUL(alphaImagSIMD,stateImagUpSIMD));
+            res1 = SIMD_SUB(res1,SIMD_MUL(betaRealSIMD,stateRealLoSIMD));
+            res1 = SIMD_SUB(res1,SIMD_MUL(betaImagSIMD,stateImagLoSIMD));
+
+
+            //stateVecImag[indexUp] = alphaReal*stateImagUp + alphaImag*stateRealUp
+            //    - betaReal*stateImagLo + betaImag*stateRealLo;
+            qrealSIMD res2 =  SIMD_MUL(alphaRealSIMD,stateImagUpSIMD);
+            res2 = SIMD_ADD(res2,SIMD_MUL(alphaImagSIMD,stateRealUpSIMD));
+            res2 = SIMD_SUB(res2,SIMD_MUL(betaRealSIMD,stateImagLoSIMD));
+            res2 = SIMD_ADD(res2,SIMD_MUL(betaImagSIMD,stateRealLoSIMD));
+
+            // state[indexLo] = beta  * state[indexUp] + conj(alpha) * state[indexLo]
+            //stateVecReal[indexLo] = betaReal*stateRealUp - betaImag*stateImagUp
+            //    + alphaReal*stateRealLo + alphaImag*stateImagLo;
+            qrealSIMD res3 = SIMD_MUL(betaRealSIMD,stateRealUpSIMD);
+            res3 = SIMD_SUB(res3,SIMD_MUL(betaImagSIMD,stateImagUpSIMD));
+            res3 = SIMD_ADD(res3,SIMD_MUL(alphaRealSIMD,stateRealLoSIMD));
+            res3 = SIMD_ADD(res3,SIMD_MUL(alphaImagSIMD,stateImagLoSIMD));
+
+            //stateVecImag[indexLo] = betaReal*stateImagUp + betaImag*stateRealUp
+            //    + alphaReal*stateImagLo - alphaImag*stateRealLo;
+            qrealSIMD res4 = SIMD_MUL(betaRealSIMD,stateImagUpSIMD);
+            res4 = SIMD_ADD(res4,SIMD_MUL(betaImagSIMD,stateRealUpSIMD));
+            res4 = SIMD_ADD(res4,SIMD_MUL(alphaRealSIMD,stateImagLoSIMD));
+            res4 = SIMD_SUB(res4,SIMD_MUL(alphaImagSIMD,stateRealLoSIMD));
+
+            SIMD_STORE(stateVecReal+indexUp,res1);
+            SIMD_STORE(stateVecImag+indexUp,res2);
+            SIMD_STORE(stateVecReal+indexLo,res3);
+            SIMD_STORE(stateVecImag+indexLo,res4);
+        }
+    }
+# ifdef _OPENMP
+    } else { 
+        for (thisTask = 0; thisTask < numTasks; ++thisTask)
+# pragma omp parallel \
+    shared   (thisTask,stateVecReal,stateVecImag, alphaRealSIMD,alphaImagSIMD, betaRealSIMD,betaImagSIMD) \
+    private  (indexUp,indexLo, stateRealUpSIMD,stateImagUpSIMD,stateRealLoSIMD,stateImagLoSIMD)
+    {
+# pragma omp for schedule (static)
+        for (indexUp = thisTask * sizeTask * 2; indexUp < thisTask * sizeTask * 2 + sizeTask; indexUp+=SIMD_WIDTH) {
+
+            indexLo     = indexUp + sizeTask;
+
+            // store current state vector values in temp variables
+            stateRealUpSIMD = SIMD_LOAD(stateVecReal+indexUp);
+            stateImagUpSIMD = SIMD_LOAD(stateVecImag+indexUp);
+            stateRealLoSIMD = SIMD_LOAD(stateVecReal+indexLo);
+            stateImagLoSIMD = SIMD_LOAD(stateVecImag+indexLo);
+
+
+            // state[indexUp] = alpha * state[indexUp] - conj(beta)  * state[indexLo]
+            //stateVecReal[indexUp] = alphaReal*stateRealUp - alphaImag*stateImagUp
+            //    - betaReal*stateRealLo - betaImag*stateImagLo;
+            qrealSIMD res1 =  SIMD_MUL(alphaRealSIMD,stateRealUpSIMD);
+            res1 = SIMD_SUB(res1,SIMD_MUL(alphaImagSIMD,stateImagUpSIMD));
+            res1 = SIMD_SUB(res1,SIMD_MUL(betaRealSIMD,stateRealLoSIMD));
+            res1 = SIMD_SUB(res1,SIMD_MUL(betaImagSIMD,stateImagLoSIMD));
+
+
+            //stateVecImag[indexUp] = alphaReal*stateImagUp + alphaImag*stateRealUp
+            //    - betaReal*stateImagLo + betaImag*stateRealLo;
+            qrealSIMD res2 =  SIMD_MUL(alphaRealSIMD,stateImagUpSIMD);
+            res2 = SIMD_ADD(res2,SIMD_MUL(alphaImagSIMD,stateRealUpSIMD));
+            res2 = SIMD_SUB(res2,SIMD_MUL(betaRealSIMD,stateImagLoSIMD));
+            res2 = SIMD_ADD(res2,SIMD_MUL(betaImagSIMD,stateRealLoSIMD));
+
+            // state[indexLo] = beta  * state[indexUp] + conj(alpha) * state[indexLo]
+            //stateVecReal[indexLo] = betaReal*stateRealUp - betaImag*stateImagUp
+            //    + alphaReal*stateRealLo + alphaImag*stateImagLo;
+            qrealSIMD res3 = SIMD_MUL(betaRealSIMD,stateRealUpSIMD);
+            res3 = SIMD_SUB(res3,SIMD_MUL(betaImagSIMD,stateImagUpSIMD));
+            res3 = SIMD_ADD(res3,SIMD_MUL(alphaRealSIMD,stateRealLoSIMD));
+            res3 = SIMD_ADD(res3,SIMD_MUL(alphaImagSIMD,stateImagLoSIMD));
+
+            //stateVecImag[indexLo] = betaReal*stateImagUp + betaImag*stateRealUp
+            //    + alphaReal*stateImagLo - alphaImag*stateRealLo;
+            qrealSIMD res4 = SIMD_MUL(betaRealSIMD,stateImagUpSIMD);
+            res4 = SIMD_ADD(res4,SIMD_MUL(betaImagSIMD,stateRealUpSIMD));
+            res4 = SIMD_ADD(res4,SIMD_MUL(alphaRealSIMD,stateImagLoSIMD));
+            res4 = SIMD_SUB(res4,SIMD_MUL(alphaImagSIMD,stateRealLoSIMD));
+
+            SIMD_STORE(stateVecReal+indexUp,res1);
+            SIMD_STORE(stateVecImag+indexUp,res2);
+            SIMD_STORE(stateVecReal+indexLo,res3);
+            SIMD_STORE(stateVecImag+indexLo,res4);
+        }
+    }
+    }
+# endif
+
+
+}
+
+void statevec_compactUnitaryLocal (Qureg qureg, const int targetQubit, Complex alpha, Complex beta)
+{
+    long long int sizeBlock, sizeHalfBlock;
+    long long int thisBlock, // current block
+         indexUp,indexLo;    // current index and corresponding index in lower half block
+
+    qreal stateRealUp,stateRealLo,stateImagUp,stateImagLo;
+    long long int thisTask;
+    const long long int numTasks=qureg.numAmpsPerChunk>>1;
+
+    // set dimensions
+    sizeHalfBlock = 1LL << targetQubit;
+    sizeBlock     = 2LL * sizeHalfBlock;
+
+    // Can't use qureg.stateVec as a private OMP var
+    qreal *stateVecReal = qureg.stateVec.real;
+    qreal *stateVecImag = qureg.stateVec.imag;
+    qreal alphaImag=alpha.imag, alphaReal=alpha.real;
+    qreal betaImag=beta.imag, betaReal=beta.real;
+
+# ifdef _OPENMP
+# pragma omp parallel \
+    shared   (sizeBlock,sizeHalfBlock, stateVecReal,stateVecImag, alphaReal,alphaImag, betaReal,betaImag) \
+    private  (thisTask,thisBlock ,indexUp,indexLo, stateRealUp,stateImagUp,stateRealLo,stateImagLo)
+# endif
+    {
+# ifdef _OPENMP
+# pragma omp for schedule (static)
+# endif
+        for (thisTask=0; thisTask<numTasks; thisTask++) {
+
+            thisBlock   = thisTask / sizeHalfBlock;
+            indexUp     = thisBlock*sizeBlock + thisTask%sizeHalfBlock;
+            indexLo     = indexUp + sizeHalfBlock;
+
+            // store current state vector values in temp variables
+            stateRealUp = stateVecReal[indexUp];
+            stateImagUp = stateVecImag[indexUp];
+
+            stateRealLo = stateVecReal[indexLo];
+            stateImagLo = stateVecImag[indexLo];
+
+            // state[indexUp] = alpha * state[indexUp] - conj(beta)  * state[indexLo]
+            stateVecReal[indexUp] = alphaReal*stateRealUp - alphaImag*stateImagUp
+                - betaReal*stateRealLo - betaImag*stateImagLo;
+            stateVecImag[indexUp] = alphaReal*stateImagUp + alphaImag*stateRealUp
+                - betaReal*stateImagLo + betaImag*stateRealLo;
+
+            // state[indexLo] = beta  * state[indexUp] + conj(alpha) * state[indexLo]
+            stateVecReal[indexLo] = betaReal*stateRealUp - betaImag*stateImagUp
+                + alphaReal*stateRealLo + alphaImag*stateImagLo;
+            stateVecImag[indexLo] = betaReal*stateImagUp + betaImag*stateRealUp
+                + alphaReal*stateImagLo - alphaImag*stateRealLo;
+        }
+    }
+
+}
+
+void statevec_multiControlledTwoQubitUnitaryLocal(Qureg qureg, long long int ctrlMask, const int q1, const int q2, ComplexMatrix4 u) {
+
+    // can't use qureg.stateVec as a private OMP var
+    qreal *reVec = qureg.stateVec.real;
+    qreal *imVec = qureg.stateVec.imag;
+
+    // the global (between all nodes) index of this node's start index
+    long long int globalIndStart = qureg.chunkId*qureg.numAmpsPerChunk;
+
+    long long int numTasks = qureg.numAmpsPerChunk >> 2; // each iteration updates 4 amplitudes
+    long long int thisTask;
+    long long int thisGlobalInd00;
+    long long int ind00, ind01, ind10, ind11;
+    qreal re00, re01, re10, re11;
+    qreal im00, im01, im10, im11;
+
+# ifdef _OPENMP
+# pragma omp parallel \
+    shared   (reVec,imVec,globalIndStart,numTasks,ctrlMask,u) \
+    private  (thisTask, thisGlobalInd00, ind00,ind01,ind10,ind11, re00,re01,re10,re11, im00,im01,im10,im11)
+# endif
+    {
+# ifdef _OPENMP
+# pragma omp for schedule (static)
+# endif
+        for (thisTask=0; thisTask<numTasks; thisTask++) {
+
+            // determine ind00 of |..0..0..>
+            ind00 = insertTwoZeroBits(thisTask, q1, q2);
+
+            // skip amplitude if controls aren't in 1 state (overloaded for speed)
+            thisGlobalInd00 = ind00 + globalIndStart;
+            if (ctrlMask && ((ctrlMask & thisGlobalInd00) != ctrlMask))
+                continue;
+
+            // inds of |..0..1..>, |..1..0..> and |..1..1..>
+            ind01 = flipBit(ind00, q1);
+            ind10 = flipBit(ind00, q2);
+            ind11 = flipBit(ind01, q2);
+
+            // extract statevec amplitudes
+            re00 = reVec[ind00]; im00 = imVec[ind00];
+            re01 = reVec[ind01]; im01 = imVec[ind01];
+            re10 = reVec[ind10]; im10 = imVec[ind10];
+            re11 = reVec[ind11]; im11 = imVec[ind11];
+
+            // apply u * {amp00, amp01, amp10, amp11}
+            reVec[ind00] =
+                u.real[0][0]*re00 - u.imag[0][0]*im00 +
+                u.real[0][1]*re01 - u.imag[0][1]*im01 +
+                u.real[0][2]*re10 - u.imag[0][2]*im10 +
+                u.real[0][3]*re11 - u.imag[0][3]*im11;
+            imVec[ind00] =
+                u.imag[0][0]*re00 + u.real[0][0]*im00 +
+                u.imag[0][1]*re01 + u.real[0][1]*im01 +
+                u.imag[0][2]*re10 + u.real[0][2]*im10 +
+                u.imag[0][3]*re11 + u.real[0][3]*im11;
+
+            reVec[ind01] =
+                u.real[1][0]*re00 - u.imag[1][0]*im00 +
+                u.real[1][1]*re01 - u.imag[1][1]*im01 +
+                u.real[1][2]*re10 - u.imag[1][2]*im10 +
+                u.real[1][3]*re11 - u.imag[1][3]*im11;
+            imVec[ind01] =
+                u.imag[1][0]*re00 + u.real[1][0]*im00 +
+                u.imag[1][1]*re01 + u.real[1][1]*im01 +
+                u.imag[1][2]*re10 + u.real[1][2]*im10 +
+                u.imag[1][3]*re11 + u.real[1][3]*im11;
+
+            reVec[ind10] =
+                u.real[2][0]*re00 - u.imag[2][0]*im00 +
+                u.real[2][1]*re01 - u.imag[2][1]*im01 +
+                u.real[2][2]*re10 - u.imag[2][2]*im10 +
+                u.real[2][3]*re11 - u.imag[2][3]*im11;
+            imVec[ind10] =
+                u.imag[2][0]*re00 + u.real[2][0]*im00 +
+                u.imag[2][1]*re01 + u.real[2][1]*im01 +
+                u.imag[2][2]*re10 + u.real[2][2]*im10 +
+                u.imag[2][3]*re11 + u.real[2][3]*im11;
+
+            reVec[ind11] =
+                u.real[3][0]*re00 - u.imag[3][0]*im00 +
+                u.real[3][1]*re01 - u.imag[3][1]*im01 +
+                u.real[3][2]*re10 - u.imag[3][2]*im10 +
+                u.real[3][3]*re11 - u.imag[3][3]*im11;
+            imVec[ind11] =
+                u.imag[3][0]*re00 + u.real[3][0]*im00 +
+                u.imag[3][1]*re01 + u.real[3][1]*im01 +
+                u.imag[3][2]*re10 + u.real[3][2]*im10 +
+                u.imag[3][3]*re11 + u.real[3][3]*im11;
+        }
+    }
+}
+
+int qsortComp(const void *a, const void *b) {
+    return *(int*)a - *(int*)b;
+}
+
+void statevec_multiControlledMultiQubitUnitaryLocal(Qureg qureg, long long int ctrlMask, int* targs, const int numTargs, ComplexMatrixN u)
+{
+    // can't use qureg.stateVec as a private OMP var
+    qreal *reVec = qureg.stateVec.real;
+    qreal *imVec = qureg.stateVec.imag;
+
+    long long int numTasks = qureg.numAmpsPerChunk >> numTargs;  // kernel called on every 1 in 2^numTargs amplitudes
+    long long int numTargAmps = 1 << u.numQubits;  // num amps to be modified by each task
+
+    // the global (between all nodes) index of this node's start index
+    long long int globalIndStart = qureg.chunkId*qureg.numAmpsPerChunk;
+
+    long long int thisTask;
+    long long int thisInd00; // this thread's index of |..0..0..> (target qubits = 0)
+    long long int thisGlobalInd00; // the global (between all nodes) index of this thread's |..0..0..> state
+    long long int ind;   // each thread's iteration of amplitudes to modify
+    int i, t, r, c;  // each thread's iteration of amps and targets
+    qreal reElem, imElem;  // each thread's iteration of u elements
+
+    // each thread/task will record and modify numTargAmps amplitudes, privately
+    // (of course, tasks eliminated by the ctrlMask won't edit their allocation)
+    long long int ampInds[numTargAmps];
+    qreal reAmps[numTargAmps];
+    qreal imAmps[numTargAmps];
+
+    // we need a sorted targets list to find thisInd00 for each task.
+    // we can't modify targets, because the user-ordering of targets matters in u
+    int sortedTargs[numTargs];
+    for (int t=0; t < numTargs; t++)
+        sortedTargs[t] = targs[t];
+    qsort(sortedTargs, numTargs, sizeof(int), qsortComp);
+
+# ifdef _OPENMP
+# pragma omp parallel \
+    shared   (reVec,imVec, numTasks,numTargAmps,globalIndStart, ctrlMask,targs,sortedTargs,u) \
+    private  (thisTask,thisInd00,thisGlobalInd00,ind,i,t,r,c,reElem,imElem,  ampInds,reAmps,imAmps)
+# endif
+    {
+# ifdef _OPENMP
+# pragma omp for schedule (static)
+# endif
+        for (thisTask=0; thisTask<numTasks; thisTask++) {
+
+            // find this task's start index (where all targs are 0)
+            thisInd00 = thisTask;
+            for (t=0; t < numTargs; t++)
+                thisInd00 = insertZeroBit(thisInd00, sortedTargs[t]);
+
+            // this task only modifies amplitudes if control qubits are 1 for this state
+            thisGlobalInd00 = thisInd00 + globalIndStart;
+            if (ctrlMask && ((ctrlMask & thisGlobalInd00) != ctrlMask))
+                continue;
+
+            // determine the indices and record values of this tasks's target amps
+            for (i=0; i < numTargAmps; i++) {
+
+                // get statevec index of current target qubit assignment
+                ind = thisInd00;
+                for (t=0; t < numTargs; t++)
+                    if (extractBit(t, i))
+                        ind = flipBit(ind, targs[t]);
+
+                // update this tasks's private arrays
+                ampInds[i] = ind;
+                reAmps [i] = reVec[ind];
+                imAmps [i] = imVec[ind];
+            }
+
+            // modify this tasks's target amplitudes
+            for (r=0; r < numTargAmps; r++) {
+                ind = ampInds[r];
+                reVec[ind] = 0;
+                imVec[ind] = 0;
+
+                for (c=0; c < numTargAmps; c++) {
+                    reElem = u.real[r][c];
+                    imElem = u.imag[r][c];
+                    reVec[ind] += reAmps[c]*reElem - imAmps[c]*imElem;
+                    imVec[ind] += reAmps[c]*imElem + imAmps[c]*reElem;
+                }
+            }
+        }
+    }
+}
+
+/** Apply the Kraus map sum_n ops[n] rho ops[n]^dagger upon targets directly, one block of 
+ * 2^numTargets x 2^numTargets elements (differing only in the targets' row and column bits) 
+ * at a time. Each block costs 2 numOps 8^numTargets flops, rather than the 16^numTargets of
+ * the equivalent superoperator. The targets' column bits must all lie within the chunk.
+ */
+void densmatr_applyMultiQubitKrausMap(Qureg qureg, int* targets, int numTargets, ComplexMatrixN* ops, int numOps)
+{
+    // can't use qureg.stateVec as a private OMP var
+    qreal *reVec = qureg.stateVec.real;
+    qreal *imVec = qureg.stateVec.imag;
+
+    const int numQubits = qureg.numQubitsRepresented;
+    const int dim = 1 << numTargets;
+    const long long int numTasks = qureg.numAmpsPerChunk >> (2*numTargets);
+
+    long long int thisTask;
+    long long int thisInd00;  // this thread's index of |..0..0..><..0..0..| (target row and column bits = 0)
+    int n, t, r, c, k;
+    qreal reSum, imSum;
+
+    // we need a sorted targets list to find thisInd00 for each task.
+    // we can't modify targets, because the user-ordering of targets matters in ops
+    int sortedTargs[numTargets];
+    for (t=0; t < numTargets; t++)
+        sortedTargs[t] = targets[t];
+    qsort(sortedTargs, numTargets, sizeof(int), qsortComp);
+
+    // offset of block row r from thisInd00, where bit t of r is the row bit of targets[t]. 
+    // The offset of block column c is rowOffsets[c] << numQubits
+    long long int rowOffsets[dim];
+    for (r=0; r < dim; r++) {
+        rowOffsets[r] = 0;
+        for (t=0; t < numTargets; t++)
+            if ((r >> t) & 1)
+                rowOffsets[r] |= 1LL << targets[t];
+    }
+
+    // each thread's block, its product with an op, and its accumulated image under the map
+    qreal reRho[dim][dim], imRho[dim][dim];
+    qreal reProd[dim][dim], imProd[dim][dim];
+    qreal reOut[dim][dim], imOut[dim][dim];
+
+# ifdef _OPENMP
+# pragma omp parallel \
+    shared   (reVec,imVec, sortedTargs,rowOffsets,ops) \
+    private  (thisTask,thisInd00,n,t,r,c,k,reSum,imSum, reRho,imRho,reProd,imProd,reOut,imOut)
+# endif
+    {
+# ifdef _OPENMP
+# pragma omp for schedule (static)
+# endif
+        for (thisTask=0; thisTask<numTasks; thisTask++) {
+
+            // find this task's start index (where all target row and column bits are 0)
+            thisInd00 = thisTask;
+            for (t=0; t < numTargets; t++)
+                thisInd00 = insertZeroBit(thisInd00, sortedTargs[t]);
+            for (t=0; t < numTargets; t++)
+                thisInd00 = insertZeroBit(thisInd00, sortedTargs[t] + numQubits);
+
+            for (r=0; r < dim; r++) {
+                for (c=0; c < dim; c++) {
+                    reRho[r][c] = reVec[thisInd00 | rowOffsets[r] | (rowOffsets[c] << numQubits)];
+                    imRho[r][c] = imVec[thisInd00 | rowOffsets[r] | (rowOffsets[c] << numQubits)];
+                    reOut[r][c] = 0;
+                    imOut[r][c] = 0;
+                }
+            }
+
+            for (n=0; n < numOps; n++) {
+
+                // prod = op rho
+                for (r=0; r < dim; r++) {
+                    for (c=0; c < dim; c++) {
+                        reSum = 0;
+                        imSum = 0;
+                        for (k=0; k < dim; k++) {
+                            reSum += ops[n].real[r][k]*reRho[k][c] - ops[n].imag[r][k]*imRho[k][c];
+                            imSum += ops[n].real[r][k]*imRho[k][c] + ops[n].imag[r][k]*reRho[k][c];
+                        }
+                        reProd[r][c] = reSum;
+                        imProd[r][c] = imSum;
+                    }
+                }
+
+                // out += prod op^dagger
+                for (r=0; r < dim; r++) {
+                    for (c=0; c < dim; c++) {
+                        reSum = 0;
+                        imSum = 0;
+                        for (k=0; k < dim; k++) {
+                            reSum += reProd[r][k]*ops[n].real[c][k] + imProd[r][k]*ops[n].imag[c][k];
+                            imSum += imProd[r][k]*ops[n].real[c][k] - reProd[r][k]*ops[n].imag[c][k];
+                        }
+                        reOut[r][c] += reSum;
+                        imOut[r][c] += imSum;
+                    }
+                }
+            }
+
+            for (r=0; r < dim; r++) {
+                for (c=0; c < dim; c++) {
+                    reVec[thisInd00 | rowOffsets[r] | (rowOffsets[c] << numQubits)] = reOut[r][c];
+                    imVec[thisInd00 | rowOffsets[r] | (rowOffsets[c] << numQubits)] = imOut[r][c];
+                }
+            }
+        }
+    }
+}
+
+void statevec_unitaryLocal(Qureg qureg, const int targetQubit, ComplexMatrix2 u)
+{
+    long long int sizeBlock, sizeHalfBlock;
+    long long int thisBlock, // current block
+         indexUp,indexLo;    // current index and corresponding index in lower half block
+
+    qreal stateRealUp,stateRealLo,stateImagUp,stateImagLo;
+    long long int thisTask;
+    const long long int numTasks=qureg.numAmpsPerChunk>>1;
+
+    // set dimensions
+    sizeHalfBlock = 1LL << targetQubit;
+    sizeBlock     = 2LL * sizeHalfBlock;
+
+    // Can't use qureg.stateVec as a private OMP var
+    qreal *stateVecReal = qureg.stateVec.real;
+    qreal *stateVecImag = qureg.stateVec.imag;
+
+# ifdef _OPENMP
+# pragma omp parallel \
+    shared   (sizeBlock,sizeHalfBlock, stateVecReal,stateVecImag, u) \
+    private  (thisTask,thisBlock ,indexUp,indexLo, stateRealUp,stateImagUp,stateRealLo,stateImagLo)
+# endif
+    {
+# ifdef _OPENMP
+# pragma omp for schedule (static)
+# endif
+        for (thisTask=0; thisTask<numTasks; thisTask++) {
+
+            thisBlock   = thisTask / sizeHalfBlock;
+            indexUp     = thisBlock*sizeBlock + thisTask%sizeHalfBlock;
+            indexLo     = indexUp + sizeHalfBlock;
+
+            // store current state vector values in temp variables
+            stateRealUp = stateVecReal[indexUp];
+            stateImagUp = stateVecImag[indexUp];
+
+            stateRealLo = stateVecReal[indexLo];
+            stateImagLo = stateVecImag[indexLo];
+
+
+            // state[indexUp] = u00 * state[indexUp] + u01 * state[indexLo]
+            stateVecReal[indexUp] = u.real[0][0]*stateRealUp - u.imag[0][0]*stateImagUp
+                + u.real[0][1]*stateRealLo - u.imag[0][1]*stateImagLo;
+            stateVecImag[indexUp] = u.real[0][0]*stateImagUp + u.imag[0][0]*stateRealUp
+                + u.real[0][1]*stateImagLo + u.imag[0][1]*stateRealLo;
+
+            // state[indexLo] = u10  * state[indexUp] + u11 * state[indexLo]
+            stateVecReal[indexLo] = u.real[1][0]*stateRealUp  - u.imag[1][0]*stateImagUp
+                + u.real[1][1]*stateRealLo  -  u.imag[1][1]*stateImagLo;
+            stateVecImag[indexLo] = u.real[1][0]*stateImagUp + u.imag[1][0]*stateRealUp
+                + u.real[1][1]*stateImagLo + u.imag[1][1]*stateRealLo;
+
+        }
+    }
+}
+
+/** Rotate a single qubit in the state vector of probability amplitudes,
+ * given two complex numbers alpha and beta,
+ * and a subset of the state vector with upper and lower block values stored seperately.
+ *
+ *  @param[in,out] qureg object representing the set of qubits
+ *  @param[in] rot1 rotation angle
+ *  @param[in] rot2 rotation angle
+ *  @param[in] stateVecUp probability amplitudes in upper half of a block
+ *  @param[in] stateVecLo probability amplitudes in lower half of a block
+ *  @param[out] stateVecOut array section to update (will correspond to either the lower or upper half of a block)
+ */
+void statevec_compactUnitaryDistributed (Qureg qureg,
+        Complex rot1, Complex rot2,
+        ComplexArray stateVecUp,
+        ComplexArray stateVecLo,
+        ComplexArray stateVecOut)
+{
+
+    qreal   stateRealUp,stateRealLo,stateImagUp,stateImagLo;
+    long long int thisTask;
+    const long long int numTasks=qureg.numAmpsPerChunk;
+    if(numTasks >= SIMD_WIDTH){
+        statevec_compactUnitaryDistributedSIMD(qureg,rot1,rot2,stateVecUp,stateVecLo,stateVecOut);
+        return ;
+    }
+
+    qreal rot1Real=rot1.real, rot1Imag=rot1.imag;
+    qreal rot2Real=rot2.real, rot2Imag=rot2.imag;
+    qreal *stateVecRealUp=stateVecUp.real, *stateVecImagUp=stateVecUp.imag;
+    qreal *stateVecRealLo=stateVecLo.real, *stateVecImagLo=stateVecLo.imag;
+    qreal *stateVecRealOut=stateVecOut.real, *stateVecImagOut=stateVecOut.imag;
+
+# ifdef _OPENMP
+# pragma omp parallel \
+    shared   (stateVecRealUp,stateVecImagUp,stateVecRealLo,stateVecImagLo,stateVecRealOut,stateVecImagOut, \
+            rot1Real,rot1Imag, rot2Real,rot2Imag) \
+    private  (thisTask,stateRealUp,stateImagUp,stateRealLo,stateImagLo)
+# endif
+    {
+# ifdef _OPENMP
+# pragma omp for schedule (static)
+# endif
+        for (thisTask=0; thisTask<numTasks; thisTask++) {
+            // store current state vector values in temp variables
+            stateRealUp = stateVecRealUp[thisTask];
+            stateImagUp = stateVecImagUp[thisTask];
+
+            stateRealLo = stateVecRealLo[thisTask];
+            stateImagLo = stateVecImagLo[thisTask];
+
+            // state[indexUp] = alpha * state[indexUp] - conj(beta)  * state[indexLo]
+            stateVecRealOut[thisTask] = rot1Real*stateRealUp - rot1Imag*stateImagUp + rot2Real*stateRealLo + rot2Imag*stateImagLo;
+            stateVecImagOut[thisTask] = rot1Real*stateImagUp + rot1Imag*stateRealUp + rot2Real*stateImagLo - rot2Imag*stateRealLo;
+        }
+    }
+}
+
+void statevec_compactUnitaryDistributedSIMD (Qureg qureg,
+        Complex rot1, Complex rot2,
+        ComplexArray stateVecUp,
+        ComplexArray stateVecLo,
+        ComplexArray stateVecOut)
+{
+
+    long long int thisTask;
+    const long long int numTasks=qureg.numAmpsPerChunk;
+
+    qreal rot1Real=rot1.real, rot1Imag=rot1.imag;
+    qreal rot2Real=rot2.real, rot2Imag=rot2.imag;
+    qreal *stateVecRealUp=stateVecUp.real, *stateVecImagUp=stateVecUp.imag;
+    qreal *stateVecRealLo=stateVecLo.real, *stateVecImagLo=stateVecLo.imag;
+    qreal *stateVecRealOut=stateVecOut.real, *stateVecImagOut=stateVecOut.imag;
+
+    qrealSIMD stateRealUpSIMD,stateRealLoSIMD,stateImagUpSIMD,stateImagLoSIMD;
+    register const qrealSIMD rot1RealSIMD = SIMD_SET1(rot1Real);
+    register const qrealSIMD rot1ImagSIMD = SIMD_SET1(rot1Imag);
+    register const qrealSIMD rot2RealSIMD = SIMD_SET1(rot2Real);
+    register const qrealSIMD rot2ImagSIMD = SIMD_SET1(rot2Imag);
+
+# ifdef _OPENMP
+# pragma omp parallel \
+    shared   (stateVecRealUp,stateVecImagUp,stateVecRealLo,stateVecImagLo,stateVecRealOut,stateVecImagOut, \
+            rot1RealSIMD,rot1ImagSIMD, rot2RealSIMD,rot2ImagSIMD) \
+    private  (thisTask,stateRealUpSIMD,stateImagUpSIMD,stateRealLoSIMD,stateImagLoSIMD)
+# endif
+    {
+# ifdef _OPENMP
+# pragma omp for schedule (static)
+# endif
+        for (thisTask=0; thisTask<numTasks; thisTask+=SIMD_WIDTH) {
+            // store current state vector values in temp variables
+            stateRealUpSIMD = SIMD_LOAD(stateVecRealUp+thisTask);
+            stateImagUpSIMD = SIMD_LOAD(stateVecImagUp+thisTask);
+
+            stateRealLoSIMD = SIMD_LOAD(stateVecRealLo+thisTask);
+            stateImagLoSIMD = SIMD_LOAD(stateVecImagLo+thisTask);
+
+            // state[indexUp] = alpha * state[indexUp] - conj(beta)  * state[indexLo]
+            //stateVecRealOut[thisTask] = rot1Real*stateRealUp - rot1Imag*stateImagUp + rot2Real*stateRealLo + rot2Imag*stateImagLo;
+            //stateVecImagOut[thisTask] = rot1Real*stateImagUp + rot1Imag*stateRealUp + rot2Real*stateImagLo - rot2Imag*stateRealLo;
+            SIMD_STORE(stateVecRealOut+thisTask, SIMD_ADD( \
+                                SIMD_SUB(SIMD_MUL(rot1RealSIMD,stateRealUpSIMD),SIMD_MUL(rot1ImagSIMD,stateImagUpSIMD)), \
+                                SIMD_ADD(SIMD_MUL(rot2RealSIMD,stateRealLoSIMD),SIMD_MUL(rot2ImagSIMD,stateImagLoSIMD))));
+
+            SIMD_STORE(stateVecImagOut+thisTask, SIMD_ADD( \
+                                SIMD_ADD(SIMD_MUL(rot1RealSIMD,stateImagUpSIMD),SIMD_MUL(rot1ImagSIMD,stateRealUpSIMD)), \
+                                SIMD_SUB(SIMD_MUL(rot2RealSIMD,stateImagLoSIMD),SIMD_MUL(rot2ImagSIMD,stateRealLoSIMD))));
+        }
+    }
+}
+
+/** Apply a unitary operation to a single qubit
+ *  given a subset of the state vector with upper and lower block values
+ * stored seperately.
+ *
+ *  @remarks Qubits are zero-based and the first qubit is the rightmost
+ *
+ *  @param[in,out] qureg object representing the set of qubits
+ *  @param[in] u unitary matrix to apply
+ *  @param[in] stateVecUp probability amplitudes in upper half of a block
+ *  @param[in] stateVecLo probability amplitudes in lower half of a block
+ *  @param[out] stateVecOut array section to update (will correspond to either the lower or upper half of a block)
+ */
+void statevec_unitaryDistributed (Qureg qureg,
+        Complex rot1, Complex rot2,
+        ComplexArray stateVecUp,
+        ComplexArray stateVecLo,
+        ComplexArray stateVecOut)
+{
+
+    qreal   stateRealUp,stateRealLo,stateImagUp,stateImagLo;
+    long long int thisTask;
+    const long long int numTasks=qureg.numAmpsPerChunk;
+
+    qreal rot1Real=rot1.real, rot1Imag=rot1.imag;
+    qreal rot2Real=rot2.real, rot2Imag=rot2.imag;
+    qreal *stateVecRealUp=stateVecUp.real, *stateVecImagUp=stateVecUp.imag;
+    qreal *stateVecRealLo=stateVecLo.real, *stateVecImagLo=stateVecLo.imag;
+    qreal *stateVecRealOut=stateVecOut.real, *stateVecImagOut=stateVecOut.imag;
+
+
+# ifdef _OPENMP
+# pragma omp parallel \
+    shared   (stateVecRealUp,stateVecImagUp,stateVecRealLo,stateVecImagLo,stateVecRealOut,stateVecImagOut, \
+            rot1Real, rot1Imag, rot2Real, rot2Imag) \
+    private  (thisTask,stateRealUp,stateImagUp,stateRealLo,stateImagLo)
+# endif
+    {
+# ifdef _OPENMP
+# pragma omp for schedule (static)
+# endif
+        for (thisTask=0; thisTask<numTasks; thisTask++) {
+            // store current state vector values in temp variables
+            stateRealUp = stateVecRealUp[thisTask];
+            stateImagUp = stateVecImagUp[thisTask];
+
+            stateRealLo = stateVecRealLo[thisTask];
+            stateImagLo = stateVecImagLo[thisTask];
+
+            stateVecRealOut[thisTask] = rot1Real*stateRealUp - rot1Imag*stateImagUp
+                + rot2Real*stateRealLo - rot2Imag*stateImagLo;
+            stateVecImagOut[thisTask] = rot1Real*stateImagUp + rot1Imag*stateRealUp
+                + rot2Real*stateImagLo + rot2Imag*stateRealLo;
+        }
+    }
+}
+
+
+void statevec_controlledCompactUnitaryLocalAllSmallSIMD (Qureg qureg, const int controlQubit, const int targetQubit,
+        Complex alpha, Complex beta)
+{
+    long long int indexUp,indexLo;    // current index and corresponding index in lower half block
+
+    const long long int numTasks = (qureg.numAmpsPerChunk>>(1 + targetQubit)) ;
+    const long long int sizeTask = (1LL << targetQubit);
+    long long thisTask;
+
+    // Can't use qureg.stateVec as a private OMP var
+    qreal *stateVecReal = qureg.stateVec.real;
+    qreal *stateVecImag = qureg.stateVec.imag;
+    qreal alphaImag=alpha.imag, alphaReal=alpha.real;
+    qreal betaImag=beta.imag, betaReal=beta.real;
+
+    qrealSIMD stateRealUpSIMD,stateImagUpSIMD,stateRealLoSIMD,stateImagLoSIMD;
+    register const qrealSIMD alphaRealSIMD = SIMD_SET1(alphaReal);
+    register const qrealSIMD alphaImagSIMD = SIMD_SET1(alphaImag);
+    register const qrealSIMD betaRealSIMD = SIMD_SET1(betaReal);
+    register const qrealSIMD betaImagSIMD = SIMD_SET1(betaImag); 
+
+# ifdef _OPENMP
+    if(numTasks >= omp_get_num_threads()){
+# pragma omp parallel \
+    shared   (stateVecReal,stateVecImag,alphaRealSIMD,alphaImagSIMD, betaRealSIMD,betaImagSIMD) \
+    private  (thisTask,indexUp,indexLo,stateRealUpSIMD,stateImagUpSIMD,stateRealLoSIMD,stateImagLoSIMD)
+# endif
+    {
+# ifdef _OPENMP
+# pragma omp for schedule (static)
+# endif
+        for (thisTask = 0; thisTask < numTasks; ++thisTask)
+        for (indexUp = thisTask * sizeTask * 2; indexUp < thisTask * sizeTask * 2 + sizeTask; indexUp+=SIMD_WIDTH) {
+
+                indexLo     = indexUp + sizeTask;
+
+                    // controlBit = extractBit (controlQubit, indexUp+chunkId*chunkSize);
+                    // if (controlBit){
+                    // store current state vector values in temp variables
+                    stateRealUpSIMD = SIMD_LOAD(stateVecReal+indexUp);
+                    stateImagUpSIMD = SIMD_LOAD(stateVecImag+indexUp);
+                    stateRealLoSIMD = SIMD_LOAD(stateVecReal+indexLo);
+                    stateImagLoSIMD = SIMD_LOAD(stateVecImag+indexLo);
+
+                    // state[indexUp] = alpha * state[indexUp] - conj(beta)  * state[indexLo]
+                    //stateVecReal[indexUp] = alphaReal*stateRealUp - alphaImag*stateImagUp
+                    //    - betaReal*stateRealLo - betaImag*stateImagLo;
+                    qrealSIMD res1 =  SIMD_MUL(alphaRealSIMD,stateRealUpSIMD);
+                    res1 = SIMD_SUB(res1,SIMD_MUL(alphaImagSIMD,stateImagUpSIMD));
+                    res1 = SIMD_SUB(res1,SIMD_MUL(betaRealSIMD,stateRealLoSIMD));
+                    res1 = SIMD_SUB(res1,SIMD_MUL(betaImagSIMD,stateImagLoSIMD));
+
+
+                    //stateVecImag[indexUp] = alphaReal*stateImagUp + alphaImag*stateRealUp
+                    //    - betaReal*stateImagLo + betaImag*stateRealLo;
+                    qrealSIMD res2 =  SIMD_MUL(alphaRealSIMD,stateImagUpSIMD);
+                    res2 = SIMD_ADD(res2,SIMD_MUL(alphaImagSIMD,stateRealUpSIMD));
+                    res2 = SIMD_SUB(res2,SIMD_MUL(betaRealSIMD,stateImagLoSIMD));
+                    res2 = SIMD_ADD(res2,SIMD_MUL(betaImagSIMD,stateRealLoSIMD));
+
+                    // state[indexLo] = beta  * state[indexUp] + conj(alpha) * state[indexLo]
+                    //stateVecReal[indexLo] = betaReal*stateRealUp - betaImag*stateImagUp
+                    //    + alphaReal*stateRealLo + alphaImag*stateImagLo;
+                    qrealSIMD res3 = SIMD_MUL(betaRealSIMD,stateRealUpSIMD);
+                    res3 = SIMD_SUB(res3,SIMD_MUL(betaImagSIMD,stateImagUpSIMD));
+                    res3 = SIMD_ADD(res3,SIMD_MUL(alphaRealSIMD,stateRealLoSIMD));
+                    res3 = SIMD_ADD(res3,SIMD_MUL(alphaImagSIMD,stateImagLoSIMD));
+
+                    //stateVecImag[indexLo] = betaReal*stateImagUp + betaImag*stateRealUp
+                    //    + alphaReal*stateImagLo - alphaImag*stateRealLo;
+                    qrealSIMD res4 = SIMD_MUL(betaRealSIMD,stateImagUpSIMD);
+                    res4 = SIMD_ADD(res4,SIMD_MUL(betaImagSIMD,stateRealUpSIMD));
+                    res4 = SIMD_ADD(res4,SIMD_MUL(alphaRealSIMD,stateImagLoSIMD));
+                    res4 = SIMD_SUB(res4,SIMD_MUL(alphaImagSIMD,stateRealLoSIMD));
+
+                    SIMD_STORE(stateVecReal+indexUp,res1);
+                    SIMD_STORE(stateVecImag+indexUp,res2);
+                    SIMD_STORE(stateVecReal+indexLo,res3);
+                    SIMD_STORE(stateVecImag+indexLo,res4);
+                    // }        }
+    }
+    }
+# ifdef _OPENMP
+    }else {
+        for (thisTask = 0; thisTask < numTasks; ++thisTask)
+
+# pragma omp parallel \
+    shared   (thisTask,stateVecReal,stateVecImag,alphaRealSIMD,alphaImagSIMD, betaRealSIMD,betaImagSIMD) \
+    private  (indexUp,indexLo, stateRealUpSIMD,stateImagUpSIMD,stateRealLoSIMD,stateImagLoSIMD)
+    {
+# pragma omp for schedule (static)
+        for (indexUp = thisTask * sizeTask * 2; indexUp < thisTask * sizeTask * 2 + sizeTask; indexUp+=SIMD_WIDTH) {
+
+                indexLo     = indexUp + sizeTask;
+
+                    // controlBit = extractBit (controlQubit, indexUp+chunkId*chunkSize);
+                    // if (controlBit){
+                    // store current state vector values in temp variables
+                    stateRealUpSIMD = SIMD_LOAD(stateVecReal+indexUp);
+                    stateImagUpSIMD = SIMD_LOAD(stateVecImag+indexUp);
+                    stateRealLoSIMD = SIMD_LOAD(stateVecReal+indexLo);
+                    stateImagLoSIMD = SIMD_LOAD(stateVecImag+indexLo);
+
+                    // state[indexUp] = alpha * state[indexUp] - conj(beta)  * state[indexLo]
+                    //stateVecReal[indexUp] = alphaReal*stateRealUp - alphaImag*stateImagUp
+                    //    - betaReal*stateRealLo - betaImag*stateImagLo;
+                    qrealSIMD res1 =  SIMD_MUL(alphaRealSIMD,stateRealUpSIMD);
+                    res1 = SIMD_SUB(res1,SIMD_MUL(alphaImagSIMD,stateImagUpSIMD));
+                    res1 = SIMD_SUB(res1,SIMD_MUL(betaRealSIMD,stateRealLoSIMD));
+                    res1 = SIMD_SUB(res1,SIMD_MUL(betaImagSIMD,stateImagLoSIMD));
+
+
+                    //stateVecImag[indexUp] = alphaReal*stateImagUp + alphaImag*stateRealUp
+                    //    - betaReal*stateImagLo + betaImag*stateRealLo;
+                    qrealSIMD res2 =  SIMD_MUL(alphaRealSIMD,stateImagUpSIMD);
+                    res2 = SIMD_ADD(res2,SIMD_MUL(alphaImagSIMD,stateRealUpSIMD));
+                    res2 = SIMD_SUB(res2,SIMD_MUL(betaRealSIMD,stateImagLoSIMD));
+                    res2 = SIMD_ADD(res2,SIMD_MUL(betaImagSIMD,stateRealLoSIMD));
+
+                    // state[indexLo] = beta  * state[indexUp] + conj(alpha) * state[indexLo]
+                    //stateVecReal[indexLo] = betaReal*stateRealUp - betaImag*stateImagUp
+                    //    + alphaReal*stateRealLo + alphaImag*stateImagLo;
+                    qrealSIMD res3 = SIMD_MUL(betaRealSIMD,stateRealUpSIMD);
+                    res3 = SIMD_SUB(res3,SIMD_MUL(betaImagSIMD,stateImagUpSIMD));
+                    res3 = SIMD_ADD(res3,SIMD_MUL(alphaRealSIMD,stateRealLoSIMD));
+                    res3 = SIMD_ADD(res3,SIMD_MUL(alphaImagSIMD,stateImagLoSIMD));
+
+                    //stateVecImag[indexLo] = betaReal*stateImagUp + betaImag*stateRealUp
+                    //    + alphaReal*stateImagLo - alphaImag*stateRealLo;
+                    qrealSIMD res4 = SIMD_MUL(betaRealSIMD,stateImagUpSIMD);
+                    res4 = SIMD_ADD(res4,SIMD_MUL(betaImagSIMD,stateRealUpSIMD));
+                    res4 = SIMD_ADD(res4,SIMD_MUL(alphaRealSIMD,stateImagLoSIMD));
+                    res4 = SIMD_SUB(res4,SIMD_MUL(alphaImagSIMD,stateRealLoSIMD));
+
+                    SIMD_STORE(stateVecReal+indexUp,res1);
+                    SIMD_STORE(stateVecImag+indexUp,res2);
+                    SIMD_STORE(stateVecReal+indexLo,res3);
+                    SIMD_STORE(stateVecImag+indexLo,res4);
+                    // }        }
+        }
+    }
+    }
+# endif
+}
+
+void statevec_controlledCompactUnitaryLocalAllSmall (Qureg qureg, const int controlQubit, const int targetQubit,
+        Complex alpha, Complex beta)
+{
+    long long int indexUp,indexLo;    // current index and corresponding index in lower half block
+
+    qreal stateRealUp,stateRealLo,stateImagUp,stateImagLo;
+    const long long int numTasks = (qureg.numAmpsPerChunk>>(1 + targetQubit)) ;
+    const long long int sizeTask = (1LL << targetQubit);
+    long long thisTask;
+
+    // Can't use qureg.stateVec as a private OMP var
+    qreal *stateVecReal = qureg.stateVec.real;
+    qreal *stateVecImag = qureg.stateVec.imag;
+    qreal alphaImag=alpha.imag, alphaReal=alpha.real;
+    qreal betaImag=beta.imag, betaReal=beta.real;
+
+# ifdef _OPENMP
+    if(numTasks >= omp_get_num_threads()){
+# pragma omp parallel \
+    shared   (stateVecReal,stateVecImag) \
+    private  (thisTask,indexUp,indexLo, stateRealUp,stateImagUp)
+# endif
+    {
+# ifdef _OPENMP
+# pragma omp for schedule (static)
+# endif
+        for (thisTask = 0; thisTask < numTasks; ++thisTask)
+        for (indexUp = thisTask * sizeTask * 2; indexUp < thisTask * sizeTask * 2 + sizeTask; ++ indexUp) {
+
+            indexLo     = indexUp + sizeTask;
+
+                // store current state vector values in temp variables
+                stateRealUp = stateVecReal[indexUp];
+                stateImagUp = stateVecImag[indexUp];
+
+                stateRealLo = stateVecReal[indexLo];
+                stateImagLo = stateVecImag[indexLo];
+
+                // state[indexUp] = alpha * state[indexUp] - conj(beta)  * state[indexLo]
+                stateVecReal[indexUp] = alphaReal*stateRealUp - alphaImag*stateImagUp
+                    - betaReal*stateRealLo - betaImag*stateImagLo;
+                stateVecImag[indexUp] = alphaReal*stateImagUp + alphaImag*stateRealUp
+                    - betaReal*stateImagLo + betaImag*stateRealLo;
+
+                // state[indexLo] = beta  * state[indexUp] + conj(alpha) * state[indexLo]
+                stateVecReal[indexLo] = betaReal*stateRealUp - betaImag*stateImagUp
+                    + alphaReal*stateRealLo + alphaImag*stateImagLo;
+                stateVecImag[indexLo] = betaReal*stateImagUp + betaImag*stateRealUp
+                    + alphaReal*stateImagLo - alphaImag*stateRealLo;
+        }
+    }
+# ifdef _OPENMP
+    }else {
+        for (thisTask = 0; thisTask < numTasks; ++thisTask)
+
+# pragma omp parallel \
+    shared   (thisTask,stateVecReal,stateVecImag) \
+    private  (indexUp,indexLo, stateRealUp,stateImagUp)
+    {
+# pragma omp for schedule (static)
+        for (indexUp = thisTask * sizeTask * 2; indexUp < thisTask * sizeTask * 2 + sizeTask; ++ indexUp) {
+
+            indexLo     = indexUp + sizeTask;
+
+                // store current state vector values in temp variables
+                stateRealUp = stateVecReal[indexUp];
+                stateImagUp = stateVecImag[indexUp];
+
+                stateRealLo = stateVecReal[indexLo];
+                stateImagLo = stateVecImag[indexLo];
+
+                // state[indexUp] = alpha * state[indexUp] - conj(beta)  * state[indexLo]
+                stateVecReal[indexUp] = alphaReal*stateRealUp - alphaImag*stateImagUp
+                    - betaReal*stateRealLo - betaImag*stateImagLo;
+                stateVecImag[indexUp] = alphaReal*stateImagUp + alphaImag*stateRealUp
+                    - betaReal*stateImagLo + betaImag*stateRealLo;
+
+                // state[indexLo] = beta  * state[indexUp] + conj(alpha) * state[indexLo]
+                stateVecReal[indexLo] = betaReal*stateRealUp - betaImag*stateImagUp
+                    + alphaReal*stateRealLo + alphaImag*stateImagLo;
+                stateVecImag[indexLo] = betaReal*stateImagUp + betaImag*stateRealUp
+                    + alphaReal*stateImagLo - alphaImag*stateRealLo;
+        }
+    }
+    }
+# endif
+}
+
+
+void statevec_controlledCompactUnitaryLocalAll (Qureg qureg, const int controlQubit, const int targetQubit,
+        Complex alpha, Complex beta)
+{
+    long long int sizeBlock, sizeHalfBlock;
+    long long int thisBlock, // current block
+         indexUp,indexLo;    // current index and corresponding index in lower half block
+
+    qreal stateRealUp,stateRealLo,stateImagUp,stateImagLo;
+    long long int thisTask;
+    const long long int numTasks=qureg.numAmpsPerChunk>>1;
+
+    // set dimensions
+    sizeHalfBlock = 1LL << targetQubit;
+    sizeBlock     = 2LL * sizeHalfBlock;
+
+    // Can't use qureg.stateVec as a private OMP var
+    qreal *stateVecReal = qureg.stateVec.real;
+    qreal *stateVecImag = qureg.stateVec.imag;
+    qreal alphaImag=alpha.imag, alphaReal=alpha.real;
+    qreal betaImag=beta.imag, betaReal=beta.real;
+    
+# ifdef _OPENMP
+# pragma omp parallel \
+    shared   (sizeBlock,sizeHalfBlock, stateVecReal,stateVecImag, alphaReal,alphaImag, betaReal,betaImag) \
+    private  (thisTask,thisBlock ,indexUp,indexLo, stateRealUp,stateImagUp,stateRealLo,stateImagLo)
+# endif
+    {
+# ifdef _OPENMP
+# pragma omp for schedule (static)
+# endif
+        for (thisTask=0; thisTask<numTasks; thisTask++) {
+
+            thisBlock   = thisTask / sizeHalfBlock;
+            indexUp     = thisBlock*sizeBlock + thisTask%sizeHalfBlock;
+            indexLo     = indexUp + sizeHalfBlock;
+
+                // store current state vector values in temp variables
+                stateRealUp = stateVecReal[indexUp];
+                stateImagUp = stateVecImag[indexUp];
+
+                stateRealLo = stateVecReal[indexLo];
+                stateImagLo = stateVecImag[indexLo];
+
+                // state[indexUp] = alpha * state[indexUp] - conj(beta)  * state[indexLo]
+                stateVecReal[indexUp] = alphaReal*stateRealUp - alphaImag*stateImagUp
+                    - betaReal*stateRealLo - betaImag*stateImagLo;
+                stateVecImag[indexUp] = alphaReal*stateImagUp + alphaImag*stateRealUp
+                    - betaReal*stateImagLo + betaImag*stateRealLo;
+
+                // state[indexLo] = beta  * state[indexUp] + conj(alpha) * state[indexLo]
+                stateVecReal[indexLo] = betaReal*stateRealUp - betaImag*stateImagUp
+                    + alphaReal*stateRealLo + alphaImag*stateImagLo;
+                stateVecImag[indexLo] = betaReal*stateImagUp + betaImag*stateRealUp
+                    + alphaReal*stateImagLo - alphaImag*stateRealLo;
+
+        }
+    }
+
+}
+
+void statevec_controlledCompactUnitaryLocalSmall (Qureg qureg, const int controlQubit, const int targetQubit,
+        Complex alpha, Complex beta)
+{
+
+    if((1LL<<controlQubit)>=qureg.numAmpsPerChunk) {
+        if(extractBit(controlQubit,qureg.chunkId*qureg.numAmpsPerChunk)) {
+            statevec_controlledCompactUnitaryLocalAllSmall(qureg,controlQubit,targetQubit,alpha,beta);
+        }
+        return ;
+    }
+    long long int sizeBlock, sizeHalfBlock;
+    long long int thisBlock, // current block
+         indexUp,indexLo;    // current index and corresponding index in lower half block
+
+    qreal stateRealUp,stateRealLo,stateImagUp,stateImagLo;
+    long long int thisTask;
+
+    const long long int sizeTask = ((targetQubit > controlQubit) ? (1LL << controlQubit) : (1LL << targetQubit));
+    if(sizeTask >= SIMD_WIDTH){
+        statevec_controlledCompactUnitaryLocalSIMD(qureg,controlQubit,targetQubit,alpha,beta);
+        //printf("simd");
+        return;
+    }
+
+    const long long int numTasks = ((targetQubit > controlQubit) ? (1LL << (targetQubit - controlQubit - 1)) : (1LL << (controlQubit - targetQubit - 1)));
+    // const long long int chunkSize=qureg.numAmpsPerChunk;
+    // const long long int chunkId=qureg.chunkId;
+    const long long int numBlocks = ((targetQubit > controlQubit) ? (qureg.numAmpsPerChunk>>(1 + targetQubit)) : (qureg.numAmpsPerChunk>>(1 + controlQubit)));
+    const long long int blockOffset = 1LL << controlQubit;
+
+    // set dimensions
+    sizeHalfBlock = 1LL << targetQubit;
+    sizeBlock = ((targetQubit > controlQubit) ? (2LL * sizeHalfBlock) : (2LL << controlQubit));
+
+    // Can't use qureg.stateVec as a private OMP var
+    qreal *stateVecReal = qureg.stateVec.real;
+    qreal *stateVecImag = qureg.stateVec.imag;
+    qreal alphaImag=alpha.imag, alphaReal=alpha.real;
+    qreal betaImag=beta.imag, betaReal=beta.real;
+
+# ifdef _OPENMP
+    if(numBlocks >= omp_get_num_threads()){
+# pragma omp parallel \
+    shared   (sizeBlock,sizeHalfBlock, stateVecReal,stateVecImag, alphaReal,alphaImag, betaReal,betaImag) \
+    private  (thisTask,thisBlock ,indexUp,indexLo, stateRealUp,stateImagUp,stateRealLo,stateImagLo)
 # endif
     {
 # ifdef _OPENMP
 # pragma omp for schedule (static)
 # endif
-        for (index=0; index<stateVecSize; index++) {
-            stateVecReal[index] = 0.0;
-            stateVecImag[index] = 0.0;
+        for (thisBlock = 0; thisBlock < numBlocks; ++thisBlock) {
+            for(thisTask = 0; thisTask < numTasks; ++thisTask)
+            for(indexUp = thisBlock * sizeBlock + sizeTask * thisTask * 2 + blockOffset; indexUp < thisBlock * sizeBlock + sizeTask * thisTask * 2 + sizeTask + blockOffset; ++indexUp) {
+            // for(indexUp = thisBlock * sizeBlock; indexUp < thisBlock * sizeBlock + sizeHalfBlock; ++indexUp) {
+
+                indexLo     = indexUp + sizeHalfBlock;
+             //   if(thisBlock != thisTask / sizeHalfBlock) exit(1);
+             //   if(indexUp != thisBlock*sizeBlock + thisTask%sizeHalfBlock) exit(2);
+             //   if(indexLo != indexUp + sizeHalfBlock) exit(3);
+
+//                int controlBit = extractBit (controlQubit, indexUp+chunkId*chunkSize);
+//                if (controlBit){
+                    // store current state vector values in temp variables
+                    stateRealUp = stateVecReal[indexUp];
+                    stateImagUp = stateVecImag[indexUp];
+
+                    stateRealLo = stateVecReal[indexLo];
+                    stateImagLo = stateVecImag[indexLo];
+
+                    // state[indexUp] = alpha * state[indexUp] - conj(beta)  * state[indexLo]
+                    stateVecReal[indexUp] = alphaReal*stateRealUp - alphaImag*stateImagUp
+                        - betaReal*stateRealLo - betaImag*stateImagLo;
+                    stateVecImag[indexUp] = alphaReal*stateImagUp + alphaImag*stateRealUp
+                        - betaReal*stateImagLo + betaImag*stateRealLo;
+
+                    // state[indexLo] = beta  * state[indexUp] + conj(alpha) * state[indexLo]
+                    stateVecReal[indexLo] = betaReal*stateRealUp - betaImag*stateImagUp
+                        + alphaReal*stateRealLo + alphaImag*stateImagLo;
+                    stateVecImag[indexLo] = betaReal*stateImagUp + betaImag*stateRealUp
+                        + alphaReal*stateImagLo - alphaImag*stateRealLo;
+//                }
+            }
+        }
+    }
+# ifdef _OPENMP
+    } else {
+        for (thisBlock = 0; thisBlock < numBlocks; ++thisBlock) {
+# pragma omp parallel \
+    shared   (sizeBlock,thisBlock,sizeHalfBlock, stateVecReal,stateVecImag, alphaReal,alphaImag, betaReal,betaImag) \
+    private  (thisTask ,indexUp,indexLo, stateRealUp,stateImagUp,stateRealLo,stateImagLo)
+    {
+# pragma omp for schedule (static)
+            for(thisTask = 0; thisTask < numTasks; ++thisTask)
+            for(indexUp = thisBlock * sizeBlock + sizeTask * thisTask * 2 + blockOffset; indexUp < thisBlock * sizeBlock + sizeTask * thisTask * 2 + sizeTask + blockOffset; ++indexUp) {
+            // for(indexUp = thisBlock * sizeBlock; indexUp < thisBlock * sizeBlock + sizeHalfBlock; ++indexUp) {
+
+                indexLo     = indexUp + sizeHalfBlock;
+             //   if(thisBlock != thisTask / sizeHalfBlock) exit(1);
+             //   if(indexUp != thisBlock*sizeBlock + thisTask%sizeHalfBlock) exit(2);
+             //   if(indexLo != indexUp + sizeHalfBlock) exit(3);
+
+//                int controlBit = extractBit (controlQubit, indexUp+chunkId*chunkSize);
+//                if (controlBit){
+                    // store current state vector values in temp variables
+                    stateRealUp = stateVecReal[indexUp];
+                    stateImagUp = stateVecImag[indexUp];
+
+                    stateRealLo = stateVecReal[indexLo];
+                    stateImagLo = stateVecImag[indexLo];
+
+                    // state[indexUp] = alpha * state[indexUp] - conj(beta)  * state[indexLo]
+                    stateVecReal[indexUp] = alphaReal*stateRealUp - alphaImag*stateImagUp
+                        - betaReal*stateRealLo - betaImag*stateImagLo;
+                    stateVecImag[indexUp] = alphaReal*stateImagUp + alphaImag*stateRealUp
+                        - betaReal*stateImagLo + betaImag*stateRealLo;
+
+                    // state[indexLo] = beta  * state[indexUp] + conj(alpha) * state[indexLo]
+                    stateVecReal[indexLo] = betaReal*stateRealUp - betaImag*stateImagUp
+                        + alphaReal*stateRealLo + alphaImag*stateImagLo;
+                    stateVecImag[indexLo] = betaReal*stateImagUp + betaImag*stateRealUp
+                        + alphaReal*stateImagLo - alphaImag*stateRealLo;
+//                }
+            }
         }
     }
+    }
+# endif
 }
 
-void statevec_initZeroState (Qureg qureg)
+void statevec_controlledCompactUnitaryLocalSIMD (Qureg qureg, const int controlQubit, const int targetQubit,
+        Complex alpha, Complex beta)
 {
-    statevec_initBlankState(qureg);
-    if (qureg.chunkId==0){
-        // zero state |0000..0000> has probability 1
-        qureg.stateVec.real[0] = 1.0;
-        qureg.stateVec.imag[0] = 0.0;
+    long long int sizeBlock, sizeHalfBlock;
+    long long int thisBlock, // current block
+         indexUp,indexLo;    // current index and corresponding index in lower half block
+
+    long long int thisTask;
+    const long long int numTasks = ((targetQubit > controlQubit) ? (1LL << (targetQubit - controlQubit - 1)) : (1LL << (controlQubit - targetQubit - 1)));
+    // const long long int chunkSize=qureg.numAmpsPerChunk;
+    // const long long int chunkId=qureg.chunkId;
+    const long long int numBlocks = ((targetQubit > controlQubit) ? (qureg.numAmpsPerChunk>>(1 + targetQubit)) : (qureg.numAmpsPerChunk>>(1 + controlQubit)));
+    const long long int sizeTask = ((targetQubit > controlQubit) ? (1LL << controlQubit) : (1LL << targetQubit));
+    const long long int blockOffset = 1LL << controlQubit;
+
+    // set dimensions
+    sizeHalfBlock = 1LL << targetQubit;
+    sizeBlock     = ((targetQubit > controlQubit) ? (2LL * sizeHalfBlock) : (2LL << controlQubit));
+
+    // Can't use qureg.stateVec as a private OMP var
+    qreal *stateVecReal = qureg.stateVec.real;
+    qreal *stateVecImag = qureg.stateVec.imag;
+    qreal alphaImag=alpha.imag, alphaReal=alpha.real;
+    qreal betaImag=beta.imag, betaReal=beta.real;
+
+    qrealSIMD stateRealUpSIMD,stateImagUpSIMD,stateRealLoSIMD,stateImagLoSIMD;
+    register const qrealSIMD alphaRealSIMD = SIMD_SET1(alphaReal);
+    register const qrealSIMD alphaImagSIMD = SIMD_SET1(alphaImag);
+    register const qrealSIMD betaRealSIMD = SIMD_SET1(betaReal);
+    register const qrealSIMD betaImagSIMD = SIMD_SET1(betaImag);
+    
+# ifdef _OPENMP
+    if(numBlocks >= omp_get_num_threads()){
+# pragma omp parallel \
+    shared   (sizeBlock,sizeHalfBlock, stateVecReal,stateVecImag, alphaRealSIMD,alphaImagSIMD, betaRealSIMD,betaImagSIMD) \
+    private  (thisTask,thisBlock ,indexUp,indexLo, stateRealUpSIMD,stateImagUpSIMD,stateRealLoSIMD,stateImagLoSIMD)
+# endif
+        {
+# ifdef _OPENMP
+# pragma omp for schedule (static)
+# endif
+            for (thisBlock = 0; thisBlock < numBlocks; ++thisBlock) {
+                for(thisTask = 0; thisTask < numTasks; ++thisTask)
+                for(indexUp = thisBlock * sizeBlock + sizeTask * thisTask * 2 + blockOffset; indexUp < thisBlock * sizeBlock + sizeTask * thisTask * 2 + sizeTask + blockOffset; indexUp+=SIMD_WIDTH) {
+                // for(indexUp = thisBlock * sizeBlock; indexUp < thisBlock * sizeBlock + sizeHalfBlock; ++indexUp) {
+
+                    indexLo     = indexUp + sizeHalfBlock;
+
+                    // controlBit = extractBit (controlQubit, indexUp+chunkId*chunkSize);
+                    // if (controlBit){
+                    // store current state vector values in temp variables
+                    stateRealUpSIMD = SIMD_LOAD(stateVecReal+indexUp);
+                    stateImagUpSIMD = SIMD_LOAD(stateVecImag+indexUp);
+                    stateRealLoSIMD = SIMD_LOAD(stateVecReal+indexLo);
+                    stateImagLoSIMD = SIMD_LOAD(stateVecImag+indexLo);
+
+                    // state[indexUp] = alpha * state[indexUp] - conj(beta)  * state[indexLo]
+                    //stateVecReal[indexUp] = alphaReal*stateRealUp - alphaImag*stateImagUp
+                    //    - betaReal*stateRealLo - betaImag*stateImagLo;
+                    qrealSIMD res1 =  SIMD_MUL(alphaRealSIMD,stateRealUpSIMD);
+                    res1 = SIMD_SUB(res1,SIMD_MUL(alphaImagSIMD,stateImagUpSIMD));
+                    res1 = SIMD_SUB(res1,SIMD_MUL(betaRealSIMD,stateRealLoSIMD));
+                    res1 = SIMD_SUB(res1,SIMD_MUL(betaImagSIMD,stateImagLoSIMD));
+
+
+                    //stateVecImag[indexUp] = alphaReal*stateImagUp + alphaImag*stateRealUp
+                    //    - betaReal*stateImagLo + betaImag*stateRealLo;
+                    qrealSIMD res2 =  SIMD_MUL(alphaRealSIMD,stateImagUpSIMD);
+                    res2 = SIMD_ADD(res2,SIMD_MUL(alphaImagSIMD,stateRealUpSIMD));
+                    res2 = SIMD_SUB(res2,SIMD_MUL(betaRealSIMD,stateImagLoSIMD));
+                    res2 = SIMD_ADD(res2,SIMD_MUL(betaImagSIMD,stateRealLoSIMD));
+
+                    // state[indexLo] = beta  * state[indexUp] + conj(alpha) * state[indexLo]
+                    //stateVecReal[indexLo] = betaReal*stateRealUp - betaImag*stateImagUp
+                    //    + alphaReal*stateRealLo + alphaImag*stateImagLo;
+                    qrealSIMD res3 = SIMD_MUL(betaRealSIMD,stateRealUpSIMD);
+                    res3 = SIMD_SUB(res3,SIMD_MUL(betaImagSIMD,stateImagUpSIMD));
+                    res3 = SIMD_ADD(res3,SIMD_MUL(alphaRealSIMD,stateRealLoSIMD));
+                    res3 = SIMD_ADD(res3,SIMD_MUL(alphaImagSIMD,stateImagLoSIMD));
+
+                    //stateVecImag[indexLo] = betaReal*stateImagUp + betaImag*stateRealUp
+                    //    + alphaReal*stateImagLo - alphaImag*stateRealLo;
+                    qrealSIMD res4 = SIMD_MUL(betaRealSIMD,stateImagUpSIMD);
+                    res4 = SIMD_ADD(res4,SIMD_MUL(betaImagSIMD,stateRealUpSIMD));
+                    res4 = SIMD_ADD(res4,SIMD_MUL(alphaRealSIMD,stateImagLoSIMD));
+                    res4 = SIMD_SUB(res4,SIMD_MUL(alphaImagSIMD,stateRealLoSIMD));
+
+                    SIMD_STORE(stateVecReal+indexUp,res1);
+                    SIMD_STORE(stateVecImag+indexUp,res2);
+                    SIMD_STORE(stateVecReal+indexLo,res3);
+                    SIMD_STORE(stateVecImag+indexLo,res4);
+                    // }
+                }
+            }
+        }
+# ifdef _OPENMP
+    } else {
+         for (thisBlock = 0; thisBlock < numBlocks; ++thisBlock) 
+
+# pragma omp parallel \
+    shared   (thisBlock,sizeBlock,sizeHalfBlock, stateVecReal,stateVecImag, alphaRealSIMD,alphaImagSIMD, betaRealSIMD,betaImagSIMD) \
+    private  (thisTask ,indexUp,indexLo, stateRealUpSIMD,stateImagUpSIMD,stateRealLoSIMD,stateImagLoSIMD)
+        {
+# pragma omp for schedule (static)
+                for(thisTask = 0; thisTask < numTasks; ++thisTask) {
+                for(indexUp = thisBlock * sizeBlock + sizeTask * thisTask * 2 + blockOffset; indexUp < thisBlock * sizeBlock + sizeTask * thisTask * 2 + sizeTask + blockOffset; indexUp+=SIMD_WIDTH) {
+                // for(indexUp = thisBlock * sizeBlock; indexUp < thisBlock * sizeBlock + sizeHalfBlock; ++indexUp) {
+
+                    indexLo     = indexUp + sizeHalfBlock;
+
+                    // controlBit = extractBit (controlQubit, indexUp+chunkId*chunkSize);
+                    // if (controlBit){
+                    // store current state vector values in temp variables
+                    stateRealUpSIMD = SIMD_LOAD(stateVecReal+indexUp);
+                    stateImagUpSIMD = SIMD_LOAD(stateVecImag+indexUp);
+                    stateRealLoSIMD = SIMD_LOAD(stateVecReal+indexLo);
+                    stateImagLoSIMD = SIMD_LOAD(stateVecImag+indexLo);
+
+                    // state[indexUp] = alpha * state[indexUp] - conj(beta)  * state[indexLo]
+                    //stateVecReal[indexUp] = alphaReal*stateRealUp - alphaImag*stateImagUp
+                    //    - betaReal*stateRealLo - betaImag*stateImagLo;
+                    qrealSIMD res1 =  SIMD_MUL(alphaRealSIMD,stateRealUpSIMD);
+                    res1 = SIMD_SUB(res1,SIMD_MUL(alphaImagSIMD,stateImagUpSIMD));
+                    res1 = SIMD_SUB(res1,SIMD_MUL(betaRealSIMD,stateRealLoSIMD));
+                    res1 = SIMD_SUB(res1,SIMD_MUL(betaImagSIMD,stateImagLoSIMD));
+
+
+                    //stateVecImag[indexUp] = alphaReal*stateImagUp + alphaImag*stateRealUp
+                    //    - betaReal*stateImagLo + betaImag*stateRealLo;
+                    qrealSIMD res2 =  SIMD_MUL(alphaRealSIMD,stateImagUpSIMD);
+                    res2 = SIMD_ADD(res2,SIMD_MUL(alphaImagSIMD,stateRealUpSIMD));
+                    res2 = SIMD_SUB(res2,SIMD_MUL(betaRealSIMD,stateImagLoSIMD));
+                    res2 = SIMD_ADD(res2,SIMD_MUL(betaImagSIMD,stateRealLoSIMD));
+
+                    // state[indexLo] = beta  * state[indexUp] + conj(alpha) * state[indexLo]
+                    //stateVecReal[indexLo] = betaReal*stateRealUp - betaImag*stateImagUp
+                    //    + alphaReal*stateRealLo + alphaImag*stateImagLo;
+                    qrealSIMD res3 = SIMD_MUL(betaRealSIMD,stateRealUpSIMD);
+                    res3 = SIMD_SUB(res3,SIMD_MUL(betaImagSIMD,stateImagUpSIMD));
+                    res3 = SIMD_ADD(res3,SIMD_MUL(alphaRealSIMD,stateRealLoSIMD));
+                    res3 = SIMD_ADD(res3,SIMD_MUL(alphaImagSIMD,stateImagLoSIMD));
+
+                    //stateVecImag[indexLo] = betaReal*stateImagUp + betaImag*stateRealUp
+                    //    + alphaReal*stateImagLo - alphaImag*stateRealLo;
+                    qrealSIMD res4 = SIMD_MUL(betaRealSIMD,stateImagUpSIMD);
+                    res4 = SIMD_ADD(res4,SIMD_MUL(betaImagSIMD,stateRealUpSIMD));
+                    res4 = SIMD_ADD(res4,SIMD_MUL(alphaRealSIMD,stateImagLoSIMD));
+                    res4 = SIMD_SUB(res4,SIMD_MUL(alphaImagSIMD,stateRealLoSIMD));
+
+                    SIMD_STORE(stateVecReal+indexUp,res1);
+                    SIMD_STORE(stateVecImag+indexUp,res2);
+                    SIMD_STORE(stateVecReal+indexLo,res3);
+                    SIMD_STORE(stateVecImag+indexLo,res4);
+                    // }
+                }
+            }
+        }
+
     }
+# endif
+
 }
 
-void statevec_initPlusState (Qureg qureg)
+void statevec_controlledCompactUnitaryLocal (Qureg qureg, const int controlQubit, const int targetQubit,
+        Complex alpha, Complex beta)
 {
-    long long int chunkSize, stateVecSize;
-    long long int index;
+    long long int sizeBlock, sizeHalfBlock;
+    long long int thisBlock, // current block
+         indexUp,indexLo;    // current index and corresponding index in lower half block
 
-    // dimension of the state vector
-    chunkSize = qureg.numAmpsPerChunk;
-    stateVecSize = chunkSize*qureg.numChunks;
-    qreal normFactor = 1.0/sqrt((qreal)stateVecSize);
+    qreal stateRealUp,stateRealLo,stateImagUp,stateImagLo;
+    long long int thisTask;
+    const long long int numTasks=qureg.numAmpsPerChunk>>1;
+    const long long int chunkSize=qureg.numAmpsPerChunk;
+    const long long int chunkId=qureg.chunkId;
 
-    // Can't use qureg->stateVec as a private OMP var
+    int controlBit;
+
+    // set dimensions
+    sizeHalfBlock = 1LL << targetQubit;
+    sizeBlock     = 2LL * sizeHalfBlock;
+
+    // Can't use qureg.stateVec as a private OMP var
     qreal *stateVecReal = qureg.stateVec.real;
     qreal *stateVecImag = qureg.stateVec.imag;
+    qreal alphaImag=alpha.imag, alphaReal=alpha.real;
+    qreal betaImag=beta.imag, betaReal=beta.real;
 
-    // initialise the state to |+++..+++> = 1/normFactor {1, 1, 1, ...}
 # ifdef _OPENMP
 # pragma omp parallel \
-    shared   (chunkSize, stateVecReal, stateVecImag, normFactor) \
-    private  (index)
+    shared   (sizeBlock,sizeHalfBlock, stateVecReal,stateVecImag, alphaReal,alphaImag, betaReal,betaImag) \
+    private  (thisTask,thisBlock ,indexUp,indexLo, stateRealUp,stateImagUp,stateRealLo,stateImagLo,controlBit)
 # endif
     {
 # ifdef _OPENMP
 # pragma omp for schedule (static)
 # endif
-        for (index=0; index<chunkSize; index++) {
-            stateVecReal[index] = normFactor;
-            stateVecImag[index] = 0.0;
+        for (thisTask=0; thisTask<numTasks; thisTask++) {
+
+            thisBlock   = thisTask / sizeHalfBlock;
+            indexUp     = thisBlock*sizeBlock + thisTask%sizeHalfBlock;
+            indexLo     = indexUp + sizeHalfBlock;
+
+            controlBit = extractBit (controlQubit, indexUp+chunkId*chunkSize);
+            if (controlBit){
+                // store current state vector values in temp variables
+                stateRealUp = stateVecReal[indexUp];
+                stateImagUp = stateVecImag[indexUp];
+
+                stateRealLo = stateVecReal[indexLo];
+                stateImagLo = stateVecImag[indexLo];
+
+                // state[indexUp] = alpha * state[indexUp] - conj(beta)  * state[indexLo]
+                stateVecReal[indexUp] = alphaReal*stateRealUp - alphaImag*stateImagUp
+                    - betaReal*stateRealLo - betaImag*stateImagLo;
+                stateVecImag[indexUp] = alphaReal*stateImagUp + alphaImag*stateRealUp
+                    - betaReal*stateImagLo + betaImag*stateRealLo;
+
+                // state[indexLo] = beta  * state[indexUp] + conj(alpha) * state[indexLo]
+                stateVecReal[indexLo] = betaReal*stateRealUp - betaImag*stateImagUp
+                    + alphaReal*stateRealLo + alphaImag*stateImagLo;
+                stateVecImag[indexLo] = betaReal*stateImagUp + betaImag*stateRealUp
+                    + alphaReal*stateImagLo - alphaImag*stateRealLo;
+            }
+
         }
     }
+
 }
 
-void statevec_initClassicalState (Qureg qureg, long long int stateInd)
+/* ctrlQubitsMask is a bit mask indicating which qubits are control Qubits
+ * ctrlFlipMask is a bit mask indicating which control qubits should be 'flipped'
+ * in the condition, i.e. they should have value 0 when the unitary is applied
+ */
+void statevec_multiControlledUnitaryLocal(
+    Qureg qureg, const int targetQubit,
+    long long int ctrlQubitsMask, long long int ctrlFlipMask,
+    ComplexMatrix2 u)
 {
-    long long int stateVecSize;
-    long long int index;
+    long long int sizeBlock, sizeHalfBlock;
+    long long int thisBlock, // current block
+         indexUp,indexLo;    // current index and corresponding index in lower half block
 
-    // dimension of the state vector
-    stateVecSize = qureg.numAmpsPerChunk;
+    qreal stateRealUp,stateRealLo,stateImagUp,stateImagLo;
+    long long int thisTask;
+    const long long int numTasks=qureg.numAmpsPerChunk>>1;
+    const long long int chunkSize=qureg.numAmpsPerChunk;
+    const long long int chunkId=qureg.chunkId;
 
-    // Can't use qureg->stateVec as a private OMP var
+    // set dimensions
+    sizeHalfBlock = 1LL << targetQubit;
+    sizeBlock     = 2LL * sizeHalfBlock;
+
+    // Can't use qureg.stateVec as a private OMP var
     qreal *stateVecReal = qureg.stateVec.real;
     qreal *stateVecImag = qureg.stateVec.imag;
 
-    // initialise the state to vector to all zeros
 # ifdef _OPENMP
 # pragma omp parallel \
-    shared   (stateVecSize, stateVecReal, stateVecImag) \
-    private  (index)
+    shared   (sizeBlock,sizeHalfBlock, stateVecReal,stateVecImag, u, ctrlQubitsMask,ctrlFlipMask) \
+    private  (thisTask,thisBlock, indexUp,indexLo, stateRealUp,stateImagUp,stateRealLo,stateImagLo)
 # endif
     {
 # ifdef _OPENMP
 # pragma omp for schedule (static)
 # endif
-        for (index=0; index<stateVecSize; index++) {
-            stateVecReal[index] = 0.0;
-            stateVecImag[index] = 0.0;
-        }
-    }
+        for (thisTask=0; thisTask<numTasks; thisTask++) {
 
-    // give the specified classical state prob 1
-    if (qureg.chunkId == stateInd/stateVecSize){
-        stateVecReal[stateInd % stateVecSize] = 1.0;
-        stateVecImag[stateInd % stateVecSize] = 0.0;
-    }
-}
+            thisBlock   = thisTask / sizeHalfBlock;
+            indexUp     = thisBlock*sizeBlock + thisTask%sizeHalfBlock;
+            indexLo     = indexUp + sizeHalfBlock;
 
-void statevec_cloneQureg(Qureg targetQureg, Qureg copyQureg) {
 
-    // registers are equal sized, so nodes hold the same state-vector partitions
-    long long int stateVecSize;
-    long long int index;
+            // take the basis index, flip the designated (XOR) 'control' bits, AND with the controls.
+            // if this equals the control mask, the control qubits have the desired values in the basis index
+            if (ctrlQubitsMask == (ctrlQubitsMask & ((indexUp+chunkId*chunkSize) ^ ctrlFlipMask))) {
+                // store current state vector values in temp variables
+                stateRealUp = stateVecReal[indexUp];
+                stateImagUp = stateVecImag[indexUp];
 
-    // dimension of the state vector
-    stateVecSize = targetQureg.numAmpsPerChunk;
+                stateRealLo = stateVecReal[indexLo];
+                stateImagLo = stateVecImag[indexLo];
 
-    // Can't use qureg->stateVec as a private OMP var
-    qreal *targetStateVecReal = targetQureg.stateVec.real;
-    qreal *targetStateVecImag = targetQureg.stateVec.imag;
-    qreal *copyStateVecReal = copyQureg.stateVec.real;
-    qreal *copyStateVecImag = copyQureg.stateVec.imag;
+                // state[indexUp] = u00 * state[indexUp] + u01 * state[indexLo]
+                stateVecReal[indexUp] = u.real[0][0]*stateRealUp - u.imag[0][0]*stateImagUp
+                    + u.real[0][1]*stateRealLo - u.imag[0][1]*stateImagLo;
+                stateVecImag[indexUp] = u.real[0][0]*stateImagUp + u.imag[0][0]*stateRealUp
+                    + u.real[0][1]*stateImagLo + u.imag[0][1]*stateRealLo;
 
-    // initialise the state to |0000..0000>
-# ifdef _OPENMP
-# pragma omp parallel \
-    shared   (stateVecSize, targetStateVecReal, targetStateVecImag, copyStateVecReal, copyStateVecImag) \
-    private  (index)
-# endif
-    {
-# ifdef _OPENMP
-# pragma omp for schedule (static)
-# endif
-        for (index=0; index<stateVecSize; index++) {
-            targetStateVecReal[index] = copyStateVecReal[index];
-            targetStateVecImag[index] = copyStateVecImag[index];
+                // state[indexLo] = u10  * state[indexUp] + u11 * state[indexLo]
+                stateVecReal[indexLo] = u.real[1][0]*stateRealUp  - u.imag[1][0]*stateImagUp
+                    + u.real[1][1]*stateRealLo  -  u.imag[1][1]*stateImagLo;
+                stateVecImag[indexLo] = u.real[1][0]*stateImagUp + u.imag[1][0]*stateRealUp
+                    + u.real[1][1]*stateImagLo + u.imag[1][1]*stateRealLo;
+            }
         }
     }
+
 }
 
-/**
- * Initialise the state vector of probability amplitudes such that one qubit is set to 'outcome' and all other qubits are in an equal superposition of zero and one.
- * @param[in,out] qureg object representing the set of qubits to be initialised
- * @param[in] qubitId id of qubit to set to state 'outcome'
- * @param[in] value of qubit 'qubitId'
- */
-void statevec_initStateOfSingleQubit(Qureg *qureg, int qubitId, int outcome)
+void statevec_controlledUnitaryLocal(Qureg qureg, const int controlQubit, const int targetQubit,
+        ComplexMatrix2 u)
 {
-    long long int chunkSize, stateVecSize;
-    long long int index;
-    int bit;
-    const long long int chunkId=qureg->chunkId;
+    long long int sizeBlock, sizeHalfBlock;
+    long long int thisBlock, // current block
+         indexUp,indexLo;    // current index and corresponding index in lower half block
 
-    // dimension of the state vector
-    chunkSize = qureg->numAmpsPerChunk;
-    stateVecSize = chunkSize*qureg->numChunks;
-    qreal normFactor = 1.0/sqrt((qreal)stateVecSize/2.0);
+    qreal stateRealUp,stateRealLo,stateImagUp,stateImagLo;
+    long long int thisTask;
+    const long long int numTasks=qureg.numAmpsPerChunk>>1;
+    const long long int chunkSize=qureg.numAmpsPerChunk;
+    const long long int chunkId=qureg.chunkId;
 
-    // Can't use qureg->stateVec as a private OMP var
-    qreal *stateVecReal = qureg->stateVec.real;
-    qreal *stateVecImag = qureg->stateVec.imag;
+    int controlBit;
+
+    // set dimensions
+    sizeHalfBlock = 1LL << targetQubit;
+    sizeBlock     = 2LL * sizeHalfBlock;
+
+    // Can't use qureg.stateVec as a private OMP var
+    qreal *stateVecReal = qureg.stateVec.real;
+    qreal *stateVecImag = qureg.stateVec.imag;
 
-    // initialise the state to |0000..0000>
 # ifdef _OPENMP
 # pragma omp parallel \
-    shared   (chunkSize, stateVecReal, stateVecImag, normFactor, qubitId, outcome) \
-    private  (index, bit)
+    shared   (sizeBlock,sizeHalfBlock, stateVecReal,stateVecImag, u) \
+    private  (thisTask,thisBlock ,indexUp,indexLo, stateRealUp,stateImagUp,stateRealLo,stateImagLo,controlBit)
 # endif
     {
 # ifdef _OPENMP
 # pragma omp for schedule (static)
 # endif
-        for (index=0; index<chunkSize; index++) {
-            bit = extractBit(qubitId, index+chunkId*chunkSize);
-            if (bit==outcome) {
-                stateVecReal[index] = normFactor;
-                stateVecImag[index] = 0.0;
-            } else {
-                stateVecReal[index] = 0.0;
-                stateVecImag[index] = 0.0;
+        for (thisTask=0; thisTask<numTasks; thisTask++) {
+
+            thisBlock   = thisTask / sizeHalfBlock;
+            indexUp     = thisBlock*sizeBlock + thisTask%sizeHalfBlock;
+            indexLo     = indexUp + sizeHalfBlock;
+
+            controlBit = extractBit (controlQubit, indexUp+chunkId*chunkSize);
+            if (controlBit){
+                // store current state vector values in temp variables
+                stateRealUp = stateVecReal[indexUp];
+                stateImagUp = stateVecImag[indexUp];
+
+                stateRealLo = stateVecReal[indexLo];
+                stateImagLo = stateVecImag[indexLo];
+
+
+                // state[indexUp] = u00 * state[indexUp] + u01 * state[indexLo]
+                stateVecReal[indexUp] = u.real[0][0]*stateRealUp - u.imag[0][0]*stateImagUp
+                    + u.real[0][1]*stateRealLo - u.imag[0][1]*stateImagLo;
+                stateVecImag[indexUp] = u.real[0][0]*stateImagUp + u.imag[0][0]*stateRealUp
+                    + u.real[0][1]*stateImagLo + u.imag[0][1]*stateRealLo;
+
+                // state[indexLo] = u10  * state[indexUp] + u11 * state[indexLo]
+                stateVecReal[indexLo] = u.real[1][0]*stateRealUp  - u.imag[1][0]*stateImagUp
+                    + u.real[1][1]*stateRealLo  -  u.imag[1][1]*stateImagLo;
+                stateVecImag[indexLo] = u.real[1][0]*stateImagUp + u.imag[1][0]*stateRealUp
+                    + u.real[1][1]*stateImagLo + u.imag[1][1]*stateRealLo;
             }
         }
     }
 }
-
-
-/**
- * Initialise the state vector of probability amplitudes to an (unphysical) state with
- * each component of each probability amplitude a unique floating point value. For debugging processes
- * @param[in,out] qureg object representing the set of qubits to be initialised
- */
-void statevec_initDebugState (Qureg qureg)
+void statevec_controlledCompactUnitaryDistributedAllSIMD (Qureg qureg, const int controlQubit,
+        Complex rot1, Complex rot2,
+        ComplexArray stateVecUp,
+        ComplexArray stateVecLo,
+        ComplexArray stateVecOut)
 {
-    long long int chunkSize;
-    long long int index;
-    long long int indexOffset;
 
-    // dimension of the state vector
-    chunkSize = qureg.numAmpsPerChunk;
+    qrealSIMD stateRealUpSIMD,stateRealLoSIMD,stateImagUpSIMD,stateImagLoSIMD;
 
-    // Can't use qureg->stateVec as a private OMP var
-    qreal *stateVecReal = qureg.stateVec.real;
-    qreal *stateVecImag = qureg.stateVec.imag;
+    long long int thisTask;
+    const long long int numTasks=qureg.numAmpsPerChunk;
 
-    indexOffset = chunkSize * qureg.chunkId;
+    qreal rot1Real=rot1.real, rot1Imag=rot1.imag;
+    qreal rot2Real=rot2.real, rot2Imag=rot2.imag;
+    qreal *stateVecRealUp=stateVecUp.real, *stateVecImagUp=stateVecUp.imag;
+    qreal *stateVecRealLo=stateVecLo.real, *stateVecImagLo=stateVecLo.imag;
+    qreal *stateVecRealOut=stateVecOut.real, *stateVecImagOut=stateVecOut.imag;
+
+    register const qrealSIMD rot1RealSIMD = SIMD_SET1(rot1Real);
+    register const qrealSIMD rot1ImagSIMD = SIMD_SET1(rot1Imag);
+    register const qrealSIMD rot2RealSIMD = SIMD_SET1(rot2Real);
+    register const qrealSIMD rot2ImagSIMD = SIMD_SET1(rot2Imag);
 
-    // initialise the state to |0000..0000>
 # ifdef _OPENMP
 # pragma omp parallel \
-    shared   (chunkSize, stateVecReal, stateVecImag, indexOffset) \
-    private  (index)
+    shared   (stateVecRealUp,stateVecImagUp,stateVecRealLo,stateVecImagLo,stateVecRealOut,stateVecImagOut, \
+            rot1RealSIMD,rot1ImagSIMD, rot2RealSIMD,rot2ImagSIMD) \
+    private  (thisTask,stateRealUpSIMD,stateImagUpSIMD,stateRealLoSIMD,stateImagLoSIMD)
 # endif
     {
 # ifdef _OPENMP
 # pragma omp for schedule (static)
 # endif
-        for (index=0; index<chunkSize; index++) {
-            stateVecReal[index] = ((indexOffset + index)*2.0)/10.0;
-            stateVecImag[index] = ((indexOffset + index)*2.0+1.0)/10.0;
+        for (thisTask=0; thisTask<numTasks; thisTask+=SIMD_WIDTH) {
+                stateRealUpSIMD = SIMD_LOAD(stateVecRealUp+thisTask);
+                stateImagUpSIMD = SIMD_LOAD(stateVecImagUp+thisTask);
+
+                stateRealLoSIMD = SIMD_LOAD(stateVecRealLo+thisTask);
+                stateImagLoSIMD = SIMD_LOAD(stateVecImagLo+thisTask);
+
+                SIMD_STORE(stateVecRealOut+thisTask, SIMD_ADD( \
+                                SIMD_SUB(SIMD_MUL(rot1RealSIMD,stateRealUpSIMD),SIMD_MUL(rot1ImagSIMD,stateImagUpSIMD)), \
+                                SIMD_ADD(SIMD_MUL(rot2RealSIMD,stateRealLoSIMD),SIMD_MUL(rot2ImagSIMD,stateImagLoSIMD))));
+
+                SIMD_STORE(stateVecImagOut+thisTask, SIMD_ADD( \
+                                SIMD_ADD(SIMD_MUL(rot1RealSIMD,stateImagUpSIMD),SIMD_MUL(rot1ImagSIMD,stateRealUpSIMD)), \
+                                SIMD_SUB(SIMD_MUL(rot2RealSIMD,stateImagLoSIMD),SIMD_MUL(rot2ImagSIMD,stateRealLoSIMD))));
         }
     }
 }
 
-// returns 1 if successful, else 0
-int statevec_initStateFromSingleFile(Qureg *qureg, char filename[200], QuESTEnv env){
-    long long int chunkSize, stateVecSize;
-    long long int indexInChunk, totalIndex;
-
-    chunkSize = qureg->numAmpsPerChunk;
-    stateVecSize = chunkSize*qureg->numChunks;
-
-    qreal *stateVecReal = qureg->stateVec.real;
-    qreal *stateVecImag = qureg->stateVec.imag;
 
-    FILE *fp;
-    char line[200];
+void statevec_controlledCompactUnitaryDistributedAll (Qureg qureg, const int controlQubit,
+        Complex rot1, Complex rot2,
+        ComplexArray stateVecUp,
+        ComplexArray stateVecLo,
+        ComplexArray stateVecOut)
+{
+    qreal   stateRealUp,stateRealLo,stateImagUp,stateImagLo;
+    long long int thisTask;
+    const long long int numTasks=qureg.numAmpsPerChunk;
+    if(numTasks >= SIMD_WIDTH){
+        statevec_controlledCompactUnitaryDistributedAllSIMD(qureg,controlQubit,rot1,rot2,stateVecUp,stateVecLo,stateVecOut);
+        return ;
+    }
+    qreal rot1Real=rot1.real, rot1Imag=rot1.imag;
+    qreal rot2Real=rot2.real, rot2Imag=rot2.imag;
+    qreal *stateVecRealUp=stateVecUp.real, *stateVecImagUp=stateVecUp.imag;
+    qreal *stateVecRealLo=stateVecLo.real, *stateVecImagLo=stateVecLo.imag;
+    qreal *stateVecRealOut=stateVecOut.real, *stateVecImagOut=stateVecOut.imag;
 
-    for (int rank=0; rank<(qureg->numChunks); rank++){
-        if (rank==qureg->chunkId){
-            fp = fopen(filename, "r");
+# ifdef _OPENMP
+# pragma omp parallel \
+    shared   (stateVecRealUp,stateVecImagUp,stateVecRealLo,stateVecImagLo,stateVecRealOut,stateVecImagOut, \
+            rot1Real,rot1Imag, rot2Real,rot2Imag) \
+    private  (thisTask,stateRealUp,stateImagUp,stateRealLo,stateImagLo)
+# endif
+    {
+# ifdef _OPENMP
+# pragma omp for schedule (static)
+# endif
+        for (thisTask=0; thisTask<numTasks; thisTask++) {
+                // store current state vector values in temp variables
+                stateRealUp = stateVecRealUp[thisTask];
+                stateImagUp = stateVecImagUp[thisTask];
 
-            // indicate file open failure
-            if (fp == NULL)
-                return 0;
+                stateRealLo = stateVecRealLo[thisTask];
+                stateImagLo = stateVecImagLo[thisTask];
 
-            indexInChunk = 0; totalIndex = 0;
-            while (fgets(line, sizeof(char)*200, fp) != NULL && totalIndex<stateVecSize){
-                if (line[0]!='#'){
-                    int chunkId = (int) (totalIndex/chunkSize);
-                    if (chunkId==qureg->chunkId){
-                        # if QuEST_PREC==1
-                        sscanf(line, "%f, %f", &(stateVecReal[indexInChunk]),
-                                &(stateVecImag[indexInChunk]));
-                        # elif QuEST_PREC==2
-                        sscanf(line, "%lf, %lf", &(stateVecReal[indexInChunk]),
-                                &(stateVecImag[indexInChunk]));
-                        # elif QuEST_PREC==4
-                        sscanf(line, "%Lf, %Lf", &(stateVecReal[indexInChunk]),
-                                &(stateVecImag[indexInChunk]));
-                        # endif
-                        indexInChunk += 1;
-                    }
-                    totalIndex += 1;
-                }
-            }
-            fclose(fp);
+                // state[indexUp] = alpha * state[indexUp] - conj(beta)  * state[indexLo]
+                stateVecRealOut[thisTask] = rot1Real*stateRealUp - rot1Imag*stateImagUp + rot2Real*stateRealLo + rot2Imag*stateImagLo;
+                stateVecImagOut[thisTask] = rot1Real*stateImagUp + rot1Imag*stateRealUp + rot2Real*stateImagLo - rot2Imag*stateRealLo;
         }
-        syncQuESTEnv(env);
     }
-
-    // indicate success
-    return 1;
 }
 
-int statevec_compareStates(Qureg mq1, Qureg mq2, qreal precision){
-    qreal diff;
-    long long int chunkSize = mq1.numAmpsPerChunk;
-
-    for (long long int i=0; i<chunkSize; i++){
-        diff = absReal(mq1.stateVec.real[i] - mq2.stateVec.real[i]);
-        if (diff>precision) return 0;
-        diff = absReal(mq1.stateVec.imag[i] - mq2.stateVec.imag[i]);
-        if (diff>precision) return 0;
-    }
-    return 1;
-}
 
-void statevec_compactUnitaryLocalSmall (Qureg qureg, const int targetQubit, Complex alpha, Complex beta)
+/** Rotate a single qubit in the state vector of probability amplitudes, given two complex
+ * numbers alpha and beta and a subset of the state vector with upper and lower block values
+ * stored seperately. Only perform the rotation where the control qubit is one.
+ *
+ *  @param[in,out] qureg object representing the set of qubits
+ *  @param[in] controlQubit qubit to determine whether or not to perform a rotation
+ *  @param[in] rot1 rotation angle
+ *  @param[in] rot2 rotation angle
+ *  @param[in] stateVecUp probability amplitudes in upper half of a block
+ *  @param[in] stateVecLo probability amplitudes in lower half of a block
+ *  @param[out] stateVecOut array section to update (will correspond to either the lower or upper half of a block)
+ */
+void statevec_controlledCompactUnitaryDistributed (Qureg qureg, const int controlQubit,
+        Complex rot1, Complex rot2,
+        ComplexArray stateVecUp,
+        ComplexArray stateVecLo,
+        ComplexArray stateVecOut)
 {
-    long long int indexUp,indexLo;    // current index and corresponding index in lower half block
-
-    qreal stateRealUp,stateRealLo,stateImagUp,stateImagLo;
+    if((1LL<<controlQubit)>=qureg.numAmpsPerChunk) {
+        if(extractBit(controlQubit,qureg.chunkId*qureg.numAmpsPerChunk)) {
+            statevec_controlledCompactUnitaryDistributedAll(qureg,controlQubit,rot1,rot2,stateVecUp,stateVecLo,stateVecOut);
+        }
+        return ;
+    }
+    qreal   stateRealUp,stateRealLo,stateImagUp,stateImagLo;
+    long long int thisTask;
+    const long long int numTasks=qureg.numAmpsPerChunk;
+    const long long int chunkSize=qureg.numAmpsPerChunk;
+    const long long int chunkId=qureg.chunkId;
 
-    const long long int sizeTask = (1LL << targetQubit);
-    if(sizeTask >= 4){
-        statevec_compactUnitaryLocalSIMD(qureg,targetQubit,alpha,beta);
-        //printf("simd");
+    if((1LL<<controlQubit) >= 2*SIMD_WIDTH){
+        statevec_controlledCompactUnitaryDistributedSIMD(qureg,controlQubit,rot1,rot2,stateVecUp,stateVecLo,stateVecOut);
         return;
     }
 
-    const long long int numTasks = (qureg.numAmpsPerChunk>>(1 + targetQubit)) ;
-    long long thisTask;
+    int controlBit;
 
-    // Can't use qureg.stateVec as a private OMP var
-    qreal *stateVecReal = qureg.stateVec.real;
-    qreal *stateVecImag = qureg.stateVec.imag;
-    qreal alphaImag=alpha.imag, alphaReal=alpha.real;
-    qreal betaImag=beta.imag, betaReal=beta.real;
+    qreal rot1Real=rot1.real, rot1Imag=rot1.imag;
+    qreal rot2Real=rot2.real, rot2Imag=rot2.imag;
+    qreal *stateVecRealUp=stateVecUp.real, *stateVecImagUp=stateVecUp.imag;
+    qreal *stateVecRealLo=stateVecLo.real, *stateVecImagLo=stateVecLo.imag;
+    qreal *stateVecRealOut=stateVecOut.real, *stateVecImagOut=stateVecOut.imag;
 
 # ifdef _OPENMP
 # pragma omp parallel \
-    shared   (stateVecReal,stateVecImag, alphaReal,alphaImag, betaReal,betaImag) \
-    private  (thisTask,indexUp,indexLo, stateRealUp,stateImagUp,stateRealLo,stateImagLo)
+    shared   (stateVecRealUp,stateVecImagUp,stateVecRealLo,stateVecImagLo,stateVecRealOut,stateVecImagOut, \
+            rot1Real,rot1Imag, rot2Real,rot2Imag) \
+    private  (thisTask,stateRealUp,stateImagUp,stateRealLo,stateImagLo,controlBit)
 # endif
     {
 # ifdef _OPENMP
 # pragma omp for schedule (static)
 # endif
-        for (thisTask = 0; thisTask < numTasks; ++thisTask)
-        for (indexUp = thisTask * sizeTask * 2; indexUp < thisTask * sizeTask * 2 + sizeTask; ++ indexUp) {
-
-            indexLo     = indexUp + sizeTask;
-
-            // store current state vector values in temp variables
-            stateRealUp = stateVecReal[indexUp];
-            stateImagUp = stateVecImag[indexUp];
-
-            stateRealLo = stateVecReal[indexLo];
-            stateImagLo = stateVecImag[indexLo];
+        for (thisTask=0; thisTask<numTasks; thisTask++) {
+            controlBit = extractBit (controlQubit, thisTask+chunkId*chunkSize);
+            if (controlBit){
+                // store current state vector values in temp variables
+                stateRealUp = stateVecRealUp[thisTask];
+                stateImagUp = stateVecImagUp[thisTask];
 
-            // state[indexUp] = alpha * state[indexUp] - conj(beta)  * state[indexLo]
-            stateVecReal[indexUp] = alphaReal*stateRealUp - alphaImag*stateImagUp
-                - betaReal*stateRealLo - betaImag*stateImagLo;
-            stateVecImag[indexUp] = alphaReal*stateImagUp + alphaImag*stateRealUp
-                - betaReal*stateImagLo + betaImag*stateRealLo;
+                stateRealLo = stateVecRealLo[thisTask];
+                stateImagLo = stateVecImagLo[thisTask];
 
-            // state[indexLo] = beta  * state[indexUp] + conj(alpha) * state[indexLo]
-            stateVecReal[indexLo] = betaReal*stateRealUp - betaImag*stateImagUp
-                + alphaReal*stateRealLo + alphaImag*stateImagLo;
-            stateVecImag[indexLo] = betaReal*stateImagUp + betaImag*stateRealUp
-                + alphaReal*stateImagLo - alphaImag*stateRealLo;
+                // state[indexUp] = alpha * state[indexUp] - conj(beta)  * state[indexLo]
+                stateVecRealOut[thisTask] = rot1Real*stateRealUp - rot1Imag*stateImagUp + rot2Real*stateRealLo + rot2Imag*stateImagLo;
+                stateVecImagOut[thisTask] = rot1Real*stateImagUp + rot1Imag*stateRealUp + rot2Real*stateImagLo - rot2Imag*stateRealLo;
+            }
         }
     }
-
 }
 
-void statevec_compactUnitaryLocalSIMD (Qureg qureg, const int targetQubit, Complex alpha, Complex beta)
+void statevec_controlledCompactUnitaryDistributedSIMD (Qureg qureg, const int controlQubit,
+        Complex rot1, Complex rot2,
+        ComplexArray stateVecUp,
+        ComplexArray stateVecLo,
+        ComplexArray stateVecOut)
 {
-    long long int indexUp,indexLo;    // current index and corresponding index in lower half block
-
 
-    const long long int numTasks = (qureg.numAmpsPerChunk>>(1 + targetQubit)) ;
-    const long long int sizeTask = (1LL << targetQubit);
-    long long thisTask;
+    qrealSIMD stateRealUpSIMD,stateRealLoSIMD,stateImagUpSIMD,stateImagLoSIMD;
 
+    long long int thisTask;
+    long long int thisBlock;
+    long long int taskEnd;
+    const long long int chunkSize=qureg.numAmpsPerChunk;
+    const long long int chunkId=qureg.chunkId;
 
-    // Can't use qureg.stateVec as a private OMP var
-    qreal *stateVecReal = qureg.stateVec.real;
-    qreal *stateVecImag = qureg.stateVec.imag;
-    qreal alphaImag=alpha.imag, alphaReal=alpha.real;
-    qreal betaImag=beta.imag, betaReal=beta.real;
+    const long long int blockSize=2LL<<controlQubit;
+    const long long int halfBlockSize = blockSize>>1;
 
+    const long long int blockStart=(chunkId*chunkSize)/(blockSize);
+    const long long int blockRange=(chunkSize>blockSize)?(chunkSize/blockSize):1;
+    const long long int blockEnd=(chunkId+1)*chunkSize-blockStart*blockSize;
+    if(blockEnd <= 0) return;
 
-    __m256d stateRealUpSIMD,stateImagUpSIMD,stateRealLoSIMD,stateImagLoSIMD;
-    register const __m256d alphaRealSIMD = _mm256_set1_pd(alphaReal);
-    register const __m256d alphaImagSIMD = _mm256_set1_pd(alphaImag);
-    register const __m256d betaRealSIMD = _mm256_set1_pd(betaReal);
-    register const __m256d betaImagSIMD = _mm256_set1_pd(betaImag);
+    qreal rot1Real=rot1.real, rot1Imag=rot1.imag;
+    qreal rot2Real=rot2.real, rot2Imag=rot2.imag;
+    qreal *stateVecRealUp=stateVecUp.real, *stateVecImagUp=stateVecUp.imag;
+    qreal *stateVecRealLo=stateVecLo.real, *stateVecImagLo=stateVecLo.imag;
+    qreal *stateVecRealOut=stateVecOut.real, *stateVecImagOut=stateVecOut.imag;
 
+    register const qrealSIMD rot1RealSIMD = SIMD_SET1(rot1Real);
+    register const qrealSIMD rot1ImagSIMD = SIMD_SET1(rot1Imag);
+    register const qrealSIMD rot2RealSIMD = SIMD_SET1(rot2Real);
+    register const qrealSIMD rot2ImagSIMD = SIMD_SET1(rot2Imag);
 
 # ifdef _OPENMP
-    if(numTasks >= omp_get_num_threads()){
+    if(blockRange >= omp_get_num_threads()){
 # pragma omp parallel \
-    shared   (stateVecReal,stateVecImag, alphaRealSIMD,alphaImagSIMD, betaRealSIMD,betaImagSIMD) \
-    private  (thisTask,indexUp,indexLo, stateRealUpSIMD,stateImagUpSIMD,stateRealLoSIMD,stateImagLoSIMD)
+    shared   (stateVecRealUp,stateVecImagUp,stateVecRealLo,stateVecImagLo,stateVecRealOut,stateVecImagOut, \
+            rot1RealSIMD,rot1ImagSIMD, rot2RealSIMD,rot2ImagSIMD) \
+    private  (thisTask,thisBlock,taskEnd,stateRealUpSIMD,stateImagUpSIMD,stateRealLoSIMD,stateImagLoSIMD)
 # endif
     {
 # ifdef _OPENMP
 # pragma omp for schedule (static)
 # endif
-        for (thisTask = 0; thisTask < numTasks; ++thisTask)
-        for (indexUp = thisTask * sizeTask * 2; indexUp < thisTask * sizeTask * 2 + sizeTask; indexUp+=4) {
-
-            indexLo     = indexUp + sizeTask;
-
-            // store current state vector values in temp variables
-            stateRealUpSIMD = _mm256_loadu_pd(stateVecReal+indexUp);
-            stateImagUpSIMD = _mm256_loadu_pd(stateVecImag+indexUp);
-            stateRealLoSIMD = _mm256_loadu_pd(stateVecReal+indexLo);
-            stateImagLoSIMD = _mm256_loadu_pd(stateVecImag+indexLo);
-
-
-            // state[indexUp] = alpha * state[indexUp] - conj(beta)  * state[indexLo]
-            //stateVecReal[indexUp] = alphaReal*stateRealUp - alphaImag*stateImagUp
-            //    - betaReal*stateRealLo - betaImag*stateImagLo;
-            __m256d res1 =  _mm256_mul_pd(alphaRealSIMD,stateRealUpSIMD);
-            res1 = _mm256_sub_pd(res1,_mm256_mul_pd(alphaImagSIMD,stateImagUpSIMD));
-            res1 = _mm256_sub_pd(res1,_mm256_mul_pd(betaRealSIMD,stateRealLoSIMD));
-            res1 = _mm256_sub_pd(res1,_mm256_mul_pd(betaImagSIMD,stateImagLoSIMD));
-
+        for(thisBlock=0; thisBlock<blockRange; thisBlock++){
+            taskEnd = fmin(blockEnd,(thisBlock+1)*blockSize);
 
-            //stateVecImag[indexUp] = alphaReal*stateImagUp + alphaImag*stateRealUp
-            //    - betaReal*stateImagLo + betaImag*stateRealLo;
-            __m256d res2 =  _mm256_mul_pd(alphaRealSIMD,stateImagUpSIMD);
-            res2 = _mm256_add_pd(res2,_mm256_mul_pd(alphaImagSIMD,stateRealUpSIMD));
-            res2 = _mm256_sub_pd(res2,_mm256_mul_pd(betaRealSIMD,stateImagLoSIMD));
-            res2 = _mm256_add_pd(res2,_mm256_mul_pd(betaImagSIMD,stateRealLoSIMD));
+            for(thisTask=thisBlock*blockSize+halfBlockSize; thisTask<taskEnd; thisTask+=SIMD_WIDTH){
+                stateRealUpSIMD = SIMD_LOAD(stateVecRealUp+thisTask);
+                stateImagUpSIMD = SIMD_LOAD(stateVecImagUp+thisTask);
 
-            // state[indexLo] = beta  * state[indexUp] + conj(alpha) * state[indexLo]
-            //stateVecReal[indexLo] = betaReal*stateRealUp - betaImag*stateImagUp
-            //    + alphaReal*stateRealLo + alphaImag*stateImagLo;
-            __m256d res3 = _mm256_mul_pd(betaRealSIMD,stateRealUpSIMD);
-            res3 = _mm256_sub_pd(res3,_mm256_mul_pd(betaImagSIMD,stateImagUpSIMD));
-            res3 = _mm256_add_pd(res3,_mm256_mul_pd(alphaRealSIMD,stateRealLoSIMD));
-            res3 = _mm256_add_pd(res3,_mm256_mul_pd(alphaImagSIMD,stateImagLoSIMD));
+                stateRealLoSIMD = SIMD_LOAD(stateVecRealLo+thisTask);
+                stateImagLoSIMD = SIMD_LOAD(stateVecImagLo+thisTask);
 
-            //stateVecImag[indexLo] = betaReal*stateImagUp + betaImag*stateRealUp
-            //    + alphaReal*stateImagLo - alphaImag*stateRealLo;
-            __m256d res4 = _mm256_mul_pd(betaRealSIMD,stateImagUpSIMD);
-            res4 = _mm256_add_pd(res4,_mm256_mul_pd(betaImagSIMD,stateRealUpSIMD));
-            res4 = _mm256_add_pd(res4,_mm256_mul_pd(alphaRealSIMD,stateImagLoSIMD));
-            res4 = _mm256_sub_pd(res4,_mm256_mul_pd(alphaImagSIMD,stateRealLoSIMD));
+                SIMD_STORE(stateVecRealOut+thisTask, SIMD_ADD( \
+                                SIMD_SUB(SIMD_MUL(rot1RealSIMD,stateRealUpSIMD),SIMD_MUL(rot1ImagSIMD,stateImagUpSIMD)), \
+                                SIMD_ADD(SIMD_MUL(rot2RealSIMD,stateRealLoSIMD),SIMD_MUL(rot2ImagSIMD,stateImagLoSIMD))));
 
-            _mm256_storeu_pd(stateVecReal+indexUp,res1);
-            _mm256_storeu_pd(stateVecImag+indexUp,res2);
-            _mm256_storeu_pd(stateVecReal+indexLo,res3);
-            _mm256_storeu_pd(stateVecImag+indexLo,res4);
+                SIMD_STORE(stateVecImagOut+thisTask, SIMD_ADD( \
+                                SIMD_ADD(SIMD_MUL(rot1RealSIMD,stateImagUpSIMD),SIMD_MUL(rot1ImagSIMD,stateRealUpSIMD)), \
+                                SIMD_SUB(SIMD_MUL(rot2RealSIMD,stateImagLoSIMD),SIMD_MUL(rot2ImagSIMD,stateRealLoSIMD))));
+            }
         }
     }
 # ifdef _OPENMP
-    } else { 
-        for (thisTask = 0; thisTask < numTasks; ++thisTask)
+    } else {
+        for(thisBlock=0; thisBlock<blockRange; thisBlock++){
+            taskEnd = fmin(blockEnd,(thisBlock+1)*blockSize);
 # pragma omp parallel \
-    shared   (thisTask,stateVecReal,stateVecImag, alphaRealSIMD,alphaImagSIMD, betaRealSIMD,betaImagSIMD) \
-    private  (indexUp,indexLo, stateRealUpSIMD,stateImagUpSIMD,stateRealLoSIMD,stateImagLoSIMD)
+    shared   (taskEnd,thisBlock,stateVecRealUp,stateVecImagUp,stateVecRealLo,stateVecImagLo,stateVecRealOut,stateVecImagOut, \
+            rot1RealSIMD,rot1ImagSIMD, rot2RealSIMD,rot2ImagSIMD) \
+    private  (thisTask,stateRealUpSIMD,stateImagUpSIMD,stateRealLoSIMD,stateImagLoSIMD)
     {
 # pragma omp for schedule (static)
-        for (indexUp = thisTask * sizeTask * 2; indexUp < thisTask * sizeTask * 2 + sizeTask; indexUp+=4) {
-
-            indexLo     = indexUp + sizeTask;
-
-            // store current state vector values in temp variables
-            stateRealUpSIMD = _mm256_loadu_pd(stateVecReal+indexUp);
-            stateImagUpSIMD = _mm256_loadu_pd(stateVecImag+indexUp);
-            stateRealLoSIMD = _mm256_loadu_pd(stateVecReal+indexLo);
-            stateImagLoSIMD = _mm256_loadu_pd(stateVecImag+indexLo);
-
-
-            // state[indexUp] = alpha * state[indexUp] - conj(beta)  * state[indexLo]
-            //stateVecReal[indexUp] = alphaReal*stateRealUp - alphaImag*stateImagUp
-            //    - betaReal*stateRealLo - betaImag*stateImagLo;
-            __m256d res1 =  _mm256_mul_pd(alphaRealSIMD,stateRealUpSIMD);
-            res1 = _mm256_sub_pd(res1,_mm256_mul_pd(alphaImagSIMD,stateImagUpSIMD));
-            res1 = _mm256_sub_pd(res1,_mm256_mul_pd(betaRealSIMD,stateRealLoSIMD));
-            res1 = _mm256_sub_pd(res1,_mm256_mul_pd(betaImagSIMD,stateImagLoSIMD));
-
+            for(thisTask=thisBlock*blockSize+halfBlockSize; thisTask<taskEnd; thisTask+=SIMD_WIDTH){
+                stateRealUpSIMD = SIMD_LOAD(stateVecRealUp+thisTask);
+                stateImagUpSIMD = SIMD_LOAD(stateVecImagUp+thisTask);
 
-            //stateVecImag[indexUp] = alphaReal*stateImagUp + alphaImag*stateRealUp
-            //    - betaReal*stateImagLo + betaImag*stateRealLo;
-            __m256d res2 =  _mm256_mul_pd(alphaRealSIMD,stateImagUpSIMD);
-            res2 = _mm256_add_pd(res2,_mm256_mul_pd(alphaImagSIMD,stateRealUpSIMD));
-            res2 = _mm256_sub_pd(res2,_mm256_mul_pd(betaRealSIMD,stateImagLoSIMD));
-            res2 = _mm256_add_pd(res2,_mm256_mul_pd(betaImagSIMD,stateRealLoSIMD));
-
-            // state[indexLo] = beta  * state[indexUp] + conj(alpha) * state[indexLo]
-            //stateVecReal[indexLo] = betaReal*stateRealUp - betaImag*stateImagUp
-            //    + alphaReal*stateRealLo + alphaImag*stateImagLo;
-            __m256d res3 = _mm256_mul_pd(betaRealSIMD,stateRealUpSIMD);
-            res3 = _mm256_sub_pd(res3,_mm256_mul_pd(betaImagSIMD,stateImagUpSIMD));
-            res3 = _mm256_add_pd(res3,_mm256_mul_pd(alphaRealSIMD,stateRealLoSIMD));
-            res3 = _mm256_add_pd(res3,_mm256_mul_pd(alphaImagSIMD,stateImagLoSIMD));
+                stateRealLoSIMD = SIMD_LOAD(stateVecRealLo+thisTask);
+                stateImagLoSIMD = SIMD_LOAD(stateVecImagLo+thisTask);
 
-            //stateVecImag[indexLo] = betaReal*stateImagUp + betaImag*stateRealUp
-            //    + alphaReal*stateImagLo - alphaImag*stateRealLo;
-            __m256d res4 = _mm256_mul_pd(betaRealSIMD,stateImagUpSIMD);
-            res4 = _mm256_add_pd(res4,_mm256_mul_pd(betaImagSIMD,stateRealUpSIMD));
-            res4 = _mm256_add_pd(res4,_mm256_mul_pd(alphaRealSIMD,stateImagLoSIMD));
-            res4 = _mm256_sub_pd(res4,_mm256_mul_pd(alphaImagSIMD,stateRealLoSIMD));
+                SIMD_STORE(stateVecRealOut+thisTask, SIMD_ADD( \
+                                SIMD_SUB(SIMD_MUL(rot1RealSIMD,stateRealUpSIMD),SIMD_MUL(rot1ImagSIMD,stateImagUpSIMD)), \
+                                SIMD_ADD(SIMD_MUL(rot2RealSIMD,stateRealLoSIMD),SIMD_MUL(rot2ImagSIMD,stateImagLoSIMD))));
 
-            _mm256_storeu_pd(stateVecReal+indexUp,res1);
-            _mm256_storeu_pd(stateVecImag+indexUp,res2);
-            _mm256_storeu_pd(stateVecReal+indexLo,res3);
-            _mm256_storeu_pd(stateVecImag+indexLo,res4);
+                SIMD_STORE(stateVecImagOut+thisTask, SIMD_ADD( \
+                                SIMD_ADD(SIMD_MUL(rot1RealSIMD,stateImagUpSIMD),SIMD_MUL(rot1ImagSIMD,stateRealUpSIMD)), \
+                                SIMD_SUB(SIMD_MUL(rot2RealSIMD,stateImagLoSIMD),SIMD_MUL(rot2ImagSIMD,stateRealLoSIMD))));
+            }
         }
     }
     }
-# endif
-
-
+#endif
 }
 
-void statevec_compactUnitaryLocal (Qureg qureg, const int targetQubit, Complex alpha, Complex beta)
+/** Rotate a single qubit in the state vector of probability amplitudes, given two complex
+ *  numbers alpha and beta and a subset of the state vector with upper and lower block values
+ *  stored seperately. Only perform the rotation where the control qubit is one.
+ *
+ *  @param[in,out] qureg object representing the set of qubits
+ *  @param[in] controlQubit qubit to determine whether or not to perform a rotation
+ *  @param[in] rot1 rotation angle
+ *  @param[in] rot2 rotation angle
+ *  @param[in] stateVecUp probability amplitudes in upper half of a block
+ *  @param[in] stateVecLo probability amplitudes in lower half of a block
+ *  @param[out] stateVecOut array section to update (will correspond to either the lower or upper half of a block)
+ */
+void statevec_controlledUnitaryDistributed (Qureg qureg, const int controlQubit,
+        Complex rot1, Complex rot2,
+        ComplexArray stateVecUp,
+        ComplexArray stateVecLo,
+        ComplexArray stateVecOut)
 {
-    long long int sizeBlock, sizeHalfBlock;
-    long long int thisBlock, // current block
-         indexUp,indexLo;    // current index and corresponding index in lower half block
 
-    qreal stateRealUp,stateRealLo,stateImagUp,stateImagLo;
+    qreal   stateRealUp,stateRealLo,stateImagUp,stateImagLo;
     long long int thisTask;
-    const long long int numTasks=qureg.numAmpsPerChunk>>1;
+    const long long int numTasks=qureg.numAmpsPerChunk;
+    const long long int chunkSize=qureg.numAmpsPerChunk;
+    const long long int chunkId=qureg.chunkId;
 
-    // set dimensions
-    sizeHalfBlock = 1LL << targetQubit;
-    sizeBlock     = 2LL * sizeHalfBlock;
+    int controlBit;
 
-    // Can't use qureg.stateVec as a private OMP var
-    qreal *stateVecReal = qureg.stateVec.real;
-    qreal *stateVecImag = qureg.stateVec.imag;
-    qreal alphaImag=alpha.imag, alphaReal=alpha.real;
-    qreal betaImag=beta.imag, betaReal=beta.real;
+    qreal rot1Real=rot1.real, rot1Imag=rot1.imag;
+    qreal rot2Real=rot2.real, rot2Imag=rot2.imag;
+    qreal *stateVecRealUp=stateVecUp.real, *stateVecImagUp=stateVecUp.imag;
+    qreal *stateVecRealLo=stateVecLo.real, *stateVecImagLo=stateVecLo.imag;
+    qreal *stateVecRealOut=stateVecOut.real, *stateVecImagOut=stateVecOut.imag;
 
 # ifdef _OPENMP
 # pragma omp parallel \
-    shared   (sizeBlock,sizeHalfBlock, stateVecReal,stateVecImag, alphaReal,alphaImag, betaReal,betaImag) \
-    private  (thisTask,thisBlock ,indexUp,indexLo, stateRealUp,stateImagUp,stateRealLo,stateImagLo)
+    shared   (stateVecRealUp,stateVecImagUp,stateVecRealLo,stateVecImagLo,stateVecRealOut,stateVecImagOut, \
+            rot1Real,rot1Imag, rot2Real,rot2Imag) \
+    private  (thisTask,stateRealUp,stateImagUp,stateRealLo,stateImagLo,controlBit)
 # endif
     {
 # ifdef _OPENMP
 # pragma omp for schedule (static)
 # endif
         for (thisTask=0; thisTask<numTasks; thisTask++) {
+            controlBit = extractBit (controlQubit, thisTask+chunkId*chunkSize);
+            if (controlBit){
+                // store current state vector values in temp variables
+                stateRealUp = stateVecRealUp[thisTask];
+                stateImagUp = stateVecImagUp[thisTask];
 
-            thisBlock   = thisTask / sizeHalfBlock;
-            indexUp     = thisBlock*sizeBlock + thisTask%sizeHalfBlock;
-            indexLo     = indexUp + sizeHalfBlock;
-
-            // store current state vector values in temp variables
-            stateRealUp = stateVecReal[indexUp];
-            stateImagUp = stateVecImag[indexUp];
-
-            stateRealLo = stateVecReal[indexLo];
-            stateImagLo = stateVecImag[indexLo];
-
-            // state[indexUp] = alpha * state[indexUp] - conj(beta)  * state[indexLo]
-            stateVecReal[indexUp] = alphaReal*stateRealUp - alphaImag*stateImagUp
-                - betaReal*stateRealLo - betaImag*stateImagLo;
-            stateVecImag[indexUp] = alphaReal*stateImagUp + alphaImag*stateRealUp
-                - betaReal*stateImagLo + betaImag*stateRealLo;
+                stateRealLo = stateVecRealLo[thisTask];
+                stateImagLo = stateVecImagLo[thisTask];
 
-            // state[indexLo] = beta  * state[indexUp] + conj(alpha) * state[indexLo]
-            stateVecReal[indexLo] = betaReal*stateRealUp - betaImag*stateImagUp
-                + alphaReal*stateRealLo + alphaImag*stateImagLo;
-            stateVecImag[indexLo] = betaReal*stateImagUp + betaImag*stateRealUp
-                + alphaReal*stateImagLo - alphaImag*stateRealLo;
+                stateVecRealOut[thisTask] = rot1Real*stateRealUp - rot1Imag*stateImagUp
+                    + rot2Real*stateRealLo - rot2Imag*stateImagLo;
+                stateVecImagOut[thisTask] = rot1Real*stateImagUp + rot1Imag*stateRealUp
+                    + rot2Real*stateImagLo + rot2Imag*stateRealLo;
+            }
         }
     }
-
 }
 
-void statevec_multiControlledTwoQubitUnitaryLocal(Qureg qureg, long long int ctrlMask, const int q1, const int q2, ComplexMatrix4 u) {
-
-    // can't use qureg.stateVec as a private OMP var
-    qreal *reVec = qureg.stateVec.real;
-    qreal *imVec = qureg.stateVec.imag;
-
-    // the global (between all nodes) index of this node's start index
-    long long int globalIndStart = qureg.chunkId*qureg.numAmpsPerChunk;
+/** Apply a unitary operation to a single qubit in the state vector of probability amplitudes, given
+ *  a subset of the state vector with upper and lower block values
+ stored seperately. Only perform the rotation where all the control qubits are 1.
+ *
+ *  @param[in,out] qureg object representing the set of qubits
+ *  @param[in] targetQubit qubit to rotate
+ *  @param[in] ctrlQubitsMask a bit mask indicating whether each qubit is a control (1) or not (0)
+ *  @param[in] ctrlFlipMask a bit mask indicating whether each qubit (only controls are relevant)
+ *             should be flipped when checking the control condition
+ *  @param[in] rot1 rotation angle
+ *  @param[in] rot2 rotation angle
+ *  @param[in] stateVecUp probability amplitudes in upper half of a block
+ *  @param[in] stateVecLo probability amplitudes in lower half of a block
+ *  @param[out] stateVecOut array section to update (will correspond to either the lower or upper half of a block)
+ */
+void statevec_multiControlledUnitaryDistributed (
+        Qureg qureg,
+        const int targetQubit,
+        long long int ctrlQubitsMask, long long int ctrlFlipMask,
+        Complex rot1, Complex rot2,
+        ComplexArray stateVecUp,
+        ComplexArray stateVecLo,
+        ComplexArray stateVecOut)
+{
 
-    long long int numTasks = qureg.numAmpsPerChunk >> 2; // each iteration updates 4 amplitudes
+    qreal   stateRealUp,stateRealLo,stateImagUp,stateImagLo;
     long long int thisTask;
-    long long int thisGlobalInd00;
-    long long int ind00, ind01, ind10, ind11;
-    qreal re00, re01, re10, re11;
-    qreal im00, im01, im10, im11;
+    const long long int numTasks=qureg.numAmpsPerChunk;
+    const long long int chunkSize=qureg.numAmpsPerChunk;
+    const long long int chunkId=qureg.chunkId;
+
+    qreal rot1Real=rot1.real, rot1Imag=rot1.imag;
+    qreal rot2Real=rot2.real, rot2Imag=rot2.imag;
+    qreal *stateVecRealUp=stateVecUp.real, *stateVecImagUp=stateVecUp.imag;
+    qreal *stateVecRealLo=stateVecLo.real, *stateVecImagLo=stateVecLo.imag;
+    qreal *stateVecRealOut=stateVecOut.real, *stateVecImagOut=stateVecOut.imag;
 
 # ifdef _OPENMP
 # pragma omp parallel \
-    shared   (reVec,imVec,globalIndStart,numTasks,ctrlMask,u) \
-    private  (thisTask, thisGlobalInd00, ind00,ind01,ind10,ind11, re00,re01,re10,re11, im00,im01,im10,im11)
+    shared   (stateVecRealUp,stateVecImagUp,stateVecRealLo,stateVecImagLo,stateVecRealOut,stateVecImagOut, \
+            rot1Real,rot1Imag, rot2Real,rot2Imag, ctrlQubitsMask,ctrlFlipMask) \
+    private  (thisTask,stateRealUp,stateImagUp,stateRealLo,stateImagLo)
 # endif
     {
 # ifdef _OPENMP
 # pragma omp for schedule (static)
 # endif
         for (thisTask=0; thisTask<numTasks; thisTask++) {
+            if (ctrlQubitsMask == (ctrlQubitsMask & ((thisTask+chunkId*chunkSize) ^ ctrlFlipMask))) {
+                // store current state vector values in temp variables
+                stateRealUp = stateVecRealUp[thisTask];
+                stateImagUp = stateVecImagUp[thisTask];
 
-            // determine ind00 of |..0..0..>
-            ind00 = insertTwoZeroBits(thisTask, q1, q2);
-
-            // skip amplitude if controls aren't in 1 state (overloaded for speed)
-            thisGlobalInd00 = ind00 + globalIndStart;
-            if (ctrlMask && ((ctrlMask & thisGlobalInd00) != ctrlMask))
-                continue;
-
-            // inds of |..0..1..>, |..1..0..> and |..1..1..>
-            ind01 = flipBit(ind00, q1);
-            ind10 = flipBit(ind00, q2);
-            ind11 = flipBit(ind01, q2);
-
-            // extract statevec amplitudes
-            re00 = reVec[ind00]; im00 = imVec[ind00];
-            re01 = reVec[ind01]; im01 = imVec[ind01];
-            re10 = reVec[ind10]; im10 = imVec[ind10];
-            re11 = reVec[ind11]; im11 = imVec[ind11];
-
-            // apply u * {amp00, amp01, amp10, amp11}
-            reVec[ind00] =
-                u.real[0][0]*re00 - u.imag[0][0]*im00 +
-                u.real[0][1]*re01 - u.imag[0][1]*im01 +
-                u.real[0][2]*re10 - u.imag[0][2]*im10 +
-                u.real[0][3]*re11 - u.imag[0][3]*im11;
-            imVec[ind00] =
-                u.imag[0][0]*re00 + u.real[0][0]*im00 +
-                u.imag[0][1]*re01 + u.real[0][1]*im01 +
-                u.imag[0][2]*re10 + u.real[0][2]*im10 +
-                u.imag[0][3]*re11 + u.real[0][3]*im11;
-
-            reVec[ind01] =
-                u.real[1][0]*re00 - u.imag[1][0]*im00 +
-                u.real[1][1]*re01 - u.imag[1][1]*im01 +
-                u.real[1][2]*re10 - u.imag[1][2]*im10 +
-                u.real[1][3]*re11 - u.imag[1][3]*im11;
-            imVec[ind01] =
-                u.imag[1][0]*re00 + u.real[1][0]*im00 +
-                u.imag[1][1]*re01 + u.real[1][1]*im01 +
-                u.imag[1][2]*re10 + u.real[1][2]*im10 +
-                u.imag[1][3]*re11 + u.real[1][3]*im11;
-
-            reVec[ind10] =
-                u.real[2][0]*re00 - u.imag[2][0]*im00 +
-                u.real[2][1]*re01 - u.imag[2][1]*im01 +
-                u.real[2][2]*re10 - u.imag[2][2]*im10 +
-                u.real[2][3]*re11 - u.imag[2][3]*im11;
-            imVec[ind10] =
-                u.imag[2][0]*re00 + u.real[2][0]*im00 +
-                u.imag[2][1]*re01 + u.real[2][1]*im01 +
-                u.imag[2][2]*re10 + u.real[2][2]*im10 +
-                u.imag[2][3]*re11 + u.real[2][3]*im11;
+                stateRealLo = stateVecRealLo[thisTask];
+                stateImagLo = stateVecImagLo[thisTask];
 
-            reVec[ind11] =
-                u.real[3][0]*re00 - u.imag[3][0]*im00 +
-                u.real[3][1]*re01 - u.imag[3][1]*im01 +
-                u.real[3][2]*re10 - u.imag[3][2]*im10 +
-                u.real[3][3]*re11 - u.imag[3][3]*im11;
-            imVec[ind11] =
-                u.imag[3][0]*re00 + u.real[3][0]*im00 +
-                u.imag[3][1]*re01 + u.real[3][1]*im01 +
-                u.imag[3][2]*re10 + u.real[3][2]*im10 +
-                u.imag[3][3]*re11 + u.real[3][3]*im11;
+                stateVecRealOut[thisTask] = rot1Real*stateRealUp - rot1Imag*stateImagUp
+                    + rot2Real*stateRealLo - rot2Imag*stateImagLo;
+                stateVecImagOut[thisTask] = rot1Real*stateImagUp + rot1Imag*stateRealUp
+                    + rot2Real*stateImagLo + rot2Imag*stateRealLo;
+            }
         }
-    }
-}
-
-int qsortComp(const void *a, const void *b) {
-    return *(int*)a - *(int*)b;
-}
-
-void statevec_multiControlledMultiQubitUnitaryLocal(Qureg qureg, long long int ctrlMask, int* targs, const int numTargs, ComplexMatrixN u)
-{
-    // can't use qureg.stateVec as a private OMP var
-    qreal *reVec = qureg.stateVec.real;
-    qreal *imVec = qureg.stateVec.imag;
-
-    long long int numTasks = qureg.numAmpsPerChunk >> numTargs;  // kernel called on every 1 in 2^numTargs amplitudes
-    long long int numTargAmps = 1 << u.numQubits;  // num amps to be modified by each task
-
-    // the global (between all nodes) index of this node's start index
-    long long int globalIndStart = qureg.chunkId*qureg.numAmpsPerChunk;
+    }
+}
 
-    long long int thisTask;
-    long long int thisInd00; // this thread's index of |..0..0..> (target qubits = 0)
-    long long int thisGlobalInd00; // the global (between all nodes) index of this thread's |..0..0..> state
-    long long int ind;   // each thread's iteration of amplitudes to modify
-    int i, t, r, c;  // each thread's iteration of amps and targets
-    qreal reElem, imElem;  // each thread's iteration of u elements
+void statevec_pauliXLocalSmall(Qureg qureg, const int targetQubit)
+{
+    long long int indexUp,indexLo;    // current index and corresponding index in lower half block
 
-    // each thread/task will record and modify numTargAmps amplitudes, privately
-    // (of course, tasks eliminated by the ctrlMask won't edit their allocation)
-    long long int ampInds[numTargAmps];
-    qreal reAmps[numTargAmps];
-    qreal imAmps[numTargAmps];
+    qreal stateRealUp,stateImagUp;
+    const long long int numTasks = (qureg.numAmpsPerChunk>>(1 + targetQubit)) ;
+    const long long int sizeTask = (1LL << targetQubit);
+    long long thisTask;
 
-    // we need a sorted targets list to find thisInd00 for each task.
-    // we can't modify targets, because the user-ordering of targets matters in u
-    int sortedTargs[numTargs];
-    for (int t=0; t < numTargs; t++)
-        sortedTargs[t] = targs[t];
-    qsort(sortedTargs, numTargs, sizeof(int), qsortComp);
+    // Can't use qureg.stateVec as a private OMP var
+    qreal *stateVecReal = qureg.stateVec.real;
+    qreal *stateVecImag = qureg.stateVec.imag;
 
 # ifdef _OPENMP
+    if(numTasks >= omp_get_num_threads()){
 # pragma omp parallel \
-    shared   (reVec,imVec, numTasks,numTargAmps,globalIndStart, ctrlMask,targs,sortedTargs,u) \
-    private  (thisTask,thisInd00,thisGlobalInd00,ind,i,t,r,c,reElem,imElem,  ampInds,reAmps,imAmps)
+    shared   (stateVecReal,stateVecImag) \
+    private  (thisTask,indexUp,indexLo, stateRealUp,stateImagUp)
 # endif
     {
 # ifdef _OPENMP
 # pragma omp for schedule (static)
 # endif
-        for (thisTask=0; thisTask<numTasks; thisTask++) {
+        for (thisTask = 0; thisTask < numTasks; ++thisTask)
+        for (indexUp = thisTask * sizeTask * 2; indexUp < thisTask * sizeTask * 2 + sizeTask; ++ indexUp) {
 
-            // find this task's start index (where all targs are 0)
-            thisInd00 = thisTask;
-            for (t=0; t < numTargs; t++)
-                thisInd00 = insertZeroBit(thisInd00, sortedTargs[t]);
+            indexLo     = indexUp + sizeTask;
 
-            // this task only modifies amplitudes if control qubits are 1 for this state
-            thisGlobalInd00 = thisInd00 + globalIndStart;
-            if (ctrlMask && ((ctrlMask & thisGlobalInd00) != ctrlMask))
-                continue;
+            stateRealUp = stateVecReal[indexUp];
+            stateImagUp = stateVecImag[indexUp];
 
-            // determine the indices and record values of this tasks's target amps
-            for (i=0; i < numTargAmps; i++) {
+            stateVecReal[indexUp] = stateVecReal[indexLo];
+            stateVecImag[indexUp] = stateVecImag[indexLo];
 
-                // get statevec index of current target qubit assignment
-                ind = thisInd00;
-                for (t=0; t < numTargs; t++)
-                    if (extractBit(t, i))
-                        ind = flipBit(ind, targs[t]);
+            stateVecReal[indexLo] = stateRealUp;
+            stateVecImag[indexLo] = stateImagUp;
+        }
+    }
+# ifdef _OPENMP
+    }else {
+        for (thisTask = 0; thisTask < numTasks; ++thisTask)
 
-                // update this tasks's private arrays
-                ampInds[i] = ind;
-                reAmps [i] = reVec[ind];
-                imAmps [i] = imVec[ind];
-            }
+# pragma omp parallel \
+    shared   (thisTask,stateVecReal,stateVecImag) \
+    private  (indexUp,indexLo, stateRealUp,stateImagUp)
+    {
+# pragma omp for schedule (static)
+        for (indexUp = thisTask * sizeTask * 2; indexUp < thisTask * sizeTask * 2 + sizeTask; ++ indexUp) {
 
-            // modify this tasks's target amplitudes
-            for (r=0; r < numTargAmps; r++) {
-                ind = ampInds[r];
-                reVec[ind] = 0;
-                imVec[ind] = 0;
+            indexLo     = indexUp + sizeTask;
 
-                for (c=0; c < numTargAmps; c++) {
-                    reElem = u.real[r][c];
-                    imElem = u.imag[r][c];
-                    reVec[ind] += reAmps[c]*reElem - imAmps[c]*imElem;
-                    imVec[ind] += reAmps[c]*imElem + imAmps[c]*reElem;
-                }
-            }
+            stateRealUp = stateVecReal[indexUp];
+            stateImagUp = stateVecImag[indexUp];
+
+            stateVecReal[indexUp] = stateVecReal[indexLo];
+            stateVecImag[indexUp] = stateVecImag[indexLo];
+
+            stateVecReal[indexLo] = stateRealUp;
+            stateVecImag[indexLo] = stateImagUp;
         }
     }
+    }
+# endif
 }
 
-void statevec_unitaryLocal(Qureg qureg, const int targetQubit, ComplexMatrix2 u)
+void statevec_pauliXLocal(Qureg qureg, const int targetQubit)
 {
     long long int sizeBlock, sizeHalfBlock;
     long long int thisBlock, // current block
          indexUp,indexLo;    // current index and corresponding index in lower half block
 
-    qreal stateRealUp,stateRealLo,stateImagUp,stateImagLo;
+    qreal stateRealUp,stateImagUp;
     long long int thisTask;
     const long long int numTasks=qureg.numAmpsPerChunk>>1;
 
@@ -2105,216 +4998,295 @@ void statevec_unitaryLocal(Qureg qureg, const int targetQubit, ComplexMatrix2 u)
 
 # ifdef _OPENMP
 # pragma omp parallel \
-    shared   (sizeBlock,sizeHalfBlock, stateVecReal,stateVecImag, u) \
-    private  (thisTask,thisBlock ,indexUp,indexLo, stateRealUp,stateImagUp,stateRealLo,stateImagLo)
+    shared   (sizeBlock,sizeHalfBlock, stateVecReal,stateVecImag) \
+    private  (thisTask,thisBlock ,indexUp,indexLo, stateRealUp,stateImagUp)
 # endif
     {
 # ifdef _OPENMP
 # pragma omp for schedule (static)
 # endif
         for (thisTask=0; thisTask<numTasks; thisTask++) {
-
             thisBlock   = thisTask / sizeHalfBlock;
             indexUp     = thisBlock*sizeBlock + thisTask%sizeHalfBlock;
             indexLo     = indexUp + sizeHalfBlock;
 
-            // store current state vector values in temp variables
             stateRealUp = stateVecReal[indexUp];
             stateImagUp = stateVecImag[indexUp];
 
-            stateRealLo = stateVecReal[indexLo];
-            stateImagLo = stateVecImag[indexLo];
-
-
-            // state[indexUp] = u00 * state[indexUp] + u01 * state[indexLo]
-            stateVecReal[indexUp] = u.real[0][0]*stateRealUp - u.imag[0][0]*stateImagUp
-                + u.real[0][1]*stateRealLo - u.imag[0][1]*stateImagLo;
-            stateVecImag[indexUp] = u.real[0][0]*stateImagUp + u.imag[0][0]*stateRealUp
-                + u.real[0][1]*stateImagLo + u.imag[0][1]*stateRealLo;
-
-            // state[indexLo] = u10  * state[indexUp] + u11 * state[indexLo]
-            stateVecReal[indexLo] = u.real[1][0]*stateRealUp  - u.imag[1][0]*stateImagUp
-                + u.real[1][1]*stateRealLo  -  u.imag[1][1]*stateImagLo;
-            stateVecImag[indexLo] = u.real[1][0]*stateImagUp + u.imag[1][0]*stateRealUp
-                + u.real[1][1]*stateImagLo + u.imag[1][1]*stateRealLo;
+            stateVecReal[indexUp] = stateVecReal[indexLo];
+            stateVecImag[indexUp] = stateVecImag[indexLo];
 
+            stateVecReal[indexLo] = stateRealUp;
+            stateVecImag[indexLo] = stateImagUp;
         }
     }
+
 }
 
-/** Rotate a single qubit in the state vector of probability amplitudes,
- * given two complex numbers alpha and beta,
- * and a subset of the state vector with upper and lower block values stored seperately.
+/** Rotate a single qubit by {{0,1},{1,0}.
+ *  Operate on a subset of the state vector with upper and lower block values
+ *  stored seperately. This rotation is just swapping upper and lower values, and
+ *  stateVecIn must already be the correct section for this chunk
+ *
+ *  @remarks Qubits are zero-based and the
+ *  the first qubit is the rightmost
  *
  *  @param[in,out] qureg object representing the set of qubits
- *  @param[in] rot1 rotation angle
- *  @param[in] rot2 rotation angle
- *  @param[in] stateVecUp probability amplitudes in upper half of a block
- *  @param[in] stateVecLo probability amplitudes in lower half of a block
+ *  @param[in] stateVecIn probability amplitudes in lower or upper half of a block depending on chunkId
  *  @param[out] stateVecOut array section to update (will correspond to either the lower or upper half of a block)
  */
-void statevec_compactUnitaryDistributed (Qureg qureg,
-        Complex rot1, Complex rot2,
-        ComplexArray stateVecUp,
-        ComplexArray stateVecLo,
+void statevec_pauliXDistributed (Qureg qureg,
+        ComplexArray stateVecIn,
         ComplexArray stateVecOut)
 {
 
-    qreal   stateRealUp,stateRealLo,stateImagUp,stateImagLo;
     long long int thisTask;
     const long long int numTasks=qureg.numAmpsPerChunk;
-    if(numTasks >= 4){
-        statevec_compactUnitaryDistributedSIMD(qureg,rot1,rot2,stateVecUp,stateVecLo,stateVecOut);
+
+    qreal *stateVecRealIn=stateVecIn.real, *stateVecImagIn=stateVecIn.imag;
+    qreal *stateVecRealOut=stateVecOut.real, *stateVecImagOut=stateVecOut.imag;
+
+# ifdef _OPENMP
+# pragma omp parallel \
+    shared   (stateVecRealIn,stateVecImagIn,stateVecRealOut,stateVecImagOut) \
+    private  (thisTask)
+# endif
+    {
+# ifdef _OPENMP
+# pragma omp for schedule (static)
+# endif
+        for (thisTask=0; thisTask<numTasks; thisTask++) {
+            stateVecRealOut[thisTask] = stateVecRealIn[thisTask];
+            stateVecImagOut[thisTask] = stateVecImagIn[thisTask];
+        }
+    }
+}
+void statevec_controlledNotLocalAll(Qureg qureg, const int controlQubit, const int targetQubit)
+{
+    long long int sizeBlock, sizeHalfBlock;
+    long long int thisBlock, // current block
+         indexUp,indexLo;    // current index and corresponding index in lower half block
+
+    qreal stateRealUp,stateImagUp;
+    long long int thisTask;
+    const long long int numTasks=qureg.numAmpsPerChunk>>1;
+    
+    // set dimensions
+    sizeHalfBlock = 1LL << targetQubit;
+    sizeBlock     = 2LL * sizeHalfBlock;
+
+    // Can't use qureg.stateVec as a private OMP var
+    qreal *stateVecReal = qureg.stateVec.real;
+    qreal *stateVecImag = qureg.stateVec.imag;
+
+# ifdef _OPENMP
+# pragma omp parallel \
+    shared   (sizeBlock,sizeHalfBlock, stateVecReal,stateVecImag) \
+    private  (thisTask,thisBlock ,indexUp,indexLo, stateRealUp,stateImagUp)
+# endif
+    {
+# ifdef _OPENMP
+# pragma omp for schedule (static)
+# endif
+        for (thisTask=0; thisTask<numTasks; thisTask++) {
+            thisBlock   = thisTask / sizeHalfBlock;
+            indexUp     = thisBlock*sizeBlock + thisTask%sizeHalfBlock;
+            indexLo     = indexUp + sizeHalfBlock;
+            stateRealUp = stateVecReal[indexUp];
+            stateImagUp = stateVecImag[indexUp];
+
+            stateVecReal[indexUp] = stateVecReal[indexLo];
+            stateVecImag[indexUp] = stateVecImag[indexLo];
+
+            stateVecReal[indexLo] = stateRealUp;
+            stateVecImag[indexLo] = stateImagUp;
+        }
+    }
+}
+void statevec_controlledNotLocalSmall(Qureg qureg, const int controlQubit, const int targetQubit)
+{
+    long long int sizeBlock, sizeHalfBlock;
+    long long int thisBlock, // current block
+         indexUp,indexLo;    // current index and corresponding index in lower half block
+
+    qreal stateRealUp,stateImagUp;
+    if((1LL<<controlQubit)>=qureg.numAmpsPerChunk) {
+        if(extractBit(controlQubit,qureg.chunkId*qureg.numAmpsPerChunk)) {
+            statevec_controlledNotLocalAll(qureg,controlQubit,targetQubit);
+        }
         return ;
     }
+    long long int thisTask;
+    const long long int numTasks = ((targetQubit > controlQubit) ? (1LL << (targetQubit - controlQubit - 1)) : (1LL << (controlQubit - targetQubit - 1)));
+    // const long long int chunkSize=qureg.numAmpsPerChunk;
+    // const long long int chunkId=qureg.chunkId;
+    const long long int numBlocks = ((targetQubit > controlQubit) ? (qureg.numAmpsPerChunk>>(1 + targetQubit)) : (qureg.numAmpsPerChunk>>(1 + controlQubit)));
+    const long long int sizeTask = ((targetQubit > controlQubit) ? (1LL << controlQubit) : (1LL << targetQubit));
+    const long long int blockOffset = 1LL << controlQubit;
+
+    sizeHalfBlock = 1LL << targetQubit;
+    sizeBlock     = ((targetQubit > controlQubit) ? (2LL * sizeHalfBlock) : (2LL << controlQubit));
+
+
+    // Can't use qureg.stateVec as a private OMP var
+    qreal *stateVecReal = qureg.stateVec.real;
+    qreal *stateVecImag = qureg.stateVec.imag;
+
+# ifdef _OPENMP
+    if(numBlocks >= omp_get_num_threads()) {
+# pragma omp parallel \
+    shared   (sizeBlock,sizeHalfBlock, stateVecReal,stateVecImag,blockOffset) \
+    private  (thisTask,thisBlock ,indexUp,indexLo, stateRealUp,stateImagUp)
+# endif
+    {
+# ifdef _OPENMP
+# pragma omp for schedule (static)
+# endif
+        for (thisBlock = 0; thisBlock < numBlocks; ++thisBlock) {
+            for(thisTask = 0; thisTask < numTasks; ++thisTask) {
+                for(indexUp = thisBlock * sizeBlock + sizeTask * thisTask * 2 + blockOffset; indexUp < thisBlock * sizeBlock + sizeTask * thisTask * 2 + sizeTask + blockOffset; ++indexUp) {
+                    indexLo     = indexUp + sizeHalfBlock;
+
+                    stateRealUp = stateVecReal[indexUp];
+                    stateImagUp = stateVecImag[indexUp];
 
-    qreal rot1Real=rot1.real, rot1Imag=rot1.imag;
-    qreal rot2Real=rot2.real, rot2Imag=rot2.imag;
-    qreal *stateVecRealUp=stateVecUp.real, *stateVecImagUp=stateVecUp.imag;
-    qreal *stateVecRealLo=stateVecLo.real, *stateVecImagLo=stateVecLo.imag;
-    qreal *stateVecRealOut=stateVecOut.real, *stateVecImagOut=stateVecOut.imag;
+                    stateVecReal[indexUp] = stateVecReal[indexLo];
+                    stateVecImag[indexUp] = stateVecImag[indexLo];
 
+                    stateVecReal[indexLo] = stateRealUp;
+                    stateVecImag[indexLo] = stateImagUp;
+                }
+            }
+        }
+    }
 # ifdef _OPENMP
+    } else {
+        for (thisBlock = 0; thisBlock < numBlocks; ++thisBlock) {
 # pragma omp parallel \
-    shared   (stateVecRealUp,stateVecImagUp,stateVecRealLo,stateVecImagLo,stateVecRealOut,stateVecImagOut, \
-            rot1Real,rot1Imag, rot2Real,rot2Imag) \
-    private  (thisTask,stateRealUp,stateImagUp,stateRealLo,stateImagLo)
-# endif
+    shared   (thisBlock,sizeBlock,sizeHalfBlock, stateVecReal,stateVecImag,blockOffset) \
+    private  (thisTask ,indexUp,indexLo, stateRealUp,stateImagUp)
     {
-# ifdef _OPENMP
 # pragma omp for schedule (static)
-# endif
-        for (thisTask=0; thisTask<numTasks; thisTask++) {
-            // store current state vector values in temp variables
-            stateRealUp = stateVecRealUp[thisTask];
-            stateImagUp = stateVecImagUp[thisTask];
+            for(thisTask = 0; thisTask < numTasks; ++thisTask) {
+                for(indexUp = thisBlock * sizeBlock + sizeTask * thisTask * 2 + blockOffset; indexUp < thisBlock * sizeBlock + sizeTask * thisTask * 2 + sizeTask + blockOffset; ++indexUp) {
+                    indexLo     = indexUp + sizeHalfBlock;
 
-            stateRealLo = stateVecRealLo[thisTask];
-            stateImagLo = stateVecImagLo[thisTask];
+                    stateRealUp = stateVecReal[indexUp];
+                    stateImagUp = stateVecImag[indexUp];
 
-            // state[indexUp] = alpha * state[indexUp] - conj(beta)  * state[indexLo]
-            stateVecRealOut[thisTask] = rot1Real*stateRealUp - rot1Imag*stateImagUp + rot2Real*stateRealLo + rot2Imag*stateImagLo;
-            stateVecImagOut[thisTask] = rot1Real*stateImagUp + rot1Imag*stateRealUp + rot2Real*stateImagLo - rot2Imag*stateRealLo;
+                    stateVecReal[indexUp] = stateVecReal[indexLo];
+                    stateVecImag[indexUp] = stateVecImag[indexLo];
+
+                    stateVecReal[indexLo] = stateRealUp;
+                    stateVecImag[indexLo] = stateImagUp;
+                }
+            }
         }
     }
+    }
+#endif
 }
 
-void statevec_compactUnitaryDistributedSIMD (Qureg qureg,
-        Complex rot1, Complex rot2,
-        ComplexArray stateVecUp,
-        ComplexArray stateVecLo,
-        ComplexArray stateVecOut)
+void statevec_controlledNotLocal(Qureg qureg, const int controlQubit, const int targetQubit)
 {
+    long long int sizeBlock, sizeHalfBlock;
+    long long int thisBlock, // current block
+         indexUp,indexLo;    // current index and corresponding index in lower half block
 
+    qreal stateRealUp,stateImagUp;
     long long int thisTask;
-    const long long int numTasks=qureg.numAmpsPerChunk;
+    const long long int numTasks=qureg.numAmpsPerChunk>>1;
+    const long long int chunkSize=qureg.numAmpsPerChunk;
+    const long long int chunkId=qureg.chunkId;
 
-    qreal rot1Real=rot1.real, rot1Imag=rot1.imag;
-    qreal rot2Real=rot2.real, rot2Imag=rot2.imag;
-    qreal *stateVecRealUp=stateVecUp.real, *stateVecImagUp=stateVecUp.imag;
-    qreal *stateVecRealLo=stateVecLo.real, *stateVecImagLo=stateVecLo.imag;
-    qreal *stateVecRealOut=stateVecOut.real, *stateVecImagOut=stateVecOut.imag;
+    int controlBit;
+
+    // set dimensions
+    sizeHalfBlock = 1LL << targetQubit;
+    sizeBlock     = 2LL * sizeHalfBlock;
 
-    __m256d stateRealUpSIMD,stateRealLoSIMD,stateImagUpSIMD,stateImagLoSIMD;
-    register const __m256d rot1RealSIMD = _mm256_set1_pd(rot1Real);
-    register const __m256d rot1ImagSIMD = _mm256_set1_pd(rot1Imag);
-    register const __m256d rot2RealSIMD = _mm256_set1_pd(rot2Real);
-    register const __m256d rot2ImagSIMD = _mm256_set1_pd(rot2Imag);
+    // Can't use qureg.stateVec as a private OMP var
+    qreal *stateVecReal = qureg.stateVec.real;
+    qreal *stateVecImag = qureg.stateVec.imag;
 
 # ifdef _OPENMP
 # pragma omp parallel \
-    shared   (stateVecRealUp,stateVecImagUp,stateVecRealLo,stateVecImagLo,stateVecRealOut,stateVecImagOut, \
-            rot1RealSIMD,rot1ImagSIMD, rot2RealSIMD,rot2ImagSIMD) \
-    private  (thisTask,stateRealUpSIMD,stateImagUpSIMD,stateRealLoSIMD,stateImagLoSIMD)
+    shared   (sizeBlock,sizeHalfBlock, stateVecReal,stateVecImag) \
+    private  (thisTask,thisBlock ,indexUp,indexLo, stateRealUp,stateImagUp,controlBit)
 # endif
     {
 # ifdef _OPENMP
 # pragma omp for schedule (static)
 # endif
-        for (thisTask=0; thisTask<numTasks; thisTask+=4) {
-            // store current state vector values in temp variables
-            stateRealUpSIMD = _mm256_loadu_pd(stateVecRealUp+thisTask);
-            stateImagUpSIMD = _mm256_loadu_pd(stateVecImagUp+thisTask);
+        for (thisTask=0; thisTask<numTasks; thisTask++) {
+            thisBlock   = thisTask / sizeHalfBlock;
+            indexUp     = thisBlock*sizeBlock + thisTask%sizeHalfBlock;
+            indexLo     = indexUp + sizeHalfBlock;
 
-            stateRealLoSIMD = _mm256_loadu_pd(stateVecRealLo+thisTask);
-            stateImagLoSIMD = _mm256_loadu_pd(stateVecImagLo+thisTask);
+            controlBit = extractBit(controlQubit, indexUp+chunkId*chunkSize);
+            if (controlBit){
+                stateRealUp = stateVecReal[indexUp];
+                stateImagUp = stateVecImag[indexUp];
 
-            // state[indexUp] = alpha * state[indexUp] - conj(beta)  * state[indexLo]
-            //stateVecRealOut[thisTask] = rot1Real*stateRealUp - rot1Imag*stateImagUp + rot2Real*stateRealLo + rot2Imag*stateImagLo;
-            //stateVecImagOut[thisTask] = rot1Real*stateImagUp + rot1Imag*stateRealUp + rot2Real*stateImagLo - rot2Imag*stateRealLo;
-            _mm256_storeu_pd(stateVecRealOut+thisTask, _mm256_add_pd( \
-                                _mm256_sub_pd(_mm256_mul_pd(rot1RealSIMD,stateRealUpSIMD),_mm256_mul_pd(rot1ImagSIMD,stateImagUpSIMD)), \
-                                _mm256_add_pd(_mm256_mul_pd(rot2RealSIMD,stateRealLoSIMD),_mm256_mul_pd(rot2ImagSIMD,stateImagLoSIMD))));
+                stateVecReal[indexUp] = stateVecReal[indexLo];
+                stateVecImag[indexUp] = stateVecImag[indexLo];
 
-            _mm256_storeu_pd(stateVecImagOut+thisTask, _mm256_add_pd( \
-                                _mm256_add_pd(_mm256_mul_pd(rot1RealSIMD,stateImagUpSIMD),_mm256_mul_pd(rot1ImagSIMD,stateRealUpSIMD)), \
-                                _mm256_sub_pd(_mm256_mul_pd(rot2RealSIMD,stateImagLoSIMD),_mm256_mul_pd(rot2ImagSIMD,stateRealLoSIMD))));
+                stateVecReal[indexLo] = stateRealUp;
+                stateVecImag[indexLo] = stateImagUp;
+            }
         }
     }
 }
 
-/** Apply a unitary operation to a single qubit
- *  given a subset of the state vector with upper and lower block values
- * stored seperately.
- *
- *  @remarks Qubits are zero-based and the first qubit is the rightmost
+/** Rotate a single qubit by {{0,1},{1,0}.
+ *  Operate on a subset of the state vector with upper and lower block values
+ *  stored seperately. This rotation is just swapping upper and lower values, and
+ *  stateVecIn must already be the correct section for this chunk. Only perform the rotation
+ *  for elements where controlQubit is one.
  *
  *  @param[in,out] qureg object representing the set of qubits
- *  @param[in] u unitary matrix to apply
- *  @param[in] stateVecUp probability amplitudes in upper half of a block
- *  @param[in] stateVecLo probability amplitudes in lower half of a block
+ *  @param[in] stateVecIn probability amplitudes in lower or upper half of a block depending on chunkId
  *  @param[out] stateVecOut array section to update (will correspond to either the lower or upper half of a block)
  */
-void statevec_unitaryDistributed (Qureg qureg,
-        Complex rot1, Complex rot2,
-        ComplexArray stateVecUp,
-        ComplexArray stateVecLo,
+void statevec_controlledNotDistributed (Qureg qureg, const int controlQubit,
+        ComplexArray stateVecIn,
         ComplexArray stateVecOut)
 {
 
-    qreal   stateRealUp,stateRealLo,stateImagUp,stateImagLo;
     long long int thisTask;
     const long long int numTasks=qureg.numAmpsPerChunk;
+    const long long int chunkSize=qureg.numAmpsPerChunk;
+    const long long int chunkId=qureg.chunkId;
 
-    qreal rot1Real=rot1.real, rot1Imag=rot1.imag;
-    qreal rot2Real=rot2.real, rot2Imag=rot2.imag;
-    qreal *stateVecRealUp=stateVecUp.real, *stateVecImagUp=stateVecUp.imag;
-    qreal *stateVecRealLo=stateVecLo.real, *stateVecImagLo=stateVecLo.imag;
-    qreal *stateVecRealOut=stateVecOut.real, *stateVecImagOut=stateVecOut.imag;
+    int controlBit;
 
+    qreal *stateVecRealIn=stateVecIn.real, *stateVecImagIn=stateVecIn.imag;
+    qreal *stateVecRealOut=stateVecOut.real, *stateVecImagOut=stateVecOut.imag;
 
 # ifdef _OPENMP
 # pragma omp parallel \
-    shared   (stateVecRealUp,stateVecImagUp,stateVecRealLo,stateVecImagLo,stateVecRealOut,stateVecImagOut, \
-            rot1Real, rot1Imag, rot2Real, rot2Imag) \
-    private  (thisTask,stateRealUp,stateImagUp,stateRealLo,stateImagLo)
+    shared   (stateVecRealIn,stateVecImagIn,stateVecRealOut,stateVecImagOut) \
+    private  (thisTask,controlBit)
 # endif
     {
 # ifdef _OPENMP
 # pragma omp for schedule (static)
 # endif
         for (thisTask=0; thisTask<numTasks; thisTask++) {
-            // store current state vector values in temp variables
-            stateRealUp = stateVecRealUp[thisTask];
-            stateImagUp = stateVecImagUp[thisTask];
-
-            stateRealLo = stateVecRealLo[thisTask];
-            stateImagLo = stateVecImagLo[thisTask];
-
-            stateVecRealOut[thisTask] = rot1Real*stateRealUp - rot1Imag*stateImagUp
-                + rot2Real*stateRealLo - rot2Imag*stateImagLo;
-            stateVecImagOut[thisTask] = rot1Real*stateImagUp + rot1Imag*stateRealUp
-                + rot2Real*stateImagLo + rot2Imag*stateRealLo;
+            controlBit = extractBit (controlQubit, thisTask+chunkId*chunkSize);
+            if (controlBit){
+                stateVecRealOut[thisTask] = stateVecRealIn[thisTask];
+                stateVecImagOut[thisTask] = stateVecImagIn[thisTask];
+            }
         }
     }
 }
 
-
-void statevec_controlledCompactUnitaryLocalAllSmallSIMD (Qureg qureg, const int controlQubit, const int targetQubit,
-        Complex alpha, Complex beta)
+void statevec_pauliYLocalSmall(Qureg qureg, const int targetQubit, const int conjFac)
 {
     long long int indexUp,indexLo;    // current index and corresponding index in lower half block
 
+    qreal stateRealUp,stateImagUp;
     const long long int numTasks = (qureg.numAmpsPerChunk>>(1 + targetQubit)) ;
     const long long int sizeTask = (1LL << targetQubit);
     long long thisTask;
@@ -2322,238 +5294,234 @@ void statevec_controlledCompactUnitaryLocalAllSmallSIMD (Qureg qureg, const int
     // Can't use qureg.stateVec as a private OMP var
     qreal *stateVecReal = qureg.stateVec.real;
     qreal *stateVecImag = qureg.stateVec.imag;
-    qreal alphaImag=alpha.imag, alphaReal=alpha.real;
-    qreal betaImag=beta.imag, betaReal=beta.real;
-
-    __m256d stateRealUpSIMD,stateImagUpSIMD,stateRealLoSIMD,stateImagLoSIMD;
-    register const __m256d alphaRealSIMD = _mm256_set1_pd(alphaReal);
-    register const __m256d alphaImagSIMD = _mm256_set1_pd(alphaImag);
-    register const __m256d betaRealSIMD = _mm256_set1_pd(betaReal);
-    register const __m256d betaImagSIMD = _mm256_set1_pd(betaImag); 
 
 # ifdef _OPENMP
-    if(numTasks >= omp_get_num_threads()){
 # pragma omp parallel \
-    shared   (stateVecReal,stateVecImag,alphaRealSIMD,alphaImagSIMD, betaRealSIMD,betaImagSIMD) \
-    private  (thisTask,indexUp,indexLo,stateRealUpSIMD,stateImagUpSIMD,stateRealLoSIMD,stateImagLoSIMD)
+    shared   (stateVecReal,stateVecImag) \
+    private  (thisTask,indexUp,indexLo, stateRealUp,stateImagUp)
 # endif
     {
 # ifdef _OPENMP
 # pragma omp for schedule (static)
 # endif
         for (thisTask = 0; thisTask < numTasks; ++thisTask)
-        for (indexUp = thisTask * sizeTask * 2; indexUp < thisTask * sizeTask * 2 + sizeTask; indexUp+=4) {
+        for (indexUp = thisTask * sizeTask * 2; indexUp < thisTask * sizeTask * 2 + sizeTask; ++ indexUp) {
 
-                indexLo     = indexUp + sizeTask;
+            indexLo     = indexUp + sizeTask;
 
-                    // controlBit = extractBit (controlQubit, indexUp+chunkId*chunkSize);
-                    // if (controlBit){
-                    // store current state vector values in temp variables
-                    stateRealUpSIMD = _mm256_loadu_pd(stateVecReal+indexUp);
-                    stateImagUpSIMD = _mm256_loadu_pd(stateVecImag+indexUp);
-                    stateRealLoSIMD = _mm256_loadu_pd(stateVecReal+indexLo);
-                    stateImagLoSIMD = _mm256_loadu_pd(stateVecImag+indexLo);
+            stateRealUp = stateVecReal[indexUp];
+            stateImagUp = stateVecImag[indexUp];
 
-                    // state[indexUp] = alpha * state[indexUp] - conj(beta)  * state[indexLo]
-                    //stateVecReal[indexUp] = alphaReal*stateRealUp - alphaImag*stateImagUp
-                    //    - betaReal*stateRealLo - betaImag*stateImagLo;
-                    __m256d res1 =  _mm256_mul_pd(alphaRealSIMD,stateRealUpSIMD);
-                    res1 = _mm256_sub_pd(res1,_mm256_mul_pd(alphaImagSIMD,stateImagUpSIMD));
-                    res1 = _mm256_sub_pd(res1,_mm256_mul_pd(betaRealSIMD,stateRealLoSIMD));
-                    res1 = _mm256_sub_pd(res1,_mm256_mul_pd(betaImagSIMD,stateImagLoSIMD));
+            stateVecReal[indexUp] = conjFac * stateVecImag[indexLo];
+            stateVecImag[indexUp] = conjFac * -stateVecReal[indexLo];
+            stateVecReal[indexLo] = conjFac * -stateImagUp;
+            stateVecImag[indexLo] = conjFac * stateRealUp;
+        }
+    }
+}
 
+void statevec_pauliYLocal(Qureg qureg, const int targetQubit, const int conjFac)
+{
+    long long int sizeBlock, sizeHalfBlock;
+    long long int thisBlock, // current block
+         indexUp,indexLo;    // current index and corresponding index in lower half block
 
-                    //stateVecImag[indexUp] = alphaReal*stateImagUp + alphaImag*stateRealUp
-                    //    - betaReal*stateImagLo + betaImag*stateRealLo;
-                    __m256d res2 =  _mm256_mul_pd(alphaRealSIMD,stateImagUpSIMD);
-                    res2 = _mm256_add_pd(res2,_mm256_mul_pd(alphaImagSIMD,stateRealUpSIMD));
-                    res2 = _mm256_sub_pd(res2,_mm256_mul_pd(betaRealSIMD,stateImagLoSIMD));
-                    res2 = _mm256_add_pd(res2,_mm256_mul_pd(betaImagSIMD,stateRealLoSIMD));
+    qreal stateRealUp,stateImagUp;
+    long long int thisTask;
+    const long long int numTasks=qureg.numAmpsPerChunk>>1;
 
-                    // state[indexLo] = beta  * state[indexUp] + conj(alpha) * state[indexLo]
-                    //stateVecReal[indexLo] = betaReal*stateRealUp - betaImag*stateImagUp
-                    //    + alphaReal*stateRealLo + alphaImag*stateImagLo;
-                    __m256d res3 = _mm256_mul_pd(betaRealSIMD,stateRealUpSIMD);
-                    res3 = _mm256_sub_pd(res3,_mm256_mul_pd(betaImagSIMD,stateImagUpSIMD));
-                    res3 = _mm256_add_pd(res3,_mm256_mul_pd(alphaRealSIMD,stateRealLoSIMD));
-                    res3 = _mm256_add_pd(res3,_mm256_mul_pd(alphaImagSIMD,stateImagLoSIMD));
+    // set dimensions
+    sizeHalfBlock = 1LL << targetQubit;
+    sizeBlock     = 2LL * sizeHalfBlock;
 
-                    //stateVecImag[indexLo] = betaReal*stateImagUp + betaImag*stateRealUp
-                    //    + alphaReal*stateImagLo - alphaImag*stateRealLo;
-                    __m256d res4 = _mm256_mul_pd(betaRealSIMD,stateImagUpSIMD);
-                    res4 = _mm256_add_pd(res4,_mm256_mul_pd(betaImagSIMD,stateRealUpSIMD));
-                    res4 = _mm256_add_pd(res4,_mm256_mul_pd(alphaRealSIMD,stateImagLoSIMD));
-                    res4 = _mm256_sub_pd(res4,_mm256_mul_pd(alphaImagSIMD,stateRealLoSIMD));
-
-                    _mm256_storeu_pd(stateVecReal+indexUp,res1);
-                    _mm256_storeu_pd(stateVecImag+indexUp,res2);
-                    _mm256_storeu_pd(stateVecReal+indexLo,res3);
-                    _mm256_storeu_pd(stateVecImag+indexLo,res4);
-                    // }        }
-    }
-    }
-# ifdef _OPENMP
-    }else {
-        for (thisTask = 0; thisTask < numTasks; ++thisTask)
+    // Can't use qureg.stateVec as a private OMP var
+    qreal *stateVecReal = qureg.stateVec.real;
+    qreal *stateVecImag = qureg.stateVec.imag;
 
+# ifdef _OPENMP
 # pragma omp parallel \
-    shared   (thisTask,stateVecReal,stateVecImag,alphaRealSIMD,alphaImagSIMD, betaRealSIMD,betaImagSIMD) \
-    private  (indexUp,indexLo, stateRealUpSIMD,stateImagUpSIMD,stateRealLoSIMD,stateImagLoSIMD)
+    shared   (sizeBlock,sizeHalfBlock, stateVecReal,stateVecImag) \
+    private  (thisTask,thisBlock ,indexUp,indexLo, stateRealUp,stateImagUp)
+# endif
     {
+# ifdef _OPENMP
 # pragma omp for schedule (static)
-        for (indexUp = thisTask * sizeTask * 2; indexUp < thisTask * sizeTask * 2 + sizeTask; indexUp+=4) {
-
-                indexLo     = indexUp + sizeTask;
+# endif
+        for (thisTask=0; thisTask<numTasks; thisTask++) {
+            thisBlock   = thisTask / sizeHalfBlock;
+            indexUp     = thisBlock*sizeBlock + thisTask%sizeHalfBlock;
+            indexLo     = indexUp + sizeHalfBlock;
 
-                    // controlBit = extractBit (controlQubit, indexUp+chunkId*chunkSize);
-                    // if (controlBit){
-                    // store current state vector values in temp variables
-                    stateRealUpSIMD = _mm256_loadu_pd(stateVecReal+indexUp);
-                    stateImagUpSIMD = _mm256_loadu_pd(stateVecImag+indexUp);
-                    stateRealLoSIMD = _mm256_loadu_pd(stateVecReal+indexLo);
-                    stateImagLoSIMD = _mm256_loadu_pd(stateVecImag+indexLo);
+            stateRealUp = stateVecReal[indexUp];
+            stateImagUp = stateVecImag[indexUp];
 
-                    // state[indexUp] = alpha * state[indexUp] - conj(beta)  * state[indexLo]
-                    //stateVecReal[indexUp] = alphaReal*stateRealUp - alphaImag*stateImagUp
-                    //    - betaReal*stateRealLo - betaImag*stateImagLo;
-                    __m256d res1 =  _mm256_mul_pd(alphaRealSIMD,stateRealUpSIMD);
-                    res1 = _mm256_sub_pd(res1,_mm256_mul_pd(alphaImagSIMD,stateImagUpSIMD));
-                    res1 = _mm256_sub_pd(res1,_mm256_mul_pd(betaRealSIMD,stateRealLoSIMD));
-                    res1 = _mm256_sub_pd(res1,_mm256_mul_pd(betaImagSIMD,stateImagLoSIMD));
+            stateVecReal[indexUp] = conjFac * stateVecImag[indexLo];
+            stateVecImag[indexUp] = conjFac * -stateVecReal[indexLo];
+            stateVecReal[indexLo] = conjFac * -stateImagUp;
+            stateVecImag[indexLo] = conjFac * stateRealUp;
+        }
+    }
+}
 
+/** Rotate a single qubit by +-{{0,-i},{i,0}.
+ *  Operate on a subset of the state vector with upper and lower block values
+ *  stored seperately. This rotation is just swapping upper and lower values, and
+ *  stateVecIn must already be the correct section for this chunk
+ *
+ *  @remarks Qubits are zero-based and the
+ *  the first qubit is the rightmost
+ *
+ *  @param[in,out] qureg object representing the set of qubits
+ *  @param[in] stateVecIn probability amplitudes in lower or upper half of a block depending on chunkId
+ *  @param[in] updateUpper flag, 1: updating upper values, 0: updating lower values in block
+ *  @param[out] stateVecOut array section to update (will correspond to either the lower or upper half of a block)
+ */
+void statevec_pauliYDistributed(Qureg qureg,
+        ComplexArray stateVecIn,
+        ComplexArray stateVecOut,
+        int updateUpper, const int conjFac)
+{
 
-                    //stateVecImag[indexUp] = alphaReal*stateImagUp + alphaImag*stateRealUp
-                    //    - betaReal*stateImagLo + betaImag*stateRealLo;
-                    __m256d res2 =  _mm256_mul_pd(alphaRealSIMD,stateImagUpSIMD);
-                    res2 = _mm256_add_pd(res2,_mm256_mul_pd(alphaImagSIMD,stateRealUpSIMD));
-                    res2 = _mm256_sub_pd(res2,_mm256_mul_pd(betaRealSIMD,stateImagLoSIMD));
-                    res2 = _mm256_add_pd(res2,_mm256_mul_pd(betaImagSIMD,stateRealLoSIMD));
+    long long int thisTask;
+    const long long int numTasks=qureg.numAmpsPerChunk;
 
-                    // state[indexLo] = beta  * state[indexUp] + conj(alpha) * state[indexLo]
-                    //stateVecReal[indexLo] = betaReal*stateRealUp - betaImag*stateImagUp
-                    //    + alphaReal*stateRealLo + alphaImag*stateImagLo;
-                    __m256d res3 = _mm256_mul_pd(betaRealSIMD,stateRealUpSIMD);
-                    res3 = _mm256_sub_pd(res3,_mm256_mul_pd(betaImagSIMD,stateImagUpSIMD));
-                    res3 = _mm256_add_pd(res3,_mm256_mul_pd(alphaRealSIMD,stateRealLoSIMD));
-                    res3 = _mm256_add_pd(res3,_mm256_mul_pd(alphaImagSIMD,stateImagLoSIMD));
+    qreal *stateVecRealIn=stateVecIn.real, *stateVecImagIn=stateVecIn.imag;
+    qreal *stateVecRealOut=stateVecOut.real, *stateVecImagOut=stateVecOut.imag;
 
-                    //stateVecImag[indexLo] = betaReal*stateImagUp + betaImag*stateRealUp
-                    //    + alphaReal*stateImagLo - alphaImag*stateRealLo;
-                    __m256d res4 = _mm256_mul_pd(betaRealSIMD,stateImagUpSIMD);
-                    res4 = _mm256_add_pd(res4,_mm256_mul_pd(betaImagSIMD,stateRealUpSIMD));
-                    res4 = _mm256_add_pd(res4,_mm256_mul_pd(alphaRealSIMD,stateImagLoSIMD));
-                    res4 = _mm256_sub_pd(res4,_mm256_mul_pd(alphaImagSIMD,stateRealLoSIMD));
-
-                    _mm256_storeu_pd(stateVecReal+indexUp,res1);
-                    _mm256_storeu_pd(stateVecImag+indexUp,res2);
-                    _mm256_storeu_pd(stateVecReal+indexLo,res3);
-                    _mm256_storeu_pd(stateVecImag+indexLo,res4);
-                    // }        }
+    int realSign=1, imagSign=1;
+    if (updateUpper) imagSign=-1;
+    else realSign = -1;
+
+# ifdef _OPENMP
+# pragma omp parallel \
+    shared   (stateVecRealIn,stateVecImagIn,stateVecRealOut,stateVecImagOut,realSign,imagSign) \
+    private  (thisTask)
+# endif
+    {
+# ifdef _OPENMP
+# pragma omp for schedule (static)
+# endif
+        for (thisTask=0; thisTask<numTasks; thisTask++) {
+            stateVecRealOut[thisTask] = conjFac * realSign * stateVecImagIn[thisTask];
+            stateVecImagOut[thisTask] = conjFac * imagSign * stateVecRealIn[thisTask];
         }
     }
-    }
-# endif
 }
+void statevec_controlledPauliYLocalAll(Qureg qureg, const int controlQubit, const int targetQubit, const int conjFac) {
+    long long int sizeBlock, sizeHalfBlock;
+    long long int thisBlock, // current block
+         indexUp,indexLo;    // current index and corresponding index in lower half block
 
-void statevec_controlledCompactUnitaryLocalAllSmall (Qureg qureg, const int controlQubit, const int targetQubit,
-        Complex alpha, Complex beta)
-{
-    long long int indexUp,indexLo;    // current index and corresponding index in lower half block
+    qreal stateRealUp,stateImagUp;
+    long long int thisTask;
+    const long long int numTasks=qureg.numAmpsPerChunk>>1;
 
-    qreal stateRealUp,stateRealLo,stateImagUp,stateImagLo;
-    const long long int numTasks = (qureg.numAmpsPerChunk>>(1 + targetQubit)) ;
-    const long long int sizeTask = (1LL << targetQubit);
-    long long thisTask;
+    // set dimensions
+    sizeHalfBlock = 1LL << targetQubit;
+    sizeBlock     = 2LL * sizeHalfBlock;
 
     // Can't use qureg.stateVec as a private OMP var
     qreal *stateVecReal = qureg.stateVec.real;
     qreal *stateVecImag = qureg.stateVec.imag;
-    qreal alphaImag=alpha.imag, alphaReal=alpha.real;
-    qreal betaImag=beta.imag, betaReal=beta.real;
 
 # ifdef _OPENMP
-    if(numTasks >= omp_get_num_threads()){
 # pragma omp parallel \
-    shared   (stateVecReal,stateVecImag) \
-    private  (thisTask,indexUp,indexLo, stateRealUp,stateImagUp)
+    shared   (sizeBlock,sizeHalfBlock, stateVecReal,stateVecImag) \
+    private  (thisTask,thisBlock ,indexUp,indexLo, stateRealUp,stateImagUp)
 # endif
     {
 # ifdef _OPENMP
 # pragma omp for schedule (static)
 # endif
-        for (thisTask = 0; thisTask < numTasks; ++thisTask)
-        for (indexUp = thisTask * sizeTask * 2; indexUp < thisTask * sizeTask * 2 + sizeTask; ++ indexUp) {
-
-            indexLo     = indexUp + sizeTask;
+        for (thisTask=0; thisTask<numTasks; thisTask++) {
+            thisBlock   = thisTask / sizeHalfBlock;
+            indexUp     = thisBlock*sizeBlock + thisTask%sizeHalfBlock;
+            indexLo     = indexUp + sizeHalfBlock;
 
-                // store current state vector values in temp variables
                 stateRealUp = stateVecReal[indexUp];
                 stateImagUp = stateVecImag[indexUp];
 
-                stateRealLo = stateVecReal[indexLo];
-                stateImagLo = stateVecImag[indexLo];
-
-                // state[indexUp] = alpha * state[indexUp] - conj(beta)  * state[indexLo]
-                stateVecReal[indexUp] = alphaReal*stateRealUp - alphaImag*stateImagUp
-                    - betaReal*stateRealLo - betaImag*stateImagLo;
-                stateVecImag[indexUp] = alphaReal*stateImagUp + alphaImag*stateRealUp
-                    - betaReal*stateImagLo + betaImag*stateRealLo;
+                // update under +-{{0, -i}, {i, 0}}
+                stateVecReal[indexUp] = conjFac * stateVecImag[indexLo];
+                stateVecImag[indexUp] = conjFac * -stateVecReal[indexLo];
+                stateVecReal[indexLo] = conjFac * -stateImagUp;
+                stateVecImag[indexLo] = conjFac * stateRealUp;
+        }
+    }
+}
 
-                // state[indexLo] = beta  * state[indexUp] + conj(alpha) * state[indexLo]
-                stateVecReal[indexLo] = betaReal*stateRealUp - betaImag*stateImagUp
-                    + alphaReal*stateRealLo + alphaImag*stateImagLo;
-                stateVecImag[indexLo] = betaReal*stateImagUp + betaImag*stateRealUp
-                    + alphaReal*stateImagLo - alphaImag*stateRealLo;
+void statevec_controlledPauliYLocalSmall(Qureg qureg, const int controlQubit, const int targetQubit, const int conjFac)
+{
+    if((1LL<<controlQubit)>=qureg.numAmpsPerChunk) {
+        if(extractBit(controlQubit,qureg.chunkId*qureg.numAmpsPerChunk)) {
+            statevec_controlledPauliYLocalAll(qureg, controlQubit, targetQubit, conjFac);
         }
+        return ;
     }
-# ifdef _OPENMP
-    }else {
-        for (thisTask = 0; thisTask < numTasks; ++thisTask)
+    long long int sizeBlock, sizeHalfBlock;
+    long long int thisBlock, // current block
+         indexUp,indexLo;    // current index and corresponding index in lower half block
 
-# pragma omp parallel \
-    shared   (thisTask,stateVecReal,stateVecImag) \
-    private  (indexUp,indexLo, stateRealUp,stateImagUp)
-    {
-# pragma omp for schedule (static)
-        for (indexUp = thisTask * sizeTask * 2; indexUp < thisTask * sizeTask * 2 + sizeTask; ++ indexUp) {
+    qreal stateRealUp,stateImagUp;
+    long long int thisTask;
+    const long long int numTasks = ((targetQubit > controlQubit) ? (1LL << (targetQubit - controlQubit - 1)) : (1LL << (controlQubit - targetQubit - 1)));
+    // const long long int chunkSize=qureg.numAmpsPerChunk;
+    // const long long int chunkId=qureg.chunkId;
+    const long long int numBlocks = ((targetQubit > controlQubit) ? (qureg.numAmpsPerChunk>>(1 + targetQubit)) : (qureg.numAmpsPerChunk>>(1 + controlQubit)));
+    const long long int sizeTask = ((targetQubit > controlQubit) ? (1LL << controlQubit) : (1LL << targetQubit));
+    const long long int blockOffset = 1LL << controlQubit;
 
-            indexLo     = indexUp + sizeTask;
+    // set dimensions
+    sizeHalfBlock = 1LL << targetQubit;
+    sizeBlock     = ((targetQubit > controlQubit) ? (2LL * sizeHalfBlock) : (2LL << controlQubit));
 
-                // store current state vector values in temp variables
-                stateRealUp = stateVecReal[indexUp];
-                stateImagUp = stateVecImag[indexUp];
 
-                stateRealLo = stateVecReal[indexLo];
-                stateImagLo = stateVecImag[indexLo];
+    // Can't use qureg.stateVec as a private OMP var
+    qreal *stateVecReal = qureg.stateVec.real;
+    qreal *stateVecImag = qureg.stateVec.imag;
 
-                // state[indexUp] = alpha * state[indexUp] - conj(beta)  * state[indexLo]
-                stateVecReal[indexUp] = alphaReal*stateRealUp - alphaImag*stateImagUp
-                    - betaReal*stateRealLo - betaImag*stateImagLo;
-                stateVecImag[indexUp] = alphaReal*stateImagUp + alphaImag*stateRealUp
-                    - betaReal*stateImagLo + betaImag*stateRealLo;
+# ifdef _OPENMP
+# pragma omp parallel \
+    shared   (sizeBlock,sizeHalfBlock, stateVecReal,stateVecImag, blockOffset) \
+    private  (thisTask,thisBlock ,indexUp,indexLo, stateRealUp,stateImagUp)
+# endif
+    {
+# ifdef _OPENMP
+# pragma omp for schedule (static)
+# endif
+        for (thisBlock = 0; thisBlock < numBlocks; ++thisBlock) {
+            for(thisTask = 0; thisTask < numTasks; ++thisTask){
+                for(indexUp = thisBlock * sizeBlock + sizeTask * thisTask * 2 + blockOffset; indexUp < thisBlock * sizeBlock + sizeTask * thisTask * 2 + sizeTask + blockOffset; ++indexUp) {
+                    indexLo     = indexUp + sizeHalfBlock;
 
-                // state[indexLo] = beta  * state[indexUp] + conj(alpha) * state[indexLo]
-                stateVecReal[indexLo] = betaReal*stateRealUp - betaImag*stateImagUp
-                    + alphaReal*stateRealLo + alphaImag*stateImagLo;
-                stateVecImag[indexLo] = betaReal*stateImagUp + betaImag*stateRealUp
-                    + alphaReal*stateImagLo - alphaImag*stateRealLo;
+                    stateRealUp = stateVecReal[indexUp];
+                    stateImagUp = stateVecImag[indexUp];
+
+                    // update under +-{{0, -i}, {i, 0}}
+                    stateVecReal[indexUp] = conjFac * stateVecImag[indexLo];
+                    stateVecImag[indexUp] = conjFac * -stateVecReal[indexLo];
+                    stateVecReal[indexLo] = conjFac * -stateImagUp;
+                    stateVecImag[indexLo] = conjFac * stateRealUp;
+                }
+            }
         }
     }
-    }
-# endif
 }
 
 
-void statevec_controlledCompactUnitaryLocalAll (Qureg qureg, const int controlQubit, const int targetQubit,
-        Complex alpha, Complex beta)
+void statevec_controlledPauliYLocal(Qureg qureg, const int controlQubit, const int targetQubit, const int conjFac)
 {
     long long int sizeBlock, sizeHalfBlock;
     long long int thisBlock, // current block
          indexUp,indexLo;    // current index and corresponding index in lower half block
 
-    qreal stateRealUp,stateRealLo,stateImagUp,stateImagLo;
+    qreal stateRealUp,stateImagUp;
     long long int thisTask;
     const long long int numTasks=qureg.numAmpsPerChunk>>1;
+    const long long int chunkSize=qureg.numAmpsPerChunk;
+    const long long int chunkId=qureg.chunkId;
+
+    int controlBit;
 
     // set dimensions
     sizeHalfBlock = 1LL << targetQubit;
@@ -2562,2356 +5530,2603 @@ void statevec_controlledCompactUnitaryLocalAll (Qureg qureg, const int controlQu
     // Can't use qureg.stateVec as a private OMP var
     qreal *stateVecReal = qureg.stateVec.real;
     qreal *stateVecImag = qureg.stateVec.imag;
-    qreal alphaImag=alpha.imag, alphaReal=alpha.real;
-    qreal betaImag=beta.imag, betaReal=beta.real;
-    
+
 # ifdef _OPENMP
 # pragma omp parallel \
-    shared   (sizeBlock,sizeHalfBlock, stateVecReal,stateVecImag, alphaReal,alphaImag, betaReal,betaImag) \
-    private  (thisTask,thisBlock ,indexUp,indexLo, stateRealUp,stateImagUp,stateRealLo,stateImagLo)
+    shared   (sizeBlock,sizeHalfBlock, stateVecReal,stateVecImag) \
+    private  (thisTask,thisBlock ,indexUp,indexLo, stateRealUp,stateImagUp,controlBit)
 # endif
     {
 # ifdef _OPENMP
 # pragma omp for schedule (static)
 # endif
         for (thisTask=0; thisTask<numTasks; thisTask++) {
-
             thisBlock   = thisTask / sizeHalfBlock;
             indexUp     = thisBlock*sizeBlock + thisTask%sizeHalfBlock;
             indexLo     = indexUp + sizeHalfBlock;
 
-                // store current state vector values in temp variables
+            controlBit = extractBit(controlQubit, indexUp+chunkId*chunkSize);
+            if (controlBit){
                 stateRealUp = stateVecReal[indexUp];
                 stateImagUp = stateVecImag[indexUp];
 
-                stateRealLo = stateVecReal[indexLo];
-                stateImagLo = stateVecImag[indexLo];
+                // update under +-{{0, -i}, {i, 0}}
+                stateVecReal[indexUp] = conjFac * stateVecImag[indexLo];
+                stateVecImag[indexUp] = conjFac * -stateVecReal[indexLo];
+                stateVecReal[indexLo] = conjFac * -stateImagUp;
+                stateVecImag[indexLo] = conjFac * stateRealUp;
+            }
+        }
+    }
+}
 
-                // state[indexUp] = alpha * state[indexUp] - conj(beta)  * state[indexLo]
-                stateVecReal[indexUp] = alphaReal*stateRealUp - alphaImag*stateImagUp
-                    - betaReal*stateRealLo - betaImag*stateImagLo;
-                stateVecImag[indexUp] = alphaReal*stateImagUp + alphaImag*stateRealUp
-                    - betaReal*stateImagLo + betaImag*stateRealLo;
 
-                // state[indexLo] = beta  * state[indexUp] + conj(alpha) * state[indexLo]
-                stateVecReal[indexLo] = betaReal*stateRealUp - betaImag*stateImagUp
-                    + alphaReal*stateRealLo + alphaImag*stateImagLo;
-                stateVecImag[indexLo] = betaReal*stateImagUp + betaImag*stateRealUp
-                    + alphaReal*stateImagLo - alphaImag*stateRealLo;
+void statevec_controlledPauliYDistributed (Qureg qureg, const int controlQubit,
+        ComplexArray stateVecIn,
+        ComplexArray stateVecOut, const int conjFac)
+{
+
+    long long int thisTask;
+    const long long int numTasks=qureg.numAmpsPerChunk;
+    const long long int chunkSize=qureg.numAmpsPerChunk;
+    const long long int chunkId=qureg.chunkId;
+
+    int controlBit;
+
+    qreal *stateVecRealIn=stateVecIn.real, *stateVecImagIn=stateVecIn.imag;
+    qreal *stateVecRealOut=stateVecOut.real, *stateVecImagOut=stateVecOut.imag;
 
+# ifdef _OPENMP
+# pragma omp parallel \
+    shared   (stateVecRealIn,stateVecImagIn,stateVecRealOut,stateVecImagOut) \
+    private  (thisTask,controlBit)
+# endif
+    {
+# ifdef _OPENMP
+# pragma omp for schedule (static)
+# endif
+        for (thisTask=0; thisTask<numTasks; thisTask++) {
+            controlBit = extractBit (controlQubit, thisTask+chunkId*chunkSize);
+            if (controlBit){
+                stateVecRealOut[thisTask] = conjFac * stateVecImagIn[thisTask];
+                stateVecImagOut[thisTask] = conjFac * -stateVecRealIn[thisTask];
+            }
         }
     }
+}
+
+void statevec_hadamardLocalSmall(Qureg qureg, const int targetQubit)
+{
+    long long int indexUp,indexLo;    // current index and corresponding index in lower half block
+
+    qreal stateRealUp,stateRealLo,stateImagUp,stateImagLo;
+    const long long int sizeTask = (1LL << targetQubit);
+    if(sizeTask >= SIMD_WIDTH){
+        statevec_hadamardLocalSIMD(qureg,targetQubit);
+        //printf("simd");
+        return;
+    }
+
+    const long long int numTasks = (qureg.numAmpsPerChunk>>(1 + targetQubit)) ;
+    long long thisTask;
+
+    // Can't use qureg.stateVec as a private OMP var
+    qreal *stateVecReal = qureg.stateVec.real;
+    qreal *stateVecImag = qureg.stateVec.imag;
+
+    qreal recRoot2 = 1.0/sqrt(2);
+
+# ifdef _OPENMP
+# pragma omp parallel \
+    shared   (stateVecReal,stateVecImag, recRoot2) \
+    private  (thisTask,indexUp,indexLo, stateRealUp,stateImagUp,stateRealLo,stateImagLo)
+# endif
+    {
+# ifdef _OPENMP
+# pragma omp for schedule (static)
+# endif
+        for (thisTask = 0; thisTask < numTasks; ++thisTask)
+        for (indexUp = thisTask * sizeTask * 2; indexUp < thisTask * sizeTask * 2 + sizeTask; ++ indexUp) {
 
-}
+            indexLo     = indexUp + sizeTask;
 
-void statevec_controlledCompactUnitaryLocalSmall (Qureg qureg, const int controlQubit, const int targetQubit,
-        Complex alpha, Complex beta)
-{
+            stateRealUp = stateVecReal[indexUp];
+            stateImagUp = stateVecImag[indexUp];
 
-    if((1LL<<controlQubit)>=qureg.numAmpsPerChunk) {
-        if(extractBit(controlQubit,qureg.chunkId*qureg.numAmpsPerChunk)) {
-            statevec_controlledCompactUnitaryLocalAllSmall(qureg,controlQubit,targetQubit,alpha,beta);
-        }
-        return ;
-    }
-    long long int sizeBlock, sizeHalfBlock;
-    long long int thisBlock, // current block
-         indexUp,indexLo;    // current index and corresponding index in lower half block
+            stateRealLo = stateVecReal[indexLo];
+            stateImagLo = stateVecImag[indexLo];
 
-    qreal stateRealUp,stateRealLo,stateImagUp,stateImagLo;
-    long long int thisTask;
+            stateVecReal[indexUp] = recRoot2*(stateRealUp + stateRealLo);
+            stateVecImag[indexUp] = recRoot2*(stateImagUp + stateImagLo);
 
-    const long long int sizeTask = ((targetQubit > controlQubit) ? (1LL << controlQubit) : (1LL << targetQubit));
-    if(sizeTask >= 4){
-        statevec_controlledCompactUnitaryLocalSIMD(qureg,controlQubit,targetQubit,alpha,beta);
-        //printf("simd");
-        return;
+            stateVecReal[indexLo] = recRoot2*(stateRealUp - stateRealLo);
+            stateVecImag[indexLo] = recRoot2*(stateImagUp - stateImagLo);
+        }
     }
+}
 
-    const long long int numTasks = ((targetQubit > controlQubit) ? (1LL << (targetQubit - controlQubit - 1)) : (1LL << (controlQubit - targetQubit - 1)));
-    // const long long int chunkSize=qureg.numAmpsPerChunk;
-    // const long long int chunkId=qureg.chunkId;
-    const long long int numBlocks = ((targetQubit > controlQubit) ? (qureg.numAmpsPerChunk>>(1 + targetQubit)) : (qureg.numAmpsPerChunk>>(1 + controlQubit)));
-    const long long int blockOffset = 1LL << controlQubit;
+void statevec_hadamardLocalSIMD(Qureg qureg, const int targetQubit)
+{
+    long long int indexUp,indexLo;    // current index and corresponding index in lower half block
 
-    // set dimensions
-    sizeHalfBlock = 1LL << targetQubit;
-    sizeBlock = ((targetQubit > controlQubit) ? (2LL * sizeHalfBlock) : (2LL << controlQubit));
+    qrealSIMD stateRealUpSIMD,stateRealLoSIMD,stateImagUpSIMD,stateImagLoSIMD;
+    const long long int numTasks = (qureg.numAmpsPerChunk>>(1 + targetQubit)) ;
+    const long long int sizeTask = (1LL << targetQubit);
+    long long thisTask;
 
     // Can't use qureg.stateVec as a private OMP var
     qreal *stateVecReal = qureg.stateVec.real;
     qreal *stateVecImag = qureg.stateVec.imag;
-    qreal alphaImag=alpha.imag, alphaReal=alpha.real;
-    qreal betaImag=beta.imag, betaReal=beta.real;
+
+    qreal recRoot2 = 1.0/sqrt(2);
+    register const qrealSIMD recRoot2SIMD = SIMD_SET1(recRoot2);
 
 # ifdef _OPENMP
-    if(numBlocks >= omp_get_num_threads()){
+    if(numTasks >= omp_get_num_threads()){
 # pragma omp parallel \
-    shared   (sizeBlock,sizeHalfBlock, stateVecReal,stateVecImag, alphaReal,alphaImag, betaReal,betaImag) \
-    private  (thisTask,thisBlock ,indexUp,indexLo, stateRealUp,stateImagUp,stateRealLo,stateImagLo)
+    shared   (stateVecReal,stateVecImag, recRoot2SIMD) \
+    private  (thisTask,indexUp,indexLo, stateRealUpSIMD,stateImagUpSIMD,stateRealLoSIMD,stateImagLoSIMD)
 # endif
     {
 # ifdef _OPENMP
 # pragma omp for schedule (static)
 # endif
-        for (thisBlock = 0; thisBlock < numBlocks; ++thisBlock) {
-            for(thisTask = 0; thisTask < numTasks; ++thisTask)
-            for(indexUp = thisBlock * sizeBlock + sizeTask * thisTask * 2 + blockOffset; indexUp < thisBlock * sizeBlock + sizeTask * thisTask * 2 + sizeTask + blockOffset; ++indexUp) {
-            // for(indexUp = thisBlock * sizeBlock; indexUp < thisBlock * sizeBlock + sizeHalfBlock; ++indexUp) {
-
-                indexLo     = indexUp + sizeHalfBlock;
-             //   if(thisBlock != thisTask / sizeHalfBlock) exit(1);
-             //   if(indexUp != thisBlock*sizeBlock + thisTask%sizeHalfBlock) exit(2);
-             //   if(indexLo != indexUp + sizeHalfBlock) exit(3);
-
-//                int controlBit = extractBit (controlQubit, indexUp+chunkId*chunkSize);
-//                if (controlBit){
-                    // store current state vector values in temp variables
-                    stateRealUp = stateVecReal[indexUp];
-                    stateImagUp = stateVecImag[indexUp];
+        for (thisTask = 0; thisTask < numTasks; ++thisTask)
+        for (indexUp = thisTask * sizeTask * 2; indexUp < thisTask * sizeTask * 2 + sizeTask; indexUp+=SIMD_WIDTH) {
 
-                    stateRealLo = stateVecReal[indexLo];
-                    stateImagLo = stateVecImag[indexLo];
+            indexLo     = indexUp + sizeTask;
 
-                    // state[indexUp] = alpha * state[indexUp] - conj(beta)  * state[indexLo]
-                    stateVecReal[indexUp] = alphaReal*stateRealUp - alphaImag*stateImagUp
-                        - betaReal*stateRealLo - betaImag*stateImagLo;
-                    stateVecImag[indexUp] = alphaReal*stateImagUp + alphaImag*stateRealUp
-                        - betaReal*stateImagLo + betaImag*stateRealLo;
+            stateRealUpSIMD = SIMD_LOAD(stateVecReal+indexUp);
+            stateImagUpSIMD = SIMD_LOAD(stateVecImag+indexUp);
+            stateRealLoSIMD = SIMD_LOAD(stateVecReal+indexLo);
+            stateImagLoSIMD = SIMD_LOAD(stateVecImag+indexLo);
 
-                    // state[indexLo] = beta  * state[indexUp] + conj(alpha) * state[indexLo]
-                    stateVecReal[indexLo] = betaReal*stateRealUp - betaImag*stateImagUp
-                        + alphaReal*stateRealLo + alphaImag*stateImagLo;
-                    stateVecImag[indexLo] = betaReal*stateImagUp + betaImag*stateRealUp
-                        + alphaReal*stateImagLo - alphaImag*stateRealLo;
-//                }
-            }
+            SIMD_STORE(stateVecReal+indexUp, SIMD_MUL(recRoot2SIMD,SIMD_ADD(stateRealUpSIMD, stateRealLoSIMD)));
+            SIMD_STORE(stateVecImag+indexUp, SIMD_MUL(recRoot2SIMD,SIMD_ADD(stateImagUpSIMD, stateImagLoSIMD)));
+            SIMD_STORE(stateVecReal+indexLo, SIMD_MUL(recRoot2SIMD,SIMD_SUB(stateRealUpSIMD, stateRealLoSIMD)));
+            SIMD_STORE(stateVecImag+indexLo, SIMD_MUL(recRoot2SIMD,SIMD_SUB(stateImagUpSIMD, stateImagLoSIMD)));
         }
     }
+    
 # ifdef _OPENMP
     } else {
-        for (thisBlock = 0; thisBlock < numBlocks; ++thisBlock) {
+        for (thisTask = 0; thisTask < numTasks; ++thisTask)
 # pragma omp parallel \
-    shared   (sizeBlock,thisBlock,sizeHalfBlock, stateVecReal,stateVecImag, alphaReal,alphaImag, betaReal,betaImag) \
-    private  (thisTask ,indexUp,indexLo, stateRealUp,stateImagUp,stateRealLo,stateImagLo)
+    shared   (thisTask,stateVecReal,stateVecImag, recRoot2SIMD) \
+    private  (indexUp,indexLo, stateRealUpSIMD,stateImagUpSIMD,stateRealLoSIMD,stateImagLoSIMD)
     {
 # pragma omp for schedule (static)
-            for(thisTask = 0; thisTask < numTasks; ++thisTask)
-            for(indexUp = thisBlock * sizeBlock + sizeTask * thisTask * 2 + blockOffset; indexUp < thisBlock * sizeBlock + sizeTask * thisTask * 2 + sizeTask + blockOffset; ++indexUp) {
-            // for(indexUp = thisBlock * sizeBlock; indexUp < thisBlock * sizeBlock + sizeHalfBlock; ++indexUp) {
-
-                indexLo     = indexUp + sizeHalfBlock;
-             //   if(thisBlock != thisTask / sizeHalfBlock) exit(1);
-             //   if(indexUp != thisBlock*sizeBlock + thisTask%sizeHalfBlock) exit(2);
-             //   if(indexLo != indexUp + sizeHalfBlock) exit(3);
-
-//                int controlBit = extractBit (controlQubit, indexUp+chunkId*chunkSize);
-//                if (controlBit){
-                    // store current state vector values in temp variables
-                    stateRealUp = stateVecReal[indexUp];
-                    stateImagUp = stateVecImag[indexUp];
+        for (indexUp = thisTask * sizeTask * 2; indexUp < thisTask * sizeTask * 2 + sizeTask; indexUp+=SIMD_WIDTH) {
 
-                    stateRealLo = stateVecReal[indexLo];
-                    stateImagLo = stateVecImag[indexLo];
+            indexLo     = indexUp + sizeTask;
 
-                    // state[indexUp] = alpha * state[indexUp] - conj(beta)  * state[indexLo]
-                    stateVecReal[indexUp] = alphaReal*stateRealUp - alphaImag*stateImagUp
-                        - betaReal*stateRealLo - betaImag*stateImagLo;
-                    stateVecImag[indexUp] = alphaReal*stateImagUp + alphaImag*stateRealUp
-                        - betaReal*stateImagLo + betaImag*stateRealLo;
+            stateRealUpSIMD = SIMD_LOAD(stateVecReal+indexUp);
+            stateImagUpSIMD = SIMD_LOAD(stateVecImag+indexUp);
+            stateRealLoSIMD = SIMD_LOAD(stateVecReal+indexLo);
+            stateImagLoSIMD = SIMD_LOAD(stateVecImag+indexLo);
 
-                    // state[indexLo] = beta  * state[indexUp] + conj(alpha) * state[indexLo]
-                    stateVecReal[indexLo] = betaReal*stateRealUp - betaImag*stateImagUp
-                        + alphaReal*stateRealLo + alphaImag*stateImagLo;
-                    stateVecImag[indexLo] = betaReal*stateImagUp + betaImag*stateRealUp
-                        + alphaReal*stateImagLo - alphaImag*stateRealLo;
-//                }
-            }
+            SIMD_STORE(stateVecReal+indexUp, SIMD_MUL(recRoot2SIMD,SIMD_ADD(stateRealUpSIMD, stateRealLoSIMD)));
+            SIMD_STORE(stateVecImag+indexUp, SIMD_MUL(recRoot2SIMD,SIMD_ADD(stateImagUpSIMD, stateImagLoSIMD)));
+            SIMD_STORE(stateVecReal+indexLo, SIMD_MUL(recRoot2SIMD,SIMD_SUB(stateRealUpSIMD, stateRealLoSIMD)));
+            SIMD_STORE(stateVecImag+indexLo, SIMD_MUL(recRoot2SIMD,SIMD_SUB(stateImagUpSIMD, stateImagLoSIMD)));
         }
     }
     }
 # endif
+
 }
 
-void statevec_controlledCompactUnitaryLocalSIMD (Qureg qureg, const int controlQubit, const int targetQubit,
-        Complex alpha, Complex beta)
+void statevec_hadamardLocal(Qureg qureg, const int targetQubit)
 {
     long long int sizeBlock, sizeHalfBlock;
     long long int thisBlock, // current block
          indexUp,indexLo;    // current index and corresponding index in lower half block
 
+    qreal stateRealUp,stateRealLo,stateImagUp,stateImagLo;
     long long int thisTask;
-    const long long int numTasks = ((targetQubit > controlQubit) ? (1LL << (targetQubit - controlQubit - 1)) : (1LL << (controlQubit - targetQubit - 1)));
-    // const long long int chunkSize=qureg.numAmpsPerChunk;
-    // const long long int chunkId=qureg.chunkId;
-    const long long int numBlocks = ((targetQubit > controlQubit) ? (qureg.numAmpsPerChunk>>(1 + targetQubit)) : (qureg.numAmpsPerChunk>>(1 + controlQubit)));
-    const long long int sizeTask = ((targetQubit > controlQubit) ? (1LL << controlQubit) : (1LL << targetQubit));
-    const long long int blockOffset = 1LL << controlQubit;
+    const long long int numTasks=qureg.numAmpsPerChunk>>1;
 
     // set dimensions
     sizeHalfBlock = 1LL << targetQubit;
-    sizeBlock     = ((targetQubit > controlQubit) ? (2LL * sizeHalfBlock) : (2LL << controlQubit));
+    sizeBlock     = 2LL * sizeHalfBlock;
 
     // Can't use qureg.stateVec as a private OMP var
     qreal *stateVecReal = qureg.stateVec.real;
     qreal *stateVecImag = qureg.stateVec.imag;
-    qreal alphaImag=alpha.imag, alphaReal=alpha.real;
-    qreal betaImag=beta.imag, betaReal=beta.real;
 
-    __m256d stateRealUpSIMD,stateImagUpSIMD,stateRealLoSIMD,stateImagLoSIMD;
-    register const __m256d alphaRealSIMD = _mm256_set1_pd(alphaReal);
-    register const __m256d alphaImagSIMD = _mm256_set1_pd(alphaImag);
-    register const __m256d betaRealSIMD = _mm256_set1_pd(betaReal);
-    register const __m256d betaImagSIMD = _mm256_set1_pd(betaImag);
-    
+    qreal recRoot2 = 1.0/sqrt(2);
+
 # ifdef _OPENMP
-    if(numBlocks >= omp_get_num_threads()){
 # pragma omp parallel \
-    shared   (sizeBlock,sizeHalfBlock, stateVecReal,stateVecImag, alphaRealSIMD,alphaImagSIMD, betaRealSIMD,betaImagSIMD) \
-    private  (thisTask,thisBlock ,indexUp,indexLo, stateRealUpSIMD,stateImagUpSIMD,stateRealLoSIMD,stateImagLoSIMD)
+    shared   (sizeBlock,sizeHalfBlock, stateVecReal,stateVecImag, recRoot2) \
+    private  (thisTask,thisBlock ,indexUp,indexLo, stateRealUp,stateImagUp,stateRealLo,stateImagLo)
 # endif
-        {
+    {
 # ifdef _OPENMP
 # pragma omp for schedule (static)
 # endif
-            for (thisBlock = 0; thisBlock < numBlocks; ++thisBlock) {
-                for(thisTask = 0; thisTask < numTasks; ++thisTask)
-                for(indexUp = thisBlock * sizeBlock + sizeTask * thisTask * 2 + blockOffset; indexUp < thisBlock * sizeBlock + sizeTask * thisTask * 2 + sizeTask + blockOffset; indexUp+=4) {
-                // for(indexUp = thisBlock * sizeBlock; indexUp < thisBlock * sizeBlock + sizeHalfBlock; ++indexUp) {
-
-                    indexLo     = indexUp + sizeHalfBlock;
-
-                    // controlBit = extractBit (controlQubit, indexUp+chunkId*chunkSize);
-                    // if (controlBit){
-                    // store current state vector values in temp variables
-                    stateRealUpSIMD = _mm256_loadu_pd(stateVecReal+indexUp);
-                    stateImagUpSIMD = _mm256_loadu_pd(stateVecImag+indexUp);
-                    stateRealLoSIMD = _mm256_loadu_pd(stateVecReal+indexLo);
-                    stateImagLoSIMD = _mm256_loadu_pd(stateVecImag+indexLo);
-
-                    // state[indexUp] = alpha * state[indexUp] - conj(beta)  * state[indexLo]
-                    //stateVecReal[indexUp] = alphaReal*stateRealUp - alphaImag*stateImagUp
-                    //    - betaReal*stateRealLo - betaImag*stateImagLo;
-                    __m256d res1 =  _mm256_mul_pd(alphaRealSIMD,stateRealUpSIMD);
-                    res1 = _mm256_sub_pd(res1,_mm256_mul_pd(alphaImagSIMD,stateImagUpSIMD));
-                    res1 = _mm256_sub_pd(res1,_mm256_mul_pd(betaRealSIMD,stateRealLoSIMD));
-                    res1 = _mm256_sub_pd(res1,_mm256_mul_pd(betaImagSIMD,stateImagLoSIMD));
-
-
-                    //stateVecImag[indexUp] = alphaReal*stateImagUp + alphaImag*stateRealUp
-                    //    - betaReal*stateImagLo + betaImag*stateRealLo;
-                    __m256d res2 =  _mm256_mul_pd(alphaRealSIMD,stateImagUpSIMD);
-                    res2 = _mm256_add_pd(res2,_mm256_mul_pd(alphaImagSIMD,stateRealUpSIMD));
-                    res2 = _mm256_sub_pd(res2,_mm256_mul_pd(betaRealSIMD,stateImagLoSIMD));
-                    res2 = _mm256_add_pd(res2,_mm256_mul_pd(betaImagSIMD,stateRealLoSIMD));
-
-                    // state[indexLo] = beta  * state[indexUp] + conj(alpha) * state[indexLo]
-                    //stateVecReal[indexLo] = betaReal*stateRealUp - betaImag*stateImagUp
-                    //    + alphaReal*stateRealLo + alphaImag*stateImagLo;
-                    __m256d res3 = _mm256_mul_pd(betaRealSIMD,stateRealUpSIMD);
-                    res3 = _mm256_sub_pd(res3,_mm256_mul_pd(betaImagSIMD,stateImagUpSIMD));
-                    res3 = _mm256_add_pd(res3,_mm256_mul_pd(alphaRealSIMD,stateRealLoSIMD));
-                    res3 = _mm256_add_pd(res3,_mm256_mul_pd(alphaImagSIMD,stateImagLoSIMD));
-
-                    //stateVecImag[indexLo] = betaReal*stateImagUp + betaImag*stateRealUp
-                    //    + alphaReal*stateImagLo - alphaImag*stateRealLo;
-                    __m256d res4 = _mm256_mul_pd(betaRealSIMD,stateImagUpSIMD);
-                    res4 = _mm256_add_pd(res4,_mm256_mul_pd(betaImagSIMD,stateRealUpSIMD));
-                    res4 = _mm256_add_pd(res4,_mm256_mul_pd(alphaRealSIMD,stateImagLoSIMD));
-                    res4 = _mm256_sub_pd(res4,_mm256_mul_pd(alphaImagSIMD,stateRealLoSIMD));
-
-                    _mm256_storeu_pd(stateVecReal+indexUp,res1);
-                    _mm256_storeu_pd(stateVecImag+indexUp,res2);
-                    _mm256_storeu_pd(stateVecReal+indexLo,res3);
-                    _mm256_storeu_pd(stateVecImag+indexLo,res4);
-                    // }
-                }
-            }
-        }
-# ifdef _OPENMP
-    } else {
-         for (thisBlock = 0; thisBlock < numBlocks; ++thisBlock) 
-
-# pragma omp parallel \
-    shared   (thisBlock,sizeBlock,sizeHalfBlock, stateVecReal,stateVecImag, alphaRealSIMD,alphaImagSIMD, betaRealSIMD,betaImagSIMD) \
-    private  (thisTask ,indexUp,indexLo, stateRealUpSIMD,stateImagUpSIMD,stateRealLoSIMD,stateImagLoSIMD)
-        {
-# pragma omp for schedule (static)
-                for(thisTask = 0; thisTask < numTasks; ++thisTask) {
-                for(indexUp = thisBlock * sizeBlock + sizeTask * thisTask * 2 + blockOffset; indexUp < thisBlock * sizeBlock + sizeTask * thisTask * 2 + sizeTask + blockOffset; indexUp+=4) {
-                // for(indexUp = thisBlock * sizeBlock; indexUp < thisBlock * sizeBlock + sizeHalfBlock; ++indexUp) {
-
-                    indexLo     = indexUp + sizeHalfBlock;
-
-                    // controlBit = extractBit (controlQubit, indexUp+chunkId*chunkSize);
-                    // if (controlBit){
-                    // store current state vector values in temp variables
-                    stateRealUpSIMD = _mm256_loadu_pd(stateVecReal+indexUp);
-                    stateImagUpSIMD = _mm256_loadu_pd(stateVecImag+indexUp);
-                    stateRealLoSIMD = _mm256_loadu_pd(stateVecReal+indexLo);
-                    stateImagLoSIMD = _mm256_loadu_pd(stateVecImag+indexLo);
-
-                    // state[indexUp] = alpha * state[indexUp] - conj(beta)  * state[indexLo]
-                    //stateVecReal[indexUp] = alphaReal*stateRealUp - alphaImag*stateImagUp
-                    //    - betaReal*stateRealLo - betaImag*stateImagLo;
-                    __m256d res1 =  _mm256_mul_pd(alphaRealSIMD,stateRealUpSIMD);
-                    res1 = _mm256_sub_pd(res1,_mm256_mul_pd(alphaImagSIMD,stateImagUpSIMD));
-                    res1 = _mm256_sub_pd(res1,_mm256_mul_pd(betaRealSIMD,stateRealLoSIMD));
-                    res1 = _mm256_sub_pd(res1,_mm256_mul_pd(betaImagSIMD,stateImagLoSIMD));
+        for (thisTask=0; thisTask<numTasks; thisTask++) {
+            thisBlock   = thisTask / sizeHalfBlock;
+            indexUp     = thisBlock*sizeBlock + thisTask%sizeHalfBlock;
+            indexLo     = indexUp + sizeHalfBlock;
 
+            stateRealUp = stateVecReal[indexUp];
+            stateImagUp = stateVecImag[indexUp];
 
-                    //stateVecImag[indexUp] = alphaReal*stateImagUp + alphaImag*stateRealUp
-                    //    - betaReal*stateImagLo + betaImag*stateRealLo;
-                    __m256d res2 =  _mm256_mul_pd(alphaRealSIMD,stateImagUpSIMD);
-                    res2 = _mm256_add_pd(res2,_mm256_mul_pd(alphaImagSIMD,stateRealUpSIMD));
-                    res2 = _mm256_sub_pd(res2,_mm256_mul_pd(betaRealSIMD,stateImagLoSIMD));
-                    res2 = _mm256_add_pd(res2,_mm256_mul_pd(betaImagSIMD,stateRealLoSIMD));
+            stateRealLo = stateVecReal[indexLo];
+            stateImagLo = stateVecImag[indexLo];
 
-                    // state[indexLo] = beta  * state[indexUp] + conj(alpha) * state[indexLo]
-                    //stateVecReal[indexLo] = betaReal*stateRealUp - betaImag*stateImagUp
-                    //    + alphaReal*stateRealLo + alphaImag*stateImagLo;
-                    __m256d res3 = _mm256_mul_pd(betaRealSIMD,stateRealUpSIMD);
-                    res3 = _mm256_sub_pd(res3,_mm256_mul_pd(betaImagSIMD,stateImagUpSIMD));
-                    res3 = _mm256_add_pd(res3,_mm256_mul_pd(alphaRealSIMD,stateRealLoSIMD));
-                    res3 = _mm256_add_pd(res3,_mm256_mul_pd(alphaImagSIMD,stateImagLoSIMD));
+            stateVecReal[indexUp] = recRoot2*(stateRealUp + stateRealLo);
+            stateVecImag[indexUp] = recRoot2*(stateImagUp + stateImagLo);
 
-                    //stateVecImag[indexLo] = betaReal*stateImagUp + betaImag*stateRealUp
-                    //    + alphaReal*stateImagLo - alphaImag*stateRealLo;
-                    __m256d res4 = _mm256_mul_pd(betaRealSIMD,stateImagUpSIMD);
-                    res4 = _mm256_add_pd(res4,_mm256_mul_pd(betaImagSIMD,stateRealUpSIMD));
-                    res4 = _mm256_add_pd(res4,_mm256_mul_pd(alphaRealSIMD,stateImagLoSIMD));
-                    res4 = _mm256_sub_pd(res4,_mm256_mul_pd(alphaImagSIMD,stateRealLoSIMD));
-
-                    _mm256_storeu_pd(stateVecReal+indexUp,res1);
-                    _mm256_storeu_pd(stateVecImag+indexUp,res2);
-                    _mm256_storeu_pd(stateVecReal+indexLo,res3);
-                    _mm256_storeu_pd(stateVecImag+indexLo,res4);
-                    // }
-                }
-            }
+            stateVecReal[indexLo] = recRoot2*(stateRealUp - stateRealLo);
+            stateVecImag[indexLo] = recRoot2*(stateImagUp - stateImagLo);
         }
-
     }
-# endif
-
 }
 
-void statevec_controlledCompactUnitaryLocal (Qureg qureg, const int controlQubit, const int targetQubit,
-        Complex alpha, Complex beta)
+/** Rotate a single qubit by {{1,1},{1,-1}}/sqrt2.
+ *  Operate on a subset of the state vector with upper and lower block values
+ *  stored seperately. This rotation is just swapping upper and lower values, and
+ *  stateVecIn must already be the correct section for this chunk
+ *
+ *  @param[in,out] qureg object representing the set of qubits
+ *  @param[in] stateVecIn probability amplitudes in lower or upper half of a block depending on chunkId
+ *  @param[in] updateUpper flag, 1: updating upper values, 0: updating lower values in block
+ *  @param[out] stateVecOut array section to update (will correspond to either the lower or upper half of a block)
+ */
+void statevec_hadamardDistributed(Qureg qureg,
+        ComplexArray stateVecUp,
+        ComplexArray stateVecLo,
+        ComplexArray stateVecOut,
+        int updateUpper)
 {
-    long long int sizeBlock, sizeHalfBlock;
-    long long int thisBlock, // current block
-         indexUp,indexLo;    // current index and corresponding index in lower half block
 
-    qreal stateRealUp,stateRealLo,stateImagUp,stateImagLo;
+    qreal   stateRealUp,stateRealLo,stateImagUp,stateImagLo;
     long long int thisTask;
-    const long long int numTasks=qureg.numAmpsPerChunk>>1;
-    const long long int chunkSize=qureg.numAmpsPerChunk;
-    const long long int chunkId=qureg.chunkId;
+    const long long int numTasks=qureg.numAmpsPerChunk;
 
-    int controlBit;
+    if(numTasks >= SIMD_WIDTH){
+        statevec_hadamardDistributedSIMD(qureg,stateVecUp,stateVecLo,stateVecOut,updateUpper);
+        return;
+    }
+
+    int sign;
+    if (updateUpper) sign=1;
+    else sign=-1;
 
-    // set dimensions
-    sizeHalfBlock = 1LL << targetQubit;
-    sizeBlock     = 2LL * sizeHalfBlock;
+    qreal recRoot2 = 1.0/sqrt(2);
 
-    // Can't use qureg.stateVec as a private OMP var
-    qreal *stateVecReal = qureg.stateVec.real;
-    qreal *stateVecImag = qureg.stateVec.imag;
-    qreal alphaImag=alpha.imag, alphaReal=alpha.real;
-    qreal betaImag=beta.imag, betaReal=beta.real;
+    qreal *stateVecRealUp=stateVecUp.real, *stateVecImagUp=stateVecUp.imag;
+    qreal *stateVecRealLo=stateVecLo.real, *stateVecImagLo=stateVecLo.imag;
+    qreal *stateVecRealOut=stateVecOut.real, *stateVecImagOut=stateVecOut.imag;
 
 # ifdef _OPENMP
 # pragma omp parallel \
-    shared   (sizeBlock,sizeHalfBlock, stateVecReal,stateVecImag, alphaReal,alphaImag, betaReal,betaImag) \
-    private  (thisTask,thisBlock ,indexUp,indexLo, stateRealUp,stateImagUp,stateRealLo,stateImagLo,controlBit)
+    shared   (stateVecRealUp,stateVecImagUp,stateVecRealLo,stateVecImagLo,stateVecRealOut,stateVecImagOut, \
+            recRoot2, sign) \
+    private  (thisTask,stateRealUp,stateImagUp,stateRealLo,stateImagLo)
 # endif
     {
 # ifdef _OPENMP
 # pragma omp for schedule (static)
 # endif
         for (thisTask=0; thisTask<numTasks; thisTask++) {
+            // store current state vector values in temp variables
+            stateRealUp = stateVecRealUp[thisTask];
+            stateImagUp = stateVecImagUp[thisTask];
 
-            thisBlock   = thisTask / sizeHalfBlock;
-            indexUp     = thisBlock*sizeBlock + thisTask%sizeHalfBlock;
-            indexLo     = indexUp + sizeHalfBlock;
-
-            controlBit = extractBit (controlQubit, indexUp+chunkId*chunkSize);
-            if (controlBit){
-                // store current state vector values in temp variables
-                stateRealUp = stateVecReal[indexUp];
-                stateImagUp = stateVecImag[indexUp];
-
-                stateRealLo = stateVecReal[indexLo];
-                stateImagLo = stateVecImag[indexLo];
-
-                // state[indexUp] = alpha * state[indexUp] - conj(beta)  * state[indexLo]
-                stateVecReal[indexUp] = alphaReal*stateRealUp - alphaImag*stateImagUp
-                    - betaReal*stateRealLo - betaImag*stateImagLo;
-                stateVecImag[indexUp] = alphaReal*stateImagUp + alphaImag*stateRealUp
-                    - betaReal*stateImagLo + betaImag*stateRealLo;
-
-                // state[indexLo] = beta  * state[indexUp] + conj(alpha) * state[indexLo]
-                stateVecReal[indexLo] = betaReal*stateRealUp - betaImag*stateImagUp
-                    + alphaReal*stateRealLo + alphaImag*stateImagLo;
-                stateVecImag[indexLo] = betaReal*stateImagUp + betaImag*stateRealUp
-                    + alphaReal*stateImagLo - alphaImag*stateRealLo;
-            }
+            stateRealLo = stateVecRealLo[thisTask];
+            stateImagLo = stateVecImagLo[thisTask];
 
+            stateVecRealOut[thisTask] = recRoot2*(stateRealUp + sign*stateRealLo);
+            stateVecImagOut[thisTask] = recRoot2*(stateImagUp + sign*stateImagLo);
         }
     }
-
 }
 
-/* ctrlQubitsMask is a bit mask indicating which qubits are control Qubits
- * ctrlFlipMask is a bit mask indicating which control qubits should be 'flipped'
- * in the condition, i.e. they should have value 0 when the unitary is applied
- */
-void statevec_multiControlledUnitaryLocal(
-    Qureg qureg, const int targetQubit,
-    long long int ctrlQubitsMask, long long int ctrlFlipMask,
-    ComplexMatrix2 u)
+void statevec_hadamardDistributedSIMD(Qureg qureg,
+        ComplexArray stateVecUp,
+        ComplexArray stateVecLo,
+        ComplexArray stateVecOut,
+        int updateUpper)
 {
-    long long int sizeBlock, sizeHalfBlock;
-    long long int thisBlock, // current block
-         indexUp,indexLo;    // current index and corresponding index in lower half block
 
-    qreal stateRealUp,stateRealLo,stateImagUp,stateImagLo;
+    qrealSIMD   stateRealUpSIMD,stateRealLoSIMD,stateImagUpSIMD,stateImagLoSIMD;
     long long int thisTask;
-    const long long int numTasks=qureg.numAmpsPerChunk>>1;
-    const long long int chunkSize=qureg.numAmpsPerChunk;
-    const long long int chunkId=qureg.chunkId;
+    const long long int numTasks=qureg.numAmpsPerChunk;
 
-    // set dimensions
-    sizeHalfBlock = 1LL << targetQubit;
-    sizeBlock     = 2LL * sizeHalfBlock;
+    int sign;
+    if (updateUpper) sign=1;
+    else sign=-1;
 
-    // Can't use qureg.stateVec as a private OMP var
-    qreal *stateVecReal = qureg.stateVec.real;
-    qreal *stateVecImag = qureg.stateVec.imag;
+    qreal recRoot2 = 1.0/sqrt(2);
+    register const qrealSIMD recRoot2SIMD = SIMD_SET1(recRoot2);
+    register const qrealSIMD signSIMD = SIMD_SET1(sign);
+
+    qreal *stateVecRealUp=stateVecUp.real, *stateVecImagUp=stateVecUp.imag;
+    qreal *stateVecRealLo=stateVecLo.real, *stateVecImagLo=stateVecLo.imag;
+    qreal *stateVecRealOut=stateVecOut.real, *stateVecImagOut=stateVecOut.imag;
 
 # ifdef _OPENMP
 # pragma omp parallel \
-    shared   (sizeBlock,sizeHalfBlock, stateVecReal,stateVecImag, u, ctrlQubitsMask,ctrlFlipMask) \
-    private  (thisTask,thisBlock, indexUp,indexLo, stateRealUp,stateImagUp,stateRealLo,stateImagLo)
+    shared   (stateVecRealUp,stateVecImagUp,stateVecRealLo,stateVecImagLo,stateVecRealOut,stateVecImagOut, \
+            recRoot2SIMD, signSIMD) \
+    private  (thisTask,stateRealUpSIMD,stateImagUpSIMD,stateRealLoSIMD,stateImagLoSIMD)
 # endif
     {
 # ifdef _OPENMP
 # pragma omp for schedule (static)
 # endif
-        for (thisTask=0; thisTask<numTasks; thisTask++) {
+        for (thisTask=0; thisTask<numTasks; thisTask+=SIMD_WIDTH) {
+            // store current state vector values in temp variables
+            stateRealUpSIMD = SIMD_LOAD(stateVecRealUp+thisTask);
+            stateImagUpSIMD = SIMD_LOAD(stateVecImagUp+thisTask);
+            stateRealLoSIMD = SIMD_LOAD(stateVecRealLo+thisTask);
+            stateImagLoSIMD = SIMD_LOAD(stateVecImagLo+thisTask);
 
-            thisBlock   = thisTask / sizeHalfBlock;
-            indexUp     = thisBlock*sizeBlock + thisTask%sizeHalfBlock;
-            indexLo     = indexUp + sizeHalfBlock;
+            SIMD_STORE(stateVecRealOut+thisTask, SIMD_MUL(recRoot2SIMD,SIMD_ADD(stateRealUpSIMD,SIMD_MUL(signSIMD,stateRealLoSIMD))));
+            SIMD_STORE(stateVecImagOut+thisTask, SIMD_MUL(recRoot2SIMD,SIMD_ADD(stateImagUpSIMD,SIMD_MUL(signSIMD,stateImagLoSIMD))));
+        }
+    }
+}
+void statevec_phaseShiftByTermAllSIMD (Qureg qureg, const int targetQubit, Complex term)
+{
+    long long int index;
 
+    // const long long int chunkSize=qureg.numAmpsPerChunk;
+    // const long long int chunkId=qureg.chunkId;
 
-            // take the basis index, flip the designated (XOR) 'control' bits, AND with the controls.
-            // if this equals the control mask, the control qubits have the desired values in the basis index
-            if (ctrlQubitsMask == (ctrlQubitsMask & ((indexUp+chunkId*chunkSize) ^ ctrlFlipMask))) {
-                // store current state vector values in temp variables
-                stateRealUp = stateVecReal[indexUp];
-                stateImagUp = stateVecImag[indexUp];
+    // dimension of the state vector
+    long long int stateVecSize = qureg.numAmpsPerChunk;
 
-                stateRealLo = stateVecReal[indexLo];
-                stateImagLo = stateVecImag[indexLo];
+    qreal *stateVecReal = qureg.stateVec.real;
+    qreal *stateVecImag = qureg.stateVec.imag;
 
-                // state[indexUp] = u00 * state[indexUp] + u01 * state[indexLo]
-                stateVecReal[indexUp] = u.real[0][0]*stateRealUp - u.imag[0][0]*stateImagUp
-                    + u.real[0][1]*stateRealLo - u.imag[0][1]*stateImagLo;
-                stateVecImag[indexUp] = u.real[0][0]*stateImagUp + u.imag[0][0]*stateRealUp
-                    + u.real[0][1]*stateImagLo + u.imag[0][1]*stateRealLo;
+    qrealSIMD stateRealLoSIMD, stateImagLoSIMD;
+    register const qrealSIMD cosAngleSIMD = SIMD_SET1(term.real);
+    register const qrealSIMD sinAngleSIMD = SIMD_SET1(term.imag);
 
-                // state[indexLo] = u10  * state[indexUp] + u11 * state[indexLo]
-                stateVecReal[indexLo] = u.real[1][0]*stateRealUp  - u.imag[1][0]*stateImagUp
-                    + u.real[1][1]*stateRealLo  -  u.imag[1][1]*stateImagLo;
-                stateVecImag[indexLo] = u.real[1][0]*stateImagUp + u.imag[1][0]*stateRealUp
-                    + u.real[1][1]*stateImagLo + u.imag[1][1]*stateRealLo;
-            }
-        }
-    }
+# ifdef _OPENMP
+# pragma omp parallel for \
+    shared   (stateVecReal,stateVecImag ) \
+    private  (index,stateRealLoSIMD,stateImagLoSIMD)             \
+    schedule (static)
+# endif
+    for(index=0; index<stateVecSize; index+=SIMD_WIDTH) {
 
-}
+        // update the coeff of the |1> state of the target qubit
+        // targetBit = extractBit (targetQubit, index+chunkId*chunkSize);
+        // if (targetBit) {
 
-void statevec_controlledUnitaryLocal(Qureg qureg, const int controlQubit, const int targetQubit,
-        ComplexMatrix2 u)
-{
-    long long int sizeBlock, sizeHalfBlock;
-    long long int thisBlock, // current block
-         indexUp,indexLo;    // current index and corresponding index in lower half block
+            stateRealLoSIMD = SIMD_LOAD(stateVecReal+index);
+            stateImagLoSIMD = SIMD_LOAD(stateVecImag+index);
 
-    qreal stateRealUp,stateRealLo,stateImagUp,stateImagLo;
-    long long int thisTask;
-    const long long int numTasks=qureg.numAmpsPerChunk>>1;
-    const long long int chunkSize=qureg.numAmpsPerChunk;
-    const long long int chunkId=qureg.chunkId;
+            SIMD_STORE(stateVecReal+index, SIMD_SUB(\
+                            SIMD_MUL(cosAngleSIMD,stateRealLoSIMD),\
+                            SIMD_MUL(sinAngleSIMD,stateImagLoSIMD)));
+            //stateVecReal[index] = cosAngle*stateRealLo - sinAngle*stateImagLo;
 
-    int controlBit;
+            SIMD_STORE(stateVecImag+index, SIMD_ADD(\
+                            SIMD_MUL(sinAngleSIMD,stateRealLoSIMD),\
+                            SIMD_MUL(cosAngleSIMD,stateImagLoSIMD)));
+            //stateVecImag[index] = sinAngle*stateRealLo + cosAngle*stateImagLo;
+        // }
+    }
+}
 
-    // set dimensions
-    sizeHalfBlock = 1LL << targetQubit;
-    sizeBlock     = 2LL * sizeHalfBlock;
 
-    // Can't use qureg.stateVec as a private OMP var
+void statevec_phaseShiftByTermAll (Qureg qureg, const int targetQubit, Complex term)
+{
+    long long int index;
+    long long int stateVecSize;
+
+    // dimension of the state vector
+    stateVecSize = qureg.numAmpsPerChunk;
+    if(stateVecSize >= SIMD_WIDTH) {
+        statevec_phaseShiftByTermAllSIMD(qureg,targetQubit,term);
+        return ;
+    }
+
     qreal *stateVecReal = qureg.stateVec.real;
     qreal *stateVecImag = qureg.stateVec.imag;
 
+    qreal stateRealLo, stateImagLo;
+    const qreal cosAngle = term.real;
+    const qreal sinAngle = term.imag;
+
 # ifdef _OPENMP
-# pragma omp parallel \
-    shared   (sizeBlock,sizeHalfBlock, stateVecReal,stateVecImag, u) \
-    private  (thisTask,thisBlock ,indexUp,indexLo, stateRealUp,stateImagUp,stateRealLo,stateImagLo,controlBit)
-# endif
-    {
-# ifdef _OPENMP
-# pragma omp for schedule (static)
+# pragma omp parallel for \
+    shared   (stateVecSize, stateVecReal,stateVecImag ) \
+    private  (index,stateRealLo,stateImagLo)             \
+    schedule (static)
 # endif
-        for (thisTask=0; thisTask<numTasks; thisTask++) {
+    for (index=0; index<stateVecSize; index++) {
 
-            thisBlock   = thisTask / sizeHalfBlock;
-            indexUp     = thisBlock*sizeBlock + thisTask%sizeHalfBlock;
-            indexLo     = indexUp + sizeHalfBlock;
+        // update the coeff of the |1> state of the target qubit
+            stateRealLo = stateVecReal[index];
+            stateImagLo = stateVecImag[index];
 
-            controlBit = extractBit (controlQubit, indexUp+chunkId*chunkSize);
-            if (controlBit){
-                // store current state vector values in temp variables
-                stateRealUp = stateVecReal[indexUp];
-                stateImagUp = stateVecImag[indexUp];
+            stateVecReal[index] = cosAngle*stateRealLo - sinAngle*stateImagLo;
+            stateVecImag[index] = sinAngle*stateRealLo + cosAngle*stateImagLo;
+    }
+}
 
-                stateRealLo = stateVecReal[indexLo];
-                stateImagLo = stateVecImag[indexLo];
+void statevec_phaseShiftByTermSmall (Qureg qureg, const int targetQubit, Complex term)
+{
+    long long int index;
 
+    // const long long int chunkSize=qureg.numAmpsPerChunk;
+    // const long long int chunkId=qureg.chunkId;
+    if((1LL<<targetQubit)>=qureg.numAmpsPerChunk) {
+        if(extractBit(targetQubit,qureg.chunkId*qureg.numAmpsPerChunk)) {
+            statevec_phaseShiftByTermAll(qureg,targetQubit,term);
+        }
+        return ;
+    }
+    // dimension of the state vector
+    const long long int sizeTask = (1LL << targetQubit);
+    if(sizeTask >= SIMD_WIDTH){
+        statevec_phaseShiftByTermSIMD(qureg,targetQubit,term);
+        return;
+    }
 
-                // state[indexUp] = u00 * state[indexUp] + u01 * state[indexLo]
-                stateVecReal[indexUp] = u.real[0][0]*stateRealUp - u.imag[0][0]*stateImagUp
-                    + u.real[0][1]*stateRealLo - u.imag[0][1]*stateImagLo;
-                stateVecImag[indexUp] = u.real[0][0]*stateImagUp + u.imag[0][0]*stateRealUp
-                    + u.real[0][1]*stateImagLo + u.imag[0][1]*stateRealLo;
+    const long long int numTasks = (qureg.numAmpsPerChunk>>(1 + targetQubit)) ;
+    long long thisTask;
 
-                // state[indexLo] = u10  * state[indexUp] + u11 * state[indexLo]
-                stateVecReal[indexLo] = u.real[1][0]*stateRealUp  - u.imag[1][0]*stateImagUp
-                    + u.real[1][1]*stateRealLo  -  u.imag[1][1]*stateImagLo;
-                stateVecImag[indexLo] = u.real[1][0]*stateImagUp + u.imag[1][0]*stateRealUp
-                    + u.real[1][1]*stateImagLo + u.imag[1][1]*stateRealLo;
-            }
-        }
+    qreal *stateVecReal = qureg.stateVec.real;
+    qreal *stateVecImag = qureg.stateVec.imag;
+
+    qreal stateRealLo, stateImagLo;
+    const qreal cosAngle = term.real;
+    const qreal sinAngle = term.imag;
+
+# ifdef _OPENMP
+# pragma omp parallel for \
+    shared   (stateVecReal,stateVecImag ) \
+    private  (index,stateRealLo,stateImagLo)             \
+    schedule (static)
+# endif
+    for(thisTask = 0; thisTask < numTasks; ++thisTask)
+    for(index = sizeTask * thisTask * 2 + sizeTask; index < sizeTask * (thisTask + 1) * 2; ++index) {
+
+        // update the coeff of the |1> state of the target qubit
+        // targetBit = extractBit (targetQubit, index+chunkId*chunkSize);
+        // if (targetBit) {
+
+            stateRealLo = stateVecReal[index];
+            stateImagLo = stateVecImag[index];
+
+            stateVecReal[index] = cosAngle*stateRealLo - sinAngle*stateImagLo;
+            stateVecImag[index] = sinAngle*stateRealLo + cosAngle*stateImagLo;
+        // }
     }
 }
-void statevec_controlledCompactUnitaryDistributedAllSIMD (Qureg qureg, const int controlQubit,
-        Complex rot1, Complex rot2,
-        ComplexArray stateVecUp,
-        ComplexArray stateVecLo,
-        ComplexArray stateVecOut)
+
+void statevec_phaseShiftByTermSIMD (Qureg qureg, const int targetQubit, Complex term)
 {
+    long long int index;
 
-    __m256d stateRealUpSIMD,stateRealLoSIMD,stateImagUpSIMD,stateImagLoSIMD;
+    // const long long int chunkSize=qureg.numAmpsPerChunk;
+    // const long long int chunkId=qureg.chunkId;
 
-    long long int thisTask;
-    const long long int numTasks=qureg.numAmpsPerChunk;
+    // dimension of the state vector
+    const long long int numTasks = (qureg.numAmpsPerChunk>>(1 + targetQubit)) ;
+    const long long int sizeTask = (1LL << targetQubit);
+    long long thisTask;
 
-    qreal rot1Real=rot1.real, rot1Imag=rot1.imag;
-    qreal rot2Real=rot2.real, rot2Imag=rot2.imag;
-    qreal *stateVecRealUp=stateVecUp.real, *stateVecImagUp=stateVecUp.imag;
-    qreal *stateVecRealLo=stateVecLo.real, *stateVecImagLo=stateVecLo.imag;
-    qreal *stateVecRealOut=stateVecOut.real, *stateVecImagOut=stateVecOut.imag;
+    qreal *stateVecReal = qureg.stateVec.real;
+    qreal *stateVecImag = qureg.stateVec.imag;
 
-    register const __m256d rot1RealSIMD = _mm256_set1_pd(rot1Real);
-    register const __m256d rot1ImagSIMD = _mm256_set1_pd(rot1Imag);
-    register const __m256d rot2RealSIMD = _mm256_set1_pd(rot2Real);
-    register const __m256d rot2ImagSIMD = _mm256_set1_pd(rot2Imag);
+    qrealSIMD stateRealLoSIMD, stateImagLoSIMD;
+    register const qrealSIMD cosAngleSIMD = SIMD_SET1(term.real);
+    register const qrealSIMD sinAngleSIMD = SIMD_SET1(term.imag);
 
 # ifdef _OPENMP
-# pragma omp parallel \
-    shared   (stateVecRealUp,stateVecImagUp,stateVecRealLo,stateVecImagLo,stateVecRealOut,stateVecImagOut, \
-            rot1RealSIMD,rot1ImagSIMD, rot2RealSIMD,rot2ImagSIMD) \
-    private  (thisTask,stateRealUpSIMD,stateImagUpSIMD,stateRealLoSIMD,stateImagLoSIMD)
-# endif
-    {
-# ifdef _OPENMP
-# pragma omp for schedule (static)
+    if(numTasks >= omp_get_num_threads()) {
+# pragma omp parallel for \
+    shared   (stateVecReal,stateVecImag ) \
+    private  (index,stateRealLoSIMD,stateImagLoSIMD)             \
+    schedule (static)
 # endif
-        for (thisTask=0; thisTask<numTasks; thisTask+=4) {
-                stateRealUpSIMD = _mm256_loadu_pd(stateVecRealUp+thisTask);
-                stateImagUpSIMD = _mm256_loadu_pd(stateVecImagUp+thisTask);
+    for(thisTask = 0; thisTask < numTasks; ++thisTask)
+    for(index = sizeTask * thisTask * 2 + sizeTask; index < sizeTask * (thisTask + 1) * 2; index+=SIMD_WIDTH) {
+
+        // update the coeff of the |1> state of the target qubit
+        // targetBit = extractBit (targetQubit, index+chunkId*chunkSize);
+        // if (targetBit) {
 
-                stateRealLoSIMD = _mm256_loadu_pd(stateVecRealLo+thisTask);
-                stateImagLoSIMD = _mm256_loadu_pd(stateVecImagLo+thisTask);
+            stateRealLoSIMD = SIMD_LOAD(stateVecReal+index);
+            stateImagLoSIMD = SIMD_LOAD(stateVecImag+index);
 
-                _mm256_storeu_pd(stateVecRealOut+thisTask, _mm256_add_pd( \
-                                _mm256_sub_pd(_mm256_mul_pd(rot1RealSIMD,stateRealUpSIMD),_mm256_mul_pd(rot1ImagSIMD,stateImagUpSIMD)), \
-                                _mm256_add_pd(_mm256_mul_pd(rot2RealSIMD,stateRealLoSIMD),_mm256_mul_pd(rot2ImagSIMD,stateImagLoSIMD))));
+            SIMD_STORE(stateVecReal+index, SIMD_SUB(\
+                            SIMD_MUL(cosAngleSIMD,stateRealLoSIMD),\
+                            SIMD_MUL(sinAngleSIMD,stateImagLoSIMD)));
+            //stateVecReal[index] = cosAngle*stateRealLo - sinAngle*stateImagLo;
 
-                _mm256_storeu_pd(stateVecImagOut+thisTask, _mm256_add_pd( \
-                                _mm256_add_pd(_mm256_mul_pd(rot1RealSIMD,stateImagUpSIMD),_mm256_mul_pd(rot1ImagSIMD,stateRealUpSIMD)), \
-                                _mm256_sub_pd(_mm256_mul_pd(rot2RealSIMD,stateImagLoSIMD),_mm256_mul_pd(rot2ImagSIMD,stateRealLoSIMD))));
-        }
+            SIMD_STORE(stateVecImag+index, SIMD_ADD(\
+                            SIMD_MUL(sinAngleSIMD,stateRealLoSIMD),\
+                            SIMD_MUL(cosAngleSIMD,stateImagLoSIMD)));
+            //stateVecImag[index] = sinAngle*stateRealLo + cosAngle*stateImagLo;
+        // }
     }
-}
+    
+# ifdef _OPENMP
+   } else {
+        for(thisTask = 0; thisTask < numTasks; ++thisTask)
 
+# pragma omp parallel for \
+    shared   (stateVecReal,stateVecImag ) \
+    private  (index,stateRealLoSIMD,stateImagLoSIMD)             \
+    schedule (static)
+    for(index = sizeTask * thisTask * 2 + sizeTask; index < sizeTask * (thisTask + 1) * 2; index+=SIMD_WIDTH) {
 
-void statevec_controlledCompactUnitaryDistributedAll (Qureg qureg, const int controlQubit,
-        Complex rot1, Complex rot2,
-        ComplexArray stateVecUp,
-        ComplexArray stateVecLo,
-        ComplexArray stateVecOut)
-{
-    qreal   stateRealUp,stateRealLo,stateImagUp,stateImagLo;
-    long long int thisTask;
-    const long long int numTasks=qureg.numAmpsPerChunk;
-    if(numTasks>4){
-        statevec_controlledCompactUnitaryDistributedAllSIMD(qureg,controlQubit,rot1,rot2,stateVecUp,stateVecLo,stateVecOut);
-        return ;
-    }
-    qreal rot1Real=rot1.real, rot1Imag=rot1.imag;
-    qreal rot2Real=rot2.real, rot2Imag=rot2.imag;
-    qreal *stateVecRealUp=stateVecUp.real, *stateVecImagUp=stateVecUp.imag;
-    qreal *stateVecRealLo=stateVecLo.real, *stateVecImagLo=stateVecLo.imag;
-    qreal *stateVecRealOut=stateVecOut.real, *stateVecImagOut=stateVecOut.imag;
+        // update the coeff of the |1> state of the target qubit
+        // targetBit = extractBit (targetQubit, index+chunkId*chunkSize);
+        // if (targetBit) {
 
-# ifdef _OPENMP
-# pragma omp parallel \
-    shared   (stateVecRealUp,stateVecImagUp,stateVecRealLo,stateVecImagLo,stateVecRealOut,stateVecImagOut, \
-            rot1Real,rot1Imag, rot2Real,rot2Imag) \
-    private  (thisTask,stateRealUp,stateImagUp,stateRealLo,stateImagLo)
-# endif
-    {
-# ifdef _OPENMP
-# pragma omp for schedule (static)
-# endif
-        for (thisTask=0; thisTask<numTasks; thisTask++) {
-                // store current state vector values in temp variables
-                stateRealUp = stateVecRealUp[thisTask];
-                stateImagUp = stateVecImagUp[thisTask];
+            stateRealLoSIMD = SIMD_LOAD(stateVecReal+index);
+            stateImagLoSIMD = SIMD_LOAD(stateVecImag+index);
 
-                stateRealLo = stateVecRealLo[thisTask];
-                stateImagLo = stateVecImagLo[thisTask];
+            SIMD_STORE(stateVecReal+index, SIMD_SUB(\
+                            SIMD_MUL(cosAngleSIMD,stateRealLoSIMD),\
+                            SIMD_MUL(sinAngleSIMD,stateImagLoSIMD)));
+            //stateVecReal[index] = cosAngle*stateRealLo - sinAngle*stateImagLo;
 
-                // state[indexUp] = alpha * state[indexUp] - conj(beta)  * state[indexLo]
-                stateVecRealOut[thisTask] = rot1Real*stateRealUp - rot1Imag*stateImagUp + rot2Real*stateRealLo + rot2Imag*stateImagLo;
-                stateVecImagOut[thisTask] = rot1Real*stateImagUp + rot1Imag*stateRealUp + rot2Real*stateImagLo - rot2Imag*stateRealLo;
-        }
+            SIMD_STORE(stateVecImag+index, SIMD_ADD(\
+                            SIMD_MUL(sinAngleSIMD,stateRealLoSIMD),\
+                            SIMD_MUL(cosAngleSIMD,stateImagLoSIMD)));
+            //stateVecImag[index] = sinAngle*stateRealLo + cosAngle*stateImagLo;
+        // }
     }
-}
+   }
+# endif
 
+}
 
-/** Rotate a single qubit in the state vector of probability amplitudes, given two complex
- * numbers alpha and beta and a subset of the state vector with upper and lower block values
- * stored seperately. Only perform the rotation where the control qubit is one.
- *
- *  @param[in,out] qureg object representing the set of qubits
- *  @param[in] controlQubit qubit to determine whether or not to perform a rotation
- *  @param[in] rot1 rotation angle
- *  @param[in] rot2 rotation angle
- *  @param[in] stateVecUp probability amplitudes in upper half of a block
- *  @param[in] stateVecLo probability amplitudes in lower half of a block
- *  @param[out] stateVecOut array section to update (will correspond to either the lower or upper half of a block)
- */
-void statevec_controlledCompactUnitaryDistributed (Qureg qureg, const int controlQubit,
-        Complex rot1, Complex rot2,
-        ComplexArray stateVecUp,
-        ComplexArray stateVecLo,
-        ComplexArray stateVecOut)
+void statevec_phaseShiftByTerm (Qureg qureg, const int targetQubit, Complex term)
 {
-    if((1LL<<controlQubit)>=qureg.numAmpsPerChunk) {
-        if(extractBit(controlQubit,qureg.chunkId*qureg.numAmpsPerChunk)) {
-            statevec_controlledCompactUnitaryDistributedAll(qureg,controlQubit,rot1,rot2,stateVecUp,stateVecLo,stateVecOut);
-        }
-        return ;
-    }
-    qreal   stateRealUp,stateRealLo,stateImagUp,stateImagLo;
-    long long int thisTask;
-    const long long int numTasks=qureg.numAmpsPerChunk;
+    long long int index;
+    long long int stateVecSize;
+    int targetBit;
+
     const long long int chunkSize=qureg.numAmpsPerChunk;
     const long long int chunkId=qureg.chunkId;
 
-    if((1<<(controlQubit-1)) >= 4){
-        statevec_controlledCompactUnitaryDistributedSIMD(qureg,controlQubit,rot1,rot2,stateVecUp,stateVecLo,stateVecOut);
-        return;
-    }
-
-    int controlBit;
+    // dimension of the state vector
+    stateVecSize = qureg.numAmpsPerChunk;
+    qreal *stateVecReal = qureg.stateVec.real;
+    qreal *stateVecImag = qureg.stateVec.imag;
 
-    qreal rot1Real=rot1.real, rot1Imag=rot1.imag;
-    qreal rot2Real=rot2.real, rot2Imag=rot2.imag;
-    qreal *stateVecRealUp=stateVecUp.real, *stateVecImagUp=stateVecUp.imag;
-    qreal *stateVecRealLo=stateVecLo.real, *stateVecImagLo=stateVecLo.imag;
-    qreal *stateVecRealOut=stateVecOut.real, *stateVecImagOut=stateVecOut.imag;
+    qreal stateRealLo, stateImagLo;
+    const qreal cosAngle = term.real;
+    const qreal sinAngle = term.imag;
 
 # ifdef _OPENMP
-# pragma omp parallel \
-    shared   (stateVecRealUp,stateVecImagUp,stateVecRealLo,stateVecImagLo,stateVecRealOut,stateVecImagOut, \
-            rot1Real,rot1Imag, rot2Real,rot2Imag) \
-    private  (thisTask,stateRealUp,stateImagUp,stateRealLo,stateImagLo,controlBit)
-# endif
-    {
-# ifdef _OPENMP
-# pragma omp for schedule (static)
+# pragma omp parallel for \
+    shared   (stateVecSize, stateVecReal,stateVecImag ) \
+    private  (index,targetBit,stateRealLo,stateImagLo)             \
+    schedule (static)
 # endif
-        for (thisTask=0; thisTask<numTasks; thisTask++) {
-            controlBit = extractBit (controlQubit, thisTask+chunkId*chunkSize);
-            if (controlBit){
-                // store current state vector values in temp variables
-                stateRealUp = stateVecRealUp[thisTask];
-                stateImagUp = stateVecImagUp[thisTask];
+    for (index=0; index<stateVecSize; index++) {
 
-                stateRealLo = stateVecRealLo[thisTask];
-                stateImagLo = stateVecImagLo[thisTask];
+        // update the coeff of the |1> state of the target qubit
+        targetBit = extractBit (targetQubit, index+chunkId*chunkSize);
+        if (targetBit) {
 
-                // state[indexUp] = alpha * state[indexUp] - conj(beta)  * state[indexLo]
-                stateVecRealOut[thisTask] = rot1Real*stateRealUp - rot1Imag*stateImagUp + rot2Real*stateRealLo + rot2Imag*stateImagLo;
-                stateVecImagOut[thisTask] = rot1Real*stateImagUp + rot1Imag*stateRealUp + rot2Real*stateImagLo - rot2Imag*stateRealLo;
-            }
+            stateRealLo = stateVecReal[index];
+            stateImagLo = (stateVecImag)? stateVecImag[index] : 0; // absent for real-amplitude registers
+
+            stateVecReal[index] = cosAngle*stateRealLo - sinAngle*stateImagLo;
+            if (stateVecImag)
+                stateVecImag[index] = sinAngle*stateRealLo + cosAngle*stateImagLo;
         }
     }
 }
 
-void statevec_controlledCompactUnitaryDistributedSIMD (Qureg qureg, const int controlQubit,
-        Complex rot1, Complex rot2,
-        ComplexArray stateVecUp,
-        ComplexArray stateVecLo,
-        ComplexArray stateVecOut)
+void statevec_controlledPhaseShift (Qureg qureg, const int idQubit1, const int idQubit2, qreal angle)
 {
+    long long int index;
+    long long int stateVecSize;
+    int bit1, bit2;
 
-    __m256d stateRealUpSIMD,stateRealLoSIMD,stateImagUpSIMD,stateImagLoSIMD;
-
-    long long int thisTask;
-    long long int thisBlock;
-    long long int taskEnd;
     const long long int chunkSize=qureg.numAmpsPerChunk;
     const long long int chunkId=qureg.chunkId;
 
-    const long long int blockSize=2LL<<controlQubit;
-    const long long int halfBlockSize = blockSize>>1;
-
-    const long long int blockStart=(chunkId*chunkSize)/(blockSize);
-    const long long int blockRange=(chunkSize>blockSize)?(chunkSize/blockSize):1;
-    const long long int blockEnd=(chunkId+1)*chunkSize-blockStart*blockSize;
-    if(blockEnd <= 0) return;
-
-    qreal rot1Real=rot1.real, rot1Imag=rot1.imag;
-    qreal rot2Real=rot2.real, rot2Imag=rot2.imag;
-    qreal *stateVecRealUp=stateVecUp.real, *stateVecImagUp=stateVecUp.imag;
-    qreal *stateVecRealLo=stateVecLo.real, *stateVecImagLo=stateVecLo.imag;
-    qreal *stateVecRealOut=stateVecOut.real, *stateVecImagOut=stateVecOut.imag;
+    // dimension of the state vector
+    stateVecSize = qureg.numAmpsPerChunk;
+    qreal *stateVecReal = qureg.stateVec.real;
+    qreal *stateVecImag = qureg.stateVec.imag;
 
-    register const __m256d rot1RealSIMD = _mm256_set1_pd(rot1Real);
-    register const __m256d rot1ImagSIMD = _mm256_set1_pd(rot1Imag);
-    register const __m256d rot2RealSIMD = _mm256_set1_pd(rot2Real);
-    register const __m256d rot2ImagSIMD = _mm256_set1_pd(rot2Imag);
+    qreal stateRealLo, stateImagLo;
+    const qreal cosAngle = cos(angle);
+    const qreal sinAngle = sin(angle);
 
 # ifdef _OPENMP
-    if(blockRange >= omp_get_num_threads()){
-# pragma omp parallel \
-    shared   (stateVecRealUp,stateVecImagUp,stateVecRealLo,stateVecImagLo,stateVecRealOut,stateVecImagOut, \
-            rot1RealSIMD,rot1ImagSIMD, rot2RealSIMD,rot2ImagSIMD) \
-    private  (thisTask,thisBlock,taskEnd,stateRealUpSIMD,stateImagUpSIMD,stateRealLoSIMD,stateImagLoSIMD)
-# endif
-    {
-# ifdef _OPENMP
-# pragma omp for schedule (static)
+# pragma omp parallel for \
+    shared   (stateVecSize, stateVecReal,stateVecImag ) \
+    private  (index,bit1,bit2,stateRealLo,stateImagLo)             \
+    schedule (static)
 # endif
-        for(thisBlock=0; thisBlock<blockRange; thisBlock++){
-            taskEnd = fmin(blockEnd,(thisBlock+1)*blockSize);
-
-            for(thisTask=thisBlock*blockSize+halfBlockSize; thisTask<taskEnd; thisTask+=4){
-                stateRealUpSIMD = _mm256_loadu_pd(stateVecRealUp+thisTask);
-                stateImagUpSIMD = _mm256_loadu_pd(stateVecImagUp+thisTask);
-
-                stateRealLoSIMD = _mm256_loadu_pd(stateVecRealLo+thisTask);
-                stateImagLoSIMD = _mm256_loadu_pd(stateVecImagLo+thisTask);
-
-                _mm256_storeu_pd(stateVecRealOut+thisTask, _mm256_add_pd( \
-                                _mm256_sub_pd(_mm256_mul_pd(rot1RealSIMD,stateRealUpSIMD),_mm256_mul_pd(rot1ImagSIMD,stateImagUpSIMD)), \
-                                _mm256_add_pd(_mm256_mul_pd(rot2RealSIMD,stateRealLoSIMD),_mm256_mul_pd(rot2ImagSIMD,stateImagLoSIMD))));
-
-                _mm256_storeu_pd(stateVecImagOut+thisTask, _mm256_add_pd( \
-                                _mm256_add_pd(_mm256_mul_pd(rot1RealSIMD,stateImagUpSIMD),_mm256_mul_pd(rot1ImagSIMD,stateRealUpSIMD)), \
-                                _mm256_sub_pd(_mm256_mul_pd(rot2RealSIMD,stateImagLoSIMD),_mm256_mul_pd(rot2ImagSIMD,stateRealLoSIMD))));
-            }
-        }
-    }
-# ifdef _OPENMP
-    } else {
-        for(thisBlock=0; thisBlock<blockRange; thisBlock++){
-            taskEnd = fmin(blockEnd,(thisBlock+1)*blockSize);
-# pragma omp parallel \
-    shared   (taskEnd,thisBlock,stateVecRealUp,stateVecImagUp,stateVecRealLo,stateVecImagLo,stateVecRealOut,stateVecImagOut, \
-            rot1RealSIMD,rot1ImagSIMD, rot2RealSIMD,rot2ImagSIMD) \
-    private  (thisTask,stateRealUpSIMD,stateImagUpSIMD,stateRealLoSIMD,stateImagLoSIMD)
-    {
-# pragma omp for schedule (static)
-            for(thisTask=thisBlock*blockSize+halfBlockSize; thisTask<taskEnd; thisTask+=4){
-                stateRealUpSIMD = _mm256_loadu_pd(stateVecRealUp+thisTask);
-                stateImagUpSIMD = _mm256_loadu_pd(stateVecImagUp+thisTask);
-
-                stateRealLoSIMD = _mm256_loadu_pd(stateVecRealLo+thisTask);
-                stateImagLoSIMD = _mm256_loadu_pd(stateVecImagLo+thisTask);
+    for (index=0; index<stateVecSize; index++) {
+        bit1 = extractBit (idQubit1, index+chunkId*chunkSize);
+        bit2 = extractBit (idQubit2, index+chunkId*chunkSize);
+        if (bit1 && bit2) {
 
-                _mm256_storeu_pd(stateVecRealOut+thisTask, _mm256_add_pd( \
-                                _mm256_sub_pd(_mm256_mul_pd(rot1RealSIMD,stateRealUpSIMD),_mm256_mul_pd(rot1ImagSIMD,stateImagUpSIMD)), \
-                                _mm256_add_pd(_mm256_mul_pd(rot2RealSIMD,stateRealLoSIMD),_mm256_mul_pd(rot2ImagSIMD,stateImagLoSIMD))));
+            stateRealLo = stateVecReal[index];
+            stateImagLo = (stateVecImag)? stateVecImag[index] : 0; // absent for real-amplitude registers
 
-                _mm256_storeu_pd(stateVecImagOut+thisTask, _mm256_add_pd( \
-                                _mm256_add_pd(_mm256_mul_pd(rot1RealSIMD,stateImagUpSIMD),_mm256_mul_pd(rot1ImagSIMD,stateRealUpSIMD)), \
-                                _mm256_sub_pd(_mm256_mul_pd(rot2RealSIMD,stateImagLoSIMD),_mm256_mul_pd(rot2ImagSIMD,stateRealLoSIMD))));
-            }
+            stateVecReal[index] = cosAngle*stateRealLo - sinAngle*stateImagLo;
+            if (stateVecImag)
+                stateVecImag[index] = sinAngle*stateRealLo + cosAngle*stateImagLo;
         }
     }
-    }
-#endif
 }
 
-/** Rotate a single qubit in the state vector of probability amplitudes, given two complex
- *  numbers alpha and beta and a subset of the state vector with upper and lower block values
- *  stored seperately. Only perform the rotation where the control qubit is one.
- *
- *  @param[in,out] qureg object representing the set of qubits
- *  @param[in] controlQubit qubit to determine whether or not to perform a rotation
- *  @param[in] rot1 rotation angle
- *  @param[in] rot2 rotation angle
- *  @param[in] stateVecUp probability amplitudes in upper half of a block
- *  @param[in] stateVecLo probability amplitudes in lower half of a block
- *  @param[out] stateVecOut array section to update (will correspond to either the lower or upper half of a block)
- */
-void statevec_controlledUnitaryDistributed (Qureg qureg, const int controlQubit,
-        Complex rot1, Complex rot2,
-        ComplexArray stateVecUp,
-        ComplexArray stateVecLo,
-        ComplexArray stateVecOut)
+void statevec_multiControlledPhaseShift(Qureg qureg, int *controlQubits, int numControlQubits, qreal angle)
 {
+    long long int index;
+    long long int stateVecSize;
 
-    qreal   stateRealUp,stateRealLo,stateImagUp,stateImagLo;
-    long long int thisTask;
-    const long long int numTasks=qureg.numAmpsPerChunk;
     const long long int chunkSize=qureg.numAmpsPerChunk;
     const long long int chunkId=qureg.chunkId;
 
-    int controlBit;
+    long long int mask = getQubitBitMask(controlQubits, numControlQubits);
 
-    qreal rot1Real=rot1.real, rot1Imag=rot1.imag;
-    qreal rot2Real=rot2.real, rot2Imag=rot2.imag;
-    qreal *stateVecRealUp=stateVecUp.real, *stateVecImagUp=stateVecUp.imag;
-    qreal *stateVecRealLo=stateVecLo.real, *stateVecImagLo=stateVecLo.imag;
-    qreal *stateVecRealOut=stateVecOut.real, *stateVecImagOut=stateVecOut.imag;
+    stateVecSize = qureg.numAmpsPerChunk;
+    qreal *stateVecReal = qureg.stateVec.real;
+    qreal *stateVecImag = qureg.stateVec.imag;
+
+    qreal stateRealLo, stateImagLo;
+    const qreal cosAngle = cos(angle);
+    const qreal sinAngle = sin(angle);
 
 # ifdef _OPENMP
 # pragma omp parallel \
-    shared   (stateVecRealUp,stateVecImagUp,stateVecRealLo,stateVecImagLo,stateVecRealOut,stateVecImagOut, \
-            rot1Real,rot1Imag, rot2Real,rot2Imag) \
-    private  (thisTask,stateRealUp,stateImagUp,stateRealLo,stateImagLo,controlBit)
+    shared   (stateVecSize, stateVecReal, stateVecImag, mask) \
+    private  (index, stateRealLo, stateImagLo)
 # endif
     {
 # ifdef _OPENMP
 # pragma omp for schedule (static)
 # endif
-        for (thisTask=0; thisTask<numTasks; thisTask++) {
-            controlBit = extractBit (controlQubit, thisTask+chunkId*chunkSize);
-            if (controlBit){
-                // store current state vector values in temp variables
-                stateRealUp = stateVecRealUp[thisTask];
-                stateImagUp = stateVecImagUp[thisTask];
+        for (index=0; index<stateVecSize; index++) {
+            if (mask == (mask & (index+chunkId*chunkSize)) ){
 
-                stateRealLo = stateVecRealLo[thisTask];
-                stateImagLo = stateVecImagLo[thisTask];
+                stateRealLo = stateVecReal[index];
+                stateImagLo = stateVecImag[index];
 
-                stateVecRealOut[thisTask] = rot1Real*stateRealUp - rot1Imag*stateImagUp
-                    + rot2Real*stateRealLo - rot2Imag*stateImagLo;
-                stateVecImagOut[thisTask] = rot1Real*stateImagUp + rot1Imag*stateRealUp
-                    + rot2Real*stateImagLo + rot2Imag*stateRealLo;
+                stateVecReal[index] = cosAngle*stateRealLo - sinAngle*stateImagLo;
+                stateVecImag[index] = sinAngle*stateRealLo + cosAngle*stateImagLo;
             }
         }
     }
 }
 
-/** Apply a unitary operation to a single qubit in the state vector of probability amplitudes, given
- *  a subset of the state vector with upper and lower block values
- stored seperately. Only perform the rotation where all the control qubits are 1.
- *
- *  @param[in,out] qureg object representing the set of qubits
- *  @param[in] targetQubit qubit to rotate
- *  @param[in] ctrlQubitsMask a bit mask indicating whether each qubit is a control (1) or not (0)
- *  @param[in] ctrlFlipMask a bit mask indicating whether each qubit (only controls are relevant)
- *             should be flipped when checking the control condition
- *  @param[in] rot1 rotation angle
- *  @param[in] rot2 rotation angle
- *  @param[in] stateVecUp probability amplitudes in upper half of a block
- *  @param[in] stateVecLo probability amplitudes in lower half of a block
- *  @param[out] stateVecOut array section to update (will correspond to either the lower or upper half of a block)
- */
-void statevec_multiControlledUnitaryDistributed (
-        Qureg qureg,
-        const int targetQubit,
-        long long int ctrlQubitsMask, long long int ctrlFlipMask,
-        Complex rot1, Complex rot2,
-        ComplexArray stateVecUp,
-        ComplexArray stateVecLo,
-        ComplexArray stateVecOut)
+int getBitMaskParity(long long int mask) {
+    int parity = 0;
+    while (mask) {
+        parity = !parity;
+        mask = mask & (mask-1);
+    }
+    return parity;
+}
+
+void statevec_multiRotateZ(Qureg qureg, long long int mask, qreal angle)
 {
+    long long int index;
+    long long int stateVecSize;
 
-    qreal   stateRealUp,stateRealLo,stateImagUp,stateImagLo;
-    long long int thisTask;
-    const long long int numTasks=qureg.numAmpsPerChunk;
     const long long int chunkSize=qureg.numAmpsPerChunk;
     const long long int chunkId=qureg.chunkId;
 
-    qreal rot1Real=rot1.real, rot1Imag=rot1.imag;
-    qreal rot2Real=rot2.real, rot2Imag=rot2.imag;
-    qreal *stateVecRealUp=stateVecUp.real, *stateVecImagUp=stateVecUp.imag;
-    qreal *stateVecRealLo=stateVecLo.real, *stateVecImagLo=stateVecLo.imag;
-    qreal *stateVecRealOut=stateVecOut.real, *stateVecImagOut=stateVecOut.imag;
+    stateVecSize = qureg.numAmpsPerChunk;
+    qreal *stateVecReal = qureg.stateVec.real;
+    qreal *stateVecImag = qureg.stateVec.imag;
+
+    qreal stateReal, stateImag;
+    const qreal cosAngle = cos(angle/2.0);
+    const qreal sinAngle = sin(angle/2.0);
+
+    // = +-1, to flip sinAngle based on target qubit parity, to effect
+    // exp(-angle/2 i fac_j)|j>
+    int fac;
 
 # ifdef _OPENMP
 # pragma omp parallel \
-    shared   (stateVecRealUp,stateVecImagUp,stateVecRealLo,stateVecImagLo,stateVecRealOut,stateVecImagOut, \
-            rot1Real,rot1Imag, rot2Real,rot2Imag, ctrlQubitsMask,ctrlFlipMask) \
-    private  (thisTask,stateRealUp,stateImagUp,stateRealLo,stateImagLo)
+    shared   (stateVecSize, stateVecReal, stateVecImag, mask) \
+    private  (index, fac, stateReal, stateImag)
 # endif
     {
 # ifdef _OPENMP
 # pragma omp for schedule (static)
 # endif
-        for (thisTask=0; thisTask<numTasks; thisTask++) {
-            if (ctrlQubitsMask == (ctrlQubitsMask & ((thisTask+chunkId*chunkSize) ^ ctrlFlipMask))) {
-                // store current state vector values in temp variables
-                stateRealUp = stateVecRealUp[thisTask];
-                stateImagUp = stateVecImagUp[thisTask];
-
-                stateRealLo = stateVecRealLo[thisTask];
-                stateImagLo = stateVecImagLo[thisTask];
+        for (index=0; index<stateVecSize; index++) {
+            stateReal = stateVecReal[index];
+            stateImag = stateVecImag[index];
 
-                stateVecRealOut[thisTask] = rot1Real*stateRealUp - rot1Imag*stateImagUp
-                    + rot2Real*stateRealLo - rot2Imag*stateImagLo;
-                stateVecImagOut[thisTask] = rot1Real*stateImagUp + rot1Imag*stateRealUp
-                    + rot2Real*stateImagLo + rot2Imag*stateRealLo;
-            }
+            // odd-parity target qubits get fac_j = -1
+            fac = getBitMaskParity(mask & (index+chunkId*chunkSize))? -1 : 1;
+            stateVecReal[index] = cosAngle*stateReal + fac * sinAngle*stateImag;
+            stateVecImag[index] = - fac * sinAngle*stateReal + cosAngle*stateImag;
         }
     }
 }
 
-void statevec_pauliXLocalSmall(Qureg qureg, const int targetQubit)
-{
-    long long int indexUp,indexLo;    // current index and corresponding index in lower half block
+qreal densmatr_findProbabilityOfZeroLocal(Qureg qureg, const int measureQubit) {
 
-    qreal stateRealUp,stateImagUp;
-    const long long int numTasks = (qureg.numAmpsPerChunk>>(1 + targetQubit)) ;
-    const long long int sizeTask = (1LL << targetQubit);
-    long long thisTask;
+    // computes first local index containing a diagonal element
+    long long int localNumAmps = qureg.numAmpsPerChunk;
+    long long int densityDim = (1LL << qureg.numQubitsRepresented);
+    long long int diagSpacing = 1LL + densityDim;
+    long long int maxNumDiagsPerChunk = 1 + localNumAmps / diagSpacing;
+    long long int numPrevDiags = (qureg.chunkId>0)? 1+(qureg.chunkId*localNumAmps)/diagSpacing : 0;
+    long long int globalIndNextDiag = diagSpacing * numPrevDiags;
+    long long int localIndNextDiag = globalIndNextDiag % localNumAmps;
 
-    // Can't use qureg.stateVec as a private OMP var
+    // computes how many diagonals are contained in this chunk
+    long long int numDiagsInThisChunk = maxNumDiagsPerChunk;
+    if (localIndNextDiag + (numDiagsInThisChunk-1)*diagSpacing >= localNumAmps)
+        numDiagsInThisChunk -= 1;
+
+    long long int visitedDiags;     // number of visited diagonals in this chunk so far
+    long long int basisStateInd;    // current diagonal index being considered
+    long long int index;            // index in the local chunk
+
+    qreal zeroProb = 0;
     qreal *stateVecReal = qureg.stateVec.real;
-    qreal *stateVecImag = qureg.stateVec.imag;
 
 # ifdef _OPENMP
-    if(numTasks >= omp_get_num_threads()){
 # pragma omp parallel \
-    shared   (stateVecReal,stateVecImag) \
-    private  (thisTask,indexUp,indexLo, stateRealUp,stateImagUp)
+    shared    (localIndNextDiag, numPrevDiags, diagSpacing, stateVecReal, numDiagsInThisChunk) \
+    private   (visitedDiags, basisStateInd, index) \
+    reduction ( +:zeroProb )
 # endif
     {
 # ifdef _OPENMP
-# pragma omp for schedule (static)
+# pragma omp for schedule  (static)
 # endif
-        for (thisTask = 0; thisTask < numTasks; ++thisTask)
-        for (indexUp = thisTask * sizeTask * 2; indexUp < thisTask * sizeTask * 2 + sizeTask; ++ indexUp) {
-
-            indexLo     = indexUp + sizeTask;
+        // sums the diagonal elems of the density matrix where measureQubit=0
+        for (visitedDiags = 0; visitedDiags < numDiagsInThisChunk; visitedDiags++) {
 
-            stateRealUp = stateVecReal[indexUp];
-            stateImagUp = stateVecImag[indexUp];
+            basisStateInd = numPrevDiags + visitedDiags;
+            index = localIndNextDiag + diagSpacing * visitedDiags;
 
-            stateVecReal[indexUp] = stateVecReal[indexLo];
-            stateVecImag[indexUp] = stateVecImag[indexLo];
+            if (extractBit(measureQubit, basisStateInd) == 0)
+                zeroProb += stateVecReal[index]; // assume imag[diagonls] ~ 0
 
-            stateVecReal[indexLo] = stateRealUp;
-            stateVecImag[indexLo] = stateImagUp;
         }
     }
+
+    return zeroProb;
+}
+
+/** Gives the contiguous range [startTask, endTask) of numTasks assigned to the calling thread. 
+ * Successive parallel regions calling this with the same numTasks and number of threads 
+ * assign every thread the same tasks.
+ */
+static void getThreadTaskRange(long long int numTasks, long long int* startTask, long long int* endTask) {
+
+    long long int numThreads = 1, thread = 0;
 # ifdef _OPENMP
-    }else {
-        for (thisTask = 0; thisTask < numTasks; ++thisTask)
+    numThreads = omp_get_num_threads();
+    thread = omp_get_thread_num();
+# endif
+    long long int numPerThread = numTasks / numThreads;
+    long long int numExtra = numTasks % numThreads;
+    *startTask = thread*numPerThread + ((thread < numExtra)? thread : numExtra);
+    *endTask = *startTask + numPerThread + ((thread < numExtra)? 1 : 0);
+}
+
+/** Sum the probability of the amplitudes with measureQubit=0 of tasks [startTask, endTask), where 
+ * task t is the t-th amplitude among the first halves of every block. The tasks within one block 
+ * are contiguous amplitudes, so they are visited as runs rather than by an index computed per task, 
+ * and are summed SIMD_WIDTH at a time into independent partial sums.
+ */
+static qreal findProbabilityOfZeroInTasks(qreal* stateVecReal, qreal* stateVecImag, int measureQubit,
+        long long int startTask, long long int endTask) {
+
+    long long int thisTask, nextTask, index, runEnd;
+    qreal zeroProb = 0;
+
+    qrealSIMD realSIMD, imagSIMD;
+    qrealSIMD zeroProbSIMD = SIMD_SET1(0);
+    qreal zeroProbLanes[SIMD_WIDTH];
+
+    for (thisTask=startTask; thisTask<endTask; thisTask=nextTask) {
+        nextTask = ((thisTask >> measureQubit) + 1) << measureQubit;
+        if (nextTask > endTask)
+            nextTask = endTask;
+
+        index = thisTask + ((thisTask >> measureQubit) << measureQubit);
+        runEnd = index + (nextTask - thisTask);
+        for (; index+SIMD_WIDTH<=runEnd; index+=SIMD_WIDTH) {
+            realSIMD = SIMD_LOAD(&stateVecReal[index]);
+            imagSIMD = SIMD_LOAD(&stateVecImag[index]);
+            zeroProbSIMD = SIMD_ADD(zeroProbSIMD,
+                SIMD_ADD(SIMD_MUL(realSIMD, realSIMD), SIMD_MUL(imagSIMD, imagSIMD)));
+        }
+        for (; index<runEnd; index++)
+            zeroProb += stateVecReal[index]*stateVecReal[index]
+                + stateVecImag[index]*stateVecImag[index];
+    }
+
+    SIMD_STORE(zeroProbLanes, zeroProbSIMD);
+    for (int lane=0; lane<SIMD_WIDTH; lane++)
+        zeroProb += zeroProbLanes[lane];
+    return zeroProb;
+}
+
+/** Collapse the amplitudes of tasks [startTask, endTask) (as per findProbabilityOfZeroInTasks) to 
+ * measureQubit=outcome, scaling the consistent amplitude of each task by renorm and zeroing the other, 
+ * SIMD_WIDTH tasks at a time.
+ */
+static void collapseToOutcomeInTasks(qreal* stateVecReal, qreal* stateVecImag, int measureQubit, int outcome,
+        qreal renorm, long long int startTask, long long int endTask) {
+
+    long long int sizeHalfBlock = 1LL << measureQubit;
+    long long int keepOffset = (outcome)? sizeHalfBlock : 0;
+    long long int zeroOffset = sizeHalfBlock - keepOffset;
+    long long int thisTask, nextTask, index, runEnd;
+
+    const qrealSIMD renormSIMD = SIMD_SET1(renorm);
+    const qrealSIMD zeroSIMD = SIMD_SET1(0);
+
+    for (thisTask=startTask; thisTask<endTask; thisTask=nextTask) {
+        nextTask = ((thisTask >> measureQubit) + 1) << measureQubit;
+        if (nextTask > endTask)
+            nextTask = endTask;
+
+        index = thisTask + ((thisTask >> measureQubit) << measureQubit);
+        runEnd = index + (nextTask - thisTask);
+        for (; index+SIMD_WIDTH<=runEnd; index+=SIMD_WIDTH) {
+            SIMD_STORE(&stateVecReal[index+keepOffset], SIMD_MUL(renormSIMD, SIMD_LOAD(&stateVecReal[index+keepOffset])));
+            SIMD_STORE(&stateVecImag[index+keepOffset], SIMD_MUL(renormSIMD, SIMD_LOAD(&stateVecImag[index+keepOffset])));
+            SIMD_STORE(&stateVecReal[index+zeroOffset], zeroSIMD);
+            SIMD_STORE(&stateVecImag[index+zeroOffset], zeroSIMD);
+        }
+        for (; index<runEnd; index++) {
+            stateVecReal[index+keepOffset] *= renorm;
+            stateVecImag[index+keepOffset] *= renorm;
+            stateVecReal[index+zeroOffset] = 0;
+            stateVecImag[index+zeroOffset] = 0;
+        }
+    }
+}
 
+/** Measure the total probability of a specified qubit being in the zero state across all amplitudes in this chunk.
+ *  Size of regions to skip is less than the size of one chunk.
+ *
+ *  @param[in] qureg object representing the set of qubits
+ *  @param[in] measureQubit qubit to measure
+ *  @return probability of qubit measureQubit being zero
+ */
+qreal statevec_findProbabilityOfZeroLocal (Qureg qureg,
+        const int measureQubit)
+{
+    long long int numTasks=qureg.numAmpsPerChunk>>1;
+    qreal totalProbability = 0.0;
+
+    qreal *stateVecReal = qureg.stateVec.real;
+    qreal *stateVecImag = qureg.stateVec.imag;
+
+# ifdef _OPENMP
 # pragma omp parallel \
-    shared   (thisTask,stateVecReal,stateVecImag) \
-    private  (indexUp,indexLo, stateRealUp,stateImagUp)
+    shared    (numTasks, stateVecReal,stateVecImag) \
+    reduction ( +:totalProbability )
+# endif
     {
-# pragma omp for schedule (static)
-        for (indexUp = thisTask * sizeTask * 2; indexUp < thisTask * sizeTask * 2 + sizeTask; ++ indexUp) {
+        long long int startTask, endTask;
+        getThreadTaskRange(numTasks, &startTask, &endTask);
+        totalProbability += findProbabilityOfZeroInTasks(stateVecReal, stateVecImag, measureQubit, startTask, endTask);
+    }
+    return totalProbability;
+}
+
+/** Measure the probability of a specified qubit being in the zero state across all amplitudes held in this chunk.
+ * Size of regions to skip is a multiple of chunkSize.
+ * The results are communicated and aggregated by the caller
+ *
+ *  @param[in] qureg object representing the set of qubits
+ *  @return probability of qubit measureQubit being zero
+ */
+qreal statevec_findProbabilityOfZeroDistributed (Qureg qureg) {
+    // ----- measured probability
+    qreal   totalProbability;                                  // probability (returned) value
+    // ----- temp variables
+    long long int thisTask;                                   // task based approach for expose loop with small granularity
+    long long int numTasks=qureg.numAmpsPerChunk;
 
-            indexLo     = indexUp + sizeTask;
+    // ---------------------------------------------------------------- //
+    //            find probability                                      //
+    // ---------------------------------------------------------------- //
 
-            stateRealUp = stateVecReal[indexUp];
-            stateImagUp = stateVecImag[indexUp];
+    // initialise returned value
+    totalProbability = 0.0;
 
-            stateVecReal[indexUp] = stateVecReal[indexLo];
-            stateVecImag[indexUp] = stateVecImag[indexLo];
+    qreal *stateVecReal = qureg.stateVec.real;
+    qreal *stateVecImag = qureg.stateVec.imag;
 
-            stateVecReal[indexLo] = stateRealUp;
-            stateVecImag[indexLo] = stateImagUp;
+# ifdef _OPENMP
+# pragma omp parallel \
+    shared    (numTasks,stateVecReal,stateVecImag) \
+    private   (thisTask) \
+    reduction ( +:totalProbability )
+# endif
+    {
+# ifdef _OPENMP
+# pragma omp for schedule  (static)
+# endif
+        for (thisTask=0; thisTask<numTasks; thisTask++) {
+            totalProbability += stateVecReal[thisTask]*stateVecReal[thisTask]
+                + stateVecImag[thisTask]*stateVecImag[thisTask];
         }
     }
-    }
-# endif
+
+    return totalProbability;
 }
 
-void statevec_pauliXLocal(Qureg qureg, const int targetQubit)
-{
-    long long int sizeBlock, sizeHalfBlock;
-    long long int thisBlock, // current block
-         indexUp,indexLo;    // current index and corresponding index in lower half block
+/** Accumulate the reduced density matrix of a single qubit over the amplitude pairs held in 
+ * this chunk, i.e. the sums over the other qubits' states x of |psi_{x0}|^2, |psi_{x1}|^2 and 
+ * psi_{x0} conj(psi_{x1}). Both amplitudes of each pair must lie in this chunk.
+ * The results are aggregated over chunks by the caller.
+ *
+ *  @param[in] qureg object representing the set of qubits
+ *  @param[in] qubit qubit whose reduced state is sought
+ *  @param[out] sums {rho00, rho11, real(rho01), imag(rho01)} over this chunk
+ */
+void statevec_calcQubitDensityMatrixLocal(Qureg qureg, const int qubit, qreal sums[4]) {
 
-    qreal stateRealUp,stateImagUp;
-    long long int thisTask;
-    const long long int numTasks=qureg.numAmpsPerChunk>>1;
+    const long long int numTasks = qureg.numAmpsPerChunk >> 1;
+    const long long int qubitMask = 1LL << qubit;
 
-    // set dimensions
-    sizeHalfBlock = 1LL << targetQubit;
-    sizeBlock     = 2LL * sizeHalfBlock;
+    long long int thisTask, ind0, ind1;
+    qreal re0, im0, re1, im1;
+    qreal prob0=0, prob1=0, reCoh=0, imCoh=0;
 
-    // Can't use qureg.stateVec as a private OMP var
     qreal *stateVecReal = qureg.stateVec.real;
     qreal *stateVecImag = qureg.stateVec.imag;
 
 # ifdef _OPENMP
 # pragma omp parallel \
-    shared   (sizeBlock,sizeHalfBlock, stateVecReal,stateVecImag) \
-    private  (thisTask,thisBlock ,indexUp,indexLo, stateRealUp,stateImagUp)
+    shared    (stateVecReal,stateVecImag) \
+    private   (thisTask,ind0,ind1, re0,im0,re1,im1) \
+    reduction ( +:prob0,prob1,reCoh,imCoh )
 # endif
     {
 # ifdef _OPENMP
-# pragma omp for schedule (static)
+# pragma omp for schedule  (static)
 # endif
         for (thisTask=0; thisTask<numTasks; thisTask++) {
-            thisBlock   = thisTask / sizeHalfBlock;
-            indexUp     = thisBlock*sizeBlock + thisTask%sizeHalfBlock;
-            indexLo     = indexUp + sizeHalfBlock;
+            ind0 = insertZeroBit(thisTask, qubit);
+            ind1 = ind0 | qubitMask;
 
-            stateRealUp = stateVecReal[indexUp];
-            stateImagUp = stateVecImag[indexUp];
-
-            stateVecReal[indexUp] = stateVecReal[indexLo];
-            stateVecImag[indexUp] = stateVecImag[indexLo];
+            re0 = stateVecReal[ind0]; im0 = stateVecImag[ind0];
+            re1 = stateVecReal[ind1]; im1 = stateVecImag[ind1];
 
-            stateVecReal[indexLo] = stateRealUp;
-            stateVecImag[indexLo] = stateImagUp;
+            prob0 += re0*re0 + im0*im0;
+            prob1 += re1*re1 + im1*im1;
+            reCoh += re0*re1 + im0*im1;
+            imCoh += im0*re1 - re0*im1;
         }
     }
 
+    sums[0] = prob0;
+    sums[1] = prob1;
+    sums[2] = reCoh;
+    sums[3] = imCoh;
 }
 
-/** Rotate a single qubit by {{0,1},{1,0}.
- *  Operate on a subset of the state vector with upper and lower block values
- *  stored seperately. This rotation is just swapping upper and lower values, and
- *  stateVecIn must already be the correct section for this chunk
- *
- *  @remarks Qubits are zero-based and the
- *  the first qubit is the rightmost
+/** Accumulate the reduced density matrix of a single qubit, as per statevec_calcQubitDensityMatrixLocal,
+ * when each pair of amplitudes is split between this chunk and its pair chunk. 
+ * Only the chunk holding the qubit's zero states should call this, so that each pair is counted once.
  *
- *  @param[in,out] qureg object representing the set of qubits
- *  @param[in] stateVecIn probability amplitudes in lower or upper half of a block depending on chunkId
- *  @param[out] stateVecOut array section to update (will correspond to either the lower or upper half of a block)
+ *  @param[in] qureg object representing the set of qubits
+ *  @param[in] stateVecUp the chunk of amplitudes with the qubit in state 0
+ *  @param[in] stateVecLo the chunk of amplitudes with the qubit in state 1
+ *  @param[out] sums {rho00, rho11, real(rho01), imag(rho01)} over these chunks
  */
-void statevec_pauliXDistributed (Qureg qureg,
-        ComplexArray stateVecIn,
-        ComplexArray stateVecOut)
-{
+void statevec_calcQubitDensityMatrixDistributed(Qureg qureg, ComplexArray stateVecUp, ComplexArray stateVecLo, qreal sums[4]) {
+
+    const long long int numTasks = qureg.numAmpsPerChunk;
 
     long long int thisTask;
-    const long long int numTasks=qureg.numAmpsPerChunk;
+    qreal re0, im0, re1, im1;
+    qreal prob0=0, prob1=0, reCoh=0, imCoh=0;
 
-    qreal *stateVecRealIn=stateVecIn.real, *stateVecImagIn=stateVecIn.imag;
-    qreal *stateVecRealOut=stateVecOut.real, *stateVecImagOut=stateVecOut.imag;
+    qreal *stateVecRealUp = stateVecUp.real, *stateVecImagUp = stateVecUp.imag;
+    qreal *stateVecRealLo = stateVecLo.real, *stateVecImagLo = stateVecLo.imag;
 
 # ifdef _OPENMP
 # pragma omp parallel \
-    shared   (stateVecRealIn,stateVecImagIn,stateVecRealOut,stateVecImagOut) \
-    private  (thisTask)
+    shared    (stateVecRealUp,stateVecImagUp,stateVecRealLo,stateVecImagLo) \
+    private   (thisTask, re0,im0,re1,im1) \
+    reduction ( +:prob0,prob1,reCoh,imCoh )
 # endif
     {
 # ifdef _OPENMP
-# pragma omp for schedule (static)
+# pragma omp for schedule  (static)
 # endif
         for (thisTask=0; thisTask<numTasks; thisTask++) {
-            stateVecRealOut[thisTask] = stateVecRealIn[thisTask];
-            stateVecImagOut[thisTask] = stateVecImagIn[thisTask];
+            re0 = stateVecRealUp[thisTask]; im0 = stateVecImagUp[thisTask];
+            re1 = stateVecRealLo[thisTask]; im1 = stateVecImagLo[thisTask];
+
+            prob0 += re0*re0 + im0*im0;
+            prob1 += re1*re1 + im1*im1;
+            reCoh += re0*re1 + im0*im1;
+            imCoh += im0*re1 - re0*im1;
         }
     }
+
+    sums[0] = prob0;
+    sums[1] = prob1;
+    sums[2] = reCoh;
+    sums[3] = imCoh;
 }
-void statevec_controlledNotLocalAll(Qureg qureg, const int controlQubit, const int targetQubit)
-{
-    long long int sizeBlock, sizeHalfBlock;
-    long long int thisBlock, // current block
-         indexUp,indexLo;    // current index and corresponding index in lower half block
 
-    qreal stateRealUp,stateImagUp;
-    long long int thisTask;
-    const long long int numTasks=qureg.numAmpsPerChunk>>1;
-    
-    // set dimensions
-    sizeHalfBlock = 1LL << targetQubit;
-    sizeBlock     = 2LL * sizeHalfBlock;
+/** Populate offsets[a] with the index bits which set each kept qubit keepQubits[j] to bit j of a */
+static void getKeptQubitOffsets(int* keepQubits, int numKeep, long long int* offsets) {
+    long long int dim = 1LL << numKeep;
+    for (long long int a=0; a<dim; a++) {
+        offsets[a] = 0;
+        for (int j=0; j<numKeep; j++)
+            offsets[a] |= ((long long int) extractBit(j, a)) << keepQubits[j];
+    }
+}
+
+/** Complete a row-major Hermitian matrix of which only the upper triangle has been accumulated */
+static void fillLowerTriangleByConjugation(qreal* reSums, qreal* imSums, long long int dim) {
+    for (long long int a=0; a<dim; a++) {
+        imSums[a*dim + a] = 0;
+        for (long long int b=0; b<a; b++) {
+            reSums[a*dim + b] =   reSums[b*dim + a];
+            imSums[a*dim + b] = - imSums[b*dim + a];
+        }
+    }
+}
+
+/** Accumulate the reduced density matrix of the kept qubits over the amplitudes held in this chunk, 
+ * i.e. rho[a][b] = sum_e psi_{a,e} conj(psi_{b,e}) where a and b are the states of the kept qubits 
+ * (keepQubits[0] least significant) and e is the state of the traced-out qubits. The 2^numKeep 
+ * amplitudes sharing each e must lie in this chunk. Each thread accumulates the upper triangle 
+ * into a private buffer, so the state is streamed once without contention, and the buffers are 
+ * merged before the lower triangle is set by conjugation. The results are aggregated over chunks 
+ * by the caller.
+ *
+ *  @param[in] qureg object representing the set of qubits
+ *  @param[in] keepQubits qubits which are not traced out
+ *  @param[in] numKeep number of qubits in keepQubits
+ *  @param[out] reSums real components of the row-major 2^numKeep by 2^numKeep matrix over this chunk
+ *  @param[out] imSums imaginary components of the matrix over this chunk
+ */
+void statevec_calcReducedDensityMatrixLocal(Qureg qureg, int* keepQubits, int numKeep, qreal* reSums, qreal* imSums) {
+
+    const long long int numTasks = qureg.numAmpsPerChunk >> numKeep;
+    const long long int dim = 1LL << numKeep;
+    const long long int numElems = dim*dim;
+
+    long long int *offsets = malloc(dim * sizeof *offsets);
+    getKeptQubitOffsets(keepQubits, numKeep, offsets);
+
+    // the kept qubits are cleared from each task's index in increasing order
+    int sortedKeep[numKeep];
+    for (int j=0; j < numKeep; j++)
+        sortedKeep[j] = keepQubits[j];
+    qsort(sortedKeep, numKeep, sizeof(int), qsortComp);
+
+    long long int i;
+    for (i=0; i<numElems; i++) {
+        reSums[i] = 0;
+        imSums[i] = 0;
+    }
 
-    // Can't use qureg.stateVec as a private OMP var
     qreal *stateVecReal = qureg.stateVec.real;
     qreal *stateVecImag = qureg.stateVec.imag;
 
 # ifdef _OPENMP
 # pragma omp parallel \
-    shared   (sizeBlock,sizeHalfBlock, stateVecReal,stateVecImag) \
-    private  (thisTask,thisBlock ,indexUp,indexLo, stateRealUp,stateImagUp)
+    shared    (stateVecReal,stateVecImag, offsets,sortedKeep, reSums,imSums) \
+    private   (i)
 # endif
     {
+        long long int thisTask, ind00, a, b;
+        int j;
+        qreal *reAcc = calloc(2*numElems + 2*dim, sizeof *reAcc);
+        qreal *imAcc = &reAcc[numElems];
+        qreal *reAmps = &reAcc[2*numElems];
+        qreal *imAmps = &reAcc[2*numElems + dim];
+
 # ifdef _OPENMP
-# pragma omp for schedule (static)
+# pragma omp for schedule  (static)
 # endif
         for (thisTask=0; thisTask<numTasks; thisTask++) {
-            thisBlock   = thisTask / sizeHalfBlock;
-            indexUp     = thisBlock*sizeBlock + thisTask%sizeHalfBlock;
-            indexLo     = indexUp + sizeHalfBlock;
-            stateRealUp = stateVecReal[indexUp];
-            stateImagUp = stateVecImag[indexUp];
 
-            stateVecReal[indexUp] = stateVecReal[indexLo];
-            stateVecImag[indexUp] = stateVecImag[indexLo];
+            ind00 = thisTask;
+            for (j=0; j < numKeep; j++)
+                ind00 = insertZeroBit(ind00, sortedKeep[j]);
 
-            stateVecReal[indexLo] = stateRealUp;
-            stateVecImag[indexLo] = stateImagUp;
+            for (a=0; a<dim; a++) {
+                reAmps[a] = stateVecReal[ind00 | offsets[a]];
+                imAmps[a] = (stateVecImag)? stateVecImag[ind00 | offsets[a]] : 0; // absent for real registers
+            }
+
+            for (a=0; a<dim; a++)
+                for (b=a; b<dim; b++) {
+                    reAcc[a*dim + b] += reAmps[a]*reAmps[b] + imAmps[a]*imAmps[b];
+                    imAcc[a*dim + b] += imAmps[a]*reAmps[b] - reAmps[a]*imAmps[b];
+                }
         }
-    }
-}
-void statevec_controlledNotLocalSmall(Qureg qureg, const int controlQubit, const int targetQubit)
-{
-    long long int sizeBlock, sizeHalfBlock;
-    long long int thisBlock, // current block
-         indexUp,indexLo;    // current index and corresponding index in lower half block
 
-    qreal stateRealUp,stateImagUp;
-    if((1LL<<controlQubit)>=qureg.numAmpsPerChunk) {
-        if(extractBit(controlQubit,qureg.chunkId*qureg.numAmpsPerChunk)) {
-            statevec_controlledNotLocalAll(qureg,controlQubit,targetQubit);
+# ifdef _OPENMP
+# pragma omp critical
+# endif
+        {
+            for (i=0; i<numElems; i++) {
+                reSums[i] += reAcc[i];
+                imSums[i] += imAcc[i];
+            }
         }
-        return ;
+        free(reAcc);
     }
-    long long int thisTask;
-    const long long int numTasks = ((targetQubit > controlQubit) ? (1LL << (targetQubit - controlQubit - 1)) : (1LL << (controlQubit - targetQubit - 1)));
-    // const long long int chunkSize=qureg.numAmpsPerChunk;
-    // const long long int chunkId=qureg.chunkId;
-    const long long int numBlocks = ((targetQubit > controlQubit) ? (qureg.numAmpsPerChunk>>(1 + targetQubit)) : (qureg.numAmpsPerChunk>>(1 + controlQubit)));
-    const long long int sizeTask = ((targetQubit > controlQubit) ? (1LL << controlQubit) : (1LL << targetQubit));
-    const long long int blockOffset = 1LL << controlQubit;
 
-    sizeHalfBlock = 1LL << targetQubit;
-    sizeBlock     = ((targetQubit > controlQubit) ? (2LL * sizeHalfBlock) : (2LL << controlQubit));
+    fillLowerTriangleByConjugation(reSums, imSums, dim);
+    free(offsets);
+}
+
+/** Whether binning numTasks elements into numOutcomes bins should accumulate into per-thread
+ * copies of the bins (merged at the end) rather than atomically updating shared bins. 
+ * The copies are worthwhile unless their merging would outweigh the binning itself.
+ */
+static int isBinnedPerThread(long long int numOutcomes, long long int numTasks) {
+    int numThreads = 1;
+# ifdef _OPENMP
+    numThreads = omp_get_max_threads();
+# endif
+    return numOutcomes > 0 && numOutcomes * numThreads <= numTasks;
+}
 
+/** Gives the outcome of qubits (qubits[0] being least significant) encoded by ind */
+static long long int getOutcomeOfIndex(int* qubits, int numQubits, long long int ind) {
+    long long int outcomeInd = 0;
+    for (int q=0; q<numQubits; q++)
+        outcomeInd |= (long long int) extractBit(qubits[q], ind) << q;
+    return outcomeInd;
+}
+
+/** Accumulate the probability of every outcome of the given qubits over the amplitudes
+ * held in this chunk. The outcome of an amplitude is the bit-string formed by qubits
+ * (qubits[0] being least significant), so that a single pass over the chunk fills all
+ * 2^numQubits bins of outcomeProbs. The chunk is visited in blocks of OUTCOME_BLOCK_SIZE
+ * amplitudes, within which the outcome of the lower qubits is tabulated once, and that of 
+ * the upper qubits is fixed. Each thread bins into its own copy of outcomeProbs when 
+ * isBinnedPerThread, and otherwise (or if its copy cannot be allocated) atomically 
+ * updates outcomeProbs. The results are aggregated over chunks by the caller.
+ *
+ *  @param[out] outcomeProbs array of length 2^numQubits, overwritten with the chunk's sums
+ *  @param[in] qureg object representing the set of qubits
+ *  @param[in] qubits qubits whose outcomes are binned
+ *  @param[in] numQubits number of qubits in qubits
+ */
+void statevec_calcProbOfAllOutcomesLocal(qreal* outcomeProbs, Qureg qureg, int* qubits, int numQubits) {
+
+    long long int numOutcomes = 1LL << numQubits;
+    long long int numTasks = qureg.numAmpsPerChunk;
+    long long int offset = qureg.chunkId * qureg.numAmpsPerChunk;
+    int perThread = isBinnedPerThread(numOutcomes, numTasks);
+    long long int outcomeInd;
+
+    for (outcomeInd=0; outcomeInd<numOutcomes; outcomeInd++)
+        outcomeProbs[outcomeInd] = 0;
+
+    // the outcomes of the qubits within a block are the same for every block
+    long long int blockSize = (numTasks < OUTCOME_BLOCK_SIZE)? numTasks : OUTCOME_BLOCK_SIZE;
+    long long int numBlocks = numTasks / blockSize;
+    long long int blockOutcomes[blockSize];
+    int lowQubits[numQubits];
+    int highQubits[numQubits];
+    int numLow=0, numHigh=0;
+    for (int q=0; q<numQubits; q++) {
+        if ((1LL << qubits[q]) < blockSize)
+            lowQubits[numLow++] = q;
+        else
+            highQubits[numHigh++] = q;
+    }
+    for (long long int j=0; j<blockSize; j++) {
+        blockOutcomes[j] = 0;
+        for (int l=0; l<numLow; l++)
+            blockOutcomes[j] |= (long long int) extractBit(qubits[lowQubits[l]], j) << lowQubits[l];
+    }
 
-    // Can't use qureg.stateVec as a private OMP var
     qreal *stateVecReal = qureg.stateVec.real;
     qreal *stateVecImag = qureg.stateVec.imag;
 
 # ifdef _OPENMP
-    if(numBlocks >= omp_get_num_threads()) {
 # pragma omp parallel \
-    shared   (sizeBlock,sizeHalfBlock, stateVecReal,stateVecImag,blockOffset) \
-    private  (thisTask,thisBlock ,indexUp,indexLo, stateRealUp,stateImagUp)
+    shared    (numBlocks, blockSize, blockOutcomes, highQubits, numHigh, offset, qubits, \
+               stateVecReal, stateVecImag, outcomeProbs, perThread)
 # endif
     {
+        long long int thisBlock, blockStart, highOutcome, thisTask, binInd, j;
+        int h;
+        qreal prob;
+        qreal *bins = (perThread)? calloc(numOutcomes, sizeof *bins) : NULL;
+
 # ifdef _OPENMP
-# pragma omp for schedule (static)
+# pragma omp for schedule  (static)
 # endif
-        for (thisBlock = 0; thisBlock < numBlocks; ++thisBlock) {
-            for(thisTask = 0; thisTask < numTasks; ++thisTask) {
-                for(indexUp = thisBlock * sizeBlock + sizeTask * thisTask * 2 + blockOffset; indexUp < thisBlock * sizeBlock + sizeTask * thisTask * 2 + sizeTask + blockOffset; ++indexUp) {
-                    indexLo     = indexUp + sizeHalfBlock;
+        for (thisBlock=0; thisBlock<numBlocks; thisBlock++) {
+            blockStart = thisBlock*blockSize;
 
-                    stateRealUp = stateVecReal[indexUp];
-                    stateImagUp = stateVecImag[indexUp];
+            highOutcome = 0;
+            for (h=0; h<numHigh; h++)
+                highOutcome |= (long long int) extractBit(qubits[highQubits[h]], offset + blockStart) << highQubits[h];
 
-                    stateVecReal[indexUp] = stateVecReal[indexLo];
-                    stateVecImag[indexUp] = stateVecImag[indexLo];
+            for (j=0; j<blockSize; j++) {
+                thisTask = blockStart + j;
+                binInd = highOutcome | blockOutcomes[j];
+                prob = stateVecReal[thisTask]*stateVecReal[thisTask];
+                if (stateVecImag) // absent for real-amplitude registers
+                    prob += stateVecImag[thisTask]*stateVecImag[thisTask];
 
-                    stateVecReal[indexLo] = stateRealUp;
-                    stateVecImag[indexLo] = stateImagUp;
+                if (bins)
+                    bins[binInd] += prob;
+                else {
+# ifdef _OPENMP
+# pragma omp atomic update
+# endif
+                    outcomeProbs[binInd] += prob;
                 }
             }
         }
-    }
+
+        if (bins) {
 # ifdef _OPENMP
-    } else {
-        for (thisBlock = 0; thisBlock < numBlocks; ++thisBlock) {
-# pragma omp parallel \
-    shared   (thisBlock,sizeBlock,sizeHalfBlock, stateVecReal,stateVecImag,blockOffset) \
-    private  (thisTask ,indexUp,indexLo, stateRealUp,stateImagUp)
-    {
-# pragma omp for schedule (static)
-            for(thisTask = 0; thisTask < numTasks; ++thisTask) {
-                for(indexUp = thisBlock * sizeBlock + sizeTask * thisTask * 2 + blockOffset; indexUp < thisBlock * sizeBlock + sizeTask * thisTask * 2 + sizeTask + blockOffset; ++indexUp) {
-                    indexLo     = indexUp + sizeHalfBlock;
+# pragma omp critical
+# endif
+            {
+                for (binInd=0; binInd<numOutcomes; binInd++)
+                    outcomeProbs[binInd] += bins[binInd];
+            }
+            free(bins);
+        }
+    }
+}
 
-                    stateRealUp = stateVecReal[indexUp];
-                    stateImagUp = stateVecImag[indexUp];
+static long long int getNumSampleBlocks(Qureg qureg) {
+    return (qureg.numAmpsPerChunk < NUM_SAMPLE_BLOCKS)? qureg.numAmpsPerChunk : NUM_SAMPLE_BLOCKS;
+}
 
-                    stateVecReal[indexUp] = stateVecReal[indexLo];
-                    stateVecImag[indexUp] = stateVecImag[indexLo];
+/** Sum the probabilities of contiguous blocks of the amplitudes in this chunk, so that
+ * a sampled amplitude can later be located by scanning only a single block. 
+ * 
+ *  @param[in] qureg object representing the set of qubits
+ *  @param[out] blockProbs array of length NUM_SAMPLE_BLOCKS, populated with the probability of each block
+ *  @return the total probability of this chunk
+ */
+qreal statevec_calcProbOfBlocksLocal(Qureg qureg, qreal* blockProbs) {
 
-                    stateVecReal[indexLo] = stateRealUp;
-                    stateVecImag[indexLo] = stateImagUp;
-                }
+    long long int numBlocks = getNumSampleBlocks(qureg);
+    long long int blockSize = qureg.numAmpsPerChunk / numBlocks;
+    long long int thisBlock, index;
+    qreal blockProb;
+    qreal totalProb = 0;
+
+    qreal *stateVecReal = qureg.stateVec.real;
+    qreal *stateVecImag = qureg.stateVec.imag;
+
+# ifdef _OPENMP
+# pragma omp parallel \
+    shared    (numBlocks, blockSize, stateVecReal, stateVecImag, blockProbs) \
+    private   (thisBlock, index, blockProb) \
+    reduction ( +:totalProb )
+# endif
+    {
+# ifdef _OPENMP
+# pragma omp for schedule  (static)
+# endif
+        for (thisBlock=0; thisBlock<numBlocks; thisBlock++) {
+            blockProb = 0;
+            for (index=thisBlock*blockSize; index<(thisBlock+1)*blockSize; index++) {
+                blockProb += stateVecReal[index]*stateVecReal[index];
+                if (stateVecImag) // absent for real-amplitude registers
+                    blockProb += stateVecImag[index]*stateVecImag[index];
             }
+
+            blockProbs[thisBlock] = blockProb;
+            totalProb += blockProb;
         }
     }
-    }
-#endif
+
+    return totalProb;
 }
 
-void statevec_controlledNotLocal(Qureg qureg, const int controlQubit, const int targetQubit)
-{
-    long long int sizeBlock, sizeHalfBlock;
-    long long int thisBlock, // current block
-         indexUp,indexLo;    // current index and corresponding index in lower half block
+/** Find the first local amplitude at which the cumulative probability of this chunk 
+ * exceeds cumulProb, using the block sums of statevec_calcProbOfBlocksLocal so that 
+ * only one block of amplitudes is scanned. If rounding error means no amplitude 
+ * exceeds cumulProb, the last amplitude of non-zero probability is chosen.
+ *
+ *  @param[in] qureg object representing the set of qubits
+ *  @param[in] blockProbs block probabilities populated by statevec_calcProbOfBlocksLocal
+ *  @param[in] cumulProb cumulative probability to locate, relative to the start of this chunk
+ *  @param[out] ampProb the probability of the returned amplitude
+ *  @return the local index of the located amplitude
+ */
+long long int statevec_findCumulativeProbIndexLocal(Qureg qureg, qreal* blockProbs, qreal cumulProb, qreal* ampProb) {
 
-    qreal stateRealUp,stateImagUp;
-    long long int thisTask;
-    const long long int numTasks=qureg.numAmpsPerChunk>>1;
-    const long long int chunkSize=qureg.numAmpsPerChunk;
-    const long long int chunkId=qureg.chunkId;
+    long long int numBlocks = getNumSampleBlocks(qureg);
+    long long int blockSize = qureg.numAmpsPerChunk / numBlocks;
+
+    // choose the block containing cumulProb (or the last non-empty block)
+    long long int thisBlock, chosenBlock = 0;
+    for (thisBlock=0; thisBlock<numBlocks; thisBlock++) {
+        if (blockProbs[thisBlock] <= 0)
+            continue;
+        chosenBlock = thisBlock;
+        if (cumulProb < blockProbs[thisBlock])
+            break;
+        cumulProb -= blockProbs[thisBlock];
+    }
+
+    // scan the amplitudes of that block alone
+    qreal *stateVecReal = qureg.stateVec.real;
+    qreal *stateVecImag = qureg.stateVec.imag;
+    long long int index, chosenIndex = chosenBlock*blockSize;
+    qreal prob;
+    *ampProb = 0;
+    for (index=chosenBlock*blockSize; index<(chosenBlock+1)*blockSize; index++) {
+        prob = stateVecReal[index]*stateVecReal[index];
+        if (stateVecImag)
+            prob += stateVecImag[index]*stateVecImag[index];
+        if (prob <= 0)
+            continue;
+        chosenIndex = index;
+        *ampProb = prob;
+        if (cumulProb < prob)
+            break;
+        cumulProb -= prob;
+    }
+
+    return chosenIndex;
+}
 
-    int controlBit;
+/** Collapse the state-vector onto the classical state stateInd, retaining the phase
+ * of its amplitude but giving it unit magnitude. Every other amplitude is zeroed, so 
+ * this needs no communication and is a single pass over each chunk.
+ */
+void statevec_collapseToBasisState(Qureg qureg, long long int stateInd) {
 
-    // set dimensions
-    sizeHalfBlock = 1LL << targetQubit;
-    sizeBlock     = 2LL * sizeHalfBlock;
+    long long int stateVecSize = qureg.numAmpsPerChunk;
+    long long int index;
 
-    // Can't use qureg.stateVec as a private OMP var
     qreal *stateVecReal = qureg.stateVec.real;
     qreal *stateVecImag = qureg.stateVec.imag;
 
+    // retain the amplitude's phase (if it is held in this chunk)
+    qreal ampReal=0, ampImag=0, ampNorm;
+    int isLocal = (qureg.chunkId == stateInd/stateVecSize);
+    if (isLocal) {
+        ampReal = stateVecReal[stateInd % stateVecSize];
+        ampImag = (stateVecImag)? stateVecImag[stateInd % stateVecSize] : 0;
+        ampNorm = sqrt(ampReal*ampReal + ampImag*ampImag);
+        ampReal = (ampNorm > 0)? ampReal/ampNorm : 1;
+        ampImag = (ampNorm > 0)? ampImag/ampNorm : 0;
+    }
+
 # ifdef _OPENMP
 # pragma omp parallel \
-    shared   (sizeBlock,sizeHalfBlock, stateVecReal,stateVecImag) \
-    private  (thisTask,thisBlock ,indexUp,indexLo, stateRealUp,stateImagUp,controlBit)
+    shared   (stateVecSize, stateVecReal, stateVecImag) \
+    private  (index)
 # endif
     {
 # ifdef _OPENMP
 # pragma omp for schedule (static)
 # endif
-        for (thisTask=0; thisTask<numTasks; thisTask++) {
-            thisBlock   = thisTask / sizeHalfBlock;
-            indexUp     = thisBlock*sizeBlock + thisTask%sizeHalfBlock;
-            indexLo     = indexUp + sizeHalfBlock;
-
-            controlBit = extractBit(controlQubit, indexUp+chunkId*chunkSize);
-            if (controlBit){
-                stateRealUp = stateVecReal[indexUp];
-                stateImagUp = stateVecImag[indexUp];
-
-                stateVecReal[indexUp] = stateVecReal[indexLo];
-                stateVecImag[indexUp] = stateVecImag[indexLo];
-
-                stateVecReal[indexLo] = stateRealUp;
-                stateVecImag[indexLo] = stateImagUp;
-            }
+        for (index=0; index<stateVecSize; index++) {
+            stateVecReal[index] = 0.0;
+            if (stateVecImag) // absent for real-amplitude registers
+                stateVecImag[index] = 0.0;
         }
     }
+
+    if (isLocal) {
+        stateVecReal[stateInd % stateVecSize] = ampReal;
+        if (stateVecImag)
+            stateVecImag[stateInd % stateVecSize] = ampImag;
+    }
 }
 
-/** Rotate a single qubit by {{0,1},{1,0}.
- *  Operate on a subset of the state vector with upper and lower block values
- *  stored seperately. This rotation is just swapping upper and lower values, and
- *  stateVecIn must already be the correct section for this chunk. Only perform the rotation
- *  for elements where controlQubit is one.
+/** Collapse the state-vector to be consistent with measuring each of qubits in the 
+ * corresponding outcomes, zeroing every inconsistent amplitude and renormalising the 
+ * remainder in the same pass. Since each amplitude is processed independently using 
+ * its global index, this needs no communication in the distributed version.
  *
  *  @param[in,out] qureg object representing the set of qubits
- *  @param[in] stateVecIn probability amplitudes in lower or upper half of a block depending on chunkId
- *  @param[out] stateVecOut array section to update (will correspond to either the lower or upper half of a block)
+ *  @param[in] qubits qubits which were measured
+ *  @param[in] outcomes the outcome (0 or 1) of each qubit in qubits
+ *  @param[in] numQubits number of qubits in qubits
+ *  @param[in] outcomeProb the (non-zero) probability of the joint outcome
  */
-void statevec_controlledNotDistributed (Qureg qureg, const int controlQubit,
-        ComplexArray stateVecIn,
-        ComplexArray stateVecOut)
-{
+void statevec_collapseToOutcomes(Qureg qureg, int* qubits, int* outcomes, int numQubits, qreal outcomeProb) {
 
-    long long int thisTask;
-    const long long int numTasks=qureg.numAmpsPerChunk;
-    const long long int chunkSize=qureg.numAmpsPerChunk;
-    const long long int chunkId=qureg.chunkId;
+    long long int stateVecSize = qureg.numAmpsPerChunk;
+    long long int offset = qureg.chunkId * qureg.numAmpsPerChunk;
+    long long int index;
 
-    int controlBit;
+    // amplitudes are kept where the bits of qubitMask match outcomeMask
+    long long int qubitMask = 0;
+    long long int outcomeMask = 0;
+    for (int q=0; q<numQubits; q++) {
+        qubitMask |= 1LL << qubits[q];
+        if (outcomes[q])
+            outcomeMask |= 1LL << qubits[q];
+    }
 
-    qreal *stateVecRealIn=stateVecIn.real, *stateVecImagIn=stateVecIn.imag;
-    qreal *stateVecRealOut=stateVecOut.real, *stateVecImagOut=stateVecOut.imag;
+    qreal renorm = 1/sqrt(outcomeProb);
+    qreal *stateVecReal = qureg.stateVec.real;
+    qreal *stateVecImag = qureg.stateVec.imag;
 
 # ifdef _OPENMP
 # pragma omp parallel \
-    shared   (stateVecRealIn,stateVecImagIn,stateVecRealOut,stateVecImagOut) \
-    private  (thisTask,controlBit)
+    shared   (stateVecSize, offset, qubitMask, outcomeMask, renorm, stateVecReal, stateVecImag) \
+    private  (index)
 # endif
     {
 # ifdef _OPENMP
 # pragma omp for schedule (static)
 # endif
-        for (thisTask=0; thisTask<numTasks; thisTask++) {
-            controlBit = extractBit (controlQubit, thisTask+chunkId*chunkSize);
-            if (controlBit){
-                stateVecRealOut[thisTask] = stateVecRealIn[thisTask];
-                stateVecImagOut[thisTask] = stateVecImagIn[thisTask];
+        for (index=0; index<stateVecSize; index++) {
+            if (((index+offset) & qubitMask) == outcomeMask) {
+                stateVecReal[index] *= renorm;
+                if (stateVecImag) // absent for real-amplitude registers
+                    stateVecImag[index] *= renorm;
+            } else {
+                stateVecReal[index] = 0;
+                if (stateVecImag)
+                    stateVecImag[index] = 0;
             }
         }
     }
 }
 
-void statevec_pauliYLocalSmall(Qureg qureg, const int targetQubit, const int conjFac)
-{
-    long long int indexUp,indexLo;    // current index and corresponding index in lower half block
+/** Collapse the density matrix to be consistent with measuring each of qubits in the 
+ * corresponding outcomes. Elements are kept only where both their row and column 
+ * indices agree with the outcomes, and are renormalised in the same pass.
+ */
+void densmatr_collapseToOutcomes(Qureg qureg, int* qubits, int* outcomes, int numQubits, qreal outcomeProb) {
 
-    qreal stateRealUp,stateImagUp;
-    const long long int numTasks = (qureg.numAmpsPerChunk>>(1 + targetQubit)) ;
-    const long long int sizeTask = (1LL << targetQubit);
-    long long thisTask;
+    long long int stateVecSize = qureg.numAmpsPerChunk;
+    long long int offset = qureg.chunkId * qureg.numAmpsPerChunk;
+    long long int index;
+    int shift = qureg.numQubitsRepresented;
 
-    // Can't use qureg.stateVec as a private OMP var
+    // elements are kept where the row and column bits of qubitMask match outcomeMask
+    long long int qubitMask = 0;
+    long long int outcomeMask = 0;
+    for (int q=0; q<numQubits; q++) {
+        qubitMask |= (1LL << qubits[q]) | (1LL << (qubits[q] + shift));
+        if (outcomes[q])
+            outcomeMask |= (1LL << qubits[q]) | (1LL << (qubits[q] + shift));
+    }
+
+    qreal renorm = 1/outcomeProb;
     qreal *stateVecReal = qureg.stateVec.real;
     qreal *stateVecImag = qureg.stateVec.imag;
 
 # ifdef _OPENMP
 # pragma omp parallel \
-    shared   (stateVecReal,stateVecImag) \
-    private  (thisTask,indexUp,indexLo, stateRealUp,stateImagUp)
+    shared   (stateVecSize, offset, qubitMask, outcomeMask, renorm, stateVecReal, stateVecImag) \
+    private  (index)
 # endif
     {
 # ifdef _OPENMP
 # pragma omp for schedule (static)
 # endif
-        for (thisTask = 0; thisTask < numTasks; ++thisTask)
-        for (indexUp = thisTask * sizeTask * 2; indexUp < thisTask * sizeTask * 2 + sizeTask; ++ indexUp) {
-
-            indexLo     = indexUp + sizeTask;
-
-            stateRealUp = stateVecReal[indexUp];
-            stateImagUp = stateVecImag[indexUp];
-
-            stateVecReal[indexUp] = conjFac * stateVecImag[indexLo];
-            stateVecImag[indexUp] = conjFac * -stateVecReal[indexLo];
-            stateVecReal[indexLo] = conjFac * -stateImagUp;
-            stateVecImag[indexLo] = conjFac * stateRealUp;
+        for (index=0; index<stateVecSize; index++) {
+            if (((index+offset) & qubitMask) == outcomeMask) {
+                stateVecReal[index] *= renorm;
+                stateVecImag[index] *= renorm;
+            } else {
+                stateVecReal[index] = 0;
+                stateVecImag[index] = 0;
+            }
         }
     }
 }
 
-void statevec_pauliYLocal(Qureg qureg, const int targetQubit, const int conjFac)
-{
-    long long int sizeBlock, sizeHalfBlock;
-    long long int thisBlock, // current block
-         indexUp,indexLo;    // current index and corresponding index in lower half block
-
-    qreal stateRealUp,stateImagUp;
-    long long int thisTask;
-    const long long int numTasks=qureg.numAmpsPerChunk>>1;
-
-    // set dimensions
-    sizeHalfBlock = 1LL << targetQubit;
-    sizeBlock     = 2LL * sizeHalfBlock;
+/** Sum the probability of the amplitudes in this chunk consistent with measuring each of qubits in 
+ * the corresponding outcomes, as a single masked reduction. The amplitudes are visited in runs no 
+ * longer than 2^(the least of qubits), within which every masked bit is fixed, so that inconsistent 
+ * runs are skipped without being read. The results are aggregated over chunks by the caller.
+ */
+qreal statevec_calcProbOfOutcomesLocal(Qureg qureg, int* qubits, int* outcomes, int numQubits) {
 
-    // Can't use qureg.stateVec as a private OMP var
+    long long int stateVecSize = qureg.numAmpsPerChunk;
+    long long int offset = qureg.chunkId * qureg.numAmpsPerChunk;
+    long long int run, index;
+
+    long long int qubitMask = 0;
+    long long int outcomeMask = 0;
+    int minQubit = qubits[0];
+    for (int q=0; q<numQubits; q++) {
+        qubitMask |= 1LL << qubits[q];
+        if (outcomes[q])
+            outcomeMask |= 1LL << qubits[q];
+        if (qubits[q] < minQubit)
+            minQubit = qubits[q];
+    }
+
+    // runs are also capped so that there are enough of them to share between threads
+    long long int runSize = 1LL << minQubit;
+    if (runSize > OUTCOME_BLOCK_SIZE)
+        runSize = OUTCOME_BLOCK_SIZE;
+    if (runSize > stateVecSize)
+        runSize = stateVecSize;
+    long long int numRuns = stateVecSize / runSize;
+
+    qreal outcomeProb = 0;
     qreal *stateVecReal = qureg.stateVec.real;
     qreal *stateVecImag = qureg.stateVec.imag;
 
 # ifdef _OPENMP
 # pragma omp parallel \
-    shared   (sizeBlock,sizeHalfBlock, stateVecReal,stateVecImag) \
-    private  (thisTask,thisBlock ,indexUp,indexLo, stateRealUp,stateImagUp)
+    shared    (numRuns, runSize, offset, qubitMask, outcomeMask, stateVecReal, stateVecImag) \
+    private   (run, index) \
+    reduction ( +:outcomeProb )
 # endif
     {
 # ifdef _OPENMP
 # pragma omp for schedule (static)
 # endif
-        for (thisTask=0; thisTask<numTasks; thisTask++) {
-            thisBlock   = thisTask / sizeHalfBlock;
-            indexUp     = thisBlock*sizeBlock + thisTask%sizeHalfBlock;
-            indexLo     = indexUp + sizeHalfBlock;
-
-            stateRealUp = stateVecReal[indexUp];
-            stateImagUp = stateVecImag[indexUp];
+        for (run=0; run<numRuns; run++) {
+            if (((run*runSize + offset) & qubitMask) != outcomeMask)
+                continue;
 
-            stateVecReal[indexUp] = conjFac * stateVecImag[indexLo];
-            stateVecImag[indexUp] = conjFac * -stateVecReal[indexLo];
-            stateVecReal[indexLo] = conjFac * -stateImagUp;
-            stateVecImag[indexLo] = conjFac * stateRealUp;
+            for (index=run*runSize; index<(run+1)*runSize; index++) {
+                outcomeProb += stateVecReal[index]*stateVecReal[index];
+                if (stateVecImag) // absent for real-amplitude registers
+                    outcomeProb += stateVecImag[index]*stateVecImag[index];
+            }
         }
     }
+    return outcomeProb;
 }
 
-/** Rotate a single qubit by +-{{0,-i},{i,0}.
- *  Operate on a subset of the state vector with upper and lower block values
- *  stored seperately. This rotation is just swapping upper and lower values, and
- *  stateVecIn must already be the correct section for this chunk
- *
- *  @remarks Qubits are zero-based and the
- *  the first qubit is the rightmost
- *
- *  @param[in,out] qureg object representing the set of qubits
- *  @param[in] stateVecIn probability amplitudes in lower or upper half of a block depending on chunkId
- *  @param[in] updateUpper flag, 1: updating upper values, 0: updating lower values in block
- *  @param[out] stateVecOut array section to update (will correspond to either the lower or upper half of a block)
+/** Sum the diagonal elements in this chunk of a density matrix which are consistent with measuring 
+ * each of qubits in the corresponding outcomes, as a single masked reduction. The results are 
+ * aggregated over chunks by the caller.
  */
-void statevec_pauliYDistributed(Qureg qureg,
-        ComplexArray stateVecIn,
-        ComplexArray stateVecOut,
-        int updateUpper, const int conjFac)
-{
+qreal densmatr_calcProbOfOutcomesLocal(Qureg qureg, int* qubits, int* outcomes, int numQubits) {
 
-    long long int thisTask;
-    const long long int numTasks=qureg.numAmpsPerChunk;
+    // computes first local index containing a diagonal element
+    long long int localNumAmps = qureg.numAmpsPerChunk;
+    long long int densityDim = (1LL << qureg.numQubitsRepresented);
+    long long int diagSpacing = 1LL + densityDim;
+    long long int maxNumDiagsPerChunk = 1 + localNumAmps / diagSpacing;
+    long long int numPrevDiags = (qureg.chunkId>0)? 1+(qureg.chunkId*localNumAmps)/diagSpacing : 0;
+    long long int globalIndNextDiag = diagSpacing * numPrevDiags;
+    long long int localIndNextDiag = globalIndNextDiag % localNumAmps;
 
-    qreal *stateVecRealIn=stateVecIn.real, *stateVecImagIn=stateVecIn.imag;
-    qreal *stateVecRealOut=stateVecOut.real, *stateVecImagOut=stateVecOut.imag;
+    // computes how many diagonals are contained in this chunk
+    long long int numDiagsInThisChunk = maxNumDiagsPerChunk;
+    if (localIndNextDiag + (numDiagsInThisChunk-1)*diagSpacing >= localNumAmps)
+        numDiagsInThisChunk -= 1;
 
-    int realSign=1, imagSign=1;
-    if (updateUpper) imagSign=-1;
-    else realSign = -1;
+    long long int qubitMask = 0;
+    long long int outcomeMask = 0;
+    for (int q=0; q<numQubits; q++) {
+        qubitMask |= 1LL << qubits[q];
+        if (outcomes[q])
+            outcomeMask |= 1LL << qubits[q];
+    }
+
+    long long int visitedDiags;     // number of visited diagonals in this chunk so far
+    long long int basisStateInd;    // current diagonal index being considered
+    long long int index;            // index in the local chunk
+
+    qreal outcomeProb = 0;
+    qreal *stateVecReal = qureg.stateVec.real;
 
 # ifdef _OPENMP
 # pragma omp parallel \
-    shared   (stateVecRealIn,stateVecImagIn,stateVecRealOut,stateVecImagOut,realSign,imagSign) \
-    private  (thisTask)
+    shared    (localIndNextDiag, numPrevDiags, diagSpacing, stateVecReal, numDiagsInThisChunk, qubitMask, outcomeMask) \
+    private   (visitedDiags, basisStateInd, index) \
+    reduction ( +:outcomeProb )
 # endif
     {
 # ifdef _OPENMP
-# pragma omp for schedule (static)
+# pragma omp for schedule  (static)
 # endif
-        for (thisTask=0; thisTask<numTasks; thisTask++) {
-            stateVecRealOut[thisTask] = conjFac * realSign * stateVecImagIn[thisTask];
-            stateVecImagOut[thisTask] = conjFac * imagSign * stateVecRealIn[thisTask];
+        for (visitedDiags = 0; visitedDiags < numDiagsInThisChunk; visitedDiags++) {
+
+            basisStateInd = numPrevDiags + visitedDiags;
+            index = localIndNextDiag + diagSpacing * visitedDiags;
+
+            if ((basisStateInd & qubitMask) == outcomeMask)
+                outcomeProb += stateVecReal[index]; // assume imag[diagonls] ~ 0
         }
     }
+    return outcomeProb;
 }
-void statevec_controlledPauliYLocalAll(Qureg qureg, const int controlQubit, const int targetQubit, const int conjFac) {
-    long long int sizeBlock, sizeHalfBlock;
-    long long int thisBlock, // current block
-         indexUp,indexLo;    // current index and corresponding index in lower half block
 
-    qreal stateRealUp,stateImagUp;
-    long long int thisTask;
-    const long long int numTasks=qureg.numAmpsPerChunk>>1;
+void densmatr_calcProbOfAllOutcomesLocal(qreal* outcomeProbs, Qureg qureg, int* qubits, int numQubits) {
 
-    // set dimensions
-    sizeHalfBlock = 1LL << targetQubit;
-    sizeBlock     = 2LL * sizeHalfBlock;
+    // computes first local index containing a diagonal element
+    long long int localNumAmps = qureg.numAmpsPerChunk;
+    long long int densityDim = (1LL << qureg.numQubitsRepresented);
+    long long int diagSpacing = 1LL + densityDim;
+    long long int maxNumDiagsPerChunk = 1 + localNumAmps / diagSpacing;
+    long long int numPrevDiags = (qureg.chunkId>0)? 1+(qureg.chunkId*localNumAmps)/diagSpacing : 0;
+    long long int globalIndNextDiag = diagSpacing * numPrevDiags;
+    long long int localIndNextDiag = globalIndNextDiag % localNumAmps;
+
+    // computes how many diagonals are contained in this chunk
+    long long int numDiagsInThisChunk = maxNumDiagsPerChunk;
+    if (localIndNextDiag + (numDiagsInThisChunk-1)*diagSpacing >= localNumAmps)
+        numDiagsInThisChunk -= 1;
+
+    // bins privately per thread as per statevec_calcProbOfAllOutcomesLocal
+    long long int numOutcomes = 1LL << numQubits;
+    int perThread = isBinnedPerThread(numOutcomes, numDiagsInThisChunk);
+    long long int outcomeInd;
+
+    for (outcomeInd=0; outcomeInd<numOutcomes; outcomeInd++)
+        outcomeProbs[outcomeInd] = 0;
 
-    // Can't use qureg.stateVec as a private OMP var
     qreal *stateVecReal = qureg.stateVec.real;
-    qreal *stateVecImag = qureg.stateVec.imag;
 
 # ifdef _OPENMP
 # pragma omp parallel \
-    shared   (sizeBlock,sizeHalfBlock, stateVecReal,stateVecImag) \
-    private  (thisTask,thisBlock ,indexUp,indexLo, stateRealUp,stateImagUp)
+    shared    (localIndNextDiag, numPrevDiags, diagSpacing, stateVecReal, numDiagsInThisChunk, qubits, numQubits, outcomeProbs, perThread)
 # endif
     {
+        long long int visitedDiags;     // number of visited diagonals in this chunk so far
+        long long int basisStateInd;    // current diagonal index being considered
+        long long int index;            // index in the local chunk
+        long long int binInd;
+        qreal *bins = (perThread)? calloc(numOutcomes, sizeof *bins) : NULL;
+
 # ifdef _OPENMP
-# pragma omp for schedule (static)
+# pragma omp for schedule  (static)
 # endif
-        for (thisTask=0; thisTask<numTasks; thisTask++) {
-            thisBlock   = thisTask / sizeHalfBlock;
-            indexUp     = thisBlock*sizeBlock + thisTask%sizeHalfBlock;
-            indexLo     = indexUp + sizeHalfBlock;
+        // bins each diagonal elem of the density matrix by the outcome of qubits
+        for (visitedDiags = 0; visitedDiags < numDiagsInThisChunk; visitedDiags++) {
 
-                stateRealUp = stateVecReal[indexUp];
-                stateImagUp = stateVecImag[indexUp];
+            basisStateInd = numPrevDiags + visitedDiags;
+            index = localIndNextDiag + diagSpacing * visitedDiags;
 
-                // update under +-{{0, -i}, {i, 0}}
-                stateVecReal[indexUp] = conjFac * stateVecImag[indexLo];
-                stateVecImag[indexUp] = conjFac * -stateVecReal[indexLo];
-                stateVecReal[indexLo] = conjFac * -stateImagUp;
-                stateVecImag[indexLo] = conjFac * stateRealUp;
+            binInd = getOutcomeOfIndex(qubits, numQubits, basisStateInd);
+
+            if (bins)
+                bins[binInd] += stateVecReal[index]; // assume imag[diagonls] ~ 0
+            else {
+# ifdef _OPENMP
+# pragma omp atomic update
+# endif
+                outcomeProbs[binInd] += stateVecReal[index];
+            }
         }
-    }
-}
 
-void statevec_controlledPauliYLocalSmall(Qureg qureg, const int controlQubit, const int targetQubit, const int conjFac)
-{
-    if((1LL<<controlQubit)>=qureg.numAmpsPerChunk) {
-        if(extractBit(controlQubit,qureg.chunkId*qureg.numAmpsPerChunk)) {
-            statevec_controlledPauliYLocalAll(qureg, controlQubit, targetQubit, conjFac);
+        if (bins) {
+# ifdef _OPENMP
+# pragma omp critical
+# endif
+            {
+                for (binInd=0; binInd<numOutcomes; binInd++)
+                    outcomeProbs[binInd] += bins[binInd];
+            }
+            free(bins);
         }
-        return ;
     }
-    long long int sizeBlock, sizeHalfBlock;
-    long long int thisBlock, // current block
-         indexUp,indexLo;    // current index and corresponding index in lower half block
+}
+
+/** Accumulate the partial trace of a density matrix over all but the kept qubits, from the 
+ * columns held in this chunk, i.e. out[a][b] = sum_e rho[(a,e)][(b,e)] where a and b are the states 
+ * of the kept qubits (keepQubits[0] least significant) and e is the state of the traced-out qubits.
+ * Each visited column contributes to a single column b of the output, and only its upper triangle 
+ * is accumulated, into per-thread buffers as per statevec_calcReducedDensityMatrixLocal. 
+ * The results are aggregated over chunks by the caller.
+ *
+ *  @param[in] qureg object representing the density matrix
+ *  @param[in] keepQubits qubits which are not traced out
+ *  @param[in] numKeep number of qubits in keepQubits
+ *  @param[out] reSums real components of the row-major 2^numKeep by 2^numKeep matrix over this chunk
+ *  @param[out] imSums imaginary components of the matrix over this chunk
+ */
+void densmatr_calcReducedDensityMatrixLocal(Qureg qureg, int* keepQubits, int numKeep, qreal* reSums, qreal* imSums) {
 
-    qreal stateRealUp,stateImagUp;
-    long long int thisTask;
-    const long long int numTasks = ((targetQubit > controlQubit) ? (1LL << (targetQubit - controlQubit - 1)) : (1LL << (controlQubit - targetQubit - 1)));
-    // const long long int chunkSize=qureg.numAmpsPerChunk;
-    // const long long int chunkId=qureg.chunkId;
-    const long long int numBlocks = ((targetQubit > controlQubit) ? (qureg.numAmpsPerChunk>>(1 + targetQubit)) : (qureg.numAmpsPerChunk>>(1 + controlQubit)));
-    const long long int sizeTask = ((targetQubit > controlQubit) ? (1LL << controlQubit) : (1LL << targetQubit));
-    const long long int blockOffset = 1LL << controlQubit;
+    const int numQubits = qureg.numQubitsRepresented;
+    const long long int dim = 1LL << numKeep;
+    const long long int numElems = dim*dim;
 
-    // set dimensions
-    sizeHalfBlock = 1LL << targetQubit;
-    sizeBlock     = ((targetQubit > controlQubit) ? (2LL * sizeHalfBlock) : (2LL << controlQubit));
+    const long long int globalIndStart = qureg.chunkId*qureg.numAmpsPerChunk;
+    const long long int globalIndEnd = globalIndStart + qureg.numAmpsPerChunk;
+    const long long int colStart = globalIndStart >> numQubits;
+    const long long int colEnd = ((globalIndEnd - 1) >> numQubits) + 1;
 
+    long long int *offsets = malloc(dim * sizeof *offsets);
+    getKeptQubitOffsets(keepQubits, numKeep, offsets);
+    const long long int keepMask = getQubitBitMask(keepQubits, numKeep);
+
+    long long int i;
+    for (i=0; i<numElems; i++) {
+        reSums[i] = 0;
+        imSums[i] = 0;
+    }
 
-    // Can't use qureg.stateVec as a private OMP var
     qreal *stateVecReal = qureg.stateVec.real;
     qreal *stateVecImag = qureg.stateVec.imag;
 
 # ifdef _OPENMP
 # pragma omp parallel \
-    shared   (sizeBlock,sizeHalfBlock, stateVecReal,stateVecImag, blockOffset) \
-    private  (thisTask,thisBlock ,indexUp,indexLo, stateRealUp,stateImagUp)
+    shared    (stateVecReal,stateVecImag, offsets, reSums,imSums) \
+    private   (i)
 # endif
     {
+        long long int col, envRow, globalInd, a, b;
+        int j;
+        qreal *reAcc = calloc(2*numElems, sizeof *reAcc);
+        qreal *imAcc = &reAcc[numElems];
+
 # ifdef _OPENMP
-# pragma omp for schedule (static)
+# pragma omp for schedule  (static)
 # endif
-        for (thisBlock = 0; thisBlock < numBlocks; ++thisBlock) {
-            for(thisTask = 0; thisTask < numTasks; ++thisTask){
-                for(indexUp = thisBlock * sizeBlock + sizeTask * thisTask * 2 + blockOffset; indexUp < thisBlock * sizeBlock + sizeTask * thisTask * 2 + sizeTask + blockOffset; ++indexUp) {
-                    indexLo     = indexUp + sizeHalfBlock;
+        for (col=colStart; col<colEnd; col++) {
 
-                    stateRealUp = stateVecReal[indexUp];
-                    stateImagUp = stateVecImag[indexUp];
+            b = 0;
+            for (j=0; j < numKeep; j++)
+                b |= extractBit(keepQubits[j], col) << j;
+            envRow = col & ~keepMask;
 
-                    // update under +-{{0, -i}, {i, 0}}
-                    stateVecReal[indexUp] = conjFac * stateVecImag[indexLo];
-                    stateVecImag[indexUp] = conjFac * -stateVecReal[indexLo];
-                    stateVecReal[indexLo] = conjFac * -stateImagUp;
-                    stateVecImag[indexLo] = conjFac * stateRealUp;
-                }
+            for (a=0; a<=b; a++) {
+                globalInd = (envRow | offsets[a]) + (col << numQubits);
+                if (globalInd < globalIndStart || globalInd >= globalIndEnd)
+                    continue;
+
+                reAcc[a*dim + b] += stateVecReal[globalInd - globalIndStart];
+                imAcc[a*dim + b] += stateVecImag[globalInd - globalIndStart];
+            }
+        }
+
+# ifdef _OPENMP
+# pragma omp critical
+# endif
+        {
+            for (i=0; i<numElems; i++) {
+                reSums[i] += reAcc[i];
+                imSums[i] += imAcc[i];
             }
         }
+        free(reAcc);
     }
-}
 
+    fillLowerTriangleByConjugation(reSums, imSums, dim);
+    free(offsets);
+}
 
-void statevec_controlledPauliYLocal(Qureg qureg, const int controlQubit, const int targetQubit, const int conjFac)
-{
-    long long int sizeBlock, sizeHalfBlock;
-    long long int thisBlock, // current block
-         indexUp,indexLo;    // current index and corresponding index in lower half block
+/** As densmatr_calcReducedDensityMatrixLocal, but reading each rho[r][c] from packed storage */
+void packmatr_calcReducedDensityMatrixLocal(Qureg qureg, int* keepQubits, int numKeep, qreal* reSums, qreal* imSums) {
 
-    qreal stateRealUp,stateImagUp;
-    long long int thisTask;
-    const long long int numTasks=qureg.numAmpsPerChunk>>1;
-    const long long int chunkSize=qureg.numAmpsPerChunk;
-    const long long int chunkId=qureg.chunkId;
+    const long long int numCols = 1LL << qureg.numQubitsRepresented;
+    const long long int dim = 1LL << numKeep;
+    const long long int numElems = dim*dim;
 
-    int controlBit;
+    long long int *offsets = malloc(dim * sizeof *offsets);
+    getKeptQubitOffsets(keepQubits, numKeep, offsets);
+    const long long int keepMask = getQubitBitMask(keepQubits, numKeep);
 
-    // set dimensions
-    sizeHalfBlock = 1LL << targetQubit;
-    sizeBlock     = 2LL * sizeHalfBlock;
+    long long int i;
+    for (i=0; i<numElems; i++) {
+        reSums[i] = 0;
+        imSums[i] = 0;
+    }
 
-    // Can't use qureg.stateVec as a private OMP var
-    qreal *stateVecReal = qureg.stateVec.real;
-    qreal *stateVecImag = qureg.stateVec.imag;
+    qreal *reVec = qureg.stateVec.real;
+    qreal *imVec = qureg.stateVec.imag;
 
 # ifdef _OPENMP
 # pragma omp parallel \
-    shared   (sizeBlock,sizeHalfBlock, stateVecReal,stateVecImag) \
-    private  (thisTask,thisBlock ,indexUp,indexLo, stateRealUp,stateImagUp,controlBit)
+    shared    (reVec,imVec, offsets, reSums,imSums) \
+    private   (i)
 # endif
     {
+        long long int col, envRow, a, b;
+        int j;
+        qreal re, im;
+        qreal *reAcc = calloc(2*numElems, sizeof *reAcc);
+        qreal *imAcc = &reAcc[numElems];
+
 # ifdef _OPENMP
-# pragma omp for schedule (static)
+# pragma omp for schedule  (static)
 # endif
-        for (thisTask=0; thisTask<numTasks; thisTask++) {
-            thisBlock   = thisTask / sizeHalfBlock;
-            indexUp     = thisBlock*sizeBlock + thisTask%sizeHalfBlock;
-            indexLo     = indexUp + sizeHalfBlock;
+        for (col=0; col<numCols; col++) {
 
-            controlBit = extractBit(controlQubit, indexUp+chunkId*chunkSize);
-            if (controlBit){
-                stateRealUp = stateVecReal[indexUp];
-                stateImagUp = stateVecImag[indexUp];
+            b = 0;
+            for (j=0; j < numKeep; j++)
+                b |= extractBit(keepQubits[j], col) << j;
+            envRow = col & ~keepMask;
 
-                // update under +-{{0, -i}, {i, 0}}
-                stateVecReal[indexUp] = conjFac * stateVecImag[indexLo];
-                stateVecImag[indexUp] = conjFac * -stateVecReal[indexLo];
-                stateVecReal[indexLo] = conjFac * -stateImagUp;
-                stateVecImag[indexLo] = conjFac * stateRealUp;
+            for (a=0; a<=b; a++) {
+                getPackedElem(reVec, imVec, envRow | offsets[a], col, &re, &im);
+                reAcc[a*dim + b] += re;
+                imAcc[a*dim + b] += im;
             }
         }
+
+# ifdef _OPENMP
+# pragma omp critical
+# endif
+        {
+            for (i=0; i<numElems; i++) {
+                reSums[i] += reAcc[i];
+                imSums[i] += imAcc[i];
+            }
+        }
+        free(reAcc);
     }
+
+    fillLowerTriangleByConjugation(reSums, imSums, dim);
+    free(offsets);
 }
 
 
-void statevec_controlledPauliYDistributed (Qureg qureg, const int controlQubit,
-        ComplexArray stateVecIn,
-        ComplexArray stateVecOut, const int conjFac)
+
+void statevec_controlledPhaseFlip (Qureg qureg, const int idQubit1, const int idQubit2)
 {
+    long long int index;
+    long long int stateVecSize;
+    int bit1, bit2;
 
-    long long int thisTask;
-    const long long int numTasks=qureg.numAmpsPerChunk;
     const long long int chunkSize=qureg.numAmpsPerChunk;
     const long long int chunkId=qureg.chunkId;
 
-    int controlBit;
+    // dimension of the state vector
+    stateVecSize = qureg.numAmpsPerChunk;
+    qreal *stateVecReal = qureg.stateVec.real;
+    qreal *stateVecImag = qureg.stateVec.imag;
 
-    qreal *stateVecRealIn=stateVecIn.real, *stateVecImagIn=stateVecIn.imag;
-    qreal *stateVecRealOut=stateVecOut.real, *stateVecImagOut=stateVecOut.imag;
+# ifdef _OPENMP
+# pragma omp parallel for \
+    shared   (stateVecSize, stateVecReal,stateVecImag ) \
+    private  (index,bit1,bit2)             \
+    schedule (static)
+# endif
+    for (index=0; index<stateVecSize; index++) {
+        bit1 = extractBit (idQubit1, index+chunkId*chunkSize);
+        bit2 = extractBit (idQubit2, index+chunkId*chunkSize);
+        if (bit1 && bit2) {
+            stateVecReal [index] = - stateVecReal [index];
+            if (stateVecImag) // absent for real-amplitude registers
+                stateVecImag [index] = - stateVecImag [index];
+        }
+    }
+}
+
+void statevec_multiControlledPhaseFlip(Qureg qureg, int *controlQubits, int numControlQubits)
+{
+    long long int index;
+    long long int stateVecSize;
+
+    const long long int chunkSize=qureg.numAmpsPerChunk;
+    const long long int chunkId=qureg.chunkId;
+
+    long long int mask = getQubitBitMask(controlQubits, numControlQubits);
+
+    stateVecSize = qureg.numAmpsPerChunk;
+    qreal *stateVecReal = qureg.stateVec.real;
+    qreal *stateVecImag = qureg.stateVec.imag;
 
 # ifdef _OPENMP
 # pragma omp parallel \
-    shared   (stateVecRealIn,stateVecImagIn,stateVecRealOut,stateVecImagOut) \
-    private  (thisTask,controlBit)
+    shared   (stateVecSize, stateVecReal,stateVecImag, mask ) \
+    private  (index)
 # endif
     {
 # ifdef _OPENMP
 # pragma omp for schedule (static)
 # endif
-        for (thisTask=0; thisTask<numTasks; thisTask++) {
-            controlBit = extractBit (controlQubit, thisTask+chunkId*chunkSize);
-            if (controlBit){
-                stateVecRealOut[thisTask] = conjFac * stateVecImagIn[thisTask];
-                stateVecImagOut[thisTask] = conjFac * -stateVecRealIn[thisTask];
+        for (index=0; index<stateVecSize; index++) {
+            if (mask == (mask & (index+chunkId*chunkSize)) ){
+                stateVecReal [index] = - stateVecReal [index];
+                stateVecImag [index] = - stateVecImag [index];
             }
         }
     }
 }
 
-void statevec_hadamardLocalSmall(Qureg qureg, const int targetQubit)
+/** Update the state vector to be consistent with measuring measureQubit=0 if outcome=0 and measureQubit=1
+ *  if outcome=1.
+ *  Performs an irreversible change to the state vector: it updates the vector according
+ *  to the event that an outcome have been measured on the qubit indicated by measureQubit (where
+ *  this label starts from 0, of course). It achieves this by setting all inconsistent
+ *  amplitudes to 0 and
+ *  then renormalising based on the total probability of measuring measureQubit=0 or 1 according to the
+ *  value of outcome.
+ *  In the local version, one or more blocks (with measureQubit=0 in the first half of the block and
+ *  measureQubit=1 in the second half of the block) fit entirely into one chunk.
+ *
+ *  @param[in,out] qureg object representing the set of qubits
+ *  @param[in] measureQubit qubit to measure
+ *  @param[in] totalProbability probability of qubit measureQubit being either zero or one
+ *  @param[in] outcome to measure the probability of and set the state to -- either zero or one
+ */
+void statevec_collapseToKnownProbOutcomeLocal(Qureg qureg, int measureQubit, int outcome, qreal totalProbability)
 {
-    long long int indexUp,indexLo;    // current index and corresponding index in lower half block
+    long long int numTasks=qureg.numAmpsPerChunk>>1;
+    qreal renorm=1/sqrt(totalProbability);
 
-    qreal stateRealUp,stateRealLo,stateImagUp,stateImagLo;
-    const long long int sizeTask = (1LL << targetQubit);
-    if(sizeTask >= 4){
-        statevec_hadamardLocalSIMD(qureg,targetQubit);
-        //printf("simd");
-        return;
+    qreal *stateVecReal = qureg.stateVec.real;
+    qreal *stateVecImag = qureg.stateVec.imag;
+
+# ifdef _OPENMP
+# pragma omp parallel \
+    shared    (numTasks, stateVecReal,stateVecImag, renorm,outcome)
+# endif
+    {
+        long long int startTask, endTask;
+        getThreadTaskRange(numTasks, &startTask, &endTask);
+        collapseToOutcomeInTasks(stateVecReal, stateVecImag, measureQubit, outcome, renorm, startTask, endTask);
     }
+}
 
-    const long long int numTasks = (qureg.numAmpsPerChunk>>(1 + targetQubit)) ;
-    long long thisTask;
+/** Measure measureQubit, randomly choosing its outcome and collapsing the state-vector to it, in a 
+ * single parallel region. Each thread sums the probability of the amplitudes it then collapses, so 
+ * when a thread's share of the chunk fits in cache, the collapse reuses the amplitudes loaded for 
+ * the probability. The per-thread sums are added in thread order, so the outcome is reproducible.
+ * Only valid when every block (of both outcomes of measureQubit) fits in the chunk.
+ *
+ *  @param[in,out] qureg object representing the set of qubits
+ *  @param[in] measureQubit qubit to measure
+ *  @param[out] outcomeProb probability of the chosen outcome
+ *  @return the chosen outcome
+ */
+int statevec_measureWithStatsLocal(Qureg qureg, int measureQubit, qreal *outcomeProb)
+{
+    long long int numTasks=qureg.numAmpsPerChunk>>1;
+    int outcome = 0;
+    qreal renorm = 0;
+
+    int numThreads = 1;
+# ifdef _OPENMP
+    numThreads = omp_get_max_threads();
+# endif
+    qreal threadZeroProbs[numThreads];
 
-    // Can't use qureg.stateVec as a private OMP var
     qreal *stateVecReal = qureg.stateVec.real;
     qreal *stateVecImag = qureg.stateVec.imag;
 
-    qreal recRoot2 = 1.0/sqrt(2);
-
 # ifdef _OPENMP
 # pragma omp parallel \
-    shared   (stateVecReal,stateVecImag, recRoot2) \
-    private  (thisTask,indexUp,indexLo, stateRealUp,stateImagUp,stateRealLo,stateImagLo)
+    shared    (numTasks, stateVecReal,stateVecImag, threadZeroProbs, outcome,renorm,outcomeProb)
 # endif
     {
+        long long int startTask, endTask;
+        int thread = 0, numTeamThreads = 1;
 # ifdef _OPENMP
-# pragma omp for schedule (static)
+        thread = omp_get_thread_num();
+        numTeamThreads = omp_get_num_threads();
 # endif
-        for (thisTask = 0; thisTask < numTasks; ++thisTask)
-        for (indexUp = thisTask * sizeTask * 2; indexUp < thisTask * sizeTask * 2 + sizeTask; ++ indexUp) {
+        getThreadTaskRange(numTasks, &startTask, &endTask);
+        threadZeroProbs[thread] = findProbabilityOfZeroInTasks(
+            stateVecReal, stateVecImag, measureQubit, startTask, endTask);
 
-            indexLo     = indexUp + sizeTask;
+# ifdef _OPENMP
+# pragma omp barrier
+# pragma omp single
+# endif
+        {
+            qreal zeroProb = 0;
+            for (int t=0; t<numTeamThreads; t++)
+                zeroProb += threadZeroProbs[t];
+            outcome = generateMeasurementOutcome(zeroProb, outcomeProb);
+            renorm = 1/sqrt(*outcomeProb);
+        }
 
-            stateRealUp = stateVecReal[indexUp];
-            stateImagUp = stateVecImag[indexUp];
+        collapseToOutcomeInTasks(stateVecReal, stateVecImag, measureQubit, outcome, renorm, startTask, endTask);
+    }
+    return outcome;
+}
 
-            stateRealLo = stateVecReal[indexLo];
-            stateImagLo = stateVecImag[indexLo];
+/** Renormalise parts of the state vector where measureQubit=0 or 1, based on the total probability of that qubit being
+ *  in state 0 or 1.
+ *  Measure in Zero performs an irreversible change to the state vector: it updates the vector according
+ *  to the event that the value 'outcome' has been measured on the qubit indicated by measureQubit (where
+ *  this label starts from 0, of course). It achieves this by setting all inconsistent amplitudes to 0 and
+ *  then renormalising based on the total probability of measuring measureQubit=0 if outcome=0 and
+ *  measureQubit=1 if outcome=1.
+ *  In the distributed version, one block (with measureQubit=0 in the first half of the block and
+ *  measureQubit=1 in the second half of the block) is spread over multiple chunks, meaning that each chunks performs
+ *  only renormalisation or only setting amplitudes to 0. This function handles the renormalisation.
+ *
+ *  @param[in,out] qureg object representing the set of qubits
+ *  @param[in] measureQubit qubit to measure
+ *  @param[in] totalProbability probability of qubit measureQubit being zero
+ */
+void statevec_collapseToKnownProbOutcomeDistributedRenorm (Qureg qureg, const int measureQubit, const qreal totalProbability)
+{
+    // ----- temp variables
+    long long int thisTask;
+    long long int numTasks=qureg.numAmpsPerChunk;
 
-            stateVecReal[indexUp] = recRoot2*(stateRealUp + stateRealLo);
-            stateVecImag[indexUp] = recRoot2*(stateImagUp + stateImagLo);
+    qreal renorm=1/sqrt(totalProbability);
 
-            stateVecReal[indexLo] = recRoot2*(stateRealUp - stateRealLo);
-            stateVecImag[indexLo] = recRoot2*(stateImagUp - stateImagLo);
+    qreal *stateVecReal = qureg.stateVec.real;
+    qreal *stateVecImag = qureg.stateVec.imag;
+
+# ifdef _OPENMP
+# pragma omp parallel \
+    shared    (numTasks,stateVecReal,stateVecImag) \
+    private   (thisTask)
+# endif
+    {
+# ifdef _OPENMP
+# pragma omp for schedule  (static)
+# endif
+        for (thisTask=0; thisTask<numTasks; thisTask++) {
+            stateVecReal[thisTask] = stateVecReal[thisTask]*renorm;
+            stateVecImag[thisTask] = stateVecImag[thisTask]*renorm;
         }
     }
 }
 
-void statevec_hadamardLocalSIMD(Qureg qureg, const int targetQubit)
+/** Set all amplitudes in one chunk to 0.
+ *  Measure in Zero performs an irreversible change to the state vector: it updates the vector according
+ *  to the event that a zero have been measured on the qubit indicated by measureQubit (where
+ *  this label starts from 0, of course). It achieves this by setting all inconsistent amplitudes to 0 and
+ *  then renormalising based on the total probability of measuring measureQubit=0 or 1.
+ *  In the distributed version, one block (with measureQubit=0 in the first half of the block and
+ *  measureQubit=1 in the second half of the block) is spread over multiple chunks, meaning that each chunks performs
+ *  only renormalisation or only setting amplitudes to 0. This function handles setting amplitudes to 0.
+ *
+ *  @param[in,out] qureg object representing the set of qubits
+ *  @param[in] measureQubit qubit to measure
+ */
+void statevec_collapseToOutcomeDistributedSetZero(Qureg qureg)
 {
-    long long int indexUp,indexLo;    // current index and corresponding index in lower half block
+    // ----- temp variables
+    long long int thisTask;
+    long long int numTasks=qureg.numAmpsPerChunk;
 
-    __m256d stateRealUpSIMD,stateRealLoSIMD,stateImagUpSIMD,stateImagLoSIMD;
-    const long long int numTasks = (qureg.numAmpsPerChunk>>(1 + targetQubit)) ;
-    const long long int sizeTask = (1LL << targetQubit);
-    long long thisTask;
+    // ---------------------------------------------------------------- //
+    //            find probability                                      //
+    // ---------------------------------------------------------------- //
 
-    // Can't use qureg.stateVec as a private OMP var
     qreal *stateVecReal = qureg.stateVec.real;
     qreal *stateVecImag = qureg.stateVec.imag;
 
-    qreal recRoot2 = 1.0/sqrt(2);
-    register const __m256d recRoot2SIMD = _mm256_set1_pd(recRoot2);
-
 # ifdef _OPENMP
-    if(numTasks >= omp_get_num_threads()){
 # pragma omp parallel \
-    shared   (stateVecReal,stateVecImag, recRoot2SIMD) \
-    private  (thisTask,indexUp,indexLo, stateRealUpSIMD,stateImagUpSIMD,stateRealLoSIMD,stateImagLoSIMD)
+    shared    (numTasks,stateVecReal,stateVecImag) \
+    private   (thisTask)
 # endif
     {
 # ifdef _OPENMP
-# pragma omp for schedule (static)
+# pragma omp for schedule  (static)
 # endif
-        for (thisTask = 0; thisTask < numTasks; ++thisTask)
-        for (indexUp = thisTask * sizeTask * 2; indexUp < thisTask * sizeTask * 2 + sizeTask; indexUp+=4) {
-
-            indexLo     = indexUp + sizeTask;
-
-            stateRealUpSIMD = _mm256_loadu_pd(stateVecReal+indexUp);
-            stateImagUpSIMD = _mm256_loadu_pd(stateVecImag+indexUp);
-            stateRealLoSIMD = _mm256_loadu_pd(stateVecReal+indexLo);
-            stateImagLoSIMD = _mm256_loadu_pd(stateVecImag+indexLo);
-
-            _mm256_storeu_pd(stateVecReal+indexUp, _mm256_mul_pd(recRoot2SIMD,_mm256_add_pd(stateRealUpSIMD, stateRealLoSIMD)));
-            _mm256_storeu_pd(stateVecImag+indexUp, _mm256_mul_pd(recRoot2SIMD,_mm256_add_pd(stateImagUpSIMD, stateImagLoSIMD)));
-            _mm256_storeu_pd(stateVecReal+indexLo, _mm256_mul_pd(recRoot2SIMD,_mm256_sub_pd(stateRealUpSIMD, stateRealLoSIMD)));
-            _mm256_storeu_pd(stateVecImag+indexLo, _mm256_mul_pd(recRoot2SIMD,_mm256_sub_pd(stateImagUpSIMD, stateImagLoSIMD)));
-        }
-    }
-    
-# ifdef _OPENMP
-    } else {
-        for (thisTask = 0; thisTask < numTasks; ++thisTask)
-# pragma omp parallel \
-    shared   (thisTask,stateVecReal,stateVecImag, recRoot2SIMD) \
-    private  (indexUp,indexLo, stateRealUpSIMD,stateImagUpSIMD,stateRealLoSIMD,stateImagLoSIMD)
-    {
-# pragma omp for schedule (static)
-        for (indexUp = thisTask * sizeTask * 2; indexUp < thisTask * sizeTask * 2 + sizeTask; indexUp+=4) {
-
-            indexLo     = indexUp + sizeTask;
-
-            stateRealUpSIMD = _mm256_loadu_pd(stateVecReal+indexUp);
-            stateImagUpSIMD = _mm256_loadu_pd(stateVecImag+indexUp);
-            stateRealLoSIMD = _mm256_loadu_pd(stateVecReal+indexLo);
-            stateImagLoSIMD = _mm256_loadu_pd(stateVecImag+indexLo);
-
-            _mm256_storeu_pd(stateVecReal+indexUp, _mm256_mul_pd(recRoot2SIMD,_mm256_add_pd(stateRealUpSIMD, stateRealLoSIMD)));
-            _mm256_storeu_pd(stateVecImag+indexUp, _mm256_mul_pd(recRoot2SIMD,_mm256_add_pd(stateImagUpSIMD, stateImagLoSIMD)));
-            _mm256_storeu_pd(stateVecReal+indexLo, _mm256_mul_pd(recRoot2SIMD,_mm256_sub_pd(stateRealUpSIMD, stateRealLoSIMD)));
-            _mm256_storeu_pd(stateVecImag+indexLo, _mm256_mul_pd(recRoot2SIMD,_mm256_sub_pd(stateImagUpSIMD, stateImagLoSIMD)));
+        for (thisTask=0; thisTask<numTasks; thisTask++) {
+            stateVecReal[thisTask] = 0;
+            stateVecImag[thisTask] = 0;
         }
     }
-    }
-# endif
-
 }
 
-void statevec_hadamardLocal(Qureg qureg, const int targetQubit)
-{
-    long long int sizeBlock, sizeHalfBlock;
-    long long int thisBlock, // current block
-         indexUp,indexLo;    // current index and corresponding index in lower half block
-
-    qreal stateRealUp,stateRealLo,stateImagUp,stateImagLo;
-    long long int thisTask;
-    const long long int numTasks=qureg.numAmpsPerChunk>>1;
-
-    // set dimensions
-    sizeHalfBlock = 1LL << targetQubit;
-    sizeBlock     = 2LL * sizeHalfBlock;
+/** It is ensured that all amplitudes needing to be swapped are on this node.
+ * This means that amplitudes for |a 0..0..> to |a 1..1..> all exist on this node
+ * and each node has a different bit-string prefix "a". The prefix 'a' (and ergo,
+ * the chunkID) don't enter the calculations for the offset of |a 0..1..> and
+ * |a 1..0..> from |a 0..0..> and ergo are not featured below.
+ */
+void statevec_swapQubitAmpsLocal(Qureg qureg, int qb1, int qb2) {
 
-    // Can't use qureg.stateVec as a private OMP var
-    qreal *stateVecReal = qureg.stateVec.real;
-    qreal *stateVecImag = qureg.stateVec.imag;
+    // can't use qureg.stateVec as a private OMP var
+    qreal *reVec = qureg.stateVec.real;
+    qreal *imVec = qureg.stateVec.imag;
 
-    qreal recRoot2 = 1.0/sqrt(2);
+    long long int numTasks = qureg.numAmpsPerChunk >> 2; // each iteration updates 2 amps and skips 2 amps
+    long long int thisTask;
+    long long int ind00, ind01, ind10;
+    qreal re01, re10;
+    qreal im01, im10;
 
 # ifdef _OPENMP
 # pragma omp parallel \
-    shared   (sizeBlock,sizeHalfBlock, stateVecReal,stateVecImag, recRoot2) \
-    private  (thisTask,thisBlock ,indexUp,indexLo, stateRealUp,stateImagUp,stateRealLo,stateImagLo)
+    shared   (reVec,imVec,numTasks,qb1,qb2) \
+    private  (thisTask, ind00,ind01,ind10, re01,re10, im01,im10)
 # endif
     {
 # ifdef _OPENMP
 # pragma omp for schedule (static)
 # endif
         for (thisTask=0; thisTask<numTasks; thisTask++) {
-            thisBlock   = thisTask / sizeHalfBlock;
-            indexUp     = thisBlock*sizeBlock + thisTask%sizeHalfBlock;
-            indexLo     = indexUp + sizeHalfBlock;
-
-            stateRealUp = stateVecReal[indexUp];
-            stateImagUp = stateVecImag[indexUp];
-
-            stateRealLo = stateVecReal[indexLo];
-            stateImagLo = stateVecImag[indexLo];
+            // determine ind00 of |..0..0..>, |..0..1..> and |..1..0..>
+            ind00 = insertTwoZeroBits(thisTask, qb1, qb2);
+            ind01 = flipBit(ind00, qb1);
+            ind10 = flipBit(ind00, qb2);
 
-            stateVecReal[indexUp] = recRoot2*(stateRealUp + stateRealLo);
-            stateVecImag[indexUp] = recRoot2*(stateImagUp + stateImagLo);
+            // extract statevec amplitudes
+            re01 = reVec[ind01]; im01 = imVec[ind01];
+            re10 = reVec[ind10]; im10 = imVec[ind10];
 
-            stateVecReal[indexLo] = recRoot2*(stateRealUp - stateRealLo);
-            stateVecImag[indexLo] = recRoot2*(stateImagUp - stateImagLo);
+            // swap 01 and 10 amps
+            reVec[ind01] = re10; reVec[ind10] = re01;
+            imVec[ind01] = im10; imVec[ind10] = im01;
         }
     }
 }
 
-/** Rotate a single qubit by {{1,1},{1,-1}}/sqrt2.
- *  Operate on a subset of the state vector with upper and lower block values
- *  stored seperately. This rotation is just swapping upper and lower values, and
- *  stateVecIn must already be the correct section for this chunk
- *
- *  @param[in,out] qureg object representing the set of qubits
- *  @param[in] stateVecIn probability amplitudes in lower or upper half of a block depending on chunkId
- *  @param[in] updateUpper flag, 1: updating upper values, 0: updating lower values in block
- *  @param[out] stateVecOut array section to update (will correspond to either the lower or upper half of a block)
+/** qureg.pairStateVec contains the entire set of amplitudes of the paired node
+ * which includes the set of all amplitudes which need to be swapped between
+ * |..0..1..> and |..1..0..>
  */
-void statevec_hadamardDistributed(Qureg qureg,
-        ComplexArray stateVecUp,
-        ComplexArray stateVecLo,
-        ComplexArray stateVecOut,
-        int updateUpper)
-{
-
-    qreal   stateRealUp,stateRealLo,stateImagUp,stateImagLo;
-    long long int thisTask;
-    const long long int numTasks=qureg.numAmpsPerChunk;
-
-    if(numTasks >= 4){
-        statevec_hadamardDistributedSIMD(qureg,stateVecUp,stateVecLo,stateVecOut,updateUpper);
-        return;
-    }
+void statevec_swapQubitAmpsDistributed(Qureg qureg, int pairRank, int qb1, int qb2) {
 
-    int sign;
-    if (updateUpper) sign=1;
-    else sign=-1;
+    // can't use qureg.stateVec as a private OMP var
+    qreal *reVec = qureg.stateVec.real;
+    qreal *imVec = qureg.stateVec.imag;
+    qreal *rePairVec = qureg.pairStateVec.real;
+    qreal *imPairVec = qureg.pairStateVec.imag;
 
-    qreal recRoot2 = 1.0/sqrt(2);
+    long long int numLocalAmps = qureg.numAmpsPerChunk;
+    long long int globalStartInd = qureg.chunkId * numLocalAmps;
+    long long int pairGlobalStartInd = pairRank * numLocalAmps;
 
-    qreal *stateVecRealUp=stateVecUp.real, *stateVecImagUp=stateVecUp.imag;
-    qreal *stateVecRealLo=stateVecLo.real, *stateVecImagLo=stateVecLo.imag;
-    qreal *stateVecRealOut=stateVecOut.real, *stateVecImagOut=stateVecOut.imag;
+    long long int localInd, globalInd;
+    long long int pairLocalInd, pairGlobalInd;
 
 # ifdef _OPENMP
 # pragma omp parallel \
-    shared   (stateVecRealUp,stateVecImagUp,stateVecRealLo,stateVecImagLo,stateVecRealOut,stateVecImagOut, \
-            recRoot2, sign) \
-    private  (thisTask,stateRealUp,stateImagUp,stateRealLo,stateImagLo)
+    shared   (reVec,imVec,rePairVec,imPairVec,numLocalAmps,globalStartInd,pairGlobalStartInd,qb1,qb2) \
+    private  (localInd,globalInd, pairLocalInd,pairGlobalInd)
 # endif
     {
 # ifdef _OPENMP
 # pragma omp for schedule (static)
 # endif
-        for (thisTask=0; thisTask<numTasks; thisTask++) {
-            // store current state vector values in temp variables
-            stateRealUp = stateVecRealUp[thisTask];
-            stateImagUp = stateVecImagUp[thisTask];
+        for (localInd=0; localInd < numLocalAmps; localInd++) {
 
-            stateRealLo = stateVecRealLo[thisTask];
-            stateImagLo = stateVecImagLo[thisTask];
+            globalInd = globalStartInd + localInd;
+            if (isOddParity(globalInd, qb1, qb2)) {
 
-            stateVecRealOut[thisTask] = recRoot2*(stateRealUp + sign*stateRealLo);
-            stateVecImagOut[thisTask] = recRoot2*(stateImagUp + sign*stateImagLo);
+                pairGlobalInd = flipBit(flipBit(globalInd, qb1), qb2);
+                pairLocalInd = pairGlobalInd - pairGlobalStartInd;
+
+                reVec[localInd] = rePairVec[pairLocalInd];
+                imVec[localInd] = imPairVec[pairLocalInd];
+            }
         }
     }
 }
 
-void statevec_hadamardDistributedSIMD(Qureg qureg,
-        ComplexArray stateVecUp,
-        ComplexArray stateVecLo,
-        ComplexArray stateVecOut,
-        int updateUpper)
-{
+void statevec_setWeightedQureg(Complex fac1, Qureg qureg1, Complex fac2, Qureg qureg2, Complex facOut, Qureg out) {
 
-    __m256d   stateRealUpSIMD,stateRealLoSIMD,stateImagUpSIMD,stateImagLoSIMD;
-    long long int thisTask;
-    const long long int numTasks=qureg.numAmpsPerChunk;
+    long long int numAmps = qureg1.numAmpsPerChunk;
 
-    int sign;
-    if (updateUpper) sign=1;
-    else sign=-1;
+    qreal *vecRe1 = qureg1.stateVec.real;
+    qreal *vecIm1 = qureg1.stateVec.imag;
+    qreal *vecRe2 = qureg2.stateVec.real;
+    qreal *vecIm2 = qureg2.stateVec.imag;
+    qreal *vecReOut = out.stateVec.real;
+    qreal *vecImOut = out.stateVec.imag;
 
-    qreal recRoot2 = 1.0/sqrt(2);
-    register const __m256d recRoot2SIMD = _mm256_set1_pd(recRoot2);
-    register const __m256d signSIMD = _mm256_set1_pd(sign);
+    qreal facRe1 = fac1.real;
+    qreal facIm1 = fac1.imag;
+    qreal facRe2 = fac2.real;
+    qreal facIm2 = fac2.imag;
+    qreal facReOut = facOut.real;
+    qreal facImOut = facOut.imag;
 
-    qreal *stateVecRealUp=stateVecUp.real, *stateVecImagUp=stateVecUp.imag;
-    qreal *stateVecRealLo=stateVecLo.real, *stateVecImagLo=stateVecLo.imag;
-    qreal *stateVecRealOut=stateVecOut.real, *stateVecImagOut=stateVecOut.imag;
+    qreal re1,im1, re2,im2, reOut,imOut;
+    long long int index;
 
 # ifdef _OPENMP
 # pragma omp parallel \
-    shared   (stateVecRealUp,stateVecImagUp,stateVecRealLo,stateVecImagLo,stateVecRealOut,stateVecImagOut, \
-            recRoot2SIMD, signSIMD) \
-    private  (thisTask,stateRealUpSIMD,stateImagUpSIMD,stateRealLoSIMD,stateImagLoSIMD)
+    shared    (vecRe1,vecIm1, vecRe2,vecIm2, vecReOut,vecImOut, facRe1,facIm1,facRe2,facIm2, numAmps) \
+    private   (index, re1,im1, re2,im2, reOut,imOut)
 # endif
     {
 # ifdef _OPENMP
-# pragma omp for schedule (static)
+# pragma omp for schedule  (static)
 # endif
-        for (thisTask=0; thisTask<numTasks; thisTask+=4) {
-            // store current state vector values in temp variables
-            stateRealUpSIMD = _mm256_loadu_pd(stateVecRealUp+thisTask);
-            stateImagUpSIMD = _mm256_loadu_pd(stateVecImagUp+thisTask);
-            stateRealLoSIMD = _mm256_loadu_pd(stateVecRealLo+thisTask);
-            stateImagLoSIMD = _mm256_loadu_pd(stateVecImagLo+thisTask);
+        for (index=0LL; index<numAmps; index++) {
+            re1 = vecRe1[index]; im1 = vecIm1[index];
+            re2 = vecRe2[index]; im2 = vecIm2[index];
+            reOut = vecReOut[index];
+            imOut = vecImOut[index];
 
-            _mm256_storeu_pd(stateVecRealOut+thisTask, _mm256_mul_pd(recRoot2SIMD,_mm256_add_pd(stateRealUpSIMD,_mm256_mul_pd(signSIMD,stateRealLoSIMD))));
-            _mm256_storeu_pd(stateVecImagOut+thisTask, _mm256_mul_pd(recRoot2SIMD,_mm256_add_pd(stateImagUpSIMD,_mm256_mul_pd(signSIMD,stateImagLoSIMD))));
+            vecReOut[index] = (facReOut*reOut - facImOut*imOut) + (facRe1*re1 - facIm1*im1) + (facRe2*re2 - facIm2*im2);
+            vecImOut[index] = (facReOut*imOut + facImOut*reOut) + (facRe1*im1 + facIm1*re1) + (facRe2*im2 + facIm2*re2);
         }
     }
 }
-void statevec_phaseShiftByTermAllSIMD (Qureg qureg, const int targetQubit, Complex term)
-{
-    long long int index;
 
-    // const long long int chunkSize=qureg.numAmpsPerChunk;
-    // const long long int chunkId=qureg.chunkId;
+/*
+ * real-amplitude state-vector operations
+ *
+ * A real-amplitude register allocates only stateVec.real (and pairStateVec.real when distributed);
+ * its imag arrays are NULL. Only gates and operations which keep the amplitudes real reach these
+ * kernels, so the imaginary components of their matrices are ignored.
+ */
 
-    // dimension of the state vector
+void realvec_initBlankState(Qureg qureg)
+{
     long long int stateVecSize = qureg.numAmpsPerChunk;
+    long long int index;
 
     qreal *stateVecReal = qureg.stateVec.real;
-    qreal *stateVecImag = qureg.stateVec.imag;
-
-    __m256d stateRealLoSIMD, stateImagLoSIMD;
-    register const __m256d cosAngleSIMD = _mm256_set1_pd(term.real);
-    register const __m256d sinAngleSIMD = _mm256_set1_pd(term.imag);
 
 # ifdef _OPENMP
-# pragma omp parallel for \
-    shared   (stateVecReal,stateVecImag ) \
-    private  (index,stateRealLoSIMD,stateImagLoSIMD)             \
-    schedule (static)
+# pragma omp parallel \
+    shared   (stateVecSize, stateVecReal) \
+    private  (index)
 # endif
-    for(index=0; index<stateVecSize; index+=4) {
-
-        // update the coeff of the |1> state of the target qubit
-        // targetBit = extractBit (targetQubit, index+chunkId*chunkSize);
-        // if (targetBit) {
-
-            stateRealLoSIMD = _mm256_loadu_pd(stateVecReal+index);
-            stateImagLoSIMD = _mm256_loadu_pd(stateVecImag+index);
-
-            _mm256_storeu_pd(stateVecReal+index, _mm256_sub_pd(\
-                            _mm256_mul_pd(cosAngleSIMD,stateRealLoSIMD),\
-                            _mm256_mul_pd(sinAngleSIMD,stateImagLoSIMD)));
-            //stateVecReal[index] = cosAngle*stateRealLo - sinAngle*stateImagLo;
-
-            _mm256_storeu_pd(stateVecImag+index, _mm256_add_pd(\
-                            _mm256_mul_pd(sinAngleSIMD,stateRealLoSIMD),\
-                            _mm256_mul_pd(cosAngleSIMD,stateImagLoSIMD)));
-            //stateVecImag[index] = sinAngle*stateRealLo + cosAngle*stateImagLo;
-        // }
+    {
+# ifdef _OPENMP
+# pragma omp for schedule (static)
+# endif
+        for (index=0; index<stateVecSize; index++)
+            stateVecReal[index] = 0.0;
     }
 }
 
+void realvec_initClassicalState(Qureg qureg, long long int stateInd)
+{
+    realvec_initBlankState(qureg);
+
+    // give the specified classical state prob 1
+    if (qureg.chunkId == stateInd/qureg.numAmpsPerChunk)
+        qureg.stateVec.real[stateInd % qureg.numAmpsPerChunk] = 1.0;
+}
 
-void statevec_phaseShiftByTermAll (Qureg qureg, const int targetQubit, Complex term)
+void realvec_initPlusState(Qureg qureg)
 {
+    long long int chunkSize = qureg.numAmpsPerChunk;
     long long int index;
-    long long int stateVecSize;
-
-    // dimension of the state vector
-    stateVecSize = qureg.numAmpsPerChunk;
-    if(stateVecSize>=4) {
-        statevec_phaseShiftByTermAllSIMD(qureg,targetQubit,term);
-        return ;
-    }
+    qreal normFactor = 1.0/sqrt((qreal) qureg.numAmpsTotal);
 
     qreal *stateVecReal = qureg.stateVec.real;
-    qreal *stateVecImag = qureg.stateVec.imag;
-
-    qreal stateRealLo, stateImagLo;
-    const qreal cosAngle = term.real;
-    const qreal sinAngle = term.imag;
 
 # ifdef _OPENMP
-# pragma omp parallel for \
-    shared   (stateVecSize, stateVecReal,stateVecImag ) \
-    private  (index,stateRealLo,stateImagLo)             \
-    schedule (static)
+# pragma omp parallel \
+    shared   (chunkSize, stateVecReal, normFactor) \
+    private  (index)
 # endif
-    for (index=0; index<stateVecSize; index++) {
-
-        // update the coeff of the |1> state of the target qubit
-            stateRealLo = stateVecReal[index];
-            stateImagLo = stateVecImag[index];
-
-            stateVecReal[index] = cosAngle*stateRealLo - sinAngle*stateImagLo;
-            stateVecImag[index] = sinAngle*stateRealLo + cosAngle*stateImagLo;
+    {
+# ifdef _OPENMP
+# pragma omp for schedule (static)
+# endif
+        for (index=0; index<chunkSize; index++)
+            stateVecReal[index] = normFactor;
     }
 }
 
-void statevec_phaseShiftByTermSmall (Qureg qureg, const int targetQubit, Complex term)
+void realvec_setAmps(Qureg qureg, long long int startInd, qreal* reals, long long int numAmps)
 {
+    // restrict the given amplitudes to those in this chunk, as per statevec_setAmps
+    long long int localStartInd = startInd - qureg.chunkId*qureg.numAmpsPerChunk;
+    long long int localEndInd = localStartInd + numAmps; // exclusive
+    long long int offset = qureg.chunkId*qureg.numAmpsPerChunk - startInd;
+
+    if (localStartInd < 0)
+        localStartInd = 0;
+    if (localEndInd > qureg.numAmpsPerChunk)
+        localEndInd = qureg.numAmpsPerChunk;
+
     long long int index;
+    qreal* vecRe = qureg.stateVec.real;
 
-    // const long long int chunkSize=qureg.numAmpsPerChunk;
-    // const long long int chunkId=qureg.chunkId;
-    if((1LL<<targetQubit)>=qureg.numAmpsPerChunk) {
-        if(extractBit(targetQubit,qureg.chunkId*qureg.numAmpsPerChunk)) {
-            statevec_phaseShiftByTermAll(qureg,targetQubit,term);
-        }
-        return ;
-    }
-    // dimension of the state vector
-    const long long int sizeTask = (1LL << targetQubit);
-    if(sizeTask >= 4){
-        statevec_phaseShiftByTermSIMD(qureg,targetQubit,term);
-        return;
+# ifdef _OPENMP
+# pragma omp parallel \
+    shared   (localStartInd,localEndInd, vecRe, reals, offset) \
+    private  (index)
+# endif
+    {
+# ifdef _OPENMP
+# pragma omp for schedule (static)
+# endif
+        for (index=localStartInd; index < localEndInd; index++)
+            vecRe[index] = reals[index + offset];
     }
+}
 
-    const long long int numTasks = (qureg.numAmpsPerChunk>>(1 + targetQubit)) ;
-    long long thisTask;
+void realvec_cloneQureg(Qureg targetQureg, Qureg copyQureg)
+{
+    long long int stateVecSize = targetQureg.numAmpsPerChunk;
+    long long int index;
 
-    qreal *stateVecReal = qureg.stateVec.real;
-    qreal *stateVecImag = qureg.stateVec.imag;
+    size_t arrSize = (size_t) (stateVecSize * sizeof(*(targetQureg.stateVec.real)));
+    if (shareAmpArray(targetQureg.stateVec.real, copyQureg.stateVec.real, arrSize))
+        return;
 
-    qreal stateRealLo, stateImagLo;
-    const qreal cosAngle = term.real;
-    const qreal sinAngle = term.imag;
+    qreal *targetStateVecReal = targetQureg.stateVec.real;
+    qreal *copyStateVecReal = copyQureg.stateVec.real;
 
 # ifdef _OPENMP
-# pragma omp parallel for \
-    shared   (stateVecReal,stateVecImag ) \
-    private  (index,stateRealLo,stateImagLo)             \
-    schedule (static)
+# pragma omp parallel \
+    shared   (stateVecSize, targetStateVecReal, copyStateVecReal) \
+    private  (index)
 # endif
-    for(thisTask = 0; thisTask < numTasks; ++thisTask)
-    for(index = sizeTask * thisTask * 2 + sizeTask; index < sizeTask * (thisTask + 1) * 2; ++index) {
-
-        // update the coeff of the |1> state of the target qubit
-        // targetBit = extractBit (targetQubit, index+chunkId*chunkSize);
-        // if (targetBit) {
-
-            stateRealLo = stateVecReal[index];
-            stateImagLo = stateVecImag[index];
-
-            stateVecReal[index] = cosAngle*stateRealLo - sinAngle*stateImagLo;
-            stateVecImag[index] = sinAngle*stateRealLo + cosAngle*stateImagLo;
-        // }
+    {
+# ifdef _OPENMP
+# pragma omp for schedule (static)
+# endif
+        for (index=0; index<stateVecSize; index++)
+            targetStateVecReal[index] = copyStateVecReal[index];
     }
 }
 
-void statevec_phaseShiftByTermSIMD (Qureg qureg, const int targetQubit, Complex term)
+void realvec_multiControlledUnitaryLocal(
+    Qureg qureg, const int targetQubit,
+    long long int ctrlQubitsMask, long long int ctrlFlipMask,
+    ComplexMatrix2 u)
 {
-    long long int index;
+    long long int sizeBlock, sizeHalfBlock;
+    long long int thisBlock, indexUp,indexLo;
 
-    // const long long int chunkSize=qureg.numAmpsPerChunk;
-    // const long long int chunkId=qureg.chunkId;
+    qreal stateUp,stateLo;
+    const long long int chunkSize=qureg.numAmpsPerChunk;
+    const long long int chunkId=qureg.chunkId;
 
-    // dimension of the state vector
-    const long long int numTasks = (qureg.numAmpsPerChunk>>(1 + targetQubit)) ;
-    const long long int sizeTask = (1LL << targetQubit);
-    long long thisTask;
+    sizeHalfBlock = 1LL << targetQubit;
+    sizeBlock     = 2LL * sizeHalfBlock;
+    const long long int numBlocks=chunkSize/sizeBlock;
 
+    qreal u00=u.real[0][0], u01=u.real[0][1];
+    qreal u10=u.real[1][0], u11=u.real[1][1];
     qreal *stateVecReal = qureg.stateVec.real;
-    qreal *stateVecImag = qureg.stateVec.imag;
-
-    __m256d stateRealLoSIMD, stateImagLoSIMD;
-    register const __m256d cosAngleSIMD = _mm256_set1_pd(term.real);
-    register const __m256d sinAngleSIMD = _mm256_set1_pd(term.imag);
 
+    // blocks are walked contiguously (rather than by task index) so the inner loop vectorises
 # ifdef _OPENMP
-    if(numTasks >= omp_get_num_threads()) {
-# pragma omp parallel for \
-    shared   (stateVecReal,stateVecImag ) \
-    private  (index,stateRealLoSIMD,stateImagLoSIMD)             \
-    schedule (static)
+# pragma omp parallel \
+    shared   (sizeBlock,sizeHalfBlock, stateVecReal, u00,u01,u10,u11, ctrlQubitsMask,ctrlFlipMask) \
+    private  (thisBlock, indexUp,indexLo, stateUp,stateLo)
 # endif
-    for(thisTask = 0; thisTask < numTasks; ++thisTask)
-    for(index = sizeTask * thisTask * 2 + sizeTask; index < sizeTask * (thisTask + 1) * 2; index+=4) {
-
-        // update the coeff of the |1> state of the target qubit
-        // targetBit = extractBit (targetQubit, index+chunkId*chunkSize);
-        // if (targetBit) {
-
-            stateRealLoSIMD = _mm256_loadu_pd(stateVecReal+index);
-            stateImagLoSIMD = _mm256_loadu_pd(stateVecImag+index);
-
-            _mm256_storeu_pd(stateVecReal+index, _mm256_sub_pd(\
-                            _mm256_mul_pd(cosAngleSIMD,stateRealLoSIMD),\
-                            _mm256_mul_pd(sinAngleSIMD,stateImagLoSIMD)));
-            //stateVecReal[index] = cosAngle*stateRealLo - sinAngle*stateImagLo;
-
-            _mm256_storeu_pd(stateVecImag+index, _mm256_add_pd(\
-                            _mm256_mul_pd(sinAngleSIMD,stateRealLoSIMD),\
-                            _mm256_mul_pd(cosAngleSIMD,stateImagLoSIMD)));
-            //stateVecImag[index] = sinAngle*stateRealLo + cosAngle*stateImagLo;
-        // }
-    }
-    
+    {
 # ifdef _OPENMP
-   } else {
-        for(thisTask = 0; thisTask < numTasks; ++thisTask)
-
-# pragma omp parallel for \
-    shared   (stateVecReal,stateVecImag ) \
-    private  (index,stateRealLoSIMD,stateImagLoSIMD)             \
-    schedule (static)
-    for(index = sizeTask * thisTask * 2 + sizeTask; index < sizeTask * (thisTask + 1) * 2; index+=4) {
+# pragma omp for schedule (static)
+# endif
+        for (thisBlock=0; thisBlock<numBlocks; thisBlock++)
+        for (indexUp=thisBlock*sizeBlock; indexUp<thisBlock*sizeBlock+sizeHalfBlock; indexUp++) {
 
-        // update the coeff of the |1> state of the target qubit
-        // targetBit = extractBit (targetQubit, index+chunkId*chunkSize);
-        // if (targetBit) {
+            indexLo     = indexUp + sizeHalfBlock;
 
-            stateRealLoSIMD = _mm256_loadu_pd(stateVecReal+index);
-            stateImagLoSIMD = _mm256_loadu_pd(stateVecImag+index);
+            if (ctrlQubitsMask && ctrlQubitsMask != (ctrlQubitsMask & ((indexUp+chunkId*chunkSize) ^ ctrlFlipMask)))
+                continue;
 
-            _mm256_storeu_pd(stateVecReal+index, _mm256_sub_pd(\
-                            _mm256_mul_pd(cosAngleSIMD,stateRealLoSIMD),\
-                            _mm256_mul_pd(sinAngleSIMD,stateImagLoSIMD)));
-            //stateVecReal[index] = cosAngle*stateRealLo - sinAngle*stateImagLo;
+            stateUp = stateVecReal[indexUp];
+            stateLo = stateVecReal[indexLo];
 
-            _mm256_storeu_pd(stateVecImag+index, _mm256_add_pd(\
-                            _mm256_mul_pd(sinAngleSIMD,stateRealLoSIMD),\
-                            _mm256_mul_pd(cosAngleSIMD,stateImagLoSIMD)));
-            //stateVecImag[index] = sinAngle*stateRealLo + cosAngle*stateImagLo;
-        // }
+            stateVecReal[indexUp] = u00*stateUp + u01*stateLo;
+            stateVecReal[indexLo] = u10*stateUp + u11*stateLo;
+        }
     }
-   }
-# endif
-
 }
 
-void statevec_phaseShiftByTerm (Qureg qureg, const int targetQubit, Complex term)
+void realvec_multiControlledUnitaryDistributed(
+        Qureg qureg,
+        long long int ctrlQubitsMask, long long int ctrlFlipMask,
+        qreal rot1, qreal rot2,
+        qreal* stateVecUp,
+        qreal* stateVecLo,
+        qreal* stateVecOut)
 {
-    long long int index;
-    long long int stateVecSize;
-    int targetBit;
-
+    long long int thisTask;
+    const long long int numTasks=qureg.numAmpsPerChunk;
     const long long int chunkSize=qureg.numAmpsPerChunk;
     const long long int chunkId=qureg.chunkId;
 
-    // dimension of the state vector
-    stateVecSize = qureg.numAmpsPerChunk;
-    qreal *stateVecReal = qureg.stateVec.real;
-    qreal *stateVecImag = qureg.stateVec.imag;
-
-    qreal stateRealLo, stateImagLo;
-    const qreal cosAngle = term.real;
-    const qreal sinAngle = term.imag;
-
 # ifdef _OPENMP
-# pragma omp parallel for \
-    shared   (stateVecSize, stateVecReal,stateVecImag ) \
-    private  (index,targetBit,stateRealLo,stateImagLo)             \
-    schedule (static)
+# pragma omp parallel \
+    shared   (stateVecUp,stateVecLo,stateVecOut, rot1,rot2, ctrlQubitsMask,ctrlFlipMask) \
+    private  (thisTask)
 # endif
-    for (index=0; index<stateVecSize; index++) {
-
-        // update the coeff of the |1> state of the target qubit
-        targetBit = extractBit (targetQubit, index+chunkId*chunkSize);
-        if (targetBit) {
-
-            stateRealLo = stateVecReal[index];
-            stateImagLo = stateVecImag[index];
-
-            stateVecReal[index] = cosAngle*stateRealLo - sinAngle*stateImagLo;
-            stateVecImag[index] = sinAngle*stateRealLo + cosAngle*stateImagLo;
-        }
+    {
+# ifdef _OPENMP
+# pragma omp for schedule (static)
+# endif
+        for (thisTask=0; thisTask<numTasks; thisTask++)
+            if (ctrlQubitsMask == (ctrlQubitsMask & ((thisTask+chunkId*chunkSize) ^ ctrlFlipMask)))
+                stateVecOut[thisTask] = rot1*stateVecUp[thisTask] + rot2*stateVecLo[thisTask];
     }
 }
 
-void statevec_controlledPhaseShift (Qureg qureg, const int idQubit1, const int idQubit2, qreal angle)
+void realvec_multiControlledPhaseFlip(Qureg qureg, long long int mask)
 {
     long long int index;
-    long long int stateVecSize;
-    int bit1, bit2;
-
-    const long long int chunkSize=qureg.numAmpsPerChunk;
+    const long long int stateVecSize=qureg.numAmpsPerChunk;
     const long long int chunkId=qureg.chunkId;
 
-    // dimension of the state vector
-    stateVecSize = qureg.numAmpsPerChunk;
     qreal *stateVecReal = qureg.stateVec.real;
-    qreal *stateVecImag = qureg.stateVec.imag;
-
-    qreal stateRealLo, stateImagLo;
-    const qreal cosAngle = cos(angle);
-    const qreal sinAngle = sin(angle);
 
 # ifdef _OPENMP
-# pragma omp parallel for \
-    shared   (stateVecSize, stateVecReal,stateVecImag ) \
-    private  (index,bit1,bit2,stateRealLo,stateImagLo)             \
-    schedule (static)
+# pragma omp parallel \
+    shared   (stateVecReal, mask) \
+    private  (index)
 # endif
-    for (index=0; index<stateVecSize; index++) {
-        bit1 = extractBit (idQubit1, index+chunkId*chunkSize);
-        bit2 = extractBit (idQubit2, index+chunkId*chunkSize);
-        if (bit1 && bit2) {
+    {
+# ifdef _OPENMP
+# pragma omp for schedule (static)
+# endif
+        for (index=0; index<stateVecSize; index++)
+            if (mask == (mask & (index+chunkId*stateVecSize)))
+                stateVecReal[index] = - stateVecReal[index];
+    }
+}
 
-            stateRealLo = stateVecReal[index];
-            stateImagLo = stateVecImag[index];
+/** As statevec_swapQubitAmpsLocal, for a real-amplitude register */
+void realvec_swapQubitAmpsLocal(Qureg qureg, int qb1, int qb2)
+{
+    qreal *reVec = qureg.stateVec.real;
 
-            stateVecReal[index] = cosAngle*stateRealLo - sinAngle*stateImagLo;
-            stateVecImag[index] = sinAngle*stateRealLo + cosAngle*stateImagLo;
+    long long int numTasks = qureg.numAmpsPerChunk >> 2;
+    long long int thisTask;
+    long long int ind00, ind01, ind10;
+    qreal re01;
+
+# ifdef _OPENMP
+# pragma omp parallel \
+    shared   (reVec,numTasks,qb1,qb2) \
+    private  (thisTask, ind00,ind01,ind10, re01)
+# endif
+    {
+# ifdef _OPENMP
+# pragma omp for schedule (static)
+# endif
+        for (thisTask=0; thisTask<numTasks; thisTask++) {
+            ind00 = insertTwoZeroBits(thisTask, qb1, qb2);
+            ind01 = flipBit(ind00, qb1);
+            ind10 = flipBit(ind00, qb2);
+
+            re01 = reVec[ind01];
+            reVec[ind01] = reVec[ind10];
+            reVec[ind10] = re01;
         }
     }
 }
 
-void statevec_multiControlledPhaseShift(Qureg qureg, int *controlQubits, int numControlQubits, qreal angle)
+/** As statevec_swapQubitAmpsDistributed, for a real-amplitude register */
+void realvec_swapQubitAmpsDistributed(Qureg qureg, int pairRank, int qb1, int qb2)
 {
-    long long int index;
-    long long int stateVecSize;
-
-    const long long int chunkSize=qureg.numAmpsPerChunk;
-    const long long int chunkId=qureg.chunkId;
-
-    long long int mask = getQubitBitMask(controlQubits, numControlQubits);
+    qreal *reVec = qureg.stateVec.real;
+    qreal *rePairVec = qureg.pairStateVec.real;
 
-    stateVecSize = qureg.numAmpsPerChunk;
-    qreal *stateVecReal = qureg.stateVec.real;
-    qreal *stateVecImag = qureg.stateVec.imag;
+    long long int numLocalAmps = qureg.numAmpsPerChunk;
+    long long int globalStartInd = qureg.chunkId * numLocalAmps;
+    long long int pairGlobalStartInd = pairRank * numLocalAmps;
 
-    qreal stateRealLo, stateImagLo;
-    const qreal cosAngle = cos(angle);
-    const qreal sinAngle = sin(angle);
+    long long int localInd, globalInd, pairGlobalInd;
 
 # ifdef _OPENMP
 # pragma omp parallel \
-    shared   (stateVecSize, stateVecReal, stateVecImag, mask) \
-    private  (index, stateRealLo, stateImagLo)
+    shared   (reVec,rePairVec,numLocalAmps,globalStartInd,pairGlobalStartInd,qb1,qb2) \
+    private  (localInd,globalInd, pairGlobalInd)
 # endif
     {
 # ifdef _OPENMP
 # pragma omp for schedule (static)
 # endif
-        for (index=0; index<stateVecSize; index++) {
-            if (mask == (mask & (index+chunkId*chunkSize)) ){
-
-                stateRealLo = stateVecReal[index];
-                stateImagLo = stateVecImag[index];
-
-                stateVecReal[index] = cosAngle*stateRealLo - sinAngle*stateImagLo;
-                stateVecImag[index] = sinAngle*stateRealLo + cosAngle*stateImagLo;
+        for (localInd=0; localInd < numLocalAmps; localInd++) {
+            globalInd = globalStartInd + localInd;
+            if (isOddParity(globalInd, qb1, qb2)) {
+                pairGlobalInd = flipBit(flipBit(globalInd, qb1), qb2);
+                reVec[localInd] = rePairVec[pairGlobalInd - pairGlobalStartInd];
             }
         }
     }
 }
 
-int getBitMaskParity(long long int mask) {
-    int parity = 0;
-    while (mask) {
-        parity = !parity;
-        mask = mask & (mask-1);
-    }
-    return parity;
-}
-
-void statevec_multiRotateZ(Qureg qureg, long long int mask, qreal angle)
+/** As statevec_multiControlledTwoQubitUnitaryLocal, for a real-amplitude register and a 
+ * real matrix u (whose imaginary components are ignored) */
+void realvec_multiControlledTwoQubitUnitaryLocal(Qureg qureg, long long int ctrlMask, const int q1, const int q2, ComplexMatrix4 u)
 {
-    long long int index;
-    long long int stateVecSize;
-
-    const long long int chunkSize=qureg.numAmpsPerChunk;
-    const long long int chunkId=qureg.chunkId;
-
-    stateVecSize = qureg.numAmpsPerChunk;
-    qreal *stateVecReal = qureg.stateVec.real;
-    qreal *stateVecImag = qureg.stateVec.imag;
-
-    qreal stateReal, stateImag;
-    const qreal cosAngle = cos(angle/2.0);
-    const qreal sinAngle = sin(angle/2.0);
+    qreal *reVec = qureg.stateVec.real;
 
-    // = +-1, to flip sinAngle based on target qubit parity, to effect
-    // exp(-angle/2 i fac_j)|j>
-    int fac;
+    long long int globalIndStart = qureg.chunkId*qureg.numAmpsPerChunk;
+    long long int numTasks = qureg.numAmpsPerChunk >> 2;
+    long long int thisTask;
+    long long int ind00, ind01, ind10, ind11;
+    qreal re00, re01, re10, re11;
 
 # ifdef _OPENMP
 # pragma omp parallel \
-    shared   (stateVecSize, stateVecReal, stateVecImag, mask) \
-    private  (index, fac, stateReal, stateImag)
+    shared   (reVec,globalIndStart,numTasks,ctrlMask,u) \
+    private  (thisTask, ind00,ind01,ind10,ind11, re00,re01,re10,re11)
 # endif
     {
 # ifdef _OPENMP
 # pragma omp for schedule (static)
 # endif
-        for (index=0; index<stateVecSize; index++) {
-            stateReal = stateVecReal[index];
-            stateImag = stateVecImag[index];
+        for (thisTask=0; thisTask<numTasks; thisTask++) {
 
-            // odd-parity target qubits get fac_j = -1
-            fac = getBitMaskParity(mask & (index+chunkId*chunkSize))? -1 : 1;
-            stateVecReal[index] = cosAngle*stateReal + fac * sinAngle*stateImag;
-            stateVecImag[index] = - fac * sinAngle*stateReal + cosAngle*stateImag;
+            ind00 = insertTwoZeroBits(thisTask, q1, q2);
+            if (ctrlMask && ((ctrlMask & (ind00 + globalIndStart)) != ctrlMask))
+                continue;
+
+            ind01 = flipBit(ind00, q1);
+            ind10 = flipBit(ind00, q2);
+            ind11 = flipBit(ind01, q2);
+
+            re00 = reVec[ind00];
+            re01 = reVec[ind01];
+            re10 = reVec[ind10];
+            re11 = reVec[ind11];
+
+            reVec[ind00] = u.real[0][0]*re00 + u.real[0][1]*re01 + u.real[0][2]*re10 + u.real[0][3]*re11;
+            reVec[ind01] = u.real[1][0]*re00 + u.real[1][1]*re01 + u.real[1][2]*re10 + u.real[1][3]*re11;
+            reVec[ind10] = u.real[2][0]*re00 + u.real[2][1]*re01 + u.real[2][2]*re10 + u.real[2][3]*re11;
+            reVec[ind11] = u.real[3][0]*re00 + u.real[3][1]*re01 + u.real[3][2]*re10 + u.real[3][3]*re11;
         }
     }
 }
 
-qreal densmatr_findProbabilityOfZeroLocal(Qureg qureg, const int measureQubit) {
-
-    // computes first local index containing a diagonal element
-    long long int localNumAmps = qureg.numAmpsPerChunk;
-    long long int densityDim = (1LL << qureg.numQubitsRepresented);
-    long long int diagSpacing = 1LL + densityDim;
-    long long int maxNumDiagsPerChunk = 1 + localNumAmps / diagSpacing;
-    long long int numPrevDiags = (qureg.chunkId>0)? 1+(qureg.chunkId*localNumAmps)/diagSpacing : 0;
-    long long int globalIndNextDiag = diagSpacing * numPrevDiags;
-    long long int localIndNextDiag = globalIndNextDiag % localNumAmps;
+/** As statevec_multiControlledMultiQubitUnitaryLocal, for a real-amplitude register and a 
+ * real matrix u (whose imaginary components are ignored) */
+void realvec_multiControlledMultiQubitUnitaryLocal(Qureg qureg, long long int ctrlMask, int* targs, const int numTargs, ComplexMatrixN u)
+{
+    qreal *reVec = qureg.stateVec.real;
 
-    // computes how many diagonals are contained in this chunk
-    long long int numDiagsInThisChunk = maxNumDiagsPerChunk;
-    if (localIndNextDiag + (numDiagsInThisChunk-1)*diagSpacing >= localNumAmps)
-        numDiagsInThisChunk -= 1;
+    long long int numTasks = qureg.numAmpsPerChunk >> numTargs;
+    long long int numTargAmps = 1 << u.numQubits;
+    long long int globalIndStart = qureg.chunkId*qureg.numAmpsPerChunk;
 
-    long long int visitedDiags;     // number of visited diagonals in this chunk so far
-    long long int basisStateInd;    // current diagonal index being considered
-    long long int index;            // index in the local chunk
+    long long int thisTask, thisInd00, ind;
+    int i, t, r, c;
+    long long int ampInds[numTargAmps];
+    qreal reAmps[numTargAmps];
 
-    qreal zeroProb = 0;
-    qreal *stateVecReal = qureg.stateVec.real;
+    int sortedTargs[numTargs];
+    for (t=0; t < numTargs; t++)
+        sortedTargs[t] = targs[t];
+    qsort(sortedTargs, numTargs, sizeof(int), qsortComp);
 
 # ifdef _OPENMP
 # pragma omp parallel \
-    shared    (localIndNextDiag, numPrevDiags, diagSpacing, stateVecReal, numDiagsInThisChunk) \
-    private   (visitedDiags, basisStateInd, index) \
-    reduction ( +:zeroProb )
+    shared   (reVec, numTasks,numTargAmps,globalIndStart, ctrlMask,targs,sortedTargs,u) \
+    private  (thisTask,thisInd00,ind,i,t,r,c, ampInds,reAmps)
 # endif
     {
 # ifdef _OPENMP
-# pragma omp for schedule  (static)
+# pragma omp for schedule (static)
 # endif
-        // sums the diagonal elems of the density matrix where measureQubit=0
-        for (visitedDiags = 0; visitedDiags < numDiagsInThisChunk; visitedDiags++) {
+        for (thisTask=0; thisTask<numTasks; thisTask++) {
 
-            basisStateInd = numPrevDiags + visitedDiags;
-            index = localIndNextDiag + diagSpacing * visitedDiags;
+            thisInd00 = thisTask;
+            for (t=0; t < numTargs; t++)
+                thisInd00 = insertZeroBit(thisInd00, sortedTargs[t]);
+            if (ctrlMask && ((ctrlMask & (thisInd00 + globalIndStart)) != ctrlMask))
+                continue;
 
-            if (extractBit(measureQubit, basisStateInd) == 0)
-                zeroProb += stateVecReal[index]; // assume imag[diagonls] ~ 0
+            for (i=0; i < numTargAmps; i++) {
+                ind = thisInd00;
+                for (t=0; t < numTargs; t++)
+                    if (extractBit(t, i))
+                        ind = flipBit(ind, targs[t]);
+                ampInds[i] = ind;
+                reAmps [i] = reVec[ind];
+            }
 
+            for (r=0; r < numTargAmps; r++) {
+                ind = ampInds[r];
+                reVec[ind] = 0;
+                for (c=0; c < numTargAmps; c++)
+                    reVec[ind] += reAmps[c]*u.real[r][c];
+            }
         }
     }
-
-    return zeroProb;
 }
 
-/** Measure the total probability of a specified qubit being in the zero state across all amplitudes in this chunk.
- *  Size of regions to skip is less than the size of one chunk.
- *
- *  @param[in] qureg object representing the set of qubits
- *  @param[in] measureQubit qubit to measure
- *  @return probability of qubit measureQubit being zero
- */
-qreal statevec_findProbabilityOfZeroLocal (Qureg qureg,
-        const int measureQubit)
+qreal realvec_findProbabilityOfZeroLocal(Qureg qureg, const int measureQubit)
 {
-    // ----- sizes
-    long long int sizeBlock,                                  // size of blocks
-         sizeHalfBlock;                                       // size of blocks halved
-    // ----- indices
-    long long int thisBlock,                                  // current block
-         index;                                               // current index for first half block
-    // ----- measured probability
-    qreal   totalProbability;                                  // probability (returned) value
-    // ----- temp variables
-    long long int thisTask;
-    long long int numTasks=qureg.numAmpsPerChunk>>1;
-
-    // ---------------------------------------------------------------- //
-    //            dimensions                                            //
-    // ---------------------------------------------------------------- //
-    sizeHalfBlock = 1LL << (measureQubit);                       // number of state vector elements to sum,
-    // and then the number to skip
-    sizeBlock     = 2LL * sizeHalfBlock;                         // size of blocks (pairs of measure and skip entries)
-
-    // initialise returned value
-    totalProbability = 0.0;
+    long long int sizeHalfBlock = 1LL << measureQubit;
+    long long int sizeBlock = 2LL * sizeHalfBlock;
+    long long int numTasks = qureg.numAmpsPerChunk>>1;
+    long long int thisTask, index;
+    qreal totalProbability = 0;
 
     qreal *stateVecReal = qureg.stateVec.real;
-    qreal *stateVecImag = qureg.stateVec.imag;
 
 # ifdef _OPENMP
 # pragma omp parallel \
-    shared    (numTasks,sizeBlock,sizeHalfBlock, stateVecReal,stateVecImag) \
-    private   (thisTask,thisBlock,index) \
+    shared    (numTasks,sizeBlock,sizeHalfBlock, stateVecReal) \
+    private   (thisTask,index) \
     reduction ( +:totalProbability )
 # endif
     {
@@ -4919,413 +8134,533 @@ qreal statevec_findProbabilityOfZeroLocal (Qureg qureg,
 # pragma omp for schedule  (static)
 # endif
         for (thisTask=0; thisTask<numTasks; thisTask++) {
-            thisBlock = thisTask / sizeHalfBlock;
-            index     = thisBlock*sizeBlock + thisTask%sizeHalfBlock;
-
-            totalProbability += stateVecReal[index]*stateVecReal[index]
-                + stateVecImag[index]*stateVecImag[index];
+            index = (thisTask / sizeHalfBlock)*sizeBlock + thisTask%sizeHalfBlock;
+            totalProbability += stateVecReal[index]*stateVecReal[index];
         }
     }
     return totalProbability;
 }
 
-/** Measure the probability of a specified qubit being in the zero state across all amplitudes held in this chunk.
- * Size of regions to skip is a multiple of chunkSize.
- * The results are communicated and aggregated by the caller
- *
- *  @param[in] qureg object representing the set of qubits
- *  @return probability of qubit measureQubit being zero
+/** Sum of the probabilities of every amplitude in this chunk. This gives this chunk's contribution 
+ * to the probability of a qubit being zero when the chunk holds only amplitudes with that qubit zero.
  */
-qreal statevec_findProbabilityOfZeroDistributed (Qureg qureg) {
-    // ----- measured probability
-    qreal   totalProbability;                                  // probability (returned) value
-    // ----- temp variables
-    long long int thisTask;                                   // task based approach for expose loop with small granularity
-    long long int numTasks=qureg.numAmpsPerChunk;
-
-    // ---------------------------------------------------------------- //
-    //            find probability                                      //
-    // ---------------------------------------------------------------- //
-
-    // initialise returned value
-    totalProbability = 0.0;
+qreal realvec_findProbabilityOfZeroDistributed(Qureg qureg)
+{
+    long long int numTasks = qureg.numAmpsPerChunk;
+    long long int thisTask;
+    qreal totalProbability = 0;
 
     qreal *stateVecReal = qureg.stateVec.real;
-    qreal *stateVecImag = qureg.stateVec.imag;
 
 # ifdef _OPENMP
 # pragma omp parallel \
-    shared    (numTasks,stateVecReal,stateVecImag) \
+    shared    (numTasks, stateVecReal) \
     private   (thisTask) \
     reduction ( +:totalProbability )
 # endif
     {
 # ifdef _OPENMP
 # pragma omp for schedule  (static)
+# endif
+        for (thisTask=0; thisTask<numTasks; thisTask++)
+            totalProbability += stateVecReal[thisTask]*stateVecReal[thisTask];
+    }
+    return totalProbability;
+}
+
+void realvec_collapseToKnownProbOutcomeLocal(Qureg qureg, int measureQubit, int outcome, qreal totalProbability)
+{
+    long long int sizeHalfBlock = 1LL << measureQubit;
+    long long int sizeBlock = 2LL * sizeHalfBlock;
+    long long int numTasks = qureg.numAmpsPerChunk>>1;
+    long long int thisTask, index;
+
+    qreal renorm = 1/sqrt(totalProbability);
+    qreal *stateVecReal = qureg.stateVec.real;
+
+    // offsets (within a block) of the kept and discarded amplitudes
+    long long int keepOffset = (outcome==0)? 0 : sizeHalfBlock;
+    long long int zeroOffset = sizeHalfBlock - keepOffset;
+
+# ifdef _OPENMP
+# pragma omp parallel \
+    shared    (numTasks,sizeBlock,sizeHalfBlock, stateVecReal,renorm, keepOffset,zeroOffset) \
+    private   (thisTask,index)
+# endif
+    {
+# ifdef _OPENMP
+# pragma omp for schedule  (static)
 # endif
         for (thisTask=0; thisTask<numTasks; thisTask++) {
-            totalProbability += stateVecReal[thisTask]*stateVecReal[thisTask]
-                + stateVecImag[thisTask]*stateVecImag[thisTask];
+            index = (thisTask / sizeHalfBlock)*sizeBlock + thisTask%sizeHalfBlock;
+            stateVecReal[index + keepOffset] *= renorm;
+            stateVecReal[index + zeroOffset] = 0;
         }
     }
-
-    return totalProbability;
 }
 
+/** Multiply every amplitude in this chunk by factor. In the distributed collapse, a chunk either
+ * holds only amplitudes consistent with the outcome (renormalised by 1/sqrt(prob)), or none (zeroed).
+ */
+void realvec_scaleAmpsLocal(Qureg qureg, qreal factor)
+{
+    long long int numTasks = qureg.numAmpsPerChunk;
+    long long int thisTask;
+
+    qreal *stateVecReal = qureg.stateVec.real;
 
+# ifdef _OPENMP
+# pragma omp parallel \
+    shared    (numTasks, stateVecReal, factor) \
+    private   (thisTask)
+# endif
+    {
+# ifdef _OPENMP
+# pragma omp for schedule  (static)
+# endif
+        for (thisTask=0; thisTask<numTasks; thisTask++)
+            stateVecReal[thisTask] *= factor;
+    }
+}
 
-void statevec_controlledPhaseFlip (Qureg qureg, const int idQubit1, const int idQubit2)
+qreal realvec_calcTotalProbLocal(Qureg qureg)
 {
+    // Kahan summation, as per statevec_calcTotalProb
+    qreal pTotal=0;
+    qreal y, t, c=0;
     long long int index;
-    long long int stateVecSize;
-    int bit1, bit2;
 
-    const long long int chunkSize=qureg.numAmpsPerChunk;
-    const long long int chunkId=qureg.chunkId;
+    for (index=0; index<qureg.numAmpsPerChunk; index++) {
+        y = qureg.stateVec.real[index]*qureg.stateVec.real[index] - c;
+        t = pTotal + y;
+        // Don't change the bracketing on the following line
+        c = ( t - pTotal ) - y;
+        pTotal = t;
+    }
+    return pTotal;
+}
 
-    // dimension of the state vector
-    stateVecSize = qureg.numAmpsPerChunk;
-    qreal *stateVecReal = qureg.stateVec.real;
-    qreal *stateVecImag = qureg.stateVec.imag;
+qreal realvec_calcInnerProductLocal(Qureg bra, Qureg ket)
+{
+    qreal innerProd = 0;
+    long long int index;
+    long long int numAmps = bra.numAmpsPerChunk;
+    qreal *braVecReal = bra.stateVec.real;
+    qreal *ketVecReal = ket.stateVec.real;
 
 # ifdef _OPENMP
-# pragma omp parallel for \
-    shared   (stateVecSize, stateVecReal,stateVecImag ) \
-    private  (index,bit1,bit2)             \
-    schedule (static)
+# pragma omp parallel \
+    shared    (braVecReal, ketVecReal, numAmps) \
+    private   (index) \
+    reduction ( +:innerProd )
 # endif
-    for (index=0; index<stateVecSize; index++) {
-        bit1 = extractBit (idQubit1, index+chunkId*chunkSize);
-        bit2 = extractBit (idQubit2, index+chunkId*chunkSize);
-        if (bit1 && bit2) {
-            stateVecReal [index] = - stateVecReal [index];
-            stateVecImag [index] = - stateVecImag [index];
-        }
+    {
+# ifdef _OPENMP
+# pragma omp for schedule  (static)
+# endif
+        for (index=0; index < numAmps; index++)
+            innerProd += braVecReal[index]*ketVecReal[index];
     }
+    return innerProd;
 }
 
-void statevec_multiControlledPhaseFlip(Qureg qureg, int *controlQubits, int numControlQubits)
+/** Computes this node's contribution to <psi|P|psi> for the Pauli product P given by termCodes (one
+ * code per qubit). P maps |j> to i^numY (-1)^popcount(j & signMask) |j ^ flipMask>, so for real psi,
+ * <psi|P|psi> = i^numY sum_j (-1)^popcount(j & signMask) psi_j psi_{j ^ flipMask}, which is zero when
+ * numY is odd. flippedAmps must hold the chunk containing the amplitudes psi_{j ^ flipMask} of this
+ * chunk's j; this is the register's own chunk when flipMask targets only local qubits.
+ */
+qreal realvec_calcExpecPauliProdLocal(Qureg qureg, enum pauliOpType* termCodes, qreal* flippedAmps)
 {
-    long long int index;
-    long long int stateVecSize;
+    long long int *signMasks;
+    int *phaseCodes;
+    long long int *flipMasks = getPauliTermMasks(termCodes, qureg.numQubitsRepresented, 1, &signMasks, &phaseCodes);
+    long long int flipMask = flipMasks[0];
+    long long int signMask = signMasks[0];
+    int phaseCode = phaseCodes[0];
+    free(flipMasks);
 
-    const long long int chunkSize=qureg.numAmpsPerChunk;
-    const long long int chunkId=qureg.chunkId;
+    if (phaseCode % 2 == 1)
+        return 0;
 
-    long long int mask = getQubitBitMask(controlQubits, numControlQubits);
+    long long int numAmps = qureg.numAmpsPerChunk;
+    long long int globalIndStart = qureg.chunkId*numAmps;
+    long long int localFlipMask = flipMask & (numAmps - 1);
+    long long int index;
+    qreal value = 0;
 
-    stateVecSize = qureg.numAmpsPerChunk;
     qreal *stateVecReal = qureg.stateVec.real;
-    qreal *stateVecImag = qureg.stateVec.imag;
 
 # ifdef _OPENMP
 # pragma omp parallel \
-    shared   (stateVecSize, stateVecReal,stateVecImag, mask ) \
-    private  (index)
+    shared    (stateVecReal, flippedAmps, numAmps, globalIndStart, localFlipMask, signMask) \
+    private   (index) \
+    reduction ( +:value )
 # endif
     {
 # ifdef _OPENMP
-# pragma omp for schedule (static)
+# pragma omp for schedule  (static)
 # endif
-        for (index=0; index<stateVecSize; index++) {
-            if (mask == (mask & (index+chunkId*chunkSize)) ){
-                stateVecReal [index] = - stateVecReal [index];
-                stateVecImag [index] = - stateVecImag [index];
-            }
+        for (index=0; index < numAmps; index++) {
+            qreal term = stateVecReal[index] * flippedAmps[index ^ localFlipMask];
+            value += (countOneBits((index + globalIndStart) & signMask) & 1)? - term : term;
         }
     }
+    return (phaseCode == 2)? - value : value;
 }
 
-/** Update the state vector to be consistent with measuring measureQubit=0 if outcome=0 and measureQubit=1
- *  if outcome=1.
- *  Performs an irreversible change to the state vector: it updates the vector according
- *  to the event that an outcome have been measured on the qubit indicated by measureQubit (where
- *  this label starts from 0, of course). It achieves this by setting all inconsistent
- *  amplitudes to 0 and
- *  then renormalising based on the total probability of measuring measureQubit=0 or 1 according to the
- *  value of outcome.
- *  In the local version, one or more blocks (with measureQubit=0 in the first half of the block and
- *  measureQubit=1 in the second half of the block) fit entirely into one chunk.
+/*
+ * fixed Hamming-weight (subspace) state-vector operations
  *
- *  @param[in,out] qureg object representing the set of qubits
- *  @param[in] measureQubit qubit to measure
- *  @param[in] totalProbability probability of qubit measureQubit being either zero or one
- *  @param[in] outcome to measure the probability of and set the state to -- either zero or one
+ * A subspace register of n qubits and Hamming weight k stores the C(n,k) amplitudes of the basis
+ * states with k bits set, in increasing order of their indices. The position (rank) of a state in
+ * that order is given by the combinatorial number system: the i-th lowest set bit, at position p,
+ * contributes C(p,i). Subspace registers are never distributed, so chunkId is always 0.
  */
-void statevec_collapseToKnownProbOutcomeLocal(Qureg qureg, int measureQubit, int outcome, qreal totalProbability)
+
+/* C(n,k) for n,k < 64, where C(n,k) = 0 for k > n */
+static long long int subspaceBinomials[64][64];
+
+static void setSubspaceBinomials(void) {
+    if (subspaceBinomials[0][0])
+        return;
+    for (int n=0; n<64; n++) {
+        subspaceBinomials[n][0] = 1;
+        for (int k=1; k<=n; k++)
+            subspaceBinomials[n][k] = subspaceBinomials[n-1][k-1] + subspaceBinomials[n-1][k];
+    }
+}
+
+/** Returns the position of basis state among those of the same Hamming weight, in increasing order */
+static inline long long int getSubspaceRank(long long int state, int numQubits) {
+    long long int rank = 0;
+    int i = 0;
+    for (int p=0; p < numQubits; p++)
+        if ((state >> p) & 1)
+            rank += subspaceBinomials[p][++i];
+    return rank;
+}
+
+/** Returns the basis state of the given rank among those of Hamming weight hammingWeight */
+static inline long long int getSubspaceState(long long int rank, int numQubits, int hammingWeight) {
+    long long int state = 0;
+    int p = numQubits;
+    for (int i=hammingWeight; i > 0; i--) {
+        // the highest remaining position p with C(p,i) <= rank
+        do p--; while (subspaceBinomials[p][i] > rank);
+        state |= 1LL << p;
+        rank -= subspaceBinomials[p][i];
+    }
+    return state;
+}
+
+static long long int getSubspaceDim(int numQubits, int hammingWeight) {
+    setSubspaceBinomials();
+    return subspaceBinomials[numQubits][hammingWeight];
+}
+
+void subspace_initClassicalState(Qureg qureg, long long int stateInd)
 {
-    // ----- sizes
-    long long int sizeBlock,                                  // size of blocks
-         sizeHalfBlock;                                       // size of blocks halved
-    // ----- indices
-    long long int thisBlock,                                  // current block
-         index;                                               // current index for first half block
-    // ----- measured probability
-    qreal   renorm;                                            // probability (returned) value
-    // ----- temp variables
-    long long int thisTask;                                   // task based approach for expose loop with small granularity
-    // (good for shared memory parallelism)
-    long long int numTasks=qureg.numAmpsPerChunk>>1;
+    statevec_initBlankState(qureg);
+    qureg.stateVec.real[getSubspaceRank(stateInd, qureg.numQubitsRepresented)] = 1.0;
+}
 
-    // ---------------------------------------------------------------- //
-    //            dimensions                                            //
-    // ---------------------------------------------------------------- //
-    sizeHalfBlock = 1LL << (measureQubit);                       // number of state vector elements to sum,
-    // and then the number to skip
-    sizeBlock     = 2LL * sizeHalfBlock;                         // size of blocks (pairs of measure and skip entries)
+Complex subspace_getAmp(Qureg qureg, long long int index)
+{
+    Complex amp = {.real=0, .imag=0};
+    if (countOneBits(index) != qureg.hammingWeight)
+        return amp;
+
+    long long int rank = getSubspaceRank(index, qureg.numQubitsRepresented);
+    amp.real = qureg.stateVec.real[rank];
+    amp.imag = qureg.stateVec.imag[rank];
+    return amp;
+}
+
+/** Multiplies every amplitude whose basis state has all bits of mask set by term */
+void subspace_phaseShiftByTerm(Qureg qureg, long long int mask, Complex term)
+{
+    const long long int numAmps = qureg.numAmpsPerChunk;
+    const int numQubits = qureg.numQubitsRepresented;
+    const int weight = qureg.hammingWeight;
+    const qreal cosAngle = term.real;
+    const qreal sinAngle = term.imag;
 
-    renorm=1/sqrt(totalProbability);
     qreal *stateVecReal = qureg.stateVec.real;
     qreal *stateVecImag = qureg.stateVec.imag;
-
+    qreal stateReal, stateImag;
+    long long int rank, state;
 
 # ifdef _OPENMP
 # pragma omp parallel \
-    shared    (numTasks,sizeBlock,sizeHalfBlock, stateVecReal,stateVecImag,renorm,outcome) \
-    private   (thisTask,thisBlock,index)
+    shared   (stateVecReal,stateVecImag, mask) \
+    private  (rank,state, stateReal,stateImag)
 # endif
     {
-        if (outcome==0){
-            // measure qubit is 0
 # ifdef _OPENMP
-# pragma omp for schedule  (static)
-# endif
-            for (thisTask=0; thisTask<numTasks; thisTask++) {
-                thisBlock = thisTask / sizeHalfBlock;
-                index     = thisBlock*sizeBlock + thisTask%sizeHalfBlock;
-                stateVecReal[index]=stateVecReal[index]*renorm;
-                stateVecImag[index]=stateVecImag[index]*renorm;
-
-                stateVecReal[index+sizeHalfBlock]=0;
-                stateVecImag[index+sizeHalfBlock]=0;
-            }
-        } else {
-            // measure qubit is 1
-# ifdef _OPENMP
-# pragma omp for schedule  (static)
+# pragma omp for schedule (static)
 # endif
-            for (thisTask=0; thisTask<numTasks; thisTask++) {
-                thisBlock = thisTask / sizeHalfBlock;
-                index     = thisBlock*sizeBlock + thisTask%sizeHalfBlock;
-                stateVecReal[index]=0;
-                stateVecImag[index]=0;
+        for (rank=0; rank<numAmps; rank++) {
+            state = getSubspaceState(rank, numQubits, weight);
+            if ((state & mask) != mask)
+                continue;
 
-                stateVecReal[index+sizeHalfBlock]=stateVecReal[index+sizeHalfBlock]*renorm;
-                stateVecImag[index+sizeHalfBlock]=stateVecImag[index+sizeHalfBlock]*renorm;
-            }
+            stateReal = stateVecReal[rank];
+            stateImag = stateVecImag[rank];
+            stateVecReal[rank] = cosAngle*stateReal - sinAngle*stateImag;
+            stateVecImag[rank] = sinAngle*stateReal + cosAngle*stateImag;
         }
     }
-
 }
 
-/** Renormalise parts of the state vector where measureQubit=0 or 1, based on the total probability of that qubit being
- *  in state 0 or 1.
- *  Measure in Zero performs an irreversible change to the state vector: it updates the vector according
- *  to the event that the value 'outcome' has been measured on the qubit indicated by measureQubit (where
- *  this label starts from 0, of course). It achieves this by setting all inconsistent amplitudes to 0 and
- *  then renormalising based on the total probability of measuring measureQubit=0 if outcome=0 and
- *  measureQubit=1 if outcome=1.
- *  In the distributed version, one block (with measureQubit=0 in the first half of the block and
- *  measureQubit=1 in the second half of the block) is spread over multiple chunks, meaning that each chunks performs
- *  only renormalisation or only setting amplitudes to 0. This function handles the renormalisation.
- *
- *  @param[in,out] qureg object representing the set of qubits
- *  @param[in] measureQubit qubit to measure
- *  @param[in] totalProbability probability of qubit measureQubit being zero
- */
-void statevec_collapseToKnownProbOutcomeDistributedRenorm (Qureg qureg, const int measureQubit, const qreal totalProbability)
+void subspace_multiRotateZ(Qureg qureg, long long int mask, qreal angle)
 {
-    // ----- temp variables
-    long long int thisTask;
-    long long int numTasks=qureg.numAmpsPerChunk;
-
-    qreal renorm=1/sqrt(totalProbability);
+    const long long int numAmps = qureg.numAmpsPerChunk;
+    const int numQubits = qureg.numQubitsRepresented;
+    const int weight = qureg.hammingWeight;
+    const qreal cosAngle = cos(angle/2.0);
+    const qreal sinAngle = sin(angle/2.0);
 
     qreal *stateVecReal = qureg.stateVec.real;
     qreal *stateVecImag = qureg.stateVec.imag;
+    qreal stateReal, stateImag;
+    long long int rank, state;
+    int fac;
 
 # ifdef _OPENMP
 # pragma omp parallel \
-    shared    (numTasks,stateVecReal,stateVecImag) \
-    private   (thisTask)
+    shared   (stateVecReal,stateVecImag, mask) \
+    private  (rank,state, fac, stateReal,stateImag)
 # endif
     {
 # ifdef _OPENMP
-# pragma omp for schedule  (static)
+# pragma omp for schedule (static)
 # endif
-        for (thisTask=0; thisTask<numTasks; thisTask++) {
-            stateVecReal[thisTask] = stateVecReal[thisTask]*renorm;
-            stateVecImag[thisTask] = stateVecImag[thisTask]*renorm;
+        for (rank=0; rank<numAmps; rank++) {
+            state = getSubspaceState(rank, numQubits, weight);
+
+            // odd-parity target qubits get fac = -1, effecting exp(-angle/2 i fac)
+            fac = (countOneBits(state & mask) & 1)? -1 : 1;
+            stateReal = stateVecReal[rank];
+            stateImag = stateVecImag[rank];
+            stateVecReal[rank] = cosAngle*stateReal + fac * sinAngle*stateImag;
+            stateVecImag[rank] = - fac * sinAngle*stateReal + cosAngle*stateImag;
         }
     }
 }
 
-/** Set all amplitudes in one chunk to 0.
- *  Measure in Zero performs an irreversible change to the state vector: it updates the vector according
- *  to the event that a zero have been measured on the qubit indicated by measureQubit (where
- *  this label starts from 0, of course). It achieves this by setting all inconsistent amplitudes to 0 and
- *  then renormalising based on the total probability of measuring measureQubit=0 or 1.
- *  In the distributed version, one block (with measureQubit=0 in the first half of the block and
- *  measureQubit=1 in the second half of the block) is spread over multiple chunks, meaning that each chunks performs
- *  only renormalisation or only setting amplitudes to 0. This function handles setting amplitudes to 0.
- *
- *  @param[in,out] qureg object representing the set of qubits
- *  @param[in] measureQubit qubit to measure
+/** Applies a number-conserving two-qubit gate, where q1 is the least significant qubit of u. 
+ * Basis states with q1,q2 = 00 or 11 are only rescaled, while each state with q1,q2 = 10 is mixed 
+ * with its partner (both bits flipped, so of the same Hamming weight) at a different rank. Every 
+ * pair is updated by the thread visiting its 10 member.
  */
-void statevec_collapseToOutcomeDistributedSetZero(Qureg qureg)
+void subspace_multiControlledTwoQubitUnitary(Qureg qureg, long long int ctrlMask, const int q1, const int q2, ComplexMatrix4 u)
 {
-    // ----- temp variables
-    long long int thisTask;
-    long long int numTasks=qureg.numAmpsPerChunk;
-
-    // ---------------------------------------------------------------- //
-    //            find probability                                      //
-    // ---------------------------------------------------------------- //
+    const long long int numAmps = qureg.numAmpsPerChunk;
+    const int numQubits = qureg.numQubitsRepresented;
+    const int weight = qureg.hammingWeight;
+    const long long int mask1 = 1LL << q1;
+    const long long int mask2 = 1LL << q2;
 
     qreal *stateVecReal = qureg.stateVec.real;
     qreal *stateVecImag = qureg.stateVec.imag;
+    qreal re1, im1, re2, im2;
+    long long int rank, state, partnerRank;
+    int ind;
 
 # ifdef _OPENMP
 # pragma omp parallel \
-    shared    (numTasks,stateVecReal,stateVecImag) \
-    private   (thisTask)
+    shared   (stateVecReal,stateVecImag, ctrlMask, u) \
+    private  (rank,state,partnerRank, ind, re1,im1,re2,im2)
 # endif
     {
 # ifdef _OPENMP
-# pragma omp for schedule  (static)
+# pragma omp for schedule (static)
 # endif
-        for (thisTask=0; thisTask<numTasks; thisTask++) {
-            stateVecReal[thisTask] = 0;
-            stateVecImag[thisTask] = 0;
+        for (rank=0; rank<numAmps; rank++) {
+            state = getSubspaceState(rank, numQubits, weight);
+            if ((state & ctrlMask) != ctrlMask)
+                continue;
+
+            ind = ((state & mask1)? 1 : 0) | ((state & mask2)? 2 : 0);
+            re1 = stateVecReal[rank];
+            im1 = stateVecImag[rank];
+
+            // 00 and 11 acquire only their diagonal element
+            if (ind == 0 || ind == 3) {
+                stateVecReal[rank] = u.real[ind][ind]*re1 - u.imag[ind][ind]*im1;
+                stateVecImag[rank] = u.real[ind][ind]*im1 + u.imag[ind][ind]*re1;
+                continue;
+            }
+            if (ind == 2)
+                continue;
+
+            partnerRank = getSubspaceRank(state ^ (mask1 | mask2), numQubits);
+            re2 = stateVecReal[partnerRank];
+            im2 = stateVecImag[partnerRank];
+
+            stateVecReal[rank] = u.real[1][1]*re1 - u.imag[1][1]*im1 + u.real[1][2]*re2 - u.imag[1][2]*im2;
+            stateVecImag[rank] = u.real[1][1]*im1 + u.imag[1][1]*re1 + u.real[1][2]*im2 + u.imag[1][2]*re2;
+            stateVecReal[partnerRank] = u.real[2][1]*re1 - u.imag[2][1]*im1 + u.real[2][2]*re2 - u.imag[2][2]*im2;
+            stateVecImag[partnerRank] = u.real[2][1]*im1 + u.imag[2][1]*re1 + u.real[2][2]*im2 + u.imag[2][2]*re2;
         }
     }
 }
 
-/** It is ensured that all amplitudes needing to be swapped are on this node.
- * This means that amplitudes for |a 0..0..> to |a 1..1..> all exist on this node
- * and each node has a different bit-string prefix "a". The prefix 'a' (and ergo,
- * the chunkID) don't enter the calculations for the offset of |a 0..1..> and
- * |a 1..0..> from |a 0..0..> and ergo are not featured below.
- */
-void statevec_swapQubitAmpsLocal(Qureg qureg, int qb1, int qb2) {
-
-    // can't use qureg.stateVec as a private OMP var
-    qreal *reVec = qureg.stateVec.real;
-    qreal *imVec = qureg.stateVec.imag;
+void subspace_swapQubitAmps(Qureg qureg, int qb1, int qb2)
+{
+    const long long int numAmps = qureg.numAmpsPerChunk;
+    const int numQubits = qureg.numQubitsRepresented;
+    const int weight = qureg.hammingWeight;
+    const long long int mask1 = 1LL << qb1;
+    const long long int mask2 = 1LL << qb2;
 
-    long long int numTasks = qureg.numAmpsPerChunk >> 2; // each iteration updates 2 amps and skips 2 amps
-    long long int thisTask;
-    long long int ind00, ind01, ind10;
-    qreal re01, re10;
-    qreal im01, im10;
+    qreal *stateVecReal = qureg.stateVec.real;
+    qreal *stateVecImag = qureg.stateVec.imag;
+    qreal re, im;
+    long long int rank, state, partnerRank;
 
 # ifdef _OPENMP
 # pragma omp parallel \
-    shared   (reVec,imVec,numTasks,qb1,qb2) \
-    private  (thisTask, ind00,ind01,ind10, re01,re10, im01,im10)
+    shared   (stateVecReal,stateVecImag) \
+    private  (rank,state,partnerRank, re,im)
 # endif
     {
 # ifdef _OPENMP
 # pragma omp for schedule (static)
 # endif
-        for (thisTask=0; thisTask<numTasks; thisTask++) {
-            // determine ind00 of |..0..0..>, |..0..1..> and |..1..0..>
-            ind00 = insertTwoZeroBits(thisTask, qb1, qb2);
-            ind01 = flipBit(ind00, qb1);
-            ind10 = flipBit(ind00, qb2);
+        for (rank=0; rank<numAmps; rank++) {
+            state = getSubspaceState(rank, numQubits, weight);
 
-            // extract statevec amplitudes
-            re01 = reVec[ind01]; im01 = imVec[ind01];
-            re10 = reVec[ind10]; im10 = imVec[ind10];
+            // each pair is swapped by its member with qb1 = 1 and qb2 = 0
+            if (!(state & mask1) || (state & mask2))
+                continue;
 
-            // swap 01 and 10 amps
-            reVec[ind01] = re10; reVec[ind10] = re01;
-            imVec[ind01] = im10; imVec[ind10] = im01;
+            partnerRank = getSubspaceRank(state ^ (mask1 | mask2), numQubits);
+            re = stateVecReal[rank];
+            im = stateVecImag[rank];
+            stateVecReal[rank] = stateVecReal[partnerRank];
+            stateVecImag[rank] = stateVecImag[partnerRank];
+            stateVecReal[partnerRank] = re;
+            stateVecImag[partnerRank] = im;
         }
     }
 }
 
-/** qureg.pairStateVec contains the entire set of amplitudes of the paired node
- * which includes the set of all amplitudes which need to be swapped between
- * |..0..1..> and |..1..0..>
- */
-void statevec_swapQubitAmpsDistributed(Qureg qureg, int pairRank, int qb1, int qb2) {
-
-    // can't use qureg.stateVec as a private OMP var
-    qreal *reVec = qureg.stateVec.real;
-    qreal *imVec = qureg.stateVec.imag;
-    qreal *rePairVec = qureg.pairStateVec.real;
-    qreal *imPairVec = qureg.pairStateVec.imag;
-
-    long long int numLocalAmps = qureg.numAmpsPerChunk;
-    long long int globalStartInd = qureg.chunkId * numLocalAmps;
-    long long int pairGlobalStartInd = pairRank * numLocalAmps;
+qreal subspace_calcProbOfOutcome(Qureg qureg, const int measureQubit, int outcome)
+{
+    const long long int numAmps = qureg.numAmpsPerChunk;
+    const int numQubits = qureg.numQubitsRepresented;
+    const int weight = qureg.hammingWeight;
 
-    long long int localInd, globalInd;
-    long long int pairLocalInd, pairGlobalInd;
+    qreal *stateVecReal = qureg.stateVec.real;
+    qreal *stateVecImag = qureg.stateVec.imag;
+    long long int rank, state;
+    qreal totalProbability = 0;
 
 # ifdef _OPENMP
 # pragma omp parallel \
-    shared   (reVec,imVec,rePairVec,imPairVec,numLocalAmps,globalStartInd,pairGlobalStartInd,qb1,qb2) \
-    private  (localInd,globalInd, pairLocalInd,pairGlobalInd)
+    shared    (stateVecReal,stateVecImag) \
+    private   (rank,state) \
+    reduction ( +:totalProbability )
 # endif
     {
 # ifdef _OPENMP
-# pragma omp for schedule (static)
+# pragma omp for schedule  (static)
 # endif
-        for (localInd=0; localInd < numLocalAmps; localInd++) {
+        for (rank=0; rank<numAmps; rank++) {
+            state = getSubspaceState(rank, numQubits, weight);
+            if (extractBit(measureQubit, state) == outcome)
+                totalProbability += stateVecReal[rank]*stateVecReal[rank] + stateVecImag[rank]*stateVecImag[rank];
+        }
+    }
+    return totalProbability;
+}
 
-            globalInd = globalStartInd + localInd;
-            if (isOddParity(globalInd, qb1, qb2)) {
+void subspace_collapseToKnownProbOutcome(Qureg qureg, const int measureQubit, int outcome, qreal totalProbability)
+{
+    const long long int numAmps = qureg.numAmpsPerChunk;
+    const int numQubits = qureg.numQubitsRepresented;
+    const int weight = qureg.hammingWeight;
+    const qreal renorm = 1/sqrt(totalProbability);
 
-                pairGlobalInd = flipBit(flipBit(globalInd, qb1), qb2);
-                pairLocalInd = pairGlobalInd - pairGlobalStartInd;
+    qreal *stateVecReal = qureg.stateVec.real;
+    qreal *stateVecImag = qureg.stateVec.imag;
+    long long int rank, state;
+    qreal fac;
 
-                reVec[localInd] = rePairVec[pairLocalInd];
-                imVec[localInd] = imPairVec[pairLocalInd];
-            }
+# ifdef _OPENMP
+# pragma omp parallel \
+    shared   (stateVecReal,stateVecImag) \
+    private  (rank,state,fac)
+# endif
+    {
+# ifdef _OPENMP
+# pragma omp for schedule (static)
+# endif
+        for (rank=0; rank<numAmps; rank++) {
+            state = getSubspaceState(rank, numQubits, weight);
+            fac = (extractBit(measureQubit, state) == outcome)? renorm : 0;
+            stateVecReal[rank] *= fac;
+            stateVecImag[rank] *= fac;
         }
     }
 }
 
-void statevec_setWeightedQureg(Complex fac1, Qureg qureg1, Complex fac2, Qureg qureg2, Complex facOut, Qureg out) {
+/** Each Pauli product maps basis state |x> to i^numY (-1)^|x & signMask| |x ^ flipMask>, which 
+ * remains in the subspace only when the flipped bits of x hold as many ones as zeros. Terms 
+ * flipping an odd number of qubits therefore vanish, and the others are evaluated amplitude-wise.
+ */
+qreal subspace_calcExpecPauliSum(Qureg qureg, enum pauliOpType* allCodes, qreal* termCoeffs, int numSumTerms)
+{
+    const long long int numAmps = qureg.numAmpsPerChunk;
+    const int numQubits = qureg.numQubitsRepresented;
+    const int weight = qureg.hammingWeight;
 
-    long long int numAmps = qureg1.numAmpsPerChunk;
+    long long int *signMasks;
+    int *phaseCodes;
+    long long int *flipMasks = getPauliTermMasks(allCodes, numQubits, numSumTerms, &signMasks, &phaseCodes);
 
-    qreal *vecRe1 = qureg1.stateVec.real;
-    qreal *vecIm1 = qureg1.stateVec.imag;
-    qreal *vecRe2 = qureg2.stateVec.real;
-    qreal *vecIm2 = qureg2.stateVec.imag;
-    qreal *vecReOut = out.stateVec.real;
-    qreal *vecImOut = out.stateVec.imag;
+    qreal *stateVecReal = qureg.stateVec.real;
+    qreal *stateVecImag = qureg.stateVec.imag;
+    long long int rank, state, flipped, flippedRank;
+    qreal value = 0;
 
-    qreal facRe1 = fac1.real;
-    qreal facIm1 = fac1.imag;
-    qreal facRe2 = fac2.real;
-    qreal facIm2 = fac2.imag;
-    qreal facReOut = facOut.real;
-    qreal facImOut = facOut.imag;
+    for (int t=0; t < numSumTerms; t++) {
+        long long int flipMask = flipMasks[t];
+        long long int signMask = signMasks[t];
+        int phaseCode = phaseCodes[t];
+        qreal termValue = 0;
 
-    qreal re1,im1, re2,im2, reOut,imOut;
-    long long int index;
+        if (countOneBits(flipMask) & 1)
+            continue;
 
 # ifdef _OPENMP
 # pragma omp parallel \
-    shared    (vecRe1,vecIm1, vecRe2,vecIm2, vecReOut,vecImOut, facRe1,facIm1,facRe2,facIm2, numAmps) \
-    private   (index, re1,im1, re2,im2, reOut,imOut)
+    shared    (stateVecReal,stateVecImag, flipMask,signMask,phaseCode) \
+    private   (rank,state,flipped,flippedRank) \
+    reduction ( +:termValue )
 # endif
-    {
+        {
 # ifdef _OPENMP
 # pragma omp for schedule  (static)
 # endif
-        for (index=0LL; index<numAmps; index++) {
-            re1 = vecRe1[index]; im1 = vecIm1[index];
-            re2 = vecRe2[index]; im2 = vecIm2[index];
-            reOut = vecReOut[index];
-            imOut = vecImOut[index];
-
-            vecReOut[index] = (facReOut*reOut - facImOut*imOut) + (facRe1*re1 - facIm1*im1) + (facRe2*re2 - facIm2*im2);
-            vecImOut[index] = (facReOut*imOut + facImOut*reOut) + (facRe1*im1 + facIm1*re1) + (facRe2*im2 + facIm2*re2);
+            for (rank=0; rank<numAmps; rank++) {
+                state = getSubspaceState(rank, numQubits, weight);
+                flipped = state ^ flipMask;
+                if (countOneBits(flipped) != weight)
+                    continue;
+
+                // conj(amp[flipped]) * amp[state], phased by the Pauli product
+                flippedRank = (flipMask)? getSubspaceRank(flipped, numQubits) : rank;
+                qreal re = stateVecReal[flippedRank]*stateVecReal[rank] + stateVecImag[flippedRank]*stateVecImag[rank];
+                qreal im = stateVecReal[flippedRank]*stateVecImag[rank] - stateVecImag[flippedRank]*stateVecReal[rank];
+                qreal elem = getRealOfPhasedElem(phaseCode, re, im);
+                termValue += (countOneBits(state & signMask) & 1)? - elem : elem;
+            }
         }
+        value += termCoeffs[t] * termValue;
     }
+    free(flipMasks);
+    return value;
 }
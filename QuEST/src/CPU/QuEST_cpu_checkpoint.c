@@ -0,0 +1,347 @@
+// Distributed under MIT licence. See https://github.com/QuEST-Kit/QuEST/blob/master/LICENCE.txt for details
+
+/** @file
+ * Access to the checkpoint files of writeQuregCheckpoint() and readQuregCheckpoint(), shared by the local
+ * and distributed backends. Files are read and written with positional I/O, divided between the threads
+ * into large contiguous pieces. A checkpoint is first written beside its destination and is only renamed
+ * over it once flushed, so a previous checkpoint survives an interrupted write.
+ *
+ * Checksums are sums of a hash of every component and its global index, so that each thread and node
+ * can checksum its own amplitudes, and their sums combined in any order.
+ *
+ * Checkpoints begun by startQuregCheckpoint() are instead written (and checksummed) by a single
+ * background thread per register, from a snapshot of the register's amplitudes taken by
+ * snapshotAmpArray(), so that the register can be modified meanwhile. The header is written, and the
+ * file renamed, once the thread is joined by finishQuregCheckpoint().
+ */
+
+// exposes POSIX positional I/O under strict C99
+# define _XOPEN_SOURCE 700
+
+# include "QuEST.h"
+# include "QuEST_precision.h"
+# include "QuEST_internal.h"
+
+# include "QuEST_cpu_internal.h"
+
+# include <stdio.h>
+# include <stdlib.h>
+# include <stdint.h>
+# include <string.h>
+
+# ifdef _OPENMP
+# include <omp.h>
+# endif
+
+// the number of bytes each thread reads or writes per call, which are contiguous in the file
+# define CHECKPOINT_PIECE_BYTES (1LL << 26)
+
+// only the first 10 bytes of an x87 long double are significant, and the remainder is padding
+# if QuEST_PREC==4 && (defined(__x86_64__) || defined(__i386__))
+    # define NUM_CHECKSUM_BYTES 10
+# else
+    # define NUM_CHECKSUM_BYTES sizeof(qreal)
+# endif
+
+static unsigned long long int hashChecksumWord(uint64_t word) {
+    word = (word ^ (word >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    word = (word ^ (word >> 27)) * 0x94D049BB133111EBULL;
+    return word ^ (word >> 31);
+}
+
+static unsigned long long int hashCheckpointAmp(qreal* amp, long long int globalIndex) {
+    uint64_t words[2] = {0, 0};
+    memcpy(words, amp, NUM_CHECKSUM_BYTES);
+    return hashChecksumWord(words[0] + globalIndex * 0x9E3779B97F4A7C15ULL) ^ hashChecksumWord(words[1]);
+}
+
+unsigned long long int calcCheckpointChecksum(qreal* arr, long long int numAmps, long long int firstIndex) {
+
+    unsigned long long int checksum = 0;
+    long long int index;
+
+# ifdef _OPENMP
+# pragma omp parallel \
+    shared   (arr, numAmps, firstIndex) \
+    private  (index) \
+    reduction ( +:checksum )
+# endif
+    {
+# ifdef _OPENMP
+# pragma omp for schedule (static)
+# endif
+        for (index=0; index<numAmps; index++)
+            checksum += hashCheckpointAmp(&arr[index], firstIndex + index);
+    }
+    return checksum;
+}
+
+char* getTempCheckpointName(char* filename) {
+    char* tempName = malloc(strlen(filename) + sizeof ".tmp");
+    if (tempName != NULL)
+        sprintf(tempName, "%s.tmp", filename);
+    return tempName;
+}
+
+# if defined(_WIN32) && ! defined(__MINGW32__)
+
+/* checkpoints rely upon POSIX positional I/O, so are unavailable on Windows */
+
+int createCheckpointFile(char* filename, long long int numBytes) {
+    return -1;
+}
+
+int commitCheckpointFile(int fd, char* filename, int isComplete) {
+    return 0;
+}
+
+int openCheckpointFile(char* filename) {
+    return -1;
+}
+
+void closeCheckpointFile(int fd) {
+}
+
+int writeCheckpointBytes(int fd, void* buffer, long long int numBytes, long long int offset) {
+    return 0;
+}
+
+int readCheckpointBytes(int fd, void* buffer, long long int numBytes, long long int offset) {
+    return 0;
+}
+
+int openTempCheckpointFile(char* filename) {
+    return -1;
+}
+
+int syncCheckpointFile(int fd) {
+    return 0;
+}
+
+int startCheckpointWriter(Qureg qureg, CheckpointHeader header, int fd, char* filename) {
+    return 0;
+}
+
+int finishCheckpointWriter(Qureg qureg, CheckpointWrite* write) {
+    return 0;
+}
+
+# else
+
+# include <fcntl.h>
+# include <unistd.h>
+# include <pthread.h>
+
+int createCheckpointFile(char* filename, long long int numBytes) {
+    char* tempName = getTempCheckpointName(filename);
+    if (tempName == NULL)
+        return -1;
+
+    int fd = open(tempName, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    free(tempName);
+    if (fd >= 0 && ftruncate(fd, numBytes) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+int openTempCheckpointFile(char* filename) {
+    char* tempName = getTempCheckpointName(filename);
+    if (tempName == NULL)
+        return -1;
+
+    int fd = open(tempName, O_WRONLY);
+    free(tempName);
+    return fd;
+}
+
+int syncCheckpointFile(int fd) {
+    return fsync(fd) == 0;
+}
+
+int commitCheckpointFile(int fd, char* filename, int isComplete) {
+    char* tempName = getTempCheckpointName(filename);
+    int success = isComplete && (tempName != NULL) && syncCheckpointFile(fd);
+    success = (close(fd) == 0) && success;
+    if (success)
+        success = (rename(tempName, filename) == 0);
+    else if (tempName != NULL)
+        unlink(tempName);
+    free(tempName);
+    return success;
+}
+
+int openCheckpointFile(char* filename) {
+    return open(filename, O_RDONLY);
+}
+
+void closeCheckpointFile(int fd) {
+    close(fd);
+}
+
+/** reads (if isRead) or writes numBytes of buffer at the given offset of the file, returning whether
+ * they were all transferred
+ */
+static int transferCheckpointPiece(int fd, char* buffer, long long int numBytes, long long int offset, int isRead) {
+
+    // a single call may transfer fewer bytes than requested
+    long long int numTransferred = 0;
+    while (numTransferred < numBytes) {
+        ssize_t numDone = (isRead)?
+            pread(fd, buffer + numTransferred, numBytes - numTransferred, offset + numTransferred) :
+            pwrite(fd, buffer + numTransferred, numBytes - numTransferred, offset + numTransferred);
+        if (numDone <= 0)
+            return 0;
+        numTransferred += numDone;
+    }
+    return 1;
+}
+
+/** reads (if isRead) or writes numBytes of buffer at the given offset of the file, in pieces divided
+ * between the threads, returning whether every piece was entirely transferred
+ */
+static int transferCheckpointBytes(int fd, char* buffer, long long int numBytes, long long int offset, int isRead) {
+
+    long long int numPieces = (numBytes + CHECKPOINT_PIECE_BYTES - 1) / CHECKPOINT_PIECE_BYTES;
+    long long int piece, pieceStart, pieceSize;
+    int numFailed = 0;
+
+# ifdef _OPENMP
+# pragma omp parallel \
+    shared   (fd, buffer, numBytes, offset, isRead, numPieces) \
+    private  (piece, pieceStart, pieceSize) \
+    reduction ( +:numFailed )
+# endif
+    {
+# ifdef _OPENMP
+# pragma omp for schedule (dynamic)
+# endif
+        for (piece=0; piece<numPieces; piece++) {
+            pieceStart = piece * CHECKPOINT_PIECE_BYTES;
+            pieceSize = (pieceStart + CHECKPOINT_PIECE_BYTES < numBytes)? CHECKPOINT_PIECE_BYTES : numBytes - pieceStart;
+            if (!transferCheckpointPiece(fd, buffer + pieceStart, pieceSize, offset + pieceStart, isRead))
+                numFailed++;
+        }
+    }
+    return numFailed == 0;
+}
+
+int writeCheckpointBytes(int fd, void* buffer, long long int numBytes, long long int offset) {
+    return transferCheckpointBytes(fd, buffer, numBytes, offset, 0);
+}
+
+int readCheckpointBytes(int fd, void* buffer, long long int numBytes, long long int offset) {
+    return transferCheckpointBytes(fd, buffer, numBytes, offset, 1);
+}
+
+/* A checkpoint being written by a background thread, identified by its register's stateVec.real */
+typedef struct {
+    qreal* quregKey;
+    CheckpointWrite write;
+    pthread_t thread;
+    int isThreaded;
+    int isSnapshot;
+    qreal* arrs[2];
+    int numArrs;
+    long long int numAmps;
+    long long int firstIndex;
+    long long int offsets[2];
+} PendingCheckpoint;
+
+static PendingCheckpoint** pendingCheckpoints = NULL;
+static int numPendingCheckpoints = 0;
+
+/** writes and checksums the amplitudes of a pending checkpoint, piece by piece, with only the calling
+ * thread (so as not to compete with the simulation for more than one core)
+ */
+static void* writePendingCheckpoint(void* arg) {
+
+    PendingCheckpoint* ckp = arg;
+    long long int piece = CHECKPOINT_PIECE_BYTES / sizeof(qreal);
+    unsigned long long int checksums[2] = {0, 0};
+    int success = 1;
+
+    for (int a=0; a < ckp->numArrs && success; a++) {
+        for (long long int start=0; start < ckp->numAmps && success; start += piece) {
+            long long int end = (start + piece < ckp->numAmps)? start + piece : ckp->numAmps;
+            for (long long int index=start; index<end; index++)
+                checksums[a] += hashCheckpointAmp(&ckp->arrs[a][index], ckp->firstIndex + index);
+            success = transferCheckpointPiece(ckp->write.fd, (char*) &ckp->arrs[a][start],
+                (end - start) * sizeof(qreal), ckp->offsets[a] + start * sizeof(qreal), 0);
+        }
+    }
+    ckp->write.header.realChecksum = checksums[0];
+    ckp->write.header.imagChecksum = checksums[1];
+    ckp->write.isWritten = success;
+    return NULL;
+}
+
+int startCheckpointWriter(Qureg qureg, CheckpointHeader header, int fd, char* filename) {
+
+    PendingCheckpoint* ckp = malloc(sizeof *ckp);
+    char* name = malloc(strlen(filename) + 1);
+    PendingCheckpoint** pending = realloc(pendingCheckpoints, (numPendingCheckpoints+1) * sizeof *pending);
+    if (pending != NULL)
+        pendingCheckpoints = pending;
+    if (ckp == NULL || name == NULL || pending == NULL) {
+        free(ckp);
+        free(name);
+        return 0;
+    }
+    strcpy(name, filename);
+
+    ckp->quregKey = qureg.stateVec.real;
+    ckp->write = (CheckpointWrite) {.header=header, .filename=name, .fd=fd, .isWritten=0};
+    ckp->numArrs = (qureg.isReal)? 1 : 2;
+    ckp->numAmps = qureg.numAmpsPerChunk;
+    ckp->firstIndex = qureg.chunkId * qureg.numAmpsPerChunk;
+    ckp->offsets[0] = CHECKPOINT_DATA_OFFSET + ckp->firstIndex * sizeof(qreal);
+    ckp->offsets[1] = ckp->offsets[0] + header.numAmps * sizeof(qreal);
+
+    // out-of-core registers are not snapshot (which would copy them into memory), so are written immediately
+    size_t arrSize = qureg.numAmpsPerChunk * sizeof(qreal);
+    qreal* quregArrs[2] = {qureg.stateVec.real, qureg.stateVec.imag};
+    ckp->isSnapshot = !qureg.isOutOfCore;
+    for (int a=0; a < ckp->numArrs; a++) {
+        ckp->arrs[a] = (ckp->isSnapshot)? snapshotAmpArray(quregArrs[a], arrSize) : NULL;
+        ckp->isSnapshot = ckp->isSnapshot && (ckp->arrs[a] != NULL);
+    }
+    if (!ckp->isSnapshot) {
+        for (int a=0; a < ckp->numArrs; a++) {
+            freeAmpArraySnapshot(ckp->arrs[a], arrSize);
+            ckp->arrs[a] = quregArrs[a];
+        }
+    }
+
+    ckp->isThreaded = ckp->isSnapshot && (pthread_create(&ckp->thread, NULL, writePendingCheckpoint, ckp) == 0);
+    if (!ckp->isThreaded)
+        writePendingCheckpoint(ckp);
+
+    pendingCheckpoints[numPendingCheckpoints++] = ckp;
+    return 1;
+}
+
+int finishCheckpointWriter(Qureg qureg, CheckpointWrite* write) {
+
+    int i = 0;
+    while (i < numPendingCheckpoints && pendingCheckpoints[i]->quregKey != qureg.stateVec.real)
+        i++;
+    if (i == numPendingCheckpoints)
+        return 0;
+
+    PendingCheckpoint* ckp = pendingCheckpoints[i];
+    pendingCheckpoints[i] = pendingCheckpoints[--numPendingCheckpoints];
+
+    if (ckp->isThreaded)
+        pthread_join(ckp->thread, NULL);
+    if (ckp->isSnapshot)
+        for (int a=0; a < ckp->numArrs; a++)
+            freeAmpArraySnapshot(ckp->arrs[a], ckp->numAmps * sizeof(qreal));
+
+    *write = ckp->write;
+    free(ckp);
+    return 1;
+}
+
+# endif
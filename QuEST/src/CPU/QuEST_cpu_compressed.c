@@ -0,0 +1,633 @@
+// Distributed under MIT licence. See https://github.com/QuEST-Kit/QuEST/blob/master/LICENCE.txt for details
+
+/** @file
+ * Storage of the amplitudes of compressed state-vectors (see createCompressedQureg()). The local
+ * amplitudes are divided into blocks of 2^COMPRESSED_BLOCK_QUBITS, the components of which are
+ * quantised to signed integers relative to the largest component of the block; blocks which are
+ * entirely zero are not stored. Gates are applied by decompressing the group of blocks upon which
+ * they act into a thread-private buffer, treating that buffer as an ordinary (uncompressed) register
+ * upon which the usual local kernels act, and recompressing it.
+ *
+ * Reduced-precision registers (see createReducedPrecisionQureg()) reuse these blocks, but store each
+ * component relative to the block's largest as a float, IEEE half or bfloat16, so that all arithmetic
+ * happens in qreal upon the decompressed buffers.
+ */
+
+# include "QuEST.h"
+# include "QuEST_precision.h"
+# include "QuEST_internal.h"
+
+# include "QuEST_cpu_internal.h"
+
+# include <math.h>
+# include <stdio.h>
+# include <stdlib.h>
+# include <stdint.h>
+# include <string.h>
+
+# ifdef _OPENMP
+# include <omp.h>
+# endif
+
+# ifdef __F16C__
+# include <immintrin.h>
+# endif
+
+/* software conversions between float and IEEE half precision, rounding to nearest even */
+
+static float halfToFloat(uint16_t h) {
+    uint32_t sign = (uint32_t) (h & 0x8000) << 16;
+    uint32_t exp = (h >> 10) & 0x1F;
+    uint32_t mant = h & 0x3FF;
+    uint32_t bits;
+
+    if (exp == 0x1F)
+        bits = sign | 0x7F800000 | (mant << 13);
+    else if (exp != 0)
+        bits = sign | ((exp + 112) << 23) | (mant << 13);
+    else if (mant == 0)
+        bits = sign;
+    else {
+        // subnormal halves are normal floats
+        exp = 113;
+        while (!(mant & 0x400)) {
+            mant <<= 1;
+            exp--;
+        }
+        bits = sign | (exp << 23) | ((mant & 0x3FF) << 13);
+    }
+    float f;
+    memcpy(&f, &bits, sizeof f);
+    return f;
+}
+
+static uint16_t floatToHalf(float f) {
+    uint32_t bits;
+    memcpy(&bits, &f, sizeof bits);
+    uint16_t sign = (bits >> 16) & 0x8000;
+    int exp = (int) ((bits >> 23) & 0xFF) - 112;
+    uint32_t mant = bits & 0x7FFFFF;
+
+    if (exp >= 0x1F)
+        return sign | 0x7C00 | ((exp == 0x8F && mant)? 0x200 : 0);
+    if (exp <= 0) {
+        if (exp < -10)
+            return sign;
+        // shift the (now explicit) leading bit into the subnormal mantissa
+        mant |= 0x800000;
+        int shift = 14 - exp;
+        uint32_t half = mant >> shift;
+        uint32_t rem = mant & ((1u << shift) - 1);
+        uint32_t mid = 1u << (shift - 1);
+        if (rem > mid || (rem == mid && (half & 1)))
+            half++;
+        return sign | half;
+    }
+    // a carry out of the mantissa correctly increments the exponent
+    uint32_t half = ((uint32_t) exp << 10) | (mant >> 13);
+    uint32_t rem = mant & 0x1FFF;
+    if (rem > 0x1000 || (rem == 0x1000 && (half & 1)))
+        half++;
+    return sign | half;
+}
+
+/* bfloat16 is the upper half of a float */
+
+static float bfloat16ToFloat(uint16_t b) {
+    uint32_t bits = (uint32_t) b << 16;
+    float f;
+    memcpy(&f, &bits, sizeof f);
+    return f;
+}
+
+static uint16_t floatToBfloat16(float f) {
+    uint32_t bits;
+    memcpy(&bits, &f, sizeof bits);
+    bits += 0x7FFF + ((bits >> 16) & 1);
+    return bits >> 16;
+}
+
+/** overwrites dest with scale times the numComps floating-point components at src */
+static void decodeFloatComps(int storage, void* src, qreal scale, qreal* dest, long long int numComps) {
+
+    long long int i = 0;
+    switch (storage) {
+        case STORAGE_FLOAT:
+            for (; i<numComps; i++)
+                dest[i] = scale * ((float*) src)[i];
+            break;
+        case STORAGE_HALF:
+# ifdef __F16C__
+            for (; i+8<=numComps; i+=8) {
+                float f[8];
+                _mm256_storeu_ps(f, _mm256_cvtph_ps(_mm_loadu_si128((__m128i*) ((uint16_t*) src + i))));
+                for (int j=0; j<8; j++)
+                    dest[i+j] = scale * f[j];
+            }
+# endif
+            for (; i<numComps; i++)
+                dest[i] = scale * halfToFloat(((uint16_t*) src)[i]);
+            break;
+        case STORAGE_BFLOAT16:
+            for (; i<numComps; i++)
+                dest[i] = scale * bfloat16ToFloat(((uint16_t*) src)[i]);
+            break;
+    }
+}
+
+/** stores the numComps components at src, divided by scale, in the given floating-point format
+ * at dest, returning the squared 2-norm of the resulting rounding error
+ */
+static qreal encodeFloatComps(int storage, qreal* src, qreal scale, void* dest, long long int numComps) {
+
+    qreal errSq = 0;
+    qreal err;
+    long long int i = 0;
+    switch (storage) {
+        case STORAGE_FLOAT:
+            for (; i<numComps; i++) {
+                ((float*) dest)[i] = (float) (src[i] / scale);
+                err = src[i] - scale * ((float*) dest)[i];
+                errSq += err*err;
+            }
+            break;
+        case STORAGE_HALF:
+# ifdef __F16C__
+            for (; i+8<=numComps; i+=8) {
+                float f[8];
+                for (int j=0; j<8; j++)
+                    f[j] = (float) (src[i+j] / scale);
+                __m128i h = _mm256_cvtps_ph(_mm256_loadu_ps(f), _MM_FROUND_TO_NEAREST_INT);
+                _mm_storeu_si128((__m128i*) ((uint16_t*) dest + i), h);
+                _mm256_storeu_ps(f, _mm256_cvtph_ps(h));
+                for (int j=0; j<8; j++) {
+                    err = src[i+j] - scale * f[j];
+                    errSq += err*err;
+                }
+            }
+# endif
+            for (; i<numComps; i++) {
+                ((uint16_t*) dest)[i] = floatToHalf((float) (src[i] / scale));
+                err = src[i] - scale * halfToFloat(((uint16_t*) dest)[i]);
+                errSq += err*err;
+            }
+            break;
+        case STORAGE_BFLOAT16:
+            for (; i<numComps; i++) {
+                ((uint16_t*) dest)[i] = floatToBfloat16((float) (src[i] / scale));
+                err = src[i] - scale * bfloat16ToFloat(((uint16_t*) dest)[i]);
+                errSq += err*err;
+            }
+            break;
+    }
+    return errSq;
+}
+
+static size_t getCompressedBlockSize(CompressedAmps* amps) {
+    size_t numComps = 2 * (1LL << amps->numBlockQubits);
+    return (amps->numBits == 0)? numComps * sizeof(qreal) : numComps * (amps->numBits / 8);
+}
+
+/** overwrites re and im with the amplitudes of the given block */
+static void decompressBlock(CompressedAmps* amps, long long int blockInd, qreal* re, qreal* im) {
+
+    long long int blockSize = 1LL << amps->numBlockQubits;
+    void* block = amps->blocks[blockInd];
+    if (block == NULL) {
+        memset(re, 0, blockSize * sizeof *re);
+        memset(im, 0, blockSize * sizeof *im);
+        return;
+    }
+
+    if (amps->numBits == 0) {
+        memcpy(re, block, blockSize * sizeof *re);
+        memcpy(im, (qreal*) block + blockSize, blockSize * sizeof *im);
+        return;
+    }
+    if (amps->floatStorage >= 0) {
+        qreal scale = amps->blockScales[blockInd];
+        decodeFloatComps(amps->floatStorage, block, scale, re, blockSize);
+        decodeFloatComps(amps->floatStorage, (char*) block + blockSize * (amps->numBits / 8), scale, im, blockSize);
+        return;
+    }
+
+    qreal unit = amps->blockScales[blockInd] / ((1LL << (amps->numBits - 1)) - 1);
+    long long int i;
+    switch (amps->numBits) {
+        case 8:
+            for (i=0; i<blockSize; i++) {
+                re[i] = unit * ((int8_t*) block)[i];
+                im[i] = unit * ((int8_t*) block)[blockSize + i];
+            }
+            break;
+        case 16:
+            for (i=0; i<blockSize; i++) {
+                re[i] = unit * ((int16_t*) block)[i];
+                im[i] = unit * ((int16_t*) block)[blockSize + i];
+            }
+            break;
+        case 32:
+            for (i=0; i<blockSize; i++) {
+                re[i] = unit * ((int32_t*) block)[i];
+                im[i] = unit * ((int32_t*) block)[blockSize + i];
+            }
+            break;
+    }
+}
+
+/** stores the amplitudes re and im as the given block, returning the squared 2-norm of the
+ * resulting rounding error
+ */
+static qreal compressBlock(CompressedAmps* amps, long long int blockInd, qreal* re, qreal* im) {
+
+    long long int blockSize = 1LL << amps->numBlockQubits;
+    long long int i;
+
+    qreal scale = 0;
+    for (i=0; i<blockSize; i++) {
+        if (absReal(re[i]) > scale)
+            scale = absReal(re[i]);
+        if (absReal(im[i]) > scale)
+            scale = absReal(im[i]);
+    }
+
+    // zero blocks are freed, rather than stored
+    if (scale == 0) {
+        free(amps->blocks[blockInd]);
+        amps->blocks[blockInd] = NULL;
+        amps->blockScales[blockInd] = 0;
+        return 0;
+    }
+
+    if (amps->blocks[blockInd] == NULL) {
+        amps->blocks[blockInd] = malloc(getCompressedBlockSize(amps));
+        if (amps->blocks[blockInd] == NULL) {
+            printf("Could not allocate memory!");
+            exit (EXIT_FAILURE);
+        }
+    }
+    void* block = amps->blocks[blockInd];
+    amps->blockScales[blockInd] = scale;
+
+    if (amps->numBits == 0) {
+        memcpy(block, re, blockSize * sizeof *re);
+        memcpy((qreal*) block + blockSize, im, blockSize * sizeof *im);
+        return 0;
+    }
+    if (amps->floatStorage >= 0)
+        return encodeFloatComps(amps->floatStorage, re, scale, block, blockSize)
+            + encodeFloatComps(amps->floatStorage, im, scale, (char*) block + blockSize * (amps->numBits / 8), blockSize);
+
+    long long int maxInt = (1LL << (amps->numBits - 1)) - 1;
+    qreal unit = scale / maxInt;
+    qreal errSq = 0;
+    long long int reInt, imInt;
+    for (i=0; i<blockSize; i++) {
+        reInt = llround(re[i] / unit);
+        imInt = llround(im[i] / unit);
+        errSq += (re[i] - reInt*unit)*(re[i] - reInt*unit) + (im[i] - imInt*unit)*(im[i] - imInt*unit);
+
+        switch (amps->numBits) {
+            case 8:
+                ((int8_t*) block)[i] = (int8_t) reInt;
+                ((int8_t*) block)[blockSize + i] = (int8_t) imInt;
+                break;
+            case 16:
+                ((int16_t*) block)[i] = (int16_t) reInt;
+                ((int16_t*) block)[blockSize + i] = (int16_t) imInt;
+                break;
+            case 32:
+                ((int32_t*) block)[i] = (int32_t) reInt;
+                ((int32_t*) block)[blockSize + i] = (int32_t) imInt;
+                break;
+        }
+    }
+    return errSq;
+}
+
+void compressed_createQureg(Qureg *qureg, int numQubits, int numBits, int floatStorage, QuESTEnv env) {
+
+    CompressedAmps* amps = malloc(sizeof *amps);
+    if (amps == NULL) {
+        printf("Could not allocate memory!");
+        exit (EXIT_FAILURE);
+    }
+    amps->numBits = numBits;
+    amps->floatStorage = floatStorage;
+    amps->numBlockQubits = (numQubits < COMPRESSED_BLOCK_QUBITS)? numQubits : COMPRESSED_BLOCK_QUBITS;
+    amps->numBlocks = 1LL << (numQubits - amps->numBlockQubits);
+    amps->blocks = calloc(amps->numBlocks, sizeof *(amps->blocks));
+    amps->blockScales = calloc(amps->numBlocks, sizeof *(amps->blockScales));
+    amps->errorNorm = 0;
+    if (amps->blocks == NULL || amps->blockScales == NULL) {
+        printf("Could not allocate memory!");
+        exit (EXIT_FAILURE);
+    }
+
+    qureg->stateVec.real = NULL;
+    qureg->stateVec.imag = NULL;
+    qureg->pairStateVec.real = NULL;
+    qureg->pairStateVec.imag = NULL;
+    qureg->compressedAmps = amps;
+
+    qureg->numQubitsInStateVec = numQubits;
+    qureg->numAmpsTotal = 1LL << numQubits;
+    qureg->numAmpsPerChunk = 1LL << numQubits;
+    qureg->chunkId = env.rank;
+    qureg->numChunks = env.numRanks;
+    qureg->isDensityMatrix = 0;
+    qureg->isPacked = 0;
+    qureg->isReal = 0;
+    qureg->isSubspace = 0;
+    qureg->hammingWeight = 0;
+    qureg->isOutOfCore = 0;
+    qureg->isCompressed = 1;
+}
+
+void compressed_destroyQureg(Qureg qureg) {
+
+    CompressedAmps* amps = qureg.compressedAmps;
+    for (long long int b=0; b<amps->numBlocks; b++)
+        free(amps->blocks[b]);
+    free(amps->blocks);
+    free(amps->blockScales);
+    free(amps);
+}
+
+void compressed_initClassicalState(Qureg qureg, long long int stateInd) {
+
+    CompressedAmps* amps = qureg.compressedAmps;
+    for (long long int b=0; b<amps->numBlocks; b++) {
+        free(amps->blocks[b]);
+        amps->blocks[b] = NULL;
+        amps->blockScales[b] = 0;
+    }
+    amps->errorNorm = 0;
+
+    // a single unit amplitude is stored exactly at any precision
+    long long int blockSize = 1LL << amps->numBlockQubits;
+    qreal* re = calloc(blockSize, sizeof *re);
+    qreal* im = calloc(blockSize, sizeof *im);
+    if (re == NULL || im == NULL) {
+        printf("Could not allocate memory!");
+        exit (EXIT_FAILURE);
+    }
+    re[stateInd % blockSize] = 1;
+    compressBlock(amps, stateInd / blockSize, re, im);
+    free(re);
+    free(im);
+}
+
+Complex compressed_getAmp(Qureg qureg, long long int index) {
+
+    CompressedAmps* amps = qureg.compressedAmps;
+    long long int blockSize = 1LL << amps->numBlockQubits;
+    long long int b = index / blockSize;
+    long long int i = index % blockSize;
+    void* block = amps->blocks[b];
+
+    Complex amp = {.real=0, .imag=0};
+    if (block == NULL)
+        return amp;
+    if (amps->numBits == 0) {
+        amp.real = ((qreal*) block)[i];
+        amp.imag = ((qreal*) block)[blockSize + i];
+        return amp;
+    }
+    if (amps->floatStorage >= 0) {
+        qreal scale = amps->blockScales[b];
+        decodeFloatComps(amps->floatStorage, (char*) block + i * (amps->numBits / 8), scale, &amp.real, 1);
+        decodeFloatComps(amps->floatStorage, (char*) block + (blockSize + i) * (amps->numBits / 8), scale, &amp.imag, 1);
+        return amp;
+    }
+
+    qreal unit = amps->blockScales[b] / ((1LL << (amps->numBits - 1)) - 1);
+    switch (amps->numBits) {
+        case 8:
+            amp.real = unit * ((int8_t*) block)[i];
+            amp.imag = unit * ((int8_t*) block)[blockSize + i];
+            break;
+        case 16:
+            amp.real = unit * ((int16_t*) block)[i];
+            amp.imag = unit * ((int16_t*) block)[blockSize + i];
+            break;
+        case 32:
+            amp.real = unit * ((int32_t*) block)[i];
+            amp.imag = unit * ((int32_t*) block)[blockSize + i];
+            break;
+    }
+    return amp;
+}
+
+/** returns the total probability of the basis states whose bit measureQubit is outcome, or
+ * the total probability of all states if measureQubit is -1
+ */
+static qreal getCompressedProb(Qureg qureg, int measureQubit, int outcome) {
+
+    CompressedAmps* amps = qureg.compressedAmps;
+    long long int blockSize = 1LL << amps->numBlockQubits;
+    long long int numBlocks = amps->numBlocks;
+    int numBlockQubits = amps->numBlockQubits;
+
+    // accumulated in double, whatever the precision of qreal and of storage
+    double totalProb = 0;
+    qreal *re, *im;
+    long long int b, i;
+
+# ifdef _OPENMP
+# pragma omp parallel \
+    shared   (amps, blockSize, numBlocks, numBlockQubits, measureQubit, outcome) \
+    private  (re, im, b, i) \
+    reduction ( +:totalProb )
+# endif
+    {
+        re = malloc(blockSize * sizeof *re);
+        im = malloc(blockSize * sizeof *im);
+        if (re == NULL || im == NULL) {
+            printf("Could not allocate memory!");
+            exit (EXIT_FAILURE);
+        }
+
+# ifdef _OPENMP
+# pragma omp for schedule (static)
+# endif
+        for (b=0; b<numBlocks; b++) {
+            if (amps->blocks[b] == NULL)
+                continue;
+            if (measureQubit >= numBlockQubits && extractBit(measureQubit - numBlockQubits, b) != outcome)
+                continue;
+
+            decompressBlock(amps, b, re, im);
+            for (i=0; i<blockSize; i++)
+                if (measureQubit < 0 || measureQubit >= numBlockQubits || extractBit(measureQubit, i) == outcome)
+                    totalProb += re[i]*re[i] + im[i]*im[i];
+        }
+        free(re);
+        free(im);
+    }
+    return totalProb;
+}
+
+qreal compressed_calcTotalProb(Qureg qureg) {
+    return getCompressedProb(qureg, -1, 0);
+}
+
+qreal compressed_calcProbOfOutcome(Qureg qureg, int measureQubit, int outcome) {
+    return getCompressedProb(qureg, measureQubit, outcome);
+}
+
+Complex compressed_calcInnerProduct(Qureg bra, Qureg ket) {
+
+    CompressedAmps* braAmps = bra.compressedAmps;
+    CompressedAmps* ketAmps = ket.compressedAmps;
+    long long int blockSize = 1LL << braAmps->numBlockQubits;
+    long long int numBlocks = braAmps->numBlocks;
+
+    double innerProdReal = 0;
+    double innerProdImag = 0;
+    qreal *braRe, *braIm, *ketRe, *ketIm;
+    long long int b, i;
+
+# ifdef _OPENMP
+# pragma omp parallel \
+    shared   (braAmps, ketAmps, blockSize, numBlocks) \
+    private  (braRe, braIm, ketRe, ketIm, b, i) \
+    reduction ( +:innerProdReal, innerProdImag )
+# endif
+    {
+        braRe = malloc(blockSize * sizeof *braRe);
+        braIm = malloc(blockSize * sizeof *braIm);
+        ketRe = malloc(blockSize * sizeof *ketRe);
+        ketIm = malloc(blockSize * sizeof *ketIm);
+        if (braRe == NULL || braIm == NULL || ketRe == NULL || ketIm == NULL) {
+            printf("Could not allocate memory!");
+            exit (EXIT_FAILURE);
+        }
+
+# ifdef _OPENMP
+# pragma omp for schedule (static)
+# endif
+        for (b=0; b<numBlocks; b++) {
+            if (braAmps->blocks[b] == NULL || ketAmps->blocks[b] == NULL)
+                continue;
+
+            decompressBlock(braAmps, b, braRe, braIm);
+            decompressBlock(ketAmps, b, ketRe, ketIm);
+
+            // conj(bra) * ket
+            for (i=0; i<blockSize; i++) {
+                innerProdReal += braRe[i]*ketRe[i] + braIm[i]*ketIm[i];
+                innerProdImag += braRe[i]*ketIm[i] - braIm[i]*ketRe[i];
+            }
+        }
+        free(braRe);
+        free(braIm);
+        free(ketRe);
+        free(ketIm);
+    }
+
+    Complex innerProd;
+    innerProd.real = innerProdReal;
+    innerProd.imag = innerProdImag;
+    return innerProd;
+}
+
+void compressed_applyToBlockGroups(Qureg qureg, int* highQubits, int numHighQubits, void (*applyToGroup)(Qureg group, void* args), void* args) {
+
+    CompressedAmps* amps = qureg.compressedAmps;
+    int numBlockQubits = amps->numBlockQubits;
+    long long int blockSize = 1LL << numBlockQubits;
+    long long int numGroups = amps->numBlocks >> numHighQubits;
+    long long int numGroupBlocks = 1LL << numHighQubits;
+
+    // the bits of the block index which vary within a group, in increasing order
+    int sortedBits[2];
+    for (int i=0; i<numHighQubits; i++)
+        sortedBits[i] = highQubits[i] - numBlockQubits;
+    if (numHighQubits == 2 && sortedBits[0] > sortedBits[1]) {
+        int tmp = sortedBits[0];
+        sortedBits[0] = sortedBits[1];
+        sortedBits[1] = tmp;
+    }
+
+    // each group is an ordinary register whose qubit numBlockQubits + i is highQubits[i]
+    Qureg group = qureg;
+    group.numQubitsInStateVec = numBlockQubits + numHighQubits;
+    group.numQubitsRepresented = numBlockQubits + numHighQubits;
+    group.numAmpsTotal = blockSize * numGroupBlocks;
+    group.numAmpsPerChunk = blockSize * numGroupBlocks;
+    group.chunkId = 0;
+    group.numChunks = 1;
+    group.isCompressed = 0;
+    group.compressedAmps = NULL;
+
+    qreal errSq = 0;
+    long long int g, k, baseInd, blockInd;
+    int i;
+
+# ifdef _OPENMP
+# pragma omp parallel \
+    shared   (amps, highQubits, numHighQubits, sortedBits, blockSize, numGroups, numGroupBlocks, numBlockQubits, applyToGroup, args) \
+    private  (g, k, i, baseInd, blockInd) \
+    firstprivate (group) \
+    reduction ( +:errSq )
+# endif
+    {
+        group.stateVec.real = malloc(group.numAmpsPerChunk * sizeof(qreal));
+        group.stateVec.imag = malloc(group.numAmpsPerChunk * sizeof(qreal));
+        if (group.stateVec.real == NULL || group.stateVec.imag == NULL) {
+            printf("Could not allocate memory!");
+            exit (EXIT_FAILURE);
+        }
+
+# ifdef _OPENMP
+# pragma omp for schedule (static)
+# endif
+        for (g=0; g<numGroups; g++) {
+            baseInd = g;
+            for (i=0; i<numHighQubits; i++)
+                baseInd = insertZeroBit(baseInd, sortedBits[i]);
+
+            for (k=0; k<numGroupBlocks; k++) {
+                blockInd = baseInd;
+                for (i=0; i<numHighQubits; i++)
+                    if (extractBit(i, k))
+                        blockInd = flipBit(blockInd, highQubits[i] - numBlockQubits);
+                decompressBlock(amps, blockInd, &group.stateVec.real[k*blockSize], &group.stateVec.imag[k*blockSize]);
+            }
+
+            applyToGroup(group, args);
+
+            for (k=0; k<numGroupBlocks; k++) {
+                blockInd = baseInd;
+                for (i=0; i<numHighQubits; i++)
+                    if (extractBit(i, k))
+                        blockInd = flipBit(blockInd, highQubits[i] - numBlockQubits);
+                errSq += compressBlock(amps, blockInd, &group.stateVec.real[k*blockSize], &group.stateVec.imag[k*blockSize]);
+            }
+        }
+        free(group.stateVec.real);
+        free(group.stateVec.imag);
+    }
+
+    // errors of distinct blocks are orthogonal, whereas those of successive passes may accumulate
+    amps->errorNorm += sqrt(errSq);
+}
+
+CompressionStats compressed_getStats(Qureg qureg) {
+
+    CompressedAmps* amps = qureg.compressedAmps;
+    long long int numStoredBlocks = 0;
+    for (long long int b=0; b<amps->numBlocks; b++)
+        if (amps->blocks[b] != NULL)
+            numStoredBlocks++;
+
+    CompressionStats stats;
+    stats.numBytes = numStoredBlocks * getCompressedBlockSize(amps)
+        + amps->numBlocks * (sizeof *(amps->blocks) + sizeof *(amps->blockScales));
+    stats.compressionRatio = (2 * qureg.numAmpsTotal * sizeof(qreal)) / (qreal) stats.numBytes;
+    stats.infidelityBound = amps->errorNorm * amps->errorNorm;
+    if (stats.infidelityBound > 1)
+        stats.infidelityBound = 1;
+    return stats;
+}
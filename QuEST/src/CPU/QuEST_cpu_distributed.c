@@ -33,7 +33,9 @@
 
 Complex statevec_calcInnerProduct(Qureg bra, Qureg ket) {
 
-    Complex localInnerProd = statevec_calcInnerProductLocal(bra, ket);
+    Complex localInnerProd = (bra.isReal)?
+        (Complex) {.real=realvec_calcInnerProductLocal(bra, ket), .imag=0} :
+        statevec_calcInnerProductLocal(bra, ket);
     if (bra.numChunks == 1)
         return localInnerProd;
 
@@ -51,6 +53,9 @@ Complex statevec_calcInnerProduct(Qureg bra, Qureg ket) {
 
 qreal densmatr_calcTotalProb(Qureg qureg) {
 
+	if (qureg.isPacked)
+		return packmatr_calcTotalProbLocal(qureg);
+
 	// computes the trace by summing every element ("diag") with global index (2^n + 1)i for i in [0, 2^n-1]
 
 	// computes first local index containing a diagonal element
@@ -93,6 +98,8 @@ qreal statevec_calcTotalProb(Qureg qureg){
     long long int index;
     long long int numAmpsPerRank = qureg.numAmpsPerChunk;
     c = 0.0;
+    if (qureg.isReal)
+        numAmpsPerRank = 0; // summed below instead
     for (index=0; index<numAmpsPerRank; index++){
         // Perform pTotal+=qureg.stateVec.real[index]*qureg.stateVec.real[index]; by Kahan
         y = qureg.stateVec.real[index]*qureg.stateVec.real[index] - c;
@@ -107,6 +114,8 @@ qreal statevec_calcTotalProb(Qureg qureg){
         c = ( t - pTotal ) - y;
         pTotal = t;
     }
+    if (qureg.isReal)
+        pTotal = realvec_calcTotalProbLocal(qureg);
     if (qureg.numChunks>1)
 		MPI_Allreduce(&pTotal, &allRankTotals, 1, MPI_QuEST_REAL, MPI_SUM, MPI_COMM_WORLD);
     else
@@ -167,6 +176,8 @@ int syncQuESTSuccess(int successCode){
 }
 
 void destroyQuESTEnv(QuESTEnv env){
+    statevec_setQuregPoolCapacity(0);
+
     int finalized;
     MPI_Finalized(&finalized);
     if (!finalized) MPI_Finalize();
@@ -203,6 +214,8 @@ qreal statevec_getRealAmp(Qureg qureg, long long int index){
 }
 
 qreal statevec_getImagAmp(Qureg qureg, long long int index){
+    if (qureg.isReal)
+        return 0;
     int chunkId = getChunkIdFromIndex(qureg, index);
     qreal el;
     if (qureg.chunkId==chunkId){
@@ -378,7 +391,8 @@ void copyVecIntoMatrixPairState(Qureg matr, Qureg vec) {
     long long int numLocalAmps = vec.numAmpsPerChunk;
     long long int myOffset = vec.chunkId * numLocalAmps;
     memcpy(&matr.pairStateVec.real[myOffset], vec.stateVec.real, numLocalAmps * sizeof(qreal));
-    memcpy(&matr.pairStateVec.imag[myOffset], vec.stateVec.imag, numLocalAmps * sizeof(qreal));
+    if (!vec.isReal)
+        memcpy(&matr.pairStateVec.imag[myOffset], vec.stateVec.imag, numLocalAmps * sizeof(qreal));
 
     // we now want to share this node's vec segment with other node, so that
     // vec is cloned in every node's matr.pairStateVec
@@ -402,17 +416,29 @@ void copyVecIntoMatrixPairState(Qureg matr, Qureg vec) {
             MPI_Bcast(
                 &matr.pairStateVec.real[otherOffset + i*maxMsgSize],
                 maxMsgSize,  MPI_QuEST_REAL, broadcaster, MPI_COMM_WORLD);
-            MPI_Bcast(
-                &matr.pairStateVec.imag[otherOffset + i*maxMsgSize],
-                maxMsgSize,  MPI_QuEST_REAL, broadcaster, MPI_COMM_WORLD);
+            if (!vec.isReal)
+                MPI_Bcast(
+                    &matr.pairStateVec.imag[otherOffset + i*maxMsgSize],
+                    maxMsgSize,  MPI_QuEST_REAL, broadcaster, MPI_COMM_WORLD);
         }
     }
 }
 
 qreal densmatr_calcFidelity(Qureg qureg, Qureg pureState) {
 
-    // set qureg's pairState is to be the full pureState (on every node)
-    copyVecIntoMatrixPairState(qureg, pureState);
+    if (qureg.isPacked)
+        return packmatr_calcFidelityLocal(qureg, pureState);
+
+    // set qureg's pairState is to be the full pureState (on every node), which a single
+    // node (without a pairState) already holds whole
+    if (qureg.numChunks == 1)
+        qureg.pairStateVec = pureState.stateVec;
+    else
+        copyVecIntoMatrixPairState(qureg, pureState);
+    
+    // a real-amplitude pureState has no imaginary components to copy
+    if (pureState.isReal)
+        qureg.pairStateVec.imag = NULL;
 
     // collect calcFidelityLocal by every machine
     qreal localSum = densmatr_calcFidelityLocal(qureg, pureState);
@@ -448,6 +474,11 @@ qreal densmatr_calcInnerProduct(Qureg a, Qureg b) {
 
 void densmatr_initPureState(Qureg targetQureg, Qureg copyQureg) {
 
+    if (targetQureg.isPacked) {
+        packmatr_initPureStateLocal(targetQureg, copyQureg);
+        return;
+    }
+
     if (targetQureg.numChunks==1){
         // local version
         // save pointers to qureg's pair state
@@ -499,6 +530,9 @@ void exchangeStateVectors(Qureg qureg, int pairRank){
                 &qureg.pairStateVec.real[offset], maxMessageCount, MPI_QuEST_REAL,
                 pairRank, TAG, MPI_COMM_WORLD, &status);
         //printf("rank: %d err: %d\n", qureg.rank, err);
+        // real-amplitude registers have no imaginary components to send
+        if (qureg.isReal)
+            continue;
         MPI_Sendrecv(&qureg.stateVec.imag[offset], maxMessageCount, MPI_QuEST_REAL, pairRank, TAG,
                 &qureg.pairStateVec.imag[offset], maxMessageCount, MPI_QuEST_REAL,
                 pairRank, TAG, MPI_COMM_WORLD, &status);
@@ -696,6 +730,12 @@ void densmatr_mixDepolarising(Qureg qureg, const int targetQubit, qreal depolLev
     if (depolLevel == 0)
         return;
 
+    // packed density matrices are never distributed
+    if (qureg.isPacked) {
+        packmatr_mixDepolarisingLocal(qureg, targetQubit, depolLevel);
+        return;
+    }
+
     int rankIsUpper; // rank is in the upper half of an outer block
     int pairRank; // rank of corresponding chunk
 
@@ -723,6 +763,11 @@ void densmatr_mixDamping(Qureg qureg, const int targetQubit, qreal damping) {
     if (damping == 0)
         return;
 
+    if (qureg.isPacked) {
+        packmatr_mixDampingLocal(qureg, targetQubit, damping);
+        return;
+    }
+
     int rankIsUpper; // rank is in the upper half of an outer block
     int pairRank; // rank of corresponding chunk
 
@@ -746,6 +791,52 @@ void densmatr_mixDamping(Qureg qureg, const int targetQubit, qreal damping) {
 
 }
 
+void densmatr_mixDepolarisingOnQubits(Qureg qureg, int* targets, int numTargets, qreal depolLevel) {
+    if (depolLevel == 0)
+        return;
+
+    if (qureg.isPacked) {
+        for (int t=0; t < numTargets; t++)
+            packmatr_mixDepolarisingLocal(qureg, targets[t], depolLevel);
+        return;
+    }
+
+    // targets whose outer blocks fit in the chunk are depolarised together, and the 
+    // remainder individually by pair exchange (the channels commute)
+    int localTargs[numTargets];
+    int numLocalTargs = 0;
+    for (int t=0; t < numTargets; t++) {
+        if (densityMatrixBlockFitsInChunk(qureg.numAmpsPerChunk, qureg.numQubitsRepresented, targets[t]))
+            localTargs[numLocalTargs++] = targets[t];
+        else
+            densmatr_mixDepolarising(qureg, targets[t], depolLevel);
+    }
+    densmatr_mixDepolarisingOnQubitsLocal(qureg, localTargs, numLocalTargs, depolLevel);
+}
+
+void densmatr_mixDampingOnQubits(Qureg qureg, int* targets, int numTargets, qreal damping) {
+    if (damping == 0)
+        return;
+
+    if (qureg.isPacked) {
+        for (int t=0; t < numTargets; t++)
+            packmatr_mixDampingLocal(qureg, targets[t], damping);
+        return;
+    }
+
+    // targets whose outer blocks fit in the chunk are damped together, and the 
+    // remainder individually by pair exchange (the channels commute)
+    int localTargs[numTargets];
+    int numLocalTargs = 0;
+    for (int t=0; t < numTargets; t++) {
+        if (densityMatrixBlockFitsInChunk(qureg.numAmpsPerChunk, qureg.numQubitsRepresented, targets[t]))
+            localTargs[numLocalTargs++] = targets[t];
+        else
+            densmatr_mixDamping(qureg, targets[t], damping);
+    }
+    densmatr_mixDampingOnQubitsLocal(qureg, localTargs, numLocalTargs, damping);
+}
+
 void densmatr_mixTwoQubitDepolarising(Qureg qureg, int qubit1, int qubit2, qreal depolLevel){
     if (depolLevel == 0)
         return;
@@ -840,6 +931,11 @@ void densmatr_mixTwoQubitDepolarising(Qureg qureg, int qubit1, int qubit2, qreal
 
 void statevec_compactUnitary(Qureg qureg, const int targetQubit, Complex alpha, Complex beta)
 {
+    if (qureg.isReal) {
+        statevec_multiControlledUnitary(qureg, 0, 0, targetQubit, getCompactUnitaryMatrix(alpha, beta));
+        return;
+    }
+
     // flag to require memory exchange. 1: an entire block fits on one rank, 0: at most half a block fits on one rank
     int useLocalDataOnly = halfMatrixBlockFitsInChunk(qureg.numAmpsPerChunk, targetQubit);
     Complex rot1, rot2;
@@ -877,6 +973,11 @@ void statevec_compactUnitary(Qureg qureg, const int targetQubit, Complex alpha,
 
 void statevec_unitary(Qureg qureg, const int targetQubit, ComplexMatrix2 u)
 {
+    if (qureg.isReal) {
+        statevec_multiControlledUnitary(qureg, 0, 0, targetQubit, u);
+        return;
+    }
+
     // flag to require memory exchange. 1: an entire block fits on one rank, 0: at most half a block fits on one rank
     int useLocalDataOnly = halfMatrixBlockFitsInChunk(qureg.numAmpsPerChunk, targetQubit);
     Complex rot1, rot2;
@@ -916,6 +1017,11 @@ void statevec_unitary(Qureg qureg, const int targetQubit, ComplexMatrix2 u)
 
 void statevec_controlledCompactUnitary(Qureg qureg, const int controlQubit, const int targetQubit, Complex alpha, Complex beta)
 {
+    if (qureg.isReal) {
+        statevec_multiControlledUnitary(qureg, 1LL << controlQubit, 0, targetQubit, getCompactUnitaryMatrix(alpha, beta));
+        return;
+    }
+
     // flag to require memory exchange. 1: an entire block fits on one rank, 0: at most half a block fits on one rank
     int useLocalDataOnly = halfMatrixBlockFitsInChunk(qureg.numAmpsPerChunk, targetQubit);
     Complex rot1, rot2;
@@ -957,6 +1063,11 @@ void statevec_controlledCompactUnitary(Qureg qureg, const int controlQubit, cons
 void statevec_controlledUnitary(Qureg qureg, const int controlQubit, const int targetQubit,
         ComplexMatrix2 u)
 {
+    if (qureg.isReal) {
+        statevec_multiControlledUnitary(qureg, 1LL << controlQubit, 0, targetQubit, u);
+        return;
+    }
+
     // flag to require memory exchange. 1: an entire block fits on one rank, 0: at most half a block fits on one rank
     int useLocalDataOnly = halfMatrixBlockFitsInChunk(qureg.numAmpsPerChunk, targetQubit);
     Complex rot1, rot2;
@@ -1005,7 +1116,10 @@ void statevec_multiControlledUnitary(Qureg qureg, long long int ctrlQubitsMask,
 
     if (useLocalDataOnly){
         // all values required to update state vector lie in this rank
-        statevec_multiControlledUnitaryLocal(qureg, targetQubit, ctrlQubitsMask, ctrlFlipMask, u);
+        if (qureg.isReal)
+            realvec_multiControlledUnitaryLocal(qureg, targetQubit, ctrlQubitsMask, ctrlFlipMask, u);
+        else
+            statevec_multiControlledUnitaryLocal(qureg, targetQubit, ctrlQubitsMask, ctrlFlipMask, u);
     } else {
         // need to get corresponding chunk of state vector from other rank
         rankIsUpper = chunkIsUpper(qureg.chunkId, qureg.numAmpsPerChunk, targetQubit);
@@ -1017,7 +1131,12 @@ void statevec_multiControlledUnitary(Qureg qureg, long long int ctrlQubitsMask,
 
         // this rank's values are either in the upper of lower half of the block. send values to multiControlledUnitaryDistributed
         // in the correct order
-        if (rankIsUpper){
+        if (qureg.isReal) {
+            qreal* upper = (rankIsUpper)? qureg.stateVec.real : qureg.pairStateVec.real;
+            qreal* lower = (rankIsUpper)? qureg.pairStateVec.real : qureg.stateVec.real;
+            realvec_multiControlledUnitaryDistributed(qureg,ctrlQubitsMask,ctrlFlipMask,rot1.real,rot2.real,
+                    upper, lower, qureg.stateVec.real);
+        } else if (rankIsUpper){
             statevec_multiControlledUnitaryDistributed(qureg,targetQubit,ctrlQubitsMask,ctrlFlipMask,rot1,rot2,
                     qureg.stateVec, //upper
                     qureg.pairStateVec, //lower
@@ -1032,6 +1151,11 @@ void statevec_multiControlledUnitary(Qureg qureg, long long int ctrlQubitsMask,
 }
 void statevec_pauliX(Qureg qureg, const int targetQubit)
 {
+    if (qureg.isReal) {
+        statevec_multiControlledUnitary(qureg, 0, 0, targetQubit, (ComplexMatrix2) {.real={{0,1},{1,0}}});
+        return;
+    }
+
     // flag to require memory exchange. 1: an entire block fits on one rank, 0: at most half a block fits on one rank
     int useLocalDataOnly = halfMatrixBlockFitsInChunk(qureg.numAmpsPerChunk, targetQubit);
 
@@ -1060,6 +1184,11 @@ void statevec_pauliX(Qureg qureg, const int targetQubit)
 
 void statevec_controlledNot(Qureg qureg, const int controlQubit, const int targetQubit)
 {
+    if (qureg.isReal) {
+        statevec_multiControlledUnitary(qureg, 1LL << controlQubit, 0, targetQubit, (ComplexMatrix2) {.real={{0,1},{1,0}}});
+        return;
+    }
+
     // flag to require memory exchange. 1: an entire block fits on one rank, 0: at most half a block fits on one rank
     int useLocalDataOnly = halfMatrixBlockFitsInChunk(qureg.numAmpsPerChunk, targetQubit);
     int rankIsUpper; 	// rank's chunk is in upper half of block
@@ -1210,6 +1339,12 @@ void statevec_controlledPauliYConj(Qureg qureg, const int controlQubit, const in
 
 void statevec_hadamard(Qureg qureg, const int targetQubit)
 {
+    if (qureg.isReal) {
+        qreal r = 1/sqrt(2);
+        statevec_multiControlledUnitary(qureg, 0, 0, targetQubit, (ComplexMatrix2) {.real={{r,r},{r,-r}}});
+        return;
+    }
+
     // flag to require memory exchange. 1: an entire block fits on one rank, 0: at most half a block fits on one rank
     int useLocalDataOnly = halfMatrixBlockFitsInChunk(qureg.numAmpsPerChunk, targetQubit);
 
@@ -1265,13 +1400,21 @@ static int isChunkToSkipInFindPZero(int chunkId, long long int chunkSize, int me
 
 qreal statevec_calcProbOfOutcome(Qureg qureg, const int measureQubit, int outcome)
 {
+    // fixed Hamming-weight registers are never distributed
+    if (qureg.isSubspace)
+        return subspace_calcProbOfOutcome(qureg, measureQubit, outcome);
+
     qreal stateProb=0, totalStateProb=0;
     int skipValuesWithinRank = halfMatrixBlockFitsInChunk(qureg.numAmpsPerChunk, measureQubit);
     if (skipValuesWithinRank) {
-        stateProb = statevec_findProbabilityOfZeroLocal(qureg, measureQubit);
+        stateProb = (qureg.isReal)?
+            realvec_findProbabilityOfZeroLocal(qureg, measureQubit) :
+            statevec_findProbabilityOfZeroLocal(qureg, measureQubit);
     } else {
         if (!isChunkToSkipInFindPZero(qureg.chunkId, qureg.numAmpsPerChunk, measureQubit)){
-            stateProb = statevec_findProbabilityOfZeroDistributed(qureg);
+            stateProb = (qureg.isReal)?
+                realvec_findProbabilityOfZeroDistributed(qureg) :
+                statevec_findProbabilityOfZeroDistributed(qureg);
         } else stateProb = 0;
     }
     MPI_Allreduce(&stateProb, &totalStateProb, 1, MPI_QuEST_REAL, MPI_SUM, MPI_COMM_WORLD);
@@ -1279,8 +1422,34 @@ qreal statevec_calcProbOfOutcome(Qureg qureg, const int measureQubit, int outcom
     return totalStateProb;
 }
 
+ComplexMatrix2 statevec_calcQubitDensityMatrix(Qureg qureg, const int qubit) {
+
+    qreal sums[4] = {0}, totalSums[4];
+    if (halfMatrixBlockFitsInChunk(qureg.numAmpsPerChunk, qubit)) {
+        statevec_calcQubitDensityMatrixLocal(qureg, qubit, sums);
+    } else {
+        // the coherence needs both halves of each pair, so exchange as for a unitary on qubit
+        int rankIsUpper = chunkIsUpper(qureg.chunkId, qureg.numAmpsPerChunk, qubit);
+        int pairRank = getChunkPairId(rankIsUpper, qureg.chunkId, qureg.numAmpsPerChunk, qubit);
+        exchangeStateVectors(qureg, pairRank);
+
+        // the upper chunk accounts for both halves of every pair, and the lower contributes nothing
+        if (rankIsUpper)
+            statevec_calcQubitDensityMatrixDistributed(qureg, qureg.stateVec, qureg.pairStateVec, sums);
+    }
+    MPI_Allreduce(sums, totalSums, 4, MPI_QuEST_REAL, MPI_SUM, MPI_COMM_WORLD);
+
+    ComplexMatrix2 rho = {
+        .real = {{totalSums[0], totalSums[2]}, {totalSums[2], totalSums[1]}},
+        .imag = {{0, totalSums[3]}, {-totalSums[3], 0}}};
+    return rho;
+}
+
 qreal densmatr_calcProbOfOutcome(Qureg qureg, const int measureQubit, int outcome) {
 
+	if (qureg.isPacked)
+		return packmatr_calcProbOfOutcomeLocal(qureg, measureQubit, outcome);
+
 	qreal zeroProb = densmatr_findProbabilityOfZeroLocal(qureg, measureQubit);
 
 	qreal outcomeProb;
@@ -1291,8 +1460,191 @@ qreal densmatr_calcProbOfOutcome(Qureg qureg, const int measureQubit, int outcom
 	return outcomeProb;
 }
 
+/** sums arr (of length numElems) over all nodes in place, in messages no larger than MPI_MAX_AMPS_IN_MSG,
+ * since the count of a single message is an int */
+static void allReduceRealsInPlace(qreal* arr, long long int numElems) {
+
+    long long int maxMsgSize = MPI_MAX_AMPS_IN_MSG;
+    long long int msgSize;
+    for (long long int done=0; done < numElems; done += msgSize) {
+        msgSize = (numElems - done < maxMsgSize)? numElems - done : maxMsgSize;
+        MPI_Allreduce(MPI_IN_PLACE, &arr[done], msgSize, MPI_QuEST_REAL, MPI_SUM, MPI_COMM_WORLD);
+    }
+}
+
+qreal statevec_calcProbOfOutcomes(Qureg qureg, int* qubits, int* outcomes, int numQubits) {
+
+    qreal outcomeProb = statevec_calcProbOfOutcomesLocal(qureg, qubits, outcomes, numQubits);
+    MPI_Allreduce(MPI_IN_PLACE, &outcomeProb, 1, MPI_QuEST_REAL, MPI_SUM, MPI_COMM_WORLD);
+    return outcomeProb;
+}
+
+qreal densmatr_calcProbOfOutcomes(Qureg qureg, int* qubits, int* outcomes, int numQubits) {
+
+    qreal outcomeProb = densmatr_calcProbOfOutcomesLocal(qureg, qubits, outcomes, numQubits);
+    MPI_Allreduce(MPI_IN_PLACE, &outcomeProb, 1, MPI_QuEST_REAL, MPI_SUM, MPI_COMM_WORLD);
+    return outcomeProb;
+}
+
+void statevec_calcProbOfAllOutcomes(qreal* outcomeProbs, Qureg qureg, int* qubits, int numQubits) {
+
+    // each chunk bins its own amplitudes, so only the 2^numQubits bins are communicated
+    statevec_calcProbOfAllOutcomesLocal(outcomeProbs, qureg, qubits, numQubits);
+    allReduceRealsInPlace(outcomeProbs, 1LL << numQubits);
+}
+
+void densmatr_calcProbOfAllOutcomes(qreal* outcomeProbs, Qureg qureg, int* qubits, int numQubits) {
+
+    densmatr_calcProbOfAllOutcomesLocal(outcomeProbs, qureg, qubits, numQubits);
+    allReduceRealsInPlace(outcomeProbs, 1LL << numQubits);
+}
+
+void statevec_sampleOutcomes(Qureg qureg, int* qubits, int numQubits, int numShots, long long int* outcomes) {
+
+    // qubits stored in the chunk index have a fixed outcome within a chunk, so each chunk bins
+    // only the outcomes of its local qubits, and no bins are communicated
+    int localQubits[numQubits];
+    int localPositions[numQubits];
+    int numLocal = 0;
+    long long int chunkOutcome = 0;
+    long long int chunkStartInd = qureg.chunkId*qureg.numAmpsPerChunk;
+    for (int q=0; q<numQubits; q++) {
+        if ((1LL << qubits[q]) < qureg.numAmpsPerChunk) {
+            localQubits[numLocal] = qubits[q];
+            localPositions[numLocal] = q;
+            numLocal++;
+        } else
+            chunkOutcome |= (long long int) extractBit(qubits[q], chunkStartInd) << q;
+    }
+
+    long long int numLocalOutcomes = 1LL << numLocal;
+    qreal* localProbs = allocOutcomeProbs(numLocal, __func__);
+    statevec_calcProbOfAllOutcomesLocal(localProbs, qureg, localQubits, numLocal);
+    calcCumulativeProbs(localProbs, numLocalOutcomes);
+
+    // only the chunk totals are communicated, as per statevec_sampleBasisState
+    qreal chunkProb = localProbs[numLocalOutcomes-1];
+    qreal* chunkProbs = malloc(qureg.numChunks * sizeof *chunkProbs);
+    MPI_Allgather(&chunkProb, 1, MPI_QuEST_REAL, chunkProbs, 1, MPI_QuEST_REAL, MPI_COMM_WORLD);
+    calcCumulativeProbs(chunkProbs, qureg.numChunks);
+    qreal totalProb = chunkProbs[qureg.numChunks-1];
+    qreal prevChunksProb = (qureg.chunkId > 0)? chunkProbs[qureg.chunkId-1] : 0;
+
+    // every rank shares each shot's random number, so agrees upon the chunk it falls in, 
+    // and only that chunk fills in the shot
+    for (int s=0; s<numShots; s++) {
+        qreal cumulProb = genrand_real2() * totalProb;
+        outcomes[s] = 0;
+        if (findCumulativeProbIndex(chunkProbs, qureg.numChunks, cumulProb) != qureg.chunkId)
+            continue;
+
+        long long int localOutcome = findCumulativeProbIndex(localProbs, numLocalOutcomes, cumulProb - prevChunksProb);
+        outcomes[s] = chunkOutcome;
+        for (int j=0; j<numLocal; j++)
+            outcomes[s] |= ((localOutcome >> j) & 1LL) << localPositions[j];
+    }
+    MPI_Allreduce(MPI_IN_PLACE, outcomes, numShots, MPI_LONG_LONG, MPI_SUM, MPI_COMM_WORLD);
+
+    free(chunkProbs);
+    free(localProbs);
+}
+
+void statevec_calcReducedDensityMatrix(Qureg qureg, int* keepQubits, int numKeep, ComplexMatrixN out) {
+
+    // every amplitude of a kept-qubit block must be local, so swap any kept qubits
+    // stored in the chunk index into the lowest free local qubits, as for multi-qubit unitaries
+    long long int keepMask = getQubitBitMask(keepQubits, numKeep);
+    int freeQb=0;
+    while (maskContainsBit(keepMask, freeQb))
+        freeQb++;
+
+    int swapKeep[numKeep];
+    for (int j=0; j<numKeep; j++) {
+        if (halfMatrixBlockFitsInChunk(qureg.numAmpsPerChunk, keepQubits[j]))
+            swapKeep[j] = keepQubits[j];
+        else {
+            swapKeep[j] = freeQb;
+            freeQb++;
+            while (maskContainsBit(keepMask, freeQb))
+                freeQb++;
+        }
+    }
+    for (int j=0; j<numKeep; j++)
+        if (swapKeep[j] != keepQubits[j])
+            statevec_swapQubitAmps(qureg, keepQubits[j], swapKeep[j]);
+
+    // each chunk streams its amplitudes once, and only the 4^numKeep sums are communicated
+    long long int numElems = 1LL << (2*numKeep);
+    qreal *sums = malloc(2*numElems * sizeof *sums);
+    statevec_calcReducedDensityMatrixLocal(qureg, swapKeep, numKeep, sums, &sums[numElems]);
+    MPI_Allreduce(MPI_IN_PLACE, sums, 2*numElems, MPI_QuEST_REAL, MPI_SUM, MPI_COMM_WORLD);
+
+    for (int j=0; j<numKeep; j++)
+        if (swapKeep[j] != keepQubits[j])
+            statevec_swapQubitAmps(qureg, keepQubits[j], swapKeep[j]);
+
+    setMatrixNFromRowMajor(out, sums, &sums[numElems]);
+    free(sums);
+}
+
+void densmatr_calcReducedDensityMatrix(Qureg qureg, int* keepQubits, int numKeep, ComplexMatrixN out) {
+
+    // every element lives on the node holding its column, so no exchange is needed
+    long long int numElems = 1LL << (2*numKeep);
+    qreal *sums = malloc(2*numElems * sizeof *sums);
+    if (qureg.isPacked)
+        packmatr_calcReducedDensityMatrixLocal(qureg, keepQubits, numKeep, sums, &sums[numElems]);
+    else
+        densmatr_calcReducedDensityMatrixLocal(qureg, keepQubits, numKeep, sums, &sums[numElems]);
+    MPI_Allreduce(MPI_IN_PLACE, sums, 2*numElems, MPI_QuEST_REAL, MPI_SUM, MPI_COMM_WORLD);
+    setMatrixNFromRowMajor(out, sums, &sums[numElems]);
+    free(sums);
+}
+
+long long int statevec_sampleBasisState(Qureg qureg, qreal rand, qreal* outcomeProb) {
+
+    // each rank sums its own blocks, and only the chunk totals are communicated
+    qreal blockProbs[NUM_SAMPLE_BLOCKS];
+    qreal chunkProb = statevec_calcProbOfBlocksLocal(qureg, blockProbs);
+
+    qreal* chunkProbs = malloc(qureg.numChunks * sizeof *chunkProbs);
+    MPI_Allgather(&chunkProb, 1, MPI_QuEST_REAL, chunkProbs, 1, MPI_QuEST_REAL, MPI_COMM_WORLD);
+
+    qreal totalProb = 0;
+    for (int c=0; c<qureg.numChunks; c++)
+        totalProb += chunkProbs[c];
+
+    // every rank shares rand, so agrees upon the chunk containing the sampled state
+    qreal cumulProb = rand*totalProb;
+    int chosenChunk = 0;
+    for (int c=0; c<qureg.numChunks; c++) {
+        if (chunkProbs[c] <= 0)
+            continue;
+        chosenChunk = c;
+        if (cumulProb < chunkProbs[c])
+            break;
+        cumulProb -= chunkProbs[c];
+    }
+    free(chunkProbs);
+
+    // only the chosen chunk scans its amplitudes, then shares the result
+    long long int stateInd = 0;
+    qreal ampProb = 0;
+    if (qureg.chunkId == chosenChunk)
+        stateInd = chosenChunk*qureg.numAmpsPerChunk 
+            + statevec_findCumulativeProbIndexLocal(qureg, blockProbs, cumulProb, &ampProb);
+    MPI_Bcast(&stateInd, 1, MPI_LONG_LONG, chosenChunk, MPI_COMM_WORLD);
+    MPI_Bcast(&ampProb, 1, MPI_QuEST_REAL, chosenChunk, MPI_COMM_WORLD);
+
+    *outcomeProb = ampProb / totalProb;
+    return stateInd;
+}
+
 qreal densmatr_calcPurity(Qureg qureg) {
 
+    if (qureg.isPacked)
+        return packmatr_calcPurityLocal(qureg);
+
     qreal localPurity = densmatr_calcPurityLocal(qureg);
 
     qreal globalPurity;
@@ -1301,9 +1653,37 @@ qreal densmatr_calcPurity(Qureg qureg) {
     return globalPurity;
 }
 
+qreal densmatr_calcExpecPauliSum(Qureg qureg, enum pauliOpType* allCodes, qreal* termCoeffs, int numSumTerms) {
+
+    if (qureg.isPacked)
+        return packmatr_calcExpecPauliSumLocal(qureg, allCodes, termCoeffs, numSumTerms);
+
+    qreal localValue = densmatr_calcExpecPauliSumLocal(qureg, allCodes, termCoeffs, numSumTerms);
+
+    qreal globalValue;
+    MPI_Allreduce(&localValue, &globalValue, 1, MPI_QuEST_REAL, MPI_SUM, MPI_COMM_WORLD);
+
+    return globalValue;
+}
+
 void statevec_collapseToKnownProbOutcome(Qureg qureg, const int measureQubit, int outcome, qreal totalStateProb)
 {
+    if (qureg.isSubspace) {
+        subspace_collapseToKnownProbOutcome(qureg, measureQubit, outcome, totalStateProb);
+        return;
+    }
     int skipValuesWithinRank = halfMatrixBlockFitsInChunk(qureg.numAmpsPerChunk, measureQubit);
+    if (qureg.isReal) {
+        if (skipValuesWithinRank)
+            realvec_collapseToKnownProbOutcomeLocal(qureg, measureQubit, outcome, totalStateProb);
+        else {
+            // every amp in this chunk has the same value of the measured qubit
+            int chunkOutcome = isChunkToSkipInFindPZero(qureg.chunkId, qureg.numAmpsPerChunk, measureQubit) != 0;
+            int chunkHasOutcome = (chunkOutcome == outcome);
+            realvec_scaleAmpsLocal(qureg, (chunkHasOutcome)? 1/sqrt(totalStateProb) : 0);
+        }
+        return;
+    }
     if (skipValuesWithinRank) {
         statevec_collapseToKnownProbOutcomeLocal(qureg, measureQubit, outcome, totalStateProb);
     } else {
@@ -1321,6 +1701,15 @@ void statevec_collapseToKnownProbOutcome(Qureg qureg, const int measureQubit, in
     }
 }
 
+int statevec_measureWithStats(Qureg qureg, int measureQubit, qreal *outcomeProb) {
+
+    // the outcome must await the probability reduced over every node before collapsing
+    qreal zeroProb = statevec_calcProbOfOutcome(qureg, measureQubit, 0);
+    int outcome = generateMeasurementOutcome(zeroProb, outcomeProb);
+    statevec_collapseToKnownProbOutcome(qureg, measureQubit, outcome, *outcomeProb);
+    return outcome;
+}
+
 void seedQuESTDefault(){
     // init MT random number generator with three keys -- time and pid
     // for the MPI version, it is ok that all procs will get the same seed as random numbers will only be
@@ -1360,10 +1749,20 @@ long long int getGlobalIndOfOddParityInChunk(Qureg qureg, int qb1, int qb2) {
 
 void statevec_swapQubitAmps(Qureg qureg, int qb1, int qb2) {
 
+    if (qureg.isSubspace) {
+        subspace_swapQubitAmps(qureg, qb1, qb2);
+        return;
+    }
+
     // perform locally if possible
     int qbBig = (qb1 > qb2)? qb1 : qb2;
-    if (halfMatrixBlockFitsInChunk(qureg.numAmpsPerChunk, qbBig))
-        return statevec_swapQubitAmpsLocal(qureg, qb1, qb2);
+    if (halfMatrixBlockFitsInChunk(qureg.numAmpsPerChunk, qbBig)) {
+        if (qureg.isReal)
+            realvec_swapQubitAmpsLocal(qureg, qb1, qb2);
+        else
+            statevec_swapQubitAmpsLocal(qureg, qb1, qb2);
+        return;
+    }
 
     // do nothing if this node contains no amplitudes to swap
     long long int oddParityGlobalInd = getGlobalIndOfOddParityInChunk(qureg, qb1, qb2);
@@ -1373,7 +1772,95 @@ void statevec_swapQubitAmps(Qureg qureg, int qb1, int qb2) {
     // determine and swap amps with pair node
     int pairRank = flipBit(flipBit(oddParityGlobalInd, qb1), qb2) / qureg.numAmpsPerChunk;
     exchangeStateVectors(qureg, pairRank);
-    statevec_swapQubitAmpsDistributed(qureg, pairRank, qb1, qb2);
+    if (qureg.isReal)
+        realvec_swapQubitAmpsDistributed(qureg, pairRank, qb1, qb2);
+    else
+        statevec_swapQubitAmpsDistributed(qureg, pairRank, qb1, qb2);
+}
+
+/** Each term's X and Y operators upon qubits beyond this chunk map its amplitudes to those of
+ * a single pair chunk, which is fetched whole before the term is evaluated locally.
+ */
+qreal realvec_calcExpecPauliSum(Qureg qureg, enum pauliOpType* allCodes, qreal* termCoeffs, int numSumTerms)
+{
+    int numQubits = qureg.numQubitsRepresented;
+    int numLocalQubits = 0;
+    while ((1LL << numLocalQubits) < qureg.numAmpsPerChunk)
+        numLocalQubits++;
+
+    qreal localValue = 0, totalValue = 0;
+    for (int t=0; t < numSumTerms; t++) {
+        enum pauliOpType* termCodes = &allCodes[t*numQubits];
+
+        int pairRank = qureg.chunkId;
+        for (int q=numLocalQubits; q < numQubits; q++)
+            if (termCodes[q] == PAULI_X || termCodes[q] == PAULI_Y)
+                pairRank ^= 1 << (q - numLocalQubits);
+
+        qreal* flippedAmps = qureg.stateVec.real;
+        if (pairRank != qureg.chunkId) {
+            exchangeStateVectors(qureg, pairRank);
+            flippedAmps = qureg.pairStateVec.real;
+        }
+        localValue += termCoeffs[t] * realvec_calcExpecPauliProdLocal(qureg, termCodes, flippedAmps);
+    }
+    MPI_Allreduce(&localValue, &totalValue, 1, MPI_QuEST_REAL, MPI_SUM, MPI_COMM_WORLD);
+    return totalValue;
+}
+
+/** The row and column updates of a density matrix gate are fused into one pass when 
+ * the column target bit (the most significant) lies within each chunk. Otherwise, 
+ * u and conj(u) are applied separately, with the usual pair-chunk exchanges.
+ */
+void densmatr_multiControlledUnitary(Qureg qureg, long long int ctrlQubitsMask, long long int ctrlFlipMask, const int targetQubit, ComplexMatrix2 u)
+{
+    if (qureg.isPacked) {
+        packmatr_multiControlledUnitaryLocal(qureg, ctrlQubitsMask, ctrlFlipMask, targetQubit, u);
+        return;
+    }
+
+    int shift = qureg.numQubitsRepresented;
+    if (halfMatrixBlockFitsInChunk(qureg.numAmpsPerChunk, targetQubit+shift)) {
+        densmatr_multiControlledUnitaryLocal(qureg, ctrlQubitsMask, ctrlFlipMask, targetQubit, u);
+    } else {
+        statevec_multiControlledUnitary(qureg, ctrlQubitsMask, ctrlFlipMask, targetQubit, u);
+        statevec_multiControlledUnitary(qureg, ctrlQubitsMask<<shift, ctrlFlipMask<<shift, targetQubit+shift, getConjugateMatrix2(u));
+    }
+}
+
+void densmatr_phaseShiftByTerm(Qureg qureg, long long int ctrlMask, const int targetQubit, Complex term)
+{
+    if (qureg.isPacked) {
+        packmatr_phaseShiftByTermLocal(qureg, ctrlMask, targetQubit, term);
+        return;
+    }
+    ComplexMatrix2 u = {.real = {{1, 0}, {0, term.real}}, .imag = {{0, 0}, {0, term.imag}}};
+    densmatr_multiControlledUnitary(qureg, ctrlMask, 0, targetQubit, u);
+}
+
+void densmatr_multiControlledTwoQubitUnitary(Qureg qureg, long long int ctrlMask, const int targetQubit1, const int targetQubit2, ComplexMatrix4 u)
+{
+    if (qureg.isPacked) {
+        packmatr_multiControlledTwoQubitUnitaryLocal(qureg, ctrlMask, targetQubit1, targetQubit2, u);
+        return;
+    }
+
+    int shift = qureg.numQubitsRepresented;
+    int qBig = (targetQubit1 > targetQubit2)? targetQubit1 : targetQubit2;
+    if (halfMatrixBlockFitsInChunk(qureg.numAmpsPerChunk, qBig+shift)) {
+        densmatr_multiControlledTwoQubitUnitaryLocal(qureg, ctrlMask, targetQubit1, targetQubit2, u);
+    } else {
+        statevec_multiControlledTwoQubitUnitary(qureg, ctrlMask, targetQubit1, targetQubit2, u);
+        statevec_multiControlledTwoQubitUnitary(qureg, ctrlMask<<shift, targetQubit1+shift, targetQubit2+shift, getConjugateMatrix4(u));
+    }
+}
+
+/** Applies the two-qubit unitary to targets which both lie within this node's chunk */
+static void multiControlledTwoQubitUnitaryLocal(Qureg qureg, long long int ctrlMask, const int q1, const int q2, ComplexMatrix4 u) {
+    if (qureg.isReal)
+        realvec_multiControlledTwoQubitUnitaryLocal(qureg, ctrlMask, q1, q2, u);
+    else
+        statevec_multiControlledTwoQubitUnitaryLocal(qureg, ctrlMask, q1, q2, u);
 }
 
 /** This calls swapQubitAmps only when it would involve a distributed communication;
@@ -1386,22 +1873,26 @@ void statevec_swapQubitAmps(Qureg qureg, int qb1, int qb2) {
  * swap routine.
  */
 void statevec_multiControlledTwoQubitUnitary(Qureg qureg, long long int ctrlMask, const int q1, const int q2, ComplexMatrix4 u) {
+    if (qureg.isSubspace) {
+        subspace_multiControlledTwoQubitUnitary(qureg, ctrlMask, q1, q2, u);
+        return;
+    }
     int q1FitsInNode = halfMatrixBlockFitsInChunk(qureg.numAmpsPerChunk, q1);
     int q2FitsInNode = halfMatrixBlockFitsInChunk(qureg.numAmpsPerChunk, q2);
 
     if (q1FitsInNode && q2FitsInNode) {
-        statevec_multiControlledTwoQubitUnitaryLocal(qureg, ctrlMask, q1, q2, u);
+        multiControlledTwoQubitUnitaryLocal(qureg, ctrlMask, q1, q2, u);
 
     } else if (q1FitsInNode) {
         int qSwap = (q1 > 0)? q1-1 : q1+1;
         statevec_swapQubitAmps(qureg, q2, qSwap);
-        statevec_multiControlledTwoQubitUnitaryLocal(qureg, ctrlMask, q1, qSwap, u);
+        multiControlledTwoQubitUnitaryLocal(qureg, ctrlMask, q1, qSwap, u);
         statevec_swapQubitAmps(qureg, q2, qSwap);
 
     } else if (q2FitsInNode) {
         int qSwap = (q2 > 0)? q2-1 : q2+1;
         statevec_swapQubitAmps(qureg, q1, qSwap);
-        statevec_multiControlledTwoQubitUnitaryLocal(qureg, ctrlMask, qSwap, q2, u);
+        multiControlledTwoQubitUnitaryLocal(qureg, ctrlMask, qSwap, q2, u);
         statevec_swapQubitAmps(qureg, q1, qSwap);
 
     } else {
@@ -1409,7 +1900,7 @@ void statevec_multiControlledTwoQubitUnitary(Qureg qureg, long long int ctrlMask
         int swap2 = 1;
         statevec_swapQubitAmps(qureg, q1, swap1);
         statevec_swapQubitAmps(qureg, q2, swap2);
-        statevec_multiControlledTwoQubitUnitaryLocal(qureg, ctrlMask, swap1, swap2, u);
+        multiControlledTwoQubitUnitaryLocal(qureg, ctrlMask, swap1, swap2, u);
         statevec_swapQubitAmps(qureg, q1, swap1);
         statevec_swapQubitAmps(qureg, q2, swap2);
     }
@@ -1459,10 +1950,215 @@ void statevec_multiControlledMultiQubitUnitary(Qureg qureg, long long int ctrlMa
             statevec_swapQubitAmps(qureg, targs[t], swapTargs[t]);
 
     // all target qubits have now been swapped into local memory
-    statevec_multiControlledMultiQubitUnitaryLocal(qureg, ctrlMask, swapTargs, numTargs, u);
+    if (qureg.isReal)
+        realvec_multiControlledMultiQubitUnitaryLocal(qureg, ctrlMask, swapTargs, numTargs, u);
+    else
+        statevec_multiControlledMultiQubitUnitaryLocal(qureg, ctrlMask, swapTargs, numTargs, u);
 
     // undo swaps
     for (int t=0; t<numTargs; t++)
         if (swapTargs[t] != targs[t])
             statevec_swapQubitAmps(qureg, targs[t], swapTargs[t]);
 }
+
+/** reads (if isRead) or writes this node's numAmps of arr at the given offset (in bytes) of the file,
+ * in collective MPI-IO calls no larger than an MPI message, returning whether they all succeeded
+ */
+static int transferCheckpointAmps(MPI_File file, qreal* arr, long long int numAmps, long long int offset, int isRead) {
+
+    long long int maxMsgSize = MPI_MAX_AMPS_IN_MSG;
+    long long int msgSize;
+    int success = 1;
+    int err;
+
+    // every node holds the same number of amplitudes, so makes the same number of calls
+    for (long long int done=0; done < numAmps; done += msgSize) {
+        msgSize = (numAmps - done < maxMsgSize)? numAmps - done : maxMsgSize;
+        MPI_Offset msgOffset = offset + done * sizeof(qreal);
+        err = (isRead)?
+            MPI_File_read_at_all(file, msgOffset, &arr[done], msgSize, MPI_QuEST_REAL, MPI_STATUS_IGNORE) :
+            MPI_File_write_at_all(file, msgOffset, &arr[done], msgSize, MPI_QuEST_REAL, MPI_STATUS_IGNORE);
+        success = success && (err == MPI_SUCCESS);
+    }
+    return success;
+}
+
+/** returns the checksums of the real and imaginary components of all nodes' amplitudes */
+static void getCheckpointChecksums(Qureg qureg, unsigned long long int* checksums) {
+
+    long long int firstIndex = qureg.chunkId * qureg.numAmpsPerChunk;
+    unsigned long long int localChecksums[2] = {0, 0};
+    localChecksums[0] = calcCheckpointChecksum(qureg.stateVec.real, qureg.numAmpsPerChunk, firstIndex);
+    if (!qureg.isReal)
+        localChecksums[1] = calcCheckpointChecksum(qureg.stateVec.imag, qureg.numAmpsPerChunk, firstIndex);
+
+    MPI_Allreduce(localChecksums, checksums, 2, MPI_UNSIGNED_LONG_LONG, MPI_SUM, MPI_COMM_WORLD);
+}
+
+int statevec_writeCheckpoint(Qureg qureg, char* filename) {
+
+    CheckpointHeader header;
+    statevec_initCheckpointHeader(qureg, &header);
+    long long int arrBytes = header.numAmps * sizeof(qreal);
+    long long int chunkOffset = CHECKPOINT_DATA_OFFSET + qureg.chunkId * qureg.numAmpsPerChunk * sizeof(qreal);
+    int numArrs = (qureg.isReal)? 1 : 2;
+
+    char* tempName = getTempCheckpointName(filename);
+    if (!syncQuESTSuccess(tempName != NULL)) {
+        free(tempName);
+        return 0;
+    }
+
+    MPI_File file;
+    int isOpen = (MPI_File_open(MPI_COMM_WORLD, tempName, MPI_MODE_CREATE | MPI_MODE_WRONLY, MPI_INFO_NULL, &file) == MPI_SUCCESS);
+    if (!syncQuESTSuccess(isOpen)) {
+        if (isOpen)
+            MPI_File_close(&file);
+        free(tempName);
+        return 0;
+    }
+
+    // discard any longer file left by an interrupted write
+    int success = (MPI_File_set_size(file, CHECKPOINT_DATA_OFFSET + numArrs*arrBytes) == MPI_SUCCESS);
+    success = transferCheckpointAmps(file, qureg.stateVec.real, qureg.numAmpsPerChunk, chunkOffset, 0) && success;
+    if (!qureg.isReal)
+        success = transferCheckpointAmps(file, qureg.stateVec.imag, qureg.numAmpsPerChunk, chunkOffset + arrBytes, 0) && success;
+
+    unsigned long long int checksums[2];
+    getCheckpointChecksums(qureg, checksums);
+    header.realChecksum = checksums[0];
+    header.imagChecksum = checksums[1];
+
+    // the header is written last, so is only valid once the amplitudes are
+    if (qureg.chunkId == 0)
+        success = success && (MPI_File_write_at(file, 0, &header, sizeof header, MPI_BYTE, MPI_STATUS_IGNORE) == MPI_SUCCESS);
+    success = (MPI_File_sync(file) == MPI_SUCCESS) && success;
+    success = (MPI_File_close(&file) == MPI_SUCCESS) && success;
+    success = syncQuESTSuccess(success);
+
+    if (qureg.chunkId == 0) {
+        if (success)
+            success = (rename(tempName, filename) == 0);
+        else
+            remove(tempName);
+    }
+    free(tempName);
+    return syncQuESTSuccess(success);
+}
+
+int statevec_startCheckpoint(Qureg qureg, char* filename, long long int gateIndex) {
+
+    CheckpointHeader header;
+    statevec_initCheckpointHeader(qureg, &header);
+    header.gateIndex = gateIndex;
+    int numArrs = (qureg.isReal)? 1 : 2;
+
+    // the root node creates the file, which the other nodes then open to write their own amplitudes
+    int fd = -1;
+    if (qureg.chunkId == 0)
+        fd = createCheckpointFile(filename, CHECKPOINT_DATA_OFFSET + numArrs * header.numAmps * sizeof(qreal));
+    if (!syncQuESTSuccess(qureg.chunkId != 0 || fd >= 0))
+        return 0;
+    if (qureg.chunkId != 0)
+        fd = openTempCheckpointFile(filename);
+
+    int isStarted = (fd >= 0) && startCheckpointWriter(qureg, header, fd, filename);
+    if (syncQuESTSuccess(isStarted))
+        return 1;
+
+    // abandon the checkpoint if any node could not begin writing
+    CheckpointWrite write;
+    if (isStarted && finishCheckpointWriter(qureg, &write))
+        free(write.filename);
+    if (fd >= 0)
+        closeCheckpointFile(fd);
+    if (qureg.chunkId == 0) {
+        char* tempName = getTempCheckpointName(filename);
+        if (tempName != NULL)
+            remove(tempName);
+        free(tempName);
+    }
+    return 0;
+}
+
+int statevec_finishCheckpoint(Qureg qureg) {
+
+    // every node has a pending checkpoint of qureg, or none do
+    CheckpointWrite write;
+    if (!finishCheckpointWriter(qureg, &write))
+        return 1;
+
+    unsigned long long int localChecksums[2] = {write.header.realChecksum, write.header.imagChecksum};
+    unsigned long long int checksums[2];
+    MPI_Allreduce(localChecksums, checksums, 2, MPI_UNSIGNED_LONG_LONG, MPI_SUM, MPI_COMM_WORLD);
+    write.header.realChecksum = checksums[0];
+    write.header.imagChecksum = checksums[1];
+
+    // the header is written last by the root node, once every node's amplitudes are on disk
+    int success = syncQuESTSuccess(write.isWritten && syncCheckpointFile(write.fd));
+    if (qureg.chunkId == 0) {
+        success = success && writeCheckpointBytes(write.fd, &write.header, sizeof write.header, 0);
+        success = commitCheckpointFile(write.fd, write.filename, success);
+    } else
+        closeCheckpointFile(write.fd);
+    free(write.filename);
+    return syncQuESTSuccess(success);
+}
+
+int statevec_readCheckpointHeader(char* filename, CheckpointHeader* header) {
+
+    MPI_File file;
+    int isOpen = (MPI_File_open(MPI_COMM_WORLD, filename, MPI_MODE_RDONLY, MPI_INFO_NULL, &file) == MPI_SUCCESS);
+    if (!syncQuESTSuccess(isOpen)) {
+        if (isOpen)
+            MPI_File_close(&file);
+        return 0;
+    }
+
+    // a file too short to hold a header is left with an invalid (zero) header
+    memset(header, 0, sizeof *header);
+    MPI_File_read_at_all(file, 0, header, sizeof *header, MPI_BYTE, MPI_STATUS_IGNORE);
+    MPI_File_close(&file);
+    return 1;
+}
+
+int statevec_readCheckpoint(Qureg qureg, char* filename, CheckpointHeader header, int useMapping) {
+
+    long long int arrBytes = header.numAmps * sizeof(qreal);
+    long long int chunkBytes = qureg.numAmpsPerChunk * sizeof(qreal);
+    long long int chunkOffset = CHECKPOINT_DATA_OFFSET + qureg.chunkId * chunkBytes;
+
+    // each node maps its own amplitudes from the file
+    int isMapped = 0;
+    if (useMapping && !qureg.isOutOfCore) {
+        int fd = openCheckpointFile(filename);
+        isMapped = (fd >= 0)
+            && mapAmpArrayFromFile(qureg.stateVec.real, chunkBytes, fd, chunkOffset)
+            && (qureg.isReal || mapAmpArrayFromFile(qureg.stateVec.imag, chunkBytes, fd, chunkOffset + arrBytes));
+        if (fd >= 0)
+            closeCheckpointFile(fd);
+    }
+
+    // unless every node mapped its amplitudes, all (collectively) read them
+    int success = 1;
+    if (!syncQuESTSuccess(isMapped)) {
+        MPI_File file;
+        int isOpen = (MPI_File_open(MPI_COMM_WORLD, filename, MPI_MODE_RDONLY, MPI_INFO_NULL, &file) == MPI_SUCCESS);
+        if (!syncQuESTSuccess(isOpen)) {
+            if (isOpen)
+                MPI_File_close(&file);
+            return 0;
+        }
+        success = transferCheckpointAmps(file, qureg.stateVec.real, qureg.numAmpsPerChunk, chunkOffset, 1);
+        if (!qureg.isReal)
+            success = transferCheckpointAmps(file, qureg.stateVec.imag, qureg.numAmpsPerChunk, chunkOffset + arrBytes, 1) && success;
+        MPI_File_close(&file);
+    }
+
+    unsigned long long int checksums[2];
+    getCheckpointChecksums(qureg, checksums);
+    success = success && checksums[0] == header.realChecksum;
+    if (!qureg.isReal)
+        success = success && checksums[1] == header.imagChecksum;
+    return syncQuESTSuccess(success);
+}
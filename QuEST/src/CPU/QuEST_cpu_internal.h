@@ -14,7 +14,89 @@
 # define QUEST_CPU_INTERNAL_H
 
 # include "QuEST_precision.h"
+# include "QuEST_internal.h"
 
+# include <stddef.h>
+
+// the number of amplitude blocks per chunk which are summed when sampling a basis state
+# define NUM_SAMPLE_BLOCKS 1024
+
+// the number of amplitudes whose outcomes are tabulated together when binning
+# define OUTCOME_BLOCK_SIZE 4096
+
+// the max number of qubits upon which a layer of single-qubit channels is applied per pass of a
+// density matrix, such that each pass works on cache-resident groups of 4^4 elements
+# define MAX_NUM_TILE_TARGETS 4
+
+// the number of neighbouring element groups upon which a tile of channels is applied together
+# define NUM_TILE_GROUPS 16
+
+// the smallest amplitude array (in bytes) which is mapped directly from the OS, and can be shared 
+// copy-on-write between a register and its clones
+# define MIN_MAPPED_ARRAY_SIZE (1LL << 20)
+
+// the number of qubits of the blocks of amplitudes which compressed registers store and decompress 
+// separately, such that the decompressed groups of blocks which gates act upon remain cache-resident
+# define COMPRESSED_BLOCK_QUBITS 12
+
+/*
+ * Precision-generic SIMD. The vectorised kernels are written once in terms of qrealSIMD, a vector
+ * of SIMD_WIDTH qreals, using the widest registers the build targets: 16 floats or 8 doubles with
+ * AVX-512, else 8 floats or 4 doubles with AVX. Kernels are dispatched to only when their contiguous
+ * runs of amplitudes span at least SIMD_WIDTH. Quad precision has no vector instructions, so its
+ * qrealSIMD is a single (long double) qreal.
+ */
+
+# if QuEST_PREC != 4
+# include <immintrin.h>
+# endif
+
+# if QuEST_PREC==1 && defined(__AVX512F__)
+    typedef __m512 qrealSIMD;
+    # define SIMD_WIDTH 16
+    # define SIMD_SET1(x) _mm512_set1_ps(x)
+    # define SIMD_LOAD(ptr) _mm512_loadu_ps(ptr)
+    # define SIMD_STORE(ptr, v) _mm512_storeu_ps(ptr, v)
+    # define SIMD_ADD(a, b) _mm512_add_ps(a, b)
+    # define SIMD_SUB(a, b) _mm512_sub_ps(a, b)
+    # define SIMD_MUL(a, b) _mm512_mul_ps(a, b)
+# elif QuEST_PREC==1
+    typedef __m256 qrealSIMD;
+    # define SIMD_WIDTH 8
+    # define SIMD_SET1(x) _mm256_set1_ps(x)
+    # define SIMD_LOAD(ptr) _mm256_loadu_ps(ptr)
+    # define SIMD_STORE(ptr, v) _mm256_storeu_ps(ptr, v)
+    # define SIMD_ADD(a, b) _mm256_add_ps(a, b)
+    # define SIMD_SUB(a, b) _mm256_sub_ps(a, b)
+    # define SIMD_MUL(a, b) _mm256_mul_ps(a, b)
+# elif QuEST_PREC==2 && defined(__AVX512F__)
+    typedef __m512d qrealSIMD;
+    # define SIMD_WIDTH 8
+    # define SIMD_SET1(x) _mm512_set1_pd(x)
+    # define SIMD_LOAD(ptr) _mm512_loadu_pd(ptr)
+    # define SIMD_STORE(ptr, v) _mm512_storeu_pd(ptr, v)
+    # define SIMD_ADD(a, b) _mm512_add_pd(a, b)
+    # define SIMD_SUB(a, b) _mm512_sub_pd(a, b)
+    # define SIMD_MUL(a, b) _mm512_mul_pd(a, b)
+# elif QuEST_PREC==2
+    typedef __m256d qrealSIMD;
+    # define SIMD_WIDTH 4
+    # define SIMD_SET1(x) _mm256_set1_pd(x)
+    # define SIMD_LOAD(ptr) _mm256_loadu_pd(ptr)
+    # define SIMD_STORE(ptr, v) _mm256_storeu_pd(ptr, v)
+    # define SIMD_ADD(a, b) _mm256_add_pd(a, b)
+    # define SIMD_SUB(a, b) _mm256_sub_pd(a, b)
+    # define SIMD_MUL(a, b) _mm256_mul_pd(a, b)
+# else
+    typedef qreal qrealSIMD;
+    # define SIMD_WIDTH 1
+    # define SIMD_SET1(x) (x)
+    # define SIMD_LOAD(ptr) (*(ptr))
+    # define SIMD_STORE(ptr, v) (*(ptr) = (v))
+    # define SIMD_ADD(a, b) ((a) + (b))
+    # define SIMD_SUB(a, b) ((a) - (b))
+    # define SIMD_MUL(a, b) ((a) * (b))
+# endif
 
 /*
 * Bit twiddling functions are defined seperately here in the CPU backend, 
@@ -59,6 +141,8 @@ inline long long int insertTwoZeroBits(long long int number, int bit1, int bit2)
 
 qreal densmatr_calcPurityLocal(Qureg qureg);
 
+qreal densmatr_calcExpecPauliSumLocal(Qureg qureg, enum pauliOpType* allCodes, qreal* termCoeffs, int numSumTerms);
+
 void densmatr_initPureStateLocal(Qureg targetQureg, Qureg copyQureg);
 
 qreal densmatr_calcFidelityLocal(Qureg qureg, Qureg pureState);
@@ -69,6 +153,12 @@ qreal densmatr_calcInnerProductLocal(Qureg a, Qureg b);
 
 qreal densmatr_findProbabilityOfZeroLocal(Qureg qureg, const int measureQubit);
 
+void densmatr_calcProbOfAllOutcomesLocal(qreal* outcomeProbs, Qureg qureg, int* qubits, int numQubits);
+
+qreal densmatr_calcProbOfOutcomesLocal(Qureg qureg, int* qubits, int* outcomes, int numQubits);
+
+void densmatr_calcReducedDensityMatrixLocal(Qureg qureg, int* keepQubits, int numKeep, qreal* reSums, qreal* imSums);
+
 void densmatr_mixDepolarisingLocal(Qureg qureg, const int targetQubit, qreal depolLevel);
 
 void densmatr_mixDepolarisingDistributed(Qureg qureg, const int targetQubit, qreal depolLevel);
@@ -77,6 +167,10 @@ void densmatr_mixDampingLocal(Qureg qureg, const int targetQubit, qreal damping)
 
 void densmatr_mixDampingDistributed(Qureg qureg, const int targetQubit, qreal damping);
 
+void densmatr_mixDepolarisingOnQubitsLocal(Qureg qureg, int* targets, int numTargets, qreal depolLevel);
+
+void densmatr_mixDampingOnQubitsLocal(Qureg qureg, int* targets, int numTargets, qreal damping);
+
 void densmatr_mixTwoQubitDepolarisingLocal(Qureg qureg, int qubit1, int qubit2, qreal delta, qreal gamma);
 
 void densmatr_mixTwoQubitDepolarisingLocalPart1(Qureg qureg, int qubit1, int qubit2, qreal delta);
@@ -87,6 +181,77 @@ void densmatr_mixTwoQubitDepolarisingDistributed(Qureg qureg, const int targetQu
 void densmatr_mixTwoQubitDepolarisingQ1LocalQ2DistributedPart3(Qureg qureg, const int targetQubit,
                 const int qubit2, qreal delta, qreal gamma);
 
+void densmatr_multiControlledUnitaryLocal(Qureg qureg, long long int ctrlQubitsMask, long long int ctrlFlipMask, const int targetQubit, ComplexMatrix2 u);
+
+void densmatr_multiControlledTwoQubitUnitaryLocal(Qureg qureg, long long int ctrlMask, const int q1, const int q2, ComplexMatrix4 u);
+
+
+/*
+ * packed density matrix operations
+ */
+
+void packmatr_multiControlledUnitaryLocal(Qureg qureg, long long int ctrlQubitsMask, long long int ctrlFlipMask, const int targetQubit, ComplexMatrix2 u);
+
+void packmatr_multiControlledTwoQubitUnitaryLocal(Qureg qureg, long long int ctrlMask, const int q1, const int q2, ComplexMatrix4 u);
+
+void packmatr_phaseShiftByTermLocal(Qureg qureg, long long int ctrlMask, const int targetQubit, Complex term);
+
+void packmatr_mixDephasingLocal(Qureg qureg, const int targetQubit, qreal dephase);
+
+void packmatr_mixDepolarisingLocal(Qureg qureg, const int targetQubit, qreal depolLevel);
+
+void packmatr_mixDampingLocal(Qureg qureg, const int targetQubit, qreal damping);
+
+void packmatr_mixDephasingAllLocal(Qureg qureg, qreal dephase);
+
+void packmatr_initClassicalStateLocal(Qureg qureg, long long int stateInd);
+
+void packmatr_initPureStateLocal(Qureg qureg, Qureg pureState);
+
+qreal packmatr_calcTotalProbLocal(Qureg qureg);
+
+qreal packmatr_calcProbOfOutcomeLocal(Qureg qureg, const int measureQubit, int outcome);
+
+qreal packmatr_calcPurityLocal(Qureg qureg);
+
+void packmatr_calcReducedDensityMatrixLocal(Qureg qureg, int* keepQubits, int numKeep, qreal* reSums, qreal* imSums);
+
+qreal packmatr_calcExpecPauliSumLocal(Qureg qureg, enum pauliOpType* allCodes, qreal* termCoeffs, int numSumTerms);
+
+qreal packmatr_calcFidelityLocal(Qureg qureg, Qureg pureState);
+
+
+/*
+ * real-amplitude state vector operations
+ */
+
+void realvec_multiControlledUnitaryLocal(Qureg qureg, const int targetQubit, long long int ctrlQubitsMask, long long int ctrlFlipMask, ComplexMatrix2 u);
+
+void realvec_multiControlledUnitaryDistributed(Qureg qureg, long long int ctrlQubitsMask, long long int ctrlFlipMask,
+        qreal rot1, qreal rot2, qreal* stateVecUp, qreal* stateVecLo, qreal* stateVecOut);
+
+void realvec_swapQubitAmpsLocal(Qureg qureg, int qb1, int qb2);
+
+void realvec_swapQubitAmpsDistributed(Qureg qureg, int pairRank, int qb1, int qb2);
+
+void realvec_multiControlledTwoQubitUnitaryLocal(Qureg qureg, long long int ctrlMask, const int q1, const int q2, ComplexMatrix4 u);
+
+void realvec_multiControlledMultiQubitUnitaryLocal(Qureg qureg, long long int ctrlMask, int* targs, const int numTargs, ComplexMatrixN u);
+
+qreal realvec_findProbabilityOfZeroLocal(Qureg qureg, const int measureQubit);
+
+qreal realvec_findProbabilityOfZeroDistributed(Qureg qureg);
+
+void realvec_collapseToKnownProbOutcomeLocal(Qureg qureg, int measureQubit, int outcome, qreal totalProbability);
+
+void realvec_scaleAmpsLocal(Qureg qureg, qreal factor);
+
+qreal realvec_calcTotalProbLocal(Qureg qureg);
+
+qreal realvec_calcInnerProductLocal(Qureg bra, Qureg ket);
+
+qreal realvec_calcExpecPauliProdLocal(Qureg qureg, enum pauliOpType* termCodes, qreal* flippedAmps);
+
 
 /*
  * state vector operations
@@ -212,8 +377,24 @@ qreal statevec_findProbabilityOfZeroLocal (Qureg qureg, const int measureQubit);
 
 qreal statevec_findProbabilityOfZeroDistributed (Qureg qureg);
 
+void statevec_calcQubitDensityMatrixLocal(Qureg qureg, const int qubit, qreal sums[4]);
+
+void statevec_calcQubitDensityMatrixDistributed(Qureg qureg, ComplexArray stateVecUp, ComplexArray stateVecLo, qreal sums[4]);
+
+void statevec_calcProbOfAllOutcomesLocal(qreal* outcomeProbs, Qureg qureg, int* qubits, int numQubits);
+
+qreal statevec_calcProbOfOutcomesLocal(Qureg qureg, int* qubits, int* outcomes, int numQubits);
+
+void statevec_calcReducedDensityMatrixLocal(Qureg qureg, int* keepQubits, int numKeep, qreal* reSums, qreal* imSums);
+
+qreal statevec_calcProbOfBlocksLocal(Qureg qureg, qreal* blockProbs);
+
+long long int statevec_findCumulativeProbIndexLocal(Qureg qureg, qreal* blockProbs, qreal cumulProb, qreal* ampProb);
+
 void statevec_collapseToKnownProbOutcomeLocal(Qureg qureg, int measureQubit, int outcome, qreal totalProbability);
 
+int statevec_measureWithStatsLocal(Qureg qureg, int measureQubit, qreal *outcomeProb);
+
 void statevec_collapseToKnownProbOutcomeDistributedRenorm (Qureg qureg, const int measureQubit, const qreal totalProbability);
 
 void statevec_collapseToOutcomeDistributedSetZero(Qureg qureg);
@@ -226,5 +407,63 @@ void statevec_multiControlledTwoQubitUnitaryLocal(Qureg qureg, long long int ctr
 
 void statevec_multiControlledMultiQubitUnitaryLocal(Qureg qureg, long long int ctrlMask, int* targs, const int numTargs, ComplexMatrixN u);
 
+/*
+ * amplitude array allocation, defined in QuEST_cpu_memory.c
+ */
+
+qreal* allocAmpArray(size_t arrSize);
+
+void freeAmpArray(qreal* arr, size_t arrSize);
+
+int unshareAmpArray(qreal* arr, size_t arrSize);
+
+int shareAmpArray(qreal* target, qreal* source, size_t arrSize);
+
+qreal* snapshotAmpArray(qreal* arr, size_t arrSize);
+
+void freeAmpArraySnapshot(qreal* snapshot, size_t arrSize);
+
+qreal* allocFileAmpArray(size_t arrSize, char* dirName);
+
+void freeFileAmpArray(qreal* arr, size_t arrSize);
+
+int mapAmpArrayFromFile(qreal* arr, size_t arrSize, int fd, long long int offset);
+
+/*
+ * checkpoint file access, defined in QuEST_cpu_checkpoint.c
+ */
+
+char* getTempCheckpointName(char* filename);
+
+int createCheckpointFile(char* filename, long long int numBytes);
+
+int commitCheckpointFile(int fd, char* filename, int isComplete);
+
+int openCheckpointFile(char* filename);
+
+void closeCheckpointFile(int fd);
+
+int writeCheckpointBytes(int fd, void* buffer, long long int numBytes, long long int offset);
+
+int readCheckpointBytes(int fd, void* buffer, long long int numBytes, long long int offset);
+
+unsigned long long int calcCheckpointChecksum(qreal* arr, long long int numAmps, long long int firstIndex);
+
+int openTempCheckpointFile(char* filename);
+
+int syncCheckpointFile(int fd);
+
+/** A checkpoint written in the background by startCheckpointWriter(), as returned once finished */
+typedef struct {
+    CheckpointHeader header; // whose checksums are of this node's amplitudes only
+    char* filename;
+    int fd;
+    int isWritten;
+} CheckpointWrite;
+
+int startCheckpointWriter(Qureg qureg, CheckpointHeader header, int fd, char* filename);
+
+int finishCheckpointWriter(Qureg qureg, CheckpointWrite* write);
+
 
 # endif // QUEST_CPU_INTERNAL_H
@@ -19,6 +19,7 @@
 # include <stdlib.h>
 # include <stdio.h>
 # include <math.h>
+# include <string.h>
 # include <time.h>
 # include <sys/types.h>
 
@@ -31,14 +32,42 @@ void densmatr_mixDepolarising(Qureg qureg, const int targetQubit, qreal depolLev
     if (depolLevel == 0)
         return;
 
-    densmatr_mixDepolarisingLocal(qureg, targetQubit, depolLevel);
+    if (qureg.isPacked)
+        packmatr_mixDepolarisingLocal(qureg, targetQubit, depolLevel);
+    else
+        densmatr_mixDepolarisingLocal(qureg, targetQubit, depolLevel);
 }
 
 void densmatr_mixDamping(Qureg qureg, const int targetQubit, qreal damping) {
     if (damping == 0)
         return;
 
-    densmatr_mixDampingLocal(qureg, targetQubit, damping);
+    if (qureg.isPacked)
+        packmatr_mixDampingLocal(qureg, targetQubit, damping);
+    else
+        densmatr_mixDampingLocal(qureg, targetQubit, damping);
+}
+
+void densmatr_mixDepolarisingOnQubits(Qureg qureg, int* targets, int numTargets, qreal depolLevel) {
+    if (depolLevel == 0)
+        return;
+
+    if (qureg.isPacked)
+        for (int t=0; t < numTargets; t++)
+            packmatr_mixDepolarisingLocal(qureg, targets[t], depolLevel);
+    else
+        densmatr_mixDepolarisingOnQubitsLocal(qureg, targets, numTargets, depolLevel);
+}
+
+void densmatr_mixDampingOnQubits(Qureg qureg, int* targets, int numTargets, qreal damping) {
+    if (damping == 0)
+        return;
+
+    if (qureg.isPacked)
+        for (int t=0; t < numTargets; t++)
+            packmatr_mixDampingLocal(qureg, targets[t], damping);
+    else
+        densmatr_mixDampingOnQubitsLocal(qureg, targets, numTargets, damping);
 }
 
 void densmatr_mixTwoQubitDepolarising(Qureg qureg, int qubit1, int qubit2, qreal depolLevel){
@@ -55,9 +84,17 @@ void densmatr_mixTwoQubitDepolarising(Qureg qureg, int qubit1, int qubit2, qreal
 }
 
 qreal densmatr_calcPurity(Qureg qureg) {
+    if (qureg.isPacked)
+        return packmatr_calcPurityLocal(qureg);
     return densmatr_calcPurityLocal(qureg);
 }
 
+qreal densmatr_calcExpecPauliSum(Qureg qureg, enum pauliOpType* allCodes, qreal* termCoeffs, int numSumTerms) {
+    if (qureg.isPacked)
+        return packmatr_calcExpecPauliSumLocal(qureg, allCodes, termCoeffs, numSumTerms);
+    return densmatr_calcExpecPauliSumLocal(qureg, allCodes, termCoeffs, numSumTerms);
+}
+
 qreal densmatr_calcHilbertSchmidtDistance(Qureg a, Qureg b) {
     
     qreal distSquared = densmatr_calcHilbertSchmidtDistanceSquaredLocal(a, b);
@@ -73,6 +110,9 @@ qreal densmatr_calcInnerProduct(Qureg a, Qureg b) {
 
 qreal densmatr_calcFidelity(Qureg qureg, Qureg pureState) {
     
+    if (qureg.isPacked)
+        return packmatr_calcFidelityLocal(qureg, pureState);
+    
     // save pointers to qureg's pair state
     qreal* quregPairRePtr = qureg.pairStateVec.real;
     qreal* quregPairImPtr = qureg.pairStateVec.imag;
@@ -93,6 +133,11 @@ qreal densmatr_calcFidelity(Qureg qureg, Qureg pureState) {
 
 void densmatr_initPureState(Qureg qureg, Qureg pureState) {
     
+    if (qureg.isPacked) {
+        packmatr_initPureStateLocal(qureg, pureState);
+        return;
+    }
+    
     // save pointers to qureg's pair state
     qreal* quregPairRePtr = qureg.pairStateVec.real;
     qreal* quregPairImPtr = qureg.pairStateVec.imag;
@@ -110,11 +155,16 @@ void densmatr_initPureState(Qureg qureg, Qureg pureState) {
 }
 
 Complex statevec_calcInnerProduct(Qureg bra, Qureg ket) {
+    if (bra.isReal)
+        return (Complex) {.real=realvec_calcInnerProductLocal(bra, ket), .imag=0};
     return statevec_calcInnerProductLocal(bra, ket);
 }
 
 qreal densmatr_calcTotalProb(Qureg qureg) {
     
+    if (qureg.isPacked)
+        return packmatr_calcTotalProbLocal(qureg);
+    
     // computes the trace using Kahan summation
     qreal pTotal=0;
     qreal y, t, c;
@@ -137,6 +187,9 @@ qreal densmatr_calcTotalProb(Qureg qureg) {
 }
 
 qreal statevec_calcTotalProb(Qureg qureg){
+    if (qureg.isReal)
+        return realvec_calcTotalProbLocal(qureg);
+
     // implemented using Kahan summation for greater accuracy at a slight floating
     // point operation overhead. For more details see https://en.wikipedia.org/wiki/Kahan_summation_algorithm
     qreal pTotal=0; 
@@ -189,6 +242,7 @@ int syncQuESTSuccess(int successCode){
 
 void destroyQuESTEnv(QuESTEnv env){
     // MPI finalize goes here in MPI version. Call this function anyway for consistency
+    statevec_setQuregPoolCapacity(0);
 }
 
 void reportQuESTEnv(QuESTEnv env){
@@ -209,11 +263,18 @@ qreal statevec_getRealAmp(Qureg qureg, long long int index){
 }
 
 qreal statevec_getImagAmp(Qureg qureg, long long int index){
+    if (qureg.isReal)
+        return 0;
     return qureg.stateVec.imag[index];
 }
 
 void statevec_compactUnitary(Qureg qureg, const int targetQubit, Complex alpha, Complex beta) 
 {
+    if (qureg.isReal) {
+        realvec_multiControlledUnitaryLocal(qureg, targetQubit, 0, 0, getCompactUnitaryMatrix(alpha, beta));
+        return;
+    }
+
     // statevec_compactUnitaryLocal(qureg, targetQubit, alpha, beta);
     statevec_compactUnitaryLocalSmall(qureg, targetQubit, alpha, beta);
 
@@ -221,11 +282,20 @@ void statevec_compactUnitary(Qureg qureg, const int targetQubit, Complex alpha,
 
 void statevec_unitary(Qureg qureg, const int targetQubit, ComplexMatrix2 u) 
 {
+    if (qureg.isReal) {
+        realvec_multiControlledUnitaryLocal(qureg, targetQubit, 0, 0, u);
+        return;
+    }
     statevec_unitaryLocal(qureg, targetQubit, u);
 }
 
 void statevec_controlledCompactUnitary(Qureg qureg, const int controlQubit, const int targetQubit, Complex alpha, Complex beta) 
 {
+    if (qureg.isReal) {
+        realvec_multiControlledUnitaryLocal(qureg, targetQubit, 1LL << controlQubit, 0, getCompactUnitaryMatrix(alpha, beta));
+        return;
+    }
+
     // if ((qureg.numAmpsPerChunk >> (targetQubit + 1) ) >= 8) {
     // statevec_controlledCompactUnitaryLocalSmall(qureg, controlQubit, targetQubit, alpha, beta);
     // } else {
@@ -238,16 +308,55 @@ void statevec_controlledCompactUnitary(Qureg qureg, const int controlQubit, cons
 
 void statevec_controlledUnitary(Qureg qureg, const int controlQubit, const int targetQubit, ComplexMatrix2 u) 
 {
+    if (qureg.isReal) {
+        realvec_multiControlledUnitaryLocal(qureg, targetQubit, 1LL << controlQubit, 0, u);
+        return;
+    }
     statevec_controlledUnitaryLocal(qureg, controlQubit, targetQubit, u);
 }
 
 void statevec_multiControlledUnitary(Qureg qureg, long long int ctrlQubitsMask, long long int ctrlFlipMask, const int targetQubit, ComplexMatrix2 u) 
 {
+    if (qureg.isReal) {
+        realvec_multiControlledUnitaryLocal(qureg, targetQubit, ctrlQubitsMask, ctrlFlipMask, u);
+        return;
+    }
     statevec_multiControlledUnitaryLocal(qureg, targetQubit, ctrlQubitsMask, ctrlFlipMask, u);
 }
 
+void densmatr_multiControlledUnitary(Qureg qureg, long long int ctrlQubitsMask, long long int ctrlFlipMask, const int targetQubit, ComplexMatrix2 u) 
+{
+    if (qureg.isPacked)
+        packmatr_multiControlledUnitaryLocal(qureg, ctrlQubitsMask, ctrlFlipMask, targetQubit, u);
+    else
+        densmatr_multiControlledUnitaryLocal(qureg, ctrlQubitsMask, ctrlFlipMask, targetQubit, u);
+}
+
+void densmatr_phaseShiftByTerm(Qureg qureg, long long int ctrlMask, const int targetQubit, Complex term) 
+{
+    if (qureg.isPacked)
+        packmatr_phaseShiftByTermLocal(qureg, ctrlMask, targetQubit, term);
+    else {
+        ComplexMatrix2 u = {.real = {{1, 0}, {0, term.real}}, .imag = {{0, 0}, {0, term.imag}}};
+        densmatr_multiControlledUnitaryLocal(qureg, ctrlMask, 0, targetQubit, u);
+    }
+}
+
+void densmatr_multiControlledTwoQubitUnitary(Qureg qureg, long long int ctrlMask, const int targetQubit1, const int targetQubit2, ComplexMatrix4 u) 
+{
+    if (qureg.isPacked)
+        packmatr_multiControlledTwoQubitUnitaryLocal(qureg, ctrlMask, targetQubit1, targetQubit2, u);
+    else
+        densmatr_multiControlledTwoQubitUnitaryLocal(qureg, ctrlMask, targetQubit1, targetQubit2, u);
+}
+
 void statevec_pauliX(Qureg qureg, const int targetQubit) 
 {
+    if (qureg.isReal) {
+        realvec_multiControlledUnitaryLocal(qureg, targetQubit, 0, 0, (ComplexMatrix2) {.real={{0,1},{1,0}}});
+        return;
+    }
+
     // statevec_pauliXLocal(qureg, targetQubit);
     statevec_pauliXLocalSmall(qureg, targetQubit);
 }
@@ -282,37 +391,148 @@ void statevec_controlledPauliYConj(Qureg qureg, const int controlQubit, const in
 
 void statevec_hadamard(Qureg qureg, const int targetQubit) 
 {
+    if (qureg.isReal) {
+        qreal r = 1/sqrt(2);
+        realvec_multiControlledUnitaryLocal(qureg, targetQubit, 0, 0, (ComplexMatrix2) {.real={{r,r},{r,-r}}});
+        return;
+    }
+
     // statevec_hadamardLocal(qureg, targetQubit);
     statevec_hadamardLocalSmall(qureg, targetQubit);
 }
 
 void statevec_controlledNot(Qureg qureg, const int controlQubit, const int targetQubit) 
 {
+    if (qureg.isReal) {
+        realvec_multiControlledUnitaryLocal(qureg, targetQubit, 1LL << controlQubit, 0, (ComplexMatrix2) {.real={{0,1},{1,0}}});
+        return;
+    }
+
     // statevec_controlledNotLocal(qureg, controlQubit, targetQubit);
     statevec_controlledNotLocalSmall(qureg, controlQubit, targetQubit);
 }
 
 qreal statevec_calcProbOfOutcome(Qureg qureg, const int measureQubit, int outcome)
 {
+    if (qureg.isSubspace)
+        return subspace_calcProbOfOutcome(qureg, measureQubit, outcome);
+    
     qreal stateProb=0;
-    stateProb = statevec_findProbabilityOfZeroLocal(qureg, measureQubit);
+    if (qureg.isReal)
+        stateProb = realvec_findProbabilityOfZeroLocal(qureg, measureQubit);
+    else
+        stateProb = statevec_findProbabilityOfZeroLocal(qureg, measureQubit);
     if (outcome==1) stateProb = 1.0 - stateProb;
     return stateProb;
 }
 
+ComplexMatrix2 statevec_calcQubitDensityMatrix(Qureg qureg, const int qubit) {
+    
+    qreal sums[4];
+    statevec_calcQubitDensityMatrixLocal(qureg, qubit, sums);
+    
+    ComplexMatrix2 rho = {
+        .real = {{sums[0], sums[2]}, {sums[2], sums[1]}},
+        .imag = {{0, sums[3]}, {-sums[3], 0}}};
+    return rho;
+}
+
 qreal densmatr_calcProbOfOutcome(Qureg qureg, const int measureQubit, int outcome) {
     
+    if (qureg.isPacked)
+        return packmatr_calcProbOfOutcomeLocal(qureg, measureQubit, outcome);
+    
     qreal outcomeProb = densmatr_findProbabilityOfZeroLocal(qureg, measureQubit);
     if (outcome == 1)
         outcomeProb = 1.0 - outcomeProb;
     return outcomeProb;
 }
 
+void statevec_calcProbOfAllOutcomes(qreal* outcomeProbs, Qureg qureg, int* qubits, int numQubits) {
+    
+    statevec_calcProbOfAllOutcomesLocal(outcomeProbs, qureg, qubits, numQubits);
+}
+
+void densmatr_calcProbOfAllOutcomes(qreal* outcomeProbs, Qureg qureg, int* qubits, int numQubits) {
+    
+    densmatr_calcProbOfAllOutcomesLocal(outcomeProbs, qureg, qubits, numQubits);
+}
+
+qreal statevec_calcProbOfOutcomes(Qureg qureg, int* qubits, int* outcomes, int numQubits) {
+    
+    return statevec_calcProbOfOutcomesLocal(qureg, qubits, outcomes, numQubits);
+}
+
+qreal densmatr_calcProbOfOutcomes(Qureg qureg, int* qubits, int* outcomes, int numQubits) {
+    
+    return densmatr_calcProbOfOutcomesLocal(qureg, qubits, outcomes, numQubits);
+}
+
+void statevec_sampleOutcomes(Qureg qureg, int* qubits, int numQubits, int numShots, long long int* outcomes) {
+    
+    qreal* outcomeProbs = allocOutcomeProbs(numQubits, __func__);
+    statevec_calcProbOfAllOutcomesLocal(outcomeProbs, qureg, qubits, numQubits);
+    sampleFromOutcomeProbs(outcomeProbs, 1LL << numQubits, numShots, outcomes);
+    free(outcomeProbs);
+}
+
+void statevec_calcReducedDensityMatrix(Qureg qureg, int* keepQubits, int numKeep, ComplexMatrixN out) {
+    
+    long long int numElems = 1LL << (2*numKeep);
+    qreal *sums = malloc(2*numElems * sizeof *sums);
+    statevec_calcReducedDensityMatrixLocal(qureg, keepQubits, numKeep, sums, &sums[numElems]);
+    setMatrixNFromRowMajor(out, sums, &sums[numElems]);
+    free(sums);
+}
+
+void densmatr_calcReducedDensityMatrix(Qureg qureg, int* keepQubits, int numKeep, ComplexMatrixN out) {
+    
+    long long int numElems = 1LL << (2*numKeep);
+    qreal *sums = malloc(2*numElems * sizeof *sums);
+    if (qureg.isPacked)
+        packmatr_calcReducedDensityMatrixLocal(qureg, keepQubits, numKeep, sums, &sums[numElems]);
+    else
+        densmatr_calcReducedDensityMatrixLocal(qureg, keepQubits, numKeep, sums, &sums[numElems]);
+    setMatrixNFromRowMajor(out, sums, &sums[numElems]);
+    free(sums);
+}
+
+long long int statevec_sampleBasisState(Qureg qureg, qreal rand, qreal* outcomeProb) {
+    
+    qreal blockProbs[NUM_SAMPLE_BLOCKS];
+    qreal totalProb = statevec_calcProbOfBlocksLocal(qureg, blockProbs);
+    
+    qreal ampProb;
+    long long int stateInd = statevec_findCumulativeProbIndexLocal(qureg, blockProbs, rand*totalProb, &ampProb);
+    *outcomeProb = ampProb / totalProb;
+    return stateInd;
+}
+
 void statevec_collapseToKnownProbOutcome(Qureg qureg, const int measureQubit, int outcome, qreal stateProb)
 {
+    if (qureg.isReal) {
+        realvec_collapseToKnownProbOutcomeLocal(qureg, measureQubit, outcome, stateProb);
+        return;
+    }
+    if (qureg.isSubspace) {
+        subspace_collapseToKnownProbOutcome(qureg, measureQubit, outcome, stateProb);
+        return;
+    }
     statevec_collapseToKnownProbOutcomeLocal(qureg, measureQubit, outcome, stateProb);
 }
 
+int statevec_measureWithStats(Qureg qureg, int measureQubit, qreal *outcomeProb) {
+    
+    // complex amplitudes are measured and collapsed in one parallel region
+    if (!qureg.isReal && !qureg.isSubspace)
+        return statevec_measureWithStatsLocal(qureg, measureQubit, outcomeProb);
+    
+    qreal zeroProb = statevec_calcProbOfOutcome(qureg, measureQubit, 0);
+    int outcome = generateMeasurementOutcome(zeroProb, outcomeProb);
+    statevec_collapseToKnownProbOutcome(qureg, measureQubit, outcome, *outcomeProb);
+    return outcome;
+}
+
 void seedQuESTDefault(void){
     // init MT random number generator with three keys -- time and pid
     // for the MPI version, it is ok that all procs will get the same seed as random numbers will only be 
@@ -325,15 +545,136 @@ void seedQuESTDefault(void){
 
 void statevec_multiControlledTwoQubitUnitary(Qureg qureg, long long int ctrlMask, const int q1, const int q2, ComplexMatrix4 u)
 {
+    if (qureg.isSubspace) {
+        subspace_multiControlledTwoQubitUnitary(qureg, ctrlMask, q1, q2, u);
+        return;
+    }
+    if (qureg.isReal) {
+        realvec_multiControlledTwoQubitUnitaryLocal(qureg, ctrlMask, q1, q2, u);
+        return;
+    }
     statevec_multiControlledTwoQubitUnitaryLocal(qureg, ctrlMask, q1, q2, u);
 }
 
 void statevec_multiControlledMultiQubitUnitary(Qureg qureg, long long int ctrlMask, int* targs, const int numTargs, ComplexMatrixN u)
 {
+    if (qureg.isReal) {
+        realvec_multiControlledMultiQubitUnitaryLocal(qureg, ctrlMask, targs, numTargs, u);
+        return;
+    }
     statevec_multiControlledMultiQubitUnitaryLocal(qureg, ctrlMask, targs, numTargs, u);
 }
 
 void statevec_swapQubitAmps(Qureg qureg, int qb1, int qb2) 
 {
+    if (qureg.isReal) {
+        realvec_swapQubitAmpsLocal(qureg, qb1, qb2);
+        return;
+    }
+    if (qureg.isSubspace) {
+        subspace_swapQubitAmps(qureg, qb1, qb2);
+        return;
+    }
     statevec_swapQubitAmpsLocal(qureg, qb1, qb2);
 }
+
+qreal realvec_calcExpecPauliSum(Qureg qureg, enum pauliOpType* allCodes, qreal* termCoeffs, int numSumTerms)
+{
+    qreal value = 0;
+    for (int t=0; t < numSumTerms; t++)
+        value += termCoeffs[t] * realvec_calcExpecPauliProdLocal(
+            qureg, &allCodes[t*qureg.numQubitsRepresented], qureg.stateVec.real);
+    return value;
+}
+
+int statevec_writeCheckpoint(Qureg qureg, char* filename) {
+
+    CheckpointHeader header;
+    statevec_initCheckpointHeader(qureg, &header);
+    long long int arrBytes = header.numAmps * sizeof(qreal);
+    int numArrs = (qureg.isReal)? 1 : 2;
+
+    int fd = createCheckpointFile(filename, CHECKPOINT_DATA_OFFSET + numArrs*arrBytes);
+    if (fd < 0)
+        return 0;
+
+    header.realChecksum = calcCheckpointChecksum(qureg.stateVec.real, header.numAmps, 0);
+    int success = writeCheckpointBytes(fd, qureg.stateVec.real, arrBytes, CHECKPOINT_DATA_OFFSET);
+    if (!qureg.isReal) {
+        header.imagChecksum = calcCheckpointChecksum(qureg.stateVec.imag, header.numAmps, 0);
+        success = success && writeCheckpointBytes(fd, qureg.stateVec.imag, arrBytes, CHECKPOINT_DATA_OFFSET + arrBytes);
+    }
+
+    // the header is written last, so is only valid once the amplitudes are
+    success = success && writeCheckpointBytes(fd, &header, sizeof header, 0);
+    return commitCheckpointFile(fd, filename, success);
+}
+
+int statevec_startCheckpoint(Qureg qureg, char* filename, long long int gateIndex) {
+
+    CheckpointHeader header;
+    statevec_initCheckpointHeader(qureg, &header);
+    header.gateIndex = gateIndex;
+    int numArrs = (qureg.isReal)? 1 : 2;
+
+    int fd = createCheckpointFile(filename, CHECKPOINT_DATA_OFFSET + numArrs * header.numAmps * sizeof(qreal));
+    if (fd < 0)
+        return 0;
+    if (!startCheckpointWriter(qureg, header, fd, filename))
+        return commitCheckpointFile(fd, filename, 0);
+    return 1;
+}
+
+int statevec_finishCheckpoint(Qureg qureg) {
+
+    CheckpointWrite write;
+    if (!finishCheckpointWriter(qureg, &write))
+        return 1;
+
+    // the header is written last, so is only valid once the amplitudes are
+    int success = write.isWritten && writeCheckpointBytes(write.fd, &write.header, sizeof write.header, 0);
+    success = commitCheckpointFile(write.fd, write.filename, success);
+    free(write.filename);
+    return success;
+}
+
+int statevec_readCheckpointHeader(char* filename, CheckpointHeader* header) {
+
+    int fd = openCheckpointFile(filename);
+    if (fd < 0)
+        return 0;
+
+    // a file too short to hold a header is left with an invalid (zero) header
+    memset(header, 0, sizeof *header);
+    readCheckpointBytes(fd, header, sizeof *header, 0);
+    closeCheckpointFile(fd);
+    return 1;
+}
+
+/** overwrites arr with the amplitudes at the given offset of the file, mapping rather than reading
+ * them if requested and possible, returning whether they were entirely loaded
+ */
+static int loadCheckpointAmps(Qureg qureg, qreal* arr, int fd, long long int offset, int useMapping) {
+    long long int arrBytes = qureg.numAmpsPerChunk * sizeof(qreal);
+    if (useMapping && !qureg.isOutOfCore && mapAmpArrayFromFile(arr, arrBytes, fd, offset))
+        return 1;
+    return readCheckpointBytes(fd, arr, arrBytes, offset);
+}
+
+int statevec_readCheckpoint(Qureg qureg, char* filename, CheckpointHeader header, int useMapping) {
+
+    int fd = openCheckpointFile(filename);
+    if (fd < 0)
+        return 0;
+
+    long long int arrBytes = header.numAmps * sizeof(qreal);
+    int success = loadCheckpointAmps(qureg, qureg.stateVec.real, fd, CHECKPOINT_DATA_OFFSET, useMapping);
+    if (!qureg.isReal)
+        success = success && loadCheckpointAmps(qureg, qureg.stateVec.imag, fd, CHECKPOINT_DATA_OFFSET + arrBytes, useMapping);
+    closeCheckpointFile(fd);
+
+    success = success && calcCheckpointChecksum(qureg.stateVec.real, header.numAmps, 0) == header.realChecksum;
+    if (!qureg.isReal)
+        success = success && calcCheckpointChecksum(qureg.stateVec.imag, header.numAmps, 0) == header.imagChecksum;
+    return success;
+}
@@ -0,0 +1,336 @@
+// Distributed under MIT licence. See https://github.com/QuEST-Kit/QuEST/blob/master/LICENCE.txt for details
+
+/** @file
+ * Allocation of the amplitude arrays of CPU registers. On Linux, large arrays are mapped directly from
+ * the OS, so that they begin as (lazily committed) zero pages, and so that cloning a register can (if 
+ * enabled by setCopyOnWriteClones()) share the source's pages copy-on-write rather than copying them. 
+ * Clones are otherwise copied in parallel by the caller, which is faster whenever the clone is then 
+ * modified throughout, since each shared page costs a fault and a serial copy. Sharing works by backing the source with
+ * an anonymous in-memory file (memfd), which both registers then map privately: each page is only
+ * copied when either register first writes to it. A source whose pages have been modified since it was
+ * last shared (as reported by /proc/self/pagemap) is first written to a fresh file, so repeatedly
+ * cloning an unchanged register costs O(1).
+ * Elsewhere, and for small arrays, amplitudes are calloc'd and clones are copied.
+ *
+ * The arrays of out-of-core registers are instead shared mappings of (unlinked) files in a user-given
+ * directory, so that the OS pages them to and from disk; these are never pooled nor shared. Arrays
+ * restored from a checkpoint may be privately mapped from the checkpoint file. Snapshots of an array
+ * (written to disk by startQuregCheckpoint()) are read-only views of its memfd, so likewise only cost
+ * memory for the pages the register later modifies.
+ */
+
+# ifdef __linux__
+# define _GNU_SOURCE
+# endif
+
+# include "QuEST.h"
+# include "QuEST_precision.h"
+
+# include "QuEST_internal.h"
+# include "QuEST_cpu_internal.h"
+
+# include <stdio.h>
+# include <stdlib.h>
+# include <stdint.h>
+# include <string.h>
+
+# ifdef _OPENMP
+# include <omp.h>
+# endif
+
+/* Whether shareAmpArray() shares clones' pages, as set by setCopyOnWriteClones() */
+static int isSharingClones = 0;
+
+void statevec_setCopyOnWriteClones(int useCopyOnWrite) {
+    isSharingClones = useCopyOnWrite;
+}
+
+# ifdef __linux__
+# include <fcntl.h>
+# include <unistd.h>
+# include <sys/mman.h>
+# include <sys/syscall.h>
+
+/* The arrays currently mapped from a memfd, and the descriptor of that file */
+typedef struct {
+    qreal* arr;
+    int fd;
+} FileBackedArray;
+
+static FileBackedArray* fileBackedArrays = NULL;
+static int numFileBackedArrays = 0;
+
+static int isMappedArraySize(size_t arrSize) {
+    return arrSize >= MIN_MAPPED_ARRAY_SIZE && arrSize % sysconf(_SC_PAGESIZE) == 0;
+}
+
+static int getFileBackedArrayInd(qreal* arr) {
+    for (int i=0; i<numFileBackedArrays; i++)
+        if (fileBackedArrays[i].arr == arr)
+            return i;
+    return -1;
+}
+
+static void setArrayFile(qreal* arr, int fd) {
+    int i = getFileBackedArrayInd(arr);
+    if (i >= 0) {
+        close(fileBackedArrays[i].fd);
+        fileBackedArrays[i].fd = fd;
+        return;
+    }
+    fileBackedArrays = realloc(fileBackedArrays, (numFileBackedArrays+1) * sizeof *fileBackedArrays);
+    fileBackedArrays[numFileBackedArrays].arr = arr;
+    fileBackedArrays[numFileBackedArrays].fd = fd;
+    numFileBackedArrays++;
+}
+
+/** Forget that arr is mapped from a file, returning whether it was */
+static int unsetArrayFile(qreal* arr) {
+    int i = getFileBackedArrayInd(arr);
+    if (i < 0)
+        return 0;
+    close(fileBackedArrays[i].fd);
+    fileBackedArrays[i] = fileBackedArrays[--numFileBackedArrays];
+    return 1;
+}
+
+/** Whether any page of a privately file-mapped array has been written (and so no longer matches the
+ * file), judged from the page flags of /proc/self/pagemap: a written page is present but no longer
+ * a file page, or has been swapped. Conservatively reports 1 if pagemap cannot be read.
+ */
+static int isArrayModifiedFromFile(qreal* arr, size_t arrSize) {
+
+    int pagemap = open("/proc/self/pagemap", O_RDONLY);
+    if (pagemap < 0)
+        return 1;
+
+    const long pageSize = sysconf(_SC_PAGESIZE);
+    const size_t numPages = arrSize / pageSize;
+    const off_t firstEntry = (off_t) ((uintptr_t) arr / pageSize) * sizeof(uint64_t);
+    uint64_t entries[512];
+
+    for (size_t page=0; page < numPages; page += 512) {
+        size_t numEntries = (numPages - page < 512)? numPages - page : 512;
+        ssize_t numBytes = numEntries * sizeof(uint64_t);
+        if (pread(pagemap, entries, numBytes, firstEntry + page*sizeof(uint64_t)) != numBytes) {
+            close(pagemap);
+            return 1;
+        }
+        for (size_t e=0; e < numEntries; e++) {
+            int isPresent  = (entries[e] >> 63) & 1;
+            int isSwapped  = (entries[e] >> 62) & 1;
+            int isFilePage = (entries[e] >> 61) & 1;
+            if (isSwapped || (isPresent && !isFilePage)) {
+                close(pagemap);
+                return 1;
+            }
+        }
+    }
+    close(pagemap);
+    return 0;
+}
+
+/** Replace the pages of arr with a private mapping of a new memfd holding arr's current contents,
+ * returning the file descriptor (owned by arr), or -1 if this failed and arr is unchanged.
+ */
+static int moveArrayToNewFile(qreal* arr, size_t arrSize) {
+
+    int fd = syscall(SYS_memfd_create, "quest_amps", 0);
+    if (fd < 0)
+        return -1;
+    if (ftruncate(fd, arrSize) != 0) {
+        close(fd);
+        return -1;
+    }
+
+    // write may copy fewer bytes than requested (at most ~2GiB per call)
+    char* src = (char*) arr;
+    size_t numWritten = 0;
+    while (numWritten < arrSize) {
+        ssize_t n = pwrite(fd, src + numWritten, arrSize - numWritten, numWritten);
+        if (n <= 0) {
+            close(fd);
+            return -1;
+        }
+        numWritten += n;
+    }
+
+    if (mmap(arr, arrSize, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_FIXED, fd, 0) == MAP_FAILED) {
+        close(fd);
+        return -1;
+    }
+    setArrayFile(arr, fd);
+    return fd;
+}
+
+qreal* allocAmpArray(size_t arrSize) {
+    if (!isMappedArraySize(arrSize))
+        return calloc(1, arrSize);
+
+    void* arr = mmap(NULL, arrSize, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+    return (arr == MAP_FAILED)? NULL : arr;
+}
+
+void freeAmpArray(qreal* arr, size_t arrSize) {
+    if (arr == NULL)
+        return;
+    if (!isMappedArraySize(arrSize)) {
+        free(arr);
+        return;
+    }
+    unsetArrayFile(arr);
+    munmap(arr, arrSize);
+}
+
+/** Get the descriptor of a memfd (owned by arr) which matches arr's current contents, (re)writing one
+ * if arr has none or has since been modified, or -1 if this failed
+ */
+static int getArrayFile(qreal* arr, size_t arrSize) {
+    int i = getFileBackedArrayInd(arr);
+    int fd = (i >= 0)? fileBackedArrays[i].fd : -1;
+    if (fd < 0 || isArrayModifiedFromFile(arr, arrSize))
+        fd = moveArrayToNewFile(arr, arrSize);
+    return fd;
+}
+
+int shareAmpArray(qreal* target, qreal* source, size_t arrSize) {
+    if (!isSharingClones || !isMappedArraySize(arrSize) || target == source)
+        return 0;
+
+    int fd = getArrayFile(source, arrSize);
+    if (fd < 0)
+        return 0;
+
+    // the target's old pages are discarded, and its new pages fault in from the file
+    int targetFd = dup(fd);
+    if (targetFd < 0)
+        return 0;
+    if (mmap(target, arrSize, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_FIXED, fd, 0) == MAP_FAILED) {
+        close(targetFd);
+        return 0;
+    }
+    setArrayFile(target, targetFd);
+    return 1;
+}
+
+qreal* snapshotAmpArray(qreal* arr, size_t arrSize) {
+    if (!isMappedArraySize(arrSize)) {
+        qreal* snapshot = malloc(arrSize);
+        if (snapshot != NULL)
+            memcpy(snapshot, arr, arrSize);
+        return snapshot;
+    }
+
+    // every mapping of arr's file is private, so the file is never modified and a view of it stays fixed
+    int fd = getArrayFile(arr, arrSize);
+    void* snapshot = (fd < 0)? MAP_FAILED : mmap(NULL, arrSize, PROT_READ, MAP_SHARED, fd, 0);
+    if (snapshot != MAP_FAILED)
+        return snapshot;
+
+    snapshot = mmap(NULL, arrSize, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+    if (snapshot == MAP_FAILED)
+        return NULL;
+    memcpy(snapshot, arr, arrSize);
+    return snapshot;
+}
+
+void freeAmpArraySnapshot(qreal* snapshot, size_t arrSize) {
+    if (snapshot == NULL)
+        return;
+    if (isMappedArraySize(arrSize))
+        munmap(snapshot, arrSize);
+    else
+        free(snapshot);
+}
+
+/** Detach arr from any file it was shared from, returning whether it was (leaving arr zero) */
+int unshareAmpArray(qreal* arr, size_t arrSize) {
+    if (!isMappedArraySize(arrSize) || !unsetArrayFile(arr))
+        return 0;
+
+    // swapping in fresh anonymous pages detaches arr from the file (and zeroes it)
+    mmap(arr, arrSize, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS|MAP_FIXED, -1, 0);
+    return 1;
+}
+
+qreal* allocFileAmpArray(size_t arrSize, char* dirName) {
+
+    char* path = malloc(strlen(dirName) + sizeof "/quest_amps_XXXXXX");
+    if (path == NULL)
+        return NULL;
+    sprintf(path, "%s/quest_amps_XXXXXX", dirName);
+
+    // the file persists only while mapped, and is created sparse so reads as zero
+    int fd = mkstemp(path);
+    if (fd >= 0)
+        unlink(path);
+    free(path);
+    if (fd < 0)
+        return NULL;
+    if (ftruncate(fd, arrSize) != 0) {
+        close(fd);
+        return NULL;
+    }
+
+    void* arr = mmap(NULL, arrSize, PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    return (arr == MAP_FAILED)? NULL : arr;
+}
+
+void freeFileAmpArray(qreal* arr, size_t arrSize) {
+    if (arr != NULL)
+        munmap(arr, arrSize);
+}
+
+int mapAmpArrayFromFile(qreal* arr, size_t arrSize, int fd, long long int offset) {
+    if (!isMappedArraySize(arrSize) || offset % sysconf(_SC_PAGESIZE) != 0)
+        return 0;
+
+    // arr's old pages (and any file they were shared from) are replaced by the file's, copied on write
+    if (mmap(arr, arrSize, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_FIXED, fd, offset) == MAP_FAILED)
+        return 0;
+    unsetArrayFile(arr);
+    return 1;
+}
+
+# else
+
+qreal* allocAmpArray(size_t arrSize) {
+    return calloc(1, arrSize);
+}
+
+void freeAmpArray(qreal* arr, size_t arrSize) {
+    free(arr);
+}
+
+int shareAmpArray(qreal* target, qreal* source, size_t arrSize) {
+    return 0;
+}
+
+qreal* snapshotAmpArray(qreal* arr, size_t arrSize) {
+    qreal* snapshot = malloc(arrSize);
+    if (snapshot != NULL)
+        memcpy(snapshot, arr, arrSize);
+    return snapshot;
+}
+
+void freeAmpArraySnapshot(qreal* snapshot, size_t arrSize) {
+    free(snapshot);
+}
+
+int unshareAmpArray(qreal* arr, size_t arrSize) {
+    return 0;
+}
+
+qreal* allocFileAmpArray(size_t arrSize, char* dirName) {
+    return NULL;
+}
+
+void freeFileAmpArray(qreal* arr, size_t arrSize) {
+}
+
+int mapAmpArrayFromFile(qreal* arr, size_t arrSize, int fd, long long int offset) {
+    return 0;
+}
+
+# endif
@@ -706,12 +706,44 @@ void densmatr_mixDephasing(Qureg qureg, const int targetQubit, qreal dephase){}
 void densmatr_mixTwoQubitDephasing(Qureg qureg, int qubit1, int qubit2, qreal dephase){}
 void densmatr_mixDepolarising(Qureg qureg, const int targetQubit, qreal depolLevel){}
 void densmatr_mixDamping(Qureg qureg, const int targetQubit, qreal damping){}
+void densmatr_mixDephasingAll(Qureg qureg, qreal dephase){}
+void densmatr_mixDepolarisingOnQubits(Qureg qureg, int* targets, int numTargets, qreal depolLevel){}
+void densmatr_mixDampingOnQubits(Qureg qureg, int* targets, int numTargets, qreal damping){}
 void densmatr_mixTwoQubitDepolarising(Qureg qureg, int qubit1, int qubit2, qreal depolLevel){}
 qreal densmatr_calcFidelity(Qureg qureg, Qureg pureState){return (qreal)0;}
 qreal densmatr_calcHilbertSchmidtDistanceSquared(Qureg a, Qureg b){return (qreal)0;}
 qreal densmatr_calcPurity(Qureg qureg){return (qreal)0;}
+qreal densmatr_calcExpecPauliSum(Qureg qureg, enum pauliOpType* allCodes, qreal* termCoeffs, int numSumTerms){return (qreal)0;}
 qreal densmatr_calcProbOfOutcome(Qureg qureg, const int measureQubit, int outcome){return (qreal)0;}
 qreal densmatr_findProbabilityOfZero(Qureg qureg, const int measureQubit){return (qreal)0;}
+void densmatr_calcProbOfAllOutcomes(qreal* outcomeProbs, Qureg qureg, int* qubits, int numQubits){}
+qreal densmatr_calcProbOfOutcomes(Qureg qureg, int* qubits, int* outcomes, int numQubits){return (qreal)0;}
+void densmatr_calcReducedDensityMatrix(Qureg qureg, int* keepQubits, int numKeep, ComplexMatrixN out){}
+void realvec_initBlankState(Qureg qureg){}
+void realvec_initClassicalState(Qureg qureg, long long int stateInd){}
+void realvec_initPlusState(Qureg qureg){}
+void realvec_setAmps(Qureg qureg, long long int startInd, qreal* reals, long long int numAmps){}
+void realvec_cloneQureg(Qureg targetQureg, Qureg copyQureg){}
+void realvec_multiControlledPhaseFlip(Qureg qureg, long long int mask){}
+qreal realvec_calcExpecPauliSum(Qureg qureg, enum pauliOpType* allCodes, qreal* termCoeffs, int numSumTerms){return (qreal)0;}
+void subspace_initClassicalState(Qureg qureg, long long int stateInd){}
+Complex subspace_getAmp(Qureg qureg, long long int index){return (Complex) {0};}
+void subspace_phaseShiftByTerm(Qureg qureg, long long int mask, Complex term){}
+void subspace_multiRotateZ(Qureg qureg, long long int mask, qreal angle){}
+void subspace_multiControlledTwoQubitUnitary(Qureg qureg, long long int ctrlMask, const int q1, const int q2, ComplexMatrix4 u){}
+void subspace_swapQubitAmps(Qureg qureg, int qb1, int qb2){}
+qreal subspace_calcProbOfOutcome(Qureg qureg, const int measureQubit, int outcome){return (qreal)0;}
+void subspace_collapseToKnownProbOutcome(Qureg qureg, const int measureQubit, int outcome, qreal totalProbability){}
+qreal subspace_calcExpecPauliSum(Qureg qureg, enum pauliOpType* allCodes, qreal* termCoeffs, int numSumTerms){return (qreal)0;}
+void compressed_destroyQureg(Qureg qureg){}
+void compressed_initClassicalState(Qureg qureg, long long int stateInd){}
+Complex compressed_getAmp(Qureg qureg, long long int index){return (Complex) {0};}
+qreal compressed_calcTotalProb(Qureg qureg){return (qreal)0;}
+qreal compressed_calcProbOfOutcome(Qureg qureg, int measureQubit, int outcome){return (qreal)0;}
+Complex compressed_calcInnerProduct(Qureg bra, Qureg ket){return (Complex) {0};}
+void compressed_applyToBlockGroups(Qureg qureg, int* highQubits, int numHighQubits, void (*applyToGroup)(Qureg group, void* args), void* args){}
+CompressionStats compressed_getStats(Qureg qureg){return (CompressionStats) {0};}
+void densmatr_collapseToOutcomes(Qureg qureg, int* qubits, int* outcomes, int numQubits, qreal outcomeProb){}
 qreal densmatr_calcTotalProb(Qureg qureg){return (qreal)0;}
 qreal densmatr_calcHilbertSchmidtDistance(Qureg a, Qureg b){return (qreal)0;}
 qreal densmatr_calcInnerProduct(Qureg a, Qureg b){return (qreal)0;}
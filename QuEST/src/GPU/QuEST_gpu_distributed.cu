@@ -1630,6 +1630,443 @@ qreal statevec_calcProbOfOutcome(Qureg qureg, const int measureQubit, int outcom
   return h_totalStateProb;
 }
 
+void densmatr_multiControlledUnitary(Qureg qureg, long long int ctrlQubitsMask, long long int ctrlFlipMask, const int targetQubit, ComplexMatrix2 u)
+{
+  // the fused single-pass kernel is CPU-only for now; apply u and conj(u) separately
+  int shift = qureg.numQubitsRepresented;
+  statevec_multiControlledUnitary(qureg, ctrlQubitsMask, ctrlFlipMask, targetQubit, u);
+  statevec_multiControlledUnitary(qureg, ctrlQubitsMask<<shift, ctrlFlipMask<<shift, targetQubit+shift, getConjugateMatrix2(u));
+}
+
+void densmatr_multiControlledTwoQubitUnitary(Qureg qureg, long long int ctrlMask, const int targetQubit1, const int targetQubit2, ComplexMatrix4 u)
+{
+  int shift = qureg.numQubitsRepresented;
+  statevec_multiControlledTwoQubitUnitary(qureg, ctrlMask, targetQubit1, targetQubit2, u);
+  statevec_multiControlledTwoQubitUnitary(qureg, ctrlMask<<shift, targetQubit1+shift, targetQubit2+shift, getConjugateMatrix4(u));
+}
+
+void densmatr_applyMultiQubitKrausMap(Qureg qureg, int* targets, int numTargets, ComplexMatrixN* ops, int numOps)
+{
+  // the direct operator-sum kernel is CPU-only for now; apply the equivalent superoperator
+  densmatr_mixMultiQubitKrausMapViaSuperoperator(qureg, targets, numTargets, ops, numOps);
+}
+
+__global__ void statevec_calcQubitDensityMatrixKernel(
+  qreal* sums, ComplexArray stateVecUp, ComplexArray stateVecLo, long long int numTasks, int qubit, int pairsAreLocal)
+{
+  long long int thisTask = blockIdx.x*blockDim.x + threadIdx.x;
+  if (thisTask>=numTasks) return;
+
+  // local pairs are interleaved within one chunk, else they share an index in two chunks
+  long long int ind0 = thisTask, ind1 = thisTask;
+  if (pairsAreLocal) {
+    ind0 = insertZeroBit(thisTask, qubit);
+    ind1 = ind0 | (1LL << qubit);
+  }
+
+  qreal re0 = stateVecUp.real[ind0], im0 = stateVecUp.imag[ind0];
+  qreal re1 = stateVecLo.real[ind1], im1 = stateVecLo.imag[ind1];
+
+  atomicAdd(&sums[0], re0*re0 + im0*im0);
+  atomicAdd(&sums[1], re1*re1 + im1*im1);
+  atomicAdd(&sums[2], re0*re1 + im0*im1);
+  atomicAdd(&sums[3], im0*re1 - re0*im1);
+}
+
+ComplexMatrix2 statevec_calcQubitDensityMatrix(Qureg qureg, const int qubit)
+{
+  qreal *localSums = mallocZeroRealInDevice(4 * sizeof(qreal));
+  qreal *globalSums = mallocZeroRealInDevice(4 * sizeof(qreal));
+
+  int threadsPerCUDABlock, CUDABlocks;
+  threadsPerCUDABlock = DEFAULT_THREADS_PER_BLOCK;
+
+  if (halfMatrixBlockFitsInChunk(qureg.numAmpsPerChunk, qubit)) {
+    long long int numTasks = qureg.numAmpsPerChunk >> 1;
+    CUDABlocks = ceil((qreal)(numTasks)/threadsPerCUDABlock);
+    statevec_calcQubitDensityMatrixKernel<<<CUDABlocks, threadsPerCUDABlock>>>(
+      localSums, qureg.stateVec, qureg.stateVec, numTasks, qubit, 1);
+  } else {
+    // the coherence needs both halves of each pair, so exchange as for a unitary on qubit
+    int rankIsUpper = chunkIsUpper(qureg.chunkId, qureg.numAmpsPerChunk, qubit);
+    int pairRank = getChunkPairId(rankIsUpper, qureg.chunkId, qureg.numAmpsPerChunk, qubit);
+    exchangeStateVectors(qureg, pairRank);
+
+    // the upper chunk accounts for both halves of every pair, and the lower contributes nothing
+    if (rankIsUpper) {
+      CUDABlocks = ceil((qreal)(qureg.numAmpsPerChunk)/threadsPerCUDABlock);
+      statevec_calcQubitDensityMatrixKernel<<<CUDABlocks, threadsPerCUDABlock>>>(
+        localSums, qureg.stateVec, qureg.pairStateVec, qureg.numAmpsPerChunk, qubit, 0);
+    }
+  }
+
+  if (qureg.numChunks>1)
+    cuMPI_Allreduce(localSums, globalSums, 4, cuMPI_QuEST_REAL, cuMPI_SUM, cuMPI_COMM_WORLD);
+  else
+    cudaMemcpy(globalSums, localSums, 4 * sizeof(qreal), cudaMemcpyDeviceToDevice);
+
+  qreal sums[4];
+  cudaDeviceSynchronize();
+  cudaMemcpy(sums, globalSums, 4 * sizeof(qreal), cudaMemcpyDeviceToHost);
+  freeRealInDevice(localSums);
+  freeRealInDevice(globalSums);
+
+  ComplexMatrix2 rho;
+  rho.real[0][0] = sums[0]; rho.real[0][1] = sums[2]; rho.imag[0][0] = 0;        rho.imag[0][1] = sums[3];
+  rho.real[1][0] = sums[2]; rho.real[1][1] = sums[1]; rho.imag[1][0] = -sums[3]; rho.imag[1][1] = 0;
+  return rho;
+}
+
+__global__ void statevec_calcProbOfAllOutcomesKernel(
+  qreal* outcomeProbs, Qureg qureg, int* qubits, int numQubits)
+{
+  long long int thisTask = blockIdx.x*blockDim.x + threadIdx.x;
+  if (thisTask>=qureg.numAmpsPerChunk) return;
+
+  long long int globalInd = thisTask + qureg.chunkId*qureg.numAmpsPerChunk;
+  long long int outcomeInd = 0;
+  for (int q=0; q<numQubits; q++)
+    outcomeInd += extractBit(qubits[q], globalInd) * (1LL << q);
+
+  qreal prob = qureg.stateVec.real[thisTask]*qureg.stateVec.real[thisTask]
+    + qureg.stateVec.imag[thisTask]*qureg.stateVec.imag[thisTask];
+
+  atomicAdd(&outcomeProbs[outcomeInd], prob);
+}
+
+void statevec_calcProbOfAllOutcomes(qreal* outcomeProbs, Qureg qureg, int* qubits, int numQubits)
+{
+  // each rank bins its own amplitudes, so only the 2^numQubits bins are communicated
+  long long int numOutcomes = 1LL << numQubits;
+  qreal *localProbs = mallocZeroRealInDevice(numOutcomes * sizeof(qreal));
+  qreal *globalProbs = mallocZeroRealInDevice(numOutcomes * sizeof(qreal));
+
+  int *d_qubits;
+  cudaMalloc(&d_qubits, numQubits * sizeof(int));
+  cudaMemcpy(d_qubits, qubits, numQubits * sizeof(int), cudaMemcpyHostToDevice);
+
+  int threadsPerCUDABlock, CUDABlocks;
+  threadsPerCUDABlock = DEFAULT_THREADS_PER_BLOCK;
+  CUDABlocks = ceil((qreal)(qureg.numAmpsPerChunk)/threadsPerCUDABlock);
+  statevec_calcProbOfAllOutcomesKernel<<<CUDABlocks, threadsPerCUDABlock>>>(
+    localProbs, qureg, d_qubits, numQubits);
+
+  if (qureg.numChunks>1)
+    cuMPI_Allreduce(localProbs, globalProbs, numOutcomes, cuMPI_QuEST_REAL, cuMPI_SUM, cuMPI_COMM_WORLD);
+  else
+    cudaMemcpy(globalProbs, localProbs, numOutcomes * sizeof(qreal), cudaMemcpyDeviceToDevice);
+
+  cudaDeviceSynchronize();
+  cudaMemcpy(outcomeProbs, globalProbs, numOutcomes * sizeof(qreal), cudaMemcpyDeviceToHost);
+
+  cudaFree(d_qubits);
+  freeRealInDevice(localProbs);
+  freeRealInDevice(globalProbs);
+}
+
+qreal statevec_calcProbOfOutcomes(Qureg qureg, int* qubits, int* outcomes, int numQubits)
+{
+  qreal* outcomeProbs = allocOutcomeProbs(numQubits, __func__);
+  statevec_calcProbOfAllOutcomes(outcomeProbs, qureg, qubits, numQubits);
+  qreal outcomeProb = outcomeProbs[getOutcomeIndex(outcomes, numQubits)];
+  free(outcomeProbs);
+  return outcomeProb;
+}
+
+void statevec_sampleOutcomes(Qureg qureg, int* qubits, int numQubits, int numShots, long long int* outcomes)
+{
+  qreal* outcomeProbs = allocOutcomeProbs(numQubits, __func__);
+  statevec_calcProbOfAllOutcomes(outcomeProbs, qureg, qubits, numQubits);
+  sampleFromOutcomeProbs(outcomeProbs, 1LL << numQubits, numShots, outcomes);
+  free(outcomeProbs);
+}
+
+__global__ void statevec_calcReducedDensityMatrixKernel(
+  qreal* reSums, qreal* imSums, Qureg qureg, int* keepQubits, long long int* offsets, int numKeep)
+{
+  long long int thisTask = blockIdx.x*blockDim.x + threadIdx.x;
+  if (thisTask>=(qureg.numAmpsPerChunk >> numKeep)) return;
+
+  long long int dim = 1LL << numKeep;
+  long long int ind00 = insertZeroBits(thisTask, keepQubits, numKeep);
+  qreal *reVec = qureg.stateVec.real;
+  qreal *imVec = qureg.stateVec.imag;
+
+  // accumulate this task's upper triangle of psi_a conj(psi_b)
+  for (long long int a=0; a<dim; a++) {
+    qreal reA = reVec[ind00 | offsets[a]];
+    qreal imA = imVec[ind00 | offsets[a]];
+    for (long long int b=a; b<dim; b++) {
+      qreal reB = reVec[ind00 | offsets[b]];
+      qreal imB = imVec[ind00 | offsets[b]];
+      atomicAdd(&reSums[a*dim + b], reA*reB + imA*imB);
+      atomicAdd(&imSums[a*dim + b], imA*reB - reA*imB);
+    }
+  }
+}
+
+void statevec_calcReducedDensityMatrix(Qureg qureg, int* keepQubits, int numKeep, ComplexMatrixN out)
+{
+  // swap any kept qubits stored in the rank index into the lowest free local qubits
+  long long int keepMask = getQubitBitMask(keepQubits, numKeep);
+  int freeQb=0;
+  while (maskContainsBitOnCPU(keepMask, freeQb))
+      freeQb++;
+
+  int swapKeep[numKeep];
+  for (int j=0; j<numKeep; j++) {
+      if (halfMatrixBlockFitsInChunk(qureg.numAmpsPerChunk, keepQubits[j]))
+          swapKeep[j] = keepQubits[j];
+      else {
+          swapKeep[j] = freeQb;
+          freeQb++;
+          while (maskContainsBitOnCPU(keepMask, freeQb))
+              freeQb++;
+      }
+  }
+  for (int j=0; j<numKeep; j++)
+      if (swapKeep[j] != keepQubits[j])
+          statevec_swapQubitAmps(qureg, keepQubits[j], swapKeep[j]);
+
+  long long int dim = 1LL << numKeep;
+  long long int numElems = dim*dim;
+  long long int offsets[dim];
+  for (long long int a=0; a<dim; a++) {
+    offsets[a] = 0;
+    for (int j=0; j<numKeep; j++)
+      offsets[a] |= ((a >> j) & 1LL) << swapKeep[j];
+  }
+  int *d_keep;
+  long long int *d_offsets;
+  cudaMalloc(&d_keep, numKeep * sizeof(int));
+  cudaMalloc(&d_offsets, dim * sizeof(long long int));
+  cudaMemcpy(d_keep, swapKeep, numKeep * sizeof(int), cudaMemcpyHostToDevice);
+  cudaMemcpy(d_offsets, offsets, dim * sizeof(long long int), cudaMemcpyHostToDevice);
+
+  // each rank streams its amplitudes once, and only the 4^numKeep sums are communicated
+  qreal *localSums = mallocZeroRealInDevice(2 * numElems * sizeof(qreal));
+  qreal *globalSums = mallocZeroRealInDevice(2 * numElems * sizeof(qreal));
+
+  int threadsPerCUDABlock, CUDABlocks;
+  threadsPerCUDABlock = DEFAULT_THREADS_PER_BLOCK;
+  CUDABlocks = ceil((qreal)(qureg.numAmpsPerChunk >> numKeep)/threadsPerCUDABlock);
+  statevec_calcReducedDensityMatrixKernel<<<CUDABlocks, threadsPerCUDABlock>>>(
+    localSums, &localSums[numElems], qureg, d_keep, d_offsets, numKeep);
+
+  if (qureg.numChunks>1)
+    cuMPI_Allreduce(localSums, globalSums, 2*numElems, cuMPI_QuEST_REAL, cuMPI_SUM, cuMPI_COMM_WORLD);
+  else
+    cudaMemcpy(globalSums, localSums, 2 * numElems * sizeof(qreal), cudaMemcpyDeviceToDevice);
+
+  qreal *sums = (qreal*) malloc(2 * numElems * sizeof(qreal));
+  cudaDeviceSynchronize();
+  cudaMemcpy(sums, globalSums, 2 * numElems * sizeof(qreal), cudaMemcpyDeviceToHost);
+
+  for (int j=0; j<numKeep; j++)
+      if (swapKeep[j] != keepQubits[j])
+          statevec_swapQubitAmps(qureg, keepQubits[j], swapKeep[j]);
+
+  // set the lower triangle by conjugation
+  qreal *reSums = sums, *imSums = &sums[numElems];
+  for (long long int a=0; a<dim; a++) {
+    imSums[a*dim + a] = 0;
+    for (long long int b=0; b<a; b++) {
+      reSums[a*dim + b] =   reSums[b*dim + a];
+      imSums[a*dim + b] = - imSums[b*dim + a];
+    }
+  }
+  setMatrixNFromRowMajor(out, reSums, imSums);
+
+  free(sums);
+  cudaFree(d_keep);
+  cudaFree(d_offsets);
+  freeRealInDevice(localSums);
+  freeRealInDevice(globalSums);
+}
+
+__global__ void statevec_calcProbOfBlocksKernel(
+  Qureg qureg, qreal* blockProbs, long long int numBlocks)
+{
+  long long int thisBlock = blockIdx.x*blockDim.x + threadIdx.x;
+  if (thisBlock>=numBlocks) return;
+
+  long long int blockSize = qureg.numAmpsPerChunk / numBlocks;
+  qreal blockProb = 0;
+  for (long long int index=thisBlock*blockSize; index<(thisBlock+1)*blockSize; index++)
+    blockProb += qureg.stateVec.real[index]*qureg.stateVec.real[index]
+      + qureg.stateVec.imag[index]*qureg.stateVec.imag[index];
+
+  blockProbs[thisBlock] = blockProb;
+}
+
+long long int statevec_sampleBasisState(Qureg qureg, qreal rand, qreal* outcomeProb)
+{
+  // each rank sums its own blocks, and only the chunk totals are communicated
+  long long int numBlocks = (qureg.numAmpsPerChunk < NUM_SAMPLE_BLOCKS)? qureg.numAmpsPerChunk : NUM_SAMPLE_BLOCKS;
+  long long int blockSize = qureg.numAmpsPerChunk / numBlocks;
+  qreal *d_blockProbs = mallocZeroRealInDevice(numBlocks * sizeof(qreal));
+
+  int threadsPerCUDABlock, CUDABlocks;
+  threadsPerCUDABlock = DEFAULT_THREADS_PER_BLOCK;
+  CUDABlocks = ceil((qreal)(numBlocks)/threadsPerCUDABlock);
+  statevec_calcProbOfBlocksKernel<<<CUDABlocks, threadsPerCUDABlock>>>(
+    qureg, d_blockProbs, numBlocks);
+
+  qreal blockProbs[NUM_SAMPLE_BLOCKS];
+  cudaDeviceSynchronize();
+  cudaMemcpy(blockProbs, d_blockProbs, numBlocks * sizeof(qreal), cudaMemcpyDeviceToHost);
+  freeRealInDevice(d_blockProbs);
+
+  qreal chunkProb = 0;
+  for (long long int b=0; b<numBlocks; b++)
+    chunkProb += blockProbs[b];
+
+  // gather the chunk totals by reducing arrays which are zero but for this rank's slot
+  qreal *h_chunkProbs = (qreal*) calloc(qureg.numChunks, sizeof(qreal));
+  h_chunkProbs[qureg.chunkId] = chunkProb;
+  if (qureg.numChunks>1) {
+    qreal *localChunkProbs = mallocZeroRealInDevice(qureg.numChunks * sizeof(qreal));
+    qreal *globalChunkProbs = mallocZeroRealInDevice(qureg.numChunks * sizeof(qreal));
+    cudaMemcpy(localChunkProbs, h_chunkProbs, qureg.numChunks * sizeof(qreal), cudaMemcpyHostToDevice);
+    cuMPI_Allreduce(localChunkProbs, globalChunkProbs, qureg.numChunks, cuMPI_QuEST_REAL, cuMPI_SUM, cuMPI_COMM_WORLD);
+    cudaDeviceSynchronize();
+    cudaMemcpy(h_chunkProbs, globalChunkProbs, qureg.numChunks * sizeof(qreal), cudaMemcpyDeviceToHost);
+    freeRealInDevice(localChunkProbs);
+    freeRealInDevice(globalChunkProbs);
+  }
+
+  qreal totalProb = 0;
+  for (int c=0; c<qureg.numChunks; c++)
+    totalProb += h_chunkProbs[c];
+
+  // every rank shares rand, so agrees upon the chunk containing the sampled state
+  qreal cumulProb = rand*totalProb;
+  int chosenChunk = 0;
+  for (int c=0; c<qureg.numChunks; c++) {
+    if (h_chunkProbs[c] <= 0)
+      continue;
+    chosenChunk = c;
+    if (cumulProb < h_chunkProbs[c])
+      break;
+    cumulProb -= h_chunkProbs[c];
+  }
+  free(h_chunkProbs);
+
+  // the chosen rank scans a single block of its amplitudes on the host
+  qreal result[2] = {0, 0}; // {stateInd, ampProb}
+  if (qureg.chunkId == chosenChunk) {
+    long long int chosenBlock = 0;
+    for (long long int b=0; b<numBlocks; b++) {
+      if (blockProbs[b] <= 0)
+        continue;
+      chosenBlock = b;
+      if (cumulProb < blockProbs[b])
+        break;
+      cumulProb -= blockProbs[b];
+    }
+
+    qreal *blockReal = (qreal*) malloc(blockSize * sizeof(qreal));
+    qreal *blockImag = (qreal*) malloc(blockSize * sizeof(qreal));
+    cudaMemcpy(blockReal, &qureg.stateVec.real[chosenBlock*blockSize], blockSize * sizeof(qreal), cudaMemcpyDeviceToHost);
+    cudaMemcpy(blockImag, &qureg.stateVec.imag[chosenBlock*blockSize], blockSize * sizeof(qreal), cudaMemcpyDeviceToHost);
+
+    long long int chosenIndex = 0;
+    for (long long int index=0; index<blockSize; index++) {
+      qreal prob = blockReal[index]*blockReal[index] + blockImag[index]*blockImag[index];
+      if (prob <= 0)
+        continue;
+      chosenIndex = index;
+      result[1] = prob;
+      if (cumulProb < prob)
+        break;
+      cumulProb -= prob;
+    }
+    result[0] = (qreal) (chosenChunk*qureg.numAmpsPerChunk + chosenBlock*blockSize + chosenIndex);
+
+    free(blockReal);
+    free(blockImag);
+  }
+
+  // share the result of the chosen rank (all others contribute zero)
+  if (qureg.numChunks>1) {
+    qreal *localResult = mallocZeroRealInDevice(2 * sizeof(qreal));
+    qreal *globalResult = mallocZeroRealInDevice(2 * sizeof(qreal));
+    cudaMemcpy(localResult, result, 2 * sizeof(qreal), cudaMemcpyHostToDevice);
+    cuMPI_Allreduce(localResult, globalResult, 2, cuMPI_QuEST_REAL, cuMPI_SUM, cuMPI_COMM_WORLD);
+    cudaDeviceSynchronize();
+    cudaMemcpy(result, globalResult, 2 * sizeof(qreal), cudaMemcpyDeviceToHost);
+    freeRealInDevice(localResult);
+    freeRealInDevice(globalResult);
+  }
+
+  *outcomeProb = result[1] / totalProb;
+  return (long long int) result[0];
+}
+
+__global__ void statevec_collapseToBasisStateKernel(
+  Qureg qureg, long long int localInd, qreal ampReal, qreal ampImag)
+{
+  long long int index = blockIdx.x*blockDim.x + threadIdx.x;
+  if (index>=qureg.numAmpsPerChunk) return;
+
+  qureg.stateVec.real[index] = (index==localInd)? ampReal : 0.0;
+  qureg.stateVec.imag[index] = (index==localInd)? ampImag : 0.0;
+}
+
+void statevec_collapseToBasisState(Qureg qureg, long long int stateInd)
+{
+  // retain the amplitude's phase (if it is held in this chunk)
+  long long int localInd = -1;
+  qreal ampReal = 0, ampImag = 0;
+  if (qureg.chunkId == stateInd/qureg.numAmpsPerChunk) {
+    localInd = stateInd % qureg.numAmpsPerChunk;
+    ampReal = getRealInDevice(&qureg.stateVec.real[localInd]);
+    ampImag = getRealInDevice(&qureg.stateVec.imag[localInd]);
+    qreal ampNorm = sqrt(ampReal*ampReal + ampImag*ampImag);
+    ampReal = (ampNorm > 0)? ampReal/ampNorm : 1;
+    ampImag = (ampNorm > 0)? ampImag/ampNorm : 0;
+  }
+
+  int threadsPerCUDABlock, CUDABlocks;
+  threadsPerCUDABlock = DEFAULT_THREADS_PER_BLOCK;
+  CUDABlocks = ceil((qreal)(qureg.numAmpsPerChunk)/threadsPerCUDABlock);
+  statevec_collapseToBasisStateKernel<<<CUDABlocks, threadsPerCUDABlock>>>(
+    qureg, localInd, ampReal, ampImag);
+}
+
+__global__ void statevec_collapseToOutcomesKernel(
+  Qureg qureg, long long int qubitMask, long long int outcomeMask, qreal renorm)
+{
+  long long int index = blockIdx.x*blockDim.x + threadIdx.x;
+  if (index>=qureg.numAmpsPerChunk) return;
+
+  if (((index + qureg.chunkId*qureg.numAmpsPerChunk) & qubitMask) == outcomeMask) {
+    qureg.stateVec.real[index] *= renorm;
+    qureg.stateVec.imag[index] *= renorm;
+  } else {
+    qureg.stateVec.real[index] = 0;
+    qureg.stateVec.imag[index] = 0;
+  }
+}
+
+void statevec_collapseToOutcomes(Qureg qureg, int* qubits, int* outcomes, int numQubits, qreal outcomeProb)
+{
+  // amplitudes are kept where the bits of qubitMask match outcomeMask
+  long long int qubitMask = 0;
+  long long int outcomeMask = 0;
+  for (int q=0; q<numQubits; q++) {
+    qubitMask |= 1LL << qubits[q];
+    if (outcomes[q])
+      outcomeMask |= 1LL << qubits[q];
+  }
+
+  int threadsPerCUDABlock, CUDABlocks;
+  threadsPerCUDABlock = DEFAULT_THREADS_PER_BLOCK;
+  CUDABlocks = ceil((qreal)(qureg.numAmpsPerChunk)/threadsPerCUDABlock);
+  statevec_collapseToOutcomesKernel<<<CUDABlocks, threadsPerCUDABlock>>>(
+    qureg, qubitMask, outcomeMask, 1/sqrt(outcomeProb));
+}
+
 
 
 __global__ void statevec_collapseToKnownProbOutcomeDistributedRenormKernel(
@@ -1705,6 +2142,14 @@ void statevec_collapseToKnownProbOutcome(Qureg qureg, const int measureQubit, in
   }
 }
 
+int statevec_measureWithStats(Qureg qureg, int measureQubit, qreal *outcomeProb)
+{
+  qreal zeroProb = statevec_calcProbOfOutcome(qureg, measureQubit, 0);
+  int outcome = generateMeasurementOutcome(zeroProb, outcomeProb);
+  statevec_collapseToKnownProbOutcome(qureg, measureQubit, outcome, *outcomeProb);
+  return outcome;
+}
+
 void seedQuESTDefault(){
   // stage 1 done!
   // cuMPI done!
@@ -1940,12 +2385,23 @@ void statevec_createQureg(Qureg *qureg, int numQubits, QuESTEnv env)
         exit (EXIT_FAILURE);
     }
 
+    // device memory is not zeroed on allocation, but newly created registers must begin zeroed
+    cudaMemset(qureg->stateVec.real, 0, numAmpsPerRank * sizeof(*(qureg->stateVec.real)));
+    cudaMemset(qureg->stateVec.imag, 0, numAmpsPerRank * sizeof(*(qureg->stateVec.imag)));
+
     qureg->numQubitsInStateVec = numQubits;
     qureg->numAmpsPerChunk = numAmpsPerRank;
     qureg->numAmpsTotal = numAmps;
     qureg->chunkId = env.rank;
     qureg->numChunks = env.numRanks;
     qureg->isDensityMatrix = 0;
+    qureg->isPacked = 0;
+    qureg->isReal = 0;
+    qureg->isSubspace = 0;
+    qureg->hammingWeight = 0;
+    qureg->isOutOfCore = 0;
+    qureg->isCompressed = 0;
+    qureg->compressedAmps = NULL;
 
     // allocate GPU memory
     // cudaMalloc(&(qureg->deviceStateVec.real), qureg->numAmpsPerChunk*sizeof(*(qureg->deviceStateVec.real)));
@@ -1984,6 +2440,82 @@ void statevec_createQureg(Qureg *qureg, int numQubits, QuESTEnv env)
 
 }
 
+void densmatr_phaseShiftByTerm(Qureg qureg, long long int ctrlMask, const int targetQubit, Complex term)
+{
+  ComplexMatrix2 u = {.real = {{1, 0}, {0, term.real}}, .imag = {{0, 0}, {0, term.imag}}};
+  densmatr_multiControlledUnitary(qureg, ctrlMask, 0, targetQubit, u);
+}
+
+void packmatr_createQureg(Qureg *qureg, int numQubits, QuESTEnv env)
+{
+    printf("Packed density matrices are not supported on GPU!\n");
+    exit (EXIT_FAILURE);
+}
+
+void realvec_createQureg(Qureg *qureg, int numQubits, QuESTEnv env)
+{
+    printf("Real-amplitude registers are not supported on GPU!\n");
+    exit (EXIT_FAILURE);
+}
+
+void subspace_createQureg(Qureg *qureg, int numQubits, int hammingWeight, QuESTEnv env)
+{
+    printf("Fixed Hamming-weight registers are not supported on GPU!\n");
+    exit (EXIT_FAILURE);
+}
+
+void statevec_createOutOfCoreQureg(Qureg *qureg, int numQubits, char* dirName, QuESTEnv env)
+{
+    printf("Out-of-core registers are not supported on GPU!\n");
+    exit (EXIT_FAILURE);
+}
+
+void compressed_createQureg(Qureg *qureg, int numQubits, int numBits, int floatStorage, QuESTEnv env)
+{
+    printf("Compressed registers are not supported on GPU!\n");
+    exit (EXIT_FAILURE);
+}
+
+int statevec_writeCheckpoint(Qureg qureg, char* filename)
+{
+    printf("Checkpoints are not supported on GPU!\n");
+    exit (EXIT_FAILURE);
+}
+
+int statevec_readCheckpointHeader(char* filename, CheckpointHeader* header)
+{
+    printf("Checkpoints are not supported on GPU!\n");
+    exit (EXIT_FAILURE);
+}
+
+int statevec_readCheckpoint(Qureg qureg, char* filename, CheckpointHeader header, int useMapping)
+{
+    printf("Checkpoints are not supported on GPU!\n");
+    exit (EXIT_FAILURE);
+}
+
+int statevec_startCheckpoint(Qureg qureg, char* filename, long long int gateIndex)
+{
+    printf("Checkpoints are not supported on GPU!\n");
+    exit (EXIT_FAILURE);
+}
+
+int statevec_finishCheckpoint(Qureg qureg)
+{
+    // no checkpoint can have been started
+    return 1;
+}
+
+void statevec_setQuregPoolCapacity(int capacity)
+{
+    // device arrays are not pooled; registers are always allocated afresh with cudaMalloc
+}
+
+void statevec_setCopyOnWriteClones(int useCopyOnWrite)
+{
+    // device arrays are always cloned by copying
+}
+
 void statevec_destroyQureg(Qureg qureg, QuESTEnv env)
 {
     // stage 1 done!
@@ -26,6 +26,7 @@
 # include <math.h>
 
 # define REDUCE_SHARED_SIZE 512
+# define NUM_SAMPLE_BLOCKS 1024
 # define DEBUG 0
 
 
@@ -20,6 +20,7 @@
 # include "QuEST_internal.h"
 # include "QuEST_validation.h"
 # include "QuEST_qasm.h"
+# include "QuEST_circuit.h"
 # include <stdlib.h>
 
 #ifdef __cplusplus
@@ -60,10 +61,104 @@ Qureg createDensityQureg(int numQubits, QuESTEnv env) {
     return qureg;
 }
 
+Qureg createPackedDensityQureg(int numQubits, QuESTEnv env) {
+    validateCreateNumQubits(numQubits, __func__);
+    validatePackedNumRanks(env, __func__);
+    
+    Qureg qureg;
+    packmatr_createQureg(&qureg, numQubits, env);
+    qureg.numQubitsRepresented = numQubits;
+    
+    qasm_setup(&qureg);
+    initZeroState(qureg); // safe call to public function
+    return qureg;
+}
+
+Qureg createRealQureg(int numQubits, QuESTEnv env) {
+    validateCreateNumQubits(numQubits, __func__);
+    
+    Qureg qureg;
+    realvec_createQureg(&qureg, numQubits, env);
+    qureg.numQubitsRepresented = numQubits;
+    
+    qasm_setup(&qureg);
+    realvec_initClassicalState(qureg, 0);
+    return qureg;
+}
+
+Qureg createSubspaceQureg(int numQubits, int hammingWeight, QuESTEnv env) {
+    validateCreateNumQubits(numQubits, __func__);
+    validateSubspaceSize(numQubits, hammingWeight, __func__);
+    validateSubspaceNumRanks(env, __func__);
+    
+    Qureg qureg;
+    subspace_createQureg(&qureg, numQubits, hammingWeight, env);
+    qureg.numQubitsRepresented = numQubits;
+    
+    qasm_setup(&qureg);
+    subspace_initClassicalState(qureg, (1LL << hammingWeight) - 1);
+    return qureg;
+}
+
+Qureg createOutOfCoreQureg(int numQubits, char* dirName, QuESTEnv env) {
+    validateCreateNumQubits(numQubits, __func__);
+    validateOutOfCoreDir(dirName, __func__);
+    
+    Qureg qureg;
+    statevec_createOutOfCoreQureg(&qureg, numQubits, dirName, env);
+    qureg.numQubitsRepresented = numQubits;
+    
+    qasm_setup(&qureg);
+    statevec_initZeroStateOfNewQureg(qureg);
+    return qureg;
+}
+
+Qureg createCompressedQureg(int numQubits, int numBits, QuESTEnv env) {
+    validateCreateNumQubits(numQubits, __func__);
+    validateCompressionBits(numBits, __func__);
+    validateCompressedNumRanks(env, __func__);
+    
+    Qureg qureg;
+    compressed_createQureg(&qureg, numQubits, numBits, -1, env);
+    qureg.numQubitsRepresented = numQubits;
+    
+    qasm_setup(&qureg);
+    compressed_initClassicalState(qureg, 0);
+    return qureg;
+}
+
+Qureg createReducedPrecisionQureg(int numQubits, enum ampStorageType storage, QuESTEnv env) {
+    validateCreateNumQubits(numQubits, __func__);
+    validateStorageType(storage, __func__);
+    validateCompressedNumRanks(env, __func__);
+    
+    int numBits = (storage == STORAGE_FLOAT)? 32 : 16;
+    Qureg qureg;
+    compressed_createQureg(&qureg, numQubits, numBits, storage, env);
+    qureg.numQubitsRepresented = numQubits;
+    
+    qasm_setup(&qureg);
+    compressed_initClassicalState(qureg, 0);
+    return qureg;
+}
+
 Qureg createCloneQureg(Qureg qureg, QuESTEnv env) {
+    validateNotCompressed(qureg, __func__);
 
     Qureg newQureg;
-    statevec_createQureg(&newQureg, qureg.numQubitsInStateVec, env);
+    if (qureg.isReal) {
+        realvec_createQureg(&newQureg, qureg.numQubitsRepresented, env);
+        newQureg.numQubitsRepresented = qureg.numQubitsRepresented;
+        qasm_setup(&newQureg);
+        realvec_cloneQureg(newQureg, qureg);
+        return newQureg;
+    }
+    if (qureg.isPacked)
+        packmatr_createQureg(&newQureg, qureg.numQubitsRepresented, env);
+    else if (qureg.isSubspace)
+        subspace_createQureg(&newQureg, qureg.numQubitsRepresented, qureg.hammingWeight, env);
+    else
+        statevec_createQureg(&newQureg, qureg.numQubitsInStateVec, env);
     newQureg.isDensityMatrix = qureg.isDensityMatrix;
     newQureg.numQubitsRepresented = qureg.numQubitsRepresented;
     newQureg.numQubitsInStateVec = qureg.numQubitsInStateVec;
@@ -74,10 +169,27 @@ Qureg createCloneQureg(Qureg qureg, QuESTEnv env) {
 }
 
 void destroyQureg(Qureg qureg, QuESTEnv env) {
-    statevec_destroyQureg(qureg, env);
+    if (qureg.isCompressed)
+        compressed_destroyQureg(qureg);
+    else {
+        // a checkpoint still being written is completed before the arrays are freed (or pooled)
+        int success = statevec_finishCheckpoint(qureg);
+        validateFileOpened(success, __func__);
+        statevec_destroyQureg(qureg, env);
+    }
     qasm_free(qureg);
 }
 
+void setQuregPoolCapacity(QuESTEnv env, int capacity) {
+    validateQuregPoolCapacity(capacity, __func__);
+    
+    statevec_setQuregPoolCapacity(capacity);
+}
+
+void setCopyOnWriteClones(QuESTEnv env, int useCopyOnWrite) {
+    statevec_setCopyOnWriteClones(useCopyOnWrite);
+}
+
 
 /*
  * QASM
@@ -104,26 +216,218 @@ void writeRecordedQASMToFile(Qureg qureg, char* filename) {
     validateFileOpened(success, __func__);
 }
 
+void writeRecordedTraceToFile(Qureg qureg, char* filename) {
+    int success = qasm_writeRecordedTraceToFile(qureg, filename);
+    validateFileOpened(success, __func__);
+}
+
+void writeTraceFileAsQASM(char* traceFilename, char* qasmFilename) {
+    TraceReader reader;
+    int isOpened = qasm_openTraceFile(traceFilename, &reader);
+    validateFileOpened(isOpened, __func__);
+    int isValidHeader = qasm_isValidTraceHeader(reader.header);
+    if (!isValidHeader)
+        qasm_closeTraceFile(&reader);
+    validateTraceFile(isValidHeader, __func__);
+    
+    int isValidTrace;
+    int success = qasm_writeTraceFileAsQASM(&reader, qasmFilename, &isValidTrace);
+    qasm_closeTraceFile(&reader);
+    validateFileOpened(success, __func__);
+    validateTraceRecord(isValidTrace, __func__);
+}
+
+/** applies a recorded operation through the API function which recorded it (so that it is 
+ * validated and recorded anew), returning 0 if no API function records such an operation
+ */
+static int applyTraceRecord(Qureg qureg, TraceRecord* rec) {
+    
+    int* ctrls = rec->controls;
+    int numCtrls = rec->numControls;
+    int targ = rec->target;
+    qreal* params = rec->params;
+    Complex alpha = {.real=params[0], .imag=params[1]};
+    Complex beta = {.real=params[2], .imag=params[3]};
+    Vector axis = {.x=params[1], .y=params[2], .z=params[3]};
+    
+    // multi-controlled phase gates accept the target among their controls
+    int allQubits[MAX_TRACE_CONTROLS + 1];
+    for (int i=0; i < numCtrls; i++)
+        allQubits[i] = ctrls[i];
+    allQubits[numCtrls] = targ;
+    
+    switch (rec->op) {
+        case TRACE_GATE:
+            if (numCtrls == 0 && rec->numParams == 0) {
+                switch (rec->gate) {
+                    case GATE_SIGMA_X:   pauliX(qureg, targ); return 1;
+                    case GATE_SIGMA_Y:   pauliY(qureg, targ); return 1;
+                    case GATE_SIGMA_Z:   pauliZ(qureg, targ); return 1;
+                    case GATE_T:         tGate(qureg, targ); return 1;
+                    case GATE_S:         sGate(qureg, targ); return 1;
+                    case GATE_HADAMARD:  hadamard(qureg, targ); return 1;
+                    default: return 0;
+                }
+            }
+            if (numCtrls == 0) {
+                switch (rec->gate) {
+                    case GATE_ROTATE_X:     rotateX(qureg, targ, params[0]); return 1;
+                    case GATE_ROTATE_Y:     rotateY(qureg, targ, params[0]); return 1;
+                    case GATE_ROTATE_Z:     rotateZ(qureg, targ, params[0]); return 1;
+                    case GATE_PHASE_SHIFT:  phaseShift(qureg, targ, params[0]); return 1;
+                    default: return 0;
+                }
+            }
+            if (numCtrls == 1 && rec->numParams == 0) {
+                switch (rec->gate) {
+                    case GATE_SIGMA_X:      controlledNot(qureg, ctrls[0], targ); return 1;
+                    case GATE_SIGMA_Y:      controlledPauliY(qureg, ctrls[0], targ); return 1;
+                    case GATE_SIGMA_Z:      controlledPhaseFlip(qureg, ctrls[0], targ); return 1;
+                    case GATE_SWAP:         swapGate(qureg, ctrls[0], targ); return 1;
+                    case GATE_SQRT_SWAP:    sqrtSwapGate(qureg, ctrls[0], targ); return 1;
+                    default: return 0;
+                }
+            }
+            if (numCtrls == 1) {
+                switch (rec->gate) {
+                    case GATE_ROTATE_X:     controlledRotateX(qureg, ctrls[0], targ, params[0]); return 1;
+                    case GATE_ROTATE_Y:     controlledRotateY(qureg, ctrls[0], targ, params[0]); return 1;
+                    case GATE_ROTATE_Z:     controlledRotateZ(qureg, ctrls[0], targ, params[0]); return 1;
+                    case GATE_PHASE_SHIFT:  controlledPhaseShift(qureg, ctrls[0], targ, params[0]); return 1;
+                    default: return 0;
+                }
+            }
+            if (rec->gate == GATE_SIGMA_Z && rec->numParams == 0) {
+                multiControlledPhaseFlip(qureg, allQubits, numCtrls + 1);
+                return 1;
+            }
+            if (rec->gate == GATE_PHASE_SHIFT && rec->numParams == 1) {
+                multiControlledPhaseShift(qureg, allQubits, numCtrls + 1, params[0]);
+                return 1;
+            }
+            return 0;
+        
+        case TRACE_UNITARY: {
+            ComplexMatrix2 u = {
+                .real={{params[0], params[1]}, {params[2], params[3]}},
+                .imag={{params[4], params[5]}, {params[6], params[7]}}};
+            if (numCtrls == 0)
+                unitary(qureg, targ, u);
+            else if (numCtrls == 1)
+                controlledUnitary(qureg, ctrls[0], targ, u);
+            else
+                multiControlledUnitary(qureg, ctrls, numCtrls, targ, u);
+            return 1;
+        }
+        case TRACE_STATE_CONTROLLED_UNITARY: {
+            ComplexMatrix2 u = {
+                .real={{params[0], params[1]}, {params[2], params[3]}},
+                .imag={{params[4], params[5]}, {params[6], params[7]}}};
+            multiStateControlledUnitary(qureg, ctrls, rec->controlState, numCtrls, targ, u);
+            return 1;
+        }
+        case TRACE_COMPACT_UNITARY:
+            if (numCtrls == 0)
+                compactUnitary(qureg, targ, alpha, beta);
+            else if (numCtrls == 1)
+                controlledCompactUnitary(qureg, ctrls[0], targ, alpha, beta);
+            else
+                return 0;
+            return 1;
+        
+        case TRACE_AXIS_ROTATION:
+            if (numCtrls == 0)
+                rotateAroundAxis(qureg, targ, params[0], axis);
+            else if (numCtrls == 1)
+                controlledRotateAroundAxis(qureg, ctrls[0], targ, params[0], axis);
+            else
+                return 0;
+            return 1;
+        
+        // measurements are replayed with their recorded outcomes
+        case TRACE_MEASUREMENT:
+            collapseToOutcome(qureg, targ, rec->outcome);
+            return 1;
+        
+        case TRACE_INIT_ZERO:
+            initZeroState(qureg);
+            return 1;
+        
+        case TRACE_INIT_PLUS:
+            initPlusState(qureg);
+            return 1;
+        
+        case TRACE_INIT_CLASSICAL:
+            initClassicalState(qureg, rec->stateInd);
+            return 1;
+        
+        // operations recorded only as comments cannot be replayed
+        case TRACE_COMMENT:
+            qasm_recordComment(qureg, "%s", rec->comment);
+            return 1;
+    }
+    return 0;
+}
+
+void applyTraceFile(Qureg qureg, char* filename) {
+    TraceReader reader;
+    int isOpened = qasm_openTraceFile(filename, &reader);
+    validateFileOpened(isOpened, __func__);
+    int isValidHeader = qasm_isValidTraceHeader(reader.header);
+    if (!isValidHeader || reader.header.numQubits != qureg.numQubitsRepresented)
+        qasm_closeTraceFile(&reader);
+    validateTraceFile(isValidHeader, __func__);
+    validateTraceQureg(qureg, reader.header.numQubits, __func__);
+    
+    TraceRecord rec;
+    int status;
+    while ((status = qasm_readTraceRecord(&reader, &rec)) == 1) {
+        int isApplied = applyTraceRecord(qureg, &rec);
+        if (!isApplied)
+            qasm_closeTraceFile(&reader);
+        validateTraceRecord(isApplied, __func__);
+    }
+    qasm_closeTraceFile(&reader);
+    validateTraceRecord(status == 0, __func__);
+}
+
 
 /*
  * state initialisation
  */
 
 void initZeroState(Qureg qureg) {
-    statevec_initZeroState(qureg); // valid for both statevec and density matrices
+    validateNotSubspace(qureg, __func__);
+    
+    if (qureg.isReal)
+        realvec_initClassicalState(qureg, 0);
+    else if (qureg.isCompressed)
+        compressed_initClassicalState(qureg, 0);
+    else
+        statevec_initZeroState(qureg); // valid for both statevec and density matrices
     
     qasm_recordInitZero(qureg);
 }
 
 void initBlankState(Qureg qureg) {
-    statevec_initBlankState(qureg);
+    validateNotCompressed(qureg, __func__);
+    
+    if (qureg.isReal)
+        realvec_initBlankState(qureg);
+    else
+        statevec_initBlankState(qureg);
     
     qasm_recordComment(qureg, "Here, the register was initialised to an unphysical all-zero-amplitudes 'state'.");
 }
 
 void initPlusState(Qureg qureg) {
+    validateNotSubspace(qureg, __func__);
+    validateNotCompressed(qureg, __func__);
+    
     if (qureg.isDensityMatrix)
         densmatr_initPlusState(qureg);
+    else if (qureg.isReal)
+        realvec_initPlusState(qureg);
     else
         statevec_initPlusState(qureg);
     
@@ -132,9 +436,15 @@ void initPlusState(Qureg qureg) {
 
 void initClassicalState(Qureg qureg, long long int stateInd) {
     validateStateIndex(qureg, stateInd, __func__);
+    validateStateInSubspace(qureg, stateInd, __func__);
+    validateNotCompressed(qureg, __func__);
     
     if (qureg.isDensityMatrix)
         densmatr_initClassicalState(qureg, stateInd);
+    else if (qureg.isSubspace)
+        subspace_initClassicalState(qureg, stateInd);
+    else if (qureg.isReal)
+        realvec_initClassicalState(qureg, stateInd);
     else
         statevec_initClassicalState(qureg, stateInd);
     
@@ -144,8 +454,15 @@ void initClassicalState(Qureg qureg, long long int stateInd) {
 void initPureState(Qureg qureg, Qureg pure) {
     validateSecondQuregStateVec(pure, __func__);
     validateMatchingQuregDims(qureg, pure, __func__);
+    validateNotSubspace(qureg, __func__);
+    validateNotCompressed(qureg, __func__);
+    validateNotCompressed(pure, __func__);
 
-    if (qureg.isDensityMatrix)
+    if (qureg.isReal || pure.isReal) {
+        validateMatchingQuregTypes(qureg, pure, __func__);
+        realvec_cloneQureg(qureg, pure);
+    }
+    else if (qureg.isDensityMatrix)
         densmatr_initPureState(qureg, pure);
     else
         statevec_cloneQureg(qureg, pure);
@@ -155,8 +472,14 @@ void initPureState(Qureg qureg, Qureg pure) {
 
 void initStateFromAmps(Qureg qureg, qreal* reals, qreal* imags) {
     validateStateVecQureg(qureg, __func__);
+    validateRealAmps(qureg, imags, qureg.numAmpsTotal, __func__);
+    validateNotSubspace(qureg, __func__);
+    validateNotCompressed(qureg, __func__);
     
-    statevec_setAmps(qureg, 0, reals, imags, qureg.numAmpsTotal);
+    if (qureg.isReal)
+        realvec_setAmps(qureg, 0, reals, qureg.numAmpsTotal);
+    else
+        statevec_setAmps(qureg, 0, reals, imags, qureg.numAmpsTotal);
     
     qasm_recordComment(qureg, "Here, the register was initialised to an undisclosed given pure state.");
 }
@@ -164,8 +487,13 @@ void initStateFromAmps(Qureg qureg, qreal* reals, qreal* imags) {
 void cloneQureg(Qureg targetQureg, Qureg copyQureg) {
     validateMatchingQuregTypes(targetQureg, copyQureg, __func__);
     validateMatchingQuregDims(targetQureg, copyQureg, __func__);
+    validateNotCompressed(targetQureg, __func__);
+    validateNotCompressed(copyQureg, __func__);
     
-    statevec_cloneQureg(targetQureg, copyQureg);
+    if (targetQureg.isReal)
+        realvec_cloneQureg(targetQureg, copyQureg);
+    else
+        statevec_cloneQureg(targetQureg, copyQureg);
 }
 
 
@@ -175,80 +503,96 @@ void cloneQureg(Qureg targetQureg, Qureg copyQureg) {
 
 void hadamard(Qureg qureg, const int targetQubit) {
     validateTarget(qureg, targetQubit, __func__);
+    validateNotSubspace(qureg, __func__);
+    validateNotCompressed(qureg, __func__);
     
-    statevec_hadamard(qureg, targetQubit);
-    if (qureg.isDensityMatrix) {
-        statevec_hadamard(qureg, targetQubit+qureg.numQubitsRepresented);
-    }
+    if (qureg.isDensityMatrix)
+        densmatr_hadamard(qureg, targetQubit);
+    else
+        statevec_hadamard(qureg, targetQubit);
     
     qasm_recordGate(qureg, GATE_HADAMARD, targetQubit);
 }
 
 void rotateX(Qureg qureg, const int targetQubit, qreal angle) {
     validateTarget(qureg, targetQubit, __func__);
+    validateNotReal(qureg, __func__);
+    validateNotSubspace(qureg, __func__);
+    validateNotCompressed(qureg, __func__);
     
-    statevec_rotateX(qureg, targetQubit, angle);
-    if (qureg.isDensityMatrix) {
-        statevec_rotateX(qureg, targetQubit+qureg.numQubitsRepresented, -angle);
-    }
+    if (qureg.isDensityMatrix)
+        densmatr_rotateX(qureg, targetQubit, angle);
+    else
+        statevec_rotateX(qureg, targetQubit, angle);
     
     qasm_recordParamGate(qureg, GATE_ROTATE_X, targetQubit, angle);
 }
 
 void rotateY(Qureg qureg, const int targetQubit, qreal angle) {
     validateTarget(qureg, targetQubit, __func__);
+    validateNotSubspace(qureg, __func__);
+    validateNotCompressed(qureg, __func__);
     
-    statevec_rotateY(qureg, targetQubit, angle);
-    if (qureg.isDensityMatrix) {
-        statevec_rotateY(qureg, targetQubit+qureg.numQubitsRepresented, angle);
-    }
+    if (qureg.isDensityMatrix)
+        densmatr_rotateY(qureg, targetQubit, angle);
+    else
+        statevec_rotateY(qureg, targetQubit, angle);
     
     qasm_recordParamGate(qureg, GATE_ROTATE_Y, targetQubit, angle);
 }
 
 void rotateZ(Qureg qureg, const int targetQubit, qreal angle) {
     validateTarget(qureg, targetQubit, __func__);
+    validateNotReal(qureg, __func__);
+    validateNotCompressed(qureg, __func__);
     
-    statevec_rotateZ(qureg, targetQubit, angle);
-    if (qureg.isDensityMatrix) {
-        statevec_rotateZ(qureg, targetQubit+qureg.numQubitsRepresented, -angle);
-    }
+    if (qureg.isDensityMatrix)
+        densmatr_rotateZ(qureg, targetQubit, angle);
+    else if (qureg.isSubspace)
+        subspace_multiRotateZ(qureg, 1LL << targetQubit, angle);
+    else
+        statevec_rotateZ(qureg, targetQubit, angle);
     
     qasm_recordParamGate(qureg, GATE_ROTATE_Z, targetQubit, angle);
 }
 
 void controlledRotateX(Qureg qureg, const int controlQubit, const int targetQubit, qreal angle) {
     validateControlTarget(qureg, controlQubit, targetQubit, __func__);
+    validateNotReal(qureg, __func__);
+    validateNotSubspace(qureg, __func__);
+    validateNotCompressed(qureg, __func__);
     
-    statevec_controlledRotateX(qureg, controlQubit, targetQubit, angle);
-    if (qureg.isDensityMatrix) {
-        int shift = qureg.numQubitsRepresented;
-        statevec_controlledRotateX(qureg, controlQubit+shift, targetQubit+shift, -angle);
-    }
+    if (qureg.isDensityMatrix)
+        densmatr_controlledRotateX(qureg, controlQubit, targetQubit, angle);
+    else
+        statevec_controlledRotateX(qureg, controlQubit, targetQubit, angle);
     
     qasm_recordControlledParamGate(qureg, GATE_ROTATE_X, controlQubit, targetQubit, angle);
 }
 
 void controlledRotateY(Qureg qureg, const int controlQubit, const int targetQubit, qreal angle) {
     validateControlTarget(qureg, controlQubit, targetQubit, __func__);
+    validateNotSubspace(qureg, __func__);
+    validateNotCompressed(qureg, __func__);
     
-    statevec_controlledRotateY(qureg, controlQubit, targetQubit, angle);
-    if (qureg.isDensityMatrix) {
-        int shift = qureg.numQubitsRepresented;
-        statevec_controlledRotateY(qureg, controlQubit+shift, targetQubit+shift, angle); // rotateY is real
-    }
+    if (qureg.isDensityMatrix)
+        densmatr_controlledRotateY(qureg, controlQubit, targetQubit, angle);
+    else
+        statevec_controlledRotateY(qureg, controlQubit, targetQubit, angle);
 
     qasm_recordControlledParamGate(qureg, GATE_ROTATE_Y, controlQubit, targetQubit, angle);
 }
 
 void controlledRotateZ(Qureg qureg, const int controlQubit, const int targetQubit, qreal angle) {
     validateControlTarget(qureg, controlQubit, targetQubit, __func__);
+    validateNotReal(qureg, __func__);
+    validateNotSubspace(qureg, __func__);
+    validateNotCompressed(qureg, __func__);
     
-    statevec_controlledRotateZ(qureg, controlQubit, targetQubit, angle);
-    if (qureg.isDensityMatrix) {
-        int shift = qureg.numQubitsRepresented;
-        statevec_controlledRotateZ(qureg, controlQubit+shift, targetQubit+shift, -angle);
-    }
+    if (qureg.isDensityMatrix)
+        densmatr_controlledRotateZ(qureg, controlQubit, targetQubit, angle);
+    else
+        statevec_controlledRotateZ(qureg, controlQubit, targetQubit, angle);
     
     qasm_recordControlledParamGate(qureg, GATE_ROTATE_Z, controlQubit, targetQubit, angle);
 }
@@ -256,12 +600,14 @@ void controlledRotateZ(Qureg qureg, const int controlQubit, const int targetQubi
 void twoQubitUnitary(Qureg qureg, const int targetQubit1, const int targetQubit2, ComplexMatrix4 u) {
     validateMultiTargets(qureg, (int []) {targetQubit1, targetQubit2}, 2, __func__);
     validateTwoQubitUnitaryMatrix(qureg, u, __func__);
+    validateRealTwoQubitMatrix(qureg, u, __func__);
+    validateNumberConservingMatrix(qureg, u, __func__);
+    validateNotCompressed(qureg, __func__);
     
-    statevec_twoQubitUnitary(qureg, targetQubit1, targetQubit2, u);
-    if (qureg.isDensityMatrix) {
-        int shift = qureg.numQubitsRepresented;
-        statevec_twoQubitUnitary(qureg, targetQubit1+shift, targetQubit2+shift, getConjugateMatrix4(u));
-    }
+    if (qureg.isDensityMatrix)
+        densmatr_twoQubitUnitary(qureg, targetQubit1, targetQubit2, u);
+    else
+        statevec_twoQubitUnitary(qureg, targetQubit1, targetQubit2, u);
     
     qasm_recordComment(qureg, "Here, an undisclosed 2-qubit unitary was applied.");
 }
@@ -269,12 +615,14 @@ void twoQubitUnitary(Qureg qureg, const int targetQubit1, const int targetQubit2
 void controlledTwoQubitUnitary(Qureg qureg, const int controlQubit, const int targetQubit1, const int targetQubit2, ComplexMatrix4 u) {
     validateMultiControlsMultiTargets(qureg, (int[]) {controlQubit}, 1, (int[]) {targetQubit1, targetQubit2}, 2, __func__);
     validateTwoQubitUnitaryMatrix(qureg, u, __func__);
+    validateRealTwoQubitMatrix(qureg, u, __func__);
+    validateNumberConservingMatrix(qureg, u, __func__);
+    validateNotCompressed(qureg, __func__);
     
-    statevec_controlledTwoQubitUnitary(qureg, controlQubit, targetQubit1, targetQubit2, u);
-    if (qureg.isDensityMatrix) {
-        int shift = qureg.numQubitsRepresented;
-        statevec_controlledTwoQubitUnitary(qureg, controlQubit+shift, targetQubit1+shift, targetQubit2+shift, getConjugateMatrix4(u));
-    }
+    if (qureg.isDensityMatrix)
+        densmatr_controlledTwoQubitUnitary(qureg, controlQubit, targetQubit1, targetQubit2, u);
+    else
+        statevec_controlledTwoQubitUnitary(qureg, controlQubit, targetQubit1, targetQubit2, u);
 
     qasm_recordComment(qureg, "Here, an undisclosed controlled 2-qubit unitary was applied.");
 }
@@ -282,13 +630,15 @@ void controlledTwoQubitUnitary(Qureg qureg, const int controlQubit, const int ta
 void multiControlledTwoQubitUnitary(Qureg qureg, int* controlQubits, const int numControlQubits, const int targetQubit1, const int targetQubit2, ComplexMatrix4 u) {
     validateMultiControlsMultiTargets(qureg, controlQubits, numControlQubits, (int[]) {targetQubit1, targetQubit2}, 2, __func__);
     validateTwoQubitUnitaryMatrix(qureg, u, __func__);
+    validateRealTwoQubitMatrix(qureg, u, __func__);
+    validateNumberConservingMatrix(qureg, u, __func__);
+    validateNotCompressed(qureg, __func__);
     
     long long int ctrlQubitsMask = getQubitBitMask(controlQubits, numControlQubits);
-    statevec_multiControlledTwoQubitUnitary(qureg, ctrlQubitsMask, targetQubit1, targetQubit2, u);
-    if (qureg.isDensityMatrix) {
-        int shift = qureg.numQubitsRepresented;
-        statevec_multiControlledTwoQubitUnitary(qureg, ctrlQubitsMask<<shift, targetQubit1+shift, targetQubit2+shift, getConjugateMatrix4(u));
-    }
+    if (qureg.isDensityMatrix)
+        densmatr_multiControlledTwoQubitUnitary(qureg, ctrlQubitsMask, targetQubit1, targetQubit2, u);
+    else
+        statevec_multiControlledTwoQubitUnitary(qureg, ctrlQubitsMask, targetQubit1, targetQubit2, u);
     
     qasm_recordComment(qureg, "Here, an undisclosed multi-controlled 2-qubit unitary was applied.");
 }
@@ -296,6 +646,10 @@ void multiControlledTwoQubitUnitary(Qureg qureg, int* controlQubits, const int n
 void multiQubitUnitary(Qureg qureg, int* targs, const int numTargs, ComplexMatrixN u) {
     validateMultiTargets(qureg, targs, numTargs, __func__);
     validateMultiQubitUnitaryMatrix(qureg, u, numTargs, __func__);
+    validateRealMultiQubitMatrix(qureg, u, __func__);
+    validateNotSubspace(qureg, __func__);
+    validateNotPacked(qureg, __func__);
+    validateNotCompressed(qureg, __func__);
     
     statevec_multiQubitUnitary(qureg, targs, numTargs, u);
     if (qureg.isDensityMatrix) {
@@ -313,6 +667,10 @@ void multiQubitUnitary(Qureg qureg, int* targs, const int numTargs, ComplexMatri
 void controlledMultiQubitUnitary(Qureg qureg, int ctrl, int* targs, const int numTargs, ComplexMatrixN u) {
     validateMultiControlsMultiTargets(qureg, (int[]) {ctrl}, 1, targs, numTargs, __func__);
     validateMultiQubitUnitaryMatrix(qureg, u, numTargs, __func__);
+    validateRealMultiQubitMatrix(qureg, u, __func__);
+    validateNotSubspace(qureg, __func__);
+    validateNotPacked(qureg, __func__);
+    validateNotCompressed(qureg, __func__);
     
     statevec_controlledMultiQubitUnitary(qureg, ctrl, targs, numTargs, u);
     if (qureg.isDensityMatrix) {
@@ -330,6 +688,10 @@ void controlledMultiQubitUnitary(Qureg qureg, int ctrl, int* targs, const int nu
 void multiControlledMultiQubitUnitary(Qureg qureg, int* ctrls, const int numCtrls, int* targs, const int numTargs, ComplexMatrixN u) {
     validateMultiControlsMultiTargets(qureg, ctrls, numCtrls, targs, numTargs, __func__);
     validateMultiQubitUnitaryMatrix(qureg, u, numTargs, __func__);
+    validateRealMultiQubitMatrix(qureg, u, __func__);
+    validateNotSubspace(qureg, __func__);
+    validateNotPacked(qureg, __func__);
+    validateNotCompressed(qureg, __func__);
     
     long long int ctrlMask = getQubitBitMask(ctrls, numCtrls);
     statevec_multiControlledMultiQubitUnitary(qureg, ctrlMask, targs, numTargs, u);
@@ -348,11 +710,14 @@ void multiControlledMultiQubitUnitary(Qureg qureg, int* ctrls, const int numCtrl
 void unitary(Qureg qureg, const int targetQubit, ComplexMatrix2 u) {
     validateTarget(qureg, targetQubit, __func__);
     validateOneQubitUnitaryMatrix(u, __func__);
+    validateRealOneQubitMatrix(qureg, u, __func__);
+    validateNotSubspace(qureg, __func__);
+    validateNotCompressed(qureg, __func__);
     
-    statevec_unitary(qureg, targetQubit, u);
-    if (qureg.isDensityMatrix) {
-        statevec_unitary(qureg, targetQubit+qureg.numQubitsRepresented, getConjugateMatrix2(u));
-    }
+    if (qureg.isDensityMatrix)
+        densmatr_unitary(qureg, targetQubit, u);
+    else
+        statevec_unitary(qureg, targetQubit, u);
     
     qasm_recordUnitary(qureg, u, targetQubit);
 }
@@ -360,12 +725,14 @@ void unitary(Qureg qureg, const int targetQubit, ComplexMatrix2 u) {
 void controlledUnitary(Qureg qureg, const int controlQubit, const int targetQubit, ComplexMatrix2 u) {
     validateControlTarget(qureg, controlQubit, targetQubit, __func__);
     validateOneQubitUnitaryMatrix(u, __func__);
+    validateRealOneQubitMatrix(qureg, u, __func__);
+    validateNotSubspace(qureg, __func__);
+    validateNotCompressed(qureg, __func__);
     
-    statevec_controlledUnitary(qureg, controlQubit, targetQubit, u);
-    if (qureg.isDensityMatrix) {
-        int shift = qureg.numQubitsRepresented;
-        statevec_controlledUnitary(qureg, controlQubit+shift, targetQubit+shift, getConjugateMatrix2(u));
-    }
+    if (qureg.isDensityMatrix)
+        densmatr_controlledUnitary(qureg, controlQubit, targetQubit, u);
+    else
+        statevec_controlledUnitary(qureg, controlQubit, targetQubit, u);
     
     qasm_recordControlledUnitary(qureg, u, controlQubit, targetQubit);
 }
@@ -373,14 +740,16 @@ void controlledUnitary(Qureg qureg, const int controlQubit, const int targetQubi
 void multiControlledUnitary(Qureg qureg, int* controlQubits, const int numControlQubits, const int targetQubit, ComplexMatrix2 u) {
     validateMultiControlsTarget(qureg, controlQubits, numControlQubits, targetQubit, __func__);
     validateOneQubitUnitaryMatrix(u, __func__);
+    validateRealOneQubitMatrix(qureg, u, __func__);
+    validateNotSubspace(qureg, __func__);
+    validateNotCompressed(qureg, __func__);
     
     long long int ctrlQubitsMask = getQubitBitMask(controlQubits, numControlQubits);
     long long int ctrlFlipMask = 0;
-    statevec_multiControlledUnitary(qureg, ctrlQubitsMask, ctrlFlipMask, targetQubit, u);
-    if (qureg.isDensityMatrix) {
-        int shift = qureg.numQubitsRepresented;
-        statevec_multiControlledUnitary(qureg, ctrlQubitsMask<<shift, ctrlFlipMask<<shift, targetQubit+shift, getConjugateMatrix2(u));
-    }
+    if (qureg.isDensityMatrix)
+        densmatr_multiControlledUnitary(qureg, ctrlQubitsMask, ctrlFlipMask, targetQubit, u);
+    else
+        statevec_multiControlledUnitary(qureg, ctrlQubitsMask, ctrlFlipMask, targetQubit, u);
     
     qasm_recordMultiControlledUnitary(qureg, u, controlQubits, numControlQubits, targetQubit);
 }
@@ -388,15 +757,17 @@ void multiControlledUnitary(Qureg qureg, int* controlQubits, const int numContro
 void multiStateControlledUnitary(Qureg qureg, int* controlQubits, int* controlState, const int numControlQubits, const int targetQubit, ComplexMatrix2 u) {
     validateMultiControlsTarget(qureg, controlQubits, numControlQubits, targetQubit, __func__);
     validateOneQubitUnitaryMatrix(u, __func__);
+    validateRealOneQubitMatrix(qureg, u, __func__);
     validateControlState(controlState, numControlQubits, __func__);
+    validateNotSubspace(qureg, __func__);
+    validateNotCompressed(qureg, __func__);
 
     long long int ctrlQubitsMask = getQubitBitMask(controlQubits, numControlQubits);
     long long int ctrlFlipMask = getControlFlipMask(controlQubits, controlState, numControlQubits);
-    statevec_multiControlledUnitary(qureg, ctrlQubitsMask, ctrlFlipMask, targetQubit, u);
-    if (qureg.isDensityMatrix) {
-        int shift = qureg.numQubitsRepresented;
-        statevec_multiControlledUnitary(qureg, ctrlQubitsMask<<shift, ctrlFlipMask<<shift, targetQubit+shift, getConjugateMatrix2(u));
-    }
+    if (qureg.isDensityMatrix)
+        densmatr_multiControlledUnitary(qureg, ctrlQubitsMask, ctrlFlipMask, targetQubit, u);
+    else
+        statevec_multiControlledUnitary(qureg, ctrlQubitsMask, ctrlFlipMask, targetQubit, u);
     
     qasm_recordMultiStateControlledUnitary(qureg, u, controlQubits, controlState, numControlQubits, targetQubit);
 }
@@ -404,12 +775,14 @@ void multiStateControlledUnitary(Qureg qureg, int* controlQubits, int* controlSt
 void compactUnitary(Qureg qureg, const int targetQubit, Complex alpha, Complex beta) {
     validateTarget(qureg, targetQubit, __func__);
     validateUnitaryComplexPair(alpha, beta, __func__);
+    validateRealComplexPair(qureg, alpha, beta, __func__);
+    validateNotSubspace(qureg, __func__);
+    validateNotCompressed(qureg, __func__);
     
-    statevec_compactUnitary(qureg, targetQubit, alpha, beta);
-    if (qureg.isDensityMatrix) {
-        int shift = qureg.numQubitsRepresented;
-        statevec_compactUnitary(qureg, targetQubit+shift, getConjugateScalar(alpha), getConjugateScalar(beta));
-    }
+    if (qureg.isDensityMatrix)
+        densmatr_compactUnitary(qureg, targetQubit, alpha, beta);
+    else
+        statevec_compactUnitary(qureg, targetQubit, alpha, beta);
 
     qasm_recordCompactUnitary(qureg, alpha, beta, targetQubit);
 }
@@ -417,46 +790,60 @@ void compactUnitary(Qureg qureg, const int targetQubit, Complex alpha, Complex b
 void controlledCompactUnitary(Qureg qureg, const int controlQubit, const int targetQubit, Complex alpha, Complex beta) {
     validateControlTarget(qureg, controlQubit, targetQubit, __func__);
     validateUnitaryComplexPair(alpha, beta, __func__);
+    validateRealComplexPair(qureg, alpha, beta, __func__);
+    validateNotSubspace(qureg, __func__);
+    validateNotCompressed(qureg, __func__);
     
-    statevec_controlledCompactUnitary(qureg, controlQubit, targetQubit, alpha, beta);
-    if (qureg.isDensityMatrix) {
-        int shift = qureg.numQubitsRepresented;
-        statevec_controlledCompactUnitary(qureg, 
-            controlQubit+shift, targetQubit+shift, 
-            getConjugateScalar(alpha), getConjugateScalar(beta));
-    }
+    if (qureg.isDensityMatrix)
+        densmatr_controlledCompactUnitary(qureg, controlQubit, targetQubit, alpha, beta);
+    else
+        statevec_controlledCompactUnitary(qureg, controlQubit, targetQubit, alpha, beta);
     
     qasm_recordControlledCompactUnitary(qureg, alpha, beta, controlQubit, targetQubit);
 }
 
 void pauliX(Qureg qureg, const int targetQubit) {
     validateTarget(qureg, targetQubit, __func__);
+    validateNotSubspace(qureg, __func__);
+    validateNotCompressed(qureg, __func__);
     
-    statevec_pauliX(qureg, targetQubit);
-    if (qureg.isDensityMatrix) {
-        statevec_pauliX(qureg, targetQubit+qureg.numQubitsRepresented);
-    }
+    if (qureg.isDensityMatrix)
+        densmatr_pauliX(qureg, targetQubit);
+    else
+        statevec_pauliX(qureg, targetQubit);
     
     qasm_recordGate(qureg, GATE_SIGMA_X, targetQubit);
 }
 
 void pauliY(Qureg qureg, const int targetQubit) {
     validateTarget(qureg, targetQubit, __func__);
+    validateNotReal(qureg, __func__);
+    validateNotSubspace(qureg, __func__);
+    validateNotCompressed(qureg, __func__);
     
-    statevec_pauliY(qureg, targetQubit);
-    if (qureg.isDensityMatrix) {
-        statevec_pauliYConj(qureg, targetQubit + qureg.numQubitsRepresented);
-    }
+    if (qureg.isDensityMatrix)
+        densmatr_pauliY(qureg, targetQubit);
+    else
+        statevec_pauliY(qureg, targetQubit);
     
     qasm_recordGate(qureg, GATE_SIGMA_Y, targetQubit);
 }
 
 void pauliZ(Qureg qureg, const int targetQubit) {
     validateTarget(qureg, targetQubit, __func__);
-    
-    statevec_pauliZ(qureg, targetQubit);
-    if (qureg.isDensityMatrix) {
-        statevec_pauliZ(qureg, targetQubit+qureg.numQubitsRepresented);
+    validateNotCompressed(qureg, __func__);
+    
+    if (qureg.isPacked)
+        densmatr_phaseShiftByTerm(qureg, 0, targetQubit, (Complex) {.real=-1, .imag=0});
+    else if (qureg.isReal)
+        realvec_multiControlledPhaseFlip(qureg, 1LL << targetQubit);
+    else if (qureg.isSubspace)
+        subspace_phaseShiftByTerm(qureg, 1LL << targetQubit, (Complex) {.real=-1, .imag=0});
+    else {
+        statevec_pauliZ(qureg, targetQubit);
+        if (qureg.isDensityMatrix) {
+            statevec_pauliZ(qureg, targetQubit+qureg.numQubitsRepresented);
+        }
     }
     
     qasm_recordGate(qureg, GATE_SIGMA_Z, targetQubit);
@@ -464,10 +851,18 @@ void pauliZ(Qureg qureg, const int targetQubit) {
 
 void sGate(Qureg qureg, const int targetQubit) {
     validateTarget(qureg, targetQubit, __func__);
-    
-    statevec_sGate(qureg, targetQubit);
-    if (qureg.isDensityMatrix) {
-        statevec_sGateConj(qureg, targetQubit+qureg.numQubitsRepresented);
+    validateNotReal(qureg, __func__);
+    validateNotCompressed(qureg, __func__);
+    
+    if (qureg.isPacked)
+        densmatr_phaseShiftByTerm(qureg, 0, targetQubit, (Complex) {.real=0, .imag=1});
+    else if (qureg.isSubspace)
+        subspace_phaseShiftByTerm(qureg, 1LL << targetQubit, (Complex) {.real=0, .imag=1});
+    else {
+        statevec_sGate(qureg, targetQubit);
+        if (qureg.isDensityMatrix) {
+            statevec_sGateConj(qureg, targetQubit+qureg.numQubitsRepresented);
+        }
     }
     
     qasm_recordGate(qureg, GATE_S, targetQubit);
@@ -475,10 +870,18 @@ void sGate(Qureg qureg, const int targetQubit) {
 
 void tGate(Qureg qureg, const int targetQubit) {
     validateTarget(qureg, targetQubit, __func__);
-    
-    statevec_tGate(qureg, targetQubit);
-    if (qureg.isDensityMatrix) {
-        statevec_tGateConj(qureg, targetQubit+qureg.numQubitsRepresented);
+    validateNotReal(qureg, __func__);
+    validateNotCompressed(qureg, __func__);
+    
+    if (qureg.isPacked)
+        densmatr_phaseShiftByTerm(qureg, 0, targetQubit, (Complex) {.real=1/sqrt(2), .imag=1/sqrt(2)});
+    else if (qureg.isSubspace)
+        subspace_phaseShiftByTerm(qureg, 1LL << targetQubit, (Complex) {.real=1/sqrt(2), .imag=1/sqrt(2)});
+    else {
+        statevec_tGate(qureg, targetQubit);
+        if (qureg.isDensityMatrix) {
+            statevec_tGateConj(qureg, targetQubit+qureg.numQubitsRepresented);
+        }
     }
     
     qasm_recordGate(qureg, GATE_T, targetQubit);
@@ -486,10 +889,18 @@ void tGate(Qureg qureg, const int targetQubit) {
 
 void phaseShift(Qureg qureg, const int targetQubit, qreal angle) {
     validateTarget(qureg, targetQubit, __func__);
-    
-    statevec_phaseShift(qureg, targetQubit, angle);
-    if (qureg.isDensityMatrix) {
-        statevec_phaseShift(qureg, targetQubit+qureg.numQubitsRepresented, -angle);
+    validateNotReal(qureg, __func__);
+    validateNotCompressed(qureg, __func__);
+    
+    if (qureg.isPacked)
+        densmatr_phaseShiftByTerm(qureg, 0, targetQubit, (Complex) {.real=cos(angle), .imag=sin(angle)});
+    else if (qureg.isSubspace)
+        subspace_phaseShiftByTerm(qureg, 1LL << targetQubit, (Complex) {.real=cos(angle), .imag=sin(angle)});
+    else {
+        statevec_phaseShift(qureg, targetQubit, angle);
+        if (qureg.isDensityMatrix) {
+            statevec_phaseShift(qureg, targetQubit+qureg.numQubitsRepresented, -angle);
+        }
     }
     
     qasm_recordParamGate(qureg, GATE_PHASE_SHIFT, targetQubit, angle);
@@ -497,11 +908,19 @@ void phaseShift(Qureg qureg, const int targetQubit, qreal angle) {
 
 void controlledPhaseShift(Qureg qureg, const int idQubit1, const int idQubit2, qreal angle) {
     validateControlTarget(qureg, idQubit1, idQubit2, __func__);
-    
-    statevec_controlledPhaseShift(qureg, idQubit1, idQubit2, angle);
-    if (qureg.isDensityMatrix) {
-        int shift = qureg.numQubitsRepresented;
-        statevec_controlledPhaseShift(qureg, idQubit1+shift, idQubit2+shift, -angle);
+    validateNotReal(qureg, __func__);
+    validateNotCompressed(qureg, __func__);
+    
+    if (qureg.isPacked)
+        densmatr_phaseShiftByTerm(qureg, 1LL << idQubit1, idQubit2, (Complex) {.real=cos(angle), .imag=sin(angle)});
+    else if (qureg.isSubspace)
+        subspace_phaseShiftByTerm(qureg, (1LL << idQubit1) | (1LL << idQubit2), (Complex) {.real=cos(angle), .imag=sin(angle)});
+    else {
+        statevec_controlledPhaseShift(qureg, idQubit1, idQubit2, angle);
+        if (qureg.isDensityMatrix) {
+            int shift = qureg.numQubitsRepresented;
+            statevec_controlledPhaseShift(qureg, idQubit1+shift, idQubit2+shift, -angle);
+        }
     }
     
     qasm_recordControlledParamGate(qureg, GATE_PHASE_SHIFT, idQubit1, idQubit2, angle);
@@ -509,8 +928,14 @@ void controlledPhaseShift(Qureg qureg, const int idQubit1, const int idQubit2, q
 
 void multiControlledPhaseShift(Qureg qureg, int *controlQubits, int numControlQubits, qreal angle) {
     validateMultiQubits(qureg, controlQubits, numControlQubits, __func__);
+    validateNotReal(qureg, __func__);
+    validateNotPacked(qureg, __func__);
+    validateNotCompressed(qureg, __func__);
     
-    statevec_multiControlledPhaseShift(qureg, controlQubits, numControlQubits, angle);
+    if (qureg.isSubspace)
+        subspace_phaseShiftByTerm(qureg, getQubitBitMask(controlQubits, numControlQubits), (Complex) {.real=cos(angle), .imag=sin(angle)});
+    else
+        statevec_multiControlledPhaseShift(qureg, controlQubits, numControlQubits, angle);
     if (qureg.isDensityMatrix) {
         int shift = qureg.numQubitsRepresented;
         shiftIndices(controlQubits, numControlQubits, shift);
@@ -523,35 +948,47 @@ void multiControlledPhaseShift(Qureg qureg, int *controlQubits, int numControlQu
 
 void controlledNot(Qureg qureg, const int controlQubit, const int targetQubit) {
     validateControlTarget(qureg, controlQubit, targetQubit, __func__);
+    validateNotSubspace(qureg, __func__);
+    validateNotCompressed(qureg, __func__);
     
-    statevec_controlledNot(qureg, controlQubit, targetQubit);
-    if (qureg.isDensityMatrix) {
-        int shift = qureg.numQubitsRepresented;
-        statevec_controlledNot(qureg, controlQubit+shift, targetQubit+shift);
-    }
+    if (qureg.isDensityMatrix)
+        densmatr_controlledNot(qureg, controlQubit, targetQubit);
+    else
+        statevec_controlledNot(qureg, controlQubit, targetQubit);
     
     qasm_recordControlledGate(qureg, GATE_SIGMA_X, controlQubit, targetQubit);
 }
 
 void controlledPauliY(Qureg qureg, const int controlQubit, const int targetQubit) {
     validateControlTarget(qureg, controlQubit, targetQubit, __func__);
+    validateNotReal(qureg, __func__);
+    validateNotSubspace(qureg, __func__);
+    validateNotCompressed(qureg, __func__);
     
-    statevec_controlledPauliY(qureg, controlQubit, targetQubit);
-    if (qureg.isDensityMatrix) {
-        int shift = qureg.numQubitsRepresented;
-        statevec_controlledPauliYConj(qureg, controlQubit+shift, targetQubit+shift);
-    }
+    if (qureg.isDensityMatrix)
+        densmatr_controlledPauliY(qureg, controlQubit, targetQubit);
+    else
+        statevec_controlledPauliY(qureg, controlQubit, targetQubit);
     
     qasm_recordControlledGate(qureg, GATE_SIGMA_Y, controlQubit, targetQubit);
 }
 
 void controlledPhaseFlip(Qureg qureg, const int idQubit1, const int idQubit2) {
     validateControlTarget(qureg, idQubit1, idQubit2, __func__);
-    
-    statevec_controlledPhaseFlip(qureg, idQubit1, idQubit2);
-    if (qureg.isDensityMatrix) {
-        int shift = qureg.numQubitsRepresented;
-        statevec_controlledPhaseFlip(qureg, idQubit1+shift, idQubit2+shift);
+    validateNotCompressed(qureg, __func__);
+    
+    if (qureg.isPacked)
+        densmatr_phaseShiftByTerm(qureg, 1LL << idQubit1, idQubit2, (Complex) {.real=-1, .imag=0});
+    else if (qureg.isReal)
+        realvec_multiControlledPhaseFlip(qureg, (1LL << idQubit1) | (1LL << idQubit2));
+    else if (qureg.isSubspace)
+        subspace_phaseShiftByTerm(qureg, (1LL << idQubit1) | (1LL << idQubit2), (Complex) {.real=-1, .imag=0});
+    else {
+        statevec_controlledPhaseFlip(qureg, idQubit1, idQubit2);
+        if (qureg.isDensityMatrix) {
+            int shift = qureg.numQubitsRepresented;
+            statevec_controlledPhaseFlip(qureg, idQubit1+shift, idQubit2+shift);
+        }
     }
     
     qasm_recordControlledGate(qureg, GATE_SIGMA_Z, idQubit1, idQubit2);
@@ -559,8 +996,15 @@ void controlledPhaseFlip(Qureg qureg, const int idQubit1, const int idQubit2) {
 
 void multiControlledPhaseFlip(Qureg qureg, int *controlQubits, int numControlQubits) {
     validateMultiQubits(qureg, controlQubits, numControlQubits, __func__);
+    validateNotPacked(qureg, __func__);
+    validateNotCompressed(qureg, __func__);
     
-    statevec_multiControlledPhaseFlip(qureg, controlQubits, numControlQubits);
+    if (qureg.isReal)
+        realvec_multiControlledPhaseFlip(qureg, getQubitBitMask(controlQubits, numControlQubits));
+    else if (qureg.isSubspace)
+        subspace_phaseShiftByTerm(qureg, getQubitBitMask(controlQubits, numControlQubits), (Complex) {.real=-1, .imag=0});
+    else
+        statevec_multiControlledPhaseFlip(qureg, controlQubits, numControlQubits);
     if (qureg.isDensityMatrix) {
         int shift = qureg.numQubitsRepresented;
         shiftIndices(controlQubits, numControlQubits, shift);
@@ -574,12 +1018,14 @@ void multiControlledPhaseFlip(Qureg qureg, int *controlQubits, int numControlQub
 void rotateAroundAxis(Qureg qureg, const int rotQubit, qreal angle, Vector axis) {
     validateTarget(qureg, rotQubit, __func__);
     validateVector(axis, __func__);
+    validateNotReal(qureg, __func__);
+    validateNotSubspace(qureg, __func__);
+    validateNotCompressed(qureg, __func__);
     
-    statevec_rotateAroundAxis(qureg, rotQubit, angle, axis);
-    if (qureg.isDensityMatrix) {
-        int shift = qureg.numQubitsRepresented;
-        statevec_rotateAroundAxisConj(qureg, rotQubit+shift, angle, axis);
-    }
+    if (qureg.isDensityMatrix)
+        densmatr_rotateAroundAxis(qureg, rotQubit, angle, axis);
+    else
+        statevec_rotateAroundAxis(qureg, rotQubit, angle, axis);
     
     qasm_recordAxisRotation(qureg, angle, axis, rotQubit);
 }
@@ -587,23 +1033,30 @@ void rotateAroundAxis(Qureg qureg, const int rotQubit, qreal angle, Vector axis)
 void controlledRotateAroundAxis(Qureg qureg, const int controlQubit, const int targetQubit, qreal angle, Vector axis) {
     validateControlTarget(qureg, controlQubit, targetQubit, __func__);
     validateVector(axis, __func__);
+    validateNotReal(qureg, __func__);
+    validateNotSubspace(qureg, __func__);
+    validateNotCompressed(qureg, __func__);
     
-    statevec_controlledRotateAroundAxis(qureg, controlQubit, targetQubit, angle, axis);
-    if (qureg.isDensityMatrix) {
-        int shift = qureg.numQubitsRepresented;
-        statevec_controlledRotateAroundAxisConj(qureg, controlQubit+shift, targetQubit+shift, angle, axis);
-    }
+    if (qureg.isDensityMatrix)
+        densmatr_controlledRotateAroundAxis(qureg, controlQubit, targetQubit, angle, axis);
+    else
+        statevec_controlledRotateAroundAxis(qureg, controlQubit, targetQubit, angle, axis);
     
     qasm_recordControlledAxisRotation(qureg, angle, axis, controlQubit, targetQubit);
 }
 
 void swapGate(Qureg qureg, int qb1, int qb2) {
     validateUniqueTargets(qureg, qb1, qb2, __func__);
-
-    statevec_swapQubitAmps(qureg, qb1, qb2);
-    if (qureg.isDensityMatrix) {
-        int shift = qureg.numQubitsRepresented;
-        statevec_swapQubitAmps(qureg, qb1+shift, qb2+shift);
+    validateNotCompressed(qureg, __func__);
+
+    if (qureg.isPacked)
+        densmatr_swapGate(qureg, qb1, qb2);
+    else {
+        statevec_swapQubitAmps(qureg, qb1, qb2);
+        if (qureg.isDensityMatrix) {
+            int shift = qureg.numQubitsRepresented;
+            statevec_swapQubitAmps(qureg, qb1+shift, qb2+shift);
+        }
     }
 
     qasm_recordControlledGate(qureg, GATE_SWAP, qb1, qb2);
@@ -612,11 +1065,17 @@ void swapGate(Qureg qureg, int qb1, int qb2) {
 void sqrtSwapGate(Qureg qureg, int qb1, int qb2) {
     validateUniqueTargets(qureg, qb1, qb2, __func__);
     validateMultiQubitMatrixFitsInNode(qureg, 2, __func__); // uses 2qb unitary in QuEST_common
-
-    statevec_sqrtSwapGate(qureg, qb1, qb2);
-    if (qureg.isDensityMatrix) {
-        int shift = qureg.numQubitsRepresented;
-        statevec_sqrtSwapGateConj(qureg, qb1+shift, qb2+shift);
+    validateNotReal(qureg, __func__);
+    validateNotCompressed(qureg, __func__);
+
+    if (qureg.isPacked)
+        densmatr_sqrtSwapGate(qureg, qb1, qb2);
+    else {
+        statevec_sqrtSwapGate(qureg, qb1, qb2);
+        if (qureg.isDensityMatrix) {
+            int shift = qureg.numQubitsRepresented;
+            statevec_sqrtSwapGateConj(qureg, qb1+shift, qb2+shift);
+        }
     }
 
     qasm_recordControlledGate(qureg, GATE_SQRT_SWAP, qb1, qb2);
@@ -624,9 +1083,15 @@ void sqrtSwapGate(Qureg qureg, int qb1, int qb2) {
 
 void multiRotateZ(Qureg qureg, int* qubits, int numQubits, qreal angle) {
     validateMultiTargets(qureg, qubits, numQubits, __func__);
+    validateNotReal(qureg, __func__);
+    validateNotPacked(qureg, __func__);
+    validateNotCompressed(qureg, __func__);
     
     long long int mask = getQubitBitMask(qubits, numQubits);
-    statevec_multiRotateZ(qureg, mask, angle);
+    if (qureg.isSubspace)
+        subspace_multiRotateZ(qureg, mask, angle);
+    else
+        statevec_multiRotateZ(qureg, mask, angle);
     if (qureg.isDensityMatrix) {
         int shift = qureg.numQubitsRepresented;
         statevec_multiRotateZ(qureg, mask << shift, -angle);
@@ -641,6 +1106,10 @@ void multiRotateZ(Qureg qureg, int* qubits, int numQubits, qreal angle) {
 void multiRotatePauli(Qureg qureg, int* targetQubits, enum pauliOpType* targetPaulis, int numTargets, qreal angle) {
     validateMultiTargets(qureg, targetQubits, numTargets, __func__);
     validatePauliCodes(targetPaulis, numTargets, __func__);
+    validateNotReal(qureg, __func__);
+    validateNotSubspace(qureg, __func__);
+    validateNotPacked(qureg, __func__);
+    validateNotCompressed(qureg, __func__);
     
     int conj=0;
     statevec_multiRotatePauli(qureg, targetQubits, targetPaulis, numTargets, angle, conj);
@@ -678,6 +1147,10 @@ qreal getRealAmp(Qureg qureg, long long int index) {
     validateStateVecQureg(qureg, __func__);
     validateAmpIndex(qureg, index, __func__);
     
+    if (qureg.isSubspace)
+        return subspace_getAmp(qureg, index).real;
+    if (qureg.isCompressed)
+        return compressed_getAmp(qureg, index).real;
     return statevec_getRealAmp(qureg, index);
 }
 
@@ -685,6 +1158,10 @@ qreal getImagAmp(Qureg qureg, long long int index) {
     validateStateVecQureg(qureg, __func__);
     validateAmpIndex(qureg, index, __func__);
     
+    if (qureg.isSubspace)
+        return subspace_getAmp(qureg, index).imag;
+    if (qureg.isCompressed)
+        return compressed_getAmp(qureg, index).imag;
     return statevec_getImagAmp(qureg, index);
 }
 
@@ -692,6 +1169,14 @@ qreal getProbAmp(Qureg qureg, long long int index) {
     validateStateVecQureg(qureg, __func__);
     validateAmpIndex(qureg, index, __func__);
     
+    if (qureg.isSubspace) {
+        Complex amp = subspace_getAmp(qureg, index);
+        return amp.real*amp.real + amp.imag*amp.imag;
+    }
+    if (qureg.isCompressed) {
+        Complex amp = compressed_getAmp(qureg, index);
+        return amp.real*amp.real + amp.imag*amp.imag;
+    }
     return statevec_getProbAmp(qureg, index);
 }
 
@@ -699,6 +1184,11 @@ Complex getAmp(Qureg qureg, long long int index) {
     validateStateVecQureg(qureg, __func__);
     validateAmpIndex(qureg, index, __func__);
     
+    if (qureg.isSubspace)
+        return subspace_getAmp(qureg, index);
+    if (qureg.isCompressed)
+        return compressed_getAmp(qureg, index);
+    
     Complex amp;
     amp.real = statevec_getRealAmp(qureg, index);
     amp.imag = statevec_getImagAmp(qureg, index);
@@ -709,6 +1199,10 @@ Complex getDensityAmp(Qureg qureg, long long int row, long long int col) {
     validateDensityMatrQureg(qureg, __func__);
     validateAmpIndex(qureg, row, __func__);
     validateAmpIndex(qureg, col, __func__);
+    validateNotCompressed(qureg, __func__);
+    
+    if (qureg.isPacked)
+        return packmatr_getDensityAmp(qureg, row, col);
     
     long long ind = row + col*(1LL << qureg.numQubitsRepresented);
     Complex amp;
@@ -725,6 +1219,8 @@ Complex getDensityAmp(Qureg qureg, long long int row, long long int col) {
 qreal collapseToOutcome(Qureg qureg, const int measureQubit, int outcome) {
     validateTarget(qureg, measureQubit, __func__);
     validateOutcome(outcome, __func__);
+    validateNotPacked(qureg, __func__);
+    validateNotCompressed(qureg, __func__);
     
     qreal outcomeProb;
     if (qureg.isDensityMatrix) {
@@ -737,12 +1233,14 @@ qreal collapseToOutcome(Qureg qureg, const int measureQubit, int outcome) {
         statevec_collapseToKnownProbOutcome(qureg, measureQubit, outcome, outcomeProb);
     }
     
-    qasm_recordMeasurement(qureg, measureQubit);
+    qasm_recordMeasurement(qureg, measureQubit, outcome);
     return outcomeProb;
 }
 
 int measureWithStats(Qureg qureg, int measureQubit, qreal *outcomeProb) {
     validateTarget(qureg, measureQubit, __func__);
+    validateNotPacked(qureg, __func__);
+    validateNotCompressed(qureg, __func__);
 
     int outcome;
     if (qureg.isDensityMatrix)
@@ -750,12 +1248,14 @@ int measureWithStats(Qureg qureg, int measureQubit, qreal *outcomeProb) {
     else
         outcome = statevec_measureWithStats(qureg, measureQubit, outcomeProb);
     
-    qasm_recordMeasurement(qureg, measureQubit);
+    qasm_recordMeasurement(qureg, measureQubit, outcome);
     return outcome;
 }
 
 int measure(Qureg qureg, int measureQubit) {
     validateTarget(qureg, measureQubit, __func__);
+    validateNotPacked(qureg, __func__);
+    validateNotCompressed(qureg, __func__);
     
     int outcome;
     qreal discardedProb;
@@ -764,15 +1264,78 @@ int measure(Qureg qureg, int measureQubit) {
     else
         outcome = statevec_measureWithStats(qureg, measureQubit, &discardedProb);
     
-    qasm_recordMeasurement(qureg, measureQubit);
+    qasm_recordMeasurement(qureg, measureQubit, outcome);
     return outcome;
 }
 
+qreal collapseToOutcomes(Qureg qureg, int* qubits, int* outcomes, int numQubits) {
+    validateMultiQubits(qureg, qubits, numQubits, __func__);
+    validateNotSubspace(qureg, __func__);
+    validateNotPacked(qureg, __func__);
+    validateNotCompressed(qureg, __func__);
+    for (int q=0; q < numQubits; q++)
+        validateOutcome(outcomes[q], __func__);
+    
+    qreal outcomeProb;
+    if (qureg.isDensityMatrix) {
+        outcomeProb = densmatr_calcProbOfOutcomes(qureg, qubits, outcomes, numQubits);
+        validateMeasurementProb(outcomeProb, __func__);
+        densmatr_collapseToOutcomes(qureg, qubits, outcomes, numQubits, outcomeProb);
+    } else {
+        outcomeProb = statevec_calcProbOfOutcomes(qureg, qubits, outcomes, numQubits);
+        validateMeasurementProb(outcomeProb, __func__);
+        statevec_collapseToOutcomes(qureg, qubits, outcomes, numQubits, outcomeProb);
+    }
+    
+    for (int q=0; q < numQubits; q++)
+        qasm_recordMeasurement(qureg, qubits[q], outcomes[q]);
+    return outcomeProb;
+}
+
+qreal measureQubits(Qureg qureg, int* qubits, int numQubits, int* outcomes) {
+    validateMultiQubits(qureg, qubits, numQubits, __func__);
+    validateNotSubspace(qureg, __func__);
+    validateNotPacked(qureg, __func__);
+    validateNotCompressed(qureg, __func__);
+    
+    qreal outcomeProb;
+    if (qureg.isDensityMatrix)
+        outcomeProb = densmatr_measureQubits(qureg, qubits, numQubits, outcomes);
+    else
+        outcomeProb = statevec_measureQubits(qureg, qubits, numQubits, outcomes);
+    
+    for (int q=0; q < numQubits; q++)
+        qasm_recordMeasurement(qureg, qubits[q], outcomes[q]);
+    return outcomeProb;
+}
+
+long long int measureAll(Qureg qureg, int* outcomes) {
+    validateNotSubspace(qureg, __func__);
+    validateNotPacked(qureg, __func__);
+    validateNotCompressed(qureg, __func__);
+    
+    long long int stateInd;
+    qreal discardedProb;
+    if (qureg.isDensityMatrix)
+        stateInd = densmatr_measureAllWithStats(qureg, &discardedProb);
+    else
+        stateInd = statevec_measureAllWithStats(qureg, &discardedProb);
+    
+    for (int q=0; q < qureg.numQubitsRepresented; q++) {
+        outcomes[q] = (stateInd >> q) & 1;
+        qasm_recordMeasurement(qureg, q, outcomes[q]);
+    }
+    return stateInd;
+}
+
 void mixDensityMatrix(Qureg combineQureg, qreal otherProb, Qureg otherQureg) {
     validateDensityMatrQureg(combineQureg, __func__);
     validateDensityMatrQureg(otherQureg, __func__);
     validateMatchingQuregDims(combineQureg, otherQureg, __func__);
+    validateMatchingQuregTypes(combineQureg, otherQureg, __func__);
     validateProb(otherProb, __func__);
+    validateNotCompressed(combineQureg, __func__);
+    validateNotCompressed(otherQureg, __func__);
     
     densmatr_mixDensityMatrix(combineQureg, otherProb, otherQureg);
 }
@@ -780,13 +1343,21 @@ void mixDensityMatrix(Qureg combineQureg, qreal otherProb, Qureg otherQureg) {
 void setAmps(Qureg qureg, long long int startInd, qreal* reals, qreal* imags, long long int numAmps) {
     validateStateVecQureg(qureg, __func__);
     validateNumAmps(qureg, startInd, numAmps, __func__);
+    validateRealAmps(qureg, imags, numAmps, __func__);
+    validateNotSubspace(qureg, __func__);
+    validateNotCompressed(qureg, __func__);
     
-    statevec_setAmps(qureg, startInd, reals, imags, numAmps);
+    if (qureg.isReal)
+        realvec_setAmps(qureg, startInd, reals, numAmps);
+    else
+        statevec_setAmps(qureg, startInd, reals, imags, numAmps);
     
     qasm_recordComment(qureg, "Here, some amplitudes in the statevector were manually edited.");
 }
 
 void setDensityAmps(Qureg qureg, qreal* reals, qreal* imags) {
+    validateNotPacked(qureg, __func__);
+    validateNotCompressed(qureg, __func__);
     long long int numAmps = qureg.numAmpsTotal; 
     statevec_setAmps(qureg, 0, reals, imags, numAmps);
     
@@ -798,6 +1369,15 @@ void setWeightedQureg(Complex fac1, Qureg qureg1, Complex fac2, Qureg qureg2, Co
     validateMatchingQuregTypes(qureg1, out, __func__);
     validateMatchingQuregDims(qureg1, qureg2,  __func__);
     validateMatchingQuregDims(qureg1, out, __func__);
+    validateNotReal(qureg1, __func__);
+    validateNotSubspace(qureg1, __func__);
+    validateNotReal(qureg2, __func__);
+    validateNotSubspace(qureg2, __func__);
+    validateNotReal(out, __func__);
+    validateNotSubspace(out, __func__);
+    validateNotCompressed(qureg1, __func__);
+    validateNotCompressed(qureg2, __func__);
+    validateNotCompressed(out, __func__);
 
     statevec_setWeightedQureg(fac1, qureg1, fac2, qureg2, facOut, out);
 
@@ -809,6 +1389,13 @@ void applyPauliSum(Qureg inQureg, enum pauliOpType* allPauliCodes, qreal* termCo
     validateMatchingQuregDims(inQureg, outQureg, __func__);
     validateNumPauliSumTerms(numSumTerms, __func__);
     validatePauliCodes(allPauliCodes, numSumTerms*inQureg.numQubitsRepresented, __func__);
+    validateNotReal(inQureg, __func__);
+    validateNotSubspace(inQureg, __func__);
+    validateNotReal(outQureg, __func__);
+    validateNotSubspace(outQureg, __func__);
+    validateNotPacked(inQureg, __func__);
+    validateNotCompressed(inQureg, __func__);
+    validateNotCompressed(outQureg, __func__);
     
     statevec_applyPauliSum(inQureg, allPauliCodes, termCoeffs, numSumTerms, outQureg);
     
@@ -821,17 +1408,28 @@ void applyPauliSum(Qureg inQureg, enum pauliOpType* allPauliCodes, qreal* termCo
  */
 
 qreal calcTotalProb(Qureg qureg) {
+    if (qureg.isCompressed)
+        return compressed_calcTotalProb(qureg);
     if (qureg.isDensityMatrix)  
             return densmatr_calcTotalProb(qureg);
         else
             return statevec_calcTotalProb(qureg);
 }
 
+CompressionStats getCompressionStats(Qureg qureg) {
+    validateCompressedQureg(qureg, __func__);
+    
+    return compressed_getStats(qureg);
+}
+
 Complex calcInnerProduct(Qureg bra, Qureg ket) {
     validateStateVecQureg(bra, __func__);
     validateStateVecQureg(ket, __func__);
     validateMatchingQuregDims(bra, ket,  __func__);
+    validateMatchingQuregTypes(bra, ket, __func__);
     
+    if (bra.isCompressed)
+        return compressed_calcInnerProduct(bra, ket);
     return statevec_calcInnerProduct(bra, ket);
 }
 
@@ -839,6 +1437,10 @@ qreal calcDensityInnerProduct(Qureg rho1, Qureg rho2) {
     validateDensityMatrQureg(rho1, __func__);
     validateDensityMatrQureg(rho2, __func__);
     validateMatchingQuregDims(rho1, rho2, __func__);
+    validateNotPacked(rho1, __func__);
+    validateNotPacked(rho2, __func__);
+    validateNotCompressed(rho1, __func__);
+    validateNotCompressed(rho2, __func__);
     
     return densmatr_calcInnerProduct(rho1, rho2);
 }
@@ -847,14 +1449,30 @@ qreal calcProbOfOutcome(Qureg qureg, const int measureQubit, int outcome) {
     validateTarget(qureg, measureQubit, __func__);
     validateOutcome(outcome, __func__);
     
+    if (qureg.isCompressed)
+        return compressed_calcProbOfOutcome(qureg, measureQubit, outcome);
     if (qureg.isDensityMatrix)
         return densmatr_calcProbOfOutcome(qureg, measureQubit, outcome);
     else
         return statevec_calcProbOfOutcome(qureg, measureQubit, outcome);
 }
 
+void sampleOutcomes(Qureg qureg, int* qubits, int numQubits, int numShots, long long int* outcomes) {
+    validateMultiQubits(qureg, qubits, numQubits, __func__);
+    validateNumShots(numShots, __func__);
+    validateNotSubspace(qureg, __func__);
+    validateNotPacked(qureg, __func__);
+    validateNotCompressed(qureg, __func__);
+    
+    if (qureg.isDensityMatrix)
+        densmatr_sampleOutcomes(qureg, qubits, numQubits, numShots, outcomes);
+    else
+        statevec_sampleOutcomes(qureg, qubits, numQubits, numShots, outcomes);
+}
+
 qreal calcPurity(Qureg qureg) {
     validateDensityMatrQureg(qureg, __func__);
+    validateNotCompressed(qureg, __func__);
     
     return densmatr_calcPurity(qureg);
 }
@@ -862,35 +1480,106 @@ qreal calcPurity(Qureg qureg) {
 qreal calcFidelity(Qureg qureg, Qureg pureState) {
     validateSecondQuregStateVec(pureState, __func__);
     validateMatchingQuregDims(qureg, pureState, __func__);
+    validateNotSubspace(qureg, __func__);
+    validateNotSubspace(pureState, __func__);
+    validateNotCompressed(qureg, __func__);
+    validateNotCompressed(pureState, __func__);
     
     if (qureg.isDensityMatrix)
         return densmatr_calcFidelity(qureg, pureState);
-    else
-        return statevec_calcFidelity(qureg, pureState);
+    
+    validateMatchingQuregTypes(qureg, pureState, __func__);
+    return statevec_calcFidelity(qureg, pureState);
 }
 
 qreal calcExpecPauliProd(Qureg qureg, int* targetQubits, enum pauliOpType* pauliCodes, int numTargets, Qureg workspace) {
     validateMultiTargets(qureg, targetQubits, numTargets, __func__);
     validatePauliCodes(pauliCodes, numTargets, __func__);
+    validateNotCompressed(qureg, __func__);
+    validateNotCompressed(workspace, __func__);
+    
+    // density matrices are contracted in-place, so need no workspace
+    if (qureg.isDensityMatrix)
+        return densmatr_calcExpecPauliProd(qureg, targetQubits, pauliCodes, numTargets);
+    
+    // real-amplitude and subspace registers are likewise evaluated directly
+    if (qureg.isReal)
+        return realvec_calcExpecPauliProd(qureg, targetQubits, pauliCodes, numTargets);
+    if (qureg.isSubspace)
+        return subspace_calcExpecPauliProd(qureg, targetQubits, pauliCodes, numTargets);
+    
     validateMatchingQuregTypes(qureg, workspace, __func__);
     validateMatchingQuregDims(qureg, workspace, __func__);
-    
     return statevec_calcExpecPauliProd(qureg, targetQubits, pauliCodes, numTargets, workspace);
 }
 
 qreal calcExpecPauliSum(Qureg qureg, enum pauliOpType* allPauliCodes, qreal* termCoeffs, int numSumTerms, Qureg workspace) {
+    validateNumPauliSumTerms(numSumTerms, __func__);
+    validatePauliCodes(allPauliCodes, numSumTerms*qureg.numQubitsRepresented, __func__);
+    validateNotCompressed(qureg, __func__);
+    validateNotCompressed(workspace, __func__);
+    
+    if (qureg.isDensityMatrix)
+        return densmatr_calcExpecPauliSum(qureg, allPauliCodes, termCoeffs, numSumTerms);
+    if (qureg.isReal)
+        return realvec_calcExpecPauliSum(qureg, allPauliCodes, termCoeffs, numSumTerms);
+    if (qureg.isSubspace)
+        return subspace_calcExpecPauliSum(qureg, allPauliCodes, termCoeffs, numSumTerms);
+    
+    validateMatchingQuregTypes(qureg, workspace, __func__);
+    validateMatchingQuregDims(qureg, workspace, __func__);
+    return statevec_calcExpecPauliSum(qureg, allPauliCodes, termCoeffs, numSumTerms, workspace);
+}
+
+void calcReducedDensityMatrix(Qureg qureg, int* keepQubits, int numKeep, ComplexMatrixN out) {
+    validateMultiTargets(qureg, keepQubits, numKeep, __func__);
+    validateReducedDensityMatrix(qureg, out, numKeep, __func__);
+    validateNotSubspace(qureg, __func__);
+    validateNotCompressed(qureg, __func__);
+    
+    if (qureg.isDensityMatrix)
+        densmatr_calcReducedDensityMatrix(qureg, keepQubits, numKeep, out);
+    else
+        statevec_calcReducedDensityMatrix(qureg, keepQubits, numKeep, out);
+}
+
+TrajectoryStats calcTrajectoryAverage(
+    Qureg qureg, void (*applyNoisyCircuit)(Qureg, void*), void* circuitArgs, 
+    qreal (*calcObservable)(Qureg, void*), void* observableArgs, int numTrajectories
+) {
+    validateStateVecQureg(qureg, __func__);
+    validateNumTrajectories(numTrajectories, __func__);
+    validateNotCompressed(qureg, __func__);
+    
+    return statevec_calcTrajectoryAverage(
+        qureg, applyNoisyCircuit, circuitArgs, calcObservable, observableArgs, numTrajectories);
+}
+
+TrajectoryStats calcTrajectoryExpecPauliSum(
+    Qureg qureg, void (*applyNoisyCircuit)(Qureg, void*), void* circuitArgs, 
+    enum pauliOpType* allPauliCodes, qreal* termCoeffs, int numSumTerms, Qureg workspace, int numTrajectories
+) {
+    validateStateVecQureg(qureg, __func__);
     validateNumPauliSumTerms(numSumTerms, __func__);
     validatePauliCodes(allPauliCodes, numSumTerms*qureg.numQubitsRepresented, __func__);
     validateMatchingQuregTypes(qureg, workspace, __func__);
     validateMatchingQuregDims(qureg, workspace, __func__);
+    validateNumTrajectories(numTrajectories, __func__);
+    validateNotCompressed(qureg, __func__);
+    validateNotCompressed(workspace, __func__);
     
-    return statevec_calcExpecPauliSum(qureg, allPauliCodes, termCoeffs, numSumTerms, workspace);
+    return statevec_calcTrajectoryExpecPauliSum(
+        qureg, applyNoisyCircuit, circuitArgs, allPauliCodes, termCoeffs, numSumTerms, workspace, numTrajectories);
 }
 
 qreal calcHilbertSchmidtDistance(Qureg a, Qureg b) {
     validateDensityMatrQureg(a, __func__);
     validateDensityMatrQureg(b, __func__);
     validateMatchingQuregDims(a, b, __func__);
+    validateNotPacked(a, __func__);
+    validateNotPacked(b, __func__);
+    validateNotCompressed(a, __func__);
+    validateNotCompressed(b, __func__);
     
     return densmatr_calcHilbertSchmidtDistance(a, b);
 }
@@ -901,75 +1590,164 @@ qreal calcHilbertSchmidtDistance(Qureg a, Qureg b) {
  */
 
 void mixDephasing(Qureg qureg, const int targetQubit, qreal prob) {
-    validateDensityMatrQureg(qureg, __func__);
     validateTarget(qureg, targetQubit, __func__);
     validateOneQubitDephaseProb(prob, __func__);
+    validateNotReal(qureg, __func__);
+    validateNotSubspace(qureg, __func__);
+    validateNotCompressed(qureg, __func__);
     
-    densmatr_mixDephasing(qureg, targetQubit, 2*prob);
+    if (qureg.isDensityMatrix)
+        densmatr_mixDephasing(qureg, targetQubit, 2*prob);
+    else
+        statevec_mixDephasing(qureg, targetQubit, prob);
     qasm_recordComment(qureg, 
         "Here, a phase (Z) error occured on qubit %d with probability %g", targetQubit, prob);
 }
 
 void mixTwoQubitDephasing(Qureg qureg, int qubit1, int qubit2, qreal prob) {
-    validateDensityMatrQureg(qureg, __func__);
     validateUniqueTargets(qureg, qubit1, qubit2, __func__);
     validateTwoQubitDephaseProb(prob, __func__);
+    validateNotReal(qureg, __func__);
+    validateNotSubspace(qureg, __func__);
+    validateNotPacked(qureg, __func__);
+    validateNotCompressed(qureg, __func__);
 
     ensureIndsIncrease(&qubit1, &qubit2);
-    densmatr_mixTwoQubitDephasing(qureg, qubit1, qubit2, (4*prob)/3.0);
+    if (qureg.isDensityMatrix)
+        densmatr_mixTwoQubitDephasing(qureg, qubit1, qubit2, (4*prob)/3.0);
+    else
+        statevec_mixTwoQubitDephasing(qureg, qubit1, qubit2, prob);
     qasm_recordComment(qureg,
         "Here, a phase (Z) error occured on either or both of qubits "
         "%d and %d with total probability %g", qubit1, qubit2, prob);
 }
 
 void mixDepolarising(Qureg qureg, const int targetQubit, qreal prob) {
-    validateDensityMatrQureg(qureg, __func__);
     validateTarget(qureg, targetQubit, __func__);
     validateOneQubitDepolProb(prob, __func__);
+    validateNotReal(qureg, __func__);
+    validateNotSubspace(qureg, __func__);
+    validateNotCompressed(qureg, __func__);
     
-    densmatr_mixDepolarising(qureg, targetQubit, (4*prob)/3.0);
+    if (qureg.isDensityMatrix)
+        densmatr_mixDepolarising(qureg, targetQubit, (4*prob)/3.0);
+    else
+        statevec_mixDepolarising(qureg, targetQubit, prob);
     qasm_recordComment(qureg,
         "Here, a homogeneous depolarising error (X, Y, or Z) occured on "
         "qubit %d with total probability %g", targetQubit, prob);
 }
 
 void mixDamping(Qureg qureg, const int targetQubit, qreal prob) {
-    validateDensityMatrQureg(qureg, __func__);
     validateTarget(qureg, targetQubit, __func__);
     validateOneQubitDampingProb(prob, __func__);
+    validateNotReal(qureg, __func__);
+    validateNotSubspace(qureg, __func__);
+    validateNotCompressed(qureg, __func__);
+    
+    if (qureg.isDensityMatrix)
+        densmatr_mixDamping(qureg, targetQubit, prob);
+    else
+        statevec_mixDamping(qureg, targetQubit, prob);
+}
+
+void mixDephasingAll(Qureg qureg, qreal prob) {
+    validateOneQubitDephaseProb(prob, __func__);
+    validateNotReal(qureg, __func__);
+    validateNotSubspace(qureg, __func__);
+    validateNotCompressed(qureg, __func__);
     
-    densmatr_mixDamping(qureg, targetQubit, prob);
+    if (qureg.isDensityMatrix)
+        densmatr_mixDephasingAll(qureg, 2*prob);
+    else
+        for (int q=0; q < qureg.numQubitsRepresented; q++)
+            statevec_mixDephasing(qureg, q, prob);
+    qasm_recordComment(qureg, 
+        "Here, a phase (Z) error occured on every qubit with probability %g", prob);
+}
+
+void mixDepolarisingAll(Qureg qureg, qreal prob) {
+    validateOneQubitDepolProb(prob, __func__);
+    validateNotReal(qureg, __func__);
+    validateNotSubspace(qureg, __func__);
+    validateNotCompressed(qureg, __func__);
+    
+    int numQubits = qureg.numQubitsRepresented;
+    int targets[numQubits];
+    for (int q=0; q < numQubits; q++)
+        targets[q] = q;
+    
+    if (qureg.isDensityMatrix)
+        densmatr_mixDepolarisingOnQubits(qureg, targets, numQubits, (4*prob)/3.0);
+    else
+        for (int q=0; q < numQubits; q++)
+            statevec_mixDepolarising(qureg, q, prob);
+    qasm_recordComment(qureg,
+        "Here, a homogeneous depolarising error (X, Y, or Z) occured on "
+        "every qubit with total probability %g", prob);
+}
+
+void mixDampingOnQubits(Qureg qureg, int* targets, int numTargets, qreal prob) {
+    validateMultiTargets(qureg, targets, numTargets, __func__);
+    validateOneQubitDampingProb(prob, __func__);
+    validateNotReal(qureg, __func__);
+    validateNotSubspace(qureg, __func__);
+    validateNotCompressed(qureg, __func__);
+    
+    if (qureg.isDensityMatrix)
+        densmatr_mixDampingOnQubits(qureg, targets, numTargets, prob);
+    else
+        for (int t=0; t < numTargets; t++)
+            statevec_mixDamping(qureg, targets[t], prob);
 }
 
 void mixTwoQubitDepolarising(Qureg qureg, int qubit1, int qubit2, qreal prob) {
-    validateDensityMatrQureg(qureg, __func__);
     validateUniqueTargets(qureg, qubit1, qubit2, __func__);
     validateTwoQubitDepolProb(prob, __func__);
+    validateNotReal(qureg, __func__);
+    validateNotSubspace(qureg, __func__);
+    validateNotPacked(qureg, __func__);
+    validateNotCompressed(qureg, __func__);
     
     ensureIndsIncrease(&qubit1, &qubit2);
-    densmatr_mixTwoQubitDepolarising(qureg, qubit1, qubit2, (16*prob)/15.0);
+    if (qureg.isDensityMatrix)
+        densmatr_mixTwoQubitDepolarising(qureg, qubit1, qubit2, (16*prob)/15.0);
+    else
+        statevec_mixTwoQubitDepolarising(qureg, qubit1, qubit2, prob);
     qasm_recordComment(qureg,
         "Here, a homogeneous depolarising error occured on qubits %d and %d "
         "with total probability %g", qubit1, qubit2, prob);
 }
 
 void mixPauli(Qureg qureg, int qubit, qreal probX, qreal probY, qreal probZ) {
-    validateDensityMatrQureg(qureg, __func__);
     validateTarget(qureg, qubit, __func__);
     validateOneQubitPauliProbs(probX, probY, probZ, __func__);
+    validateNotReal(qureg, __func__);
+    validateNotSubspace(qureg, __func__);
+    validateNotPacked(qureg, __func__);
+    validateNotCompressed(qureg, __func__);
     
-    densmatr_mixPauli(qureg, qubit, probX, probY, probZ);
+    if (qureg.isDensityMatrix)
+        densmatr_mixPauli(qureg, qubit, probX, probY, probZ);
+    else
+        statevec_mixPauli(qureg, qubit, probX, probY, probZ);
     qasm_recordComment(qureg,
         "Here, X, Y and Z errors occured on qubit %d with probabilities "
         "%g, %g and %g respectively", qubit, probX, probY, probZ);
 }
 
 void mixKrausMap(Qureg qureg, int target, ComplexMatrix2 *ops, int numOps) {
-    validateDensityMatrQureg(qureg, __func__);
     validateTarget(qureg, target, __func__);
     validateOneQubitKrausMap(qureg, ops, numOps, __func__);
+    validateNotReal(qureg, __func__);
+    validateNotSubspace(qureg, __func__);
+    validateNotPacked(qureg, __func__);
+    validateNotCompressed(qureg, __func__);
     
-    densmatr_mixKrausMap(qureg, target, ops, numOps);
+    if (qureg.isDensityMatrix)
+        densmatr_mixKrausMap(qureg, target, ops, numOps);
+    else
+        statevec_mixKrausMap(qureg, target, ops, numOps);
     qasm_recordComment(qureg, 
         "Here, an undisclosed Kraus map was effected on qubit %d", target);
 }
@@ -978,6 +1756,8 @@ void mixTwoQubitKrausMap(Qureg qureg, int target1, int target2, ComplexMatrix4 *
     validateDensityMatrQureg(qureg, __func__);
     validateMultiTargets(qureg, (int[]) {target1,target2}, 2, __func__);
     validateTwoQubitKrausMap(qureg, ops, numOps, __func__);
+    validateNotPacked(qureg, __func__);
+    validateNotCompressed(qureg, __func__);
     
     densmatr_mixTwoQubitKrausMap(qureg, target1, target2, ops, numOps);
     qasm_recordComment(qureg, 
@@ -988,6 +1768,8 @@ void mixMultiQubitKrausMap(Qureg qureg, int* targets, int numTargets, ComplexMat
     validateDensityMatrQureg(qureg, __func__);
     validateMultiTargets(qureg, targets, numTargets, __func__);
     validateMultiQubitKrausMap(qureg, numTargets, ops, numOps, __func__);
+    validateNotPacked(qureg, __func__);
+    validateNotCompressed(qureg, __func__);
     
     densmatr_mixMultiQubitKrausMap(qureg, targets, numTargets, ops, numOps);
     qasm_recordComment(qureg,
@@ -1046,20 +1828,149 @@ void initComplexMatrixN(ComplexMatrixN m, qreal re[][1<<m.numQubits], qreal im[]
         }
 }
 
+/*
+ * circuits
+ */
+
+Circuit createCircuit(int numQubits, int numParams) {
+    validateCreateCircuit(numQubits, numParams, __func__);
+    
+    return circuit_create(numQubits, numParams);
+}
+
+void destroyCircuit(Circuit circ) {
+    circuit_destroy(circ);
+}
+
+void addGateToCircuit(Circuit circ, enum circuitGateType gate, int* qubits, qreal* params) {
+    validateCircuitGate(circ, gate, qubits, __func__);
+    
+    circuit_addGate(circ, gate, qubits, params, -1);
+}
+
+void addParamGateToCircuit(Circuit circ, enum circuitGateType gate, int* qubits, int paramInd) {
+    validateCircuitGate(circ, gate, qubits, __func__);
+    validateCircuitParamGate(circ, gate, paramInd, __func__);
+    
+    circuit_addGate(circ, gate, qubits, NULL, paramInd);
+}
+
+void setCircuitParams(Circuit circ, qreal* params) {
+    circuit_setParams(circ, params);
+}
+
+void compileCircuit(Circuit circ) {
+    circuit_compile(circ);
+}
+
+void applyCircuit(Qureg qureg, Circuit circ) {
+    validateCircuitQureg(qureg, circ, __func__);
+    validateCircuitGates(qureg, circ, __func__);
+    validateNotPacked(qureg, __func__);
+    
+    circuit_apply(qureg, circ);
+}
+
+long long int calcCircuitIOBytes(Qureg qureg, Circuit circ, long long int* gateIOBytes) {
+    validateStateVecQureg(qureg, __func__);
+    validateCircuitQureg(qureg, circ, __func__);
+    
+    return circuit_calcIOBytes(qureg, circ, gateIOBytes);
+}
+
+qreal calcCircuitGradient(Qureg qureg, Circuit circ, enum pauliOpType* allPauliCodes, qreal* termCoeffs, int numSumTerms, qreal* gradient, Qureg workspace1, Qureg workspace2) {
+    validateStateVecQureg(qureg, __func__);
+    validateStateVecQureg(workspace1, __func__);
+    validateStateVecQureg(workspace2, __func__);
+    validateCircuitQureg(qureg, circ, __func__);
+    validateMatchingQuregDims(qureg, workspace1, __func__);
+    validateMatchingQuregDims(qureg, workspace2, __func__);
+    validateNumPauliSumTerms(numSumTerms, __func__);
+    validatePauliCodes(allPauliCodes, numSumTerms*qureg.numQubitsRepresented, __func__);
+    validateNotReal(qureg, __func__);
+    validateNotSubspace(qureg, __func__);
+    validateNotCompressed(qureg, __func__);
+    validateNotCompressed(workspace1, __func__);
+    validateNotCompressed(workspace2, __func__);
+    
+    return circuit_calcGradient(qureg, circ, allPauliCodes, termCoeffs, numSumTerms, gradient, workspace1, workspace2);
+}
+
+Circuit readQASMFile(char* filename) {
+    Circuit circ;
+    char errMsg[QASM_MAX_ERR_LEN];
+    int isParsed = qasm_parseFile(filename, NULL, &circ, errMsg);
+    validateQASMParsed(isParsed, errMsg, __func__);
+    
+    return circ;
+}
+
+Circuit readQASMString(char* qasm) {
+    Circuit circ;
+    char errMsg[QASM_MAX_ERR_LEN];
+    int isParsed = qasm_parseString(qasm, NULL, &circ, errMsg);
+    validateQASMParsed(isParsed, errMsg, __func__);
+    
+    return circ;
+}
+
+void applyQASMFile(Qureg qureg, char* filename) {
+    validateNotPacked(qureg, __func__);
+    
+    char errMsg[QASM_MAX_ERR_LEN];
+    int isParsed = qasm_parseFile(filename, &qureg, NULL, errMsg);
+    validateQASMParsed(isParsed, errMsg, __func__);
+}
+
+void applyQASMString(Qureg qureg, char* qasm) {
+    validateNotPacked(qureg, __func__);
+    
+    char errMsg[QASM_MAX_ERR_LEN];
+    int isParsed = qasm_parseString(qasm, &qureg, NULL, errMsg);
+    validateQASMParsed(isParsed, errMsg, __func__);
+}
+
+Circuit readCircuitFile(char* filename, int numQubits) {
+    validateCreateCircuit(numQubits, 0, __func__);
+    
+    Circuit circ;
+    char errMsg[CIRCUIT_FILE_MAX_ERR_LEN];
+    int isRead = circuit_readFile(filename, numQubits, &circ, errMsg);
+    validateCircuitFileRead(isRead, errMsg, __func__);
+    
+    return circ;
+}
+
+void writeCircuitFile(Circuit circ, char* filename) {
+    int success = circuit_writeFile(circ, filename);
+    validateFileOpened(success, __func__);
+}
+
 /*
  * debug
  */
 
 int compareStates(Qureg qureg1, Qureg qureg2, qreal precision) {
     validateMatchingQuregDims(qureg1, qureg2, __func__);
+    validateNotSubspace(qureg1, __func__);
+    validateNotSubspace(qureg2, __func__);
+    validateNotCompressed(qureg1, __func__);
+    validateNotCompressed(qureg2, __func__);
     return statevec_compareStates(qureg1, qureg2, precision);
 }
 
 void initDebugState(Qureg qureg) {
+    validateNotReal(qureg, __func__);
+    validateNotSubspace(qureg, __func__);
+    validateNotPacked(qureg, __func__);
+    validateNotCompressed(qureg, __func__);
     statevec_initDebugState(qureg);
 }
 
 void initStateFromSingleFile(Qureg *qureg, char filename[200], QuESTEnv env) {
+    validateNotReal(*qureg, __func__);
+    validateNotSubspace(*qureg, __func__);
+    validateNotCompressed(*qureg, __func__);
     int success = statevec_initStateFromSingleFile(qureg, filename, env);
     validateFileOpened(success, __func__);
 }
@@ -1068,19 +1979,66 @@ void initStateOfSingleQubit(Qureg *qureg, int qubitId, int outcome) {
     validateStateVecQureg(*qureg, __func__);
     validateTarget(*qureg, qubitId, __func__);
     validateOutcome(outcome, __func__);
+    validateNotSubspace(*qureg, __func__);
+    validateNotCompressed(*qureg, __func__);
     statevec_initStateOfSingleQubit(qureg, qubitId, outcome);
 }
 
 void reportStateToScreen(Qureg qureg, QuESTEnv env, int reportRank)  {
+    validateNotSubspace(qureg, __func__);
+    validateNotCompressed(qureg, __func__);
     statevec_reportStateToScreen(qureg, env, reportRank);
 }
 
+void writeQuregCheckpoint(Qureg qureg, char* filename) {
+    validateNotCompressed(qureg, __func__);
+    
+    int success = statevec_writeCheckpoint(qureg, filename);
+    validateFileOpened(success, __func__);
+}
+
+long long int readQuregCheckpoint(Qureg qureg, char* filename, int useMapping) {
+    validateNotCompressed(qureg, __func__);
+    
+    CheckpointHeader header;
+    int success = statevec_readCheckpointHeader(filename, &header);
+    validateFileOpened(success, __func__);
+    validateCheckpointHeader(qureg, header, __func__);
+    
+    success = statevec_readCheckpoint(qureg, filename, header, useMapping);
+    validateCheckpointLoaded(success, __func__);
+    
+    qasm_recordComment(qureg, "Here, the register was restored from a checkpoint.");
+    return header.gateIndex;
+}
+
+void startQuregCheckpoint(Qureg qureg, char* filename, long long int gateIndex) {
+    validateNotCompressed(qureg, __func__);
+    
+    // a register has at most one checkpoint in progress
+    int success = statevec_finishCheckpoint(qureg);
+    validateFileOpened(success, __func__);
+    
+    success = statevec_startCheckpoint(qureg, filename, gateIndex);
+    validateFileOpened(success, __func__);
+}
+
+void finishQuregCheckpoint(Qureg qureg) {
+    validateNotCompressed(qureg, __func__);
+    
+    int success = statevec_finishCheckpoint(qureg);
+    validateFileOpened(success, __func__);
+}
+
 int  getQuEST_PREC(void) {
   return sizeof(qreal)/4;
 }
   
 void u1Gate(Qureg qureg, int targetQubit, qreal lambda){
     validateTarget(qureg, targetQubit, __func__);
+    validateNotReal(qureg, __func__);
+    validateNotSubspace(qureg, __func__);
+    validateNotCompressed(qureg, __func__);
 
     qreal cos_ = cos(lambda), sin_ = sin(lambda);
 
@@ -1090,16 +2048,19 @@ void u1Gate(Qureg qureg, int targetQubit, qreal lambda){
     };
     validateOneQubitUnitaryMatrix(u, __func__);
     
-    statevec_unitary(qureg, targetQubit, u);
-    if (qureg.isDensityMatrix) {
-        statevec_unitary(qureg, targetQubit+qureg.numQubitsRepresented, getConjugateMatrix2(u));
-    }
+    if (qureg.isDensityMatrix)
+        densmatr_unitary(qureg, targetQubit, u);
+    else
+        statevec_unitary(qureg, targetQubit, u);
     
     qasm_recordUnitary(qureg, u, targetQubit);
 
 }
 void u2Gate(Qureg qureg, int targetQubit, qreal phi, qreal lambda){
     validateTarget(qureg, targetQubit, __func__);
+    validateNotReal(qureg, __func__);
+    validateNotSubspace(qureg, __func__);
+    validateNotCompressed(qureg, __func__);
 
     qreal Inv_sqrt2 = 1/sqrt(2);
     qreal cos_phi = cos(phi)*Inv_sqrt2, sin_phi = sin(phi)*Inv_sqrt2;
@@ -1112,16 +2073,19 @@ void u2Gate(Qureg qureg, int targetQubit, qreal phi, qreal lambda){
     };
     validateOneQubitUnitaryMatrix(u, __func__);
     
-    statevec_unitary(qureg, targetQubit, u);
-    if (qureg.isDensityMatrix) {
-        statevec_unitary(qureg, targetQubit+qureg.numQubitsRepresented, getConjugateMatrix2(u));
-    }
+    if (qureg.isDensityMatrix)
+        densmatr_unitary(qureg, targetQubit, u);
+    else
+        statevec_unitary(qureg, targetQubit, u);
     
     qasm_recordUnitary(qureg, u, targetQubit);
 
 }
 void u3Gate(Qureg qureg, int targetQubit, qreal theta, qreal phi, qreal lambda){
     validateTarget(qureg, targetQubit, __func__);
+    validateNotReal(qureg, __func__);
+    validateNotSubspace(qureg, __func__);
+    validateNotCompressed(qureg, __func__);
 
     
     qreal cos_theta = cos(theta/2), sin_theta = sin(theta/2);
@@ -1135,15 +2099,18 @@ void u3Gate(Qureg qureg, int targetQubit, qreal theta, qreal phi, qreal lambda){
     };
     validateOneQubitUnitaryMatrix(u, __func__);
     
-    statevec_unitary(qureg, targetQubit, u);
-    if (qureg.isDensityMatrix) {
-        statevec_unitary(qureg, targetQubit+qureg.numQubitsRepresented, getConjugateMatrix2(u));
-    }
+    if (qureg.isDensityMatrix)
+        densmatr_unitary(qureg, targetQubit, u);
+    else
+        statevec_unitary(qureg, targetQubit, u);
     
     qasm_recordUnitary(qureg, u, targetQubit);
 }
 void SqX(Qureg qureg, int targetQubit){
     validateTarget(qureg, targetQubit, __func__);
+    validateNotReal(qureg, __func__);
+    validateNotSubspace(qureg, __func__);
+    validateNotCompressed(qureg, __func__);
 
     qreal Inv_sqrt2 = 1/sqrt(2);
     ComplexMatrix2 u = {
@@ -1152,16 +2119,19 @@ void SqX(Qureg qureg, int targetQubit){
     };
     validateOneQubitUnitaryMatrix(u, __func__);
     
-    statevec_unitary(qureg, targetQubit, u);
-    if (qureg.isDensityMatrix) {
-        statevec_unitary(qureg, targetQubit+qureg.numQubitsRepresented, getConjugateMatrix2(u));
-    }
+    if (qureg.isDensityMatrix)
+        densmatr_unitary(qureg, targetQubit, u);
+    else
+        statevec_unitary(qureg, targetQubit, u);
     
     qasm_recordUnitary(qureg, u, targetQubit);
 
 }
 void SqY(Qureg qureg, int targetQubit){
     validateTarget(qureg, targetQubit, __func__);
+    validateNotReal(qureg, __func__);
+    validateNotSubspace(qureg, __func__);
+    validateNotCompressed(qureg, __func__);
 
     qreal Inv_sqrt2 = 1/sqrt(2);
     ComplexMatrix2 u = {
@@ -1170,16 +2140,19 @@ void SqY(Qureg qureg, int targetQubit){
     };
     validateOneQubitUnitaryMatrix(u, __func__);
     
-    statevec_unitary(qureg, targetQubit, u);
-    if (qureg.isDensityMatrix) {
-        statevec_unitary(qureg, targetQubit+qureg.numQubitsRepresented, getConjugateMatrix2(u));
-    }
+    if (qureg.isDensityMatrix)
+        densmatr_unitary(qureg, targetQubit, u);
+    else
+        statevec_unitary(qureg, targetQubit, u);
     
     qasm_recordUnitary(qureg, u, targetQubit);
 
 }
 void SqW(Qureg qureg, int targetQubit){
     validateTarget(qureg, targetQubit, __func__);
+    validateNotReal(qureg, __func__);
+    validateNotSubspace(qureg, __func__);
+    validateNotCompressed(qureg, __func__);
 
     qreal Inv_sqrt2 = 1/sqrt(2);
     ComplexMatrix2 u = {
@@ -1188,16 +2161,18 @@ void SqW(Qureg qureg, int targetQubit){
     };
     validateOneQubitUnitaryMatrix(u, __func__);
     
-    statevec_unitary(qureg, targetQubit, u);
-    if (qureg.isDensityMatrix) {
-        statevec_unitary(qureg, targetQubit+qureg.numQubitsRepresented, getConjugateMatrix2(u));
-    }
+    if (qureg.isDensityMatrix)
+        densmatr_unitary(qureg, targetQubit, u);
+    else
+        statevec_unitary(qureg, targetQubit, u);
     
     qasm_recordUnitary(qureg, u, targetQubit);
 }
 void fSim(Qureg qureg, int targetQubit1, int targetQubit2, qreal theta, qreal phi){
 
     validateMultiTargets(qureg, (int []) {targetQubit1, targetQubit2}, 2, __func__);
+    validateNotReal(qureg, __func__);
+    validateNotCompressed(qureg, __func__);
 
     qreal cos_theta = cos(theta), sin_theta = sin(theta);
     qreal cos_phi = cos(phi), sin_phi = sin(phi);
@@ -1208,11 +2183,10 @@ void fSim(Qureg qureg, int targetQubit1, int targetQubit2, qreal theta, qreal ph
 
     validateTwoQubitUnitaryMatrix(qureg, u, __func__);
     
-    statevec_twoQubitUnitary(qureg, targetQubit1, targetQubit2, u);
-    if (qureg.isDensityMatrix) {
-        int shift = qureg.numQubitsRepresented;
-        statevec_twoQubitUnitary(qureg, targetQubit1+shift, targetQubit2+shift, getConjugateMatrix4(u));
-    }
+    if (qureg.isDensityMatrix)
+        densmatr_twoQubitUnitary(qureg, targetQubit1, targetQubit2, u);
+    else
+        statevec_twoQubitUnitary(qureg, targetQubit1, targetQubit2, u);
     
     qasm_recordComment(qureg, "Here, an undisclosed 2-qubit unitary was applied.");
 
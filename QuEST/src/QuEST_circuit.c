@@ -0,0 +1,1044 @@
+// Distributed under MIT licence. See https://github.com/QuEST-Kit/QuEST/blob/master/LICENCE.txt for details
+
+/** @file
+ * Functions for building, applying and differentiating Circuit instances.
+ * Like QuEST_common.c, these never call front-end functions in QuEST.c; gates
+ * are effected directly with the statevec_ backend, and the conjugate gates upon
+ * the shifted qubits of density matrices are applied explicitly.
+ *
+ * Gradients are computed with the adjoint method: after applying the circuit
+ * U = U_N ... U_1 to |psi> and setting |lambda> = H|psi>, both registers are
+ * uncomputed gate-by-gate, such that before undoing gate k,
+ *      |psi>    = U_k ... U_1 |psi_0>
+ *      |lambda> = U_{k+1}^dag ... U_N^dag H U |psi_0>
+ * and the derivative of <H> with respect to the angle of U_k is
+ *      2 Re <lambda| dU_k/dangle U_k^dag |psi>
+ * which for U_k = exp(-i angle/2 G) is Im <lambda|G|psi>, and for a phase shift
+ * U_k = exp(i angle P) (P a projector onto |1>) is -2 Im <lambda|P|psi>.
+ */
+
+# include "QuEST.h"
+# include "QuEST_precision.h"
+# include "QuEST_internal.h"
+# include "QuEST_qasm.h"
+# include "QuEST_circuit.h"
+
+# include <math.h>
+# include <stdio.h>
+# include <stdlib.h>
+
+# define LIST_INIT_SIZE 64      // initial number of gates which fit in a gate list
+# define LIST_GROW_FAC 2        // growth factor when the gate list dynamically resizes
+# define OUT_OF_CORE_BLOCK_QUBITS 22  // qubits of the amplitude blocks to which passes upon out-of-core registers are applied
+
+/** Codes of compiled operations, beyond those of enum circuitGateType */
+enum circuitOpType {
+    CIRCUIT_OP_UNITARY=100,             // CircuitOp.matrix upon qubits[0]
+    CIRCUIT_OP_CONTROLLED_UNITARY=101   // CircuitOp.matrix upon qubits[1], controlled on qubits[0]
+};
+
+static const int circuitGateNumQubits[] = {
+    [CIRCUIT_HADAMARD] = 1,
+    [CIRCUIT_PAULI_X] = 1,
+    [CIRCUIT_PAULI_Y] = 1,
+    [CIRCUIT_PAULI_Z] = 1,
+    [CIRCUIT_S_GATE] = 1,
+    [CIRCUIT_T_GATE] = 1,
+    [CIRCUIT_SQRT_X] = 1,
+    [CIRCUIT_SQRT_Y] = 1,
+    [CIRCUIT_SQRT_W] = 1,
+    [CIRCUIT_ROTATE_X] = 1,
+    [CIRCUIT_ROTATE_Y] = 1,
+    [CIRCUIT_ROTATE_Z] = 1,
+    [CIRCUIT_PHASE_SHIFT] = 1,
+    [CIRCUIT_U1] = 1,
+    [CIRCUIT_U2] = 1,
+    [CIRCUIT_U3] = 1,
+    [CIRCUIT_CONTROLLED_NOT] = 2,
+    [CIRCUIT_CONTROLLED_PAULI_Y] = 2,
+    [CIRCUIT_CONTROLLED_PHASE_FLIP] = 2,
+    [CIRCUIT_CONTROLLED_ROTATE_X] = 2,
+    [CIRCUIT_CONTROLLED_ROTATE_Y] = 2,
+    [CIRCUIT_CONTROLLED_ROTATE_Z] = 2,
+    [CIRCUIT_CONTROLLED_PHASE_SHIFT] = 2,
+    [CIRCUIT_SWAP] = 2,
+    [CIRCUIT_FSIM] = 2
+};
+
+static const int circuitGateNumParams[] = {
+    [CIRCUIT_ROTATE_X] = 1,
+    [CIRCUIT_ROTATE_Y] = 1,
+    [CIRCUIT_ROTATE_Z] = 1,
+    [CIRCUIT_PHASE_SHIFT] = 1,
+    [CIRCUIT_U1] = 1,
+    [CIRCUIT_U2] = 2,
+    [CIRCUIT_U3] = 3,
+    [CIRCUIT_CONTROLLED_ROTATE_X] = 1,
+    [CIRCUIT_CONTROLLED_ROTATE_Y] = 1,
+    [CIRCUIT_CONTROLLED_ROTATE_Z] = 1,
+    [CIRCUIT_CONTROLLED_PHASE_SHIFT] = 1,
+    [CIRCUIT_FSIM] = 2
+};
+
+static void circuitAllocError(void) {
+    printf("!!!\nINTERNAL ERROR: Could not allocate memory for circuit!\n!!!");
+    exit(1);
+}
+
+int circuit_isValidGate(int gate) {
+    return gate >= CIRCUIT_HADAMARD && gate <= CIRCUIT_FSIM;
+}
+
+int circuit_getNumGateQubits(enum circuitGateType gate) {
+    return circuitGateNumQubits[gate];
+}
+
+int circuit_getNumGateParams(enum circuitGateType gate) {
+    return circuitGateNumParams[gate];
+}
+
+int circuit_isParamGate(enum circuitGateType gate) {
+    switch (gate) {
+        case CIRCUIT_ROTATE_X:
+        case CIRCUIT_ROTATE_Y:
+        case CIRCUIT_ROTATE_Z:
+        case CIRCUIT_PHASE_SHIFT:
+        case CIRCUIT_U1:
+        case CIRCUIT_CONTROLLED_ROTATE_X:
+        case CIRCUIT_CONTROLLED_ROTATE_Y:
+        case CIRCUIT_CONTROLLED_ROTATE_Z:
+        case CIRCUIT_CONTROLLED_PHASE_SHIFT:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+Circuit circuit_create(int numQubits, int numParams) {
+
+    Circuit circ;
+    circ.numQubits = numQubits;
+    circ.numParams = numParams;
+
+    // calloc initialises the parameters to zero (and permits numParams=0)
+    circ.params = calloc((numParams > 0)? numParams : 1, sizeof *circ.params);
+    circ.gateList = malloc(sizeof *circ.gateList);
+    if (circ.params == NULL || circ.gateList == NULL)
+        circuitAllocError();
+
+    circ.gateList->numGates = 0;
+    circ.gateList->capacity = LIST_INIT_SIZE;
+    circ.gateList->gates = malloc(LIST_INIT_SIZE * sizeof *(circ.gateList->gates));
+    if (circ.gateList->gates == NULL)
+        circuitAllocError();
+
+    circ.gateList->ops = NULL;
+    circ.gateList->numOps = 0;
+    circ.gateList->isCompiled = 0;
+
+    return circ;
+}
+
+void circuit_destroy(Circuit circ) {
+    free(circ.gateList->ops);
+    free(circ.gateList->gates);
+    free(circ.gateList);
+    free(circ.params);
+}
+
+void circuit_addGate(Circuit circ, enum circuitGateType gate, int* qubits, qreal* params, int paramInd) {
+
+    CircuitGateList* list = circ.gateList;
+
+    // grow gate list if necessary
+    if (list->numGates == list->capacity) {
+        int newCapacity = LIST_GROW_FAC * list->capacity;
+        CircuitGate* newGates = realloc(list->gates, newCapacity * sizeof *newGates);
+        if (newGates == NULL)
+            circuitAllocError();
+
+        list->gates = newGates;
+        list->capacity = newCapacity;
+    }
+
+    // the compiled plan is now stale
+    list->isCompiled = 0;
+
+    CircuitGate* g = &(list->gates[list->numGates++]);
+    g->type = gate;
+    g->paramInd = paramInd;
+
+    int numQubits = circuitGateNumQubits[gate];
+    for (int q=0; q<2; q++)
+        g->qubits[q] = (q < numQubits)? qubits[q] : -1;
+
+    int numParams = (params == NULL)? 0 : circuitGateNumParams[gate];
+    for (int p=0; p<3; p++)
+        g->params[p] = (p < numParams)? params[p] : 0;
+}
+
+void circuit_clear(Circuit circ) {
+    circ.gateList->numGates = 0;
+    circ.gateList->isCompiled = 0;
+}
+
+void circuit_setParams(Circuit circ, qreal* params) {
+    for (int p=0; p<circ.numParams; p++)
+        circ.params[p] = params[p];
+}
+
+/** populates the matrix of a one-qubit gate, or of the target of a controlled rotation,
+ * which is not bound to a circuit parameter
+ */
+static ComplexMatrix2 getCircuitGateMatrix2(CircuitGate* gate) {
+
+    qreal* p = gate->params;
+    qreal rt2 = 1/sqrt(2);
+    ComplexMatrix2 u = {.real={{0}}, .imag={{0}}};
+
+    switch (gate->type) {
+        case CIRCUIT_HADAMARD:
+            u.real[0][0] = rt2;     u.real[0][1] = rt2;
+            u.real[1][0] = rt2;     u.real[1][1] = -rt2;
+            break;
+        case CIRCUIT_PAULI_X:
+            u.real[0][1] = 1;       u.real[1][0] = 1;
+            break;
+        case CIRCUIT_PAULI_Y:
+            u.imag[0][1] = -1;      u.imag[1][0] = 1;
+            break;
+        case CIRCUIT_PAULI_Z:
+            u.real[0][0] = 1;       u.real[1][1] = -1;
+            break;
+        case CIRCUIT_S_GATE:
+            u.real[0][0] = 1;       u.imag[1][1] = 1;
+            break;
+        case CIRCUIT_T_GATE:
+            u.real[0][0] = 1;       u.real[1][1] = rt2;     u.imag[1][1] = rt2;
+            break;
+        case CIRCUIT_ROTATE_X:
+        case CIRCUIT_CONTROLLED_ROTATE_X:
+            u.real[0][0] = cos(p[0]/2);     u.imag[0][1] = - sin(p[0]/2);
+            u.imag[1][0] = - sin(p[0]/2);   u.real[1][1] = cos(p[0]/2);
+            break;
+        case CIRCUIT_ROTATE_Y:
+        case CIRCUIT_CONTROLLED_ROTATE_Y:
+            u.real[0][0] = cos(p[0]/2);     u.real[0][1] = - sin(p[0]/2);
+            u.real[1][0] = sin(p[0]/2);     u.real[1][1] = cos(p[0]/2);
+            break;
+        case CIRCUIT_ROTATE_Z:
+        case CIRCUIT_CONTROLLED_ROTATE_Z:
+            u.real[0][0] = cos(p[0]/2);     u.imag[0][0] = - sin(p[0]/2);
+            u.real[1][1] = cos(p[0]/2);     u.imag[1][1] =   sin(p[0]/2);
+            break;
+        case CIRCUIT_PHASE_SHIFT:
+        case CIRCUIT_U1:
+            u.real[0][0] = 1;
+            u.real[1][1] = cos(p[0]);       u.imag[1][1] = sin(p[0]);
+            break;
+        case CIRCUIT_SQRT_X:
+            u.real[0][0] = rt2;     u.imag[0][1] = -rt2;
+            u.imag[1][0] = -rt2;    u.real[1][1] = rt2;
+            break;
+        case CIRCUIT_SQRT_Y:
+            u.real[0][0] = rt2;     u.real[0][1] = -rt2;
+            u.real[1][0] = rt2;     u.real[1][1] = rt2;
+            break;
+        case CIRCUIT_SQRT_W:
+            u.real[0][0] = rt2;     u.real[0][1] = -0.5;    u.imag[0][1] = -0.5;
+            u.real[1][0] = 0.5;     u.imag[1][0] = -0.5;    u.real[1][1] = rt2;
+            break;
+        case CIRCUIT_U2: // (phi, lambda)
+            u.real[0][0] = rt2;
+            u.real[0][1] = - rt2*cos(p[1]);         u.imag[0][1] = - rt2*sin(p[1]);
+            u.real[1][0] =   rt2*cos(p[0]);         u.imag[1][0] =   rt2*sin(p[0]);
+            u.real[1][1] =   rt2*cos(p[0]+p[1]);    u.imag[1][1] =   rt2*sin(p[0]+p[1]);
+            break;
+        case CIRCUIT_U3: // (theta, phi, lambda)
+            u.real[0][0] =   cos(p[0]/2);
+            u.real[0][1] = - sin(p[0]/2)*cos(p[2]);         u.imag[0][1] = - sin(p[0]/2)*sin(p[2]);
+            u.real[1][0] =   sin(p[0]/2)*cos(p[1]);         u.imag[1][0] =   sin(p[0]/2)*sin(p[1]);
+            u.real[1][1] =   cos(p[0]/2)*cos(p[1]+p[2]);    u.imag[1][1] =   cos(p[0]/2)*sin(p[1]+p[2]);
+            break;
+        default:
+            break;
+    }
+    return u;
+}
+
+/** populates the matrix of fSim(theta, phi) */
+static ComplexMatrix4 getCircuitGateMatrix4(CircuitGate* gate) {
+
+    qreal* p = gate->params;
+    ComplexMatrix4 u = {.real={{0}}, .imag={{0}}};
+
+    u.real[0][0] = 1;
+    u.real[1][1] = cos(p[0]);   u.imag[1][2] = - sin(p[0]);
+    u.real[2][2] = cos(p[0]);   u.imag[2][1] = - sin(p[0]);
+    u.real[3][3] = cos(p[1]);   u.imag[3][3] = - sin(p[1]);
+    return u;
+}
+
+/** populates the two-qubit matrix of a (possibly compiled) operation, with circuit parameters
+ * substituted, where qubits[0] is the least significant qubit. A one-qubit operation acts as
+ * the identity upon the second qubit, and a controlled operation is controlled on qubits[0].
+ */
+static ComplexMatrix4 getCircuitOpMatrix4(CircuitOp* op, qreal* circParams) {
+
+    CircuitGate gate = op->gate;
+    if (gate.paramInd >= 0)
+        gate.params[0] = circParams[gate.paramInd];
+
+    ComplexMatrix4 u = {.real={{0}}, .imag={{0}}};
+    if (gate.type == CIRCUIT_FSIM)
+        return getCircuitGateMatrix4(&gate);
+    if (gate.type == CIRCUIT_SWAP) {
+        u.real[0][0] = 1;   u.real[1][2] = 1;
+        u.real[2][1] = 1;   u.real[3][3] = 1;
+        return u;
+    }
+
+    // the controlled gates without a rotation act as their one-qubit counterpart upon the target
+    int isControlled = 1;
+    switch (gate.type) {
+        case CIRCUIT_CONTROLLED_NOT:            gate.type = CIRCUIT_PAULI_X;        break;
+        case CIRCUIT_CONTROLLED_PAULI_Y:        gate.type = CIRCUIT_PAULI_Y;        break;
+        case CIRCUIT_CONTROLLED_PHASE_FLIP:     gate.type = CIRCUIT_PAULI_Z;        break;
+        case CIRCUIT_CONTROLLED_PHASE_SHIFT:    gate.type = CIRCUIT_PHASE_SHIFT;    break;
+        case CIRCUIT_CONTROLLED_ROTATE_X:
+        case CIRCUIT_CONTROLLED_ROTATE_Y:
+        case CIRCUIT_CONTROLLED_ROTATE_Z:
+        case CIRCUIT_OP_CONTROLLED_UNITARY:
+            break;
+        default:
+            isControlled = 0;
+    }
+    ComplexMatrix2 u2 = (gate.type == CIRCUIT_OP_UNITARY || gate.type == CIRCUIT_OP_CONTROLLED_UNITARY)?
+        op->matrix : getCircuitGateMatrix2(&gate);
+
+    for (int r=0; r<2; r++)
+        for (int c=0; c<2; c++) {
+            if (isControlled) {
+                u.real[1+2*r][1+2*c] = u2.real[r][c];
+                u.imag[1+2*r][1+2*c] = u2.imag[r][c];
+            }
+            else
+                for (int k=0; k<2; k++) {
+                    u.real[r+2*k][c+2*k] = u2.real[r][c];
+                    u.imag[r+2*k][c+2*k] = u2.imag[r][c];
+                }
+        }
+    if (isControlled) {
+        u.real[0][0] = 1;
+        u.real[2][2] = 1;
+    }
+    return u;
+}
+
+ComplexMatrix4 circuit_getGateMatrix(Circuit circ, int gateInd) {
+    CircuitOp op = {.gate = circ.gateList->gates[gateInd]};
+    return getCircuitOpMatrix4(&op, circ.params);
+}
+
+int circuit_isRealGate(Circuit circ, int gateInd) {
+    ComplexMatrix4 u = circuit_getGateMatrix(circ, gateInd);
+    for (int r=0; r<4; r++)
+        for (int c=0; c<4; c++)
+            if (absReal(u.imag[r][c]) >= REAL_EPS)
+                return 0;
+    return 1;
+}
+
+int circuit_isNumberConservingGate(Circuit circ, int gateInd) {
+
+    // the number of ones in each two-qubit basis state
+    static const int weights[] = {0, 1, 1, 2};
+
+    ComplexMatrix4 u = circuit_getGateMatrix(circ, gateInd);
+    for (int r=0; r<4; r++)
+        for (int c=0; c<4; c++)
+            if (weights[r] != weights[c] && (absReal(u.real[r][c]) >= REAL_EPS || absReal(u.imag[r][c]) >= REAL_EPS))
+                return 0;
+    return 1;
+}
+
+/** returns the matrix product a b */
+static ComplexMatrix2 getMatrix2Product(ComplexMatrix2 a, ComplexMatrix2 b) {
+    ComplexMatrix2 prod;
+    for (int r=0; r<2; r++)
+        for (int c=0; c<2; c++) {
+            prod.real[r][c] = 0;
+            prod.imag[r][c] = 0;
+            for (int k=0; k<2; k++) {
+                prod.real[r][c] += a.real[r][k]*b.real[k][c] - a.imag[r][k]*b.imag[k][c];
+                prod.imag[r][c] += a.real[r][k]*b.imag[k][c] + a.imag[r][k]*b.real[k][c];
+            }
+        }
+    return prod;
+}
+
+static void addCompiledOp(CircuitGateList* list, CircuitGate gate, ComplexMatrix2 matrix) {
+    CircuitOp* op = &(list->ops[list->numOps++]);
+    op->gate = gate;
+    op->matrix = matrix;
+}
+
+/** emits the fused one-qubit matrix pending upon qubit, if any */
+static void flushPendingMatrix(CircuitGateList* list, int qubit, int* isPending, ComplexMatrix2* pending) {
+    if (!isPending[qubit])
+        return;
+
+    CircuitGate gate = {.type=CIRCUIT_OP_UNITARY, .qubits={qubit, -1}, .params={0}, .paramInd=-1};
+    addCompiledOp(list, gate, pending[qubit]);
+    isPending[qubit] = 0;
+}
+
+void circuit_compile(Circuit circ) {
+
+    CircuitGateList* list = circ.gateList;
+    CircuitGate* gates = list->gates;
+    ComplexMatrix2 noMatrix = {.real={{0}}, .imag={{0}}};
+
+    // compilation never increases the number of operations
+    free(list->ops);
+    list->ops = malloc(((list->numGates > 0)? list->numGates : 1) * sizeof *(list->ops));
+    list->numOps = 0;
+
+    // the product of the fixed one-qubit gates not yet emitted upon each qubit
+    int* isPending = calloc(circ.numQubits, sizeof *isPending);
+    ComplexMatrix2* pending = malloc(circ.numQubits * sizeof *pending);
+    if (list->ops == NULL || isPending == NULL || pending == NULL)
+        circuitAllocError();
+
+    for (int g=0; g<list->numGates; g++) {
+        int isFixed = (gates[g].paramInd < 0);
+        int numQubits = circuitGateNumQubits[gates[g].type];
+
+        // fuse fixed one-qubit gates, commuting them past gates upon other qubits
+        if (isFixed && numQubits == 1) {
+            int q = gates[g].qubits[0];
+            ComplexMatrix2 u = getCircuitGateMatrix2(&gates[g]);
+            pending[q] = (isPending[q])? getMatrix2Product(u, pending[q]) : u;
+            isPending[q] = 1;
+            continue;
+        }
+
+        for (int i=0; i<numQubits; i++)
+            flushPendingMatrix(list, gates[g].qubits[i], isPending, pending);
+
+        // precompute the matrices of fixed controlled rotations
+        int isCtrlRot = (
+            gates[g].type == CIRCUIT_CONTROLLED_ROTATE_X ||
+            gates[g].type == CIRCUIT_CONTROLLED_ROTATE_Y ||
+            gates[g].type == CIRCUIT_CONTROLLED_ROTATE_Z);
+
+        if (isFixed && isCtrlRot) {
+            CircuitGate gate = gates[g];
+            gate.type = CIRCUIT_OP_CONTROLLED_UNITARY;
+            addCompiledOp(list, gate, getCircuitGateMatrix2(&gates[g]));
+        }
+        else
+            addCompiledOp(list, gates[g], noMatrix);
+    }
+
+    for (int q=0; q<circ.numQubits; q++)
+        flushPendingMatrix(list, q, isPending, pending);
+
+    free(isPending);
+    free(pending);
+    list->isCompiled = 1;
+}
+
+/** applies a single compiled operation to a statevector, optionally upon qubits shifted
+ * by shift (to effect the conjugate half of a density matrix gate), and optionally
+ * conjugated and/or inverted (for uncomputing).
+ */
+static void applyCircuitOp(Qureg qureg, CircuitOp* op, qreal* circParams, int shift, int conj, int inverse) {
+
+    CircuitGate* gate = &(op->gate);
+    int q0 = gate->qubits[0] + shift;
+    int q1 = gate->qubits[1] + shift;
+
+    // inverting every parameterised kernel below negates its angle
+    qreal angle = (gate->paramInd >= 0)? circParams[gate->paramInd] : gate->params[0];
+    if (inverse)
+        angle = - angle;
+
+    // conjugating negates the angle of every gate but the (real) Y rotations
+    qreal conjAngle = (conj)? - angle : angle;
+
+    // S and T are diagonal, so their inverse is their conjugate
+    int conjPhase = (conj != inverse);
+
+    ComplexMatrix2 u2;
+    ComplexMatrix4 u4;
+
+    switch (gate->type) {
+        case CIRCUIT_OP_UNITARY:
+        case CIRCUIT_OP_CONTROLLED_UNITARY:
+            u2 = op->matrix;
+            if (conj)
+                u2 = getConjugateMatrix2(u2);
+            if (inverse)
+                u2 = getConjugateTransposeMatrix2(u2);
+            if (gate->type == CIRCUIT_OP_UNITARY)
+                statevec_unitary(qureg, q0, u2);
+            else
+                statevec_controlledUnitary(qureg, q0, q1, u2);
+            break;
+        case CIRCUIT_HADAMARD:
+            statevec_hadamard(qureg, q0);
+            break;
+        case CIRCUIT_PAULI_X:
+            statevec_pauliX(qureg, q0);
+            break;
+        case CIRCUIT_PAULI_Y:
+            if (conj)
+                statevec_pauliYConj(qureg, q0);
+            else
+                statevec_pauliY(qureg, q0);
+            break;
+        case CIRCUIT_PAULI_Z:
+            statevec_pauliZ(qureg, q0);
+            break;
+        case CIRCUIT_S_GATE:
+            if (conjPhase)
+                statevec_sGateConj(qureg, q0);
+            else
+                statevec_sGate(qureg, q0);
+            break;
+        case CIRCUIT_T_GATE:
+            if (conjPhase)
+                statevec_tGateConj(qureg, q0);
+            else
+                statevec_tGate(qureg, q0);
+            break;
+        case CIRCUIT_ROTATE_X:
+            statevec_rotateX(qureg, q0, conjAngle);
+            break;
+        case CIRCUIT_ROTATE_Y:
+            statevec_rotateY(qureg, q0, angle);
+            break;
+        case CIRCUIT_ROTATE_Z:
+            statevec_rotateZ(qureg, q0, conjAngle);
+            break;
+        case CIRCUIT_PHASE_SHIFT:
+        case CIRCUIT_U1:
+            statevec_phaseShift(qureg, q0, conjAngle);
+            break;
+        case CIRCUIT_SQRT_X:
+        case CIRCUIT_SQRT_Y:
+        case CIRCUIT_SQRT_W:
+        case CIRCUIT_U2:
+        case CIRCUIT_U3:
+            u2 = getCircuitGateMatrix2(gate);
+            if (conj)
+                u2 = getConjugateMatrix2(u2);
+            if (inverse)
+                u2 = getConjugateTransposeMatrix2(u2);
+            statevec_unitary(qureg, q0, u2);
+            break;
+        case CIRCUIT_CONTROLLED_NOT:
+            statevec_controlledNot(qureg, q0, q1);
+            break;
+        case CIRCUIT_CONTROLLED_PAULI_Y:
+            if (conj)
+                statevec_controlledPauliYConj(qureg, q0, q1);
+            else
+                statevec_controlledPauliY(qureg, q0, q1);
+            break;
+        case CIRCUIT_CONTROLLED_PHASE_FLIP:
+            statevec_controlledPhaseFlip(qureg, q0, q1);
+            break;
+        case CIRCUIT_CONTROLLED_ROTATE_X:
+            statevec_controlledRotateX(qureg, q0, q1, conjAngle);
+            break;
+        case CIRCUIT_CONTROLLED_ROTATE_Y:
+            statevec_controlledRotateY(qureg, q0, q1, angle);
+            break;
+        case CIRCUIT_CONTROLLED_ROTATE_Z:
+            statevec_controlledRotateZ(qureg, q0, q1, conjAngle);
+            break;
+        case CIRCUIT_CONTROLLED_PHASE_SHIFT:
+            statevec_controlledPhaseShift(qureg, q0, q1, conjAngle);
+            break;
+        case CIRCUIT_SWAP:
+            statevec_swapQubitAmps(qureg, q0, q1);
+            break;
+        case CIRCUIT_FSIM:
+            u4 = getCircuitGateMatrix4(gate);
+            if (conj)
+                u4 = getConjugateMatrix4(u4);
+            if (inverse)
+                u4 = getConjugateTransposeMatrix4(u4);
+            statevec_twoQubitUnitary(qureg, q0, q1, u4);
+            break;
+    }
+}
+
+/** applies a single compiled operation to a fixed Hamming-weight register, whose gates have
+ * been validated to conserve the number of ones, so that its one-qubit operations are diagonal
+ */
+static void applySubspaceCircuitOp(Qureg qureg, CircuitOp* op, qreal* circParams) {
+
+    CircuitGate* gate = &(op->gate);
+    int q0 = gate->qubits[0];
+    int q1 = gate->qubits[1];
+
+    if (gate->type == CIRCUIT_SWAP) {
+        statevec_swapQubitAmps(qureg, q0, q1);
+        return;
+    }
+    ComplexMatrix4 u = getCircuitOpMatrix4(op, circParams);
+    if (q1 >= 0) {
+        statevec_multiControlledTwoQubitUnitary(qureg, 0, q0, q1, u);
+        return;
+    }
+
+    // diag(d0, d1) scales every amplitude by d0, then those with q0 in |1> by d1/d0 = d1 conj(d0)
+    Complex d0 = {.real=u.real[0][0], .imag=u.imag[0][0]};
+    Complex d1 = {.real=u.real[1][1], .imag=u.imag[1][1]};
+    Complex ratio = {
+        .real = d1.real*d0.real + d1.imag*d0.imag,
+        .imag = d1.imag*d0.real - d1.real*d0.imag};
+    if (d0.real != 1 || d0.imag != 0)
+        subspace_phaseShiftByTerm(qureg, 0, d0);
+    subspace_phaseShiftByTerm(qureg, 1LL << q0, ratio);
+}
+
+/** records a single gate to the QASM log, as would its equivalent API function */
+static void recordCircuitGate(Qureg qureg, CircuitGate* gate, qreal* circParams) {
+
+    int q0 = gate->qubits[0];
+    int q1 = gate->qubits[1];
+    qreal angle = (gate->paramInd >= 0)? circParams[gate->paramInd] : gate->params[0];
+
+    switch (gate->type) {
+        case CIRCUIT_HADAMARD:
+            qasm_recordGate(qureg, GATE_HADAMARD, q0);
+            break;
+        case CIRCUIT_PAULI_X:
+            qasm_recordGate(qureg, GATE_SIGMA_X, q0);
+            break;
+        case CIRCUIT_PAULI_Y:
+            qasm_recordGate(qureg, GATE_SIGMA_Y, q0);
+            break;
+        case CIRCUIT_PAULI_Z:
+            qasm_recordGate(qureg, GATE_SIGMA_Z, q0);
+            break;
+        case CIRCUIT_S_GATE:
+            qasm_recordGate(qureg, GATE_S, q0);
+            break;
+        case CIRCUIT_T_GATE:
+            qasm_recordGate(qureg, GATE_T, q0);
+            break;
+        case CIRCUIT_ROTATE_X:
+            qasm_recordParamGate(qureg, GATE_ROTATE_X, q0, angle);
+            break;
+        case CIRCUIT_ROTATE_Y:
+            qasm_recordParamGate(qureg, GATE_ROTATE_Y, q0, angle);
+            break;
+        case CIRCUIT_ROTATE_Z:
+            qasm_recordParamGate(qureg, GATE_ROTATE_Z, q0, angle);
+            break;
+        case CIRCUIT_PHASE_SHIFT:
+        case CIRCUIT_U1:
+            qasm_recordParamGate(qureg, GATE_PHASE_SHIFT, q0, angle);
+            break;
+        case CIRCUIT_SQRT_X:
+        case CIRCUIT_SQRT_Y:
+        case CIRCUIT_SQRT_W:
+        case CIRCUIT_U2:
+        case CIRCUIT_U3:
+            qasm_recordUnitary(qureg, getCircuitGateMatrix2(gate), q0);
+            break;
+        case CIRCUIT_CONTROLLED_NOT:
+            qasm_recordControlledGate(qureg, GATE_SIGMA_X, q0, q1);
+            break;
+        case CIRCUIT_CONTROLLED_PAULI_Y:
+            qasm_recordControlledGate(qureg, GATE_SIGMA_Y, q0, q1);
+            break;
+        case CIRCUIT_CONTROLLED_PHASE_FLIP:
+            qasm_recordControlledGate(qureg, GATE_SIGMA_Z, q0, q1);
+            break;
+        case CIRCUIT_CONTROLLED_ROTATE_X:
+            qasm_recordControlledParamGate(qureg, GATE_ROTATE_X, q0, q1, angle);
+            break;
+        case CIRCUIT_CONTROLLED_ROTATE_Y:
+            qasm_recordControlledParamGate(qureg, GATE_ROTATE_Y, q0, q1, angle);
+            break;
+        case CIRCUIT_CONTROLLED_ROTATE_Z:
+            qasm_recordControlledParamGate(qureg, GATE_ROTATE_Z, q0, q1, angle);
+            break;
+        case CIRCUIT_CONTROLLED_PHASE_SHIFT:
+            qasm_recordControlledParamGate(qureg, GATE_PHASE_SHIFT, q0, q1, angle);
+            break;
+        case CIRCUIT_SWAP:
+            qasm_recordControlledGate(qureg, GATE_SWAP, q0, q1);
+            break;
+        case CIRCUIT_FSIM:
+            qasm_recordComment(qureg, "Here, an undisclosed 2-qubit unitary was applied.");
+            break;
+    }
+}
+
+/** returns the mask of the qubits upon which a gate, or compiled operation, acts */
+static long long int getGateQubitMask(CircuitGate* gate) {
+
+    int numQubits;
+    if (gate->type == CIRCUIT_OP_UNITARY)
+        numQubits = 1;
+    else if (gate->type == CIRCUIT_OP_CONTROLLED_UNITARY)
+        numQubits = 2;
+    else
+        numQubits = circuitGateNumQubits[gate->type];
+
+    long long int mask = 0;
+    for (int i=0; i<numQubits; i++)
+        mask |= 1LL << gate->qubits[i];
+    return mask;
+}
+
+/** returns the number of qubits of the blocks of qureg's local amplitudes, to each of which a pass
+ * of gates upon low qubits is applied in turn
+ */
+static int getOutOfCoreBlockQubits(Qureg qureg) {
+    int numLocalQubits = 0;
+    while ((1LL << numLocalQubits) < qureg.numAmpsPerChunk)
+        numLocalQubits++;
+    return (numLocalQubits < OUT_OF_CORE_BLOCK_QUBITS)? numLocalQubits : OUT_OF_CORE_BLOCK_QUBITS;
+}
+
+/** schedules gates (or compiled operations), acting upon the qubits of gateMasks, into passes over 
+ * an out-of-core state-vector, each of which sweeps the state once. A pass is either a lone gate 
+ * upon a qubit outside localMask, or a group of gates upon only the qubits in localMask. Each gate 
+ * joins the first group at or after the last pass upon any of its qubits (commuting past the 
+ * disjoint passes in between), else begins a new pass. Sets passInds[g] to the pass of gate g and 
+ * isLocalPass[p] to whether pass p is a group (so must fit numGates), and returns the number of passes.
+ */
+static int scheduleOutOfCorePasses(long long int* gateMasks, int numGates, long long int localMask, int* passInds, int* isLocalPass) {
+
+    int lastPass[64];
+    for (int q=0; q<64; q++)
+        lastPass[q] = 0;
+
+    int numPasses = 0;
+    for (int g=0; g<numGates; g++) {
+        int first = 0;
+        for (int q=0; q<64; q++)
+            if (((gateMasks[g] >> q) & 1) && lastPass[q] > first)
+                first = lastPass[q];
+
+        int isLocal = ! (gateMasks[g] & ~localMask);
+        int p = numPasses;
+        if (isLocal)
+            for (p=first; p<numPasses && !isLocalPass[p]; p++)
+                ;
+        if (p == numPasses)
+            isLocalPass[numPasses++] = isLocal;
+
+        passInds[g] = p;
+        for (int q=0; q<64; q++)
+            if ((gateMasks[g] >> q) & 1)
+                lastPass[q] = p;
+    }
+    return numPasses;
+}
+
+/** schedules the compiled operations of circ into passes with scheduleOutOfCorePasses, setting 
+ * isLocalPass as described there, and listing the operations of pass p, in order, in 
+ * passOps[passStarts[p]] to passOps[passStarts[p+1]-1]. The arrays must respectively fit
+ * the number of operations, one more, and the number of operations. Returns the number of passes.
+ */
+static int getCircuitPasses(Circuit circ, long long int localMask, int* isLocalPass, int* passStarts, int* passOps) {
+
+    CircuitOp* ops = circ.gateList->ops;
+    int numOps = circ.gateList->numOps;
+    int size = (numOps > 0)? numOps : 1;
+
+    long long int* opMasks = malloc(size * sizeof *opMasks);
+    int* passInds = malloc(size * sizeof *passInds);
+    if (opMasks == NULL || passInds == NULL)
+        circuitAllocError();
+
+    for (int o=0; o<numOps; o++)
+        opMasks[o] = getGateQubitMask(&(ops[o].gate));
+    int numPasses = scheduleOutOfCorePasses(opMasks, numOps, localMask, passInds, isLocalPass);
+
+    // list the operations of each pass contiguously, retaining their order
+    for (int p=0; p<=numPasses; p++)
+        passStarts[p] = 0;
+    for (int o=0; o<numOps; o++)
+        passStarts[passInds[o] + 1]++;
+    for (int p=0; p<numPasses; p++)
+        passStarts[p+1] += passStarts[p];
+    for (int o=0; o<numOps; o++)
+        passOps[passStarts[passInds[o]]++] = o;
+    for (int p=numPasses; p>0; p--)
+        passStarts[p] = passStarts[p-1];
+    passStarts[0] = 0;
+
+    free(opMasks);
+    free(passInds);
+    return numPasses;
+}
+
+/** applies the compiled operations of circ to an out-of-core state-vector in the passes chosen by
+ * scheduleOutOfCorePasses, applying every operation of a group to each block of amplitudes in turn,
+ * while the block is resident in memory
+ */
+static void applyCircuitOutOfCore(Qureg qureg, Circuit circ) {
+
+    CircuitOp* ops = circ.gateList->ops;
+    int size = (circ.gateList->numOps > 0)? circ.gateList->numOps : 1;
+
+    int blockQubits = getOutOfCoreBlockQubits(qureg);
+    long long int blockSize = 1LL << blockQubits;
+
+    int* isLocalPass = malloc(size * sizeof *isLocalPass);
+    int* passStarts = malloc((size + 1) * sizeof *passStarts);
+    int* passOps = malloc(size * sizeof *passOps);
+    if (isLocalPass == NULL || passStarts == NULL || passOps == NULL)
+        circuitAllocError();
+    int numPasses = getCircuitPasses(circ, blockSize-1, isLocalPass, passStarts, passOps);
+
+    // each block is treated as a whole single-node register
+    Qureg block = qureg;
+    block.numQubitsRepresented = blockQubits;
+    block.numQubitsInStateVec = blockQubits;
+    block.numAmpsTotal = blockSize;
+    block.numAmpsPerChunk = blockSize;
+    block.chunkId = 0;
+    block.numChunks = 1;
+
+    for (int p=0; p<numPasses; p++) {
+        if (!isLocalPass[p]) {
+            applyCircuitOp(qureg, &ops[passOps[passStarts[p]]], circ.params, 0, 0, 0);
+            continue;
+        }
+        for (long long int b=0; b<qureg.numAmpsPerChunk; b+=blockSize) {
+            block.stateVec.real = qureg.stateVec.real + b;
+            block.stateVec.imag = qureg.stateVec.imag + b;
+            for (int i=passStarts[p]; i<passStarts[p+1]; i++)
+                applyCircuitOp(block, &ops[passOps[i]], circ.params, 0, 0, 0);
+        }
+    }
+
+    free(isLocalPass);
+    free(passStarts);
+    free(passOps);
+}
+
+/** The operations of a single pass over a compressed register, and the relabelling of their 
+ * qubits to those of the decompressed groups of blocks */
+typedef struct {
+    CircuitOp* ops;
+    int* opInds;
+    int numOps;
+    int* highQubits;
+    int numHighQubits;
+    int numBlockQubits;
+    qreal* params;
+} CompressedPass;
+
+/** applies every operation of a CompressedPass to a decompressed group of blocks */
+static void applyCompressedPass(Qureg group, void* passArg) {
+
+    CompressedPass* pass = passArg;
+    for (int i=0; i<pass->numOps; i++) {
+        CircuitOp op = pass->ops[pass->opInds[i]];
+        for (int q=0; q<2; q++)
+            for (int h=0; h<pass->numHighQubits; h++)
+                if (op.gate.qubits[q] == pass->highQubits[h])
+                    op.gate.qubits[q] = pass->numBlockQubits + h;
+        applyCircuitOp(group, &op, pass->params, 0, 0, 0);
+    }
+}
+
+/** applies the compiled operations of circ to a compressed state-vector in the passes chosen by
+ * scheduleOutOfCorePasses, where a pass upon qubits beyond the blocks acts upon groups of the 
+ * blocks which those qubits index
+ */
+static void applyCircuitCompressed(Qureg qureg, Circuit circ) {
+
+    int size = (circ.gateList->numOps > 0)? circ.gateList->numOps : 1;
+    int numBlockQubits = qureg.compressedAmps->numBlockQubits;
+
+    int* isLocalPass = malloc(size * sizeof *isLocalPass);
+    int* passStarts = malloc((size + 1) * sizeof *passStarts);
+    int* passOps = malloc(size * sizeof *passOps);
+    if (isLocalPass == NULL || passStarts == NULL || passOps == NULL)
+        circuitAllocError();
+    int numPasses = getCircuitPasses(circ, (1LL << numBlockQubits) - 1, isLocalPass, passStarts, passOps);
+
+    int highQubits[2];
+    CompressedPass pass = {.ops=circ.gateList->ops, .highQubits=highQubits, .numBlockQubits=numBlockQubits, .params=circ.params};
+
+    for (int p=0; p<numPasses; p++) {
+        pass.opInds = &passOps[passStarts[p]];
+        pass.numOps = passStarts[p+1] - passStarts[p];
+
+        // a non-local pass is a lone operation, upon at most two qubits beyond the blocks
+        pass.numHighQubits = 0;
+        if (!isLocalPass[p]) {
+            long long int mask = getGateQubitMask(&(pass.ops[pass.opInds[0]].gate)) >> numBlockQubits;
+            for (int q=0; mask; q++, mask >>= 1)
+                if (mask & 1)
+                    highQubits[pass.numHighQubits++] = numBlockQubits + q;
+        }
+        compressed_applyToBlockGroups(qureg, highQubits, pass.numHighQubits, applyCompressedPass, &pass);
+    }
+
+    free(isLocalPass);
+    free(passStarts);
+    free(passOps);
+}
+
+void circuit_apply(Qureg qureg, Circuit circ) {
+
+    if (!circ.gateList->isCompiled)
+        circuit_compile(circ);
+
+    CircuitOp* ops = circ.gateList->ops;
+    int numOps = circ.gateList->numOps;
+    int shift = qureg.numQubitsRepresented;
+
+    if (qureg.isOutOfCore)
+        applyCircuitOutOfCore(qureg, circ);
+    else if (qureg.isCompressed)
+        applyCircuitCompressed(qureg, circ);
+    else if (qureg.isSubspace)
+        for (int o=0; o<numOps; o++)
+            applySubspaceCircuitOp(qureg, &ops[o], circ.params);
+    else
+        for (int o=0; o<numOps; o++) {
+            applyCircuitOp(qureg, &ops[o], circ.params, 0, 0, 0);
+            if (qureg.isDensityMatrix)
+                applyCircuitOp(qureg, &ops[o], circ.params, shift, 1, 0);
+        }
+
+    // the QASM log records the uncompiled gates
+    if (qureg.qasmLog->isLogging)
+        for (int g=0; g<circ.gateList->numGates; g++)
+            recordCircuitGate(qureg, &(circ.gateList->gates[g]), circ.params);
+}
+
+long long int circuit_calcIOBytes(Qureg qureg, Circuit circ, long long int* gateIOBytes) {
+
+    CircuitGate* gates = circ.gateList->gates;
+    int numGates = circ.gateList->numGates;
+    int size = (numGates > 0)? numGates : 1;
+
+    long long int* gateMasks = malloc(size * sizeof *gateMasks);
+    int* passInds = malloc(size * sizeof *passInds);
+    int* isLocalPass = malloc(size * sizeof *isLocalPass);
+    int* passSizes = calloc(size, sizeof *passSizes);
+    if (gateMasks == NULL || passInds == NULL || isLocalPass == NULL || passSizes == NULL)
+        circuitAllocError();
+
+    for (int g=0; g<numGates; g++)
+        gateMasks[g] = getGateQubitMask(&gates[g]);
+    long long int localMask = (1LL << getOutOfCoreBlockQubits(qureg)) - 1;
+    int numPasses = scheduleOutOfCorePasses(gateMasks, numGates, localMask, passInds, isLocalPass);
+
+    // every pass reads and writes the real and imaginary components of every local amplitude
+    long long int passBytes = 4 * qureg.numAmpsPerChunk * (long long int) sizeof(qreal);
+
+    for (int g=0; g<numGates; g++)
+        passSizes[passInds[g]]++;
+    if (gateIOBytes != NULL)
+        for (int g=0; g<numGates; g++)
+            gateIOBytes[g] = passBytes / passSizes[passInds[g]];
+
+    free(gateMasks);
+    free(passInds);
+    free(isLocalPass);
+    free(passSizes);
+    return numPasses * passBytes;
+}
+
+/** returns the derivative of <H> with respect to the angle of the given parameterised
+ * gate, where psi and lambda are as described at the top of this file.
+ * The state of workspace is overwritten.
+ */
+static qreal getCircuitGateGradient(Qureg psi, Qureg lambda, Qureg workspace, CircuitGate* gate) {
+
+    int ctrl = gate->qubits[0];
+    int targ = gate->qubits[1];
+
+    // workspace = G|psi>, where controlled gates are projected onto their control being |1>
+    statevec_cloneQureg(workspace, psi);
+
+    switch (gate->type) {
+        case CIRCUIT_CONTROLLED_ROTATE_X:
+        case CIRCUIT_CONTROLLED_ROTATE_Y:
+        case CIRCUIT_CONTROLLED_ROTATE_Z:
+        case CIRCUIT_CONTROLLED_PHASE_SHIFT:
+            statevec_collapseToKnownProbOutcome(workspace, ctrl, 1, 1);
+            break;
+        default:
+            targ = ctrl;
+            break;
+    }
+
+    switch (gate->type) {
+        case CIRCUIT_ROTATE_X:
+        case CIRCUIT_CONTROLLED_ROTATE_X:
+            statevec_pauliX(workspace, targ);
+            break;
+        case CIRCUIT_ROTATE_Y:
+        case CIRCUIT_CONTROLLED_ROTATE_Y:
+            statevec_pauliY(workspace, targ);
+            break;
+        case CIRCUIT_ROTATE_Z:
+        case CIRCUIT_CONTROLLED_ROTATE_Z:
+            statevec_pauliZ(workspace, targ);
+            break;
+        default:
+            // phase shifts: project onto the target being |1>
+            statevec_collapseToKnownProbOutcome(workspace, targ, 1, 1);
+            return - 2 * statevec_calcInnerProduct(lambda, workspace).imag;
+    }
+
+    return statevec_calcInnerProduct(lambda, workspace).imag;
+}
+
+qreal circuit_calcGradient(Qureg qureg, Circuit circ, enum pauliOpType* allPauliCodes, qreal* termCoeffs, int numSumTerms, qreal* gradient, Qureg workspace1, Qureg workspace2) {
+
+    if (!circ.gateList->isCompiled)
+        circuit_compile(circ);
+
+    CircuitOp* ops = circ.gateList->ops;
+    int numOps = circ.gateList->numOps;
+    Qureg lambda = workspace1;
+
+    // earliest operation which is parameterised, before which lambda needn't be uncomputed
+    int firstParamOp = numOps;
+    for (int o=numOps-1; o>=0; o--)
+        if (ops[o].gate.paramInd >= 0)
+            firstParamOp = o;
+
+    // |psi> = U|psi_0>
+    for (int o=0; o<numOps; o++)
+        applyCircuitOp(qureg, &ops[o], circ.params, 0, 0, 0);
+
+    // |lambda> = H|psi>
+    statevec_applyPauliSum(qureg, allPauliCodes, termCoeffs, numSumTerms, lambda);
+    qreal expecVal = statevec_calcInnerProduct(qureg, lambda).real;
+
+    for (int p=0; p<circ.numParams; p++)
+        gradient[p] = 0;
+
+    // uncompute psi and lambda, gathering the gradient contribution of every parameterised gate
+    for (int o=numOps-1; o>=0; o--) {
+        CircuitGate* gate = &(ops[o].gate);
+        if (gate->paramInd >= 0)
+            gradient[gate->paramInd] += getCircuitGateGradient(qureg, lambda, workspace2, gate);
+
+        applyCircuitOp(qureg, &ops[o], circ.params, 0, 0, 1);
+        if (o > firstParamOp)
+            applyCircuitOp(lambda, &ops[o], circ.params, 0, 0, 1);
+    }
+
+    return expecVal;
+}
@@ -0,0 +1,59 @@
+// Distributed under MIT licence. See https://github.com/QuEST-Kit/QuEST/blob/master/LICENCE.txt for details
+
+/** @file
+ * Functions for building, applying and differentiating Circuit instances
+ */
+
+# ifndef QUEST_CIRCUIT_H
+# define QUEST_CIRCUIT_H
+
+# include "QuEST.h"
+# include "QuEST_precision.h"
+
+# define CIRCUIT_FILE_MAX_ERR_LEN 200   // maximum length (#chars) of a circuit file error message
+
+# ifdef __cplusplus
+extern "C" {
+# endif
+
+int circuit_isValidGate(int gate);
+
+int circuit_getNumGateQubits(enum circuitGateType gate);
+
+int circuit_getNumGateParams(enum circuitGateType gate);
+
+int circuit_isParamGate(enum circuitGateType gate);
+
+Circuit circuit_create(int numQubits, int numParams);
+
+void circuit_destroy(Circuit circ);
+
+void circuit_addGate(Circuit circ, enum circuitGateType gate, int* qubits, qreal* params, int paramInd);
+
+void circuit_clear(Circuit circ);
+
+void circuit_setParams(Circuit circ, qreal* params);
+
+void circuit_compile(Circuit circ);
+
+ComplexMatrix4 circuit_getGateMatrix(Circuit circ, int gateInd);
+
+int circuit_isRealGate(Circuit circ, int gateInd);
+
+int circuit_isNumberConservingGate(Circuit circ, int gateInd);
+
+void circuit_apply(Qureg qureg, Circuit circ);
+
+long long int circuit_calcIOBytes(Qureg qureg, Circuit circ, long long int* gateIOBytes);
+
+qreal circuit_calcGradient(Qureg qureg, Circuit circ, enum pauliOpType* allPauliCodes, qreal* termCoeffs, int numSumTerms, qreal* gradient, Qureg workspace1, Qureg workspace2);
+
+int circuit_readFile(char* filename, int numQubits, Circuit* circ, char* errMsg);
+
+int circuit_writeFile(Circuit circ, char* filename);
+
+# ifdef __cplusplus
+}
+# endif
+
+# endif // QUEST_CIRCUIT_H
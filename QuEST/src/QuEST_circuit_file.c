@@ -0,0 +1,389 @@
+// Distributed under MIT licence. See https://github.com/QuEST-Kit/QuEST/blob/master/LICENCE.txt for details
+
+/** @file
+ * Reading and writing Circuit instances as files. The text format is a sequence of QuEST API calls
+ * upon a single (arbitrarily named) register, like
+ *
+ *      controlledRotateX(QReg, 8, 20, 0.7111750121892845);
+ *
+ * with C comments permitted between them, as the examples otherwise #include as source. The binary
+ * format is a header followed by one fixed-size record per gate, holding its type, qubits and
+ * (double precision, irrespective of QuEST_PREC) parameters in native byte order.
+ *
+ * Files are memory-mapped and scanned in place; gate names are matched against a small table, and
+ * only the characters of each real number are copied (to be converted by strtod).
+ */
+
+// exposes POSIX memory-mapping under strict C99
+# define _XOPEN_SOURCE 700
+
+# include "QuEST.h"
+# include "QuEST_precision.h"
+# include "QuEST_circuit.h"
+
+# include <stdio.h>
+# include <stdlib.h>
+# include <stdint.h>
+# include <stdarg.h>
+# include <string.h>
+
+# include <fcntl.h>
+# include <unistd.h>
+# include <sys/mman.h>
+# include <sys/stat.h>
+
+# define MAX_NUMBER_LEN 64          // maximum length (#chars) of a real number in a text file
+# define FILE_MAGIC "QuESTCIR"      // the first 8 bytes of a binary circuit file
+# define FILE_VERSION 1
+# define FILE_HEADER_SIZE 24        // magic, int32 version, int32 (reserved) zero, int64 numGates
+# define FILE_RECORD_SIZE 36        // int32 type, int32 qubits[2], double params[3]
+
+/** The API functions (of the text format) with a Circuit gate equivalent */
+typedef struct {
+    char* name;
+    int type;
+} FileGate;
+
+static const FileGate fileGates[] = {
+    {"hadamard",                CIRCUIT_HADAMARD},
+    {"pauliX",                  CIRCUIT_PAULI_X},
+    {"pauliY",                  CIRCUIT_PAULI_Y},
+    {"pauliZ",                  CIRCUIT_PAULI_Z},
+    {"sGate",                   CIRCUIT_S_GATE},
+    {"tGate",                   CIRCUIT_T_GATE},
+    {"SqX",                     CIRCUIT_SQRT_X},
+    {"SqY",                     CIRCUIT_SQRT_Y},
+    {"SqW",                     CIRCUIT_SQRT_W},
+    {"rotateX",                 CIRCUIT_ROTATE_X},
+    {"rotateY",                 CIRCUIT_ROTATE_Y},
+    {"rotateZ",                 CIRCUIT_ROTATE_Z},
+    {"phaseShift",              CIRCUIT_PHASE_SHIFT},
+    {"u1Gate",                  CIRCUIT_U1},
+    {"u2Gate",                  CIRCUIT_U2},
+    {"u3Gate",                  CIRCUIT_U3},
+    {"controlledNot",           CIRCUIT_CONTROLLED_NOT},
+    {"controlledPauliY",        CIRCUIT_CONTROLLED_PAULI_Y},
+    {"controlledPhaseFlip",     CIRCUIT_CONTROLLED_PHASE_FLIP},
+    {"controlledRotateX",       CIRCUIT_CONTROLLED_ROTATE_X},
+    {"controlledRotateY",       CIRCUIT_CONTROLLED_ROTATE_Y},
+    {"controlledRotateZ",       CIRCUIT_CONTROLLED_ROTATE_Z},
+    {"controlledPhaseShift",    CIRCUIT_CONTROLLED_PHASE_SHIFT},
+    {"swapGate",                CIRCUIT_SWAP},
+    {"fSim",                    CIRCUIT_FSIM}
+};
+
+/** The position of the scan through a mapped text file */
+typedef struct {
+    const char* pos;
+    const char* end;
+    int line;
+    int numQubits;      // of the circuit, which bounds every qubit index
+    char* errMsg;
+} Scanner;
+
+/** records an error (with the current line) and returns 0, so that callers can return it */
+static int setError(Scanner* s, char* format, ...) {
+    va_list argp;
+    va_start(argp, format);
+    int len = vsnprintf(s->errMsg, CIRCUIT_FILE_MAX_ERR_LEN, format, argp);
+    va_end(argp);
+    if (len < CIRCUIT_FILE_MAX_ERR_LEN)
+        snprintf(s->errMsg + len, CIRCUIT_FILE_MAX_ERR_LEN - len, " (line %d)", s->line);
+    return 0;
+}
+
+static int isDigit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+static int isIdChar(char c, int isFirst) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_' || (!isFirst && isDigit(c));
+}
+
+/** skips whitespace and comments, returning 0 if a block comment is unterminated */
+static int skipSpace(Scanner* s) {
+    while (s->pos < s->end) {
+        char c = *s->pos;
+        if (c == '\n') {
+            s->line++;
+            s->pos++;
+        }
+        else if (c == ' ' || c == '\t' || c == '\r')
+            s->pos++;
+        else if (c == '/' && s->pos+1 < s->end && s->pos[1] == '/') {
+            while (s->pos < s->end && *s->pos != '\n')
+                s->pos++;
+        }
+        else if (c == '/' && s->pos+1 < s->end && s->pos[1] == '*') {
+            s->pos += 2;
+            while (s->pos+1 < s->end && !(s->pos[0] == '*' && s->pos[1] == '/'))
+                if (*(s->pos++) == '\n')
+                    s->line++;
+            if (s->pos+1 >= s->end)
+                return setError(s, "Unterminated comment.");
+            s->pos += 2;
+        }
+        else
+            break;
+    }
+    return 1;
+}
+
+static int expectChar(Scanner* s, char c) {
+    if (!skipSpace(s))
+        return 0;
+    if (s->pos == s->end || *s->pos != c)
+        return setError(s, "Expected '%c'.", c);
+    s->pos++;
+    return 1;
+}
+
+/** scans an identifier, returning its length (or 0 if there is none) */
+static int scanId(Scanner* s, const char** id) {
+    if (!skipSpace(s))
+        return 0;
+    *id = s->pos;
+    if (s->pos == s->end || !isIdChar(*s->pos, 1))
+        return 0;
+    while (s->pos < s->end && isIdChar(*s->pos, 0))
+        s->pos++;
+    return (int) (s->pos - *id);
+}
+
+static int scanQubit(Scanner* s, int* qubit) {
+    if (!skipSpace(s))
+        return 0;
+    if (s->pos == s->end || !isDigit(*s->pos))
+        return setError(s, "Expected a qubit index.");
+
+    // digits beyond the circuit size are consumed without overflowing
+    long long int ind = 0;
+    while (s->pos < s->end && isDigit(*s->pos)) {
+        if (ind <= s->numQubits)
+            ind = 10*ind + (*s->pos - '0');
+        s->pos++;
+    }
+    if (ind >= s->numQubits)
+        return setError(s, "Qubit index exceeds that of the last of the %d qubits.", s->numQubits);
+    *qubit = (int) ind;
+    return 1;
+}
+
+static int scanReal(Scanner* s, qreal* num) {
+    if (!skipSpace(s))
+        return 0;
+
+    // find the extent of [+-]digits[.digits][(e|E)[+-]digits]
+    const char* start = s->pos;
+    const char* p = s->pos;
+    int numDigits = 0;
+    if (p < s->end && (*p == '+' || *p == '-'))
+        p++;
+    for (; p < s->end && isDigit(*p); p++)
+        numDigits++;
+    if (p < s->end && *p == '.')
+        for (p++; p < s->end && isDigit(*p); p++)
+            numDigits++;
+    if (numDigits > 0 && p < s->end && (*p == 'e' || *p == 'E')) {
+        const char* e = p+1;
+        if (e < s->end && (*e == '+' || *e == '-'))
+            e++;
+        if (e < s->end && isDigit(*e)) {
+            while (e < s->end && isDigit(*e))
+                e++;
+            p = e;
+        }
+    }
+    if (numDigits == 0)
+        return setError(s, "Expected a real number.");
+    if (p - start > MAX_NUMBER_LEN)
+        return setError(s, "Numbers may have at most %d characters.", MAX_NUMBER_LEN);
+
+    // the mapped file is not null-terminated, so the number is copied for strtod
+    char buf[MAX_NUMBER_LEN + 1];
+    memcpy(buf, start, p - start);
+    buf[p - start] = '\0';
+    *num = (qreal) strtod(buf, NULL);
+    s->pos = p;
+    return 1;
+}
+
+static int getFileGateType(const char* name, int len) {
+    int numGates = sizeof(fileGates) / sizeof(*fileGates);
+    for (int g=0; g<numGates; g++)
+        if (strncmp(fileGates[g].name, name, len) == 0 && fileGates[g].name[len] == '\0')
+            return fileGates[g].type;
+    return -1;
+}
+
+/** scans one call 'gate(reg, qubits..., params...);' into circ */
+static int scanGate(Scanner* s, Circuit circ) {
+
+    const char* name;
+    int len = scanId(s, &name);
+    if (len == 0)
+        return setError(s, "Expected a gate name.");
+    int gate = getFileGateType(name, len);
+    if (gate < 0)
+        return setError(s, "Unknown gate '%.*s'.", len, name);
+
+    // the register argument is not otherwise interpreted
+    const char* reg;
+    if (!expectChar(s, '('))
+        return 0;
+    if (scanId(s, &reg) == 0)
+        return setError(s, "Expected a register name.");
+
+    int numQubits = circuit_getNumGateQubits(gate);
+    int numParams = circuit_getNumGateParams(gate);
+    int qubits[2];
+    qreal params[3];
+    for (int q=0; q<numQubits; q++)
+        if (!expectChar(s, ',') || !scanQubit(s, &qubits[q]))
+            return 0;
+    for (int p=0; p<numParams; p++)
+        if (!expectChar(s, ',') || !scanReal(s, &params[p]))
+            return 0;
+    if (!expectChar(s, ')') || !expectChar(s, ';'))
+        return 0;
+
+    if (numQubits == 2 && qubits[0] == qubits[1])
+        return setError(s, "The qubits of gate '%.*s' must be unique.", len, name);
+
+    circuit_addGate(circ, gate, qubits, params, -1);
+    return 1;
+}
+
+static int readTextFile(const char* data, size_t size, Circuit circ, char* errMsg) {
+
+    Scanner s = {.pos=data, .end=data+size, .line=1, .numQubits=circ.numQubits, .errMsg=errMsg};
+    while (1) {
+        if (!skipSpace(&s))
+            return 0;
+        if (s.pos == s.end)
+            return 1;
+        if (!scanGate(&s, circ))
+            return 0;
+    }
+}
+
+/** reads the gates of a binary file, whose header (at least) the caller has checked is present */
+static int readBinaryFile(const char* data, size_t size, Circuit circ, char* errMsg) {
+
+    int32_t version;
+    int64_t numGates;
+    memcpy(&version, data + 8, sizeof version);
+    memcpy(&numGates, data + 16, sizeof numGates);
+
+    if (version != FILE_VERSION || numGates < 0 ||
+        (uint64_t) numGates != (size - FILE_HEADER_SIZE) / FILE_RECORD_SIZE ||
+        (size - FILE_HEADER_SIZE) % FILE_RECORD_SIZE != 0) {
+        snprintf(errMsg, CIRCUIT_FILE_MAX_ERR_LEN,
+            "The binary circuit file is truncated or of an unsupported version.");
+        return 0;
+    }
+
+    const char* rec = data + FILE_HEADER_SIZE;
+    for (int64_t g=0; g<numGates; g++, rec += FILE_RECORD_SIZE) {
+        int32_t type;
+        int32_t qubits[2];
+        double params[3];
+        memcpy(&type, rec, sizeof type);
+        memcpy(qubits, rec + 4, sizeof qubits);
+        memcpy(params, rec + 12, sizeof params);
+
+        int isValid = circuit_isValidGate(type);
+        int numQubits = isValid? circuit_getNumGateQubits(type) : 0;
+        for (int q=0; q<numQubits; q++)
+            isValid = isValid && qubits[q] >= 0 && qubits[q] < circ.numQubits;
+        if (isValid && numQubits == 2)
+            isValid = qubits[0] != qubits[1];
+        if (!isValid) {
+            snprintf(errMsg, CIRCUIT_FILE_MAX_ERR_LEN,
+                "Gate %lld has an invalid type or qubits for a circuit of %d qubits.",
+                (long long int) g, circ.numQubits);
+            return 0;
+        }
+
+        int gateQubits[2] = {qubits[0], qubits[1]};
+        qreal gateParams[3] = {(qreal) params[0], (qreal) params[1], (qreal) params[2]};
+        circuit_addGate(circ, type, gateQubits, gateParams, -1);
+    }
+    return 1;
+}
+
+int circuit_readFile(char* filename, int numQubits, Circuit* circ, char* errMsg) {
+
+    int fd = open(filename, O_RDONLY);
+    struct stat info;
+    if (fd < 0 || fstat(fd, &info) != 0) {
+        if (fd >= 0)
+            close(fd);
+        snprintf(errMsg, CIRCUIT_FILE_MAX_ERR_LEN, "Could not open file '%s'.", filename);
+        return 0;
+    }
+
+    // an empty file (which cannot be mapped) is an empty circuit
+    size_t size = (size_t) info.st_size;
+    void* data = NULL;
+    if (size > 0) {
+        data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED) {
+            close(fd);
+            snprintf(errMsg, CIRCUIT_FILE_MAX_ERR_LEN, "Could not map file '%s'.", filename);
+            return 0;
+        }
+        posix_madvise(data, size, POSIX_MADV_SEQUENTIAL);
+    }
+    close(fd);
+
+    Circuit newCirc = circuit_create(numQubits, 0);
+    int isBinary = size >= FILE_HEADER_SIZE && memcmp(data, FILE_MAGIC, 8) == 0;
+    int isRead = isBinary?
+        readBinaryFile(data, size, newCirc, errMsg) :
+        readTextFile(data, size, newCirc, errMsg);
+
+    if (size > 0)
+        munmap(data, size);
+    if (isRead)
+        *circ = newCirc;
+    else
+        circuit_destroy(newCirc);
+    return isRead;
+}
+
+int circuit_writeFile(Circuit circ, char* filename) {
+
+    FILE* file = fopen(filename, "wb");
+    if (file == NULL)
+        return 0;
+
+    char header[FILE_HEADER_SIZE] = {0};
+    int32_t version = FILE_VERSION;
+    int64_t numGates = circ.gateList->numGates;
+    memcpy(header, FILE_MAGIC, 8);
+    memcpy(header + 8, &version, sizeof version);
+    memcpy(header + 16, &numGates, sizeof numGates);
+    int success = fwrite(header, FILE_HEADER_SIZE, 1, file) == 1;
+
+    for (int g=0; success && g<circ.gateList->numGates; g++) {
+        CircuitGate* gate = &(circ.gateList->gates[g]);
+
+        // gates bound to a parameter are written with its current value
+        double params[3];
+        for (int p=0; p<3; p++)
+            params[p] = (double) gate->params[p];
+        if (gate->paramInd >= 0)
+            params[0] = (double) circ.params[gate->paramInd];
+
+        char rec[FILE_RECORD_SIZE];
+        int32_t type = gate->type;
+        int32_t qubits[2] = {gate->qubits[0], gate->qubits[1]};
+        memcpy(rec, &type, sizeof type);
+        memcpy(rec + 4, qubits, sizeof qubits);
+        memcpy(rec + 12, params, sizeof params);
+        success = fwrite(rec, FILE_RECORD_SIZE, 1, file) == 1;
+    }
+
+    return (fclose(file) == 0) && success;
+}
@@ -33,6 +33,11 @@
 # include <sys/types.h> 
 # include <stdio.h>
 # include <stdlib.h>
+# include <string.h>
+
+# ifdef _OPENMP
+# include <omp.h>
+# endif
 
 
 #ifdef __cplusplus
@@ -109,6 +114,31 @@ void setConjugateMatrixN(ComplexMatrixN m) {
     int len = 1 << m.numQubits;
     macro_setConjugateMatrix(m, m, len);
 }
+void setMatrixNFromRowMajor(ComplexMatrixN m, qreal* re, qreal* im) {
+    int len = 1 << m.numQubits;
+    for (int i=0; i<len; i++)
+        for (int j=0; j<len; j++) {
+            m.real[i][j] = re[i*len + j];
+            m.imag[i][j] = im[i*len + j];
+        }
+}
+
+#define macro_setConjugateTransposeMatrix(dest, src, dim) \
+    for (int i=0; i<dim; i++) \
+        for (int j=0; j<dim; j++) { \
+            dest.real[i][j] =   src.real[j][i]; \
+            dest.imag[i][j] = - src.imag[j][i]; \
+        } 
+ComplexMatrix2 getConjugateTransposeMatrix2(ComplexMatrix2 src) {
+    ComplexMatrix2 dagg;
+    macro_setConjugateTransposeMatrix(dagg, src, 2);
+    return dagg;
+}
+ComplexMatrix4 getConjugateTransposeMatrix4(ComplexMatrix4 src) {
+    ComplexMatrix4 dagg;
+    macro_setConjugateTransposeMatrix(dagg, src, 4);
+    return dagg;
+}
 
 void getComplexPairFromRotation(qreal angle, Vector axis, Complex* alpha, Complex* beta) {
     
@@ -213,6 +243,8 @@ void seedQuEST(unsigned long int *seedArray, int numSeeds){
 }
 
 void reportState(Qureg qureg){
+    validateNotSubspace(qureg, __func__);
+    validateNotCompressed(qureg, __func__);
     FILE *state;
     char filename[100];
     long long int index;
@@ -222,14 +254,28 @@ void reportState(Qureg qureg){
 
     for(index=0; index<qureg.numAmpsPerChunk; index++){
         # if QuEST_PREC==1 || QuEST_PREC==2
-        fprintf(state, "%.12f, %.12f\n", qureg.stateVec.real[index], qureg.stateVec.imag[index]);
+        fprintf(state, "%.12f, %.12f\n", qureg.stateVec.real[index], (qureg.isReal)? 0 : qureg.stateVec.imag[index]);
         # elif QuEST_PREC == 4
-        fprintf(state, "%.12Lf, %.12Lf\n", qureg.stateVec.real[index], qureg.stateVec.imag[index]);
+        fprintf(state, "%.12Lf, %.12Lf\n", qureg.stateVec.real[index], (qureg.isReal)? 0 : qureg.stateVec.imag[index]);
         #endif
     }
     fclose(state);
 }
 
+void statevec_initCheckpointHeader(Qureg qureg, CheckpointHeader* header) {
+    memset(header, 0, sizeof *header);
+    memcpy(header->magic, CHECKPOINT_MAGIC, sizeof header->magic);
+    header->version = CHECKPOINT_VERSION;
+    header->numBytesPerReal = sizeof(qreal);
+    header->numQubits = qureg.numQubitsRepresented;
+    header->isDensityMatrix = qureg.isDensityMatrix;
+    header->isPacked = qureg.isPacked;
+    header->isReal = qureg.isReal;
+    header->isSubspace = qureg.isSubspace;
+    header->hammingWeight = qureg.hammingWeight;
+    header->numAmps = qureg.numAmpsPerChunk * qureg.numChunks;
+}
+
 void reportQuregParams(Qureg qureg){
     long long int numAmps = 1LL << qureg.numQubitsInStateVec;
     long long int numAmpsPerRank = numAmps/qureg.numChunks;
@@ -241,6 +287,14 @@ void reportQuregParams(Qureg qureg){
     }
 }
 
+void statevec_initZeroStateOfNewQureg(Qureg qureg) {
+    
+    // the sparse file of a new out-of-core register reads as zero, so only |0> is set, rather than 
+    // writing every page out to disk
+    qreal re = 1, im = 0;
+    statevec_setAmps(qureg, 0, &re, &im, 1);
+}
+
 qreal statevec_getProbAmp(Qureg qureg, long long int index){
     qreal real = statevec_getRealAmp(qureg, index);
     qreal imag = statevec_getImagAmp(qureg, index);
@@ -363,12 +417,166 @@ void statevec_controlledRotateZ(Qureg qureg, const int controlQubit, const int t
     statevec_controlledRotateAroundAxis(qureg, controlQubit, targetQubit, angle, unitAxis);
 }
 
-int statevec_measureWithStats(Qureg qureg, int measureQubit, qreal *outcomeProb) {
+ComplexMatrix2 getCompactUnitaryMatrix(Complex alpha, Complex beta) {
+    ComplexMatrix2 u = {
+        .real = {{alpha.real, -beta.real}, {beta.real,  alpha.real}},
+        .imag = {{alpha.imag,  beta.imag}, {beta.imag, -alpha.imag}}};
+    return u;
+}
+
+/* The density matrix gates below effect rho -> U rho U^dagger in a single pass
+ * (where the backend permits), rather than applying U and conj(U) separately 
+ */
+
+void densmatr_unitary(Qureg qureg, const int targetQubit, ComplexMatrix2 u) {
     
-    qreal zeroProb = statevec_calcProbOfOutcome(qureg, measureQubit, 0);
-    int outcome = generateMeasurementOutcome(zeroProb, outcomeProb);
-    statevec_collapseToKnownProbOutcome(qureg, measureQubit, outcome, *outcomeProb);
-    return outcome;
+    densmatr_multiControlledUnitary(qureg, 0, 0, targetQubit, u);
+}
+
+void densmatr_controlledUnitary(Qureg qureg, const int controlQubit, const int targetQubit, ComplexMatrix2 u) {
+    
+    densmatr_multiControlledUnitary(qureg, 1LL << controlQubit, 0, targetQubit, u);
+}
+
+void densmatr_compactUnitary(Qureg qureg, const int targetQubit, Complex alpha, Complex beta) {
+    
+    densmatr_unitary(qureg, targetQubit, getCompactUnitaryMatrix(alpha, beta));
+}
+
+void densmatr_controlledCompactUnitary(Qureg qureg, const int controlQubit, const int targetQubit, Complex alpha, Complex beta) {
+    
+    densmatr_controlledUnitary(qureg, controlQubit, targetQubit, getCompactUnitaryMatrix(alpha, beta));
+}
+
+void densmatr_rotateAroundAxis(Qureg qureg, const int rotQubit, qreal angle, Vector axis) {
+    
+    Complex alpha, beta;
+    getComplexPairFromRotation(angle, axis, &alpha, &beta);
+    densmatr_compactUnitary(qureg, rotQubit, alpha, beta);
+}
+
+void densmatr_controlledRotateAroundAxis(Qureg qureg, const int controlQubit, const int targetQubit, qreal angle, Vector axis) {
+    
+    Complex alpha, beta;
+    getComplexPairFromRotation(angle, axis, &alpha, &beta);
+    densmatr_controlledCompactUnitary(qureg, controlQubit, targetQubit, alpha, beta);
+}
+
+void densmatr_rotateX(Qureg qureg, const int rotQubit, qreal angle) {
+    
+    Vector unitAxis = {1, 0, 0};
+    densmatr_rotateAroundAxis(qureg, rotQubit, angle, unitAxis);
+}
+
+void densmatr_rotateY(Qureg qureg, const int rotQubit, qreal angle) {
+    
+    Vector unitAxis = {0, 1, 0};
+    densmatr_rotateAroundAxis(qureg, rotQubit, angle, unitAxis);
+}
+
+void densmatr_rotateZ(Qureg qureg, const int rotQubit, qreal angle) {
+    
+    Vector unitAxis = {0, 0, 1};
+    densmatr_rotateAroundAxis(qureg, rotQubit, angle, unitAxis);
+}
+
+void densmatr_controlledRotateX(Qureg qureg, const int controlQubit, const int targetQubit, qreal angle) {
+    
+    Vector unitAxis = {1, 0, 0};
+    densmatr_controlledRotateAroundAxis(qureg, controlQubit, targetQubit, angle, unitAxis);
+}
+
+void densmatr_controlledRotateY(Qureg qureg, const int controlQubit, const int targetQubit, qreal angle) {
+    
+    Vector unitAxis = {0, 1, 0};
+    densmatr_controlledRotateAroundAxis(qureg, controlQubit, targetQubit, angle, unitAxis);
+}
+
+void densmatr_controlledRotateZ(Qureg qureg, const int controlQubit, const int targetQubit, qreal angle) {
+    
+    Vector unitAxis = {0, 0, 1};
+    densmatr_controlledRotateAroundAxis(qureg, controlQubit, targetQubit, angle, unitAxis);
+}
+
+void densmatr_hadamard(Qureg qureg, const int targetQubit) {
+    
+    qreal fac = 1/sqrt(2);
+    ComplexMatrix2 u = {.real = {{fac, fac}, {fac, -fac}}, .imag = {{0}}};
+    densmatr_unitary(qureg, targetQubit, u);
+}
+
+void densmatr_pauliX(Qureg qureg, const int targetQubit) {
+    
+    ComplexMatrix2 u = {.real = {{0, 1}, {1, 0}}, .imag = {{0}}};
+    densmatr_unitary(qureg, targetQubit, u);
+}
+
+void densmatr_pauliY(Qureg qureg, const int targetQubit) {
+    
+    ComplexMatrix2 u = {.real = {{0}}, .imag = {{0, -1}, {1, 0}}};
+    densmatr_unitary(qureg, targetQubit, u);
+}
+
+void densmatr_controlledNot(Qureg qureg, const int controlQubit, const int targetQubit) {
+    
+    ComplexMatrix2 u = {.real = {{0, 1}, {1, 0}}, .imag = {{0}}};
+    densmatr_controlledUnitary(qureg, controlQubit, targetQubit, u);
+}
+
+void densmatr_controlledPauliY(Qureg qureg, const int controlQubit, const int targetQubit) {
+    
+    ComplexMatrix2 u = {.real = {{0}}, .imag = {{0, -1}, {1, 0}}};
+    densmatr_controlledUnitary(qureg, controlQubit, targetQubit, u);
+}
+
+void densmatr_twoQubitUnitary(Qureg qureg, const int targetQubit1, const int targetQubit2, ComplexMatrix4 u) {
+    
+    densmatr_multiControlledTwoQubitUnitary(qureg, 0, targetQubit1, targetQubit2, u);
+}
+
+void densmatr_controlledTwoQubitUnitary(Qureg qureg, const int controlQubit, const int targetQubit1, const int targetQubit2, ComplexMatrix4 u) {
+    
+    densmatr_multiControlledTwoQubitUnitary(qureg, 1LL << controlQubit, targetQubit1, targetQubit2, u);
+}
+
+void densmatr_swapGate(Qureg qureg, int qb1, int qb2) {
+    
+    ComplexMatrix4 u = (ComplexMatrix4) {.real={{0}}, .imag={{0}}};
+    u.real[0][0]=1;
+    u.real[1][2]=1;
+    u.real[2][1]=1;
+    u.real[3][3]=1;
+    
+    densmatr_twoQubitUnitary(qureg, qb1, qb2, u);
+}
+
+void densmatr_sqrtSwapGate(Qureg qureg, int qb1, int qb2) {
+    
+    ComplexMatrix4 u = (ComplexMatrix4) {.real={{0}}, .imag={{0}}};
+    u.real[0][0]=1;
+    u.real[3][3]=1;
+    u.real[1][1] = .5; u.imag[1][1] = .5;
+    u.real[1][2] = .5; u.imag[1][2] =-.5;
+    u.real[2][1] = .5; u.imag[2][1] =-.5;
+    u.real[2][2] = .5; u.imag[2][2] = .5;
+    
+    densmatr_twoQubitUnitary(qureg, qb1, qb2, u);
+}
+
+Complex packmatr_getDensityAmp(Qureg qureg, long long int row, long long int col) {
+    
+    // only the upper triangle is stored, column after column
+    Complex amp;
+    if (row <= col) {
+        long long int ind = (col*(col+1))/2 + row;
+        amp.real = statevec_getRealAmp(qureg, ind);
+        amp.imag = statevec_getImagAmp(qureg, ind);
+    } else {
+        long long int ind = (row*(row+1))/2 + col;
+        amp.real =   statevec_getRealAmp(qureg, ind);
+        amp.imag = - statevec_getImagAmp(qureg, ind);
+    }
+    return amp;
 }
 
 int densmatr_measureWithStats(Qureg qureg, int measureQubit, qreal *outcomeProb) {
@@ -379,6 +587,197 @@ int densmatr_measureWithStats(Qureg qureg, int measureQubit, qreal *outcomeProb)
     return outcome;
 }
 
+/** Allocates the 2^numQubits outcome probabilities binned by e.g. statevec_calcProbOfAllOutcomes, 
+ * reporting a failure as an error of caller */
+qreal* allocOutcomeProbs(int numQubits, const char* caller) {
+    
+    qreal* outcomeProbs = malloc((1LL << numQubits) * sizeof *outcomeProbs);
+    validateOutcomeProbsAllocated(outcomeProbs, caller);
+    return outcomeProbs;
+}
+
+/** the fewest probabilities per thread for which calcCumulativeProbs is multithreaded */
+#define MIN_NUM_PROBS_PER_THREAD 4096
+
+/** Overwrites probs with its cumulative sum. When multithreaded, each thread sums a 
+ * contiguous block of probs, then offsets its block by the totals of the preceding blocks.
+ */
+void calcCumulativeProbs(qreal* probs, long long int numProbs) {
+    
+    int numThreads = 1;
+# ifdef _OPENMP
+    numThreads = omp_get_max_threads();
+# endif
+
+    // a small distribution is cheaper to sum serially than to divide between threads
+    if (numThreads == 1 || numProbs < MIN_NUM_PROBS_PER_THREAD * numThreads) {
+        for (long long int i=1; i < numProbs; i++)
+            probs[i] += probs[i-1];
+        return;
+    }
+    
+    qreal blockSums[numThreads];
+
+# ifdef _OPENMP
+# pragma omp parallel \
+    shared    (probs, numProbs, blockSums)
+# endif
+    {
+        int thread = 0;
+        int numBlocks = 1;
+# ifdef _OPENMP
+        thread = omp_get_thread_num();
+        numBlocks = omp_get_num_threads();
+# endif
+        long long int start = (numProbs * thread) / numBlocks;
+        long long int end = (numProbs * (thread+1)) / numBlocks;
+        long long int i;
+        
+        for (i=start+1; i < end; i++)
+            probs[i] += probs[i-1];
+        blockSums[thread] = (end > start)? probs[end-1] : 0;
+        
+# ifdef _OPENMP
+# pragma omp barrier
+# endif
+        qreal offset = 0;
+        for (int b=0; b < thread; b++)
+            offset += blockSums[b];
+        for (i=start; i < end; i++)
+            probs[i] += offset;
+    }
+}
+
+/** Returns the first index of cumulProbs (a cumulative distribution of length numProbs) 
+ * whose cumulative probability exceeds cumulProb, by binary search */
+long long int findCumulativeProbIndex(qreal* cumulProbs, long long int numProbs, qreal cumulProb) {
+    
+    long long int lo = 0;
+    long long int hi = numProbs - 1;
+    while (lo < hi) {
+        long long int mid = lo + (hi - lo)/2;
+        if (cumulProbs[mid] > cumulProb)
+            hi = mid;
+        else
+            lo = mid + 1;
+    }
+    return lo;
+}
+
+/** Draws numShots outcomes from the distribution outcomeProbs, which is overwritten
+ * with its cumulative sum. Each shot costs one uniform number and a binary search of
+ * the cumulative distribution, so the state itself is never revisited. Since every
+ * rank shares the same seed and cumulative distribution, all ranks draw the same shots.
+ */
+void sampleFromOutcomeProbs(qreal* outcomeProbs, long long int numOutcomes, int numShots, long long int* outcomes) {
+    
+    calcCumulativeProbs(outcomeProbs, numOutcomes);
+    
+    // scale draws by the total, absorbing any normalisation error of the state
+    qreal totalProb = outcomeProbs[numOutcomes-1];
+    
+    for (int s=0; s < numShots; s++)
+        outcomes[s] = findCumulativeProbIndex(outcomeProbs, numOutcomes, genrand_real2() * totalProb);
+}
+
+/** Draws a single outcome from outcomeProbs (overwriting it), and sets outcomeProb 
+ * to its normalised probability */
+long long int sampleOneFromOutcomeProbs(qreal* outcomeProbs, long long int numOutcomes, qreal* outcomeProb) {
+    
+    long long int outcome;
+    sampleFromOutcomeProbs(outcomeProbs, numOutcomes, 1, &outcome);
+    
+    // recover the outcome probability from the cumulative distribution
+    qreal prevProb = (outcome > 0)? outcomeProbs[outcome-1] : 0;
+    *outcomeProb = (outcomeProbs[outcome] - prevProb) / outcomeProbs[numOutcomes-1];
+    return outcome;
+}
+
+void densmatr_sampleOutcomes(Qureg qureg, int* qubits, int numQubits, int numShots, long long int* outcomes) {
+    
+    long long int numOutcomes = 1LL << numQubits;
+    qreal* outcomeProbs = allocOutcomeProbs(numQubits, __func__);
+    
+    densmatr_calcProbOfAllOutcomes(outcomeProbs, qureg, qubits, numQubits);
+    sampleFromOutcomeProbs(outcomeProbs, numOutcomes, numShots, outcomes);
+    
+    free(outcomeProbs);
+}
+
+long long int statevec_measureAllWithStats(Qureg qureg, qreal *outcomeProb) {
+    
+    long long int stateInd = statevec_sampleBasisState(qureg, genrand_real2(), outcomeProb);
+    statevec_collapseToBasisState(qureg, stateInd);
+    return stateInd;
+}
+
+long long int densmatr_measureAllWithStats(Qureg qureg, qreal *outcomeProb) {
+    
+    // the diagonal is quadratically smaller than the density matrix, so is binned in full
+    int numQubits = qureg.numQubitsRepresented;
+    long long int numOutcomes = 1LL << numQubits;
+    qreal* outcomeProbs = allocOutcomeProbs(numQubits, __func__);
+    int* qubits = malloc(numQubits * sizeof *qubits);
+    for (int q=0; q < numQubits; q++)
+        qubits[q] = q;
+    
+    densmatr_calcProbOfAllOutcomes(outcomeProbs, qureg, qubits, numQubits);
+    long long int stateInd = sampleOneFromOutcomeProbs(outcomeProbs, numOutcomes, outcomeProb);
+    
+    free(outcomeProbs);
+    free(qubits);
+    
+    densmatr_initClassicalState(qureg, stateInd);
+    return stateInd;
+}
+
+/** Gives the index of outcomes within the 2^numQubits outcomes of qubits, 
+ * matching the ordering of statevec_calcProbOfAllOutcomes */
+long long int getOutcomeIndex(int* outcomes, int numQubits) {
+    
+    long long int outcomeInd = 0;
+    for (int q=0; q < numQubits; q++)
+        outcomeInd += (long long int) outcomes[q] << q;
+    return outcomeInd;
+}
+
+void setOutcomesFromIndex(int* outcomes, int numQubits, long long int outcomeInd) {
+    
+    for (int q=0; q < numQubits; q++)
+        outcomes[q] = (outcomeInd >> q) & 1;
+}
+
+qreal statevec_measureQubits(Qureg qureg, int* qubits, int numQubits, int* outcomes) {
+    
+    // one pass finds the joint distribution, and one pass collapses, however many qubits
+    long long int numOutcomes = 1LL << numQubits;
+    qreal* outcomeProbs = allocOutcomeProbs(numQubits, __func__);
+    
+    qreal outcomeProb;
+    statevec_calcProbOfAllOutcomes(outcomeProbs, qureg, qubits, numQubits);
+    long long int outcomeInd = sampleOneFromOutcomeProbs(outcomeProbs, numOutcomes, &outcomeProb);
+    free(outcomeProbs);
+    
+    setOutcomesFromIndex(outcomes, numQubits, outcomeInd);
+    statevec_collapseToOutcomes(qureg, qubits, outcomes, numQubits, outcomeProb);
+    return outcomeProb;
+}
+
+qreal densmatr_measureQubits(Qureg qureg, int* qubits, int numQubits, int* outcomes) {
+    
+    long long int numOutcomes = 1LL << numQubits;
+    qreal* outcomeProbs = allocOutcomeProbs(numQubits, __func__);
+    
+    qreal outcomeProb;
+    densmatr_calcProbOfAllOutcomes(outcomeProbs, qureg, qubits, numQubits);
+    long long int outcomeInd = sampleOneFromOutcomeProbs(outcomeProbs, numOutcomes, &outcomeProb);
+    free(outcomeProbs);
+    
+    setOutcomesFromIndex(outcomes, numQubits, outcomeInd);
+    densmatr_collapseToOutcomes(qureg, qubits, outcomes, numQubits, outcomeProb);
+    return outcomeProb;
+}
+
 qreal statevec_calcFidelity(Qureg qureg, Qureg pureState) {
     
     Complex innerProd = statevec_calcInnerProduct(qureg, pureState);
@@ -482,6 +881,41 @@ qreal statevec_calcExpecPauliProd(Qureg qureg, int* targetQubits, enum pauliOpTy
     return value;
 }
 
+/** Expresses a Pauli product as a single-term sum, by padding its codes with identities */
+static void setPaddedPauliCodes(int numQb, int* targetQubits, enum pauliOpType* pauliCodes, int numTargets, enum pauliOpType* allCodes) {
+    for (int q=0; q < numQb; q++)
+        allCodes[q] = PAULI_I;
+    for (int i=0; i < numTargets; i++)
+        allCodes[targetQubits[i]] = pauliCodes[i];
+}
+
+qreal densmatr_calcExpecPauliProd(Qureg qureg, int* targetQubits, enum pauliOpType* pauliCodes, int numTargets) {
+    
+    enum pauliOpType allCodes[qureg.numQubitsRepresented];
+    setPaddedPauliCodes(qureg.numQubitsRepresented, targetQubits, pauliCodes, numTargets, allCodes);
+    
+    qreal coeff = 1;
+    return densmatr_calcExpecPauliSum(qureg, allCodes, &coeff, 1);
+}
+
+qreal realvec_calcExpecPauliProd(Qureg qureg, int* targetQubits, enum pauliOpType* pauliCodes, int numTargets) {
+    
+    enum pauliOpType allCodes[qureg.numQubitsRepresented];
+    setPaddedPauliCodes(qureg.numQubitsRepresented, targetQubits, pauliCodes, numTargets, allCodes);
+    
+    qreal coeff = 1;
+    return realvec_calcExpecPauliSum(qureg, allCodes, &coeff, 1);
+}
+
+qreal subspace_calcExpecPauliProd(Qureg qureg, int* targetQubits, enum pauliOpType* pauliCodes, int numTargets) {
+    
+    enum pauliOpType allCodes[qureg.numQubitsRepresented];
+    setPaddedPauliCodes(qureg.numQubitsRepresented, targetQubits, pauliCodes, numTargets, allCodes);
+    
+    qreal coeff = 1;
+    return subspace_calcExpecPauliSum(qureg, allCodes, &coeff, 1);
+}
+
 qreal statevec_calcExpecPauliSum(Qureg qureg, enum pauliOpType* allCodes, qreal* termCoeffs, int numSumTerms, Qureg workspace) {
     
     int numQb = qureg.numQubitsRepresented;
@@ -637,15 +1071,48 @@ ComplexMatrixN bindArraysToStackComplexMatrixN(
     qreal imArr_[1<<(numQubits)][1<<(numQubits)]; \
     macro_initialiseStackComplexMatrixN(matrix, (numQubits), reArr_, imArr_);
 
+/** Whether sum_n K_n rho K_n^dagger should be applied directly, rather than as a 2k-qubit
+ * superoperator. Upon each block of 4^k elements, the superoperator costs 16^k flops independent 
+ * of numOps, while the direct sum costs 2 numOps 8^k (but runs about twice as fast per flop, 
+ * avoiding the dense 2k-qubit kernel's index arithmetic), so it is faster when numOps < 2^k. 
+ * It also avoids the superoperator's 16^k memory, but needs every target's column bit to lie 
+ * within the chunk, so that each block is local.
+ */
+static int isKrausMapCheaperDirect(Qureg qureg, int* targets, int numTargets, int numOps) {
+    
+    int maxTarget = 0;
+    for (int t=0; t < numTargets; t++)
+        if (targets[t] > maxTarget)
+            maxTarget = targets[t];
+    
+    int isCheaper = numOps < (1 << numTargets);
+    int isLocal = (1LL << (maxTarget + qureg.numQubitsRepresented)) < qureg.numAmpsPerChunk;
+    return isCheaper && isLocal;
+}
+
 void densmatr_mixTwoQubitKrausMap(Qureg qureg, int target1, int target2, ComplexMatrix4 *ops, int numOps) {
     
+    int targets[2] = {target1, target2};
+    if (isKrausMapCheaperDirect(qureg, targets, 2, numOps)) {
+        
+        // view each op as a ComplexMatrixN, without copying
+        qreal* reStorage[numOps][4];
+        qreal* imStorage[numOps][4];
+        ComplexMatrixN opsN[numOps];
+        for (int n=0; n < numOps; n++)
+            opsN[n] = bindArraysToStackComplexMatrixN(2, ops[n].real, ops[n].imag, reStorage[n], imStorage[n]);
+        
+        densmatr_applyMultiQubitKrausMap(qureg, targets, 2, opsN, numOps);
+        return;
+    }
+    
     ComplexMatrixN superOp;
     macro_allocStackComplexMatrixN(superOp, 4);
     populateKrausSuperOperator4(&superOp, ops, numOps);
     densmatr_applyTwoQubitKrausSuperoperator(qureg, target1, target2, superOp);
 }
 
-void densmatr_mixMultiQubitKrausMap(Qureg qureg, int* targets, int numTargets, ComplexMatrixN* ops, int numOps) {
+void densmatr_mixMultiQubitKrausMapViaSuperoperator(Qureg qureg, int* targets, int numTargets, ComplexMatrixN* ops, int numOps) {
 
     ComplexMatrixN superOp;
     
@@ -678,6 +1145,14 @@ void densmatr_mixMultiQubitKrausMap(Qureg qureg, int* targets, int numTargets, C
     }
 }
 
+void densmatr_mixMultiQubitKrausMap(Qureg qureg, int* targets, int numTargets, ComplexMatrixN* ops, int numOps) {
+    
+    if (isKrausMapCheaperDirect(qureg, targets, numTargets, numOps))
+        densmatr_applyMultiQubitKrausMap(qureg, targets, numTargets, ops, numOps);
+    else
+        densmatr_mixMultiQubitKrausMapViaSuperoperator(qureg, targets, numTargets, ops, numOps);
+}
+
 void densmatr_mixPauli(Qureg qureg, int qubit, qreal probX, qreal probY, qreal probZ) {
     
     // convert pauli probabilities into Kraus map
@@ -700,6 +1175,185 @@ void densmatr_mixPauli(Qureg qureg, int qubit, qreal probX, qreal probY, qreal p
     densmatr_mixKrausMap(qureg, qubit, ops, numOps);
 }
 
+/*
+ * quantum trajectories
+ *
+ * Upon a state-vector, each channel is unravelled by sampling one of its Kraus operators
+ * K_i with probability |K_i psi|^2, and replacing psi with K_i psi / |K_i psi|. Averaging
+ * an observable over many trajectories recovers its expectation under the density-matrix
+ * channel. Every rank shares the RNG seed, so all ranks sample the same operator.
+ */
+
+/** Samples a Pauli product upon targetQubits and applies it. termProbs[k] (which is 
+ * overwritten) is the probability of the product whose code upon targetQubits[q] is 
+ * the q-th base-4 digit of k */
+static void sampleAndApplyPauliProd(Qureg qureg, int* targetQubits, int numTargets, qreal* termProbs) {
+    
+    long long int numTerms = 1LL << (2*numTargets);
+    qreal termProb;
+    long long int term = sampleOneFromOutcomeProbs(termProbs, numTerms, &termProb);
+    
+    enum pauliOpType codes[numTargets];
+    for (int q=0; q < numTargets; q++)
+        codes[q] = (enum pauliOpType) ((term >> (2*q)) & 3);
+    
+    applyPauliProd(qureg, targetQubits, codes, numTargets);
+}
+
+void statevec_mixPauli(Qureg qureg, int qubit, qreal probX, qreal probY, qreal probZ) {
+    
+    qreal termProbs[4] = {1 - (probX + probY + probZ), probX, probY, probZ};
+    sampleAndApplyPauliProd(qureg, &qubit, 1, termProbs);
+}
+
+void statevec_mixDephasing(Qureg qureg, const int targetQubit, qreal prob) {
+    
+    statevec_mixPauli(qureg, targetQubit, 0, 0, prob);
+}
+
+void statevec_mixDepolarising(Qureg qureg, const int targetQubit, qreal prob) {
+    
+    statevec_mixPauli(qureg, targetQubit, prob/3, prob/3, prob/3);
+}
+
+void statevec_mixTwoQubitDephasing(Qureg qureg, int qubit1, int qubit2, qreal prob) {
+    
+    // terms Z1 = 3, Z2 = 3*4 and Z1 Z2 = 3 + 3*4
+    qreal termProbs[16] = {0};
+    termProbs[0] = 1 - prob;
+    termProbs[3] = termProbs[12] = termProbs[15] = prob/3;
+    
+    int targs[2] = {qubit1, qubit2};
+    sampleAndApplyPauliProd(qureg, targs, 2, termProbs);
+}
+
+void statevec_mixTwoQubitDepolarising(Qureg qureg, int qubit1, int qubit2, qreal prob) {
+    
+    qreal termProbs[16];
+    termProbs[0] = 1 - prob;
+    for (int t=1; t < 16; t++)
+        termProbs[t] = prob/15;
+    
+    int targs[2] = {qubit1, qubit2};
+    sampleAndApplyPauliProd(qureg, targs, 2, termProbs);
+}
+
+void statevec_mixDamping(Qureg qureg, const int targetQubit, qreal prob) {
+    
+    // K1 = sqrt(prob) |0><1| occurs with probability prob * P(1)
+    qreal excitedProb = statevec_calcProbOfOutcome(qureg, targetQubit, 1);
+    qreal jumpProb = prob * excitedProb;
+    
+    if (genrand_real2() < jumpProb) {
+        statevec_collapseToKnownProbOutcome(qureg, targetQubit, 1, excitedProb);
+        statevec_pauliX(qureg, targetQubit);
+    }
+    else {
+        // K0 = |0><0| + sqrt(1-prob) |1><1|, renormalised
+        qreal norm = 1/sqrt(1 - jumpProb);
+        ComplexMatrix2 op = {.real={{0}}, .imag={{0}}};
+        op.real[0][0] = norm;
+        op.real[1][1] = sqrt(1 - prob) * norm;
+        statevec_unitary(qureg, targetQubit, op);
+    }
+}
+
+/** Returns Tr(op rho op^dagger) */
+static qreal getKrausOpProb(ComplexMatrix2 op, ComplexMatrix2 rho) {
+    
+    qreal prob = 0;
+    for (int r=0; r < 2; r++) {
+        for (int c=0; c < 2; c++) {
+            
+            // (op rho)[r][c]
+            qreal re = 0, im = 0;
+            for (int k=0; k < 2; k++) {
+                re += op.real[r][k]*rho.real[k][c] - op.imag[r][k]*rho.imag[k][c];
+                im += op.real[r][k]*rho.imag[k][c] + op.imag[r][k]*rho.real[k][c];
+            }
+            
+            // real part of (op rho)[r][c] * conj(op[r][c])
+            prob += re*op.real[r][c] + im*op.imag[r][c];
+        }
+    }
+    return prob;
+}
+
+void statevec_mixKrausMap(Qureg qureg, int target, ComplexMatrix2 *ops, int numOps) {
+    
+    ComplexMatrix2 rho = statevec_calcQubitDensityMatrix(qureg, target);
+    
+    qreal opProbs[numOps];
+    for (int n=0; n < numOps; n++)
+        opProbs[n] = getKrausOpProb(ops[n], rho);
+    
+    qreal opProb;
+    int n = (int) sampleOneFromOutcomeProbs(opProbs, numOps, &opProb);
+    
+    ComplexMatrix2 op = ops[n];
+    qreal norm = 1/sqrt(opProb);
+    for (int r=0; r < 2; r++) {
+        for (int c=0; c < 2; c++) {
+            op.real[r][c] *= norm;
+            op.imag[r][c] *= norm;
+        }
+    }
+    statevec_unitary(qureg, target, op);
+}
+
+TrajectoryStats statevec_calcTrajectoryAverage(
+    Qureg qureg, void (*applyNoisyCircuit)(Qureg, void*), void* circuitArgs, 
+    qreal (*calcObservable)(Qureg, void*), void* observableArgs, int numTrajectories
+) {
+    // Welford's running mean and sum of squared deviations
+    qreal mean = 0;
+    qreal sumSqDevs = 0;
+    
+    for (int t=0; t < numTrajectories; t++) {
+        statevec_initZeroState(qureg);
+        applyNoisyCircuit(qureg, circuitArgs);
+        
+        qreal value = calcObservable(qureg, observableArgs);
+        qreal delta = value - mean;
+        mean += delta / (t+1);
+        sumSqDevs += delta * (value - mean);
+    }
+    
+    TrajectoryStats stats;
+    stats.mean = mean;
+    stats.variance = (numTrajectories > 1)? sumSqDevs / (numTrajectories - 1) : 0;
+    stats.standardError = sqrt(stats.variance / numTrajectories);
+    stats.numTrajectories = numTrajectories;
+    return stats;
+}
+
+typedef struct {
+    enum pauliOpType* allPauliCodes;
+    qreal* termCoeffs;
+    int numSumTerms;
+    Qureg workspace;
+} PauliSumArgs;
+
+static qreal calcPauliSumObservable(Qureg qureg, void* args) {
+    
+    PauliSumArgs* sum = (PauliSumArgs*) args;
+    return statevec_calcExpecPauliSum(qureg, sum->allPauliCodes, sum->termCoeffs, sum->numSumTerms, sum->workspace);
+}
+
+TrajectoryStats statevec_calcTrajectoryExpecPauliSum(
+    Qureg qureg, void (*applyNoisyCircuit)(Qureg, void*), void* circuitArgs, 
+    enum pauliOpType* allPauliCodes, qreal* termCoeffs, int numSumTerms, Qureg workspace, int numTrajectories
+) {
+    PauliSumArgs sum;
+    sum.allPauliCodes = allPauliCodes;
+    sum.termCoeffs = termCoeffs;
+    sum.numSumTerms = numSumTerms;
+    sum.workspace = workspace;
+    
+    return statevec_calcTrajectoryAverage(
+        qureg, applyNoisyCircuit, circuitArgs, calcPauliSumObservable, &sum, numTrajectories);
+}
+
 #ifdef __cplusplus
 }
 #endif
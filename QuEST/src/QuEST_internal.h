@@ -14,6 +14,8 @@
 # include "QuEST.h"
 # include "QuEST_precision.h"
 
+# include <stdint.h>
+
 # ifdef __cplusplus
 extern "C" {
 # endif
@@ -37,8 +39,16 @@ ComplexMatrix2 getConjugateMatrix2(ComplexMatrix2 src);
 
 ComplexMatrix4 getConjugateMatrix4(ComplexMatrix4 src);
 
+ComplexMatrix2 getCompactUnitaryMatrix(Complex alpha, Complex beta);
+
+ComplexMatrix2 getConjugateTransposeMatrix2(ComplexMatrix2 src);
+
+ComplexMatrix4 getConjugateTransposeMatrix4(ComplexMatrix4 src);
+
 void setConjugateMatrixN(ComplexMatrixN m);
 
+void setMatrixNFromRowMajor(ComplexMatrixN m, qreal* re, qreal* im);
+
 void ensureIndsIncrease(int* ind1, int* ind2);
 
 void getComplexPairFromRotation(qreal angle, Vector axis, Complex* alpha, Complex* beta);
@@ -53,6 +63,18 @@ void conjugateMatrixN(ComplexMatrixN u);
 
 void getQuESTDefaultSeedKey(unsigned long int *key);
 
+int generateMeasurementOutcome(qreal zeroProb, qreal *outcomeProb);
+
+qreal* allocOutcomeProbs(int numQubits, const char* caller);
+
+long long int getOutcomeIndex(int* outcomes, int numQubits);
+
+void calcCumulativeProbs(qreal* probs, long long int numProbs);
+
+long long int findCumulativeProbIndex(qreal* cumulProbs, long long int numProbs, qreal cumulProb);
+
+void sampleFromOutcomeProbs(qreal* outcomeProbs, long long int numOutcomes, int numShots, long long int* outcomes);
+
 
 /*
  * operations upon density matrices 
@@ -68,6 +90,10 @@ qreal densmatr_calcTotalProb(Qureg qureg);
 
 qreal densmatr_calcPurity(Qureg qureg);
 
+qreal densmatr_calcExpecPauliSum(Qureg qureg, enum pauliOpType* allCodes, qreal* termCoeffs, int numSumTerms);
+
+qreal densmatr_calcExpecPauliProd(Qureg qureg, int* targetQubits, enum pauliOpType* pauliCodes, int numTargets);
+
 qreal densmatr_calcFidelity(Qureg qureg, Qureg pureState);
 
 qreal densmatr_calcHilbertSchmidtDistance(Qureg a, Qureg b);
@@ -76,6 +102,70 @@ qreal densmatr_calcInnerProduct(Qureg a, Qureg b);
 
 qreal densmatr_calcProbOfOutcome(Qureg qureg, const int measureQubit, int outcome);
 
+void densmatr_multiControlledUnitary(Qureg qureg, long long int ctrlQubitsMask, long long int ctrlFlipMask, const int targetQubit, ComplexMatrix2 u);
+
+void densmatr_multiControlledTwoQubitUnitary(Qureg qureg, long long int ctrlMask, const int targetQubit1, const int targetQubit2, ComplexMatrix4 u);
+
+void densmatr_unitary(Qureg qureg, const int targetQubit, ComplexMatrix2 u);
+
+void densmatr_controlledUnitary(Qureg qureg, const int controlQubit, const int targetQubit, ComplexMatrix2 u);
+
+void densmatr_compactUnitary(Qureg qureg, const int targetQubit, Complex alpha, Complex beta);
+
+void densmatr_controlledCompactUnitary(Qureg qureg, const int controlQubit, const int targetQubit, Complex alpha, Complex beta);
+
+void densmatr_rotateAroundAxis(Qureg qureg, const int rotQubit, qreal angle, Vector axis);
+
+void densmatr_controlledRotateAroundAxis(Qureg qureg, const int controlQubit, const int targetQubit, qreal angle, Vector axis);
+
+void densmatr_rotateX(Qureg qureg, const int rotQubit, qreal angle);
+
+void densmatr_rotateY(Qureg qureg, const int rotQubit, qreal angle);
+
+void densmatr_rotateZ(Qureg qureg, const int rotQubit, qreal angle);
+
+void densmatr_controlledRotateX(Qureg qureg, const int controlQubit, const int targetQubit, qreal angle);
+
+void densmatr_controlledRotateY(Qureg qureg, const int controlQubit, const int targetQubit, qreal angle);
+
+void densmatr_controlledRotateZ(Qureg qureg, const int controlQubit, const int targetQubit, qreal angle);
+
+void densmatr_hadamard(Qureg qureg, const int targetQubit);
+
+void densmatr_pauliX(Qureg qureg, const int targetQubit);
+
+void densmatr_pauliY(Qureg qureg, const int targetQubit);
+
+void densmatr_controlledNot(Qureg qureg, const int controlQubit, const int targetQubit);
+
+void densmatr_controlledPauliY(Qureg qureg, const int controlQubit, const int targetQubit);
+
+void densmatr_twoQubitUnitary(Qureg qureg, const int targetQubit1, const int targetQubit2, ComplexMatrix4 u);
+
+void densmatr_controlledTwoQubitUnitary(Qureg qureg, const int controlQubit, const int targetQubit1, const int targetQubit2, ComplexMatrix4 u);
+
+void densmatr_phaseShiftByTerm(Qureg qureg, long long int ctrlMask, const int targetQubit, Complex term);
+
+void densmatr_swapGate(Qureg qureg, int qb1, int qb2);
+
+void densmatr_sqrtSwapGate(Qureg qureg, int qb1, int qb2);
+
+Complex packmatr_getDensityAmp(Qureg qureg, long long int row, long long int col);
+
+void densmatr_calcProbOfAllOutcomes(qreal* outcomeProbs, Qureg qureg, int* qubits, int numQubits);
+
+void densmatr_calcReducedDensityMatrix(Qureg qureg, int* keepQubits, int numKeep, ComplexMatrixN out);
+
+void densmatr_sampleOutcomes(Qureg qureg, int* qubits, int numQubits, int numShots, long long int* outcomes);
+
+long long int densmatr_measureAllWithStats(Qureg qureg, qreal *outcomeProb);
+
+void densmatr_collapseToOutcomes(Qureg qureg, int* qubits, int* outcomes, int numQubits, qreal outcomeProb);
+
+qreal densmatr_calcProbOfOutcomes(Qureg qureg, int* qubits, int* outcomes, int numQubits);
+
+qreal densmatr_measureQubits(Qureg qureg, int* qubits, int numQubits, int* outcomes);
+
 void densmatr_collapseToKnownProbOutcome(Qureg qureg, const int measureQubit, int outcome, qreal outcomeProb);
     
 int densmatr_measureWithStats(Qureg qureg, int measureQubit, qreal *outcomeProb);
@@ -88,6 +178,12 @@ void densmatr_mixDepolarising(Qureg qureg, const int targetQubit, qreal depolLev
 
 void densmatr_mixDamping(Qureg qureg, const int targetQubit, qreal damping);
 
+void densmatr_mixDephasingAll(Qureg qureg, qreal dephase);
+
+void densmatr_mixDepolarisingOnQubits(Qureg qureg, int* targets, int numTargets, qreal depolLevel);
+
+void densmatr_mixDampingOnQubits(Qureg qureg, int* targets, int numTargets, qreal damping);
+
 void densmatr_mixTwoQubitDepolarising(Qureg qureg, int qubit1, int qubit2, qreal depolLevel);
 
 void densmatr_mixPauli(Qureg qureg, int qubit, qreal pX, qreal pY, qreal pZ);
@@ -96,9 +192,31 @@ void densmatr_mixDensityMatrix(Qureg combineQureg, qreal otherProb, Qureg otherQ
 
 void densmatr_mixKrausMap(Qureg qureg, int target, ComplexMatrix2 *ops, int numOps);
 
+void statevec_mixDephasing(Qureg qureg, const int targetQubit, qreal prob);
+
+void statevec_mixTwoQubitDephasing(Qureg qureg, int qubit1, int qubit2, qreal prob);
+
+void statevec_mixDepolarising(Qureg qureg, const int targetQubit, qreal prob);
+
+void statevec_mixDamping(Qureg qureg, const int targetQubit, qreal prob);
+
+void statevec_mixTwoQubitDepolarising(Qureg qureg, int qubit1, int qubit2, qreal prob);
+
+void statevec_mixPauli(Qureg qureg, int qubit, qreal probX, qreal probY, qreal probZ);
+
+void statevec_mixKrausMap(Qureg qureg, int target, ComplexMatrix2 *ops, int numOps);
+
+TrajectoryStats statevec_calcTrajectoryAverage(Qureg qureg, void (*applyNoisyCircuit)(Qureg, void*), void* circuitArgs, qreal (*calcObservable)(Qureg, void*), void* observableArgs, int numTrajectories);
+
+TrajectoryStats statevec_calcTrajectoryExpecPauliSum(Qureg qureg, void (*applyNoisyCircuit)(Qureg, void*), void* circuitArgs, enum pauliOpType* allPauliCodes, qreal* termCoeffs, int numSumTerms, Qureg workspace, int numTrajectories);
+
 void densmatr_mixTwoQubitKrausMap(Qureg qureg, int target1, int target2, ComplexMatrix4 *ops, int numOps);
 
 void densmatr_mixMultiQubitKrausMap(Qureg qureg, int* targets, int numTargets, ComplexMatrixN* ops, int numOps);
+
+void densmatr_mixMultiQubitKrausMapViaSuperoperator(Qureg qureg, int* targets, int numTargets, ComplexMatrixN* ops, int numOps);
+
+void densmatr_applyMultiQubitKrausMap(Qureg qureg, int* targets, int numTargets, ComplexMatrixN* ops, int numOps);
     
 
 /* 
@@ -115,8 +233,18 @@ void statevec_initStateOfSingleQubit(Qureg *qureg, int qubitId, int outcome);
 
 void statevec_createQureg(Qureg *qureg, int numQubits, QuESTEnv env);
 
+void statevec_createOutOfCoreQureg(Qureg *qureg, int numQubits, char* dirName, QuESTEnv env);
+
+void packmatr_createQureg(Qureg *qureg, int numQubits, QuESTEnv env);
+
 void statevec_destroyQureg(Qureg qureg, QuESTEnv env);
 
+void statevec_setQuregPoolCapacity(int capacity);
+
+void statevec_setCopyOnWriteClones(int useCopyOnWrite);
+
+void statevec_initZeroStateOfNewQureg(Qureg qureg);
+
 void statevec_initBlankState(Qureg qureg);
 
 void statevec_initZeroState(Qureg qureg);
@@ -231,6 +359,26 @@ void statevec_controlledNot(Qureg qureg, const int controlQubit, const int targe
 
 qreal statevec_calcProbOfOutcome(Qureg qureg, const int measureQubit, int outcome);
 
+void statevec_calcProbOfAllOutcomes(qreal* outcomeProbs, Qureg qureg, int* qubits, int numQubits);
+
+ComplexMatrix2 statevec_calcQubitDensityMatrix(Qureg qureg, const int qubit);
+
+void statevec_calcReducedDensityMatrix(Qureg qureg, int* keepQubits, int numKeep, ComplexMatrixN out);
+
+void statevec_sampleOutcomes(Qureg qureg, int* qubits, int numQubits, int numShots, long long int* outcomes);
+
+long long int statevec_sampleBasisState(Qureg qureg, qreal rand, qreal* outcomeProb);
+
+void statevec_collapseToBasisState(Qureg qureg, long long int stateInd);
+
+long long int statevec_measureAllWithStats(Qureg qureg, qreal *outcomeProb);
+
+void statevec_collapseToOutcomes(Qureg qureg, int* qubits, int* outcomes, int numQubits, qreal outcomeProb);
+
+qreal statevec_calcProbOfOutcomes(Qureg qureg, int* qubits, int* outcomes, int numQubits);
+
+qreal statevec_measureQubits(Qureg qureg, int* qubits, int numQubits, int* outcomes);
+
 void statevec_collapseToKnownProbOutcome(Qureg qureg, const int measureQubit, int outcome, qreal outcomeProb);
 
 int statevec_measureWithStats(Qureg qureg, int measureQubit, qreal *outcomeProb);
@@ -249,6 +397,123 @@ void statevec_setWeightedQureg(Complex fac1, Qureg qureg1, Complex fac2, Qureg q
 
 void statevec_applyPauliSum(Qureg inQureg, enum pauliOpType* allCodes, qreal* termCoeffs, int numSumTerms, Qureg outQureg);
 
+
+/* 
+ * operations upon real-amplitude state vectors
+ */
+
+void realvec_createQureg(Qureg *qureg, int numQubits, QuESTEnv env);
+
+void realvec_initBlankState(Qureg qureg);
+
+void realvec_initClassicalState(Qureg qureg, long long int stateInd);
+
+void realvec_initPlusState(Qureg qureg);
+
+void realvec_setAmps(Qureg qureg, long long int startInd, qreal* reals, long long int numAmps);
+
+void realvec_cloneQureg(Qureg targetQureg, Qureg copyQureg);
+
+void realvec_multiControlledPhaseFlip(Qureg qureg, long long int mask);
+
+qreal realvec_calcExpecPauliSum(Qureg qureg, enum pauliOpType* allCodes, qreal* termCoeffs, int numSumTerms);
+
+qreal realvec_calcExpecPauliProd(Qureg qureg, int* targetQubits, enum pauliOpType* pauliCodes, int numTargets);
+
+
+/* 
+ * operations upon fixed Hamming-weight (subspace) state vectors
+ */
+
+void subspace_createQureg(Qureg *qureg, int numQubits, int hammingWeight, QuESTEnv env);
+
+void subspace_initClassicalState(Qureg qureg, long long int stateInd);
+
+Complex subspace_getAmp(Qureg qureg, long long int index);
+
+void subspace_phaseShiftByTerm(Qureg qureg, long long int mask, Complex term);
+
+void subspace_multiRotateZ(Qureg qureg, long long int mask, qreal angle);
+
+void subspace_multiControlledTwoQubitUnitary(Qureg qureg, long long int ctrlMask, const int q1, const int q2, ComplexMatrix4 u);
+
+void subspace_swapQubitAmps(Qureg qureg, int qb1, int qb2);
+
+qreal subspace_calcProbOfOutcome(Qureg qureg, const int measureQubit, int outcome);
+
+void subspace_collapseToKnownProbOutcome(Qureg qureg, const int measureQubit, int outcome, qreal totalProbability);
+
+qreal subspace_calcExpecPauliSum(Qureg qureg, enum pauliOpType* allCodes, qreal* termCoeffs, int numSumTerms);
+
+qreal subspace_calcExpecPauliProd(Qureg qureg, int* targetQubits, enum pauliOpType* pauliCodes, int numTargets);
+
+
+/*
+ * operations upon compressed state vectors
+ */
+
+void compressed_createQureg(Qureg *qureg, int numQubits, int numBits, int floatStorage, QuESTEnv env);
+
+void compressed_destroyQureg(Qureg qureg);
+
+void compressed_initClassicalState(Qureg qureg, long long int stateInd);
+
+Complex compressed_getAmp(Qureg qureg, long long int index);
+
+qreal compressed_calcTotalProb(Qureg qureg);
+
+qreal compressed_calcProbOfOutcome(Qureg qureg, int measureQubit, int outcome);
+
+Complex compressed_calcInnerProduct(Qureg bra, Qureg ket);
+
+void compressed_applyToBlockGroups(Qureg qureg, int* highQubits, int numHighQubits, void (*applyToGroup)(Qureg group, void* args), void* args);
+
+CompressionStats compressed_getStats(Qureg qureg);
+
+
+/*
+ * checkpoints
+ */
+
+# define CHECKPOINT_MAGIC "QuESTckp"
+# define CHECKPOINT_VERSION 2
+
+// the offset (in bytes) of the amplitudes within a checkpoint file, which is a multiple of the page size
+// of every common platform, so that the amplitude arrays of large registers can be mapped from the file
+# define CHECKPOINT_DATA_OFFSET (1LL << 16)
+
+/** The first bytes of a checkpoint file, which are followed at CHECKPOINT_DATA_OFFSET by the real
+ * components of all numAmps amplitudes, then (unless isReal) their imaginary components. gateIndex
+ * is that given to startQuregCheckpoint(), and zero for writeQuregCheckpoint().
+ */
+typedef struct {
+    char magic[8];
+    int32_t version;
+    int32_t numBytesPerReal;
+    int32_t numQubits;
+    int32_t isDensityMatrix;
+    int32_t isPacked;
+    int32_t isReal;
+    int32_t isSubspace;
+    int32_t hammingWeight;
+    int64_t numAmps;
+    int64_t gateIndex;
+    uint64_t realChecksum;
+    uint64_t imagChecksum;
+} CheckpointHeader;
+
+void statevec_initCheckpointHeader(Qureg qureg, CheckpointHeader* header);
+
+int statevec_writeCheckpoint(Qureg qureg, char* filename);
+
+int statevec_readCheckpointHeader(char* filename, CheckpointHeader* header);
+
+int statevec_readCheckpoint(Qureg qureg, char* filename, CheckpointHeader header, int useMapping);
+
+int statevec_startCheckpoint(Qureg qureg, char* filename, long long int gateIndex);
+
+int statevec_finishCheckpoint(Qureg qureg);
+
 # ifdef __cplusplus
 }
 # endif
@@ -1,7 +1,11 @@
 // Distributed under MIT licence. See https://github.com/QuEST-Kit/QuEST/blob/master/LICENCE.txt for details 
 
 /** @file
- * Functions for generating QASM output from QuEST circuits
+ * Functions for recording the operations upon a Qureg, and generating QASM output from them.
+ * Operations are recorded as compact binary records (of an opcode, qubits, exact parameters and
+ * any further data) with no formatting, and are only rendered as QASM when printed or written,
+ * so that recording can be left enabled over long simulations. The records can also be written
+ * to a binary trace file, which can be replayed upon another Qureg, or later rendered as QASM.
  *
  * @author Tyson Jones
  */
@@ -32,8 +36,12 @@
 # define COMMENT_PREF "//"     // QASM syntax for a comment ;)
 
 # define MAX_LINE_LEN 200       // maximum length (#chars) of a single QASM instruction
-# define BUF_INIT_SIZE 1000     // initial size of the QASM buffer (#chars)
+# define BUF_INIT_SIZE 1024     // initial size of the trace buffer (#bytes), exceeding the largest record
 # define BUF_GROW_FAC 2         // growth factor when buffer dynamically resizes
+# define READ_BUF_SIZE (1 << 20)// size of the buffer through which trace files are read (#bytes)
+
+# define RECORD_HEADER_SIZE 6   // bytes of a record's op, gate (or outcome), #controls, #params and #data bytes
+# define MAX_RECORD_SIZE (RECORD_HEADER_SIZE + (1 + 2*MAX_TRACE_CONTROLS)*4 + 8*sizeof(qreal) + MAX_TRACE_COMMENT_LEN)
 
 static const char* qasmGateLabels[] = {
     [GATE_SIGMA_X] = "x",
@@ -51,6 +59,20 @@ static const char* qasmGateLabels[] = {
     [GATE_SQRT_SWAP] = "sqrtswap" // needs decomp into cNOTs and Rx(pi/2)?
 };
 
+/** The expected number of parameters of each operation, where -1 permits 0 or 1 */
+static const int traceNumParams[] = {
+    [TRACE_GATE] = -1,
+    [TRACE_UNITARY] = 8,
+    [TRACE_STATE_CONTROLLED_UNITARY] = 8,
+    [TRACE_COMPACT_UNITARY] = 4,
+    [TRACE_AXIS_ROTATION] = 4,
+    [TRACE_MEASUREMENT] = 0,
+    [TRACE_INIT_ZERO] = 0,
+    [TRACE_INIT_PLUS] = 0,
+    [TRACE_INIT_CLASSICAL] = 0,
+    [TRACE_COMMENT] = 0
+};
+
 // @TODO make a proper internal error thing
 void bufferOverflow(void) {
     printf("!!!\nINTERNAL ERROR: QASM line buffer filled!\n!!!");
@@ -67,18 +89,10 @@ void qasm_setup(Qureg* qureg) {
     
     qasmLog->isLogging = 0;
     qasmLog->bufferSize = BUF_INIT_SIZE;
+    qasmLog->bufferFill = 0;
     qasmLog->buffer = malloc(qasmLog->bufferSize * sizeof *(qasmLog->buffer));
     if (qasmLog->buffer == NULL)
         bufferOverflow();
-    
-    // add headers and quantum / classical register creation
-    qasmLog->bufferFill = snprintf(
-        qasmLog->buffer, qasmLog->bufferSize,
-        "OPENQASM 2.0;\nqreg %s[%d];\ncreg %s[%d];\n", 
-        QUREG_LABEL, qureg->numQubitsRepresented,
-        MESREG_LABEL, qureg->numQubitsRepresented);
-    if (qasmLog->bufferFill >= qasmLog->bufferSize)
-        bufferOverflow();
 }
 
 void qasm_startRecording(Qureg qureg) {
@@ -89,32 +103,72 @@ void qasm_stopRecording(Qureg qureg) {
     qureg.qasmLog->isLogging = 0;
 }
 
-void addStringToQASM(Qureg qureg, char line[], int lineLen) {
-    
-    char* buf = qureg.qasmLog->buffer;
-    int bufSize = qureg.qasmLog->bufferSize;
-    int bufFill = qureg.qasmLog->bufferFill;
-    
-    // grow QASM buffer if necessary
-    if (lineLen + bufFill > bufSize) {
-                
-        int newBufSize = BUF_GROW_FAC * bufSize;
-        if (lineLen + bufFill > newBufSize)
+/** appends a record to the trace, of a header (of op, gate, #controls, #params and #data bytes), 
+ * the target then control qubits, the parameters, and then any further data. The fields are
+ * packed without alignment, so are always copied with memcpy
+ */
+void addRecordToTrace(
+    Qureg qureg, TraceOp op, int gate, int targetQubit, int* controlQubits, int numControlQubits, 
+    qreal* params, int numParams, void* data, int numDataBytes
+) {
+    QASMLogger* log = qureg.qasmLog;
+    long long int recordSize = RECORD_HEADER_SIZE + (1 + numControlQubits)*sizeof(int32_t) 
+        + numParams*sizeof(qreal) + numDataBytes;
+    
+    // grow trace buffer if necessary (once suffices, since no record exceeds BUF_INIT_SIZE)
+    if (log->bufferFill + recordSize > log->bufferSize) {
+        long long int newBufSize = BUF_GROW_FAC * log->bufferSize;
+        char* newBuffer = realloc(log->buffer, newBufSize * sizeof *newBuffer);
+        if (newBuffer == NULL)
             bufferOverflow();
         
-        char* newBuffer = malloc(newBufSize * sizeof *newBuffer);
-        sprintf(newBuffer, "%s", buf);
-        free(buf);
-        
-        qureg.qasmLog->bufferSize = newBufSize;
-        qureg.qasmLog->buffer = newBuffer;
-        bufSize = newBufSize;
-        buf = newBuffer;
+        log->bufferSize = newBufSize;
+        log->buffer = newBuffer;
     }
-        
-    // add new str
-    int addedChars = snprintf(buf+bufFill, bufSize-bufFill, "%s", line);
-    qureg.qasmLog->bufferFill += addedChars;
+    
+    unsigned char* rec = (unsigned char*) log->buffer + log->bufferFill;
+    uint16_t numData = numDataBytes;
+    rec[0] = op;
+    rec[1] = gate;
+    rec[2] = numControlQubits;
+    rec[3] = numParams;
+    memcpy(rec + 4, &numData, sizeof numData);
+    rec += RECORD_HEADER_SIZE;
+    
+    int32_t qubit = targetQubit;
+    memcpy(rec, &qubit, sizeof qubit);
+    rec += sizeof qubit;
+    for (int i=0; i < numControlQubits; i++) {
+        qubit = controlQubits[i];
+        memcpy(rec, &qubit, sizeof qubit);
+        rec += sizeof qubit;
+    }
+    
+    if (numParams > 0)
+        memcpy(rec, params, numParams * sizeof *params);
+    rec += numParams * sizeof *params;
+    if (numDataBytes > 0)
+        memcpy(rec, data, numDataBytes);
+    
+    log->bufferFill += recordSize;
+}
+
+void getParamsFromMatrix(ComplexMatrix2 u, qreal* params) {
+    for (int r=0; r < 2; r++)
+        for (int c=0; c < 2; c++) {
+            params[2*r + c] = u.real[r][c];
+            params[4 + 2*r + c] = u.imag[r][c];
+        }
+}
+
+ComplexMatrix2 getMatrixFromParams(qreal* params) {
+    ComplexMatrix2 u;
+    for (int r=0; r < 2; r++)
+        for (int c=0; c < 2; c++) {
+            u.real[r][c] = params[2*r + c];
+            u.imag[r][c] = params[4 + 2*r + c];
+        }
+    return u;
 }
 
 void qasm_recordComment(Qureg qureg, char* comment, ...) {
@@ -125,54 +179,13 @@ void qasm_recordComment(Qureg qureg, char* comment, ...) {
     // write formatted comment to buff
     va_list argp;
     va_start(argp, comment);
-    char buff[MAX_LINE_LEN - 4];
-    vsnprintf(buff, MAX_LINE_LEN-5, comment, argp);
+    char buff[MAX_TRACE_COMMENT_LEN + 1];
+    int len = vsnprintf(buff, MAX_TRACE_COMMENT_LEN + 1, comment, argp);
     va_end(argp);
+    if (len > MAX_TRACE_COMMENT_LEN)
+        len = MAX_TRACE_COMMENT_LEN;
     
-    // add chars to buff, write to QASM logger
-    char line[MAX_LINE_LEN + 1]; // for trailing \0
-    int len = snprintf(line, MAX_LINE_LEN, "%s %s\n", COMMENT_PREF, buff);
-    addStringToQASM(qureg, line, len);
-}
-
-void addGateToQASM(Qureg qureg, TargetGate gate, int* controlQubits, int numControlQubits, int targetQubit, qreal* params, int numParams) {
-    
-    int len = 0;
-    char line[MAX_LINE_LEN + 1]; // for trailing \0
-    
-    // add control labels
-    for (int i=0; i < numControlQubits; i++)
-        len += snprintf(line+len, MAX_LINE_LEN-len, "%s", CTRL_LABEL_PREF);
-    
-    // add target gate
-    len += snprintf(line+len, MAX_LINE_LEN-len, "%s", qasmGateLabels[gate]);
-    
-    // add parameters
-    if (numParams > 0) {
-        len += snprintf(line+len, MAX_LINE_LEN-len, "(");
-        for (int i=0; i < numParams; i++) {
-            len += snprintf(line+len, MAX_LINE_LEN-len, REAL_QASM_FORMAT, params[i]);
-            if (i != numParams - 1)
-                len += snprintf(line+len, MAX_LINE_LEN-len, ",");
-        }
-        len += snprintf(line+len, MAX_LINE_LEN-len, ")");
-    }
-    
-    // add space
-    len += snprintf(line+len, MAX_LINE_LEN-len, " ");
-    
-    // add control qubits
-    for (int i=0; i < numControlQubits; i++)
-        len += snprintf(line+len, MAX_LINE_LEN-len, "%s[%d],", QUREG_LABEL, controlQubits[i]);
-    
-    // add target qubit, colon and newline
-    len += snprintf(line+len, MAX_LINE_LEN-len, "%s[%d];\n", QUREG_LABEL, targetQubit);
-    
-    // check whether we overflowed buffer
-    if (len >= MAX_LINE_LEN)
-        bufferOverflow();
-        
-    addStringToQASM(qureg, line, len);
+    addRecordToTrace(qureg, TRACE_COMMENT, 0, -1, NULL, 0, NULL, 0, buff, len);
 }
 
 void qasm_recordGate(Qureg qureg, TargetGate gate, int targetQubit) {
@@ -180,7 +193,7 @@ void qasm_recordGate(Qureg qureg, TargetGate gate, int targetQubit) {
     if (!qureg.qasmLog->isLogging)
         return;
     
-    addGateToQASM(qureg, gate, NULL, 0, targetQubit, NULL, 0);
+    addRecordToTrace(qureg, TRACE_GATE, gate, targetQubit, NULL, 0, NULL, 0, NULL, 0);
 }
 
 void qasm_recordParamGate(Qureg qureg, TargetGate gate, int targetQubit, qreal param) {
@@ -189,7 +202,7 @@ void qasm_recordParamGate(Qureg qureg, TargetGate gate, int targetQubit, qreal p
         return;
     
     qreal params[1] = {param};
-    addGateToQASM(qureg, gate, NULL, 0, targetQubit, params, 1);
+    addRecordToTrace(qureg, TRACE_GATE, gate, targetQubit, NULL, 0, params, 1, NULL, 0);
 }
 
 void qasm_recordCompactUnitary(Qureg qureg, Complex alpha, Complex beta, int targetQubit) {
@@ -197,11 +210,8 @@ void qasm_recordCompactUnitary(Qureg qureg, Complex alpha, Complex beta, int tar
     if (!qureg.qasmLog->isLogging)
         return;
     
-    qreal rz2, ry, rz1;
-    getZYZRotAnglesFromComplexPair(alpha, beta, &rz2, &ry, &rz1);
-    
-    qreal params[3] = {rz2, ry, rz1};
-    addGateToQASM(qureg, GATE_UNITARY, NULL, 0, targetQubit, params, 3);
+    qreal params[4] = {alpha.real, alpha.imag, beta.real, beta.imag};
+    addRecordToTrace(qureg, TRACE_COMPACT_UNITARY, 0, targetQubit, NULL, 0, params, 4, NULL, 0);
 }
 
 void qasm_recordUnitary(Qureg qureg, ComplexMatrix2 u, int targetQubit) {
@@ -209,15 +219,9 @@ void qasm_recordUnitary(Qureg qureg, ComplexMatrix2 u, int targetQubit) {
     if (!qureg.qasmLog->isLogging)
         return;
     
-    Complex alpha, beta;
-    qreal discardedGlobalPhase;
-    getComplexPairAndPhaseFromUnitary(u, &alpha, &beta, &discardedGlobalPhase);
-    
-    qreal rz2, ry, rz1;
-    getZYZRotAnglesFromComplexPair(alpha, beta, &rz2, &ry, &rz1);
-    
-    qreal params[3] = {rz2, ry, rz1};
-    addGateToQASM(qureg, GATE_UNITARY, NULL, 0, targetQubit, params, 3);
+    qreal params[8];
+    getParamsFromMatrix(u, params);
+    addRecordToTrace(qureg, TRACE_UNITARY, 0, targetQubit, NULL, 0, params, 8, NULL, 0);
 }
 
 void qasm_recordAxisRotation(Qureg qureg, qreal angle, Vector axis, const int targetQubit) {
@@ -225,14 +229,8 @@ void qasm_recordAxisRotation(Qureg qureg, qreal angle, Vector axis, const int ta
     if (!qureg.qasmLog->isLogging)
         return;
     
-    Complex alpha, beta;
-    getComplexPairFromRotation(angle, axis, &alpha, &beta);
-    
-    qreal rz2, ry, rz1;
-    getZYZRotAnglesFromComplexPair(alpha, beta, &rz2, &ry, &rz1);
-    
-    qreal params[3] = {rz2, ry, rz1};
-    addGateToQASM(qureg, GATE_UNITARY, NULL, 0, targetQubit, params, 3);
+    qreal params[4] = {angle, axis.x, axis.y, axis.z};
+    addRecordToTrace(qureg, TRACE_AXIS_ROTATION, 0, targetQubit, NULL, 0, params, 4, NULL, 0);
 }
 
 void qasm_recordControlledGate(Qureg qureg, TargetGate gate, int controlQubit, int targetQubit) {
@@ -241,7 +239,7 @@ void qasm_recordControlledGate(Qureg qureg, TargetGate gate, int controlQubit, i
         return;
     
     int controls[1] = {controlQubit};
-    addGateToQASM(qureg, gate, controls, 1, targetQubit, 0, 0);    
+    addRecordToTrace(qureg, TRACE_GATE, gate, targetQubit, controls, 1, NULL, 0, NULL, 0);
 }
 
 void qasm_recordControlledParamGate(Qureg qureg, TargetGate gate, int controlQubit, int targetQubit, qreal param) {
@@ -251,14 +249,7 @@ void qasm_recordControlledParamGate(Qureg qureg, TargetGate gate, int controlQub
     
     int controls[1] = {controlQubit};
     qreal params[1] = {param};
-    addGateToQASM(qureg, gate, controls, 1, targetQubit, params, 1);
-    
-    // correct the global phase of controlled phase shifts
-    if (gate == GATE_PHASE_SHIFT) {
-        qasm_recordComment(qureg, "Restoring the discarded global phase of the previous controlled phase gate");
-        qreal phaseFix[1] = {param/2.0};
-        addGateToQASM(qureg, GATE_ROTATE_Z, NULL, 0, targetQubit, phaseFix, 1);
-    }
+    addRecordToTrace(qureg, TRACE_GATE, gate, targetQubit, controls, 1, params, 1, NULL, 0);
 }
 
 void qasm_recordControlledCompactUnitary(Qureg qureg, Complex alpha, Complex beta, int controlQubit, int targetQubit) {
@@ -266,35 +257,20 @@ void qasm_recordControlledCompactUnitary(Qureg qureg, Complex alpha, Complex bet
     if (!qureg.qasmLog->isLogging)
         return;
     
-    qreal rz2, ry, rz1;
-    getZYZRotAnglesFromComplexPair(alpha, beta, &rz2, &ry, &rz1);
-    
     int controls[1] = {controlQubit};
-    qreal params[3] = {rz2, ry, rz1};
-    addGateToQASM(qureg, GATE_UNITARY, controls, 1, targetQubit, params, 3);
+    qreal params[4] = {alpha.real, alpha.imag, beta.real, beta.imag};
+    addRecordToTrace(qureg, TRACE_COMPACT_UNITARY, 0, targetQubit, controls, 1, params, 4, NULL, 0);
 }
 
-/** additionally performs Rz on target to restore the global phase lost from u in QASM U(a,b,c) */
 void qasm_recordControlledUnitary(Qureg qureg, ComplexMatrix2 u, int controlQubit, int targetQubit) {
     
     if (!qureg.qasmLog->isLogging)
         return;
     
-    Complex alpha, beta;
-    qreal globalPhase;
-    getComplexPairAndPhaseFromUnitary(u, &alpha, &beta, &globalPhase);
-    
-    qreal rz2, ry, rz1;
-    getZYZRotAnglesFromComplexPair(alpha, beta, &rz2, &ry, &rz1);
-    
     int controls[1] = {controlQubit};
-    qreal params[3] = {rz2, ry, rz1};
-    addGateToQASM(qureg, GATE_UNITARY, controls, 1, targetQubit, params, 3);
-    
-    // add Rz
-    qasm_recordComment(qureg, "Restoring the discarded global phase of the previous controlled unitary");
-    qreal phaseFix[1] = {globalPhase};
-    addGateToQASM(qureg, GATE_ROTATE_Z, NULL, 0, targetQubit, phaseFix, 1);
+    qreal params[8];
+    getParamsFromMatrix(u, params);
+    addRecordToTrace(qureg, TRACE_UNITARY, 0, targetQubit, controls, 1, params, 8, NULL, 0);
 }
 
 void qasm_recordControlledAxisRotation(Qureg qureg, qreal angle, Vector axis, int controlQubit, int targetQubit) {
@@ -302,15 +278,9 @@ void qasm_recordControlledAxisRotation(Qureg qureg, qreal angle, Vector axis, in
     if (!qureg.qasmLog->isLogging)
         return;
     
-    Complex alpha, beta;
-    getComplexPairFromRotation(angle, axis, &alpha, &beta);
-    
-    qreal rz2, ry, rz1;
-    getZYZRotAnglesFromComplexPair(alpha, beta, &rz2, &ry, &rz1);
-    
     int controls[1] = {controlQubit};
-    qreal params[3] = {rz2, ry, rz1};
-    addGateToQASM(qureg, GATE_UNITARY, controls, 1, targetQubit, params, 3);
+    qreal params[4] = {angle, axis.x, axis.y, axis.z};
+    addRecordToTrace(qureg, TRACE_AXIS_ROTATION, 0, targetQubit, controls, 1, params, 4, NULL, 0);
 }
 
 void qasm_recordMultiControlledGate(Qureg qureg, TargetGate gate, int* controlQubits, const int numControlQubits, const int targetQubit) {
@@ -318,7 +288,7 @@ void qasm_recordMultiControlledGate(Qureg qureg, TargetGate gate, int* controlQu
     if (!qureg.qasmLog->isLogging)
         return;
     
-    addGateToQASM(qureg, gate, controlQubits, numControlQubits, targetQubit, NULL, 0);
+    addRecordToTrace(qureg, TRACE_GATE, gate, targetQubit, controlQubits, numControlQubits, NULL, 0, NULL, 0);
 }
 
 void qasm_recordMultiControlledParamGate(Qureg qureg, TargetGate gate, int* controlQubits, const int numControlQubits, const int targetQubit, qreal param) {
@@ -327,36 +297,17 @@ void qasm_recordMultiControlledParamGate(Qureg qureg, TargetGate gate, int* cont
         return;
     
     qreal params[1] = {param};
-    addGateToQASM(qureg, gate, controlQubits, numControlQubits, targetQubit, params, 1);
-    
-    // correct the global phase of controlled phase shifts
-    if (gate == GATE_PHASE_SHIFT) {
-        qasm_recordComment(qureg, "Restoring the discarded global phase of the previous multicontrolled phase gate");
-        qreal phaseFix[1] = {param/2.0};
-        addGateToQASM(qureg, GATE_ROTATE_Z, NULL, 0, targetQubit, phaseFix, 1);
-    }
+    addRecordToTrace(qureg, TRACE_GATE, gate, targetQubit, controlQubits, numControlQubits, params, 1, NULL, 0);
 }
 
-/** additionally performs Rz on target to restore the global phase lost from u in QASM U(a,b,c) */
 void qasm_recordMultiControlledUnitary(Qureg qureg, ComplexMatrix2 u, int* controlQubits, const int numControlQubits, const int targetQubit) {
     
     if (!qureg.qasmLog->isLogging)
         return;
     
-    Complex alpha, beta;
-    qreal globalPhase;
-    getComplexPairAndPhaseFromUnitary(u, &alpha, &beta, &globalPhase);
-    
-    qreal rz2, ry, rz1;
-    getZYZRotAnglesFromComplexPair(alpha, beta, &rz2, &ry, &rz1);
-    
-    qreal params[3] = {rz2, ry, rz1};
-    addGateToQASM(qureg, GATE_UNITARY, controlQubits, numControlQubits, targetQubit, params, 3);
-    
-    // add Rz
-    qasm_recordComment(qureg, "Restoring the discarded global phase of the previous multicontrolled unitary");
-    qreal phaseFix[1] = {globalPhase};
-    addGateToQASM(qureg, GATE_ROTATE_Z, NULL, 0, targetQubit, phaseFix, 1);
+    qreal params[8];
+    getParamsFromMatrix(u, params);
+    addRecordToTrace(qureg, TRACE_UNITARY, 0, targetQubit, controlQubits, numControlQubits, params, 8, NULL, 0);
 }
 
 void qasm_recordMultiStateControlledUnitary(
@@ -365,124 +316,400 @@ void qasm_recordMultiStateControlledUnitary(
     if (!qureg.qasmLog->isLogging)
         return;
     
-    qasm_recordComment(qureg, "NOTing some gates so that the subsequent unitary is controlled-on-0");
+    int32_t states[MAX_TRACE_CONTROLS];
     for (int i=0; i < numControlQubits; i++)
-        if (controlState[i] == 0)
-            addGateToQASM(qureg, GATE_SIGMA_X, NULL, 0, controlQubits[i], NULL, 0);
+        states[i] = controlState[i];
     
-    qasm_recordMultiControlledUnitary(qureg, u, controlQubits, numControlQubits, targetQubit);
+    qreal params[8];
+    getParamsFromMatrix(u, params);
+    addRecordToTrace(
+        qureg, TRACE_STATE_CONTROLLED_UNITARY, 0, targetQubit, controlQubits, numControlQubits, 
+        params, 8, states, numControlQubits * sizeof *states);
+}
 
-    qasm_recordComment(qureg, "Undoing the NOTing of the controlled-on-0 qubits of the previous unitary");
-    for (int i=0; i < numControlQubits; i++)
-        if (controlState[i] == 0)
-            addGateToQASM(qureg, GATE_SIGMA_X, NULL, 0, controlQubits[i], NULL, 0);
+void qasm_recordMeasurement(Qureg qureg, const int measureQubit, const int outcome) {
+
+    if (!qureg.qasmLog->isLogging)
+        return;
+    
+    addRecordToTrace(qureg, TRACE_MEASUREMENT, outcome, measureQubit, NULL, 0, NULL, 0, NULL, 0);
 }
 
-/* not actually used, D'Oh!
-void qasm_recordMultiControlledAxisRotation(Qureg qureg, qreal angle, Vector axis, int* controlQubits, const int numControlQubits, const int targetQubit) {
+void qasm_recordInitZero(Qureg qureg) {
     
     if (!qureg.qasmLog->isLogging)
         return;
     
-    Complex alpha, beta;
-    getComplexPairFromRotation(angle, axis, &alpha, &beta);
+    addRecordToTrace(qureg, TRACE_INIT_ZERO, 0, -1, NULL, 0, NULL, 0, NULL, 0);
+}
+
+void qasm_recordInitPlus(Qureg qureg) {
     
-    qreal rz2, ry, rz1;
-    getZYZRotAnglesFromComplexPair(alpha, beta, &rz2, &ry, &rz1);
+    if (!qureg.qasmLog->isLogging)
+        return;
     
-    qreal params[3] = {rz2, ry, rz1};
-    addGateToQASM(qureg, GATE_UNITARY, controlQubits, numControlQubits, targetQubit, params, 3);
+    addRecordToTrace(qureg, TRACE_INIT_PLUS, 0, -1, NULL, 0, NULL, 0, NULL, 0);
 }
-*/
-
-void qasm_recordMeasurement(Qureg qureg, const int measureQubit) {
 
+void qasm_recordInitClassical(Qureg qureg, long long int stateInd) {
+    
     if (!qureg.qasmLog->isLogging)
         return;
     
-    char line[MAX_LINE_LEN + 1]; // for trailing \0
-    int len = snprintf(
-        line, MAX_LINE_LEN, "%s %s[%d] -> %s[%d];\n",
-        MEASURE_CMD, QUREG_LABEL, measureQubit, MESREG_LABEL, measureQubit);
+    int64_t ind = stateInd;
+    addRecordToTrace(qureg, TRACE_INIT_CLASSICAL, 0, -1, NULL, 0, NULL, 0, &ind, sizeof ind);
+}
+
+void qasm_clearRecorded(Qureg qureg) {
+    
+    // maintains current buffer size
+    qureg.qasmLog->bufferFill = 0;
+}
+
+
+/*
+ * reading the trace
+ */
+
+void openRecordedTrace(Qureg qureg, TraceReader* reader) {
+    
+    reader->file = NULL;
+    reader->buffer = qureg.qasmLog->buffer;
+    reader->bufferFill = qureg.qasmLog->bufferFill;
+    reader->pos = 0;
+    reader->numFileBytesLeft = 0;
+    reader->header.numQubits = qureg.numQubitsRepresented;
+}
+
+/** returns 1 if a record was decoded into rec, 0 if the trace is exhausted, or -1 if the record is
+ * invalid or truncated
+ */
+int qasm_readTraceRecord(TraceReader* reader, TraceRecord* rec) {
+    
+    // top up a file's buffer so that it contains at least one whole record
+    if (reader->file != NULL && reader->bufferFill - reader->pos < (long long int) MAX_RECORD_SIZE && reader->numFileBytesLeft > 0) {
+        long long int numKept = reader->bufferFill - reader->pos;
+        memmove(reader->buffer, reader->buffer + reader->pos, numKept);
         
-    // check whether we overflowed buffer
-    if (len >= MAX_LINE_LEN)
-        bufferOverflow();
+        long long int numRead = READ_BUF_SIZE - numKept;
+        if (numRead > reader->numFileBytesLeft)
+            numRead = reader->numFileBytesLeft;
+        if (fread(reader->buffer + numKept, 1, numRead, reader->file) != (size_t) numRead)
+            return -1;
+        
+        reader->numFileBytesLeft -= numRead;
+        reader->bufferFill = numKept + numRead;
+        reader->pos = 0;
+    }
+    
+    long long int numBytesLeft = reader->bufferFill - reader->pos;
+    if (numBytesLeft == 0)
+        return 0;
+    if (numBytesLeft < RECORD_HEADER_SIZE)
+        return -1;
+    
+    unsigned char* buf = (unsigned char*) reader->buffer + reader->pos;
+    uint16_t numDataBytes;
+    memcpy(&numDataBytes, buf + 4, sizeof numDataBytes);
+    rec->op = buf[0];
+    rec->gate = buf[1];
+    rec->numControls = buf[2];
+    rec->numParams = buf[3];
+    
+    // reject malformed records
+    if (rec->op > TRACE_COMMENT || rec->numControls > MAX_TRACE_CONTROLS)
+        return -1;
+    int numExpectedParams = traceNumParams[rec->op];
+    if (rec->numParams != numExpectedParams && !(numExpectedParams == -1 && rec->numParams <= 1))
+        return -1;
+    if (rec->op == TRACE_GATE && rec->gate > GATE_SQRT_SWAP)
+        return -1;
+    
+    long long int recordSize = RECORD_HEADER_SIZE + (1 + rec->numControls)*sizeof(int32_t) 
+        + rec->numParams*sizeof(qreal) + numDataBytes;
+    if (recordSize > numBytesLeft)
+        return -1;
+    buf += RECORD_HEADER_SIZE;
+    
+    int32_t qubit;
+    memcpy(&qubit, buf, sizeof qubit);
+    rec->target = qubit;
+    buf += sizeof qubit;
+    for (int i=0; i < rec->numControls; i++) {
+        memcpy(&qubit, buf, sizeof qubit);
+        rec->controls[i] = qubit;
+        buf += sizeof qubit;
+    }
     
-    addStringToQASM(qureg, line, len);
+    memcpy(rec->params, buf, rec->numParams * sizeof *(rec->params));
+    buf += rec->numParams * sizeof *(rec->params);
+    
+    // decode the further data of the operation
+    int numExpectedDataBytes = 0;
+    if (rec->op == TRACE_STATE_CONTROLLED_UNITARY) {
+        numExpectedDataBytes = rec->numControls * sizeof(int32_t);
+        for (int i=0; i < rec->numControls; i++) {
+            int32_t state;
+            memcpy(&state, buf + i*sizeof state, sizeof state);
+            rec->controlState[i] = state;
+        }
+    }
+    else if (rec->op == TRACE_MEASUREMENT)
+        rec->outcome = rec->gate;
+    else if (rec->op == TRACE_INIT_CLASSICAL) {
+        int64_t stateInd = 0;
+        numExpectedDataBytes = sizeof stateInd;
+        if (numDataBytes == sizeof stateInd)
+            memcpy(&stateInd, buf, sizeof stateInd);
+        rec->stateInd = stateInd;
+    }
+    else if (rec->op == TRACE_COMMENT) {
+        if (numDataBytes > MAX_TRACE_COMMENT_LEN)
+            return -1;
+        numExpectedDataBytes = numDataBytes;
+        memcpy(rec->comment, buf, numDataBytes);
+        rec->comment[numDataBytes] = '\0';
+    }
+    if (numDataBytes != numExpectedDataBytes)
+        return -1;
+    
+    reader->pos += recordSize;
+    return 1;
 }
 
-void qasm_recordInitZero(Qureg qureg) {
+void initTraceHeader(Qureg qureg, TraceHeader* header) {
     
-    if (!qureg.qasmLog->isLogging)
-        return;
+    memset(header, 0, sizeof *header);
+    memcpy(header->magic, TRACE_MAGIC, sizeof header->magic);
+    header->version = TRACE_VERSION;
+    header->numBytesPerReal = sizeof(qreal);
+    header->numQubits = qureg.numQubitsRepresented;
+    header->isDensityMatrix = qureg.isDensityMatrix;
+    header->numBytes = qureg.qasmLog->bufferFill;
+}
+
+int qasm_isValidTraceHeader(TraceHeader header) {
+    return (
+        memcmp(header.magic, TRACE_MAGIC, sizeof header.magic) == 0 &&
+        header.version == TRACE_VERSION &&
+        header.numBytesPerReal == sizeof(qreal) &&
+        header.numQubits > 0 && 
+        header.numBytes >= 0);
+}
+
+/** returns whether the file could be opened; if so, its header is read into reader (or zeroed if absent) */
+int qasm_openTraceFile(char* filename, TraceReader* reader) {
     
-    char line[MAX_LINE_LEN + 1]; // for trailing \0
-    int len = snprintf(line, MAX_LINE_LEN, "%s %s;\n", INIT_ZERO_CMD, QUREG_LABEL);
+    FILE* file = fopen(filename, "rb");
+    if (file == NULL)
+        return 0;
     
-    // check whether we overflowed buffer
-    if (len >= MAX_LINE_LEN)
+    if (fread(&reader->header, sizeof reader->header, 1, file) != 1)
+        memset(&reader->header, 0, sizeof reader->header);
+    
+    reader->file = file;
+    reader->buffer = malloc(READ_BUF_SIZE);
+    if (reader->buffer == NULL)
         bufferOverflow();
+    reader->bufferFill = 0;
+    reader->pos = 0;
+    reader->numFileBytesLeft = (qasm_isValidTraceHeader(reader->header))? reader->header.numBytes : 0;
+    return 1;
+}
+
+void qasm_closeTraceFile(TraceReader* reader) {
     
-    addStringToQASM(qureg, line, len);
+    fclose(reader->file);
+    free(reader->buffer);
 }
 
-void qasm_recordInitPlus(Qureg qureg) {
+/** returns success of file write */
+int qasm_writeRecordedTraceToFile(Qureg qureg, char* filename) {
     
-    if (!qureg.qasmLog->isLogging)
-        return;
+    FILE *file = fopen(filename, "wb");
+    if (file == NULL)
+        return 0;
     
-    // add an explanatory comment
-    char buf[MAX_LINE_LEN+1];
-    sprintf(buf, "Initialising state |+>");
-    qasm_recordComment(qureg, buf);
-    
-    // it's valid QASM to h the register (I think)
-    // |+> = H |0>
-    qasm_recordInitZero(qureg);
-    int charsWritten = snprintf(
-        buf, MAX_LINE_LEN, "%s %s;\n", 
-        qasmGateLabels[GATE_HADAMARD], QUREG_LABEL);
-    if (charsWritten >= MAX_LINE_LEN)
-        bufferOverflow();
-    addStringToQASM(qureg, buf, charsWritten);
+    TraceHeader header;
+    initTraceHeader(qureg, &header);
+    size_t numBytes = qureg.qasmLog->bufferFill;
+    int success = (
+        fwrite(&header, sizeof header, 1, file) == 1 &&
+        fwrite(qureg.qasmLog->buffer, 1, numBytes, file) == numBytes);
     
-    // old code (before above QASM shortcut)
-    /*
-    qasm_recordInitZero(qureg);
-    for (int q=0; q < qureg.numQubitsRepresented; q++)
-        qasm_recordGate(qureg, GATE_HADAMARD, q);
-    */
+    return (fclose(file) == 0) && success;
 }
 
-void qasm_recordInitClassical(Qureg qureg, long long int stateInd) {
+
+/*
+ * generating QASM
+ */
+
+void printGateAsQASM(FILE* file, TargetGate gate, int* controlQubits, int numControlQubits, int targetQubit, qreal* params, int numParams) {
     
-    if (!qureg.qasmLog->isLogging)
-        return;
+    // add control labels
+    for (int i=0; i < numControlQubits; i++)
+        fprintf(file, "%s", CTRL_LABEL_PREF);
     
-    // add an explanatory comment
-    char cmt[MAX_LINE_LEN+1];
-    sprintf(cmt, "Initialising state |%lld>", stateInd);
-    qasm_recordComment(qureg, cmt);
+    // add target gate
+    fprintf(file, "%s", qasmGateLabels[gate]);
     
-    // start in |0>
-    qasm_recordInitZero(qureg);
+    // add parameters
+    if (numParams > 0) {
+        fprintf(file, "(");
+        for (int i=0; i < numParams; i++) {
+            fprintf(file, REAL_QASM_FORMAT, params[i]);
+            if (i != numParams - 1)
+                fprintf(file, ",");
+        }
+        fprintf(file, ")");
+    }
+    
+    // add space
+    fprintf(file, " ");
     
-    // NOT the 1 bits in stateInd
-    for (int q=0; q < qureg.numQubitsRepresented; q++) 
-        if ((stateInd >> q) & 1)
-            qasm_recordGate(qureg, GATE_SIGMA_X, q);
+    // add control qubits
+    for (int i=0; i < numControlQubits; i++)
+        fprintf(file, "%s[%d],", QUREG_LABEL, controlQubits[i]);
+    
+    // add target qubit, colon and newline
+    fprintf(file, "%s[%d];\n", QUREG_LABEL, targetQubit);
 }
 
-void qasm_clearRecorded(Qureg qureg) {
+void printCommentAsQASM(FILE* file, char* comment) {
+    fprintf(file, "%s %s\n", COMMENT_PREF, comment);
+}
+
+/** prints U(rz2,ry,rz1), the ZYZ decomposition of the unitary of alpha and beta */
+void printCompactUnitaryAsQASM(FILE* file, Complex alpha, Complex beta, int* controlQubits, int numControlQubits, int targetQubit) {
     
-    // maintains current buffer size
-    (qureg.qasmLog->buffer)[0] = '\0';
-    qureg.qasmLog->bufferFill = 0;
+    qreal rz2, ry, rz1;
+    getZYZRotAnglesFromComplexPair(alpha, beta, &rz2, &ry, &rz1);
+    
+    qreal params[3] = {rz2, ry, rz1};
+    printGateAsQASM(file, GATE_UNITARY, controlQubits, numControlQubits, targetQubit, params, 3);
+}
+
+/** additionally performs Rz on target to restore the global phase lost from u in QASM U(a,b,c) when controlled */
+void printUnitaryAsQASM(FILE* file, ComplexMatrix2 u, int* controlQubits, int numControlQubits, int targetQubit) {
+    
+    Complex alpha, beta;
+    qreal globalPhase;
+    getComplexPairAndPhaseFromUnitary(u, &alpha, &beta, &globalPhase);
+    printCompactUnitaryAsQASM(file, alpha, beta, controlQubits, numControlQubits, targetQubit);
+    
+    if (numControlQubits == 0)
+        return;
+    
+    printCommentAsQASM(file, (numControlQubits == 1)?
+        "Restoring the discarded global phase of the previous controlled unitary" :
+        "Restoring the discarded global phase of the previous multicontrolled unitary");
+    qreal phaseFix[1] = {globalPhase};
+    printGateAsQASM(file, GATE_ROTATE_Z, NULL, 0, targetQubit, phaseFix, 1);
+}
+
+void printRecordAsQASM(FILE* file, TraceRecord* rec, int numQubits) {
+    
+    int* ctrls = rec->controls;
+    int numCtrls = rec->numControls;
+    Complex alpha = {.real=rec->params[0], .imag=rec->params[1]};
+    Complex beta = {.real=rec->params[2], .imag=rec->params[3]};
+    
+    switch (rec->op) {
+        case TRACE_GATE:
+            printGateAsQASM(file, rec->gate, ctrls, numCtrls, rec->target, rec->params, rec->numParams);
+            
+            // correct the global phase of controlled phase shifts
+            if (rec->gate == GATE_PHASE_SHIFT && numCtrls > 0) {
+                printCommentAsQASM(file, (numCtrls == 1)?
+                    "Restoring the discarded global phase of the previous controlled phase gate" :
+                    "Restoring the discarded global phase of the previous multicontrolled phase gate");
+                qreal phaseFix[1] = {rec->params[0]/2.0};
+                printGateAsQASM(file, GATE_ROTATE_Z, NULL, 0, rec->target, phaseFix, 1);
+            }
+            break;
+        
+        case TRACE_UNITARY:
+            printUnitaryAsQASM(file, getMatrixFromParams(rec->params), ctrls, numCtrls, rec->target);
+            break;
+        
+        case TRACE_STATE_CONTROLLED_UNITARY:
+            printCommentAsQASM(file, "NOTing some gates so that the subsequent unitary is controlled-on-0");
+            for (int i=0; i < numCtrls; i++)
+                if (rec->controlState[i] == 0)
+                    printGateAsQASM(file, GATE_SIGMA_X, NULL, 0, ctrls[i], NULL, 0);
+            
+            printUnitaryAsQASM(file, getMatrixFromParams(rec->params), ctrls, numCtrls, rec->target);
+            
+            printCommentAsQASM(file, "Undoing the NOTing of the controlled-on-0 qubits of the previous unitary");
+            for (int i=0; i < numCtrls; i++)
+                if (rec->controlState[i] == 0)
+                    printGateAsQASM(file, GATE_SIGMA_X, NULL, 0, ctrls[i], NULL, 0);
+            break;
+        
+        case TRACE_COMPACT_UNITARY:
+            printCompactUnitaryAsQASM(file, alpha, beta, ctrls, numCtrls, rec->target);
+            break;
+        
+        case TRACE_AXIS_ROTATION: {
+            Vector axis = {.x=rec->params[1], .y=rec->params[2], .z=rec->params[3]};
+            getComplexPairFromRotation(rec->params[0], axis, &alpha, &beta);
+            printCompactUnitaryAsQASM(file, alpha, beta, ctrls, numCtrls, rec->target);
+            break;
+        }
+        
+        case TRACE_MEASUREMENT:
+            fprintf(file, "%s %s[%d] -> %s[%d];\n",
+                MEASURE_CMD, QUREG_LABEL, rec->target, MESREG_LABEL, rec->target);
+            break;
+        
+        case TRACE_INIT_ZERO:
+            fprintf(file, "%s %s;\n", INIT_ZERO_CMD, QUREG_LABEL);
+            break;
+        
+        case TRACE_INIT_PLUS:
+            // it's valid QASM to h the register (I think)
+            // |+> = H |0>
+            printCommentAsQASM(file, "Initialising state |+>");
+            fprintf(file, "%s %s;\n", INIT_ZERO_CMD, QUREG_LABEL);
+            fprintf(file, "%s %s;\n", qasmGateLabels[GATE_HADAMARD], QUREG_LABEL);
+            break;
+        
+        case TRACE_INIT_CLASSICAL:
+            fprintf(file, "%s Initialising state |%lld>\n", COMMENT_PREF, rec->stateInd);
+            fprintf(file, "%s %s;\n", INIT_ZERO_CMD, QUREG_LABEL);
+            
+            // NOT the 1 bits in stateInd
+            for (int q=0; q < numQubits; q++) 
+                if ((rec->stateInd >> q) & 1)
+                    printGateAsQASM(file, GATE_SIGMA_X, NULL, 0, q, NULL, 0);
+            break;
+        
+        case TRACE_COMMENT:
+            printCommentAsQASM(file, rec->comment);
+            break;
+    }
+}
+
+/** prints the QASM header and every record of the trace, returning 0 if a record was invalid */
+int printTraceAsQASM(FILE* file, TraceReader* reader) {
+    
+    int numQubits = reader->header.numQubits;
+    fprintf(file, "OPENQASM 2.0;\nqreg %s[%d];\ncreg %s[%d];\n", 
+        QUREG_LABEL, numQubits, MESREG_LABEL, numQubits);
+    
+    TraceRecord rec;
+    int status;
+    while ((status = qasm_readTraceRecord(reader, &rec)) == 1)
+        printRecordAsQASM(file, &rec, numQubits);
+    return (status == 0);
 }
 
 void qasm_printRecorded(Qureg qureg) {
-    printf("%s", qureg.qasmLog->buffer);
+    
+    TraceReader reader;
+    openRecordedTrace(qureg, &reader);
+    printTraceAsQASM(stdout, &reader);
 }
 
 /** returns success of file write */
@@ -492,7 +719,21 @@ int qasm_writeRecordedToFile(Qureg qureg, char* filename) {
     if (file == NULL)
         return 0;
     
-    fprintf(file, "%s", qureg.qasmLog->buffer);
+    TraceReader reader;
+    openRecordedTrace(qureg, &reader);
+    printTraceAsQASM(file, &reader);
+    fclose(file);
+    return 1;
+}
+
+/** returns success of file write, setting isValidTrace to whether every record of the trace was valid */
+int qasm_writeTraceFileAsQASM(TraceReader* reader, char* filename, int* isValidTrace) {
+    
+    FILE *file = fopen(filename, "w");
+    if (file == NULL)
+        return 0;
+    
+    *isValidTrace = printTraceAsQASM(file, reader);
     fclose(file);
     return 1;
 }
@@ -1,7 +1,7 @@
 // Distributed under MIT licence. See https://github.com/QuEST-Kit/QuEST/blob/master/LICENCE.txt for details
 
 /** @file
- * Functions for generating QASM output from QuEST circuits
+ * Functions for recording the operations upon a Qureg as a binary trace, and generating QASM output from it
  *
  * @author Tyson Jones
  */
@@ -12,6 +12,12 @@
 # include "QuEST.h"
 # include "QuEST_precision.h"
 
+# include <stdio.h>
+# include <stdint.h>
+
+/** maximum length (#chars, including terminal) of an error message reported by the QASM parser */
+# define QASM_MAX_ERR_LEN 200
+
 # ifdef __cplusplus
 extern "C" {
 # endif
@@ -34,6 +40,67 @@ typedef enum {
     GATE_SQRT_SWAP
 } TargetGate;
 
+/**! Identifiers of the operations recorded in the binary trace of a QASM logger */
+typedef enum {
+    TRACE_GATE,                     // a (multi-)controlled TargetGate with at most one parameter
+    TRACE_UNITARY,                  // a (multi-)controlled ComplexMatrix2
+    TRACE_STATE_CONTROLLED_UNITARY, // a ComplexMatrix2 conditioned upon the states of its controls
+    TRACE_COMPACT_UNITARY,          // a (controlled) unitary of the given alpha and beta
+    TRACE_AXIS_ROTATION,            // a (controlled) rotation around an axis
+    TRACE_MEASUREMENT,
+    TRACE_INIT_ZERO,
+    TRACE_INIT_PLUS,
+    TRACE_INIT_CLASSICAL,
+    TRACE_COMMENT
+} TraceOp;
+
+/** maximum number of control qubits of a recorded operation */
+# define MAX_TRACE_CONTROLS 63
+
+/** maximum length (#chars, excluding terminal) of a recorded comment */
+# define MAX_TRACE_COMMENT_LEN 194
+
+/** A decoded record of the binary trace, where params holds the single parameter of a TRACE_GATE,
+ * the real then imaginary components (row-major) of the matrix of a unitary, alpha then beta of a
+ * compact unitary, or the angle then axis of a rotation
+ */
+typedef struct {
+    TraceOp op;
+    TargetGate gate;
+    int target;
+    int outcome;
+    int numControls;
+    int controls[MAX_TRACE_CONTROLS];
+    int controlState[MAX_TRACE_CONTROLS];
+    int numParams;
+    qreal params[8];
+    long long int stateInd;
+    char comment[MAX_TRACE_COMMENT_LEN + 1];
+} TraceRecord;
+
+# define TRACE_MAGIC "QuESTTRC"
+# define TRACE_VERSION 1
+
+/** The header of a binary trace file, which is followed by numBytes of records */
+typedef struct {
+    char magic[8];
+    int32_t version;
+    int32_t numBytesPerReal;
+    int32_t numQubits;
+    int32_t isDensityMatrix;
+    int64_t numBytes;
+} TraceHeader;
+
+/** A reader of the records of the trace recorded by a Qureg, or of a trace file */
+typedef struct {
+    FILE* file;
+    char* buffer;
+    long long int bufferFill;
+    long long int pos;
+    long long int numFileBytesLeft;
+    TraceHeader header;
+} TraceReader;
+
 void qasm_setup(Qureg* qureg);
 
 void qasm_startRecording(Qureg qureg);
@@ -73,7 +140,7 @@ void qasm_recordMultiStateControlledUnitary(Qureg qureg, ComplexMatrix2 u, int*
 void qasm_recordMultiControlledAxisRotation(Qureg qureg, qreal angle, Vector axis, int* controlQubits, const int numControlQubits, const int targetQubit);\
 */
 
-void qasm_recordMeasurement(Qureg qureg, const int measureQubit);
+void qasm_recordMeasurement(Qureg qureg, const int measureQubit, const int outcome);
 
 void qasm_recordInitZero(Qureg qureg);
 
@@ -89,8 +156,24 @@ void qasm_printRecorded(Qureg qureg);
 
 int qasm_writeRecordedToFile(Qureg qureg, char* filename);
 
+int qasm_writeRecordedTraceToFile(Qureg qureg, char* filename);
+
+int qasm_openTraceFile(char* filename, TraceReader* reader);
+
+int qasm_isValidTraceHeader(TraceHeader header);
+
+int qasm_readTraceRecord(TraceReader* reader, TraceRecord* rec);
+
+void qasm_closeTraceFile(TraceReader* reader);
+
+int qasm_writeTraceFileAsQASM(TraceReader* reader, char* filename, int* isValidTrace);
+
 void qasm_free(Qureg qureg);
 
+int qasm_parseFile(char* filename, Qureg* qureg, Circuit* circ, char* errMsg);
+
+int qasm_parseString(char* qasm, Qureg* qureg, Circuit* circ, char* errMsg);
+
 # ifdef __cplusplus
 }
 # endif
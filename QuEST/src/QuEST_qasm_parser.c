@@ -0,0 +1,1184 @@
+// Distributed under MIT licence. See https://github.com/QuEST-Kit/QuEST/blob/master/LICENCE.txt for details
+
+/** @file
+ * A streaming parser of OpenQASM 2.0, which reads a circuit into a Circuit, or applies it directly
+ * to a Qureg. Files are read through a fixed-size buffer and parsed one statement at a time, so are
+ * never held whole in memory. Gates applied directly to a register are collected into a batch
+ * Circuit, which is applied (and so compiled, fusing runs of one-qubit gates) whenever it fills,
+ * and before every measurement, reset or classically-conditioned statement.
+ *
+ * The gates of qelib1.inc (and the labels of QuEST's own QASM output, like Rz and cRx) which have a
+ * Circuit equivalent are mapped directly to it. The remainder (like ccx) are expanded through their
+ * qelib1.inc definitions, as are user-defined gates, whose parameter expressions are compiled to a
+ * small stack-machine code when defined, and evaluated upon every use. Following QuEST (and current
+ * convention), rz is the rotation exp(-i theta Z/2), which differs from u1 by a global phase.
+ */
+
+# include "QuEST.h"
+# include "QuEST_precision.h"
+# include "QuEST_internal.h"
+# include "QuEST_qasm.h"
+# include "QuEST_circuit.h"
+
+# include <math.h>
+# include <stdio.h>
+# include <stdlib.h>
+# include <stdarg.h>
+# include <string.h>
+
+# define READ_BUF_SIZE (1 << 20)    // number of chars read from a file at a time
+# define MAX_TOKEN_LEN 64           // maximum length (#chars) of an identifier, number or string
+# define MAX_GATE_ARGS 16           // maximum number of qubits and of parameters of a single gate
+# define MAX_EXPR_DEPTH 32          // maximum number of operands a parameter expression holds at once
+# define MAX_INCLUDE_DEPTH 8        // maximum nesting of included files
+# define BATCH_SIZE 4096            // number of gates collected before being applied to a register
+# define TABLE_INIT_SIZE 256        // initial size of the gate name hash table (a power of 2)
+# define QASM_PI 3.14159265358979323846264338327950288
+
+/** Gate codes, beyond those of enum circuitGateType, of gates which are not mapped to a Circuit gate */
+enum qasmGateKind {
+    QASM_DEFINED_GATE=-1,   // expanded through its definition
+    QASM_IDENTITY_GATE=-2,  // has no effect
+    QASM_OPAQUE_GATE=-3     // declared opaque, so cannot be simulated
+};
+
+/** The gates (beyond U and CX) with a Circuit equivalent, where those of more parameters than
+ * their declaration (e.g. sdg) effect their Circuit gate with parameter fixedParam
+ */
+typedef struct {
+    char* name;
+    int type;
+    int numParams;
+    int numQubits;
+    qreal fixedParam;
+} NativeGate;
+
+static const NativeGate nativeGates[] = {
+    {"U",   CIRCUIT_U3, 3, 1, 0},
+    {"CX",  CIRCUIT_CONTROLLED_NOT, 0, 2, 0},
+    {"u3",  CIRCUIT_U3, 3, 1, 0},
+    {"u2",  CIRCUIT_U2, 2, 1, 0},
+    {"u1",  CIRCUIT_U1, 1, 1, 0},
+    {"p",   CIRCUIT_PHASE_SHIFT, 1, 1, 0},
+    {"u0",  QASM_IDENTITY_GATE, 1, 1, 0},
+    {"id",  QASM_IDENTITY_GATE, 0, 1, 0},
+    {"x",   CIRCUIT_PAULI_X, 0, 1, 0},
+    {"y",   CIRCUIT_PAULI_Y, 0, 1, 0},
+    {"z",   CIRCUIT_PAULI_Z, 0, 1, 0},
+    {"h",   CIRCUIT_HADAMARD, 0, 1, 0},
+    {"s",   CIRCUIT_S_GATE, 0, 1, 0},
+    {"sdg", CIRCUIT_PHASE_SHIFT, 0, 1, - QASM_PI/2},
+    {"t",   CIRCUIT_T_GATE, 0, 1, 0},
+    {"tdg", CIRCUIT_PHASE_SHIFT, 0, 1, - QASM_PI/4},
+    {"rx",  CIRCUIT_ROTATE_X, 1, 1, 0},
+    {"ry",  CIRCUIT_ROTATE_Y, 1, 1, 0},
+    {"rz",  CIRCUIT_ROTATE_Z, 1, 1, 0},
+    {"Rx",  CIRCUIT_ROTATE_X, 1, 1, 0},
+    {"Ry",  CIRCUIT_ROTATE_Y, 1, 1, 0},
+    {"Rz",  CIRCUIT_ROTATE_Z, 1, 1, 0},
+    {"cx",  CIRCUIT_CONTROLLED_NOT, 0, 2, 0},
+    {"cy",  CIRCUIT_CONTROLLED_PAULI_Y, 0, 2, 0},
+    {"cz",  CIRCUIT_CONTROLLED_PHASE_FLIP, 0, 2, 0},
+    {"crx", CIRCUIT_CONTROLLED_ROTATE_X, 1, 2, 0},
+    {"cry", CIRCUIT_CONTROLLED_ROTATE_Y, 1, 2, 0},
+    {"crz", CIRCUIT_CONTROLLED_ROTATE_Z, 1, 2, 0},
+    {"cRx", CIRCUIT_CONTROLLED_ROTATE_X, 1, 2, 0},
+    {"cRy", CIRCUIT_CONTROLLED_ROTATE_Y, 1, 2, 0},
+    {"cRz", CIRCUIT_CONTROLLED_ROTATE_Z, 1, 2, 0},
+    {"cu1", CIRCUIT_CONTROLLED_PHASE_SHIFT, 1, 2, 0},
+    {"cp",  CIRCUIT_CONTROLLED_PHASE_SHIFT, 1, 2, 0},
+    {"swap", CIRCUIT_SWAP, 0, 2, 0}
+};
+
+/** The gates of qelib1.inc without a Circuit equivalent, as defined there (except ch, which is
+ * there defined only up to a global phase)
+ */
+static const char* definedGates =
+    "gate cu3(theta,phi,lambda) c,t { u1((lambda+phi)/2) c; u1((lambda-phi)/2) t; cx c,t; "
+        "u3(-theta/2,0,-(phi+lambda)/2) t; cx c,t; u3(theta/2,phi,0) t; }\n"
+    "gate ch a,b { s b; h b; t b; cx a,b; tdg b; h b; sdg b; }\n"
+    "gate ccx a,b,c { h c; cx b,c; tdg c; cx a,c; t c; cx b,c; tdg c; cx a,c; t b; t c; h c; "
+        "cx a,b; t a; tdg b; cx a,b; }\n"
+    "gate cswap a,b,c { cx c,b; ccx a,b,c; cx c,b; }\n"
+    "gate rzz(theta) a,b { cx a,b; u1(theta) b; cx a,b; }\n";
+
+enum tokenType {TOKEN_END, TOKEN_ID, TOKEN_NUM, TOKEN_STRING, TOKEN_SYMBOL};
+
+typedef struct {
+    int type;
+    char text[MAX_TOKEN_LEN + 1];
+    qreal value;
+} Token;
+
+/** A file, read through a buffer, or a string */
+typedef struct {
+    FILE* file;
+    char* buf;
+    size_t len;
+    size_t pos;
+    int line;
+} Source;
+
+enum exprOp {
+    EXPR_END, EXPR_NUM, EXPR_PARAM, EXPR_NEG, EXPR_ADD, EXPR_SUB, EXPR_MUL, EXPR_DIV, EXPR_POW,
+    EXPR_SIN, EXPR_COS, EXPR_TAN, EXPR_EXP, EXPR_LN, EXPR_SQRT
+};
+
+static const char* exprFuncNames[] = {
+    [EXPR_SIN] = "sin", [EXPR_COS] = "cos", [EXPR_TAN] = "tan",
+    [EXPR_EXP] = "exp", [EXPR_LN] = "ln", [EXPR_SQRT] = "sqrt"
+};
+
+/** An instruction of compiled parameter expression code; value is a number, or the index of a parameter */
+typedef struct {
+    int op;
+    qreal value;
+} ExprInstr;
+
+/** A use of a gate within the body of a gate definition, upon the definition's qubit arguments */
+typedef struct {
+    int defInd;
+    int qubitArgs[MAX_GATE_ARGS];
+    int paramCode[MAX_GATE_ARGS];   // the start of the code of each parameter expression
+} GateCall;
+
+typedef struct {
+    char name[MAX_TOKEN_LEN + 1];
+    int type;           // an enum circuitGateType, or enum qasmGateKind
+    qreal fixedParam;
+    int numParams;
+    int numQubits;
+    int firstCall;      // the calls of the body of a QASM_DEFINED_GATE
+    int numCalls;
+} GateDef;
+
+typedef struct {
+    char name[MAX_TOKEN_LEN + 1];
+    int isQuantum;
+    int offset;         // index of the register's first qubit (or bit) among all those declared
+    int size;
+} Register;
+
+/** A qubit (or bit) argument, being either a whole register (index -1) or a single element */
+typedef struct {
+    int regInd;
+    int index;
+} RegArg;
+
+typedef struct {
+
+    Source* src;
+    Token tok;
+    int includeDepth;
+
+    Register* regs;
+    int numRegs;
+    int regsCap;
+    int numQubits;
+    int numBits;
+    int* bits;          // the outcomes of measurements
+
+    GateDef* defs;
+    int numDefs;
+    int defsCap;
+    int* table;         // hash table of indices into defs, with -1 marking empty slots
+    int tableSize;
+    GateCall* calls;
+    int numCalls;
+    int callsCap;
+    ExprInstr* code;
+    int codeLen;
+    int codeCap;
+
+    Qureg* qureg;       // the register to which gates are applied, else NULL
+    Circuit circ;       // the circuit being read, or the batch of gates yet to be applied to qureg
+    int hasCirc;
+    int isSkipping;     // whether statements are parsed but not effected (by a false if)
+
+    char* errMsg;
+    int isError;
+
+} Parser;
+
+static void parserAllocError(void) {
+    printf("!!!\nINTERNAL ERROR: Could not allocate memory for QASM parser!\n!!!");
+    exit(1);
+}
+
+/** grows *arr (of elements of elemSize) to fit at least minCap, doubling its capacity *cap */
+static void growArray(void** arr, int* cap, int minCap, size_t elemSize) {
+    if (minCap <= *cap)
+        return;
+    int newCap = (*cap > 0)? *cap : 16;
+    while (newCap < minCap)
+        newCap *= 2;
+    void* newArr = realloc(*arr, newCap * elemSize);
+    if (newArr == NULL)
+        parserAllocError();
+    *arr = newArr;
+    *cap = newCap;
+}
+
+/** records the first error (with the current line) and returns 0, so that callers can return it */
+static int setError(Parser* p, char* format, ...) {
+    if (p->isError)
+        return 0;
+
+    va_list argp;
+    va_start(argp, format);
+    int len = vsnprintf(p->errMsg, QASM_MAX_ERR_LEN, format, argp);
+    va_end(argp);
+    if (len < QASM_MAX_ERR_LEN)
+        snprintf(p->errMsg + len, QASM_MAX_ERR_LEN - len, " (line %d)", p->src->line);
+    p->isError = 1;
+    return 0;
+}
+
+
+/*
+ * lexing
+ */
+
+static int peekChar(Source* src) {
+    if (src->pos == src->len) {
+        if (src->file == NULL)
+            return EOF;
+        src->len = fread(src->buf, 1, READ_BUF_SIZE, src->file);
+        src->pos = 0;
+        if (src->len == 0)
+            return EOF;
+    }
+    return (unsigned char) src->buf[src->pos];
+}
+
+static int nextChar(Source* src) {
+    int c = peekChar(src);
+    if (c != EOF) {
+        src->pos++;
+        if (c == '\n')
+            src->line++;
+    }
+    return c;
+}
+
+static int isIdChar(int c, int isFirst) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_' || (!isFirst && c >= '0' && c <= '9');
+}
+
+static int isNumChar(int c) {
+    return (c >= '0' && c <= '9') || c == '.';
+}
+
+/** reads the next token into p->tok, returning 0 upon a lexical error */
+static int advance(Parser* p) {
+
+    Source* src = p->src;
+    Token* tok = &p->tok;
+    int c;
+
+    // skip whitespace and comments
+    while (1) {
+        c = peekChar(src);
+        if (c == ' ' || c == '\t' || c == '\r' || c == '\n')
+            nextChar(src);
+        else if (c == '/') {
+            // a lone slash is a division
+            nextChar(src);
+            if (peekChar(src) != '/') {
+                tok->type = TOKEN_SYMBOL;
+                strcpy(tok->text, "/");
+                return 1;
+            }
+            while (c != '\n' && c != EOF)
+                c = nextChar(src);
+        }
+        else
+            break;
+    }
+
+    int len = 0;
+    if (c == EOF) {
+        tok->type = TOKEN_END;
+        len = 0;
+    }
+    else if (isIdChar(c, 1)) {
+        tok->type = TOKEN_ID;
+        while (isIdChar(peekChar(src), 0) && len < MAX_TOKEN_LEN)
+            tok->text[len++] = nextChar(src);
+    }
+    else if (isNumChar(c)) {
+        tok->type = TOKEN_NUM;
+        while (len < MAX_TOKEN_LEN) {
+            c = peekChar(src);
+            int isExpSign = (c == '+' || c == '-') && len > 0 && (tok->text[len-1] == 'e' || tok->text[len-1] == 'E');
+            if (!isNumChar(c) && c != 'e' && c != 'E' && !isExpSign)
+                break;
+            tok->text[len++] = nextChar(src);
+        }
+    }
+    else if (c == '"') {
+        tok->type = TOKEN_STRING;
+        nextChar(src);
+        while ((c = nextChar(src)) != '"' && len < MAX_TOKEN_LEN) {
+            if (c == EOF || c == '\n')
+                return setError(p, "Unterminated string.");
+            tok->text[len++] = c;
+        }
+    }
+    else {
+        tok->type = TOKEN_SYMBOL;
+        tok->text[len++] = nextChar(src);
+        if ((c == '-' && peekChar(src) == '>') || (c == '=' && peekChar(src) == '='))
+            tok->text[len++] = nextChar(src);
+    }
+
+    if (len == MAX_TOKEN_LEN)
+        return setError(p, "Token longer than %d characters.", MAX_TOKEN_LEN);
+    tok->text[len] = '\0';
+
+    if (tok->type == TOKEN_NUM) {
+        char* end;
+        tok->value = strtod(tok->text, &end);
+        if (*end != '\0')
+            return setError(p, "Invalid number '%s'.", tok->text);
+    }
+    return 1;
+}
+
+static int isSymbol(Parser* p, char* symbol) {
+    return p->tok.type == TOKEN_SYMBOL && strcmp(p->tok.text, symbol) == 0;
+}
+
+static int isKeyword(Parser* p, char* keyword) {
+    return p->tok.type == TOKEN_ID && strcmp(p->tok.text, keyword) == 0;
+}
+
+static int expectSymbol(Parser* p, char* symbol) {
+    if (!isSymbol(p, symbol))
+        return setError(p, "Expected '%s' but found '%s'.", symbol, p->tok.text);
+    return advance(p);
+}
+
+/** copies the current identifier into name, and advances */
+static int expectId(Parser* p, char* name) {
+    if (p->tok.type != TOKEN_ID)
+        return setError(p, "Expected an identifier but found '%s'.", p->tok.text);
+    strcpy(name, p->tok.text);
+    return advance(p);
+}
+
+/** reads the current non-negative integer into num, and advances */
+static int expectInt(Parser* p, int* num) {
+    if (p->tok.type != TOKEN_NUM || p->tok.value != floor(p->tok.value) || p->tok.value > 1E9)
+        return setError(p, "Expected a non-negative integer but found '%s'.", p->tok.text);
+    *num = (int) p->tok.value;
+    return advance(p);
+}
+
+
+/*
+ * gate definitions
+ */
+
+static unsigned int hashName(char* name) {
+    unsigned int hash = 2166136261u;
+    for (; *name != '\0'; name++)
+        hash = (hash ^ (unsigned char) *name) * 16777619u;
+    return hash;
+}
+
+/** returns the slot of name in the hash table; either that of its definition, or an empty slot */
+static int getTableSlot(Parser* p, char* name) {
+    unsigned int mask = p->tableSize - 1;
+    unsigned int slot = hashName(name) & mask;
+    while (p->table[slot] >= 0 && strcmp(p->defs[p->table[slot]].name, name) != 0)
+        slot = (slot + 1) & mask;
+    return slot;
+}
+
+static int getGateDefInd(Parser* p, char* name) {
+    return p->table[getTableSlot(p, name)];
+}
+
+/** adds (or redefines) a gate, returning its index in p->defs */
+static int addGateDef(Parser* p, char* name, int type, int numParams, int numQubits) {
+
+    growArray((void**) &p->defs, &p->defsCap, p->numDefs + 1, sizeof *(p->defs));
+
+    // keep the table at most half full, rehashing every definition when grown
+    if (2*(p->numDefs + 1) > p->tableSize) {
+        free(p->table);
+        p->tableSize = (p->tableSize > 0)? 2*p->tableSize : TABLE_INIT_SIZE;
+        p->table = malloc(p->tableSize * sizeof *(p->table));
+        if (p->table == NULL)
+            parserAllocError();
+        for (int i=0; i<p->tableSize; i++)
+            p->table[i] = -1;
+        for (int d=0; d<p->numDefs; d++)
+            p->table[getTableSlot(p, p->defs[d].name)] = d;
+    }
+
+    // earlier uses of a redefined gate retain its previous definition
+    int defInd = p->numDefs++;
+    GateDef* def = &(p->defs[defInd]);
+    strcpy(def->name, name);
+    def->type = type;
+    def->fixedParam = 0;
+    def->numParams = numParams;
+    def->numQubits = numQubits;
+    def->firstCall = p->numCalls;
+    def->numCalls = 0;
+    p->table[getTableSlot(p, name)] = defInd;
+    return defInd;
+}
+
+/** returns the index of name among names, else -1 */
+static int getNameInd(char names[][MAX_TOKEN_LEN + 1], int numNames, char* name) {
+    for (int i=0; i<numNames; i++)
+        if (strcmp(names[i], name) == 0)
+            return i;
+    return -1;
+}
+
+static void addExprInstr(Parser* p, int op, qreal value) {
+    growArray((void**) &p->code, &p->codeCap, p->codeLen + 1, sizeof *(p->code));
+    p->code[p->codeLen].op = op;
+    p->code[p->codeLen].value = value;
+    p->codeLen++;
+}
+
+static int compileSum(Parser* p, char paramNames[][MAX_TOKEN_LEN + 1], int numParams, int* depth);
+
+/** compiles a number, constant, parameter, function call or bracketed expression */
+static int compileOperand(Parser* p, char paramNames[][MAX_TOKEN_LEN + 1], int numParams, int* depth) {
+
+    if (isSymbol(p, "-")) {
+        if (!advance(p) || !compileOperand(p, paramNames, numParams, depth))
+            return 0;
+        addExprInstr(p, EXPR_NEG, 0);
+        return 1;
+    }
+    if (isSymbol(p, "(")) {
+        return advance(p) && compileSum(p, paramNames, numParams, depth) && expectSymbol(p, ")");
+    }
+
+    if (++(*depth) > MAX_EXPR_DEPTH)
+        return setError(p, "Parameter expression is too deeply nested.");
+
+    if (p->tok.type == TOKEN_NUM) {
+        addExprInstr(p, EXPR_NUM, p->tok.value);
+        return advance(p);
+    }
+    if (p->tok.type != TOKEN_ID)
+        return setError(p, "Expected a parameter expression but found '%s'.", p->tok.text);
+
+    if (isKeyword(p, "pi")) {
+        addExprInstr(p, EXPR_NUM, QASM_PI);
+        return advance(p);
+    }
+    int paramInd = getNameInd(paramNames, numParams, p->tok.text);
+    if (paramInd >= 0) {
+        addExprInstr(p, EXPR_PARAM, paramInd);
+        return advance(p);
+    }
+    for (int op=EXPR_SIN; op<=EXPR_SQRT; op++)
+        if (isKeyword(p, (char*) exprFuncNames[op])) {
+            (*depth)--;
+            int isCompiled = advance(p) && expectSymbol(p, "(")
+                && compileSum(p, paramNames, numParams, depth) && expectSymbol(p, ")");
+            addExprInstr(p, op, 0);
+            return isCompiled;
+        }
+    return setError(p, "Unknown parameter '%s'.", p->tok.text);
+}
+
+/** compiles a right-associative power of operands */
+static int compilePower(Parser* p, char paramNames[][MAX_TOKEN_LEN + 1], int numParams, int* depth) {
+    if (!compileOperand(p, paramNames, numParams, depth))
+        return 0;
+    if (!isSymbol(p, "^"))
+        return 1;
+    if (!advance(p) || !compilePower(p, paramNames, numParams, depth))
+        return 0;
+    addExprInstr(p, EXPR_POW, 0);
+    (*depth)--;
+    return 1;
+}
+
+static int compileProduct(Parser* p, char paramNames[][MAX_TOKEN_LEN + 1], int numParams, int* depth) {
+    if (!compilePower(p, paramNames, numParams, depth))
+        return 0;
+    while (isSymbol(p, "*") || isSymbol(p, "/")) {
+        int op = isSymbol(p, "*")? EXPR_MUL : EXPR_DIV;
+        if (!advance(p) || !compilePower(p, paramNames, numParams, depth))
+            return 0;
+        addExprInstr(p, op, 0);
+        (*depth)--;
+    }
+    return 1;
+}
+
+static int compileSum(Parser* p, char paramNames[][MAX_TOKEN_LEN + 1], int numParams, int* depth) {
+    if (!compileProduct(p, paramNames, numParams, depth))
+        return 0;
+    while (isSymbol(p, "+") || isSymbol(p, "-")) {
+        int op = isSymbol(p, "+")? EXPR_ADD : EXPR_SUB;
+        if (!advance(p) || !compileProduct(p, paramNames, numParams, depth))
+            return 0;
+        addExprInstr(p, op, 0);
+        (*depth)--;
+    }
+    return 1;
+}
+
+/** compiles a parameter expression (terminated by EXPR_END), setting start to the index of its code */
+static int compileExpr(Parser* p, char paramNames[][MAX_TOKEN_LEN + 1], int numParams, int* start) {
+    int depth = 0;
+    *start = p->codeLen;
+    if (!compileSum(p, paramNames, numParams, &depth))
+        return 0;
+    addExprInstr(p, EXPR_END, 0);
+    return 1;
+}
+
+static qreal evalExpr(Parser* p, int start, qreal* params) {
+
+    qreal stack[MAX_EXPR_DEPTH];
+    int top = 0;
+
+    for (ExprInstr* instr = &(p->code[start]); instr->op != EXPR_END; instr++) {
+        switch (instr->op) {
+            case EXPR_NUM:   stack[top++] = instr->value; break;
+            case EXPR_PARAM: stack[top++] = params[(int) instr->value]; break;
+            case EXPR_NEG:   stack[top-1] = - stack[top-1]; break;
+            case EXPR_ADD:   top--; stack[top-1] += stack[top]; break;
+            case EXPR_SUB:   top--; stack[top-1] -= stack[top]; break;
+            case EXPR_MUL:   top--; stack[top-1] *= stack[top]; break;
+            case EXPR_DIV:   top--; stack[top-1] /= stack[top]; break;
+            case EXPR_POW:   top--; stack[top-1] = pow(stack[top-1], stack[top]); break;
+            case EXPR_SIN:   stack[top-1] = sin(stack[top-1]); break;
+            case EXPR_COS:   stack[top-1] = cos(stack[top-1]); break;
+            case EXPR_TAN:   stack[top-1] = tan(stack[top-1]); break;
+            case EXPR_EXP:   stack[top-1] = exp(stack[top-1]); break;
+            case EXPR_LN:    stack[top-1] = log(stack[top-1]); break;
+            case EXPR_SQRT:  stack[top-1] = sqrt(stack[top-1]); break;
+        }
+    }
+    return stack[0];
+}
+
+/** parses a comma-separated list of identifiers into names, until (but excluding) the terminator */
+static int parseNameList(Parser* p, char names[][MAX_TOKEN_LEN + 1], int* numNames, char* terminator) {
+    *numNames = 0;
+    while (!isSymbol(p, terminator)) {
+        if (*numNames == MAX_GATE_ARGS)
+            return setError(p, "Gates may have at most %d qubits and %d parameters.", MAX_GATE_ARGS, MAX_GATE_ARGS);
+        if (*numNames > 0 && !expectSymbol(p, ","))
+            return 0;
+        if (!expectId(p, names[*numNames]))
+            return 0;
+        if (getNameInd(names, *numNames, names[*numNames]) >= 0)
+            return setError(p, "Repeated argument '%s'.", names[*numNames]);
+        (*numNames)++;
+    }
+    return 1;
+}
+
+/** parses the remainder of "gate name(params) qubits { body }" after the keyword */
+static int parseGateDefinition(Parser* p) {
+
+    char name[MAX_TOKEN_LEN + 1];
+    char paramNames[MAX_GATE_ARGS][MAX_TOKEN_LEN + 1];
+    char qubitNames[MAX_GATE_ARGS][MAX_TOKEN_LEN + 1];
+    int numParams = 0;
+    int numQubits = 0;
+
+    if (!expectId(p, name))
+        return 0;
+    if (isSymbol(p, "(") && !(advance(p) && parseNameList(p, paramNames, &numParams, ")") && advance(p)))
+        return 0;
+    if (!parseNameList(p, qubitNames, &numQubits, "{") || !advance(p))
+        return 0;
+    if (numQubits == 0)
+        return setError(p, "Gate '%s' acts upon no qubits.", name);
+
+    // the body is compiled before the gate is added, so cannot refer to itself
+    int firstCall = p->numCalls;
+
+    while (!isSymbol(p, "}")) {
+        char callName[MAX_TOKEN_LEN + 1];
+        if (!expectId(p, callName))
+            return 0;
+
+        // barriers within gates are ignored
+        if (strcmp(callName, "barrier") == 0) {
+            while (!isSymbol(p, ";"))
+                if (p->tok.type == TOKEN_END || !advance(p))
+                    return setError(p, "Unterminated barrier.");
+            if (!advance(p))
+                return 0;
+            continue;
+        }
+
+        int defInd = getGateDefInd(p, callName);
+        if (defInd < 0)
+            return setError(p, "Unknown gate '%s'.", callName);
+
+        growArray((void**) &p->calls, &p->callsCap, p->numCalls + 1, sizeof *(p->calls));
+        GateCall* call = &(p->calls[p->numCalls]);
+        call->defInd = defInd;
+        GateDef callee = p->defs[defInd];
+
+        int numCallParams = 0;
+        if (isSymbol(p, "(")) {
+            if (!advance(p))
+                return 0;
+            while (!isSymbol(p, ")")) {
+                if (numCallParams == callee.numParams)
+                    return setError(p, "Gate '%s' takes %d parameter(s).", callee.name, callee.numParams);
+                if (numCallParams > 0 && !expectSymbol(p, ","))
+                    return 0;
+                if (!compileExpr(p, paramNames, numParams, &call->paramCode[numCallParams++]))
+                    return 0;
+            }
+            if (!advance(p))
+                return 0;
+        }
+        if (numCallParams != callee.numParams)
+            return setError(p, "Gate '%s' takes %d parameter(s).", callee.name, callee.numParams);
+
+        for (int q=0; q<callee.numQubits; q++) {
+            char argName[MAX_TOKEN_LEN + 1];
+            if ((q > 0 && !expectSymbol(p, ",")) || !expectId(p, argName))
+                return 0;
+            call->qubitArgs[q] = getNameInd(qubitNames, numQubits, argName);
+            if (call->qubitArgs[q] < 0)
+                return setError(p, "Unknown qubit '%s' of gate '%s'.", argName, name);
+            for (int r=0; r<q; r++)
+                if (call->qubitArgs[r] == call->qubitArgs[q])
+                    return setError(p, "Gate '%s' is applied to repeated qubit '%s'.", callee.name, argName);
+        }
+        if (!expectSymbol(p, ";"))
+            return 0;
+        p->numCalls++;
+    }
+    if (!advance(p))
+        return 0;
+
+    int defInd = addGateDef(p, name, QASM_DEFINED_GATE, numParams, numQubits);
+    p->defs[defInd].firstCall = firstCall;
+    p->defs[defInd].numCalls = p->numCalls - firstCall;
+    return 1;
+}
+
+/** parses "opaque name(params) qubits;" after the keyword, declaring a gate which cannot be applied */
+static int parseOpaqueDeclaration(Parser* p) {
+
+    char name[MAX_TOKEN_LEN + 1];
+    char names[MAX_GATE_ARGS][MAX_TOKEN_LEN + 1];
+    int numParams = 0;
+    int numQubits = 0;
+
+    if (!expectId(p, name))
+        return 0;
+    if (isSymbol(p, "(") && !(advance(p) && parseNameList(p, names, &numParams, ")") && advance(p)))
+        return 0;
+    if (!parseNameList(p, names, &numQubits, ";") || !advance(p))
+        return 0;
+
+    addGateDef(p, name, QASM_OPAQUE_GATE, numParams, numQubits);
+    return 1;
+}
+
+
+/*
+ * effecting statements
+ */
+
+/** applies (and empties) the batch of gates yet to be applied to the register */
+static void flushBatch(Parser* p) {
+    if (p->qureg == NULL || p->circ.gateList->numGates == 0)
+        return;
+    circuit_apply(*(p->qureg), p->circ);
+    circuit_clear(p->circ);
+}
+
+/** adds a gate with a Circuit equivalent to the circuit, or to the batch applied to the register */
+static int addGate(Parser* p, GateDef* def, qreal* params, int* qubits) {
+
+    if (def->type == QASM_IDENTITY_GATE)
+        return 1;
+    if (def->type == QASM_OPAQUE_GATE)
+        return setError(p, "Opaque gate '%s' cannot be simulated.", def->name);
+
+    // the circuit being read is only created upon its first gate, once its size is known
+    if (!p->hasCirc) {
+        p->circ = circuit_create(p->numQubits, 0);
+        p->hasCirc = 1;
+    }
+    if (p->qureg != NULL && p->circ.gateList->numGates == BATCH_SIZE)
+        flushBatch(p);
+
+    qreal gateParams[3] = {def->fixedParam, 0, 0};
+    for (int i=0; i<def->numParams && i<3; i++)
+        gateParams[i] = params[i];
+    circuit_addGate(p->circ, def->type, qubits, gateParams, -1);
+
+    // gates are checked against the register as they are added, so that the error cites their line
+    int gateInd = p->circ.gateList->numGates - 1;
+    if (p->qureg != NULL && p->qureg->isReal && !circuit_isRealGate(p->circ, gateInd))
+        return setError(p, "Gate '%s' is not real, so cannot be applied to a real-amplitude register.", def->name);
+    if (p->qureg != NULL && p->qureg->isSubspace && !circuit_isNumberConservingGate(p->circ, gateInd))
+        return setError(p, "Gate '%s' does not conserve the number of ones, so cannot be applied to a fixed Hamming-weight register.", def->name);
+    return 1;
+}
+
+/** applies a gate with the given parameters to the given (distinct) qubits, expanding its definition */
+static int applyGate(Parser* p, int defInd, qreal* params, int* qubits) {
+
+    GateDef* def = &(p->defs[defInd]);
+    if (def->type != QASM_DEFINED_GATE)
+        return addGate(p, def, params, qubits);
+
+    for (int c=0; c<def->numCalls; c++) {
+        GateCall* call = &(p->calls[def->firstCall + c]);
+        GateDef* callee = &(p->defs[call->defInd]);
+
+        qreal callParams[MAX_GATE_ARGS];
+        int callQubits[MAX_GATE_ARGS];
+        for (int i=0; i<callee->numParams; i++)
+            callParams[i] = evalExpr(p, call->paramCode[i], params);
+        for (int i=0; i<callee->numQubits; i++)
+            callQubits[i] = qubits[call->qubitArgs[i]];
+
+        if (!applyGate(p, call->defInd, callParams, callQubits))
+            return 0;
+    }
+    return 1;
+}
+
+static int getRegInd(Parser* p, char* name, int isQuantum) {
+    for (int r=0; r<p->numRegs; r++)
+        if (p->regs[r].isQuantum == isQuantum && strcmp(p->regs[r].name, name) == 0)
+            return r;
+    return -1;
+}
+
+/** parses "name" or "name[index]" of a quantum (or classical) register */
+static int parseRegArg(Parser* p, RegArg* arg, int isQuantum) {
+
+    char name[MAX_TOKEN_LEN + 1];
+    if (!expectId(p, name))
+        return 0;
+    arg->regInd = getRegInd(p, name, isQuantum);
+    if (arg->regInd < 0)
+        return setError(p, "Unknown %s register '%s'.", (isQuantum)? "quantum":"classical", name);
+
+    arg->index = -1;
+    if (isSymbol(p, "[")) {
+        if (!advance(p) || !expectInt(p, &arg->index) || !expectSymbol(p, "]"))
+            return 0;
+        if (arg->index >= p->regs[arg->regInd].size)
+            return setError(p, "Index %d exceeds the size of register '%s'.", arg->index, name);
+    }
+    return 1;
+}
+
+/** returns the number of times a statement upon args is broadcast (being the size of every whole register
+ * among them, or 1), or 0 if the whole registers differ in size
+ */
+static int getBroadcastSize(Parser* p, RegArg* args, int numArgs) {
+    int size = 1;
+    int hasWhole = 0;
+    for (int a=0; a<numArgs; a++) {
+        if (args[a].index >= 0)
+            continue;
+        int regSize = p->regs[args[a].regInd].size;
+        if (hasWhole && regSize != size)
+            return 0;
+        size = regSize;
+        hasWhole = 1;
+    }
+    return size;
+}
+
+static int getArgElem(Parser* p, RegArg arg, int broadcastInd) {
+    return p->regs[arg.regInd].offset + ((arg.index >= 0)? arg.index : broadcastInd);
+}
+
+/** parses the remainder of a gate application "name(params) args;" after the name */
+static int parseGateApplication(Parser* p, char* name) {
+
+    int defInd = getGateDefInd(p, name);
+    if (defInd < 0)
+        return setError(p, "Unknown gate '%s'.", name);
+    GateDef def = p->defs[defInd];
+
+    // parameters are evaluated immediately, reusing the end of the code
+    qreal params[MAX_GATE_ARGS];
+    int numParams = 0;
+    int codeLen = p->codeLen;
+    if (isSymbol(p, "(")) {
+        if (!advance(p))
+            return 0;
+        while (!isSymbol(p, ")")) {
+            int start;
+            if (numParams == def.numParams)
+                return setError(p, "Gate '%s' takes %d parameter(s).", name, def.numParams);
+            if ((numParams > 0 && !expectSymbol(p, ",")) || !compileExpr(p, NULL, 0, &start))
+                return 0;
+            params[numParams++] = evalExpr(p, start, NULL);
+        }
+        if (!advance(p))
+            return 0;
+    }
+    p->codeLen = codeLen;
+    if (numParams != def.numParams)
+        return setError(p, "Gate '%s' takes %d parameter(s).", name, def.numParams);
+
+    RegArg args[MAX_GATE_ARGS];
+    for (int q=0; q<def.numQubits; q++)
+        if ((q > 0 && !expectSymbol(p, ",")) || !parseRegArg(p, &args[q], 1))
+            return 0;
+    if (!expectSymbol(p, ";"))
+        return 0;
+
+    int size = getBroadcastSize(p, args, def.numQubits);
+    if (size == 0)
+        return setError(p, "Gate '%s' is applied to registers of different sizes.", name);
+
+    for (int i=0; i<size; i++) {
+        int qubits[MAX_GATE_ARGS];
+        for (int q=0; q<def.numQubits; q++) {
+            qubits[q] = getArgElem(p, args[q], i);
+            for (int r=0; r<q; r++)
+                if (qubits[r] == qubits[q])
+                    return setError(p, "Gate '%s' is applied to a repeated qubit.", name);
+        }
+        if (!p->isSkipping && !applyGate(p, defInd, params, qubits))
+            return 0;
+    }
+    return 1;
+}
+
+/** checks that measurements and resets, which a Circuit cannot contain, can be applied to the register */
+static int checkNonUnitaryAllowed(Parser* p, char* statement) {
+    if (p->qureg == NULL)
+        return setError(p, "'%s' cannot be added to a Circuit; use applyQASMFile() instead.", statement);
+    if (p->qureg->isCompressed)
+        return setError(p, "'%s' cannot be applied to a compressed register.", statement);
+    return 1;
+}
+
+/** parses "measure qubits -> bits;" after the keyword */
+static int parseMeasurement(Parser* p) {
+
+    RegArg args[2];
+    if (!parseRegArg(p, &args[0], 1) || !expectSymbol(p, "->") || !parseRegArg(p, &args[1], 0) || !expectSymbol(p, ";"))
+        return 0;
+    if ((args[0].index < 0) != (args[1].index < 0) || getBroadcastSize(p, args, 2) == 0)
+        return setError(p, "A measurement's quantum and classical arguments differ in size.");
+    if (p->isSkipping)
+        return 1;
+    if (!checkNonUnitaryAllowed(p, "measure"))
+        return 0;
+
+    flushBatch(p);
+    Qureg qureg = *(p->qureg);
+    for (int i=0; i<getBroadcastSize(p, args, 2); i++) {
+        int qubit = getArgElem(p, args[0], i);
+        qreal prob;
+        int outcome = (qureg.isDensityMatrix)?
+            densmatr_measureWithStats(qureg, qubit, &prob) :
+            statevec_measureWithStats(qureg, qubit, &prob);
+        p->bits[getArgElem(p, args[1], i)] = outcome;
+        qasm_recordMeasurement(qureg, qubit, outcome);
+    }
+    return 1;
+}
+
+/** parses "reset qubits;" after the keyword */
+static int parseReset(Parser* p) {
+
+    RegArg arg;
+    if (!parseRegArg(p, &arg, 1) || !expectSymbol(p, ";"))
+        return 0;
+    if (p->isSkipping)
+        return 1;
+    if (!checkNonUnitaryAllowed(p, "reset"))
+        return 0;
+    if (p->qureg->isSubspace)
+        return setError(p, "'reset' cannot be applied to a fixed Hamming-weight register, whose qubits cannot be flipped singly.");
+
+    // a density matrix is reset by certain damping, and a state-vector by measuring (and flipping) the
+    // qubit, which is recorded as such so that the register's trace remains replayable
+    flushBatch(p);
+    Qureg qureg = *(p->qureg);
+    for (int i=0; i<getBroadcastSize(p, &arg, 1); i++) {
+        int qubit = getArgElem(p, arg, i);
+        if (qureg.isDensityMatrix) {
+            densmatr_mixDamping(qureg, qubit, 1);
+            qasm_recordComment(qureg, "Here, qubit %d was reset to |0>", qubit);
+            continue;
+        }
+        qreal prob;
+        int outcome = statevec_measureWithStats(qureg, qubit, &prob);
+        qasm_recordMeasurement(qureg, qubit, outcome);
+        if (outcome == 1) {
+            statevec_pauliX(qureg, qubit);
+            qasm_recordGate(qureg, GATE_SIGMA_X, qubit);
+        }
+    }
+    return 1;
+}
+
+/** parses "qreg name[size];" or "creg name[size];" after the keyword */
+static int parseRegDeclaration(Parser* p, int isQuantum) {
+
+    growArray((void**) &p->regs, &p->regsCap, p->numRegs + 1, sizeof *(p->regs));
+    Register* reg = &(p->regs[p->numRegs]);
+
+    if (!expectId(p, reg->name) || !expectSymbol(p, "[") || !expectInt(p, &reg->size) || !expectSymbol(p, "]") || !expectSymbol(p, ";"))
+        return 0;
+    if (reg->size == 0)
+        return setError(p, "Register '%s' has no elements.", reg->name);
+    if (getRegInd(p, reg->name, isQuantum) >= 0)
+        return setError(p, "Register '%s' is already declared.", reg->name);
+    reg->isQuantum = isQuantum;
+
+    if (isQuantum) {
+        if (p->hasCirc && p->qureg == NULL)
+            return setError(p, "Quantum registers must be declared before the first gate.");
+        if (p->qureg != NULL && p->numQubits + reg->size > p->qureg->numQubitsRepresented)
+            return setError(p, "The quantum registers hold more qubits than the Qureg (%d).", p->qureg->numQubitsRepresented);
+        reg->offset = p->numQubits;
+        p->numQubits += reg->size;
+    } else {
+        reg->offset = p->numBits;
+        p->numBits += reg->size;
+        p->bits = realloc(p->bits, p->numBits * sizeof *(p->bits));
+        if (p->bits == NULL)
+            parserAllocError();
+        for (int b=reg->offset; b<p->numBits; b++)
+            p->bits[b] = 0;
+    }
+    p->numRegs++;
+    return 1;
+}
+
+static int parseSource(Parser* p, Source* src);
+
+/** parses "include "filename";" after the keyword, parsing the included file (except qelib1.inc,
+ * whose gates are always defined)
+ */
+static int parseInclude(Parser* p) {
+
+    if (p->tok.type != TOKEN_STRING)
+        return setError(p, "Expected a filename but found '%s'.", p->tok.text);
+    char filename[MAX_TOKEN_LEN + 1];
+    strcpy(filename, p->tok.text);
+    if (!advance(p) || !expectSymbol(p, ";"))
+        return 0;
+    if (strcmp(filename, "qelib1.inc") == 0)
+        return 1;
+    if (p->includeDepth == MAX_INCLUDE_DEPTH)
+        return setError(p, "Files are included more than %d deep.", MAX_INCLUDE_DEPTH);
+
+    FILE* file = fopen(filename, "r");
+    if (file == NULL)
+        return setError(p, "Could not open included file '%s'.", filename);
+    char* buf = malloc(READ_BUF_SIZE);
+    if (buf == NULL)
+        parserAllocError();
+
+    // the included file is parsed in its entirety before the token after the include
+    Source src = {.file=file, .buf=buf, .len=0, .pos=0, .line=1};
+    Source* outerSrc = p->src;
+    Token outerTok = p->tok;
+    p->includeDepth++;
+    int isParsed = parseSource(p, &src);
+    p->includeDepth--;
+    p->src = outerSrc;
+    p->tok = outerTok;
+
+    fclose(file);
+    free(buf);
+    return isParsed;
+}
+
+static int parseStatement(Parser* p);
+
+/** parses "if (bits == value) statement" after the keyword */
+static int parseConditional(Parser* p) {
+
+    if (p->qureg == NULL)
+        return setError(p, "'if' cannot be added to a Circuit; use applyQASMFile() instead.");
+
+    RegArg arg;
+    int value;
+    if (!expectSymbol(p, "(") || !parseRegArg(p, &arg, 0) || !expectSymbol(p, "==") || !expectInt(p, &value) || !expectSymbol(p, ")"))
+        return 0;
+    if (arg.index >= 0)
+        return setError(p, "Conditions must compare a whole classical register.");
+
+    // the register's bits are little-endian
+    Register reg = p->regs[arg.regInd];
+    long long int regValue = 0;
+    for (int b=0; b<reg.size; b++)
+        regValue |= ((long long int) p->bits[reg.offset + b]) << b;
+
+    if (isKeyword(p, "if") || isKeyword(p, "gate") || isKeyword(p, "qreg") || isKeyword(p, "creg"))
+        return setError(p, "Only gates, measurements and resets can be conditioned.");
+
+    int wasSkipping = p->isSkipping;
+    p->isSkipping = wasSkipping || (regValue != value);
+    int isParsed = parseStatement(p);
+    p->isSkipping = wasSkipping;
+    return isParsed;
+}
+
+static int parseStatement(Parser* p) {
+
+    char keyword[MAX_TOKEN_LEN + 1];
+    if (!expectId(p, keyword))
+        return 0;
+
+    if (strcmp(keyword, "OPENQASM") == 0) {
+        if (p->tok.type != TOKEN_NUM || p->tok.value < 2 || p->tok.value >= 3)
+            return setError(p, "Only OpenQASM 2 is supported.");
+        return advance(p) && expectSymbol(p, ";");
+    }
+    if (strcmp(keyword, "include") == 0)
+        return parseInclude(p);
+    if (strcmp(keyword, "qreg") == 0)
+        return parseRegDeclaration(p, 1);
+    if (strcmp(keyword, "creg") == 0)
+        return parseRegDeclaration(p, 0);
+    if (strcmp(keyword, "gate") == 0)
+        return parseGateDefinition(p);
+    if (strcmp(keyword, "opaque") == 0)
+        return parseOpaqueDeclaration(p);
+    if (strcmp(keyword, "measure") == 0)
+        return parseMeasurement(p);
+    if (strcmp(keyword, "reset") == 0)
+        return parseReset(p);
+    if (strcmp(keyword, "if") == 0)
+        return parseConditional(p);
+    if (strcmp(keyword, "barrier") == 0) {
+        RegArg arg;
+        do {
+            if (!parseRegArg(p, &arg, 1))
+                return 0;
+        } while (isSymbol(p, ",") && advance(p));
+        return expectSymbol(p, ";");
+    }
+    return parseGateApplication(p, keyword);
+}
+
+/** parses every statement of src */
+static int parseSource(Parser* p, Source* src) {
+    p->src = src;
+    if (!advance(p))
+        return 0;
+    while (p->tok.type != TOKEN_END)
+        if (!parseStatement(p))
+            return 0;
+    return 1;
+}
+
+
+/*
+ * front-end
+ */
+
+static void initParser(Parser* p, Qureg* qureg, char* errMsg) {
+
+    *p = (Parser) {0};
+    p->qureg = qureg;
+    p->errMsg = errMsg;
+    errMsg[0] = '\0';
+
+    // gates applied to a register are batched in a circuit of its size
+    if (qureg != NULL) {
+        p->circ = circuit_create(qureg->numQubitsRepresented, 0);
+        p->hasCirc = 1;
+    }
+
+    int numNative = sizeof nativeGates / sizeof *nativeGates;
+    for (int g=0; g<numNative; g++) {
+        NativeGate gate = nativeGates[g];
+        int defInd = addGateDef(p, gate.name, gate.type, gate.numParams, gate.numQubits);
+        p->defs[defInd].fixedParam = gate.fixedParam;
+    }
+
+    Source src = {.file=NULL, .buf=(char*) definedGates, .len=strlen(definedGates), .pos=0, .line=1};
+    if (!parseSource(p, &src)) {
+        printf("!!!\nINTERNAL ERROR: Could not define the gates of qelib1.inc!\n!!!");
+        exit(1);
+    }
+}
+
+/** frees the parser, returning its circuit (if reading one), else applying its remaining gates */
+static Circuit finishParser(Parser* p, int isParsed) {
+
+    Circuit circ = p->circ;
+    if (isParsed && p->qureg != NULL)
+        flushBatch(p);
+    if (p->hasCirc && (!isParsed || p->qureg != NULL))
+        circuit_destroy(p->circ);
+
+    free(p->regs);
+    free(p->bits);
+    free(p->defs);
+    free(p->table);
+    free(p->calls);
+    free(p->code);
+    return circ;
+}
+
+/** parses src into a circuit (if qureg is NULL), else applying it to qureg */
+static int parseQASM(Source* src, Qureg* qureg, Circuit* circ, char* errMsg) {
+
+    Parser p;
+    initParser(&p, qureg, errMsg);
+    int isParsed = parseSource(&p, src);
+
+    if (isParsed && qureg == NULL && !p.hasCirc) {
+        if (p.numQubits == 0)
+            isParsed = setError(&p, "No quantum register is declared.");
+        else {
+            p.circ = circuit_create(p.numQubits, 0);
+            p.hasCirc = 1;
+        }
+    }
+
+    Circuit parsedCirc = finishParser(&p, isParsed);
+    if (circ != NULL && isParsed)
+        *circ = parsedCirc;
+    return isParsed;
+}
+
+int qasm_parseFile(char* filename, Qureg* qureg, Circuit* circ, char* errMsg) {
+
+    FILE* file = fopen(filename, "r");
+    if (file == NULL) {
+        snprintf(errMsg, QASM_MAX_ERR_LEN, "Could not open file '%s'.", filename);
+        return 0;
+    }
+    char* buf = malloc(READ_BUF_SIZE);
+    if (buf == NULL)
+        parserAllocError();
+
+    Source src = {.file=file, .buf=buf, .len=0, .pos=0, .line=1};
+    int isParsed = parseQASM(&src, qureg, circ, errMsg);
+
+    fclose(file);
+    free(buf);
+    return isParsed;
+}
+
+int qasm_parseString(char* qasm, Qureg* qureg, Circuit* circ, char* errMsg) {
+
+    Source src = {.file=NULL, .buf=qasm, .len=strlen(qasm), .pos=0, .line=1};
+    return parseQASM(&src, qureg, circ, errMsg);
+}
@@ -18,9 +18,21 @@ extern "C" {
 # include "QuEST_precision.h"
 # include "QuEST_internal.h"
 # include "QuEST_validation.h"
+# include "QuEST_circuit.h"
  
 # include <stdio.h>
 # include <stdlib.h>
+# include <string.h>
+# include <sys/stat.h>
+
+#if defined(_WIN32) && ! defined(__MINGW32__)
+  #include <io.h>
+  #define access(path, mode) _access(path, mode)
+  #define W_OK 2
+  #define S_ISDIR(mode) (((mode) & _S_IFMT) == _S_IFDIR)
+#else
+  #include <unistd.h>
+#endif
 
 typedef enum {
     E_SUCCESS=0,
@@ -70,7 +82,43 @@ typedef enum {
     E_INVALID_NUM_TWO_QUBIT_KRAUS_OPS,
     E_INVALID_NUM_N_QUBIT_KRAUS_OPS,
     E_INVALID_KRAUS_OPS,
-    E_MISMATCHING_NUM_TARGS_KRAUS_SIZE
+    E_MISMATCHING_NUM_TARGS_KRAUS_SIZE,
+    E_INVALID_NUM_CIRCUIT_PARAMS,
+    E_INVALID_CIRCUIT_GATE,
+    E_INVALID_CIRCUIT_QUBIT,
+    E_INVALID_CIRCUIT_PARAM_GATE,
+    E_INVALID_CIRCUIT_PARAM_INDEX,
+    E_MISMATCHING_CIRCUIT_SIZE,
+    E_INVALID_NUM_SHOTS,
+    E_CANNOT_ALLOC_OUTCOME_PROBS,
+    E_PACKED_DENSMATR_DISTRIBUTED,
+    E_PACKED_DENSMATR_UNSUPPORTED,
+    E_INVALID_NUM_TRAJECTORIES,
+    E_INVALID_REDUCED_MATRIX_SIZE,
+    E_INVALID_QUREG_POOL_CAPACITY,
+    E_REAL_QUREG_UNSUPPORTED,
+    E_NON_REAL_GATE,
+    E_INVALID_HAMMING_WEIGHT,
+    E_INVALID_NUM_SUBSPACE_QUBITS,
+    E_SUBSPACE_QUREG_DISTRIBUTED,
+    E_SUBSPACE_QUREG_UNSUPPORTED,
+    E_NON_CONSERVING_GATE,
+    E_STATE_NOT_IN_SUBSPACE,
+    E_INVALID_OUT_OF_CORE_DIR,
+    E_INVALID_COMPRESSION_BITS,
+    E_COMPRESSED_QUREG_DISTRIBUTED,
+    E_COMPRESSED_QUREG_UNSUPPORTED,
+    E_NOT_COMPRESSED_QUREG,
+    E_INVALID_STORAGE_TYPE,
+    E_INVALID_CHECKPOINT,
+    E_CHECKPOINT_PRECISION,
+    E_MISMATCHING_CHECKPOINT,
+    E_CORRUPT_CHECKPOINT,
+    E_INVALID_QASM,
+    E_INVALID_TRACE,
+    E_MISMATCHING_TRACE,
+    E_CORRUPT_TRACE,
+    E_INVALID_CIRCUIT_FILE
 } ErrorCode;
 
 static const char* errorMessages[] = {
@@ -100,7 +148,7 @@ static const char* errorMessages[] = {
     [E_CANNOT_OPEN_FILE] = "Could not open file.",
     [E_SECOND_ARG_MUST_BE_STATEVEC] = "Second argument must be a state-vector.",
     [E_MISMATCHING_QUREG_DIMENSIONS] = "Dimensions of the qubit registers don't match.",
-    [E_MISMATCHING_QUREG_TYPES] = "Registers must both be state-vectors or both be density matrices.",
+    [E_MISMATCHING_QUREG_TYPES] = "Registers must both be state-vectors of the same (real, complex, fixed Hamming-weight or compressed) amplitudes, or both be density matrices of the same (packed or unpacked) storage.",
     [E_DEFINED_ONLY_FOR_STATEVECS] = "Operation valid only for state-vectors.",
     [E_DEFINED_ONLY_FOR_DENSMATRS] = "Operation valid only for density matrices.",
     [E_INVALID_PROB] = "Probabilities must be in [0, 1].",
@@ -120,7 +168,43 @@ static const char* errorMessages[] = {
     [E_INVALID_NUM_TWO_QUBIT_KRAUS_OPS] = "At least 1 and at most 16 two-qubit Kraus operators may be specified.",
     [E_INVALID_NUM_N_QUBIT_KRAUS_OPS] = "At least 1 and at most 4*N^2 of N-qubit Kraus operators may be specified.",
     [E_INVALID_KRAUS_OPS] = "The specified Kraus map is not a completely positive, trace preserving map.",
-    [E_MISMATCHING_NUM_TARGS_KRAUS_SIZE] = "Every Kraus operator must be of the same number of qubits as the number of targets."
+    [E_MISMATCHING_NUM_TARGS_KRAUS_SIZE] = "Every Kraus operator must be of the same number of qubits as the number of targets.",
+    [E_INVALID_NUM_CIRCUIT_PARAMS] = "Invalid number of circuit parameters. Must be >=0.",
+    [E_INVALID_CIRCUIT_GATE] = "Invalid circuit gate code.",
+    [E_INVALID_CIRCUIT_QUBIT] = "Invalid circuit gate qubit. Must be >=0 and <numQubits of the circuit.",
+    [E_INVALID_CIRCUIT_PARAM_GATE] = "Only single-parameter rotations and phase shifts can be bound to a circuit parameter.",
+    [E_INVALID_CIRCUIT_PARAM_INDEX] = "Invalid circuit parameter index. Must be >=0 and <numParams of the circuit.",
+    [E_MISMATCHING_CIRCUIT_SIZE] = "The circuit and qubit register act upon a different number of qubits.",
+    [E_INVALID_NUM_SHOTS] = "Invalid number of shots. Must be >0.",
+    [E_CANNOT_ALLOC_OUTCOME_PROBS] = "Could not allocate memory for the probabilities of every outcome of the given qubits. Measure or sample fewer qubits at once.",
+    [E_PACKED_DENSMATR_DISTRIBUTED] = "Packed density matrices cannot be distributed between multiple nodes.",
+    [E_PACKED_DENSMATR_UNSUPPORTED] = "Operation not supported for packed density matrices.",
+    [E_INVALID_NUM_TRAJECTORIES] = "Invalid number of trajectories. Must be >0.",
+    [E_INVALID_REDUCED_MATRIX_SIZE] = "The matrix size does not match the number of kept qubits.",
+    [E_INVALID_QUREG_POOL_CAPACITY] = "Invalid qureg pool capacity. Must be >=0.",
+    [E_REAL_QUREG_UNSUPPORTED] = "Operation not supported for real-amplitude registers, since it can introduce complex amplitudes.",
+    [E_NON_REAL_GATE] = "Real-amplitude registers accept only real gates and amplitudes; an imaginary component was non-zero.",
+    [E_INVALID_HAMMING_WEIGHT] = "Invalid Hamming weight. Must be >=0 and <=numQubits.",
+    [E_INVALID_NUM_SUBSPACE_QUBITS] = "Invalid number of qubits. Fixed Hamming-weight registers support at most 62 qubits.",
+    [E_SUBSPACE_QUREG_DISTRIBUTED] = "Fixed Hamming-weight registers cannot be distributed between multiple nodes.",
+    [E_SUBSPACE_QUREG_UNSUPPORTED] = "Operation not supported for fixed Hamming-weight registers.",
+    [E_NON_CONSERVING_GATE] = "Fixed Hamming-weight registers accept only gates which conserve the number of qubits in state |1>; the matrix couples basis states of different Hamming weight.",
+    [E_STATE_NOT_IN_SUBSPACE] = "The basis state does not have the Hamming weight (number of qubits in state |1>) of the register.",
+    [E_INVALID_OUT_OF_CORE_DIR] = "Invalid directory for the amplitude files of an out-of-core register. It must be an existing, writable directory.",
+    [E_INVALID_COMPRESSION_BITS] = "Invalid number of bits per compressed component. Must be 0 (lossless), 8, 16 or 32.",
+    [E_COMPRESSED_QUREG_DISTRIBUTED] = "Compressed registers cannot be distributed between multiple nodes.",
+    [E_COMPRESSED_QUREG_UNSUPPORTED] = "Operation not supported for compressed registers; apply gates with applyCircuit().",
+    [E_NOT_COMPRESSED_QUREG] = "The register is not compressed. It must be created with createCompressedQureg() or createReducedPrecisionQureg().",
+    [E_INVALID_STORAGE_TYPE] = "Invalid amplitude storage type. Must be STORAGE_FLOAT, STORAGE_HALF or STORAGE_BFLOAT16.",
+    [E_INVALID_CHECKPOINT] = "The file is not a checkpoint written by writeQuregCheckpoint(), or was written by an incompatible version of QuEST.",
+    [E_CHECKPOINT_PRECISION] = "The checkpoint was written with a different floating-point precision (QuEST_PREC).",
+    [E_MISMATCHING_CHECKPOINT] = "The checkpoint's register differs in type or number of qubits from the register being restored.",
+    [E_CORRUPT_CHECKPOINT] = "The checkpoint's amplitudes could not be read, or do not match its checksums. The file is corrupt, and the register is left in an invalid state.",
+    [E_INVALID_QASM] = "Could not read the OpenQASM circuit:",
+    [E_INVALID_TRACE] = "The file is not a trace written by writeRecordedTraceToFile(), or was written with a different precision (QuEST_PREC) or version of QuEST.",
+    [E_MISMATCHING_TRACE] = "The trace was recorded upon a register of a different number of qubits.",
+    [E_CORRUPT_TRACE] = "The trace contains an invalid or truncated record.",
+    [E_INVALID_CIRCUIT_FILE] = "Could not read the circuit file:"
 };
 
 void exitWithError(const char* msg, const char* func) {
@@ -397,6 +481,11 @@ void validateMatchingQuregDims(Qureg qureg1, Qureg qureg2, const char *caller) {
 
 void validateMatchingQuregTypes(Qureg qureg1, Qureg qureg2, const char *caller) {
     QuESTAssert(qureg1.isDensityMatrix==qureg2.isDensityMatrix, E_MISMATCHING_QUREG_TYPES, caller);
+    QuESTAssert(qureg1.isPacked==qureg2.isPacked, E_MISMATCHING_QUREG_TYPES, caller);
+    QuESTAssert(qureg1.isReal==qureg2.isReal, E_MISMATCHING_QUREG_TYPES, caller);
+    QuESTAssert(qureg1.isSubspace==qureg2.isSubspace, E_MISMATCHING_QUREG_TYPES, caller);
+    QuESTAssert(qureg1.hammingWeight==qureg2.hammingWeight, E_MISMATCHING_QUREG_TYPES, caller);
+    QuESTAssert(qureg1.isCompressed==qureg2.isCompressed, E_MISMATCHING_QUREG_TYPES, caller);
 }
 
 void validateSecondQuregStateVec(Qureg qureg2, const char *caller) {
@@ -407,6 +496,40 @@ void validateFileOpened(int found, const char* caller) {
     QuESTAssert(found, E_CANNOT_OPEN_FILE, caller);
 }
 
+void validateCheckpointHeader(Qureg qureg, CheckpointHeader header, const char* caller) {
+    int isCheckpoint = (memcmp(header.magic, CHECKPOINT_MAGIC, sizeof header.magic) == 0);
+    QuESTAssert(isCheckpoint && header.version == CHECKPOINT_VERSION, E_INVALID_CHECKPOINT, caller);
+    QuESTAssert(header.numBytesPerReal == sizeof(qreal), E_CHECKPOINT_PRECISION, caller);
+
+    CheckpointHeader quregHeader;
+    statevec_initCheckpointHeader(qureg, &quregHeader);
+    int isMatch = (
+        header.numQubits == quregHeader.numQubits &&
+        header.isDensityMatrix == quregHeader.isDensityMatrix &&
+        header.isPacked == quregHeader.isPacked &&
+        header.isReal == quregHeader.isReal &&
+        header.isSubspace == quregHeader.isSubspace &&
+        header.hammingWeight == quregHeader.hammingWeight &&
+        header.numAmps == quregHeader.numAmps);
+    QuESTAssert(isMatch, E_MISMATCHING_CHECKPOINT, caller);
+}
+
+void validateCheckpointLoaded(int isLoaded, const char* caller) {
+    QuESTAssert(isLoaded, E_CORRUPT_CHECKPOINT, caller);
+}
+
+void validateTraceFile(int isValidHeader, const char* caller) {
+    QuESTAssert(isValidHeader, E_INVALID_TRACE, caller);
+}
+
+void validateTraceQureg(Qureg qureg, int numTraceQubits, const char* caller) {
+    QuESTAssert(qureg.numQubitsRepresented == numTraceQubits, E_MISMATCHING_TRACE, caller);
+}
+
+void validateTraceRecord(int isValidRecord, const char* caller) {
+    QuESTAssert(isValidRecord, E_CORRUPT_TRACE, caller);
+}
+
 void validateProb(qreal prob, const char* caller) {
     QuESTAssert(prob >= 0 && prob <= 1, E_INVALID_PROB, caller);
 }
@@ -474,7 +597,8 @@ void validateOneQubitKrausMap(Qureg qureg, ComplexMatrix2* ops, int numOps, cons
     int maxNumOps = superOpNumQubits*superOpNumQubits;
     QuESTAssert(numOps > 0 && numOps <= maxNumOps, E_INVALID_NUM_ONE_QUBIT_KRAUS_OPS, caller);
     
-    validateMultiQubitMatrixFitsInNode(qureg, superOpNumQubits, caller);
+    // a state-vector trajectory applies a single sampled operator, not the superoperator
+    validateMultiQubitMatrixFitsInNode(qureg, qureg.isDensityMatrix? superOpNumQubits : opNumQubits, caller);
     
     int isPos = isCompletelyPositiveMap2(ops, numOps);
     QuESTAssert(isPos, E_INVALID_KRAUS_OPS, caller);
@@ -509,6 +633,193 @@ void validateMultiQubitKrausMap(Qureg qureg, int numTargs, ComplexMatrixN* ops,
     QuESTAssert(isPos, E_INVALID_KRAUS_OPS, caller);
 }
 
+void validateCreateCircuit(int numQubits, int numParams, const char* caller) {
+    QuESTAssert(numQubits>0, E_INVALID_NUM_CREATE_QUBITS, caller);
+    QuESTAssert(numParams>=0, E_INVALID_NUM_CIRCUIT_PARAMS, caller);
+}
+
+void validateCircuitGate(Circuit circ, int gate, int* qubits, const char* caller) {
+    QuESTAssert(circuit_isValidGate(gate), E_INVALID_CIRCUIT_GATE, caller);
+    
+    int numQubits = circuit_getNumGateQubits(gate);
+    for (int i=0; i < numQubits; i++)
+        QuESTAssert(qubits[i]>=0 && qubits[i]<circ.numQubits, E_INVALID_CIRCUIT_QUBIT, caller);
+    
+    QuESTAssert(areUniqueQubits(qubits, numQubits), E_QUBITS_NOT_UNIQUE, caller);
+}
+
+void validateCircuitParamGate(Circuit circ, int gate, int paramInd, const char* caller) {
+    QuESTAssert(circuit_isParamGate(gate), E_INVALID_CIRCUIT_PARAM_GATE, caller);
+    QuESTAssert(paramInd>=0 && paramInd<circ.numParams, E_INVALID_CIRCUIT_PARAM_INDEX, caller);
+}
+
+void validateCircuitQureg(Qureg qureg, Circuit circ, const char* caller) {
+    QuESTAssert(qureg.numQubitsRepresented==circ.numQubits, E_MISMATCHING_CIRCUIT_SIZE, caller);
+}
+
+void validateCircuitGates(Qureg qureg, Circuit circ, const char* caller) {
+    if ( ! qureg.isReal && ! qureg.isSubspace)
+        return;
+    for (int g=0; g<circ.gateList->numGates; g++) {
+        ComplexMatrix4 u = circuit_getGateMatrix(circ, g);
+        validateRealTwoQubitMatrix(qureg, u, caller);
+        validateNumberConservingMatrix(qureg, u, caller);
+    }
+}
+
+void validateQASMParsed(int isParsed, char* parseErrMsg, const char* caller) {
+    if (isParsed)
+        return;
+
+    // the parser's message (which cites the offending line) follows the generic one
+    char errMsg[1024];
+    snprintf(errMsg, sizeof errMsg, "%s %s", errorMessages[E_INVALID_QASM], parseErrMsg);
+    invalidQuESTInputError(errMsg, caller);
+}
+
+void validateCircuitFileRead(int isRead, char* readErrMsg, const char* caller) {
+    if (isRead)
+        return;
+
+    char errMsg[1024];
+    snprintf(errMsg, sizeof errMsg, "%s %s", errorMessages[E_INVALID_CIRCUIT_FILE], readErrMsg);
+    invalidQuESTInputError(errMsg, caller);
+}
+
+void validateNumShots(int numShots, const char* caller) {
+    QuESTAssert(numShots>0, E_INVALID_NUM_SHOTS, caller);
+}
+
+void validateOutcomeProbsAllocated(qreal* outcomeProbs, const char* caller) {
+    QuESTAssert(outcomeProbs != NULL, E_CANNOT_ALLOC_OUTCOME_PROBS, caller);
+}
+
+void validatePackedNumRanks(QuESTEnv env, const char* caller) {
+    QuESTAssert(env.numRanks==1, E_PACKED_DENSMATR_DISTRIBUTED, caller);
+}
+
+void validateNotPacked(Qureg qureg, const char* caller) {
+    QuESTAssert( ! qureg.isPacked, E_PACKED_DENSMATR_UNSUPPORTED, caller);
+}
+
+void validateNumTrajectories(int numTrajectories, const char* caller) {
+    QuESTAssert(numTrajectories>0, E_INVALID_NUM_TRAJECTORIES, caller);
+}
+
+void validateQuregPoolCapacity(int capacity, const char* caller) {
+    QuESTAssert(capacity>=0, E_INVALID_QUREG_POOL_CAPACITY, caller);
+}
+
+void validateNotReal(Qureg qureg, const char* caller) {
+    QuESTAssert( ! qureg.isReal, E_REAL_QUREG_UNSUPPORTED, caller);
+}
+
+void validateRealOneQubitMatrix(Qureg qureg, ComplexMatrix2 u, const char* caller) {
+    if ( ! qureg.isReal)
+        return;
+    for (int r=0; r<2; r++)
+        for (int c=0; c<2; c++)
+            QuESTAssert(absReal(u.imag[r][c]) < REAL_EPS, E_NON_REAL_GATE, caller);
+}
+
+void validateRealTwoQubitMatrix(Qureg qureg, ComplexMatrix4 u, const char* caller) {
+    if ( ! qureg.isReal)
+        return;
+    for (int r=0; r<4; r++)
+        for (int c=0; c<4; c++)
+            QuESTAssert(absReal(u.imag[r][c]) < REAL_EPS, E_NON_REAL_GATE, caller);
+}
+
+void validateRealMultiQubitMatrix(Qureg qureg, ComplexMatrixN u, const char* caller) {
+    if ( ! qureg.isReal)
+        return;
+    long long int dim = 1LL << u.numQubits;
+    for (long long int r=0; r<dim; r++)
+        for (long long int c=0; c<dim; c++)
+            QuESTAssert(absReal(u.imag[r][c]) < REAL_EPS, E_NON_REAL_GATE, caller);
+}
+
+void validateRealComplexPair(Qureg qureg, Complex alpha, Complex beta, const char* caller) {
+    if ( ! qureg.isReal)
+        return;
+    QuESTAssert(absReal(alpha.imag) < REAL_EPS && absReal(beta.imag) < REAL_EPS, E_NON_REAL_GATE, caller);
+}
+
+void validateRealAmps(Qureg qureg, qreal* imags, long long int numAmps, const char* caller) {
+    if ( ! qureg.isReal)
+        return;
+    for (long long int i=0; i<numAmps; i++)
+        QuESTAssert(absReal(imags[i]) < REAL_EPS, E_NON_REAL_GATE, caller);
+}
+
+void validateSubspaceSize(int numQubits, int hammingWeight, const char* caller) {
+    QuESTAssert(numQubits<=62, E_INVALID_NUM_SUBSPACE_QUBITS, caller);
+    QuESTAssert(hammingWeight>=0 && hammingWeight<=numQubits, E_INVALID_HAMMING_WEIGHT, caller);
+}
+
+void validateSubspaceNumRanks(QuESTEnv env, const char* caller) {
+    QuESTAssert(env.numRanks==1, E_SUBSPACE_QUREG_DISTRIBUTED, caller);
+}
+
+void validateNotSubspace(Qureg qureg, const char* caller) {
+    QuESTAssert( ! qureg.isSubspace, E_SUBSPACE_QUREG_UNSUPPORTED, caller);
+}
+
+static int getHammingWeight(long long int bits) {
+    int weight = 0;
+    for (; bits; bits &= bits-1)
+        weight++;
+    return weight;
+}
+
+void validateNumberConservingMatrix(Qureg qureg, ComplexMatrix4 u, const char* caller) {
+    if ( ! qureg.isSubspace)
+        return;
+    for (int r=0; r<4; r++)
+        for (int c=0; c<4; c++)
+            if (getHammingWeight(r) != getHammingWeight(c))
+                QuESTAssert(absReal(u.real[r][c]) < REAL_EPS && absReal(u.imag[r][c]) < REAL_EPS, 
+                    E_NON_CONSERVING_GATE, caller);
+}
+
+void validateStateInSubspace(Qureg qureg, long long int stateInd, const char* caller) {
+    if ( ! qureg.isSubspace)
+        return;
+    QuESTAssert(getHammingWeight(stateInd) == qureg.hammingWeight, E_STATE_NOT_IN_SUBSPACE, caller);
+}
+
+void validateOutOfCoreDir(char* dirName, const char* caller) {
+    struct stat info;
+    int isDir = (dirName != NULL && stat(dirName, &info) == 0 && S_ISDIR(info.st_mode));
+    QuESTAssert(isDir && access(dirName, W_OK) == 0, E_INVALID_OUT_OF_CORE_DIR, caller);
+}
+
+void validateCompressionBits(int numBits, const char* caller) {
+    QuESTAssert(numBits==0 || numBits==8 || numBits==16 || numBits==32, E_INVALID_COMPRESSION_BITS, caller);
+}
+
+void validateStorageType(enum ampStorageType storage, const char* caller) {
+    QuESTAssert(storage==STORAGE_FLOAT || storage==STORAGE_HALF || storage==STORAGE_BFLOAT16, E_INVALID_STORAGE_TYPE, caller);
+}
+
+void validateCompressedNumRanks(QuESTEnv env, const char* caller) {
+    QuESTAssert(env.numRanks==1, E_COMPRESSED_QUREG_DISTRIBUTED, caller);
+}
+
+void validateNotCompressed(Qureg qureg, const char* caller) {
+    QuESTAssert( ! qureg.isCompressed, E_COMPRESSED_QUREG_UNSUPPORTED, caller);
+}
+
+void validateCompressedQureg(Qureg qureg, const char* caller) {
+    QuESTAssert(qureg.isCompressed, E_NOT_COMPRESSED_QUREG, caller);
+}
+
+void validateReducedDensityMatrix(Qureg qureg, ComplexMatrixN out, int numKeep, const char* caller) {
+    validateMatrixInit(out, caller);
+    validateMultiQubitMatrixFitsInNode(qureg, numKeep, caller);
+    QuESTAssert(numKeep == out.numQubits, E_INVALID_REDUCED_MATRIX_SIZE, caller);
+}
+
 #ifdef __cplusplus
 }
 #endif
@@ -12,6 +12,7 @@
 # define QUEST_VALIDATION_H
 
 # include "QuEST.h"
+# include "QuEST_internal.h"
 
 # ifdef __cplusplus
 extern "C" {
@@ -71,6 +72,16 @@ void validateNumAmps(Qureg qureg, long long int startInd, long long int numAmps,
 
 void validateFileOpened(int opened, const char* caller);
 
+void validateCheckpointHeader(Qureg qureg, CheckpointHeader header, const char* caller);
+
+void validateCheckpointLoaded(int isLoaded, const char* caller);
+
+void validateTraceFile(int isValidHeader, const char* caller);
+
+void validateTraceQureg(Qureg qureg, int numTraceQubits, const char* caller);
+
+void validateTraceRecord(int isValidRecord, const char* caller);
+
 void validateProb(qreal prob, const char* caller);
 
 void validateNormProbs(qreal prob1, qreal prob2, const char* caller);
@@ -99,6 +110,68 @@ void validateMultiQubitKrausMap(Qureg qureg, int numTargs, ComplexMatrixN* ops,
 
 void validateOneQubitDampingProb(qreal prob, const char* caller);
 
+void validateCreateCircuit(int numQubits, int numParams, const char* caller);
+
+void validateCircuitGate(Circuit circ, int gate, int* qubits, const char* caller);
+
+void validateCircuitParamGate(Circuit circ, int gate, int paramInd, const char* caller);
+
+void validateCircuitQureg(Qureg qureg, Circuit circ, const char* caller);
+
+void validateCircuitGates(Qureg qureg, Circuit circ, const char* caller);
+
+void validateQASMParsed(int isParsed, char* parseErrMsg, const char* caller);
+
+void validateCircuitFileRead(int isRead, char* readErrMsg, const char* caller);
+
+void validateNumShots(int numShots, const char* caller);
+
+void validateOutcomeProbsAllocated(qreal* outcomeProbs, const char* caller);
+
+void validatePackedNumRanks(QuESTEnv env, const char* caller);
+
+void validateNotPacked(Qureg qureg, const char* caller);
+
+void validateNumTrajectories(int numTrajectories, const char* caller);
+
+void validateQuregPoolCapacity(int capacity, const char* caller);
+
+void validateNotReal(Qureg qureg, const char* caller);
+
+void validateRealOneQubitMatrix(Qureg qureg, ComplexMatrix2 u, const char* caller);
+
+void validateRealTwoQubitMatrix(Qureg qureg, ComplexMatrix4 u, const char* caller);
+
+void validateRealMultiQubitMatrix(Qureg qureg, ComplexMatrixN u, const char* caller);
+
+void validateRealComplexPair(Qureg qureg, Complex alpha, Complex beta, const char* caller);
+
+void validateRealAmps(Qureg qureg, qreal* imags, long long int numAmps, const char* caller);
+
+void validateSubspaceSize(int numQubits, int hammingWeight, const char* caller);
+
+void validateSubspaceNumRanks(QuESTEnv env, const char* caller);
+
+void validateNotSubspace(Qureg qureg, const char* caller);
+
+void validateNumberConservingMatrix(Qureg qureg, ComplexMatrix4 u, const char* caller);
+
+void validateStateInSubspace(Qureg qureg, long long int stateInd, const char* caller);
+
+void validateOutOfCoreDir(char* dirName, const char* caller);
+
+void validateCompressionBits(int numBits, const char* caller);
+
+void validateStorageType(enum ampStorageType storage, const char* caller);
+
+void validateCompressedNumRanks(QuESTEnv env, const char* caller);
+
+void validateNotCompressed(Qureg qureg, const char* caller);
+
+void validateCompressedQureg(Qureg qureg, const char* caller);
+
+void validateReducedDensityMatrix(Qureg qureg, ComplexMatrixN out, int numKeep, const char* caller);
+
 # ifdef __cplusplus
 }
 # endif
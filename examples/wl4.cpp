@@ -25,8 +25,10 @@ int main(){
     /* start timing */
     double t0 = get_wall_time();
 
-    /* add ansztz circuit */
-    #include "ansatz_circuit.dat"
+    /* add ansztz circuit, read at runtime so that it can be changed without recompiling */
+    Circuit ansatz = readCircuitFile((char*) "ansatz_circuit.dat", numQubits);
+    applyCircuit(QReg, ansatz);
+    destroyCircuit(ansatz);
 
     Qureg QReg2 = createQureg(numQubits, env);
     
@@ -35,7 +35,10 @@ int main () {
     /* start timing */
     double t0 = get_wall_time();
 
-    #include"circuit.dat"
+    /* read the circuit at runtime, so that it can be changed without recompiling */
+    Circuit circ = readCircuitFile((char*) "circuit.dat", numQubits);
+    applyCircuit(QReg, circ);
+    destroyCircuit(circ);
 
     qreal prob;
     for(int ind=0; ind<numQubits; ++ind){
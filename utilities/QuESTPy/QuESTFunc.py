@@ -14,7 +14,16 @@ createQuESTEnv     = QuESTTestee ('createQuESTEnv',QuESTEnv)
 destroyQuESTEnv    = QuESTTestee ('destroyQuESTEnv',None,[QuESTEnv],[None])
 createQureg        = QuESTTestee ('createQureg',Qureg,[c_int,QuESTEnv],[1,None])
 createDensityQureg = QuESTTestee ('createDensityQureg',Qureg,[c_int,QuESTEnv],[1,None])
+createCloneQureg   = QuESTTestee ('createCloneQureg',Qureg,[Qureg,QuESTEnv],[None,None])
+createPackedDensityQureg = QuESTTestee ('createPackedDensityQureg',Qureg,[c_int,QuESTEnv],[1,None])
+createRealQureg    = QuESTTestee ('createRealQureg',Qureg,[c_int,QuESTEnv],[1,None])
+createSubspaceQureg = QuESTTestee ('createSubspaceQureg',Qureg,[c_int,c_int,QuESTEnv],[1,0,None])
+createOutOfCoreQureg = QuESTTestee ('createOutOfCoreQureg',Qureg,[c_int,c_char_p,QuESTEnv],[1,None,None])
+createCompressedQureg = QuESTTestee ('createCompressedQureg',Qureg,[c_int,c_int,QuESTEnv],[1,0,None])
+createReducedPrecisionQureg = QuESTTestee ('createReducedPrecisionQureg',Qureg,[c_int,c_int,QuESTEnv],[1,0,None])
 destroyQureg       = QuESTTestee ('destroyQureg',None,[Qureg,QuESTEnv],[None,None])
+setQuregPoolCapacity = QuESTTestee ('setQuregPoolCapacity',None,[QuESTEnv,c_int],[None,0])
+setCopyOnWriteClones = QuESTTestee ('setCopyOnWriteClones',None,[QuESTEnv,c_int],[None,0])
 
 # Utility Operations
 cloneQureg             = QuESTTestee ("cloneQureg", retType=None, argType=[Qureg, Qureg], defArg=[None, None])
@@ -34,6 +43,15 @@ printRecordedQASM       = QuESTTestee ("printRecordedQASM", retType=None, argTyp
 startRecordingQASM      = QuESTTestee ("startRecordingQASM", retType=None, argType=[Qureg], defArg=[None])
 stopRecordingQASM       = QuESTTestee ("stopRecordingQASM", retType=None, argType=[Qureg], defArg=[None])
 writeRecordedQASMToFile = QuESTTestee ("writeRecordedQASMToFile", retType=None, argType=[Qureg,c_char_p], defArg=[None,None]) 
+writeRecordedTraceToFile = QuESTTestee ("writeRecordedTraceToFile", retType=None, argType=[Qureg,c_char_p], defArg=[None,None])
+writeTraceFileAsQASM     = QuESTTestee ("writeTraceFileAsQASM", retType=None, argType=[c_char_p,c_char_p], defArg=[None,None])
+applyTraceFile           = QuESTTestee ("applyTraceFile", retType=None, argType=[Qureg,c_char_p], defArg=[None,None])
+
+# Checkpoint Operations
+writeQuregCheckpoint  = QuESTTestee ("writeQuregCheckpoint", retType=None, argType=[Qureg,c_char_p], defArg=[None,None])
+readQuregCheckpoint   = QuESTTestee ("readQuregCheckpoint", retType=c_longlong, argType=[Qureg,c_char_p,c_int], defArg=[None,None,0])
+startQuregCheckpoint  = QuESTTestee ("startQuregCheckpoint", retType=None, argType=[Qureg,c_char_p,c_longlong], defArg=[None,None,0])
+finishQuregCheckpoint = QuESTTestee ("finishQuregCheckpoint", retType=None, argType=[Qureg], defArg=[None])
 
 # Parallel Operations
 syncQuESTEnv     = QuESTTestee ("syncQuESTEnv", retType=None, argType=[QuESTEnv], defArg=[None])
@@ -44,6 +62,7 @@ initZeroState      = QuESTTestee ("initZeroState",      retType=None, argType=[Q
 initPlusState      = QuESTTestee ("initPlusState",      retType=None, argType=[Qureg], defArg=[None])
 initClassicalState = QuESTTestee ("initClassicalState", retType=None, argType=[Qureg,c_longlong], defArg=[None,None])
 initPureState      = QuESTTestee ("initPureState",      retType=None, argType=[Qureg,Qureg], defArg=[None,None])
+initStateOfSingleQubit = QuESTTestee ("initStateOfSingleQubit", retType=None, argType=[POINTER(Qureg),c_int,c_int], defArg=[None,0,0])
 initStateFromAmps  = QuESTTestee ("initStateFromAmps",  retType=None, argType=[Qureg,POINTER(qreal),POINTER(qreal)], defArg=[None,None,None], denMat = False)
 initDebugState     = QuESTTestee ("initDebugState",     retType=None, argType=[Qureg], defArg=[None])
 initDebugState     = initDebugState  # Alias
@@ -64,6 +83,18 @@ rotateX          = QuESTTestee ("rotateX",          retType=None, argType=[Qureg
 rotateY          = QuESTTestee ("rotateY",          retType=None, argType=[Qureg,_targetQubit,qreal], defArg=[None,0,random.uniform(0.,360.)])
 rotateZ          = QuESTTestee ("rotateZ",          retType=None, argType=[Qureg,_targetQubit,qreal], defArg=[None,0,random.uniform(0.,360.)])
 unitary          = QuESTTestee ("unitary",          retType=None, argType=[Qureg,_targetQubit,ComplexMatrix2], defArg=[None,0,rand_unit_mat()]) 
+u1Gate           = QuESTTestee ("u1Gate",           retType=None, argType=[Qureg,_targetQubit,qreal], defArg=[None,0,random.uniform(0.,360.)])
+u2Gate           = QuESTTestee ("u2Gate",           retType=None, argType=[Qureg,_targetQubit,qreal,qreal], defArg=[None,0,random.uniform(0.,360.),random.uniform(0.,360.)])
+u3Gate           = QuESTTestee ("u3Gate",           retType=None, argType=[Qureg,_targetQubit,qreal,qreal,qreal], defArg=[None,0,random.uniform(0.,360.),random.uniform(0.,360.),random.uniform(0.,360.)])
+SqX              = QuESTTestee ("SqX",              retType=None, argType=[Qureg,_targetQubit], defArg=[None,0])
+SqY              = QuESTTestee ("SqY",              retType=None, argType=[Qureg,_targetQubit], defArg=[None,0])
+SqW              = QuESTTestee ("SqW",              retType=None, argType=[Qureg,_targetQubit], defArg=[None,0])
+swapGate         = QuESTTestee ("swapGate",         retType=None, argType=[Qureg,c_int,c_int], defArg=[None,0,1])
+fSim             = QuESTTestee ("fSim",             retType=None, argType=[Qureg,c_int,c_int,qreal,qreal], defArg=[None,0,1,random.uniform(0.,360.),random.uniform(0.,360.)])
+sqrtSwapGate     = QuESTTestee ("sqrtSwapGate",     retType=None, argType=[Qureg,c_int,c_int], defArg=[None,0,1])
+multiRotateZ     = QuESTTestee ("multiRotateZ",     retType=None, argType=[Qureg,POINTER(c_int),c_int,qreal], defArg=[None,[0,1],2,random.uniform(0.,360.)])
+twoQubitUnitary  = QuESTTestee ("twoQubitUnitary",  retType=None, argType=[Qureg,c_int,c_int,ComplexMatrix4], defArg=[None,0,1,None])
+multiQubitUnitary = QuESTTestee ("multiQubitUnitary", retType=None, argType=[Qureg,POINTER(c_int),c_int,ComplexMatrixN], defArg=[None,None,None,None])
 
 # Controlled Operations
 controlledCompactUnitary   = QuESTTestee ("controlledCompactUnitary",   retType=None, argType=[Qureg,_controlQubit,_targetQubit,Complex,Complex], defArg=[None,1,0,*rand_norm_comp_pair()])
@@ -76,11 +107,13 @@ controlledRotateX          = QuESTTestee ("controlledRotateX",          retType=
 controlledRotateY          = QuESTTestee ("controlledRotateY",          retType=None, argType=[Qureg,_controlQubit,_targetQubit,qreal], defArg=[None,1,0,90.])
 controlledRotateZ          = QuESTTestee ("controlledRotateZ",          retType=None, argType=[Qureg,_controlQubit,_targetQubit,qreal], defArg=[None,1,0,90.])
 controlledUnitary          = QuESTTestee ("controlledUnitary",          retType=None, argType=[Qureg,_controlQubit,_targetQubit,ComplexMatrix2], defArg=[None,1,0,rand_unit_mat()]) 
+controlledTwoQubitUnitary  = QuESTTestee ("controlledTwoQubitUnitary",  retType=None, argType=[Qureg,_controlQubit,c_int,c_int,ComplexMatrix4], defArg=[None,2,0,1,None])
 
 # Multi-controlled Operations
 multiControlledPhaseFlip  = QuESTTestee ("multiControlledPhaseFlip",  retType=None, argType=[Qureg,_controlQubits,_numControlQubits], defArg=[None,[0],1])
 multiControlledPhaseShift = QuESTTestee ("multiControlledPhaseShift", retType=None, argType=[Qureg,_controlQubits,_numControlQubits,qreal], defArg=[None,[0],1,random.uniform(0.,360.)])
 multiControlledUnitary    = QuESTTestee ("multiControlledUnitary",    retType=None, argType=[Qureg,_controlQubits,_numControlQubits,_targetQubit,ComplexMatrix2], defArg=[None,[1],1,0,rand_unit_mat()]) 
+multiControlledTwoQubitUnitary = QuESTTestee ("multiControlledTwoQubitUnitary", retType=None, argType=[Qureg,_controlQubits,_numControlQubits,c_int,c_int,ComplexMatrix4], defArg=[None,[2],1,0,1,None])
 
 # Density Matrix Operations
 mixDensityMatrix             = QuESTTestee ("mixDensityMatrix",             retType=None, argType=[Qureg,qreal,Qureg], defArg=[None,50.,None], denMat=True)
@@ -89,6 +122,13 @@ mixDepolarising = QuESTTestee ("mixDepolarising", retType=None, argType=[Qureg,_
 mixDamping    = QuESTTestee ("mixDamping",    retType=None, argType=[Qureg,_targetQubit,qreal], defArg=[None,0,0.25], denMat=True)
 mixTwoQubitDephasing    = QuESTTestee ("mixTwoQubitDephasing",    retType=None, argType=[Qureg,_targetQubit,_controlQubit,qreal], defArg=[None,0,1,0.25], denMat=True)
 mixTwoQubitDepolarising = QuESTTestee ("mixTwoQubitDepolarising", retType=None, argType=[Qureg,_targetQubit,_controlQubit,qreal], defArg=[None,0,1,0.25], denMat=True) 
+mixDephasingAll    = QuESTTestee ("mixDephasingAll",    retType=None, argType=[Qureg,qreal], defArg=[None,0.25])
+mixDepolarisingAll = QuESTTestee ("mixDepolarisingAll", retType=None, argType=[Qureg,qreal], defArg=[None,0.25])
+mixDampingOnQubits = QuESTTestee ("mixDampingOnQubits", retType=None, argType=[Qureg,POINTER(c_int),c_int,qreal], defArg=[None,None,None,0.25])
+mixPauli        = QuESTTestee ("mixPauli",        retType=None, argType=[Qureg,_targetQubit,qreal,qreal,qreal], defArg=[None,0,0.1,0.1,0.1])
+mixKrausMap     = QuESTTestee ("mixKrausMap",     retType=None, argType=[Qureg,_targetQubit,POINTER(ComplexMatrix2),c_int], defArg=[None,0,None,None])
+mixTwoQubitKrausMap   = QuESTTestee ("mixTwoQubitKrausMap",   retType=None, argType=[Qureg,c_int,c_int,POINTER(ComplexMatrix4),c_int], defArg=[None,0,1,None,None], denMat=True)
+mixMultiQubitKrausMap = QuESTTestee ("mixMultiQubitKrausMap", retType=None, argType=[Qureg,POINTER(c_int),c_int,POINTER(ComplexMatrixN),c_int], defArg=[None,None,None,None,None], denMat=True)
 
 # Examination and Mathematical Operations
 calcFidelity      = QuESTTestee ("calcFidelity",      retType=qreal, argType=[Qureg,Qureg], defArg=[None,None])
@@ -96,6 +136,7 @@ calcInnerProduct  = QuESTTestee ("calcInnerProduct",  retType=Complex, argType=[
 calcProbOfOutcome = QuESTTestee ("calcProbOfOutcome", retType=qreal, argType=[Qureg,_targetQubit,c_int], defArg=[None,0,1])
 calcTotalProb     = QuESTTestee ("calcTotalProb",     retType=qreal, argType=[Qureg], defArg=[None])
 calcPurity        = QuESTTestee ("calcPurity",        retType=qreal, argType=[Qureg], defArg=[None],denMat=True)
+calcHilbertSchmidtDistance = QuESTTestee ("calcHilbertSchmidtDistance", retType=qreal, argType=[Qureg,Qureg], defArg=[None,None], denMat=True)
 collapseToOutcome = QuESTTestee ("collapseToOutcome", retType=None, argType=[Qureg,_targetQubit,c_int], defArg=[None,0,0]) 
 getAmp            = QuESTTestee ("getAmp",            retType=Complex, argType=[Qureg,_stateIndex], defArg=[None,0], denMat = False)
 getDensityAmp     = QuESTTestee ("getDensityAmp",     retType=Complex, argType=[Qureg,_stateIndex,_stateIndex], defArg=[None,0,0],denMat=True)
@@ -106,3 +147,30 @@ getRealAmp        = QuESTTestee ("getRealAmp",        retType=qreal, argType=[Qu
 getNumQubits      = QuESTTestee ("getNumQubits",      retType=c_int, argType=[Qureg], defArg=[None])
 measure           = QuESTTestee ("measure",           retType=c_int, argType=[Qureg,_targetQubit], defArg=[None,0])
 measureWithStats  = QuESTTestee ("measureWithStats",  retType=c_int, argType=[Qureg,_targetQubit,POINTER(qreal)], defArg=[None,0,None])
+sampleOutcomes    = QuESTTestee ("sampleOutcomes",    retType=None, argType=[Qureg,POINTER(c_int),c_int,c_int,POINTER(c_longlong)], defArg=[None,None,None,None,None])
+measureAll        = QuESTTestee ("measureAll",        retType=c_longlong, argType=[Qureg,POINTER(c_int)], defArg=[None,None])
+collapseToOutcomes = QuESTTestee ("collapseToOutcomes", retType=qreal, argType=[Qureg,POINTER(c_int),POINTER(c_int),c_int], defArg=[None,None,None,None])
+measureQubits     = QuESTTestee ("measureQubits",     retType=qreal, argType=[Qureg,POINTER(c_int),c_int,POINTER(c_int)], defArg=[None,None,None,None])
+calcReducedDensityMatrix = QuESTTestee ("calcReducedDensityMatrix", retType=None, argType=[Qureg,POINTER(c_int),c_int,ComplexMatrixN], defArg=[None,None,None,None])
+getCompressionStats = QuESTTestee ("getCompressionStats", retType=CompressionStats, argType=[Qureg], defArg=[None])
+calcExpecPauliProd = QuESTTestee ("calcExpecPauliProd", retType=qreal, argType=[Qureg,POINTER(c_int),POINTER(c_int),c_int,Qureg], defArg=[None,None,None,None,None])
+calcExpecPauliSum = QuESTTestee ("calcExpecPauliSum", retType=qreal, argType=[Qureg,POINTER(c_int),POINTER(qreal),c_int,Qureg], defArg=[None,None,None,None,None])
+calcTrajectoryAverage       = QuESTTestee ("calcTrajectoryAverage",       retType=TrajectoryStats, argType=[Qureg,NoisyCircuitFunc,c_void_p,ObservableFunc,c_void_p,c_int], defArg=[None]*6)
+calcTrajectoryExpecPauliSum = QuESTTestee ("calcTrajectoryExpecPauliSum", retType=TrajectoryStats, argType=[Qureg,NoisyCircuitFunc,c_void_p,POINTER(c_int),POINTER(qreal),c_int,Qureg,c_int], defArg=[None]*8)
+
+# Circuit Operations
+createCircuit         = QuESTTestee ("createCircuit",         retType=Circuit, argType=[c_int,c_int], defArg=[1,0])
+destroyCircuit        = QuESTTestee ("destroyCircuit",        retType=None, argType=[Circuit], defArg=[None])
+addGateToCircuit      = QuESTTestee ("addGateToCircuit",      retType=None, argType=[Circuit,c_int,POINTER(c_int),POINTER(qreal)], defArg=[None,None,None,None])
+addParamGateToCircuit = QuESTTestee ("addParamGateToCircuit", retType=None, argType=[Circuit,c_int,POINTER(c_int),c_int], defArg=[None,None,None,None])
+setCircuitParams      = QuESTTestee ("setCircuitParams",      retType=None, argType=[Circuit,POINTER(qreal)], defArg=[None,None])
+compileCircuit        = QuESTTestee ("compileCircuit",        retType=None, argType=[Circuit], defArg=[None])
+applyCircuit          = QuESTTestee ("applyCircuit",          retType=None, argType=[Qureg,Circuit], defArg=[None,None])
+calcCircuitIOBytes    = QuESTTestee ("calcCircuitIOBytes",    retType=c_longlong, argType=[Qureg,Circuit,POINTER(c_longlong)], defArg=[None,None,None])
+calcCircuitGradient   = QuESTTestee ("calcCircuitGradient",   retType=qreal, argType=[Qureg,Circuit,POINTER(c_int),POINTER(qreal),c_int,POINTER(qreal),Qureg,Qureg], defArg=[None]*8)
+readQASMFile          = QuESTTestee ("readQASMFile",          retType=Circuit, argType=[c_char_p], defArg=[None])
+readQASMString        = QuESTTestee ("readQASMString",        retType=Circuit, argType=[c_char_p], defArg=[None])
+applyQASMFile         = QuESTTestee ("applyQASMFile",         retType=None, argType=[Qureg,c_char_p], defArg=[None,None])
+applyQASMString       = QuESTTestee ("applyQASMString",       retType=None, argType=[Qureg,c_char_p], defArg=[None,None])
+readCircuitFile       = QuESTTestee ("readCircuitFile",       retType=Circuit, argType=[c_char_p,c_int], defArg=[None,1])
+writeCircuitFile      = QuESTTestee ("writeCircuitFile",      retType=None, argType=[Circuit,c_char_p], defArg=[None,None])
@@ -17,9 +17,9 @@ elif QuESTPrec == 4: qreal = c_longdouble
 else: raise TypeError('Unable to determine precision of qreal')
 
 class QASMLogger(Structure):
-    _fields_ = [("buffer",c_char_p),
-               ("bufferSize",c_int),
-               ("bufferFill",c_int),
+    _fields_ = [("buffer",c_void_p),
+               ("bufferSize",c_longlong),
+               ("bufferFill",c_longlong),
                ("isLogging",c_int)]
     
 class ComplexArray(Structure):
@@ -50,10 +50,50 @@ class Complex(Structure):
                 ("imag",qreal)]
 
 class ComplexMatrix2(Structure):
+    def __init__(self, r0c0=None, r0c1=None, r1c0=None, r1c1=None):
+        super().__init__()
+        for (row, col), elem in zip(((0,0),(0,1),(1,0),(1,1)), (r0c0,r0c1,r1c0,r1c1)):
+            if elem is not None:
+                self.real[row][col] = elem.real
+                self.imag[row][col] = elem.imag
+    r0c0 = property(lambda self: Complex(self.real[0][0], self.imag[0][0]))
+    r0c1 = property(lambda self: Complex(self.real[0][1], self.imag[0][1]))
+    r1c0 = property(lambda self: Complex(self.real[1][0], self.imag[1][0]))
+    r1c1 = property(lambda self: Complex(self.real[1][1], self.imag[1][1]))
     __repr__ = lambda self:"[{},{},{},{})]".format(self.r0c0,self.r0c1,self.r1c0,self.r1c1)
     __abs__ = lambda self: abs(self.r0c0*self.r1c1 - self.r1c0*self.r0c1)
-    _fields_ = [("r0c0",Complex),("r0c1",Complex),
-                ("r1c0",Complex),("r1c1",Complex)]
+    _fields_ = [("real",(qreal*2)*2),
+                ("imag",(qreal*2)*2)]
+
+class ComplexMatrix4(Structure):
+    def __init__(self, elems=None):
+        super().__init__()
+        if elems is not None:
+            for row in range(4):
+                for col in range(4):
+                    self.real[row][col] = elems[row][col].real
+                    self.imag[row][col] = elems[row][col].imag
+    _fields_ = [("real",(qreal*4)*4),
+                ("imag",(qreal*4)*4)]
+
+class ComplexMatrixN(Structure):
+    def __init__(self, numQubits, elems=None):
+        super().__init__()
+        dim = 1 << numQubits
+        self.numQubits = numQubits
+        # the rows are owned by this object, and must outlive any use of the matrix
+        self._reRows = [(qreal*dim)() for row in range(dim)]
+        self._imRows = [(qreal*dim)() for row in range(dim)]
+        self.real = (POINTER(qreal)*dim)(*self._reRows)
+        self.imag = (POINTER(qreal)*dim)(*self._imRows)
+        if elems is not None:
+            for row in range(dim):
+                for col in range(dim):
+                    self._reRows[row][col] = elems[row][col].real
+                    self._imRows[row][col] = elems[row][col].imag
+    _fields_ = [("numQubits",c_int),
+                ("real",POINTER(POINTER(qreal))),
+                ("imag",POINTER(POINTER(qreal)))]
 
 class Vector(Structure):
     __str__ = lambda self:"[{},{},{}]".format(self.x, self.y, self.z)
@@ -121,6 +161,12 @@ class Qureg(Structure):
         return size
 
     _fields_ = [("isDensityMatrix", c_int),
+                ("isPacked", c_int),
+                ("isReal", c_int),
+                ("isSubspace", c_int),
+                ("hammingWeight", c_int),
+                ("isOutOfCore", c_int),
+                ("isCompressed", c_int),
                 ("numQubitsRepresented", c_int),
                 ("numQubitsInStateVec", c_int),
                 ("numAmpsPerChunk",c_longlong),
@@ -129,13 +175,49 @@ class Qureg(Structure):
                 ("numChunks", c_int),
                 ("stateVec", ComplexArray),
                 ("pairStateVec", ComplexArray),
-                ("deviceStateVec", ComplexArray),
                 ("firstLevelReduction",POINTER(qreal)),("secondLevelReduction",POINTER(qreal)),
+                ("compressedAmps",c_void_p),
                 ("qasmLog",POINTER(QASMLogger))]
 
 class QuESTEnv(Structure):
     _fields_ = [("rank",c_int),("numRanks",c_int)]
 
+class Circuit(Structure):
+    _fields_ = [("numQubits",c_int),
+                ("numParams",c_int),
+                ("params",POINTER(qreal)),
+                ("gateList",c_void_p)]
+
+class TrajectoryStats(Structure):
+    _fields_ = [("mean",qreal),
+                ("variance",qreal),
+                ("standardError",qreal),
+                ("numTrajectories",c_int)]
+
+class CompressionStats(Structure):
+    _fields_ = [("numBytes",c_longlong),
+                ("compressionRatio",qreal),
+                ("infidelityBound",qreal)]
+
+# Signatures of the noisy circuit and observable callbacks of calcTrajectoryAverage
+NoisyCircuitFunc = CFUNCTYPE(None, Qureg, c_void_p)
+ObservableFunc = CFUNCTYPE(qreal, Qureg, c_void_p)
+
+# Codes of enum circuitGateType
+(CIRCUIT_HADAMARD, CIRCUIT_PAULI_X, CIRCUIT_PAULI_Y, CIRCUIT_PAULI_Z,
+ CIRCUIT_S_GATE, CIRCUIT_T_GATE, CIRCUIT_SQRT_X, CIRCUIT_SQRT_Y, CIRCUIT_SQRT_W,
+ CIRCUIT_ROTATE_X, CIRCUIT_ROTATE_Y, CIRCUIT_ROTATE_Z, CIRCUIT_PHASE_SHIFT,
+ CIRCUIT_U1, CIRCUIT_U2, CIRCUIT_U3,
+ CIRCUIT_CONTROLLED_NOT, CIRCUIT_CONTROLLED_PAULI_Y, CIRCUIT_CONTROLLED_PHASE_FLIP,
+ CIRCUIT_CONTROLLED_ROTATE_X, CIRCUIT_CONTROLLED_ROTATE_Y, CIRCUIT_CONTROLLED_ROTATE_Z,
+ CIRCUIT_CONTROLLED_PHASE_SHIFT, CIRCUIT_SWAP, CIRCUIT_FSIM) = range(25)
+
+# Codes of enum pauliOpType
+PAULI_I, PAULI_X, PAULI_Y, PAULI_Z = range(4)
+
+# Codes of enum ampStorageType
+STORAGE_FLOAT, STORAGE_HALF, STORAGE_BFLOAT16 = range(3)
+
 def stringToList(a):
     """ Turn a comma-separated string into a list of floats """
     if not isinstance(a, str): raise TypeError(argWarningGen.format('stringToList',str.__name__,type(a).__name__))
@@ -181,6 +263,32 @@ def argComplexMatrix2(arg):
             'argComplexMatrix2','4 arguments',len(elements)+" arguments"))
     return ComplexMatrix2(*elements)
 
+def argPointerComplexMatrix2(arg):
+    if isinstance(arg, list) or isinstance(arg, tuple):
+        return (ComplexMatrix2*len(arg))(*map(argComplexMatrix2, arg))
+    elif isinstance(arg, ComplexMatrix2) or isinstance(arg, Array):
+        return arg
+    else : raise TypeError(argWarningGen.format('argPointerComplexMatrix2','tuple or list',type(arg).__name__))
+
+def argString(arg):
+    if   isinstance(arg, str): return arg.encode()
+    elif isinstance(arg, bytes): return arg
+    else : raise TypeError(argWarningGen.format('argString','str or bytes',type(arg).__name__))
+
+def argPointerComplexMatrix4(arg):
+    if isinstance(arg, list) or isinstance(arg, tuple):
+        return (ComplexMatrix4*len(arg))(*arg)
+    elif isinstance(arg, ComplexMatrix4) or isinstance(arg, Array):
+        return arg
+    else : raise TypeError(argWarningGen.format('argPointerComplexMatrix4','tuple or list',type(arg).__name__))
+
+def argPointerComplexMatrixN(arg):
+    if isinstance(arg, list) or isinstance(arg, tuple):
+        return (ComplexMatrixN*len(arg))(*arg)
+    elif isinstance(arg, ComplexMatrixN) or isinstance(arg, Array):
+        return arg
+    else : raise TypeError(argWarningGen.format('argPointerComplexMatrixN','tuple or list',type(arg).__name__))
+
 def argComplex(arg):
     if   isinstance(arg, Complex): return arg
     elif isinstance(arg, list):  return Complex(*arg)
@@ -214,7 +322,7 @@ def argPointerQreal(arg):
         for i in range(len(arg)):
             newArg[i] = arg[i]
         return newArg
-    elif isinstance(arg, qreal):
+    elif isinstance(arg, qreal) or isinstance(arg, Array):
         return arg
     else : raise TypeError(argWarningGen.format('argVector','str, float, tuple or list',type(a).__name__))
 
@@ -224,7 +332,7 @@ def argPointerInt(arg):
 
     if isinstance(arg,list):
         return (c_int*len(arg))(*arg)
-    elif isinstance(arg, c_int):
+    elif isinstance(arg, c_int) or isinstance(arg, Array):
         return arg
 
 def argPointerLongInt(arg):
@@ -233,7 +341,16 @@ def argPointerLongInt(arg):
 
     if isinstance(arg,list):
         return (c_long*len(arg))(*arg)
-    elif isinstance(arg, c_int):
+    elif isinstance(arg, c_int) or isinstance(arg, Array):
+        return arg
+
+def argPointerLongLongInt(arg):
+    if isinstance(arg,str):
+        arg = stringToListInt(arg)
+
+    if isinstance(arg,list):
+        return (c_longlong*len(arg))(*arg)
+    elif isinstance(arg, Array):
         return arg
 
 
@@ -242,8 +359,11 @@ class QuESTTestee:
     _basicTypeConv = {"c_int":int, "c_long":int, "c_ulong":int, "c_longlong":int,
                      "c_float":float, "c_double":float, "c_longdouble":float,
                      "Vector":argVector, "ComplexMatrix2":argComplexMatrix2, "ComplexArray":argComplexArray,
-                     "Complex":argComplex, "LP_c_double":argPointerQreal, "LP_c_int":argPointerInt,
-                     "LP_c_long":argPointerLongInt }
+                     "Complex":argComplex, "LP_c_double":argPointerQreal, "LP_c_float":argPointerQreal,
+                     "LP_c_longdouble":argPointerQreal, "LP_c_int":argPointerInt,
+                     "LP_c_long":argPointerLongInt, "LP_c_longlong":argPointerLongLongInt,
+                     "LP_ComplexMatrix2":argPointerComplexMatrix2, "LP_ComplexMatrix4":argPointerComplexMatrix4,
+                     "LP_ComplexMatrixN":argPointerComplexMatrixN, "c_char_p":argString }
 
     _funcsList = []
     _funcsDict = {}
@@ -368,3 +488,16 @@ def rand_unit_mat():
     newMat = ComplexMatrix2(*elems)
 
     return newMat
+
+def rand_unitary(dim):
+    """ Random dim x dim unitary, as nested lists of Python complex, by Gram-Schmidt """
+    rows = []
+    while len(rows) < dim:
+        row = [complex(random.uniform(-1,1), random.uniform(-1,1)) for col in range(dim)]
+        for other in rows:
+            overlap = sum(a*b.conjugate() for a, b in zip(row, other))
+            row = [a - overlap*b for a, b in zip(row, other)]
+        norm = math.sqrt(sum(abs(a)**2 for a in row))
+        if norm > 1e-3:
+            rows.append([a/norm for a in row])
+    return rows
@@ -1,6 +1,9 @@
 import os.path
 import os
+import sys
+import subprocess
 from QuESTPy.QuESTFunc import *
+import QuESTPy.QuESTBase as QuESTBase
 from functools import total_ordering
 import importlib.util
 import importlib.machinery
@@ -314,7 +317,7 @@ class TestResults:
         if tol is None:
             tol = self._tolerance
 
-        if a.isDensityMatrix and not b.isDensityMatrix or a.isDensityMatrix and not b.isDensityMatrix:
+        if a.isDensityMatrix != b.isDensityMatrix:
             raise TypeError('A and B are not both density matrices')
 
         if a.numQubitsRepresented != b.numQubitsRepresented:
@@ -323,8 +326,8 @@ class TestResults:
         # Compare final with expected states
         if a.isDensityMatrix and b.isDensityMatrix:
 
-            for row in range(a.numQubitsRepresented):
-                for col in range(b.numQubitsRepresented):
+            for row in range(1 << a.numQubitsRepresented):
+                for col in range(1 << b.numQubitsRepresented):
                     aState = getDensityAmp(a,row,col)
                     bState = getDensityAmp(b,row,col)
                     if not self.compareComplex(aState,bState,tol): return False
@@ -373,6 +376,24 @@ class TestResults:
         else:
             self.fail_test(test, message)
 
+    def validateError(self, code, funcName, errorMessage, test = "", message = ""):
+        """ Check that the QuESTPy statements in code (run upon a fresh environment Env in a separate
+        process, since input errors exit) are rejected by funcName with an error containing errorMessage """
+        script = ("import importlib.util\n"
+                  "from QuESTPy.QuESTBase import init_QuESTLib\n"
+                  "init_QuESTLib({!r})\n"
+                  "from QuESTPy.QuESTFunc import *\n"
+                  "Env = createQuESTEnv()\n").format(os.path.dirname(QuESTBase.QuESTLib._name)) + code
+        # the process must not inherit an MPI launcher's environment, so that it runs as a singleton
+        env = {key: val for key, val in os.environ.items() if not key.startswith(("OMPI_", "PMIX_", "PMI_"))}
+        env["PYTHONPATH"] = os.path.dirname(os.path.dirname(QuESTBase.__file__))
+        result = subprocess.run([sys.executable, "-c", script], env=env,
+                                stdout=subprocess.PIPE, stderr=subprocess.PIPE, universal_newlines=True)
+        expected = "QuEST Error in function {}: ".format(funcName)
+        rejected = result.returncode != 0 and any(
+            line.startswith(expected) and errorMessage in line for line in result.stdout.splitlines())
+        self.validate(rejected, test, message or "{} did not reject the input with '{}'".format(funcName, errorMessage))
+
     def print_results(self):
         """ Print number of passes and fails """
         self._write_term('\nPassed {} of {} tests, {} failed.\n'.format(self.passes,self.numTests,self.fails))